@@ -0,0 +1,253 @@
+/*
+ * dyld_cache.h - dyld_shared_cache format and address-to-symbol lookup
+ *
+ * Structures are based on dyld-421.2/launch-cache/dyld_cache_format.h. The
+ * Mach-O structures are vendored so the tool builds without the system
+ * <mach-o/loader.h> and <mach-o/nlist.h> headers.
+ */
+
+#ifndef IPSW_DYLD_CACHE_H_
+#define IPSW_DYLD_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * dyld_cache_header - Main shared cache header
+ * Based on dyld-421.2/launch-cache/dyld_cache_format.h
+ */
+struct dyld_cache_header {
+    char magic[16];           /* e.g. "dyld_v1   arm64" */
+    uint32_t mappingOffset;   /* file offset to first dyld_cache_mapping_info */
+    uint32_t mappingCount;    /* number of dyld_cache_mapping_info entries */
+    uint32_t imagesOffset;    /* file offset to first dyld_cache_image_info */
+    uint32_t imagesCount;     /* number of dyld_cache_image_info entries */
+    uint64_t dyldBaseAddress; /* base address of dyld when cache was built */
+    uint64_t codeSignatureOffset; /* file offset of code signature blob */
+    uint64_t codeSignatureSize;   /* size of code signature blob */
+    uint64_t slideInfoOffset;     /* file offset of kernel slid info */
+    uint64_t slideInfoSize;       /* size of kernel slid info */
+    uint64_t
+        localSymbolsOffset; /* file offset of where local symbols are stored */
+    uint64_t localSymbolsSize; /* size of local symbols information */
+    uint8_t uuid[16];          /* unique value for each shared cache file */
+    uint64_t cacheType;        /* 0 for development, 1 for production */
+    uint32_t
+        branchPoolsOffset; /* file offset to table of uint64_t pool addresses */
+    uint32_t branchPoolsCount;   /* number of uint64_t entries */
+    uint64_t accelerateInfoAddr; /* (unslid) address of optimization info */
+    uint64_t accelerateInfoSize; /* size of optimization info */
+    uint64_t
+        imagesTextOffset; /* file offset to first dyld_cache_image_text_info */
+    uint64_t imagesTextCount; /* number of dyld_cache_image_text_info entries */
+};
+
+/*
+ * dyld_cache_mapping_info - Maps file regions to virtual addresses
+ */
+struct dyld_cache_mapping_info {
+    uint64_t address;
+    uint64_t size;
+    uint64_t fileOffset;
+    uint32_t maxProt;
+    uint32_t initProt;
+};
+
+/*
+ * dyld_cache_image_info - Information about each dylib in the cache
+ */
+struct dyld_cache_image_info {
+    uint64_t address; /* unslid address of start of __TEXT */
+    uint64_t modTime;
+    uint64_t inode;
+    uint32_t pathFileOffset; /* file offset of path string */
+    uint32_t pad;
+};
+
+/*
+ * dyld_cache_accelerator_info - Accelerator table header
+ * Contains offsets to various optimization tables including rangeTable.
+ * Based on dyld-421.2/launch-cache/dyld_cache_format.h
+ */
+struct dyld_cache_accelerator_info {
+    uint32_t version;          /* currently 1 */
+    uint32_t imageExtrasCount; /* does not include aliases */
+    uint32_t
+        imagesExtrasOffset; /* offset to first dyld_cache_image_info_extra */
+    uint32_t
+        bottomUpListOffset;   /* offset to bottom-up sorted image index list */
+    uint32_t dylibTrieOffset; /* offset to dylib path trie */
+    uint32_t dylibTrieSize;   /* size of dylib trie */
+    uint32_t initializersOffset; /* offset to initializers list */
+    uint32_t initializersCount;  /* count of initializers */
+    uint32_t dofSectionsOffset;  /* offset to DOF sections */
+    uint32_t dofSectionsCount;   /* count of DOF sections */
+    uint32_t reExportListOffset; /* offset to re-export list */
+    uint32_t reExportCount;      /* count of re-exports */
+    uint32_t depListOffset;      /* offset to dependency list */
+    uint32_t depListCount;       /* count of dependencies */
+    uint32_t rangeTableOffset;   /* offset to range table */
+    uint32_t rangeTableCount;    /* count of range entries */
+    uint64_t dyldSectionAddr;    /* address of libdyld's __dyld section */
+};
+
+/*
+ * dyld_cache_range_entry - Maps an address range to an image index
+ * Entries are sorted by startAddress for binary search.
+ */
+struct dyld_cache_range_entry {
+    uint64_t startAddress; /* unslid address of region start */
+    uint32_t size;         /* size of region in bytes */
+    uint32_t imageIndex;   /* index into dyld_cache_image_info array */
+};
+
+/**
+ * Header for local symbols section in dyld_shared_cache.
+ * Located at header->localSymbolsOffset in the cache file.
+ * Based on dyld-421.2/launch-cache/dyld_cache_format.h
+ */
+struct dyld_cache_local_symbols_info {
+    uint32_t nlistOffset;   /* Offset to nlist entries (from this struct) */
+    uint32_t nlistCount;    /* Total count of nlist entries */
+    uint32_t stringsOffset; /* Offset to string table (from this struct) */
+    uint32_t stringsSize;   /* Size of string table in bytes */
+    uint32_t entriesOffset; /* Offset to entries array (from this struct) */
+    uint32_t entriesCount;  /* Number of entries (one per dylib) */
+};
+
+/**
+ * Per-dylib entry in local symbols table.
+ * Maps a dylib to its range of symbols in the shared nlist array.
+ */
+struct dyld_cache_local_symbols_entry {
+    uint32_t dylibOffset;     /* File offset of dylib's mach_header in cache */
+    uint32_t nlistStartIndex; /* First symbol index for this dylib */
+    uint32_t nlistCount;      /* Number of symbols for this dylib */
+};
+
+/**
+ * 64-bit symbol table entry (from <mach-o/nlist.h>).
+ */
+struct nlist_64 {
+    uint32_t n_strx;  /* Index into string table */
+    uint8_t n_type;   /* Type flags (N_EXT, N_TYPE, etc.) */
+    uint8_t n_sect;   /* Section number (1-based) or NO_SECT */
+    uint16_t n_desc;  /* Description field */
+    uint64_t n_value; /* Symbol value (address for defined symbols) */
+};
+
+/* n_type masks */
+#define N_STAB 0xe0 /* Stabs debugging symbol */
+#define N_PEXT 0x10 /* Private external symbol */
+#define N_TYPE 0x0e /* Type mask */
+#define N_EXT 0x01  /* External symbol */
+
+/* n_type values for N_TYPE bits */
+#define N_UNDF 0x00 /* Undefined */
+#define N_ABS 0x02  /* Absolute */
+#define N_SECT 0x0e /* Defined in section n_sect */
+
+/*
+ * Mach-O header and load commands (from <mach-o/loader.h>).
+ * Vendored so the tool also builds on Linux, where that header is absent.
+ */
+#define MH_MAGIC_64 0xfeedfacf /* 64-bit mach magic number */
+#define LC_SYMTAB 0x2          /* link-edit stab symbol table info */
+#define LC_SEGMENT_64 0x19     /* 64-bit segment of this file to be mapped */
+
+struct mach_header_64 {
+    uint32_t magic;      /* MH_MAGIC_64 */
+    int32_t cputype;     /* cpu specifier */
+    int32_t cpusubtype;  /* machine specifier */
+    uint32_t filetype;   /* type of file */
+    uint32_t ncmds;      /* number of load commands */
+    uint32_t sizeofcmds; /* size of all the load commands */
+    uint32_t flags;      /* flags */
+    uint32_t reserved;   /* reserved */
+};
+
+struct load_command {
+    uint32_t cmd;     /* type of load command */
+    uint32_t cmdsize; /* total size of command in bytes */
+};
+
+struct segment_command_64 {
+    uint32_t cmd;      /* LC_SEGMENT_64 */
+    uint32_t cmdsize;  /* includes sizeof section_64 structs */
+    char segname[16];  /* segment name */
+    uint64_t vmaddr;   /* memory address of this segment */
+    uint64_t vmsize;   /* memory size of this segment */
+    uint64_t fileoff;  /* file offset of this segment */
+    uint64_t filesize; /* amount to map from the file */
+    int32_t maxprot;   /* maximum VM protection */
+    int32_t initprot;  /* initial VM protection */
+    uint32_t nsects;   /* number of sections in segment */
+    uint32_t flags;    /* flags */
+};
+
+struct symtab_command {
+    uint32_t cmd;     /* LC_SYMTAB */
+    uint32_t cmdsize; /* sizeof(struct symtab_command) */
+    uint32_t symoff;  /* symbol table offset */
+    uint32_t nsyms;   /* number of symbol table entries */
+    uint32_t stroff;  /* string table offset */
+    uint32_t strsize; /* string table size in bytes */
+};
+
+/*
+ * A mapped and validated dyld_shared_cache, with pointers to the tables every
+ * lookup needs. Filled by open_shared_cache(), released by
+ * close_shared_cache().
+ */
+struct shared_cache {
+    const uint8_t *data; /* mmap'd cache file */
+    size_t size;         /* size of cache file */
+    const struct dyld_cache_header *header;
+    const struct dyld_cache_mapping_info *mappings;
+    const struct dyld_cache_image_info *images;
+    const struct dyld_cache_accelerator_info *accel_info;
+    const struct dyld_cache_range_entry *range_table;
+    const struct dyld_cache_local_symbols_info *local_info; /* may be NULL */
+};
+
+/* Address translation (see dyld_cache.c for details) */
+int64_t addr_to_file_offset(const struct dyld_cache_mapping_info *mappings,
+                            uint32_t mapping_count, uint64_t addr);
+int64_t
+image_index_to_dylib_offset(const uint8_t *cache,
+                            const struct dyld_cache_header *header,
+                            const struct dyld_cache_mapping_info *mappings,
+                            uint32_t mapping_count, uint32_t image_index);
+const struct dyld_cache_range_entry *
+binary_search_range_table(const struct dyld_cache_range_entry *rangeTable,
+                          uint32_t count, uint64_t addr);
+
+/* Symbol tables */
+const struct dyld_cache_local_symbols_entry *
+find_local_symbols_entry(const struct dyld_cache_local_symbols_entry *entries,
+                         uint32_t entries_count, uint64_t dylib_offset);
+int find_dylib_symtab(const uint8_t *cache, size_t cache_size,
+                      const struct dyld_cache_mapping_info *mappings,
+                      uint32_t mapping_count, uint64_t dylib_offset,
+                      const struct nlist_64 **nlist_out, uint32_t *nsyms_out,
+                      const char **strtab_out, uint32_t *strsize_out);
+int find_symbol_for_address(
+    const uint8_t *cache, size_t cache_size,
+    const struct dyld_cache_header *header,
+    const struct dyld_cache_mapping_info *mappings, uint32_t mapping_count,
+    const struct dyld_cache_local_symbols_info *local_info,
+    const struct dyld_cache_range_entry *rangeTable, uint32_t range_table_count,
+    uint64_t target_addr, const char **symbol_name, uint64_t *symbol_addr,
+    int32_t *image_index_out, int verbose);
+
+/* Mapped cache */
+int open_shared_cache(const char *cache_path, struct shared_cache *sc);
+void close_shared_cache(struct shared_cache *sc);
+const char *get_image_path(const struct shared_cache *sc,
+                           uint32_t image_index);
+
+/* Output helpers */
+const char *get_basename(const char *path);
+const char *strip_leading_underscore(const char *name);
+
+#endif /* IPSW_DYLD_CACHE_H_ */
@@ -0,0 +1,1038 @@
+/*
+ * index_benchmark.c - Per-address lookup time with and without a symbol index
+ *
+ * Writes a synthetic dyld_shared_cache to a temporary directory and builds
+ * its symbol index with 1, 4, and 16 threads. The files must be identical.
+ * Then resolves the same random addresses twice: once with
+ * find_symbol_for_address(), which scans the image's symbol tables, and once
+ * with symbol_index_lookup(). Both must return the same symbol for every
+ * address. Then times symbol_index_find_name() on exact, prefix, and C++
+ * qualified names, checking each against the images' own name tables.
+ * Finally runs symbol_server_run() on the cache and sends the same addresses
+ * over its socket in binary and text batches, checking the binary results
+ * against symbol_index_lookup(). Any difference exits 1.
+ *
+ * The synthetic cache has the layout ipsw reads from a real one: a header,
+ * one mapping, image infos and paths, a Mach-O header with __LINKEDIT and
+ * LC_SYMTAB per image, an accelerator rangeTable, and a local symbols section
+ * whose entries are in shuffled image order.
+ *
+ * Usage:
+ *   ipsw_index_benchmark [images] [symbols_per_table] [lookups]
+ *
+ * Defaults: 200 images, 20000 symbols per table (each image has a dylib
+ * table and a local table), 10000 lookups.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ipsw/dyld_cache.h"
+#include "ipsw/symbol_index.h"
+#include "ipsw/symbol_server.h"
+
+#define SYNTH_BASE 0x180000000ULL /* unslid address of the only mapping */
+#define SYNTH_TEXT_SIZE 0x10000   /* bytes of __TEXT per image */
+#define SYNTH_PATH_SIZE 48        /* fixed-width image path slot */
+#define SYNTH_NAME_SIZE 16        /* fixed-width symbol name, with NUL */
+
+/* xorshift64*: deterministic and good enough for synthetic layouts */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*
+ * Fill one symbol table: nlist entries at nlist, names at strtab (which starts
+ * with an empty string). Mixes the entry kinds the lookup must skip with the
+ * N_SECT symbols it must find, and C names with C++ names shared by every
+ * image.
+ */
+static void fill_symbols(struct nlist_64 *nlist, char *strtab,
+                         uint32_t count, char prefix, uint32_t image,
+                         uint64_t text_addr, int dylib, uint64_t *rng) {
+    static const uint8_t dylib_types[] = {
+        N_SECT | N_EXT, N_SECT | N_EXT, N_SECT, N_UNDF | N_EXT, 0x24 /* stab */
+    };
+
+    strtab[0] = '\0';
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t strx = 1 + k * SYNTH_NAME_SIZE;
+        if (dylib && k % 8 == 0) {
+            /* e::fNNNNN(), exported by every image */
+            snprintf(strtab + strx, SYNTH_NAME_SIZE, "__ZN1e6f%05uEv",
+                     k % 100000);
+        } else {
+            snprintf(strtab + strx, SYNTH_NAME_SIZE, "_%c%05u_%07u", prefix,
+                     image % 100000, k % 10000000);
+        }
+        nlist[k].n_strx = strx;
+        nlist[k].n_type =
+            dylib ? dylib_types[next_random(rng) % sizeof(dylib_types)]
+                  : N_SECT;
+        nlist[k].n_sect = 1;
+        nlist[k].n_desc = 0;
+        nlist[k].n_value =
+            text_addr + 0x100 + next_random(rng) % (SYNTH_TEXT_SIZE - 0x100);
+    }
+}
+
+/**
+ * Write a synthetic cache with image_count images to path.
+ *
+ * @return 0 on success, -1 on failure (error printed to stderr)
+ */
+static int write_synthetic_cache(const char *path, uint32_t image_count,
+                                 uint32_t symbols, uint64_t seed) {
+    uint64_t rng = seed;
+    uint64_t strsize = 1 + (uint64_t)symbols * SYNTH_NAME_SIZE;
+    uint64_t symtab_size = align_up(
+        (uint64_t)symbols * sizeof(struct nlist_64) + strsize, 8);
+
+    uint64_t mapping_off = sizeof(struct dyld_cache_header);
+    uint64_t images_off = mapping_off + sizeof(struct dyld_cache_mapping_info);
+    uint64_t paths_off = images_off + (uint64_t)image_count *
+                                          sizeof(struct dyld_cache_image_info);
+    uint64_t text_off =
+        align_up(paths_off + (uint64_t)image_count * SYNTH_PATH_SIZE, 0x1000);
+    uint64_t accel_off = text_off + (uint64_t)image_count * SYNTH_TEXT_SIZE;
+    uint64_t range_off = accel_off + sizeof(struct dyld_cache_accelerator_info);
+    uint64_t symtabs_off = align_up(
+        range_off +
+            (uint64_t)image_count * sizeof(struct dyld_cache_range_entry),
+        8);
+    uint64_t local_off = symtabs_off + (uint64_t)image_count * symtab_size;
+
+    uint64_t local_nlist_count = (uint64_t)image_count * symbols;
+    uint64_t local_nlist_off = sizeof(struct dyld_cache_local_symbols_info);
+    uint64_t local_strings_off =
+        local_nlist_off + local_nlist_count * sizeof(struct nlist_64);
+    uint64_t local_strings_size = 1 + local_nlist_count * SYNTH_NAME_SIZE;
+    uint64_t local_entries_off =
+        align_up(local_strings_off + local_strings_size, 4);
+    uint64_t local_size =
+        local_entries_off +
+        (uint64_t)image_count * sizeof(struct dyld_cache_local_symbols_entry);
+    uint64_t total = local_off + local_size;
+
+    if (local_strings_size > UINT32_MAX || local_entries_off > UINT32_MAX) {
+        fprintf(stderr, "Error: Synthetic cache too large\n");
+        return -1;
+    }
+
+    uint8_t *buf = calloc(1, total);
+    uint32_t *order = malloc(image_count * sizeof(*order));
+    if (!buf || !order) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(buf);
+        free(order);
+        return -1;
+    }
+
+    struct dyld_cache_header *header = (struct dyld_cache_header *)buf;
+    memcpy(header->magic, "dyld_v1   arm64", 16);
+    header->mappingOffset = (uint32_t)mapping_off;
+    header->mappingCount = 1;
+    header->imagesOffset = (uint32_t)images_off;
+    header->imagesCount = image_count;
+    header->localSymbolsOffset = local_off;
+    header->localSymbolsSize = local_size;
+    for (int i = 0; i < 16; i += 8) {
+        uint64_t r = next_random(&rng);
+        memcpy(header->uuid + i, &r, 8);
+    }
+    header->accelerateInfoAddr = SYNTH_BASE + accel_off;
+    header->accelerateInfoSize =
+        sizeof(struct dyld_cache_accelerator_info) +
+        image_count * sizeof(struct dyld_cache_range_entry);
+
+    struct dyld_cache_mapping_info *mapping =
+        (struct dyld_cache_mapping_info *)(buf + mapping_off);
+    mapping->address = SYNTH_BASE;
+    mapping->size = total;
+    mapping->fileOffset = 0;
+    mapping->maxProt = 5;
+    mapping->initProt = 5;
+
+    struct dyld_cache_accelerator_info *accel =
+        (struct dyld_cache_accelerator_info *)(buf + accel_off);
+    accel->version = 1;
+    accel->imageExtrasCount = image_count;
+    accel->rangeTableOffset = (uint32_t)(range_off - accel_off);
+    accel->rangeTableCount = image_count;
+
+    struct dyld_cache_image_info *images =
+        (struct dyld_cache_image_info *)(buf + images_off);
+    struct dyld_cache_range_entry *ranges =
+        (struct dyld_cache_range_entry *)(buf + range_off);
+
+    for (uint32_t i = 0; i < image_count; i++) {
+        uint64_t path_off = paths_off + (uint64_t)i * SYNTH_PATH_SIZE;
+        uint64_t dylib_off = text_off + (uint64_t)i * SYNTH_TEXT_SIZE;
+        uint64_t symoff = symtabs_off + (uint64_t)i * symtab_size;
+        uint64_t stroff = symoff + (uint64_t)symbols * sizeof(struct nlist_64);
+
+        snprintf((char *)buf + path_off, SYNTH_PATH_SIZE,
+                 "/usr/lib/libsynth%u.dylib", i);
+        images[i].address = SYNTH_BASE + dylib_off;
+        images[i].pathFileOffset = (uint32_t)path_off;
+        ranges[i].startAddress = SYNTH_BASE + dylib_off;
+        ranges[i].size = SYNTH_TEXT_SIZE;
+        ranges[i].imageIndex = i;
+
+        struct mach_header_64 *mh = (struct mach_header_64 *)(buf + dylib_off);
+        struct segment_command_64 *seg =
+            (struct segment_command_64 *)(mh + 1);
+        struct symtab_command *symtab = (struct symtab_command *)(seg + 1);
+        mh->magic = MH_MAGIC_64;
+        mh->filetype = 6; /* MH_DYLIB */
+        mh->ncmds = 2;
+        mh->sizeofcmds = sizeof(*seg) + sizeof(*symtab);
+        seg->cmd = LC_SEGMENT_64;
+        seg->cmdsize = sizeof(*seg);
+        memcpy(seg->segname, "__LINKEDIT", 11);
+        seg->vmaddr = SYNTH_BASE;
+        seg->vmsize = total;
+        seg->fileoff = 0;
+        seg->filesize = total;
+        symtab->cmd = LC_SYMTAB;
+        symtab->cmdsize = sizeof(*symtab);
+        symtab->symoff = (uint32_t)symoff;
+        symtab->nsyms = symbols;
+        symtab->stroff = (uint32_t)stroff;
+        symtab->strsize = (uint32_t)strsize;
+
+        fill_symbols((struct nlist_64 *)(buf + symoff), (char *)buf + stroff,
+                     symbols, 'e', i, SYNTH_BASE + dylib_off, 1, &rng);
+        order[i] = i;
+    }
+
+    /* Local symbols entries are not in image order in real caches either */
+    for (uint32_t i = image_count; i > 1; i--) {
+        uint32_t j = (uint32_t)(next_random(&rng) % i);
+        uint32_t tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+    }
+
+    struct dyld_cache_local_symbols_info *local_info =
+        (struct dyld_cache_local_symbols_info *)(buf + local_off);
+    local_info->nlistOffset = (uint32_t)local_nlist_off;
+    local_info->nlistCount = (uint32_t)local_nlist_count;
+    local_info->stringsOffset = (uint32_t)local_strings_off;
+    local_info->stringsSize = (uint32_t)local_strings_size;
+    local_info->entriesOffset = (uint32_t)local_entries_off;
+    local_info->entriesCount = image_count;
+
+    struct nlist_64 *local_nlist =
+        (struct nlist_64 *)(buf + local_off + local_nlist_off);
+    char *local_strings = (char *)buf + local_off + local_strings_off;
+    struct dyld_cache_local_symbols_entry *entries =
+        (struct dyld_cache_local_symbols_entry *)(buf + local_off +
+                                                  local_entries_off);
+    local_strings[0] = '\0';
+    for (uint32_t k = 0; k < image_count; k++) {
+        uint32_t i = order[k];
+        uint64_t start = (uint64_t)k * symbols;
+        uint64_t dylib_off = text_off + (uint64_t)i * SYNTH_TEXT_SIZE;
+
+        /* Names for this block start after the previous blocks' names */
+        fill_symbols(local_nlist + start,
+                     local_strings + start * SYNTH_NAME_SIZE, symbols, 'l', i,
+                     SYNTH_BASE + dylib_off, 0, &rng);
+        uint32_t strx_base = (uint32_t)(start * SYNTH_NAME_SIZE);
+        for (uint32_t s = 0; s < symbols; s++) {
+            local_nlist[start + s].n_strx += strx_base;
+        }
+        entries[k].dylibOffset = (uint32_t)dylib_off;
+        entries[k].nlistStartIndex = (uint32_t)start;
+        entries[k].nlistCount = symbols;
+    }
+    free(order);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror("Error opening synthetic cache");
+        free(buf);
+        return -1;
+    }
+    int ok = fwrite(buf, 1, total, f) == total;
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+    free(buf);
+    if (!ok) {
+        perror("Error writing synthetic cache");
+        return -1;
+    }
+    return 0;
+}
+
+static int scan_lookup(const struct shared_cache *sc, uint64_t addr,
+                       const char **name, uint64_t *sym_addr,
+                       int32_t *image_index) {
+    return find_symbol_for_address(
+        sc->data, sc->size, sc->header, sc->mappings,
+        sc->header->mappingCount, sc->local_info, sc->range_table,
+        sc->accel_info->rangeTableCount, addr, name, sym_addr, image_index, 0);
+}
+
+/* Thread counts timed for the build; the first one's index is kept */
+static const unsigned build_threads[] = {1, 4, 16};
+#define BUILD_THREAD_RUNS                                                      \
+    (int)(sizeof(build_threads) / sizeof(build_threads[0]))
+
+/**
+ * Read a whole file into a malloc'd buffer.
+ *
+ * @return The buffer, or NULL on failure (error printed to stderr)
+ */
+static uint8_t *read_file(const char *path, size_t *size_out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror("Error opening symbol index");
+        return NULL;
+    }
+    uint8_t *data = NULL;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 &&
+        fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc(size ? (size_t)size : 1);
+        if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    if (!data) {
+        perror("Error reading symbol index");
+        return NULL;
+    }
+    *size_out = (size_t)size;
+    return data;
+}
+
+/**
+ * Build the index once per entry of build_threads, timing each build.
+ *
+ * The first build is left at index_path. Every later build must produce the
+ * same bytes.
+ *
+ * @return 0 on success, -1 on failure or if builds differ
+ */
+static int time_builds(const struct shared_cache *sc, const char *index_path,
+                       double build_ns[BUILD_THREAD_RUNS]) {
+    char other_path[4096 + 64];
+    snprintf(other_path, sizeof(other_path), "%s.threads", index_path);
+
+    uint8_t *first = NULL;
+    size_t first_size = 0;
+    int ret = 0;
+    for (int r = 0; r < BUILD_THREAD_RUNS && ret == 0; r++) {
+        const char *path = r == 0 ? index_path : other_path;
+        double start = now_ns();
+        if (symbol_index_build(sc, path, build_threads[r]) != 0) {
+            ret = -1;
+            break;
+        }
+        build_ns[r] = now_ns() - start;
+
+        size_t size;
+        uint8_t *data = read_file(path, &size);
+        if (!data) {
+            ret = -1;
+        } else if (r == 0) {
+            first = data;
+            first_size = size;
+        } else {
+            if (size != first_size || memcmp(data, first, size) != 0) {
+                fprintf(stderr,
+                        "Error: Index built with %u threads differs from "
+                        "%u threads\n",
+                        build_threads[r], build_threads[0]);
+                ret = -1;
+            }
+            free(data);
+        }
+    }
+    unlink(other_path);
+    free(first);
+    return ret;
+}
+
+/*
+ * Callback state for symbol_index_find_name() in the benchmark.
+ */
+struct name_count {
+    uint64_t matches;
+};
+
+static int count_name_match(const struct symbol_index_match *match,
+                            void *ctx) {
+    (void)match;
+    ((struct name_count *)ctx)->matches++;
+    return 0;
+}
+
+/**
+ * Count the names equal to (or starting with) raw in every image's
+ * by_name[], without going through refs[] or symbol_index_find_name().
+ */
+static uint64_t count_in_images(const struct symbol_index *idx,
+                                const struct shared_cache *sc,
+                                const char *raw, int prefix) {
+    size_t len = strlen(raw);
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < idx->header->image_count; i++) {
+        const struct symbol_index_image *image = &idx->images[i];
+        const struct symbol_index_name *names =
+            (const struct symbol_index_name *)(idx->data +
+                                               image->names_offset);
+        /* Aliases repeat their canonical image's record; count it once */
+        int alias = 0;
+        for (uint32_t j = 0; j < i && !alias; j++) {
+            alias = image->name_count > 0 &&
+                    idx->images[j].names_offset == image->names_offset;
+        }
+        if (alias)
+            continue;
+
+        uint32_t low = 0;
+        uint32_t high = image->name_count;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if (strcmp((const char *)sc->data + names[mid].name, raw) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        for (uint32_t k = low; k < image->name_count; k++) {
+            const char *name = (const char *)sc->data + names[k].name;
+            if (prefix ? strncmp(name, raw, len) != 0 : strcmp(name, raw) != 0)
+                break;
+            total++;
+        }
+    }
+    return total;
+}
+
+/**
+ * Time symbol_index_find_name() for names picked at random from the index,
+ * as ipsw prints them and, for C++ names, as qualified names.
+ *
+ * @return 0 if every lookup found exactly the expected names, 1 otherwise
+ */
+static int run_name_benchmark(const struct shared_cache *sc,
+                              const struct symbol_index *idx,
+                              uint32_t lookups, uint64_t seed) {
+    enum { QUERY_SIZE = 64, PREFIX_LEN = 12 };
+    char(*queries)[QUERY_SIZE] = malloc(lookups * sizeof(*queries));
+    char(*cxx_queries)[QUERY_SIZE] = malloc(lookups * sizeof(*cxx_queries));
+    uint64_t *expected = malloc(lookups * sizeof(*expected));
+    uint64_t *expected_prefix = malloc(lookups * sizeof(*expected_prefix));
+    uint64_t *expected_cxx = malloc(lookups * sizeof(*expected_cxx));
+    if (!queries || !cxx_queries || !expected || !expected_prefix ||
+        !expected_cxx) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(queries);
+        free(cxx_queries);
+        free(expected);
+        free(expected_prefix);
+        free(expected_cxx);
+        return 1;
+    }
+
+    uint64_t rng = seed ^ 0xc2b2ae3d27d4eb4fULL;
+    uint32_t cxx_count = 0;
+    for (uint32_t q = 0; q < lookups; q++) {
+        const struct symbol_index_image *image;
+        do {
+            image = &idx->images[next_random(&rng) % idx->header->image_count];
+        } while (image->name_count == 0);
+        const struct symbol_index_name *names =
+            (const struct symbol_index_name *)(idx->data +
+                                               image->names_offset);
+        const char *raw =
+            (const char *)sc->data +
+            names[next_random(&rng) % image->name_count].name;
+        unsigned f;
+
+        /* Printed form: one leading underscore stripped */
+        snprintf(queries[q], QUERY_SIZE, "%s", raw + 1);
+        expected[q] = count_in_images(idx, sc, raw, 0);
+        char prefix_raw[PREFIX_LEN + 2];
+        snprintf(prefix_raw, sizeof(prefix_raw), "%s", raw);
+        expected_prefix[q] = count_in_images(idx, sc, prefix_raw, 1);
+        if (sscanf(raw, "__ZN1e6f%5uEv", &f) == 1) {
+            expected_cxx[cxx_count] = expected[q];
+            snprintf(cxx_queries[cxx_count++], QUERY_SIZE, "e::f%05u", f);
+        }
+    }
+
+    struct name_count count;
+    uint32_t mismatches = 0;
+    uint64_t total_matches = 0;
+    uint64_t total_prefix_matches = 0;
+
+    double start = now_ns();
+    for (uint32_t q = 0; q < lookups; q++) {
+        count.matches = 0;
+        symbol_index_find_name(idx, sc, queries[q], 0, count_name_match,
+                               &count);
+        if (count.matches != expected[q] && mismatches++ < 10) {
+            fprintf(stderr, "Mismatch for '%s': %llu matches, expected %llu\n",
+                    queries[q], (unsigned long long)count.matches,
+                    (unsigned long long)expected[q]);
+        }
+        total_matches += count.matches;
+    }
+    double exact_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t q = 0; q < lookups; q++) {
+        char prefix[PREFIX_LEN + 1];
+        snprintf(prefix, sizeof(prefix), "%s", queries[q]);
+        count.matches = 0;
+        symbol_index_find_name(idx, sc, prefix, 1, count_name_match, &count);
+        if (count.matches != expected_prefix[q] && mismatches++ < 10) {
+            fprintf(stderr,
+                    "Mismatch for prefix '%s': %llu matches, expected %llu\n",
+                    prefix, (unsigned long long)count.matches,
+                    (unsigned long long)expected_prefix[q]);
+        }
+        total_prefix_matches += count.matches;
+    }
+    double prefix_ns = now_ns() - start;
+
+    /* Every image exports e::fNNNNN() for the same NNNNN values */
+    uint64_t total_cxx_matches = 0;
+    start = now_ns();
+    for (uint32_t q = 0; q < cxx_count; q++) {
+        count.matches = 0;
+        symbol_index_find_name(idx, sc, cxx_queries[q], 0, count_name_match,
+                               &count);
+        if (count.matches != expected_cxx[q] && mismatches++ < 10) {
+            fprintf(stderr, "Mismatch for '%s': %llu matches, expected %llu\n",
+                    cxx_queries[q], (unsigned long long)count.matches,
+                    (unsigned long long)expected_cxx[q]);
+        }
+        total_cxx_matches += count.matches;
+    }
+    double cxx_ns = now_ns() - start;
+
+    printf("Name lookups: %u (%llu names indexed)\n", lookups,
+           (unsigned long long)idx->header->name_count);
+    printf("  exact:  %10.1f ns/lookup (%.1f matches)\n", exact_ns / lookups,
+           (double)total_matches / lookups);
+    printf("  prefix: %10.1f ns/lookup (%.1f matches)\n", prefix_ns / lookups,
+           (double)total_prefix_matches / lookups);
+    if (cxx_count > 0) {
+        printf("  C++:    %10.1f ns/lookup (%.1f matches)\n",
+               cxx_ns / cxx_count, (double)total_cxx_matches / cxx_count);
+    }
+
+    free(queries);
+    free(cxx_queries);
+    free(expected);
+    free(expected_prefix);
+    free(expected_cxx);
+    if (mismatches) {
+        fprintf(stderr, "Error: %u name lookups returned the wrong names\n",
+                mismatches);
+        return 1;
+    }
+    return 0;
+}
+
+#define SERVE_BATCH 1000 /* addresses per request */
+#define SERVE_ROUNDS 20  /* passes over the lookup addresses per protocol */
+
+struct serve_thread {
+    struct symbol_server_config config;
+    struct symbol_server_stats stats;
+    int result;
+};
+
+static void *serve_thread_main(void *arg) {
+    struct serve_thread *st = arg;
+    st->result = symbol_server_run(&st->config, &st->stats);
+    return NULL;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *data, size_t len) {
+    char *p = data;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Connect to the server, waiting for it to start listening.
+ *
+ * @param socket_path Fits in sun_path
+ *
+ * @return The socket, or -1 if the server did not start within 10 seconds
+ */
+static int connect_server(const char *socket_path,
+                          const struct serve_thread *st) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, socket_path, strlen(socket_path) + 1);
+
+    for (int attempt = 0; attempt < 1000 && st->result == 0; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        usleep(10000);
+    }
+    return -1;
+}
+
+/**
+ * One binary request and its response.
+ *
+ * @param check Compare every result with symbol_index_lookup()
+ * @return      Mismatched results, or -1 on a protocol error
+ */
+static int64_t serve_binary_batch(int fd, const struct shared_cache *sc,
+                                  const struct symbol_index *idx,
+                                  const uint64_t *addrs, uint32_t count,
+                                  int check, char **buf, size_t *buf_cap,
+                                  uint64_t *latency_ns) {
+    struct symbol_server_request request;
+    memcpy(request.magic, SYMBOL_SERVER_REQUEST_MAGIC, sizeof(request.magic));
+    request.count = count;
+    memcpy(request.uuid, sc->header->uuid, sizeof(request.uuid));
+    struct symbol_server_response response;
+    if (write_all(fd, &request, sizeof(request)) != 0 ||
+        write_all(fd, addrs, count * sizeof(*addrs)) != 0 ||
+        read_all(fd, &response, sizeof(response)) != 0 ||
+        response.status != SYMBOL_SERVER_OK || response.count != count)
+        return -1;
+
+    size_t len = count * sizeof(struct symbol_server_result) +
+                 response.strings_size;
+    if (len > *buf_cap) {
+        char *grown = realloc(*buf, len);
+        if (grown == NULL)
+            return -1;
+        *buf = grown;
+        *buf_cap = len;
+    }
+    if (read_all(fd, *buf, len) != 0)
+        return -1;
+    *latency_ns += response.latency_ns;
+
+    int64_t mismatches = 0;
+    const char *strings = *buf + count * sizeof(struct symbol_server_result);
+    for (uint32_t i = 0; check && i < count; i++) {
+        struct symbol_server_result result;
+        memcpy(&result, *buf + i * sizeof(result), sizeof(result));
+        const char *name;
+        uint64_t sym_addr;
+        int32_t image_index;
+        int hit = symbol_index_lookup(idx, sc, addrs[i], &name, &sym_addr,
+                                      &image_index) == 0;
+        int served = result.symbol_name != SYMBOL_SERVER_NO_STRING &&
+                     result.symbol_name < response.strings_size;
+        if (result.image_index != image_index || hit != served ||
+            (hit && (result.symbol_addr != sym_addr ||
+                     strcmp(strings + result.symbol_name, name) != 0))) {
+            if (mismatches++ < 10) {
+                fprintf(stderr, "Mismatch at 0x%llx: index %s, server %s\n",
+                        (unsigned long long)addrs[i], hit ? name : "(none)",
+                        served ? strings + result.symbol_name : "(none)");
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * One text request; the response must have a line per address.
+ *
+ * @return 0 on success, -1 on a protocol error
+ */
+static int serve_text_batch(int fd, const uint8_t uuid[16],
+                            const uint64_t *addrs, uint32_t count,
+                            char **buf, size_t *buf_cap,
+                            uint64_t *latency_ns) {
+    size_t len = 0;
+    size_t need = 40 + (size_t)count * 20;
+    if (need > *buf_cap) {
+        char *grown = realloc(*buf, need);
+        if (grown == NULL)
+            return -1;
+        *buf = grown;
+        *buf_cap = need;
+    }
+    for (int i = 0; i < 16; i++)
+        len += (size_t)sprintf(*buf + len, "%02x", uuid[i]);
+    for (uint32_t i = 0; i < count; i++)
+        len += (size_t)sprintf(*buf + len, " %llx",
+                               (unsigned long long)addrs[i]);
+    (*buf)[len++] = '\n';
+    if (write_all(fd, *buf, len) != 0)
+        return -1;
+
+    /* Read until the status line and every result line have arrived */
+    size_t lines = 0;
+    len = 0;
+    while (lines < (size_t)count + 1) {
+        if (*buf_cap - len < 65536) {
+            char *grown = realloc(*buf, *buf_cap * 2 + 65536);
+            if (grown == NULL)
+                return -1;
+            *buf = grown;
+            *buf_cap = *buf_cap * 2 + 65536;
+        }
+        ssize_t n = read(fd, *buf + len, *buf_cap - len);
+        if (n <= 0)
+            return -1;
+        for (ssize_t i = 0; i < n; i++)
+            lines += (*buf)[len + (size_t)i] == '\n';
+        len += (size_t)n;
+    }
+
+    unsigned returned;
+    unsigned long long latency_us;
+    if (sscanf(*buf, "OK %u %llu", &returned, &latency_us) != 2 ||
+        returned != count || lines != (size_t)count + 1)
+        return -1;
+    *latency_ns += latency_us * 1000;
+    return 0;
+}
+
+/**
+ * Serve the cache on a socket next to it and time batches of addresses over
+ * both protocols.
+ *
+ * @return 0 if every batch succeeded and agreed with the index, 1 otherwise
+ */
+static int run_serve_benchmark(const char *cache_path,
+                               const struct shared_cache *sc,
+                               const struct symbol_index *idx,
+                               const uint64_t *addrs, uint32_t lookups) {
+    struct sockaddr_un addr;
+    char socket_path[sizeof(addr.sun_path)];
+    int len = snprintf(socket_path, sizeof(socket_path), "%s.sock", cache_path);
+    if (len < 0 || (size_t)len >= sizeof(socket_path)) {
+        fprintf(stderr, "Error: Socket path too long; set a shorter TMPDIR\n");
+        return 1;
+    }
+    int stop_pipe[2];
+    if (pipe(stop_pipe) != 0) {
+        perror("Error creating stop pipe");
+        return 1;
+    }
+
+    struct serve_thread st;
+    memset(&st, 0, sizeof(st));
+    st.config.socket_path = socket_path;
+    st.config.cache_paths = &cache_path;
+    st.config.cache_count = 1;
+    st.config.stop_fd = stop_pipe[0];
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, serve_thread_main, &st) != 0) {
+        fprintf(stderr, "Error: Cannot start server thread\n");
+        close(stop_pipe[0]);
+        close(stop_pipe[1]);
+        return 1;
+    }
+
+    int result = 1;
+    int fd = connect_server(socket_path, &st);
+    char *buf = NULL;
+    size_t buf_cap = 0;
+    uint64_t batches = 0;
+    uint64_t binary_latency_ns = 0;
+    uint64_t text_latency_ns = 0;
+    int64_t mismatches = 0;
+    double binary_ns = 0;
+    double text_ns = 0;
+
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot connect to %s\n", socket_path);
+    } else {
+        double start = now_ns();
+        for (uint32_t r = 0; r < SERVE_ROUNDS && mismatches >= 0; r++) {
+            for (uint32_t i = 0; i < lookups && mismatches >= 0;
+                 i += SERVE_BATCH) {
+                uint32_t count =
+                    lookups - i < SERVE_BATCH ? lookups - i : SERVE_BATCH;
+                int64_t rc = serve_binary_batch(fd, sc, idx, addrs + i, count,
+                                                r == 0, &buf, &buf_cap,
+                                                &binary_latency_ns);
+                mismatches = rc < 0 ? -1 : mismatches + rc;
+                batches += r == 0;
+            }
+        }
+        binary_ns = now_ns() - start;
+
+        start = now_ns();
+        for (uint32_t r = 0; r < SERVE_ROUNDS && mismatches >= 0; r++) {
+            for (uint32_t i = 0; i < lookups && mismatches >= 0;
+                 i += SERVE_BATCH) {
+                uint32_t count =
+                    lookups - i < SERVE_BATCH ? lookups - i : SERVE_BATCH;
+                if (serve_text_batch(fd, sc->header->uuid, addrs + i, count,
+                                     &buf, &buf_cap, &text_latency_ns) != 0)
+                    mismatches = -1;
+            }
+        }
+        text_ns = now_ns() - start;
+        close(fd);
+    }
+
+    if (write_all(stop_pipe[1], "", 1) != 0)
+        perror("Error stopping server");
+    pthread_join(thread, NULL);
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    free(buf);
+
+    if (fd < 0 || st.result != 0) {
+        /* Error already printed */
+    } else if (mismatches < 0) {
+        fprintf(stderr, "Error: Serving a batch failed\n");
+    } else if (mismatches > 0) {
+        fprintf(stderr, "Error: %lld served results differ from the index\n",
+                (long long)mismatches);
+    } else {
+        double addresses = (double)lookups * SERVE_ROUNDS;
+        double requests = (double)batches * SERVE_ROUNDS;
+        printf("Serve: %u requests of up to %u addresses, %u worker "
+               "thread%s\n",
+               (unsigned)st.stats.requests, SERVE_BATCH,
+               (unsigned)sysconf(_SC_NPROCESSORS_ONLN),
+               sysconf(_SC_NPROCESSORS_ONLN) == 1 ? "" : "s");
+        printf("  binary: %10.0f addresses/s (%.1f us/request, "
+               "%.1f us in server)\n",
+               addresses / (binary_ns / 1e9), binary_ns / requests / 1e3,
+               (double)binary_latency_ns / requests / 1e3);
+        printf("  text:   %10.0f addresses/s (%.1f us/request, "
+               "%.1f us in server)\n",
+               addresses / (text_ns / 1e9), text_ns / requests / 1e3,
+               (double)text_latency_ns / requests / 1e3);
+        result = 0;
+    }
+    return result;
+}
+
+/**
+ * Run the benchmark against an already written cache.
+ *
+ * @return 0 if every lookup agreed, 1 otherwise
+ */
+static int run_benchmark(const char *cache_path, const char *index_path,
+                         uint32_t symbols, uint32_t lookups, uint64_t seed) {
+    struct shared_cache sc;
+    struct symbol_index idx;
+    int result = 1;
+
+    if (open_shared_cache(cache_path, &sc) != 0) {
+        return 1;
+    }
+
+    double build_ns[BUILD_THREAD_RUNS];
+    if (time_builds(&sc, index_path, build_ns) != 0) {
+        close_shared_cache(&sc);
+        return 1;
+    }
+
+    if (symbol_index_open(index_path, &sc, &idx) != 0) {
+        fprintf(stderr, "Error: Cannot open symbol index %s: %s\n", index_path,
+                strerror(errno));
+        close_shared_cache(&sc);
+        return 1;
+    }
+
+    double start;
+    uint64_t *addrs = malloc(lookups * sizeof(*addrs));
+    const char **names = malloc(lookups * sizeof(*names));
+    uint64_t *sym_addrs = malloc(lookups * sizeof(*sym_addrs));
+    int *found = malloc(lookups * sizeof(*found));
+    if (addrs && names && sym_addrs && found) {
+        uint64_t rng = seed ^ 0x9e3779b97f4a7c15ULL;
+        uint32_t image_count = sc.header->imagesCount;
+        const char *name;
+        uint64_t sym_addr;
+        int32_t image_index;
+        uint32_t resolved = 0;
+        uint32_t mismatches = 0;
+
+        for (uint32_t i = 0; i < lookups; i++) {
+            uint32_t image = (uint32_t)(next_random(&rng) % image_count);
+            addrs[i] = sc.images[image].address +
+                       next_random(&rng) % SYNTH_TEXT_SIZE;
+        }
+
+        start = now_ns();
+        for (uint32_t i = 0; i < lookups; i++) {
+            found[i] = scan_lookup(&sc, addrs[i], &names[i], &sym_addrs[i],
+                                   &image_index) == 0;
+        }
+        double scan_ns = now_ns() - start;
+
+        start = now_ns();
+        for (uint32_t i = 0; i < lookups; i++) {
+            int hit = symbol_index_lookup(&idx, &sc, addrs[i], &name,
+                                          &sym_addr, &image_index) == 0;
+            if (hit != found[i] ||
+                (hit && (sym_addr != sym_addrs[i] ||
+                         strcmp(name, names[i]) != 0))) {
+                if (mismatches++ < 10) {
+                    fprintf(stderr, "Mismatch at 0x%llx: scan %s, index %s\n",
+                            (unsigned long long)addrs[i],
+                            found[i] ? names[i] : "(none)",
+                            hit ? name : "(none)");
+                }
+            }
+            resolved += hit;
+        }
+        double index_ns = now_ns() - start;
+
+        printf("Cache: %u images, %u dylib + %u local symbols each, "
+               "%.1f MiB\n",
+               image_count, symbols, symbols,
+               (double)sc.size / (1024.0 * 1024.0));
+        printf("Index: %llu symbols, %.1f MiB\n",
+               (unsigned long long)idx.header->symbol_count,
+               (double)idx.size / (1024.0 * 1024.0));
+        for (int r = 0; r < BUILD_THREAD_RUNS; r++) {
+            printf("  build, %2u thread%s %8.1f ms (%.2fx)\n",
+                   build_threads[r], build_threads[r] == 1 ? ": " : "s:",
+                   build_ns[r] / 1e6,
+                   build_ns[0] / build_ns[r]);
+        }
+        printf("Lookups: %u (%u resolved)\n", lookups, resolved);
+        printf("  scan:  %10.1f ns/lookup\n", scan_ns / lookups);
+        printf("  index: %10.1f ns/lookup (%.1fx)\n", index_ns / lookups,
+               scan_ns / index_ns);
+
+        if (mismatches) {
+            fprintf(stderr,
+                    "Error: %u lookups differ between scan and index\n",
+                    mismatches);
+        } else {
+            result = 0;
+        }
+    } else {
+        fprintf(stderr, "Error: Out of memory\n");
+    }
+
+    if (result == 0)
+        result = run_name_benchmark(&sc, &idx, lookups, seed);
+    if (result == 0)
+        result = run_serve_benchmark(cache_path, &sc, &idx, addrs, lookups);
+
+    free(addrs);
+    free(names);
+    free(sym_addrs);
+    free(found);
+    symbol_index_close(&idx);
+    close_shared_cache(&sc);
+    return result;
+}
+
+static int parse_count(const char *arg, uint32_t *out) {
+    char *end;
+    errno = 0;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (errno || *end || end == arg || value == 0 || value > UINT32_MAX) {
+        return -1;
+    }
+    *out = (uint32_t)value;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t image_count = 200;
+    uint32_t symbols = 20000;
+    uint32_t lookups = 10000;
+    const uint64_t seed = 0x6970737769646bULL;
+
+    if (argc > 4 || (argc > 1 && parse_count(argv[1], &image_count) != 0) ||
+        (argc > 2 && parse_count(argv[2], &symbols) != 0) ||
+        (argc > 3 && parse_count(argv[3], &lookups) != 0)) {
+        fprintf(stderr,
+                "Usage: %s [images] [symbols_per_table] [lookups]\n",
+                argv[0]);
+        return 1;
+    }
+
+    const char *tmpdir = getenv("TMPDIR");
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s/ipsw_index_benchmark.XXXXXX",
+             tmpdir && *tmpdir ? tmpdir : "/tmp");
+    if (!mkdtemp(dir)) {
+        perror("Error creating temporary directory");
+        return 1;
+    }
+
+    char cache_path[4096 + 32];
+    char index_path[4096 + 32];
+    snprintf(cache_path, sizeof(cache_path), "%s/cache", dir);
+    snprintf(index_path, sizeof(index_path), "%s/cache%s", dir,
+             SYMBOL_INDEX_SUFFIX);
+
+    int result = 1;
+    if (write_synthetic_cache(cache_path, image_count, symbols, seed) == 0) {
+        result = run_benchmark(cache_path, index_path, symbols, lookups,
+                               seed);
+    }
+
+    unlink(index_path);
+    unlink(cache_path);
+    rmdir(dir);
+    return result;
+}
@@ -1,956 +1,980 @@
 /*
  * IPSW CLI Tool - Address Lookup in dyld_shared_cache
  *
- * Usage: ipsw <dyld_shared_cache_path> <hex_address>
+ * Usage: ipsw [-v] [-i index] <dyld_shared_cache_path> <hex_address>
+ *        ipsw [-v] [-i index] -b <dyld_shared_cache_path> [address_file]
+ *        ipsw index [-j threads] [-o index] <dyld_shared_cache_path>
+ *        ipsw find [-v] [-p] [-i index] <dyld_shared_cache_path> <name>
+ *        ipsw serve [-v] [-j threads] [-m budget_mib] <socket_path>
+ *                   <dyld_shared_cache_path>...
  *
  * This tool accepts a dyld_shared_cache file path and a hexadecimal address,
- * then outputs which dynamic library the address belongs to.
+ * then outputs which dynamic library the address belongs to. Batch mode (-b)
+ * reads one address per line from a file or stdin and resolves them all
+ * against a single mapping of the cache. `ipsw index` writes a symbol index
+ * next to the cache, which later lookups use to binary search instead of
+ * scanning symbol tables. `ipsw find` uses the index to go the other way,
+ * from a symbol name to its address in every image. `ipsw serve` keeps
+ * indexed caches mapped and answers batches over a unix socket.
  *
  * Based on dyld-421.2 shared cache format.
  */
 
-#include <fcntl.h>
-#include <mach-o/loader.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
-/*
- * dyld_cache_header - Main shared cache header
- * Based on dyld-421.2/launch-cache/dyld_cache_format.h
- */
-struct dyld_cache_header {
-    char magic[16];           /* e.g. "dyld_v1   arm64" */
-    uint32_t mappingOffset;   /* file offset to first dyld_cache_mapping_info */
-    uint32_t mappingCount;    /* number of dyld_cache_mapping_info entries */
-    uint32_t imagesOffset;    /* file offset to first dyld_cache_image_info */
-    uint32_t imagesCount;     /* number of dyld_cache_image_info entries */
-    uint64_t dyldBaseAddress; /* base address of dyld when cache was built */
-    uint64_t codeSignatureOffset; /* file offset of code signature blob */
-    uint64_t codeSignatureSize;   /* size of code signature blob */
-    uint64_t slideInfoOffset;     /* file offset of kernel slid info */
-    uint64_t slideInfoSize;       /* size of kernel slid info */
-    uint64_t
-        localSymbolsOffset; /* file offset of where local symbols are stored */
-    uint64_t localSymbolsSize; /* size of local symbols information */
-    uint8_t uuid[16];          /* unique value for each shared cache file */
-    uint64_t cacheType;        /* 0 for development, 1 for production */
-    uint32_t
-        branchPoolsOffset; /* file offset to table of uint64_t pool addresses */
-    uint32_t branchPoolsCount;   /* number of uint64_t entries */
-    uint64_t accelerateInfoAddr; /* (unslid) address of optimization info */
-    uint64_t accelerateInfoSize; /* size of optimization info */
-    uint64_t
-        imagesTextOffset; /* file offset to first dyld_cache_image_text_info */
-    uint64_t imagesTextCount; /* number of dyld_cache_image_text_info entries */
-};
-
-/*
- * dyld_cache_mapping_info - Maps file regions to virtual addresses
- */
-struct dyld_cache_mapping_info {
-    uint64_t address;
-    uint64_t size;
-    uint64_t fileOffset;
-    uint32_t maxProt;
-    uint32_t initProt;
-};
-
-/*
- * dyld_cache_image_info - Information about each dylib in the cache
- */
-struct dyld_cache_image_info {
-    uint64_t address; /* unslid address of start of __TEXT */
-    uint64_t modTime;
-    uint64_t inode;
-    uint32_t pathFileOffset; /* file offset of path string */
-    uint32_t pad;
-};
-
-/*
- * dyld_cache_accelerator_info - Accelerator table header
- * Contains offsets to various optimization tables including rangeTable.
- * Based on dyld-421.2/launch-cache/dyld_cache_format.h
- */
-struct dyld_cache_accelerator_info {
-    uint32_t version;          /* currently 1 */
-    uint32_t imageExtrasCount; /* does not include aliases */
-    uint32_t
-        imagesExtrasOffset; /* offset to first dyld_cache_image_info_extra */
-    uint32_t
-        bottomUpListOffset;   /* offset to bottom-up sorted image index list */
-    uint32_t dylibTrieOffset; /* offset to dylib path trie */
-    uint32_t dylibTrieSize;   /* size of dylib trie */
-    uint32_t initializersOffset; /* offset to initializers list */
-    uint32_t initializersCount;  /* count of initializers */
-    uint32_t dofSectionsOffset;  /* offset to DOF sections */
-    uint32_t dofSectionsCount;   /* count of DOF sections */
-    uint32_t reExportListOffset; /* offset to re-export list */
-    uint32_t reExportCount;      /* count of re-exports */
-    uint32_t depListOffset;      /* offset to dependency list */
-    uint32_t depListCount;       /* count of dependencies */
-    uint32_t rangeTableOffset;   /* offset to range table */
-    uint32_t rangeTableCount;    /* count of range entries */
-    uint64_t dyldSectionAddr;    /* address of libdyld's __dyld section */
-};
-
-/*
- * dyld_cache_range_entry - Maps an address range to an image index
- * Entries are sorted by startAddress for binary search.
- */
-struct dyld_cache_range_entry {
-    uint64_t startAddress; /* unslid address of region start */
-    uint32_t size;         /* size of region in bytes */
-    uint32_t imageIndex;   /* index into dyld_cache_image_info array */
-};
-
-/**
- * Header for local symbols section in dyld_shared_cache.
- * Located at header->localSymbolsOffset in the cache file.
- * Based on dyld-421.2/launch-cache/dyld_cache_format.h
- */
-struct dyld_cache_local_symbols_info {
-    uint32_t nlistOffset;   /* Offset to nlist entries (from this struct) */
-    uint32_t nlistCount;    /* Total count of nlist entries */
-    uint32_t stringsOffset; /* Offset to string table (from this struct) */
-    uint32_t stringsSize;   /* Size of string table in bytes */
-    uint32_t entriesOffset; /* Offset to entries array (from this struct) */
-    uint32_t entriesCount;  /* Number of entries (one per dylib) */
-};
-
-/**
- * Per-dylib entry in local symbols table.
- * Maps a dylib to its range of symbols in the shared nlist array.
- */
-struct dyld_cache_local_symbols_entry {
-    uint32_t dylibOffset;     /* File offset of dylib's mach_header in cache */
-    uint32_t nlistStartIndex; /* First symbol index for this dylib */
-    uint32_t nlistCount;      /* Number of symbols for this dylib */
-};
+#include "ipsw/dyld_cache.h"
+#include "ipsw/symbol_index.h"
+#include "ipsw/symbol_server.h"
 
 /**
- * 64-bit symbol table entry (from <mach-o/nlist.h>).
- */
-struct nlist_64 {
-    uint32_t n_strx;  /* Index into string table */
-    uint8_t n_type;   /* Type flags (N_EXT, N_TYPE, etc.) */
-    uint8_t n_sect;   /* Section number (1-based) or NO_SECT */
-    uint16_t n_desc;  /* Description field */
-    uint64_t n_value; /* Symbol value (address for defined symbols) */
-};
-
-/* n_type masks */
-#define N_STAB 0xe0 /* Stabs debugging symbol */
-#define N_PEXT 0x10 /* Private external symbol */
-#define N_TYPE 0x0e /* Type mask */
-#define N_EXT 0x01  /* External symbol */
-
-/* n_type values for N_TYPE bits */
-#define N_UNDF 0x00 /* Undefined */
-#define N_ABS 0x02  /* Absolute */
-#define N_SECT 0x0e /* Defined in section n_sect */
-
-/* Note: LC_SYMTAB, LC_SEGMENT_64, struct symtab_command, and
- * struct segment_command_64 are defined in <mach-o/loader.h> */
-
-/*
- * Convert a virtual address to a file offset using the mapping table.
- * Returns -1 if the address is not in any mapping.
- */
-static int64_t
-addr_to_file_offset(const struct dyld_cache_mapping_info *mappings,
-                    uint32_t mapping_count, uint64_t addr) {
-    for (uint32_t i = 0; i < mapping_count; i++) {
-        uint64_t start = mappings[i].address;
-        uint64_t end = start + mappings[i].size;
-        if (addr >= start && addr < end) {
-            return (int64_t)(mappings[i].fileOffset + (addr - start));
-        }
-    }
-    return -1;
-}
-
-/*
- * Get the accelerator info from the cache.
- * Returns pointer to accelerator info, or NULL if not available.
+ * Look up a single address and print the result.
  *
- * The accelerator info requires:
- * - mappingOffset >= 0x78 (header has accelerateInfo fields)
- * - accelerateInfoAddr != 0
- * - accelerateInfoSize != 0
+ * @param sc          Mapped cache
+ * @param idx         Symbol index for the cache, or NULL to scan
+ * @param target_addr Address to look up (unslid)
+ * @param verbose     Verbose output flag
+ * @return            Process exit code
  */
-static const struct dyld_cache_accelerator_info *
-get_accelerator_info(const uint8_t *cache, size_t cache_size,
-                     const struct dyld_cache_header *header,
-                     const struct dyld_cache_mapping_info *mappings,
-                     uint32_t mapping_count) {
-    /* Check if header has accelerateInfo fields (mappingOffset >= 0x78) */
-    if (header->mappingOffset < 0x78) {
-        return NULL;
-    }
+static int symbolicate_one(const struct shared_cache *sc,
+                           const struct symbol_index *idx,
+                           uint64_t target_addr, int verbose) {
+    const struct dyld_cache_header *header = sc->header;
+    const struct dyld_cache_local_symbols_info *local_info = sc->local_info;
 
-    /* Check if accelerateInfo is present */
-    if (header->accelerateInfoAddr == 0 || header->accelerateInfoSize == 0) {
-        return NULL;
-    }
-
-    /* Convert accelerateInfoAddr to file offset */
-    int64_t file_offset = addr_to_file_offset(mappings, mapping_count,
-                                              header->accelerateInfoAddr);
-    if (file_offset < 0) {
-        return NULL;
-    }
-
-    /* Bounds check for accelerator info */
-    if ((uint64_t)file_offset + sizeof(struct dyld_cache_accelerator_info) >
-        cache_size) {
-        return NULL;
+    if (verbose) {
+        printf("Cache magic: %.16s\n", header->magic);
+        printf("Image count: %u\n", header->imagesCount);
+        if (idx != NULL) {
+            printf("Index symbols: %llu\n",
+                   (unsigned long long)idx->header->symbol_count);
+        }
+        printf("Target address: 0x%llx\n", (unsigned long long)target_addr);
+        printf("\n");
     }
 
-    const struct dyld_cache_accelerator_info *accel_info =
-        (const struct dyld_cache_accelerator_info *)(cache + file_offset);
-
-    /* Validate version (currently 1) */
-    if (accel_info->version != 1) {
-        return NULL;
-    }
+    /* Perform symbol lookup */
+    const char *symbol_name = NULL;
+    uint64_t symbol_addr = 0;
+    int32_t image_index = -1;
 
-    /* Validate rangeTable bounds */
-    if (accel_info->rangeTableCount == 0) {
-        return NULL;
+    int symbol_found;
+    if (idx != NULL) {
+        symbol_found = symbol_index_lookup(idx, sc, target_addr, &symbol_name,
+                                           &symbol_addr, &image_index);
+    } else {
+        symbol_found = find_symbol_for_address(
+            sc->data, sc->size, header, sc->mappings, header->mappingCount,
+            local_info, sc->range_table, sc->accel_info->rangeTableCount,
+            target_addr, &symbol_name, &symbol_addr, &image_index, verbose);
     }
 
-    uint64_t range_table_end = (uint64_t)file_offset +
-                               accel_info->rangeTableOffset +
-                               (uint64_t)accel_info->rangeTableCount *
-                                   sizeof(struct dyld_cache_range_entry);
-    if (range_table_end > cache_size) {
-        return NULL;
+    /* Check if we at least found the containing dylib */
+    if (image_index < 0) {
+        /* Address not in any dylib */
+        fprintf(stderr, "Error: Address 0x%llx not found in any dylib\n",
+                (unsigned long long)target_addr);
+        return 1;
     }
 
-    return accel_info;
-}
-
-/**
- * Get the local symbols info from the cache.
- * Returns pointer to local symbols info, or NULL if not available.
- *
- * @param cache       Pointer to mmap'd cache file
- * @param cache_size  Size of cache file
- * @param header      Cache header pointer
- * @return            Pointer to local symbols info, or NULL if not available
- */
-static const struct dyld_cache_local_symbols_info *
-get_local_symbols_info(const uint8_t *cache, size_t cache_size,
-                       const struct dyld_cache_header *header) {
-    /* Check if localSymbols is present */
-    if (header->localSymbolsOffset == 0 || header->localSymbolsSize == 0) {
-        return NULL;
+    /* Get the dylib path */
+    const struct dyld_cache_image_info *image = &sc->images[image_index];
+    if (image->pathFileOffset >= sc->size) {
+        fprintf(stderr, "Error: Invalid path offset for image %d\n",
+                image_index);
+        return 1;
     }
 
-    /* Bounds check for local symbols info */
-    if (header->localSymbolsOffset +
-            sizeof(struct dyld_cache_local_symbols_info) >
-        cache_size) {
-        return NULL;
-    }
+    const char *dylib_path = (const char *)(sc->data + image->pathFileOffset);
 
-    const struct dyld_cache_local_symbols_info *local_info =
-        (const struct dyld_cache_local_symbols_info
-             *)(cache + header->localSymbolsOffset);
-
-    /* Validate offsets within local symbols section */
-    uint64_t nlist_end =
-        (uint64_t)local_info->nlistOffset +
-        (uint64_t)local_info->nlistCount * sizeof(struct nlist_64);
-    uint64_t strings_end =
-        (uint64_t)local_info->stringsOffset + local_info->stringsSize;
-    uint64_t entries_end = (uint64_t)local_info->entriesOffset +
-                           (uint64_t)local_info->entriesCount *
-                               sizeof(struct dyld_cache_local_symbols_entry);
-
-    /* All offsets are relative to local_info, check they fit in
-     * localSymbolsSize */
-    if (nlist_end > header->localSymbolsSize ||
-        strings_end > header->localSymbolsSize ||
-        entries_end > header->localSymbolsSize) {
-        return NULL;
+    /* Ensure path string is null-terminated within bounds */
+    size_t max_path_len = sc->size - image->pathFileOffset;
+    size_t path_len = strnlen(dylib_path, max_path_len);
+    if (path_len == max_path_len) {
+        fprintf(stderr, "Error: Path string not null-terminated for image %d\n",
+                image_index);
+        return 1;
     }
 
-    return local_info;
-}
-
-/**
- * Convert imageIndex (from rangeTable) to dylibOffset (for local symbols
- * entry).
- *
- * @param cache         Pointer to mmap'd cache file
- * @param header        Cache header pointer
- * @param mappings      Mapping info array
- * @param mapping_count Number of mappings
- * @param image_index   Index from rangeTable lookup
- * @return              File offset of dylib's mach_header, or -1 on error
- *
- * The rangeTable returns an imageIndex into dyld_cache_image_info array.
- * The local_symbols_entry uses dylibOffset (file offset of mach_header).
- * This function bridges the two by:
- *   1. Looking up the image's virtual address from images[imageIndex].address
- *   2. Converting that virtual address to a file offset via mapping table
- */
-static int64_t
-image_index_to_dylib_offset(const uint8_t *cache,
-                            const struct dyld_cache_header *header,
-                            const struct dyld_cache_mapping_info *mappings,
-                            uint32_t mapping_count, uint32_t image_index) {
-    /* Get image info array */
-    const struct dyld_cache_image_info *images =
-        (const struct dyld_cache_image_info *)(cache + header->imagesOffset);
-
-    /* Bounds check */
-    if (image_index >= header->imagesCount)
-        return -1;
-
-    /* Get dylib's __TEXT segment virtual address */
-    uint64_t image_addr = images[image_index].address;
+    const char *dylib_basename = get_basename(dylib_path);
 
-    /* Convert virtual address to file offset using mapping table */
-    return addr_to_file_offset(mappings, mapping_count, image_addr);
-}
+    if (symbol_found == 0 && symbol_name != NULL) {
+        /* Symbol found - output in atos-compatible format */
+        uint64_t offset = target_addr - symbol_addr;
+        const char *display_name = strip_leading_underscore(symbol_name);
 
-/**
- * Find the local symbols entry for a given dylib file offset.
- *
- * @param entries       Pointer to entries array
- * @param entries_count Number of entries
- * @param dylib_offset  File offset of dylib's mach_header (from
- * image_index_to_dylib_offset)
- * @return              Pointer to matching entry, or NULL if not found
- *
- * Time Complexity: O(n) where n = entries_count
- *
- * Note: The entries array order may not match the images array order.
- * A linear search is required to find the matching dylibOffset.
- * The caller must ensure dylib_offset is valid (>= 0) before calling.
- */
-static const struct dyld_cache_local_symbols_entry *
-find_local_symbols_entry(const struct dyld_cache_local_symbols_entry *entries,
-                         uint32_t entries_count, uint64_t dylib_offset) {
-    for (uint32_t i = 0; i < entries_count; i++) {
-        if ((uint64_t)entries[i].dylibOffset == dylib_offset) {
-            return &entries[i];
+        if (verbose) {
+            printf("Image: %s\n", dylib_path);
+            printf("Symbol: %s\n", display_name);
+            printf("Symbol address: 0x%llx\n", (unsigned long long)symbol_addr);
+            printf("Offset: +0x%llx\n", (unsigned long long)offset);
+        } else {
+            /* atos-compatible output: symbol (in dylib) + offset */
+            printf("%s (in %s) + 0x%llx\n", display_name, dylib_basename,
+                   (unsigned long long)offset);
+        }
+    } else {
+        /* No symbol found - fallback to dylib-only output */
+        if (local_info == NULL) {
+            fprintf(stderr, "Note: No local symbols available\n");
         }
-    }
-    return NULL;
-}
-
-/**
- * Search symbol table for the closest match to target address.
- *
- * @param nlist_base    Base pointer to nlist_64 array
- * @param string_table  Base pointer to string table
- * @param start_index   First nlist index for this image
- * @param count         Number of nlist entries for this image
- * @param target_addr   Target address (unslid)
- * @param best_name     [out] Best matching symbol name (unchanged if not found)
- * @param best_addr     [out] Best matching symbol address (unchanged if not
- * found)
- * @return              true if a symbol was found, false otherwise
- *
- * Time Complexity: O(n) where n = count
- * Space Complexity: O(1)
- */
-static int search_symbol_table(const struct nlist_64 *nlist_base,
-                               const char *string_table, uint32_t start_index,
-                               uint32_t count, uint64_t target_addr,
-                               const char **best_name, uint64_t *best_addr,
-                               int verbose) {
-    const struct nlist_64 *best_symbol = NULL;
-
-    (void)verbose; /* Reserved for future use */
-
-    for (uint32_t i = 0; i < count; i++) {
-        const struct nlist_64 *sym = &nlist_base[start_index + i];
-
-        /* Skip stabs debugging symbols */
-        if ((sym->n_type & N_STAB) != 0)
-            continue;
-
-        /* Only consider symbols defined in a section */
-        if ((sym->n_type & N_TYPE) != N_SECT)
-            continue;
 
-        /* Symbol must not be past the target address */
-        if (sym->n_value > target_addr)
-            continue;
+        /* Calculate offset from dylib's __TEXT base */
+        uint64_t dylib_base = image->address;
+        uint64_t offset = target_addr - dylib_base;
 
-        /* Select if this is the closest so far */
-        if (best_symbol == NULL || sym->n_value > best_symbol->n_value) {
-            best_symbol = sym;
+        if (verbose) {
+            printf("Image: %s\n", dylib_path);
+            printf("Symbol: (not found)\n");
+            printf("Dylib base: 0x%llx\n", (unsigned long long)dylib_base);
+            printf("Offset: +0x%llx\n", (unsigned long long)offset);
+        } else {
+            /* Fallback output: (in dylib) + offset */
+            printf("(in %s) + 0x%llx\n", dylib_basename,
+                   (unsigned long long)offset);
         }
     }
 
-    if (best_symbol != NULL) {
-        *best_name = &string_table[best_symbol->n_strx];
-        *best_addr = best_symbol->n_value;
-        return 1;
-    }
     return 0;
 }
 
+/*
+ * One address of a batch. Queries are sorted by image and address while they
+ * are resolved, then back into input order for output.
+ */
+struct batch_query {
+    uint64_t addr;        /* unslid address from the input */
+    size_t input_index;   /* position in the input */
+    int32_t image_index;  /* containing image, or -1 if none */
+    const char *sym_name; /* closest symbol at or below addr, or NULL */
+    uint64_t sym_addr;    /* address of sym_name */
+};
+
 /**
- * Search dylib's own symbol table from its Mach-O header.
- *
- * In the dyld_shared_cache, each dylib's symbol table offsets (from LC_SYMTAB)
- * are relative to the __LINKEDIT segment base of the dylib. We need to:
- * 1. Find LC_SEGMENT_64(__LINKEDIT) to get linkedit_base
- * 2. Find LC_SYMTAB to get symbol table info
- * 3. Calculate actual pointers using the cache's __LINKEDIT mapping
+ * Read one hexadecimal address per line. Surrounding whitespace is ignored
+ * and blank lines are skipped.
  *
- * @param cache         Pointer to mmap'd cache file
- * @param cache_size    Size of cache file
- * @param mappings      Mapping info array
- * @param mapping_count Number of mappings
- * @param dylib_offset  File offset of dylib's mach_header in cache
- * @param target_addr   Target address to look up
- * @param best_name     [in/out] Best matching symbol name
- * @param best_addr     [in/out] Best matching symbol address
- * @param verbose       Verbose output flag
- * @return              true if a better symbol was found, false otherwise
+ * @param in          Input stream
+ * @param queries_out [out] Queries in input order (caller frees)
+ * @param count_out   [out] Number of queries
+ * @return            0 on success, -1 on failure (error printed to stderr)
  */
-static int
-search_dylib_symbol_table(const uint8_t *cache, size_t cache_size,
-                          const struct dyld_cache_mapping_info *mappings,
-                          uint32_t mapping_count, uint64_t dylib_offset,
-                          uint64_t target_addr, const char **best_name,
-                          uint64_t *best_addr, int verbose) {
-    /* Get mach_header_64 at dylib_offset */
-    if (dylib_offset + sizeof(struct mach_header_64) > cache_size) {
-        return 0;
-    }
-
-    const struct mach_header_64 *mh =
-        (const struct mach_header_64 *)(cache + dylib_offset);
-
-    /* Validate magic */
-    if (mh->magic != MH_MAGIC_64) {
-        return 0;
-    }
-
-    /* Find LC_SYMTAB and LC_SEGMENT_64(__LINKEDIT) */
-    const struct symtab_command *symtab_cmd = NULL;
-    uint64_t linkedit_vmaddr = 0;
-    uint64_t linkedit_fileoff = 0;
-
-    const uint8_t *lc_ptr = (const uint8_t *)(mh + 1);
-    const uint8_t *lc_end = lc_ptr + mh->sizeofcmds;
-
-    if ((uint64_t)(lc_end - cache) > cache_size) {
-        return 0;
-    }
-
-    for (uint32_t i = 0; i < mh->ncmds && lc_ptr < lc_end; i++) {
-        const struct load_command *lc = (const struct load_command *)lc_ptr;
-
-        if (lc->cmdsize < sizeof(struct load_command) ||
-            lc_ptr + lc->cmdsize > lc_end) {
+static int read_batch_addresses(FILE *in, struct batch_query **queries_out,
+                                size_t *count_out) {
+    struct batch_query *queries = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    size_t line_no = 0;
+    ssize_t len;
+    int ret = 0;
+
+    while ((len = getline(&line, &line_cap, in)) >= 0) {
+        line_no++;
+
+        char *start = line;
+        char *end = line + len;
+        while (start < end && isspace((unsigned char)*start))
+            start++;
+        while (end > start && isspace((unsigned char)end[-1]))
+            end--;
+        if (start == end)
+            continue;
+        *end = '\0';
+
+        char *endptr;
+        uint64_t addr = strtoull(start, &endptr, 16);
+        if (*endptr != '\0' || endptr == start) {
+            fprintf(stderr,
+                    "Error: Invalid hexadecimal address '%s' on line %zu\n",
+                    start, line_no);
+            ret = -1;
             break;
         }
 
-        if (lc->cmd == LC_SYMTAB) {
-            symtab_cmd = (const struct symtab_command *)lc;
-        } else if (lc->cmd == LC_SEGMENT_64) {
-            const struct segment_command_64 *seg =
-                (const struct segment_command_64 *)lc;
-            if (strncmp(seg->segname, "__LINKEDIT", 16) == 0) {
-                linkedit_vmaddr = seg->vmaddr;
-                linkedit_fileoff = seg->fileoff;
+        if (count == cap) {
+            size_t new_cap = cap ? cap * 2 : 256;
+            struct batch_query *grown =
+                realloc(queries, new_cap * sizeof(*queries));
+            if (grown == NULL) {
+                perror("Error allocating addresses");
+                ret = -1;
+                break;
             }
+            queries = grown;
+            cap = new_cap;
         }
 
-        lc_ptr += lc->cmdsize;
+        struct batch_query *q = &queries[count];
+        q->addr = addr;
+        q->input_index = count;
+        q->image_index = -1;
+        q->sym_name = NULL;
+        q->sym_addr = 0;
+        count++;
     }
 
-    if (symtab_cmd == NULL || linkedit_vmaddr == 0) {
-        return 0;
+    if (ret == 0 && ferror(in)) {
+        perror("Error reading addresses");
+        ret = -1;
     }
+    free(line);
 
-    /* In shared cache, symbol/string offsets are relative to __LINKEDIT file
-     * offset But the actual data is in the cache's __LINKEDIT mapping. We need
-     * to convert: symoff (file-based) -> cache file offset
-     *
-     * The formula is:
-     *   actual_offset = linkedit_fileoff + (symoff - (linkedit_vmaddr -
-     * linkedit_vmaddr)) But in shared cache, all dylibs share the same
-     * __LINKEDIT segment from the cache. So we need to use the cache's
-     * __LINKEDIT mapping to find the data.
-     *
-     * symoff and stroff are offsets from the original dylib's __LINKEDIT base.
-     * We need to add them to linkedit_fileoff to get the cache file offset.
-     */
-
-    /* Convert linkedit_vmaddr to file offset in cache */
-    int64_t linkedit_cache_offset =
-        addr_to_file_offset(mappings, mapping_count, linkedit_vmaddr);
-    if (linkedit_cache_offset < 0) {
-        return 0;
-    }
-
-    /* Calculate symbol table and string table pointers */
-    uint64_t symtab_offset =
-        (uint64_t)linkedit_cache_offset + symtab_cmd->symoff - linkedit_fileoff;
-    uint64_t strtab_offset =
-        (uint64_t)linkedit_cache_offset + symtab_cmd->stroff - linkedit_fileoff;
-
-    /* Bounds check */
-    if (symtab_offset + symtab_cmd->nsyms * sizeof(struct nlist_64) >
-        cache_size) {
-        return 0;
-    }
-    if (strtab_offset + symtab_cmd->strsize > cache_size) {
-        return 0;
+    if (ret != 0) {
+        free(queries);
+        return -1;
     }
+    *queries_out = queries;
+    *count_out = count;
+    return 0;
+}
 
-    const struct nlist_64 *nlist =
-        (const struct nlist_64 *)(cache + symtab_offset);
-    const char *strtab = (const char *)(cache + strtab_offset);
+static int compare_query_by_image(const void *a, const void *b) {
+    const struct batch_query *qa = a;
+    const struct batch_query *qb = b;
+    if (qa->image_index != qb->image_index)
+        return qa->image_index < qb->image_index ? -1 : 1;
+    if (qa->addr != qb->addr)
+        return qa->addr < qb->addr ? -1 : 1;
+    return qa->input_index < qb->input_index ? -1 : 1;
+}
 
-    (void)verbose; /* Reserved for future use */
+static int compare_query_by_input(const void *a, const void *b) {
+    const struct batch_query *qa = a;
+    const struct batch_query *qb = b;
+    if (qa->input_index != qb->input_index)
+        return qa->input_index < qb->input_index ? -1 : 1;
+    return 0;
+}
 
-    int found_better = 0;
+/**
+ * Offer every defined symbol of one symbol table to a group of queries.
+ *
+ * @param group   Queries of one image, sorted by address (count > 0)
+ * @param count   Number of queries in group
+ * @param nlist   First symbol table entry to consider
+ * @param nsyms   Number of entries to consider
+ * @param strtab  String table for the entries
+ * @param strsize Size of strtab in bytes
+ *
+ * Each symbol is filed under the first query at or above its address, keeping
+ * the highest address per query. Within a query's slot every candidate lies
+ * above the previous query's address, so a running maximum over the sorted
+ * group (see resolve_query_group) gives each query its closest symbol at or
+ * below it.
+ *
+ * Time Complexity: O(m log q) where m = nsyms, q = count
+ */
+static void offer_symbols_to_group(struct batch_query *group, size_t count,
+                                   const struct nlist_64 *nlist, uint32_t nsyms,
+                                   const char *strtab, uint32_t strsize) {
+    uint64_t max_addr = group[count - 1].addr;
 
-    for (uint32_t i = 0; i < symtab_cmd->nsyms; i++) {
+    for (uint32_t i = 0; i < nsyms; i++) {
         const struct nlist_64 *sym = &nlist[i];
 
-        /* Skip stabs debugging symbols */
+        /* Same filters as the single-address search */
         if ((sym->n_type & N_STAB) != 0)
             continue;
-
-        /* Only consider symbols defined in a section */
         if ((sym->n_type & N_TYPE) != N_SECT)
             continue;
-
-        /* Symbol must not be past the target address */
-        if (sym->n_value > target_addr)
+        if (sym->n_value > max_addr)
             continue;
-
-        /* Bounds check for string index */
-        if (sym->n_strx >= symtab_cmd->strsize)
+        if (sym->n_strx >= strsize)
             continue;
 
-        const char *sym_name = &strtab[sym->n_strx];
-
-        /* Select if this is closer than current best */
-        if (*best_addr == 0 || sym->n_value > *best_addr) {
-            *best_name = sym_name;
-            *best_addr = sym->n_value;
-            found_better = 1;
+        /* First query with addr >= n_value */
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (group[mid].addr < sym->n_value) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
         }
-    }
-
-    return found_better;
-}
 
-/**
- * Binary search for address in sorted rangeTable.
- *
- * @param rangeTable Pointer to sorted range entry array
- * @param count      Number of entries in rangeTable
- * @param addr       Target address to find (unslid)
- * @return           Pointer to matching entry, or NULL if not found
- *
- * Time Complexity: O(log n) where n = rangeTableCount
- */
-static const struct dyld_cache_range_entry *
-binary_search_range_table(const struct dyld_cache_range_entry *rangeTable,
-                          uint32_t count, uint64_t addr) {
-    uint32_t low = 0;
-    uint32_t high = count;
-
-    while (low < high) {
-        uint32_t mid = low + (high - low) / 2;
-        const struct dyld_cache_range_entry *entry = &rangeTable[mid];
-
-        if (addr < entry->startAddress) {
-            high = mid;
-        } else if (addr >= entry->startAddress + entry->size) {
-            low = mid + 1;
-        } else {
-            /* addr is within [startAddress, startAddress + size) */
-            return entry;
+        struct batch_query *q = &group[low];
+        if (q->sym_name == NULL || sym->n_value > q->sym_addr) {
+            q->sym_name = &strtab[sym->n_strx];
+            q->sym_addr = sym->n_value;
         }
     }
-    return NULL;
 }
 
 /**
- * Find the closest symbol for a given address.
- *
- * @param cache             Pointer to mmap'd cache file
- * @param cache_size        Size of cache file
- * @param header            Cache header pointer
- * @param mappings          Mapping info array
- * @param mapping_count     Number of mappings
- * @param local_info        Local symbols info pointer
- * @param rangeTable        Range table pointer
- * @param range_table_count Number of range entries
- * @param target_addr       Target address to look up
- * @param symbol_name       [out] Symbol name (NULL if not found)
- * @param symbol_addr       [out] Symbol address (0 if not found)
- * @param image_index       [out] Image index of containing dylib (-1 if not
- * found)
- * @return                  0 on success, -1 on failure (address not in cache or
- * no symbols)
+ * Resolve every query of one image with a single pass over each of its symbol
+ * tables.
  *
- * Algorithm:
- *   1. Use rangeTable binary search to find containing image (O(log n))
- *      - Returns imageIndex into dyld_cache_image_info array
- *   2. Convert imageIndex to dylibOffset:
- *      a. Access images[imageIndex].address to get dylib's __TEXT vmaddr
- *      b. Use addr_to_file_offset() to convert vmaddr to file offset
- *      - This file offset equals dylibOffset in local_symbols_entry
- *   3. Find matching entry in local_symbols_entry array by dylibOffset (O(e))
- *      - Linear search through entries array comparing dylibOffset
- *   4. Iterate through the dylib's nlist entries (O(m))
- *   5. Find symbol with largest n_value <= target_addr
+ * @param sc    Mapped cache
+ * @param group Queries of one image, sorted by address (count > 0)
+ * @param count Number of queries in group
  *
- * Time Complexity: O(log n + e + m)
- *   where n = rangeTableCount, e = entriesCount, m = symbols per dylib
+ * The dylib's own table is offered before its local symbols, so on equal
+ * addresses the exported name wins, as in find_symbol_for_address().
  */
-static int find_symbol_for_address(
-    const uint8_t *cache, size_t cache_size,
-    const struct dyld_cache_header *header,
-    const struct dyld_cache_mapping_info *mappings, uint32_t mapping_count,
-    const struct dyld_cache_local_symbols_info *local_info,
-    const struct dyld_cache_range_entry *rangeTable, uint32_t range_table_count,
-    uint64_t target_addr, const char **symbol_name, uint64_t *symbol_addr,
-    int32_t *image_index_out, int verbose) {
-    /* Initialize output parameters */
-    *symbol_name = NULL;
-    *symbol_addr = 0;
-    *image_index_out = -1;
-
-    /* Step 1: Binary search rangeTable for containing image */
-    const struct dyld_cache_range_entry *range_entry =
-        binary_search_range_table(rangeTable, range_table_count, target_addr);
-    if (range_entry == NULL)
-        return -1; /* Address not in any dylib */
-
-    uint32_t image_index = range_entry->imageIndex;
-    *image_index_out = (int32_t)image_index;
-
-    /* Step 2: Convert imageIndex to dylibOffset */
+static void resolve_query_group(const struct shared_cache *sc,
+                                struct batch_query *group, size_t count) {
     int64_t dylib_offset = image_index_to_dylib_offset(
-        cache, header, mappings, mapping_count, image_index);
+        sc->data, sc->header, sc->mappings, sc->header->mappingCount,
+        (uint32_t)group[0].image_index);
     if (dylib_offset < 0)
-        return -1;
-
-    int found_symbol = 0;
+        return;
 
-    /* Search source 1: dylib's own symbol table (exported symbols) */
-    if (search_dylib_symbol_table(cache, cache_size, mappings, mapping_count,
-                                  (uint64_t)dylib_offset, target_addr,
-                                  symbol_name, symbol_addr, verbose)) {
-        found_symbol = 1;
+    /* Source 1: dylib's own symbol table (exported symbols) */
+    const struct nlist_64 *nlist;
+    uint32_t nsyms;
+    const char *strtab;
+    uint32_t strsize;
+    if (find_dylib_symtab(sc->data, sc->size, sc->mappings,
+                          sc->header->mappingCount, (uint64_t)dylib_offset,
+                          &nlist, &nsyms, &strtab, &strsize)) {
+        offer_symbols_to_group(group, count, nlist, nsyms, strtab, strsize);
     }
 
-    /* Search source 2: local symbols from dyld_cache_local_symbols_info */
+    /* Source 2: local symbols, with the entry looked up once per image */
+    const struct dyld_cache_local_symbols_info *local_info = sc->local_info;
     if (local_info != NULL) {
-        /* Get entries array */
         const struct dyld_cache_local_symbols_entry *entries =
             (const struct dyld_cache_local_symbols_entry
                  *)((const uint8_t *)local_info + local_info->entriesOffset);
-
-        /* Find matching local symbols entry */
         const struct dyld_cache_local_symbols_entry *sym_entry =
             find_local_symbols_entry(entries, local_info->entriesCount,
                                      (uint64_t)dylib_offset);
 
-        if (sym_entry != NULL) {
-            /* Get nlist and string table pointers */
+        if (sym_entry != NULL &&
+            (uint64_t)sym_entry->nlistStartIndex + sym_entry->nlistCount <=
+                local_info->nlistCount) {
             const struct nlist_64 *nlist_base =
                 (const struct nlist_64 *)((const uint8_t *)local_info +
                                           local_info->nlistOffset);
             const char *string_table =
                 (const char *)((const uint8_t *)local_info +
                                local_info->stringsOffset);
-
-            /* Search local symbol table - may find a closer match */
-            const char *local_name = NULL;
-            uint64_t local_addr = 0;
-
-            if (search_symbol_table(nlist_base, string_table,
-                                    sym_entry->nlistStartIndex,
-                                    sym_entry->nlistCount, target_addr,
-                                    &local_name, &local_addr, verbose)) {
-                /* Use local symbol if it's closer than current best */
-                if (local_addr > *symbol_addr) {
-                    *symbol_name = local_name;
-                    *symbol_addr = local_addr;
-                    found_symbol = 1;
-                }
-            }
+            offer_symbols_to_group(group, count,
+                                   nlist_base + sym_entry->nlistStartIndex,
+                                   sym_entry->nlistCount, string_table,
+                                   local_info->stringsSize);
         }
     }
 
-    return found_symbol ? 0 : -1;
+    /* Carry the closest symbol so far forward through the sorted queries */
+    const char *best_name = NULL;
+    uint64_t best_addr = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (group[i].sym_name != NULL) {
+            best_name = group[i].sym_name;
+            best_addr = group[i].sym_addr;
+        }
+        group[i].sym_name = best_name;
+        group[i].sym_addr = best_addr;
+    }
 }
 
 /**
- * Get the basename of a path (last component after /).
+ * Print one batch result in the single-address output format. An address
+ * outside every image is echoed back, as atos does.
  */
-static const char *get_basename(const char *path) {
-    const char *last_slash = strrchr(path, '/');
-    return last_slash ? last_slash + 1 : path;
+static void print_batch_result(const struct shared_cache *sc,
+                               const struct batch_query *q) {
+    const char *dylib_path =
+        q->image_index >= 0 ? get_image_path(sc, (uint32_t)q->image_index)
+                            : NULL;
+    if (dylib_path == NULL) {
+        printf("0x%llx\n", (unsigned long long)q->addr);
+        return;
+    }
+
+    const char *dylib_basename = get_basename(dylib_path);
+    if (q->sym_name != NULL) {
+        printf("%s (in %s) + 0x%llx\n", strip_leading_underscore(q->sym_name),
+               dylib_basename, (unsigned long long)(q->addr - q->sym_addr));
+    } else {
+        uint64_t dylib_base = sc->images[q->image_index].address;
+        printf("(in %s) + 0x%llx\n", dylib_basename,
+               (unsigned long long)(q->addr - dylib_base));
+    }
 }
 
 /**
- * Strip leading underscore from symbol name (C convention).
- * Returns the original name if it doesn't start with underscore.
+ * Symbolicate every address read from a stream, one output line per input
+ * address, in input order.
+ *
+ * @param sc      Mapped cache
+ * @param idx     Symbol index for the cache, or NULL to scan
+ * @param in      Input stream with one hexadecimal address per line
+ * @param verbose Verbose output flag (summary goes to stderr)
+ * @return        Process exit code
+ *
+ * With an index, each address is a direct symbol_index_lookup(). Without one:
+ *   1. Find each query's image with the rangeTable binary search
+ *   2. Sort queries by (image, address)
+ *   3. Resolve each image's queries with one pass over its symbol tables
+ *   4. Sort back into input order and print
+ *
+ * Time Complexity: O(q log q + q log n + sum over touched images of
+ *                  (e + m log q_i))
+ *   where q = addresses, n = rangeTableCount, e = entriesCount,
+ *   m = symbols per image, q_i = addresses in that image
  */
-static const char *strip_leading_underscore(const char *name) {
-    if (name && name[0] == '_')
-        return name + 1;
-    return name;
+static int symbolicate_batch(const struct shared_cache *sc,
+                             const struct symbol_index *idx, FILE *in,
+                             int verbose) {
+    struct batch_query *queries;
+    size_t count;
+    if (read_batch_addresses(in, &queries, &count) != 0)
+        return 1;
+
+    /* Indexed: binary search each address, already in input order */
+    for (size_t i = 0; idx != NULL && i < count; i++) {
+        struct batch_query *q = &queries[i];
+        symbol_index_lookup(idx, sc, q->addr, &q->sym_name, &q->sym_addr,
+                            &q->image_index);
+    }
+
+    /* Step 1: rangeTable binary search for each query's image */
+    for (size_t i = 0; idx == NULL && i < count; i++) {
+        const struct dyld_cache_range_entry *range_entry =
+            binary_search_range_table(sc->range_table,
+                                      sc->accel_info->rangeTableCount,
+                                      queries[i].addr);
+        if (range_entry != NULL)
+            queries[i].image_index = (int32_t)range_entry->imageIndex;
+    }
+
+    /* Steps 2-3: group by image, then one symbol pass per image */
+    if (idx == NULL && count > 0)
+        qsort(queries, count, sizeof(*queries), compare_query_by_image);
+
+    size_t images_searched = 0;
+    for (size_t i = 0; idx == NULL && i < count;) {
+        size_t j = i + 1;
+        while (j < count && queries[j].image_index == queries[i].image_index)
+            j++;
+        if (queries[i].image_index >= 0) {
+            resolve_query_group(sc, &queries[i], j - i);
+            images_searched++;
+        }
+        i = j;
+    }
+
+    /* Step 4: restore input order */
+    if (idx == NULL && count > 0)
+        qsort(queries, count, sizeof(*queries), compare_query_by_input);
+
+    if (verbose) {
+        fprintf(stderr, "Cache magic: %.16s\n", sc->header->magic);
+        fprintf(stderr, "Image count: %u\n", sc->header->imagesCount);
+        fprintf(stderr, "Addresses: %zu\n", count);
+        if (idx != NULL) {
+            fprintf(stderr, "Index symbols: %llu\n",
+                    (unsigned long long)idx->header->symbol_count);
+        } else {
+            fprintf(stderr, "Images searched: %zu\n", images_searched);
+        }
+    }
+    if (sc->local_info == NULL) {
+        fprintf(stderr, "Note: No local symbols available\n");
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        print_batch_result(sc, &queries[i]);
+    }
+
+    free(queries);
+    return 0;
 }
 
 static void print_usage(const char *prog_name) {
-    fprintf(stderr, "Usage: %s [-v] <dyld_shared_cache_path> <hex_address>\n",
+    fprintf(stderr,
+            "Usage: %s [-v] [-i index] <dyld_shared_cache_path> "
+            "<hex_address>\n",
+            prog_name);
+    fprintf(stderr,
+            "       %s [-v] [-i index] -b <dyld_shared_cache_path> "
+            "[address_file]\n",
+            prog_name);
+    fprintf(stderr,
+            "       %s index [-j threads] [-o index] "
+            "<dyld_shared_cache_path>\n",
+            prog_name);
+    fprintf(stderr,
+            "       %s find [-v] [-p] [-i index] <dyld_shared_cache_path> "
+            "<name>\n",
+            prog_name);
+    fprintf(stderr,
+            "       %s serve [-v] [-j threads] [-m budget_mib] <socket_path> "
+            "<dyld_shared_cache_path>...\n",
             prog_name);
     fprintf(stderr, "\n");
     fprintf(stderr, "Arguments:\n");
     fprintf(stderr,
             "  -v                      Verbose mode (show cache info)\n");
+    fprintf(stderr, "  -b                      Batch mode (one hex address "
+                    "per line)\n");
+    fprintf(stderr, "  -i index                Symbol index to use (default: "
+                    "<cache>.symidx if present)\n");
+    fprintf(stderr, "  -o index                Where `index` writes (default: "
+                    "<cache>.symidx)\n");
+    fprintf(stderr, "  -j threads              Threads `index` builds or "
+                    "`serve` resolves with\n"
+                    "                          (default: one per CPU)\n");
+    fprintf(stderr, "  -p                      `find` matches name prefixes\n");
+    fprintf(stderr, "  -m budget_mib           MiB of caches and indexes "
+                    "`serve` keeps mapped\n"
+                    "                          (default: no limit)\n");
     fprintf(stderr,
             "  dyld_shared_cache_path  Path to the dyld shared cache file\n");
     fprintf(stderr, "  hex_address             Hexadecimal address (with or "
                     "without 0x prefix)\n");
+    fprintf(stderr, "  address_file            File of addresses for -b "
+                    "(default or \"-\": stdin)\n");
+    fprintf(stderr, "  name                    Raw, C, or C++ qualified symbol "
+                    "name for `find`\n");
+    fprintf(stderr,
+            "  socket_path             Unix socket `serve` listens on\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Example:\n");
     fprintf(stderr, "  %s dyld_shared_cache_arm64 0x180028000\n", prog_name);
     fprintf(stderr, "  %s -v dyld_shared_cache_arm64 0x180028000\n", prog_name);
+    fprintf(stderr, "  %s -b dyld_shared_cache_arm64 < addresses.txt\n",
+            prog_name);
+    fprintf(stderr, "  %s index dyld_shared_cache_arm64\n", prog_name);
+    fprintf(stderr, "  %s find dyld_shared_cache_arm64 objc_msgSend\n",
+            prog_name);
+    fprintf(stderr, "  %s find -p dyld_shared_cache_arm64 WebCore::Node::\n",
+            prog_name);
+    fprintf(stderr,
+            "  %s serve -m 8192 /tmp/ipsw.sock dyld_shared_cache_arm64*\n",
+            prog_name);
 }
 
-int main(int argc, const char *argv[]) {
-    int verbose = 0;
-    int arg_offset = 1;
+/**
+ * Default index path for a cache: <cache>.symidx.
+ *
+ * @return Newly allocated path (caller frees), or NULL on allocation failure
+ */
+static char *default_index_path(const char *cache_path) {
+    size_t len = strlen(cache_path);
+    char *path = malloc(len + sizeof(SYMBOL_INDEX_SUFFIX));
+    if (path == NULL)
+        return NULL;
+    memcpy(path, cache_path, len);
+    memcpy(path + len, SYMBOL_INDEX_SUFFIX, sizeof(SYMBOL_INDEX_SUFFIX));
+    return path;
+}
 
-    /* Check for -v flag */
-    if (argc >= 2 && strcmp(argv[1], "-v") == 0) {
-        verbose = 1;
-        arg_offset = 2;
+/**
+ * Open the symbol index for a cache, if there is a usable one.
+ *
+ * @param cache_path Path to the cache file
+ * @param index_path Index given with -i, or NULL for <cache>.symidx
+ * @param sc         Mapped cache
+ * @param idx        [out] Index storage
+ * @return           idx, or NULL to scan symbol tables instead
+ *
+ * A missing default index is silent. Any other index that cannot be used is
+ * reported on stderr, and lookups fall back to scanning.
+ */
+static const struct symbol_index *
+open_index_for_cache(const char *cache_path, const char *index_path,
+                     const struct shared_cache *sc, struct symbol_index *idx) {
+    char *default_path = NULL;
+    if (index_path == NULL) {
+        default_path = default_index_path(cache_path);
+        if (default_path == NULL || access(default_path, F_OK) != 0) {
+            free(default_path);
+            return NULL;
+        }
+        index_path = default_path;
     }
 
-    if (argc - arg_offset != 2) {
-        print_usage(argv[0]);
-        return 1;
+    const struct symbol_index *ret = NULL;
+    if (symbol_index_open(index_path, sc, idx) == 0) {
+        ret = idx;
+    } else if (errno == ESTALE) {
+        fprintf(stderr,
+                "Note: Ignoring symbol index %s: built for a different "
+                "cache or ipsw version\n",
+                index_path);
+    } else {
+        fprintf(stderr, "Note: Ignoring symbol index %s: %s\n", index_path,
+                strerror(errno));
     }
+    free(default_path);
+    return ret;
+}
 
-    const char *cache_path = argv[arg_offset];
-    const char *addr_str = argv[arg_offset + 1];
-
-    /* Parse the hex address */
+/**
+ * Parse a -j value: 1 to 1024 threads.
+ *
+ * @return 0 on success, -1 on failure (error printed to stderr)
+ */
+static int parse_thread_count(const char *arg, unsigned *threads) {
     char *endptr;
-    uint64_t target_addr = strtoull(addr_str, &endptr, 16);
-    if (*endptr != '\0' || endptr == addr_str) {
-        fprintf(stderr, "Error: Invalid hexadecimal address '%s'\n", addr_str);
-        return 1;
-    }
-
-    /* Open the cache file */
-    int fd = open(cache_path, O_RDONLY);
-    if (fd < 0) {
-        perror("Error opening cache file");
-        return 1;
-    }
-
-    /* Get file size */
-    struct stat st;
-    if (fstat(fd, &st) != 0) {
-        perror("Error getting file size");
-        close(fd);
-        return 1;
+    errno = 0;
+    unsigned long value = strtoul(arg, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || endptr == arg || value == 0 ||
+        value > 1024) {
+        fprintf(stderr, "Error: Invalid thread count '%s'\n", arg);
+        return -1;
     }
-    size_t cache_size = (size_t)st.st_size;
+    *threads = (unsigned)value;
+    return 0;
+}
 
-    /* Memory map the file */
-    const uint8_t *cache =
-        mmap(NULL, cache_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (cache == MAP_FAILED) {
-        perror("Error mapping cache file");
-        close(fd);
-        return 1;
+/**
+ * `ipsw index [-j threads] [-o index] <dyld_shared_cache_path>`: build a
+ * symbol index.
+ *
+ * @return Process exit code
+ */
+static int run_index_command(int argc, const char *argv[]) {
+    const char *index_path = NULL;
+    unsigned threads = 0;
+    int arg_offset = 2;
+
+    while (arg_offset + 1 < argc && argv[arg_offset][0] == '-') {
+        if (strcmp(argv[arg_offset], "-o") == 0) {
+            index_path = argv[arg_offset + 1];
+        } else if (strcmp(argv[arg_offset], "-j") == 0) {
+            if (parse_thread_count(argv[arg_offset + 1], &threads) != 0)
+                return 1;
+        } else {
+            break;
+        }
+        arg_offset += 2;
     }
-    close(fd);
-
-    /* Verify file is large enough for header */
-    if (cache_size < sizeof(struct dyld_cache_header)) {
-        fprintf(stderr, "Error: File too small for dyld shared cache header\n");
-        munmap((void *)cache, cache_size);
+    if (argc - arg_offset != 1) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    /* Verify the cache header */
-    const struct dyld_cache_header *header =
-        (const struct dyld_cache_header *)cache;
-
-    /* Check magic - should start with "dyld_v1" */
-    if (strncmp(header->magic, "dyld_v1", 7) != 0) {
-        fprintf(stderr, "Error: Invalid dyld shared cache magic: %.16s\n",
-                header->magic);
-        munmap((void *)cache, cache_size);
-        return 1;
+    const char *cache_path = argv[arg_offset];
+    char *default_path = NULL;
+    if (index_path == NULL) {
+        default_path = default_index_path(cache_path);
+        if (default_path == NULL) {
+            perror("Error allocating index path");
+            return 1;
+        }
+        index_path = default_path;
+    }
+
+    struct shared_cache sc;
+    int ret = 1;
+    if (open_shared_cache(cache_path, &sc) == 0) {
+        struct symbol_index idx;
+        if (symbol_index_build(&sc, index_path, threads) != 0) {
+            /* Error already printed */
+        } else if (symbol_index_open(index_path, &sc, &idx) != 0) {
+            fprintf(stderr, "Error: Cannot reopen symbol index %s: %s\n",
+                    index_path, strerror(errno));
+        } else {
+            printf("Indexed %u images, %llu symbols, %llu names: %s\n",
+                   idx.header->image_count,
+                   (unsigned long long)idx.header->symbol_count,
+                   (unsigned long long)idx.header->name_count, index_path);
+            symbol_index_close(&idx);
+            ret = 0;
+        }
+        close_shared_cache(&sc);
     }
+    free(default_path);
+    return ret;
+}
 
-    /* Validate mappingOffset and imagesOffset bounds with overflow protection.
-     * Note: On 64-bit systems, uint32_t cannot overflow size_t multiplication.
-     * The bounds checks below prevent buffer overruns when accessing the
-     * tables.
-     */
-    size_t mappings_size =
-        (size_t)header->mappingCount * sizeof(struct dyld_cache_mapping_info);
-    if (header->mappingOffset > cache_size ||
-        mappings_size > cache_size - header->mappingOffset) {
-        fprintf(stderr, "Error: Invalid mapping offset or count\n");
-        munmap((void *)cache, cache_size);
-        return 1;
-    }
+/*
+ * State for printing `ipsw find` matches.
+ */
+struct find_output {
+    const struct shared_cache *sc;
+    uint64_t matches;
+};
 
-    size_t images_size =
-        (size_t)header->imagesCount * sizeof(struct dyld_cache_image_info);
-    if (header->imagesOffset > cache_size ||
-        images_size > cache_size - header->imagesOffset) {
-        fprintf(stderr, "Error: Invalid images offset or count\n");
-        munmap((void *)cache, cache_size);
-        return 1;
-    }
+static int print_name_match(const struct symbol_index_match *match,
+                            void *ctx) {
+    struct find_output *out = ctx;
+    const char *path = get_image_path(out->sc, match->image_index);
 
-    /* Get mappings and images */
-    const struct dyld_cache_mapping_info *mappings =
-        (const struct dyld_cache_mapping_info *)(cache + header->mappingOffset);
-    const struct dyld_cache_image_info *images =
-        (const struct dyld_cache_image_info *)(cache + header->imagesOffset);
+    printf("0x%llx %s (in %s)\n", (unsigned long long)match->addr,
+           strip_leading_underscore(match->name),
+           path != NULL ? get_basename(path) : "???");
+    out->matches++;
+    return 0;
+}
 
-    /* Validate each mapping's file range */
-    for (uint32_t i = 0; i < header->mappingCount; i++) {
-        if (mappings[i].fileOffset > cache_size ||
-            mappings[i].size > cache_size - mappings[i].fileOffset) {
-            fprintf(stderr, "Error: Mapping %u has invalid file range\n", i);
-            munmap((void *)cache, cache_size);
+/**
+ * `ipsw find [-v] [-p] [-i index] <dyld_shared_cache_path> <name>`: print
+ * every symbol with a name, or with -p a name prefix, in every image.
+ *
+ * @return Process exit code: 0 if anything matched
+ */
+static int run_find_command(int argc, const char *argv[]) {
+    const char *index_path = NULL;
+    int verbose = 0;
+    int prefix = 0;
+    int arg_offset = 2;
+
+    while (arg_offset < argc && argv[arg_offset][0] == '-' &&
+           argv[arg_offset][1] != '\0') {
+        if (strcmp(argv[arg_offset], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[arg_offset], "-p") == 0) {
+            prefix = 1;
+        } else if (strcmp(argv[arg_offset], "-i") == 0 &&
+                   arg_offset + 1 < argc) {
+            index_path = argv[++arg_offset];
+        } else {
+            print_usage(argv[0]);
             return 1;
         }
+        arg_offset++;
     }
-
-    /* Get accelerator info - required for iOS 9+ / macOS 10.11+ */
-    const struct dyld_cache_accelerator_info *accel_info = get_accelerator_info(
-        cache, cache_size, header, mappings, header->mappingCount);
-    if (accel_info == NULL) {
-        fprintf(stderr, "Error: This cache lacks accelerator info. "
-                        "Only iOS 9+ / macOS 10.11+ caches are supported.\n");
-        munmap((void *)cache, cache_size);
+    if (argc - arg_offset != 2) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    /* Get the rangeTable pointer */
-    int64_t accel_file_offset = addr_to_file_offset(
-        mappings, header->mappingCount, header->accelerateInfoAddr);
-    const struct dyld_cache_range_entry *rangeTable =
-        (const struct dyld_cache_range_entry *)(cache + accel_file_offset +
-                                                accel_info->rangeTableOffset);
+    const char *cache_path = argv[arg_offset];
+    const char *name = argv[arg_offset + 1];
 
-    /* Get local symbols info (may be NULL if not available) */
-    const struct dyld_cache_local_symbols_info *local_info =
-        get_local_symbols_info(cache, cache_size, header);
+    struct shared_cache sc;
+    if (open_shared_cache(cache_path, &sc) != 0)
+        return 1;
 
-    if (verbose) {
-        printf("Cache magic: %.16s\n", header->magic);
-        printf("Image count: %u\n", header->imagesCount);
-        printf("Target address: 0x%llx\n", (unsigned long long)target_addr);
-        printf("\n");
+    int ret = 1;
+    struct symbol_index idx_storage;
+    const struct symbol_index *idx =
+        open_index_for_cache(cache_path, index_path, &sc, &idx_storage);
+    if (idx == NULL) {
+        fprintf(stderr,
+                "Error: Name lookup needs a symbol index; run `%s index "
+                "%s` first\n",
+                argv[0], cache_path);
+    } else {
+        struct find_output out = {&sc, 0};
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int rc = symbol_index_find_name(idx, &sc, name, prefix,
+                                        print_name_match, &out);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (rc != 0) {
+            perror("Error searching symbol index");
+        } else if (out.matches == 0) {
+            fprintf(stderr, "Error: No symbol %s '%s'\n",
+                    prefix ? "starts with" : "named", name);
+        } else {
+            ret = 0;
+        }
+        if (verbose) {
+            double us = (double)(end.tv_sec - start.tv_sec) * 1e6 +
+                        (double)(end.tv_nsec - start.tv_nsec) / 1e3;
+            fprintf(stderr, "Matches: %llu in %.1f us (%llu names indexed)\n",
+                    (unsigned long long)out.matches, us,
+                    (unsigned long long)idx->header->name_count);
+        }
+        symbol_index_close(&idx_storage);
     }
+    close_shared_cache(&sc);
+    return ret;
+}
 
-    /* Perform symbol lookup */
-    const char *symbol_name = NULL;
-    uint64_t symbol_addr = 0;
-    int32_t image_index = -1;
+/* Write end of the pipe that tells `ipsw serve` to stop */
+static int serve_stop_fd = -1;
 
-    int symbol_found = find_symbol_for_address(
-        cache, cache_size, header, mappings, header->mappingCount, local_info,
-        rangeTable, accel_info->rangeTableCount, target_addr, &symbol_name,
-        &symbol_addr, &image_index, verbose);
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    ssize_t rc = write(serve_stop_fd, "", 1);
+    (void)rc;
+}
 
-    /* Check if we at least found the containing dylib */
-    if (image_index < 0) {
-        /* Address not in any dylib */
-        fprintf(stderr, "Error: Address 0x%llx not found in any dylib\n",
-                (unsigned long long)target_addr);
-        munmap((void *)cache, cache_size);
+/**
+ * `ipsw serve [-v] [-j threads] [-m budget_mib] <socket_path>
+ * <dyld_shared_cache_path>...`: answer symbolication requests until SIGINT
+ * or SIGTERM.
+ *
+ * @return Process exit code
+ */
+static int run_serve_command(int argc, const char *argv[]) {
+    struct symbol_server_config config;
+    memset(&config, 0, sizeof(config));
+    int arg_offset = 2;
+
+    while (arg_offset < argc && argv[arg_offset][0] == '-') {
+        if (strcmp(argv[arg_offset], "-v") == 0) {
+            config.verbose = 1;
+            arg_offset++;
+            continue;
+        }
+        if (arg_offset + 1 >= argc)
+            break;
+        if (strcmp(argv[arg_offset], "-j") == 0) {
+            if (parse_thread_count(argv[arg_offset + 1], &config.threads) != 0)
+                return 1;
+        } else if (strcmp(argv[arg_offset], "-m") == 0) {
+            char *endptr;
+            errno = 0;
+            unsigned long long mib =
+                strtoull(argv[arg_offset + 1], &endptr, 10);
+            if (errno != 0 || *endptr != '\0' ||
+                endptr == argv[arg_offset + 1] || mib == 0 ||
+                mib > UINT64_MAX >> 20) {
+                fprintf(stderr, "Error: Invalid memory budget '%s'\n",
+                        argv[arg_offset + 1]);
+                return 1;
+            }
+            config.memory_budget = (uint64_t)mib << 20;
+        } else {
+            break;
+        }
+        arg_offset += 2;
+    }
+    if (argc - arg_offset < 2) {
+        print_usage(argv[0]);
         return 1;
     }
+    config.socket_path = argv[arg_offset];
+    config.cache_paths = &argv[arg_offset + 1];
+    config.cache_count = (size_t)(argc - arg_offset - 1);
 
-    /* Get the dylib path */
-    const struct dyld_cache_image_info *image = &images[image_index];
-    if (image->pathFileOffset >= cache_size) {
-        fprintf(stderr, "Error: Invalid path offset for image %d\n",
-                image_index);
-        munmap((void *)cache, cache_size);
+    int stop_pipe[2];
+    if (pipe(stop_pipe) != 0) {
+        perror("Error creating stop pipe");
         return 1;
     }
+    serve_stop_fd = stop_pipe[1];
+    config.stop_fd = stop_pipe[0];
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    /* A client that disconnects early must not kill the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    struct symbol_server_stats stats;
+    int ret = symbol_server_run(&config, &stats) == 0 ? 0 : 1;
+    if (ret == 0) {
+        fprintf(stderr,
+                "Served %llu requests, %llu addresses on %llu connections "
+                "(%llu errors)\n",
+                (unsigned long long)stats.requests,
+                (unsigned long long)stats.addresses,
+                (unsigned long long)stats.connections,
+                (unsigned long long)stats.errors);
+        fprintf(stderr, "Latency: mean %.1f us, max %.1f us\n",
+                stats.requests ? (double)stats.latency_ns_total /
+                                     (double)stats.requests / 1e3
+                               : 0.0,
+                (double)stats.latency_ns_max / 1e3);
+        fprintf(stderr, "Caches: %llu loads, %llu evictions\n",
+                (unsigned long long)stats.loads,
+                (unsigned long long)stats.evictions);
+    }
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    return ret;
+}
 
-    const char *dylib_path = (const char *)(cache + image->pathFileOffset);
+int main(int argc, const char *argv[]) {
+    int verbose = 0;
+    int batch = 0;
+    const char *index_path = NULL;
+    int arg_offset = 1;
 
-    /* Ensure path string is null-terminated within bounds */
-    size_t max_path_len = cache_size - image->pathFileOffset;
-    size_t path_len = strnlen(dylib_path, max_path_len);
-    if (path_len == max_path_len) {
-        fprintf(stderr, "Error: Path string not null-terminated for image %d\n",
-                image_index);
-        munmap((void *)cache, cache_size);
-        return 1;
+    if (argc >= 2 && strcmp(argv[1], "index") == 0)
+        return run_index_command(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "find") == 0)
+        return run_find_command(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0)
+        return run_serve_command(argc, argv);
+
+    /* Check for -v, -b, and -i flags */
+    while (arg_offset < argc && argv[arg_offset][0] == '-' &&
+           argv[arg_offset][1] != '\0') {
+        if (strcmp(argv[arg_offset], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[arg_offset], "-b") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[arg_offset], "-i") == 0 &&
+                   arg_offset + 1 < argc) {
+            index_path = argv[++arg_offset];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        arg_offset++;
     }
 
-    const char *dylib_basename = get_basename(dylib_path);
+    int positional = argc - arg_offset;
+    if (batch ? (positional < 1 || positional > 2) : positional != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
 
-    if (symbol_found == 0 && symbol_name != NULL) {
-        /* Symbol found - output in atos-compatible format */
-        uint64_t offset = target_addr - symbol_addr;
-        const char *display_name = strip_leading_underscore(symbol_name);
+    const char *cache_path = argv[arg_offset];
 
-        if (verbose) {
-            printf("Image: %s\n", dylib_path);
-            printf("Symbol: %s\n", display_name);
-            printf("Symbol address: 0x%llx\n", (unsigned long long)symbol_addr);
-            printf("Offset: +0x%llx\n", (unsigned long long)offset);
-        } else {
-            /* atos-compatible output: symbol (in dylib) + offset */
-            printf("%s (in %s) + 0x%llx\n", display_name, dylib_basename,
-                   (unsigned long long)offset);
+    if (batch) {
+        const char *input_path = positional == 2 ? argv[arg_offset + 1] : "-";
+        FILE *in = stdin;
+        if (strcmp(input_path, "-") != 0) {
+            in = fopen(input_path, "r");
+            if (in == NULL) {
+                perror("Error opening address file");
+                return 1;
+            }
         }
-    } else {
-        /* No symbol found - fallback to dylib-only output */
-        if (local_info == NULL) {
-            fprintf(stderr, "Note: No local symbols available\n");
+
+        struct shared_cache sc;
+        int ret = 1;
+        if (open_shared_cache(cache_path, &sc) == 0) {
+            struct symbol_index idx_storage;
+            const struct symbol_index *idx = open_index_for_cache(
+                cache_path, index_path, &sc, &idx_storage);
+            ret = symbolicate_batch(&sc, idx, in, verbose);
+            if (idx != NULL)
+                symbol_index_close(&idx_storage);
+            close_shared_cache(&sc);
         }
+        if (in != stdin)
+            fclose(in);
+        return ret;
+    }
 
-        /* Calculate offset from dylib's __TEXT base */
-        uint64_t dylib_base = image->address;
-        uint64_t offset = target_addr - dylib_base;
+    const char *addr_str = argv[arg_offset + 1];
 
-        if (verbose) {
-            printf("Image: %s\n", dylib_path);
-            printf("Symbol: (not found)\n");
-            printf("Dylib base: 0x%llx\n", (unsigned long long)dylib_base);
-            printf("Offset: +0x%llx\n", (unsigned long long)offset);
-        } else {
-            /* Fallback output: (in dylib) + offset */
-            printf("(in %s) + 0x%llx\n", dylib_basename,
-                   (unsigned long long)offset);
-        }
+    /* Parse the hex address */
+    char *endptr;
+    uint64_t target_addr = strtoull(addr_str, &endptr, 16);
+    if (*endptr != '\0' || endptr == addr_str) {
+        fprintf(stderr, "Error: Invalid hexadecimal address '%s'\n", addr_str);
+        return 1;
     }
 
-    munmap((void *)cache, cache_size);
-    return 0;
+    struct shared_cache sc;
+    if (open_shared_cache(cache_path, &sc) != 0)
+        return 1;
+
+    struct symbol_index idx_storage;
+    const struct symbol_index *idx =
+        open_index_for_cache(cache_path, index_path, &sc, &idx_storage);
+    int ret = symbolicate_one(&sc, idx, target_addr, verbose);
+    if (idx != NULL)
+        symbol_index_close(&idx_storage);
+    close_shared_cache(&sc);
+    return ret;
 }
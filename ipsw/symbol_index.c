@@ -0,0 +1,1320 @@
+/*
+ * symbol_index.c - Persistent, mmap-able symbol index for a dyld_shared_cache
+ *
+ * See symbol_index.h for the file layout.
+ */
+
+#include "ipsw/symbol_index.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * One candidate symbol while an image is being indexed.
+ */
+struct index_symbol {
+    uint64_t addr; /* n_value */
+    uint64_t name; /* cache file offset of the name */
+    uint64_t seq;  /* order offered, so ties resolve as in the scan */
+};
+
+/*
+ * One name while an image's by_name[] is being sorted.
+ */
+struct name_sort {
+    const char *str; /* the name in the mapped cache */
+    uint64_t name;   /* cache file offset of the name */
+    uint64_t addr;   /* n_value */
+};
+
+/*
+ * Growable buffers reused from one image to the next, so memory is bounded
+ * by the largest image rather than the whole cache.
+ */
+struct index_scratch {
+    struct index_symbol *symbols;
+    size_t count;
+    size_t cap;
+    struct name_sort *names;
+    size_t name_count;
+    size_t names_cap;
+    uint64_t *out; /* addrs[], names[], then by_name[] of the image */
+    size_t out_cap;
+};
+
+/*
+ * An image's dylibOffset, for finding aliases and local symbols entries.
+ */
+struct image_key {
+    uint64_t dylib_offset;
+    uint32_t image_index;
+};
+
+/*
+ * A local symbols entry's dylibOffset, sorted for binary search.
+ */
+struct local_key {
+    uint64_t dylib_offset;
+    uint32_t entry_index;
+};
+
+static int compare_image_key(const void *a, const void *b) {
+    const struct image_key *ka = a;
+    const struct image_key *kb = b;
+    if (ka->dylib_offset != kb->dylib_offset)
+        return ka->dylib_offset < kb->dylib_offset ? -1 : 1;
+    if (ka->image_index != kb->image_index)
+        return ka->image_index < kb->image_index ? -1 : 1;
+    return 0;
+}
+
+static int compare_local_key(const void *a, const void *b) {
+    const struct local_key *ka = a;
+    const struct local_key *kb = b;
+    if (ka->dylib_offset != kb->dylib_offset)
+        return ka->dylib_offset < kb->dylib_offset ? -1 : 1;
+    if (ka->entry_index != kb->entry_index)
+        return ka->entry_index < kb->entry_index ? -1 : 1;
+    return 0;
+}
+
+static int compare_index_symbol(const void *a, const void *b) {
+    const struct index_symbol *sa = a;
+    const struct index_symbol *sb = b;
+    if (sa->addr != sb->addr)
+        return sa->addr < sb->addr ? -1 : 1;
+    if (sa->seq != sb->seq)
+        return sa->seq < sb->seq ? -1 : 1;
+    return 0;
+}
+
+static int compare_name_sort(const void *a, const void *b) {
+    const struct name_sort *na = a;
+    const struct name_sort *nb = b;
+    int cmp = strcmp(na->str, nb->str);
+    if (cmp != 0)
+        return cmp;
+    if (na->addr != nb->addr)
+        return na->addr < nb->addr ? -1 : 1;
+    if (na->name != nb->name)
+        return na->name < nb->name ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Find the first local symbols entry for a dylibOffset.
+ *
+ * @param keys         Local keys sorted by (dylib_offset, entry_index)
+ * @param count        Number of keys
+ * @param dylib_offset File offset of the dylib's mach_header
+ * @return             Entry index, or -1 if the dylib has no entry
+ *
+ * Picks the lowest entry index among duplicates, as the linear
+ * find_local_symbols_entry() does.
+ */
+static int64_t find_local_key(const struct local_key *keys, uint32_t count,
+                              uint64_t dylib_offset) {
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (keys[mid].dylib_offset < dylib_offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < count && keys[low].dylib_offset == dylib_offset)
+        return keys[low].entry_index;
+    return -1;
+}
+
+/**
+ * Append every defined symbol of one symbol table to the scratch buffer.
+ *
+ * Filters match the scan: stabs are skipped, only N_SECT symbols are kept,
+ * and names outside the string table are skipped.
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int offer_symbols(struct index_scratch *scratch,
+                         const struct shared_cache *sc,
+                         const struct nlist_64 *nlist, uint32_t nsyms,
+                         const char *strtab, uint32_t strsize) {
+    uint64_t strtab_offset = (uint64_t)((const uint8_t *)strtab - sc->data);
+
+    for (uint32_t i = 0; i < nsyms; i++) {
+        const struct nlist_64 *sym = &nlist[i];
+
+        if ((sym->n_type & N_STAB) != 0)
+            continue;
+        if ((sym->n_type & N_TYPE) != N_SECT)
+            continue;
+        if (sym->n_strx >= strsize)
+            continue;
+
+        if (scratch->count == scratch->cap) {
+            size_t new_cap = scratch->cap ? scratch->cap * 2 : 4096;
+            struct index_symbol *grown =
+                realloc(scratch->symbols, new_cap * sizeof(*grown));
+            if (grown == NULL)
+                return -1;
+            scratch->symbols = grown;
+            scratch->cap = new_cap;
+        }
+
+        struct index_symbol *out = &scratch->symbols[scratch->count];
+        out->addr = sym->n_value;
+        out->name = strtab_offset + sym->n_strx;
+        out->seq = scratch->count;
+        scratch->count++;
+    }
+    return 0;
+}
+
+/**
+ * Collect, sort, and deduplicate one image's symbols into scratch->out.
+ *
+ * @param sc           Mapped cache
+ * @param dylib_offset File offset of the image's mach_header
+ * @param local_entry  Index of the image's local symbols entry, or -1
+ * @param scratch      Reused buffers; on success scratch->count is the number
+ *                     of unique addresses and scratch->name_count the number
+ *                     of unique (name, address) pairs, written to scratch->out
+ *                     as addrs[count], names[count], by_name[name_count]
+ * @return             0 on success, -1 on allocation failure
+ *
+ * The dylib's own table is offered before its local symbols, and the sort is
+ * by (address, offer order), so keeping the first entry of each address
+ * gives the symbol the scan would pick.
+ */
+static int collect_image_symbols(const struct shared_cache *sc,
+                                 uint64_t dylib_offset, int64_t local_entry,
+                                 struct index_scratch *scratch) {
+    scratch->count = 0;
+
+    /* Source 1: dylib's own symbol table (exported symbols) */
+    const struct nlist_64 *nlist;
+    uint32_t nsyms;
+    const char *strtab;
+    uint32_t strsize;
+    if (find_dylib_symtab(sc->data, sc->size, sc->mappings,
+                          sc->header->mappingCount, dylib_offset, &nlist,
+                          &nsyms, &strtab, &strsize)) {
+        if (offer_symbols(scratch, sc, nlist, nsyms, strtab, strsize) != 0)
+            return -1;
+    }
+
+    /* Source 2: local symbols */
+    const struct dyld_cache_local_symbols_info *local_info = sc->local_info;
+    if (local_info != NULL && local_entry >= 0) {
+        const struct dyld_cache_local_symbols_entry *entries =
+            (const struct dyld_cache_local_symbols_entry
+                 *)((const uint8_t *)local_info + local_info->entriesOffset);
+        const struct dyld_cache_local_symbols_entry *entry =
+            &entries[local_entry];
+
+        if ((uint64_t)entry->nlistStartIndex + entry->nlistCount <=
+            local_info->nlistCount) {
+            const struct nlist_64 *nlist_base =
+                (const struct nlist_64 *)((const uint8_t *)local_info +
+                                          local_info->nlistOffset);
+            const char *string_table =
+                (const char *)((const uint8_t *)local_info +
+                               local_info->stringsOffset);
+            if (offer_symbols(scratch, sc,
+                              nlist_base + entry->nlistStartIndex,
+                              entry->nlistCount, string_table,
+                              local_info->stringsSize) != 0)
+                return -1;
+        }
+    }
+
+    scratch->name_count = 0;
+    if (scratch->count == 0)
+        return 0;
+
+    /* Every name, sorted by string, before addresses are deduplicated */
+    if (scratch->names_cap < scratch->count) {
+        struct name_sort *grown =
+            realloc(scratch->names, scratch->count * sizeof(*grown));
+        if (grown == NULL)
+            return -1;
+        scratch->names = grown;
+        scratch->names_cap = scratch->count;
+    }
+    for (size_t i = 0; i < scratch->count; i++) {
+        struct name_sort *n = &scratch->names[i];
+        n->name = scratch->symbols[i].name;
+        n->str = (const char *)(sc->data + n->name);
+        n->addr = scratch->symbols[i].addr;
+    }
+    qsort(scratch->names, scratch->count, sizeof(*scratch->names),
+          compare_name_sort);
+    size_t name_count = 0;
+    for (size_t i = 0; i < scratch->count; i++) {
+        if (name_count == 0 ||
+            scratch->names[i].addr != scratch->names[name_count - 1].addr ||
+            strcmp(scratch->names[i].str,
+                   scratch->names[name_count - 1].str) != 0) {
+            scratch->names[name_count++] = scratch->names[i];
+        }
+    }
+    scratch->name_count = name_count;
+
+    qsort(scratch->symbols, scratch->count, sizeof(*scratch->symbols),
+          compare_index_symbol);
+
+    /* Keep the first symbol at each address */
+    size_t unique = 0;
+    for (size_t i = 0; i < scratch->count; i++) {
+        if (unique == 0 ||
+            scratch->symbols[i].addr != scratch->symbols[unique - 1].addr) {
+            scratch->symbols[unique++] = scratch->symbols[i];
+        }
+    }
+    scratch->count = unique;
+
+    size_t out_count = (unique + name_count) * 2;
+    if (scratch->out_cap < out_count) {
+        uint64_t *grown = realloc(scratch->out, out_count * sizeof(*grown));
+        if (grown == NULL)
+            return -1;
+        scratch->out = grown;
+        scratch->out_cap = out_count;
+    }
+    for (size_t i = 0; i < unique; i++) {
+        scratch->out[i] = scratch->symbols[i].addr;
+        scratch->out[unique + i] = scratch->symbols[i].name;
+    }
+    uint64_t *by_name = scratch->out + unique * 2;
+    for (size_t i = 0; i < name_count; i++) {
+        by_name[i * 2] = scratch->names[i].name;
+        by_name[i * 2 + 1] = scratch->names[i].addr;
+    }
+    return 0;
+}
+
+/*
+ * Merge cursor over one image's by_name[], for write_name_refs().
+ */
+struct name_cursor {
+    const struct symbol_index_name *names; /* the image's by_name[] */
+    uint32_t count;                        /* entries in names[] */
+    uint32_t entry;                        /* next entry to merge */
+    uint32_t image;                        /* image index */
+};
+
+static const char *cursor_name(const struct shared_cache *sc,
+                               const struct name_cursor *c) {
+    return (const char *)(sc->data + c->names[c->entry].name);
+}
+
+/* Order of refs[]: by name, then by image index */
+static int cursor_less(const struct shared_cache *sc,
+                       const struct name_cursor *a,
+                       const struct name_cursor *b) {
+    int cmp = strcmp(cursor_name(sc, a), cursor_name(sc, b));
+    if (cmp != 0)
+        return cmp < 0;
+    return a->image < b->image;
+}
+
+static void sift_down(const struct shared_cache *sc, struct name_cursor *heap,
+                      uint32_t count, uint32_t i) {
+    for (;;) {
+        uint32_t smallest = i;
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        if (left < count && cursor_less(sc, &heap[left], &heap[smallest]))
+            smallest = left;
+        if (right < count && cursor_less(sc, &heap[right], &heap[smallest]))
+            smallest = right;
+        if (smallest == i)
+            return;
+        struct name_cursor tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+/**
+ * Append refs[] to f by merging the by_name[] blocks already written.
+ *
+ * @param sc         Mapped cache
+ * @param f          Output file, positioned at end_offset
+ * @param end_offset Bytes written so far; refs[] starts here
+ * @param records    Image records, filled in for every job
+ * @param jobs       Images with their own block, ascending
+ * @param job_count  Number of jobs
+ * @param name_count [out] Entries written to refs[]
+ * @return           0 on success, -1 on failure (error printed to stderr)
+ *
+ * The blocks are read back through a mapping of the file, so memory is one
+ * cursor per image plus a write buffer.
+ */
+static int write_name_refs(const struct shared_cache *sc, FILE *f,
+                           uint64_t end_offset,
+                           const struct symbol_index_image *records,
+                           const uint32_t *jobs, uint32_t job_count,
+                           uint64_t *name_count) {
+    enum { REF_BUFFER = 8192 };
+    *name_count = 0;
+
+    if (fflush(f) != 0) {
+        perror("Error writing symbol index");
+        return -1;
+    }
+    const uint8_t *written = mmap(NULL, end_offset, PROT_READ, MAP_SHARED,
+                                  fileno(f), 0);
+    if (written == MAP_FAILED) {
+        perror("Error mapping symbol index");
+        return -1;
+    }
+
+    struct name_cursor *heap =
+        malloc((job_count ? job_count : 1) * sizeof(*heap));
+    struct symbol_index_name_ref *buffer =
+        malloc(REF_BUFFER * sizeof(*buffer));
+    if (heap == NULL || buffer == NULL) {
+        perror("Error allocating symbol index");
+        free(heap);
+        free(buffer);
+        munmap((void *)written, end_offset);
+        return -1;
+    }
+
+    uint32_t heap_count = 0;
+    for (uint32_t j = 0; j < job_count; j++) {
+        const struct symbol_index_image *record = &records[jobs[j]];
+        if (record->name_count == 0)
+            continue;
+        struct name_cursor *c = &heap[heap_count++];
+        c->names = (const struct symbol_index_name *)(written +
+                                                      record->names_offset);
+        c->count = record->name_count;
+        c->entry = 0;
+        c->image = jobs[j];
+    }
+    for (uint32_t i = heap_count / 2; i-- > 0;)
+        sift_down(sc, heap, heap_count, i);
+
+    int ret = 0;
+    size_t buffered = 0;
+    while (heap_count > 0 && ret == 0) {
+        struct name_cursor *top = &heap[0];
+        buffer[buffered].image = top->image;
+        buffer[buffered].entry = top->entry;
+        buffered++;
+        (*name_count)++;
+
+        if (++top->entry == top->count)
+            heap[0] = heap[--heap_count];
+        sift_down(sc, heap, heap_count, 0);
+
+        if (buffered == REF_BUFFER || heap_count == 0) {
+            if (fwrite(buffer, sizeof(*buffer), buffered, f) != buffered) {
+                perror("Error writing symbol index");
+                ret = -1;
+            }
+            buffered = 0;
+        }
+    }
+
+    free(heap);
+    free(buffer);
+    munmap((void *)written, end_offset);
+    return ret;
+}
+
+enum { SLOT_EMPTY, SLOT_READY, SLOT_FAILED };
+
+/*
+ * One slot of the reorder window: the buffers a worker fills with one image's
+ * block and the writer drains.
+ */
+struct build_slot {
+    struct index_scratch scratch;
+    int state; /* SLOT_EMPTY, SLOT_READY, or SLOT_FAILED */
+};
+
+/*
+ * Shared state of a parallel build. Workers claim images in order, but only
+ * within `window` images of the next one to be written, so at most `window`
+ * blocks are in memory whatever the number of threads.
+ */
+struct build_pool {
+    const struct shared_cache *sc;
+    const uint32_t *jobs;         /* images with their own block, ascending */
+    const int64_t *dylib_offsets; /* indexed by image index */
+    const struct local_key *local_keys;
+    uint32_t local_count;
+    uint32_t job_count;
+    uint32_t window;
+    struct build_slot *slots; /* job j uses slots[j % window] */
+
+    pthread_mutex_t lock;
+    pthread_cond_t claimable; /* next_write advanced, or the build failed */
+    pthread_cond_t ready;     /* a slot left SLOT_EMPTY */
+    uint32_t next_claim;      /* next job a worker takes */
+    uint32_t next_write;      /* next job the writer drains */
+    int aborted;
+};
+
+/**
+ * Worker thread: collect and sort images until none are left.
+ */
+static void *build_worker(void *arg) {
+    struct build_pool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->aborted && pool->next_claim < pool->job_count &&
+               pool->next_claim - pool->next_write >= pool->window)
+            pthread_cond_wait(&pool->claimable, &pool->lock);
+        if (pool->aborted || pool->next_claim >= pool->job_count)
+            break;
+        uint32_t job = pool->next_claim++;
+        struct build_slot *slot = &pool->slots[job % pool->window];
+        pthread_mutex_unlock(&pool->lock);
+
+        uint64_t dylib_offset = (uint64_t)pool->dylib_offsets[pool->jobs[job]];
+        int64_t local_entry =
+            find_local_key(pool->local_keys, pool->local_count, dylib_offset);
+        int rc = collect_image_symbols(pool->sc, dylib_offset, local_entry,
+                                       &slot->scratch);
+
+        pthread_mutex_lock(&pool->lock);
+        slot->state = rc == 0 ? SLOT_READY : SLOT_FAILED;
+        pthread_cond_signal(&pool->ready);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Write the image blocks, then the header and image records, to f.
+ *
+ * @param sc          Mapped cache
+ * @param f           Output file, positioned at 0
+ * @param records     [out] One record per image, zeroed by the caller
+ * @param image_keys  Images with a dylibOffset, sorted by (offset, index)
+ * @param key_count   Number of image keys
+ * @param local_keys  Local symbols entries sorted by (offset, index)
+ * @param local_count Number of local keys
+ * @param threads     Worker threads, at least 1
+ * @return            0 on success, -1 on failure (error printed to stderr)
+ *
+ * Images that share a dylibOffset (aliases) share the block of the lowest
+ * image index. Workers collect and sort images in parallel; this thread
+ * writes their blocks in image order as they complete, so the file is the
+ * same for any number of threads. refs[] is merged from the written blocks
+ * last.
+ */
+static int write_index(const struct shared_cache *sc, FILE *f,
+                       struct symbol_index_image *records,
+                       const struct image_key *image_keys, uint32_t key_count,
+                       const struct local_key *local_keys,
+                       uint32_t local_count, unsigned threads) {
+    uint32_t image_count = sc->header->imagesCount;
+    struct symbol_index_header header;
+    memset(&header, 0, sizeof(header));
+
+    /* Reserve space for the header and records, rewritten at the end */
+    uint64_t images_offset = sizeof(header);
+    uint64_t pos = images_offset + (uint64_t)image_count * sizeof(*records);
+    if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+        (image_count > 0 &&
+         fwrite(records, sizeof(*records), image_count, f) != image_count)) {
+        perror("Error writing symbol index");
+        return -1;
+    }
+
+    /* alias_of[i] is the lowest image index sharing image i's dylibOffset,
+     * or UINT32_MAX if image i has no dylibOffset */
+    size_t alloc_count = image_count ? image_count : 1;
+    uint32_t *alias_of = malloc(alloc_count * sizeof(*alias_of));
+    int64_t *dylib_offsets = malloc(alloc_count * sizeof(*dylib_offsets));
+    uint32_t *jobs = malloc(alloc_count * sizeof(*jobs));
+    if (alias_of == NULL || dylib_offsets == NULL || jobs == NULL) {
+        perror("Error allocating symbol index");
+        free(alias_of);
+        free(dylib_offsets);
+        free(jobs);
+        return -1;
+    }
+    for (uint32_t i = 0; i < image_count; i++)
+        alias_of[i] = UINT32_MAX;
+    uint32_t run_start = 0;
+    for (uint32_t k = 0; k < key_count; k++) {
+        if (image_keys[k].dylib_offset != image_keys[run_start].dylib_offset)
+            run_start = k;
+        alias_of[image_keys[k].image_index] =
+            image_keys[run_start].image_index;
+        dylib_offsets[image_keys[k].image_index] =
+            (int64_t)image_keys[k].dylib_offset;
+    }
+
+    /* One job per image that owns a block, in image order */
+    uint32_t job_count = 0;
+    for (uint32_t i = 0; i < image_count; i++) {
+        if (alias_of[i] == i)
+            jobs[job_count++] = i;
+    }
+
+    if (threads > job_count)
+        threads = job_count ? job_count : 1;
+
+    struct build_pool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.sc = sc;
+    pool.jobs = jobs;
+    pool.dylib_offsets = dylib_offsets;
+    pool.local_keys = local_keys;
+    pool.local_count = local_count;
+    pool.job_count = job_count;
+    pool.window = threads * 2;
+    pool.slots = calloc(pool.window, sizeof(*pool.slots));
+    pthread_t *workers = calloc(threads, sizeof(*workers));
+    if (pool.slots == NULL || workers == NULL) {
+        perror("Error allocating symbol index");
+        free(pool.slots);
+        free(workers);
+        free(jobs);
+        free(dylib_offsets);
+        free(alias_of);
+        return -1;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.claimable, NULL);
+    pthread_cond_init(&pool.ready, NULL);
+
+    int ret = 0;
+    unsigned started = 0;
+    for (; started < threads; started++) {
+        int rc = pthread_create(&workers[started], NULL, build_worker, &pool);
+        if (rc != 0) {
+            fprintf(stderr, "Error: Cannot start index thread: %s\n",
+                    strerror(rc));
+            ret = -1;
+            break;
+        }
+    }
+
+    uint64_t symbol_count = 0;
+    for (uint32_t j = 0; j < job_count && ret == 0; j++) {
+        struct build_slot *slot = &pool.slots[j % pool.window];
+        uint32_t image = jobs[j];
+
+        pthread_mutex_lock(&pool.lock);
+        while (slot->state == SLOT_EMPTY)
+            pthread_cond_wait(&pool.ready, &pool.lock);
+        int state = slot->state;
+        pthread_mutex_unlock(&pool.lock);
+
+        size_t count = slot->scratch.count;
+        size_t name_count = slot->scratch.name_count;
+        size_t out_count = (count + name_count) * 2;
+        if (state == SLOT_FAILED) {
+            fprintf(stderr, "Error: Out of memory indexing image %u\n", image);
+            ret = -1;
+        } else if (count > UINT32_MAX || name_count > UINT32_MAX) {
+            fprintf(stderr, "Error: Image %u has too many symbols\n", image);
+            ret = -1;
+        } else if (count > 0) {
+            if (fwrite(slot->scratch.out, sizeof(*slot->scratch.out),
+                       out_count, f) != out_count) {
+                perror("Error writing symbol index");
+                ret = -1;
+            } else {
+                records[image].symbols_offset = pos;
+                records[image].symbol_count = (uint32_t)count;
+                records[image].names_offset =
+                    pos + count * 2 * sizeof(*slot->scratch.out);
+                records[image].name_count = (uint32_t)name_count;
+                pos += out_count * sizeof(*slot->scratch.out);
+                symbol_count += count;
+            }
+        }
+
+        pthread_mutex_lock(&pool.lock);
+        slot->state = SLOT_EMPTY;
+        pool.next_write++;
+        if (ret != 0)
+            pool.aborted = 1;
+        pthread_cond_broadcast(&pool.claimable);
+        pthread_mutex_unlock(&pool.lock);
+    }
+
+    if (ret != 0) {
+        pthread_mutex_lock(&pool.lock);
+        pool.aborted = 1;
+        pthread_cond_broadcast(&pool.claimable);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    for (unsigned t = 0; t < started; t++)
+        pthread_join(workers[t], NULL);
+
+    pthread_cond_destroy(&pool.ready);
+    pthread_cond_destroy(&pool.claimable);
+    pthread_mutex_destroy(&pool.lock);
+    for (uint32_t s = 0; s < pool.window; s++) {
+        free(pool.slots[s].scratch.symbols);
+        free(pool.slots[s].scratch.names);
+        free(pool.slots[s].scratch.out);
+    }
+    free(pool.slots);
+    free(workers);
+
+    /* Merge every image's by_name[] into refs[] */
+    uint64_t refs_offset = pos;
+    uint64_t name_count = 0;
+    if (ret == 0) {
+        ret = write_name_refs(sc, f, pos, records, jobs, job_count,
+                              &name_count);
+    }
+
+    /* Aliases point at their canonical image's block */
+    for (uint32_t i = 0; i < image_count && ret == 0; i++) {
+        if (alias_of[i] != UINT32_MAX && alias_of[i] != i)
+            records[i] = records[alias_of[i]];
+    }
+
+    free(jobs);
+    free(dylib_offsets);
+    free(alias_of);
+    if (ret != 0)
+        return -1;
+
+    /* Fill in the header and records now that every block is placed */
+    memcpy(header.magic, SYMBOL_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SYMBOL_INDEX_VERSION;
+    header.image_count = image_count;
+    memcpy(header.uuid, sc->header->uuid, sizeof(header.uuid));
+    header.cache_size = sc->size;
+    header.images_offset = images_offset;
+    header.symbol_count = symbol_count;
+    header.refs_offset = refs_offset;
+    header.name_count = name_count;
+
+    if (fseek(f, 0, SEEK_SET) != 0 ||
+        fwrite(&header, sizeof(header), 1, f) != 1 ||
+        (image_count > 0 &&
+         fwrite(records, sizeof(*records), image_count, f) != image_count)) {
+        perror("Error writing symbol index");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Number of worker threads when the caller passes 0: one per online CPU.
+ */
+static unsigned default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (unsigned)cpus : 1;
+}
+
+int symbol_index_build(const struct shared_cache *sc, const char *index_path,
+                       unsigned threads) {
+    uint32_t image_count = sc->header->imagesCount;
+    const struct dyld_cache_local_symbols_info *local_info = sc->local_info;
+    uint32_t local_count = local_info != NULL ? local_info->entriesCount : 0;
+
+    struct symbol_index_image *records =
+        calloc(image_count ? image_count : 1, sizeof(*records));
+    struct image_key *image_keys =
+        malloc((image_count ? image_count : 1) * sizeof(*image_keys));
+    struct local_key *local_keys =
+        malloc((local_count ? local_count : 1) * sizeof(*local_keys));
+    size_t path_len = strlen(index_path);
+    char *tmp_path = malloc(path_len + sizeof(".tmp"));
+    if (records == NULL || image_keys == NULL || local_keys == NULL ||
+        tmp_path == NULL) {
+        perror("Error allocating symbol index");
+        free(records);
+        free(image_keys);
+        free(local_keys);
+        free(tmp_path);
+        return -1;
+    }
+    memcpy(tmp_path, index_path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    /* dylibOffset of every image, sorted to find aliases */
+    uint32_t key_count = 0;
+    for (uint32_t i = 0; i < image_count; i++) {
+        int64_t dylib_offset = image_index_to_dylib_offset(
+            sc->data, sc->header, sc->mappings, sc->header->mappingCount, i);
+        if (dylib_offset < 0)
+            continue;
+        image_keys[key_count].dylib_offset = (uint64_t)dylib_offset;
+        image_keys[key_count].image_index = i;
+        key_count++;
+    }
+    qsort(image_keys, key_count, sizeof(*image_keys), compare_image_key);
+
+    /* dylibOffset -> local symbols entry, replacing the linear search */
+    if (local_count > 0) {
+        const struct dyld_cache_local_symbols_entry *entries =
+            (const struct dyld_cache_local_symbols_entry
+                 *)((const uint8_t *)local_info + local_info->entriesOffset);
+        for (uint32_t i = 0; i < local_count; i++) {
+            local_keys[i].dylib_offset = entries[i].dylibOffset;
+            local_keys[i].entry_index = i;
+        }
+        qsort(local_keys, local_count, sizeof(*local_keys), compare_local_key);
+    }
+
+    int ret = -1;
+    /* Read back for the name merge, so not write-only */
+    FILE *f = fopen(tmp_path, "w+b");
+    if (f == NULL) {
+        perror("Error creating symbol index");
+    } else {
+        ret = write_index(sc, f, records, image_keys, key_count, local_keys,
+                          local_count, threads ? threads : default_threads());
+        if (fclose(f) != 0 && ret == 0) {
+            perror("Error writing symbol index");
+            ret = -1;
+        }
+        if (ret == 0 && rename(tmp_path, index_path) != 0) {
+            perror("Error renaming symbol index");
+            ret = -1;
+        }
+        if (ret != 0)
+            unlink(tmp_path);
+    }
+
+    free(records);
+    free(image_keys);
+    free(local_keys);
+    free(tmp_path);
+    return ret;
+}
+
+/**
+ * Check a mapped index against itself and against the cache.
+ *
+ * @return 0 if usable, otherwise the errno value symbol_index_open() reports
+ */
+static int validate_index(const uint8_t *data, size_t size,
+                          const struct shared_cache *sc) {
+    const struct symbol_index_header *header =
+        (const struct symbol_index_header *)data;
+
+    if (memcmp(header->magic, SYMBOL_INDEX_MAGIC, sizeof(header->magic)) != 0)
+        return EINVAL;
+
+    /* Built by this version, for this cache? */
+    if (header->version != SYMBOL_INDEX_VERSION ||
+        memcmp(header->uuid, sc->header->uuid, sizeof(header->uuid)) != 0 ||
+        header->cache_size != sc->size ||
+        header->image_count != sc->header->imagesCount) {
+        return ESTALE;
+    }
+
+    /* Image records, blocks, and refs[] must lie inside the file */
+    uint64_t records_size =
+        (uint64_t)header->image_count * sizeof(struct symbol_index_image);
+    if (header->images_offset % 8 != 0 || header->images_offset > size ||
+        records_size > size - header->images_offset) {
+        return EINVAL;
+    }
+
+    const struct symbol_index_image *images =
+        (const struct symbol_index_image *)(data + header->images_offset);
+    for (uint32_t i = 0; i < header->image_count; i++) {
+        if (images[i].symbol_count == 0)
+            continue;
+        uint64_t block_size = (uint64_t)images[i].symbol_count * 16;
+        uint64_t names_size = (uint64_t)images[i].name_count *
+                              sizeof(struct symbol_index_name);
+        if (images[i].symbols_offset % 8 != 0 ||
+            images[i].symbols_offset > size ||
+            block_size > size - images[i].symbols_offset ||
+            images[i].names_offset % 8 != 0 ||
+            images[i].names_offset > size ||
+            names_size > size - images[i].names_offset) {
+            return EINVAL;
+        }
+    }
+
+    if (header->refs_offset % 8 != 0 || header->refs_offset > size ||
+        header->name_count > (size - header->refs_offset) /
+                                 sizeof(struct symbol_index_name_ref)) {
+        return EINVAL;
+    }
+    return 0;
+}
+
+int symbol_index_open(const char *index_path, const struct shared_cache *sc,
+                      struct symbol_index *idx) {
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(struct symbol_index_header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    close(fd);
+
+    int err = validate_index(data, size, sc);
+    if (err != 0) {
+        munmap((void *)data, size);
+        errno = err;
+        return -1;
+    }
+
+    const struct symbol_index_header *header =
+        (const struct symbol_index_header *)data;
+    idx->data = data;
+    idx->size = size;
+    idx->header = header;
+    idx->images =
+        (const struct symbol_index_image *)(data + header->images_offset);
+    idx->refs =
+        (const struct symbol_index_name_ref *)(data + header->refs_offset);
+    return 0;
+}
+
+void symbol_index_close(struct symbol_index *idx) {
+    munmap((void *)idx->data, idx->size);
+    idx->data = NULL;
+    idx->size = 0;
+}
+
+int symbol_index_lookup(const struct symbol_index *idx,
+                        const struct shared_cache *sc, uint64_t target_addr,
+                        const char **symbol_name, uint64_t *symbol_addr,
+                        int32_t *image_index_out) {
+    /* Initialize output parameters */
+    *symbol_name = NULL;
+    *symbol_addr = 0;
+    *image_index_out = -1;
+
+    /* Step 1: Binary search rangeTable for containing image */
+    const struct dyld_cache_range_entry *range_entry =
+        binary_search_range_table(sc->range_table,
+                                  sc->accel_info->rangeTableCount, target_addr);
+    if (range_entry == NULL)
+        return -1; /* Address not in any dylib */
+
+    uint32_t image_index = range_entry->imageIndex;
+    *image_index_out = (int32_t)image_index;
+    if (image_index >= idx->header->image_count)
+        return -1;
+
+    /* Step 2: Binary search the image's addresses for the last <= target */
+    const struct symbol_index_image *image = &idx->images[image_index];
+    const uint64_t *addrs =
+        (const uint64_t *)(idx->data + image->symbols_offset);
+    const uint64_t *names = addrs + image->symbol_count;
+
+    uint32_t low = 0;
+    uint32_t high = image->symbol_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (addrs[mid] <= target_addr) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0)
+        return -1; /* No symbol at or below target */
+
+    /* The name must be a null-terminated string inside the cache */
+    uint64_t name_offset = names[low - 1];
+    if (name_offset >= sc->size)
+        return -1;
+    const char *name = (const char *)(sc->data + name_offset);
+    if (strnlen(name, sc->size - name_offset) == sc->size - name_offset)
+        return -1;
+
+    *symbol_name = name;
+    *symbol_addr = addrs[low - 1];
+    return 0;
+}
+
+/*
+ * How a name in a pattern's range must continue after the key.
+ */
+enum name_match {
+    MATCH_EXACT,         /* nothing: the name equals the key */
+    MATCH_PREFIX,        /* anything */
+    MATCH_CXX_UNSCOPED,  /* function parameters, not template arguments */
+    MATCH_CXX_NESTED,    /* 'E', the end of the nested name */
+    MATCH_CXX_STRUCTOR,  /* C1-C5 or D0-D5, then 'E' */
+    MATCH_CXX_MEMBER,    /* another source name, or a C or D structor */
+};
+
+/*
+ * Matches collected over all patterns, as refs[] positions.
+ */
+struct name_results {
+    uint64_t *refs;
+    size_t count;
+    size_t cap;
+};
+
+/**
+ * Resolve refs[i] to its name in the cache.
+ *
+ * @return The name, or "" if the entry points outside the index or the cache
+ */
+static const char *ref_name(const struct symbol_index *idx,
+                            const struct shared_cache *sc, uint64_t i,
+                            uint64_t *addr, uint32_t *image) {
+    const struct symbol_index_name_ref *ref = &idx->refs[i];
+    if (ref->image >= idx->header->image_count)
+        return "";
+    const struct symbol_index_image *record = &idx->images[ref->image];
+    if (ref->entry >= record->name_count)
+        return "";
+    const struct symbol_index_name *entry =
+        (const struct symbol_index_name *)(idx->data + record->names_offset) +
+        ref->entry;
+    if (entry->name >= sc->size)
+        return "";
+    const char *name = (const char *)(sc->data + entry->name);
+    if (strnlen(name, sc->size - entry->name) == sc->size - entry->name)
+        return "";
+
+    if (addr != NULL)
+        *addr = entry->addr;
+    if (image != NULL)
+        *image = ref->image;
+    return name;
+}
+
+/**
+ * First refs[] position in [low, high) whose name is not below the key.
+ *
+ * @param exact Compare whole names (the key must be all of the name) rather
+ *              than only the first key_len bytes
+ * @param after Find the first name above the key instead
+ */
+static uint64_t name_bound(const struct symbol_index *idx,
+                           const struct shared_cache *sc, uint64_t low,
+                           uint64_t high, const char *key, size_t key_len,
+                           int exact, int after) {
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        const char *name = ref_name(idx, sc, mid, NULL, NULL);
+        int cmp = strncmp(name, key, key_len);
+        if (cmp == 0 && exact && name[key_len] != '\0')
+            cmp = 1;
+        if (cmp < 0 || (after && cmp == 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int tail_matches(const char *tail, enum name_match match) {
+    switch (match) {
+    case MATCH_EXACT:
+        return tail[0] == '\0';
+    case MATCH_PREFIX:
+        return 1;
+    case MATCH_CXX_UNSCOPED:
+        return tail[0] != 'I';
+    case MATCH_CXX_NESTED:
+        return tail[0] == 'E';
+    case MATCH_CXX_STRUCTOR:
+        return tail[0] >= '0' && tail[0] <= '5' && tail[1] == 'E';
+    case MATCH_CXX_MEMBER:
+        return (tail[0] >= '1' && tail[0] <= '9') || tail[0] == 'C' ||
+               tail[0] == 'D';
+    }
+    return 0;
+}
+
+/**
+ * Add every name in [low, high) that starts with key and continues as match
+ * requires.
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int collect_pattern(const struct symbol_index *idx,
+                           const struct shared_cache *sc, uint64_t low,
+                           uint64_t high, const char *key, size_t key_len,
+                           enum name_match match,
+                           struct name_results *results) {
+    int exact = match == MATCH_EXACT;
+    uint64_t first = name_bound(idx, sc, low, high, key, key_len, exact, 0);
+    uint64_t last = name_bound(idx, sc, first, high, key, key_len, exact, 1);
+
+    for (uint64_t i = first; i < last; i++) {
+        const char *name = ref_name(idx, sc, i, NULL, NULL);
+        if (!tail_matches(name + key_len, match))
+            continue;
+        if (results->count == results->cap) {
+            size_t new_cap = results->cap ? results->cap * 2 : 64;
+            uint64_t *grown =
+                realloc(results->refs, new_cap * sizeof(*grown));
+            if (grown == NULL)
+                return -1;
+            results->refs = grown;
+            results->cap = new_cap;
+        }
+        results->refs[results->count++] = i;
+    }
+    return 0;
+}
+
+/**
+ * Prefix search for a partial C++ source name after a mangled prefix.
+ *
+ * A source name is mangled as <length><identifier>, so `app` after P can be
+ * P3app..., P11appendChild..., and so on. Rather than trying every length,
+ * this walks the distinct lengths that occur after P, one jump per length.
+ *
+ * @param key     Buffer holding P in its first prefix_len bytes, with room
+ *                for a length and the partial name after it
+ * @param partial The partial identifier
+ * @return        0 on success, -1 on allocation failure
+ */
+static int collect_source_name_prefix(const struct symbol_index *idx,
+                                      const struct shared_cache *sc, char *key,
+                                      size_t prefix_len, const char *partial,
+                                      struct name_results *results) {
+    size_t partial_len = strlen(partial);
+    uint64_t count = idx->header->name_count;
+    uint64_t pos = name_bound(idx, sc, 0, count, key, prefix_len, 0, 0);
+    uint64_t end = name_bound(idx, sc, pos, count, key, prefix_len, 0, 1);
+
+    while (pos < end) {
+        const char *name = ref_name(idx, sc, pos, NULL, NULL);
+        const char *digits = name + prefix_len;
+        size_t digit_count = 0;
+        unsigned long length = 0;
+        while (isdigit((unsigned char)digits[digit_count]) &&
+               digit_count < 9) {
+            length = length * 10 + (unsigned long)(digits[digit_count] - '0');
+            digit_count++;
+        }
+        if (digit_count == 0 || digits[0] == '0') {
+            /* Not a source name here: skip everything with this byte */
+            digit_count = 1;
+        } else if (length >= partial_len) {
+            memcpy(key + prefix_len, digits, digit_count);
+            memcpy(key + prefix_len + digit_count, partial, partial_len);
+            if (collect_pattern(idx, sc, pos, end, key,
+                                prefix_len + digit_count + partial_len,
+                                MATCH_PREFIX, results) != 0)
+                return -1;
+        }
+
+        /* Skip to the next length; longer ones with these leading digits
+         * sort before this one and have been visited */
+        memcpy(key + prefix_len, digits, digit_count);
+        pos = name_bound(idx, sc, pos, end, key, prefix_len + digit_count, 0,
+                         1);
+    }
+    return 0;
+}
+
+/*
+ * Whether s[0, len) is a C++ identifier; '~' may start a destructor name.
+ */
+static int is_identifier(const char *s, size_t len, int allow_tilde) {
+    if (len > 0 && allow_tilde && s[0] == '~') {
+        s++;
+        len--;
+    }
+    if (len == 0 || isdigit((unsigned char)s[0]))
+        return 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)s[i]) && s[i] != '_' && s[i] != '$')
+            return 0;
+    }
+    return 1;
+}
+
+/* Append <length><identifier> to key, returning the new length */
+static size_t append_source_name(char *key, size_t key_len, const char *name,
+                                 size_t name_len) {
+    key_len += (size_t)sprintf(key + key_len, "%zu", name_len);
+    memcpy(key + key_len, name, name_len);
+    return key_len + name_len;
+}
+
+/**
+ * Add the matches of a C++ qualified name (`a::b::c`) by mangling it.
+ *
+ * Covers functions in namespaces and classes, including const member
+ * functions (_ZNK), constructors, destructors, and the `std` abbreviation
+ * (St). Names that mangle with substitutions, templates, or ABI tags in the
+ * qualifier are not found this way.
+ *
+ * @return 0 on success (including when the query is not a qualified name),
+ *         -1 on allocation failure
+ */
+static int collect_cxx_name(const struct symbol_index *idx,
+                            const struct shared_cache *sc, const char *query,
+                            int prefix, char *key,
+                            struct name_results *results) {
+    /* Split on "::"; the last component is handled separately */
+    const char *last = query;
+    size_t component_count = 1;
+    for (const char *p = strstr(query, "::"); p != NULL;
+         p = strstr(p + 2, "::")) {
+        last = p + 2;
+        component_count++;
+    }
+    size_t last_len = strlen(last);
+    if (last_len == 0 && (!prefix || component_count == 1))
+        return 0;
+    if (last_len > 0 && !is_identifier(last, last_len, !prefix))
+        return 0;
+
+    /*
+     * `std::f` is unscoped (_ZSt1f); `std::a::f` and everything deeper is
+     * nested, with or without const (_ZN, _ZNK). A `std::a` prefix can be
+     * either.
+     */
+    static const char *const forms[] = {"__Z", "__ZN", "__ZNK"};
+    int is_std = strncmp(query, "std::", 5) == 0;
+    int unscoped = component_count == 1 || (component_count == 2 && is_std);
+    int any_nested = component_count > 2 ||
+                     (component_count == 2 && (!is_std || prefix));
+
+    for (int form = unscoped ? 0 : 1; form <= (any_nested ? 2 : 0); form++) {
+        size_t key_len = strlen(forms[form]);
+        memcpy(key, forms[form], key_len);
+        int nested = form > 0;
+        const char *prev = NULL;
+        size_t prev_len = 0;
+
+        /* Qualifiers: every component but the last */
+        const char *component = query;
+        for (size_t c = 0; c + 1 < component_count; c++) {
+            const char *sep = strstr(component, "::");
+            size_t len = (size_t)(sep - component);
+            if (!is_identifier(component, len, 0))
+                return 0;
+            if (c == 0 && is_std) {
+                memcpy(key + key_len, "St", 2);
+                key_len += 2;
+            } else {
+                key_len = append_source_name(key, key_len, component, len);
+            }
+            prev = component;
+            prev_len = len;
+            component = sep + 2;
+        }
+
+        int rc;
+        if (prefix && last_len == 0) {
+            rc = collect_pattern(idx, sc, 0, idx->header->name_count, key,
+                                 key_len, MATCH_CXX_MEMBER, results);
+        } else if (prefix) {
+            rc = collect_source_name_prefix(idx, sc, key, key_len, last,
+                                            results);
+        } else if (nested && prev != NULL &&
+                   ((last_len == prev_len &&
+                     memcmp(last, prev, prev_len) == 0) ||
+                    (last[0] == '~' && last_len == prev_len + 1 &&
+                     memcmp(last + 1, prev, prev_len) == 0))) {
+            key[key_len++] = last[0] == '~' ? 'D' : 'C';
+            rc = collect_pattern(idx, sc, 0, idx->header->name_count, key,
+                                 key_len, MATCH_CXX_STRUCTOR, results);
+        } else if (last[0] == '~') {
+            rc = 0; /* a destructor of a different class: no such symbol */
+        } else {
+            key_len = append_source_name(key, key_len, last, last_len);
+            rc = collect_pattern(idx, sc, 0, idx->header->name_count, key,
+                                 key_len,
+                                 nested ? MATCH_CXX_NESTED
+                                        : MATCH_CXX_UNSCOPED,
+                                 results);
+        }
+        if (rc != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int symbol_index_find_name(const struct symbol_index *idx,
+                           const struct shared_cache *sc, const char *query,
+                           int prefix, symbol_index_match_fn fn, void *ctx) {
+    size_t query_len = strlen(query);
+    uint64_t count = idx->header->name_count;
+    enum name_match match = prefix ? MATCH_PREFIX : MATCH_EXACT;
+
+    /* Worst case: every component mangles to a 20-digit length plus name */
+    char *key = malloc(query_len * 11 + 64);
+    if (key == NULL)
+        return -1;
+
+    struct name_results results;
+    memset(&results, 0, sizeof(results));
+
+    /* Raw name, then the name with its leading underscore restored */
+    key[0] = '_';
+    memcpy(key + 1, query, query_len);
+    int rc = collect_pattern(idx, sc, 0, count, query, query_len, match,
+                             &results);
+    if (rc == 0) {
+        rc = collect_pattern(idx, sc, 0, count, key, query_len + 1, match,
+                             &results);
+    }
+    if (rc == 0)
+        rc = collect_cxx_name(idx, sc, query, prefix, key, &results);
+    free(key);
+    if (rc != 0) {
+        free(results.refs);
+        return -1;
+    }
+
+    /* Patterns can overlap (`_a` and `__a` prefixes); report each once */
+    qsort(results.refs, results.count, sizeof(*results.refs), compare_u64);
+    for (size_t i = 0; i < results.count; i++) {
+        if (i > 0 && results.refs[i] == results.refs[i - 1])
+            continue;
+        struct symbol_index_match m;
+        memset(&m, 0, sizeof(m));
+        m.name = ref_name(idx, sc, results.refs[i], &m.addr, &m.image_index);
+        if (fn(&m, ctx) != 0)
+            break;
+    }
+    free(results.refs);
+    return 0;
+}
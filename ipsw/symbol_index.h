@@ -0,0 +1,157 @@
+/*
+ * symbol_index.h - Persistent, mmap-able symbol index for a dyld_shared_cache
+ *
+ * The index is a sidecar file built once per cache by `ipsw index`. Lookups
+ * map it read-only and binary search it in place; nothing is parsed or
+ * copied when it is opened.
+ *
+ * File layout (host byte order, every section 8-byte aligned):
+ *
+ *   struct symbol_index_header
+ *   struct symbol_index_image images[image_count]
+ *   for each image with symbols:
+ *       uint64_t addrs[symbol_count]  - symbol addresses, ascending, unique
+ *       uint64_t names[symbol_count]  - cache file offset of each name
+ *       struct symbol_index_name by_name[name_count] - sorted by name
+ *   struct symbol_index_name_ref refs[name_count] - all images, by name
+ *
+ * Each image's entries merge its own LC_SYMTAB and its local symbols, with
+ * the same filtering and tie-breaking as find_symbol_for_address(). Images
+ * are keyed by their index in dyld_cache_image_info, which is what the
+ * rangeTable returns, so the dylibOffset -> local symbols entry join is done
+ * once when the index is built.
+ *
+ * by_name[] keeps every name, including several at one address, and refs[]
+ * merges every image's by_name[] for name -> address lookups.
+ */
+
+#ifndef IPSW_SYMBOL_INDEX_H_
+#define IPSW_SYMBOL_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ipsw/dyld_cache.h"
+
+#define SYMBOL_INDEX_MAGIC "IPSWSYMX" /* 8 bytes, not null-terminated */
+#define SYMBOL_INDEX_VERSION 2
+#define SYMBOL_INDEX_SUFFIX ".symidx" /* default sidecar: <cache>.symidx */
+
+struct symbol_index_header {
+    char magic[8];          /* SYMBOL_INDEX_MAGIC */
+    uint32_t version;       /* SYMBOL_INDEX_VERSION */
+    uint32_t image_count;   /* imagesCount of the indexed cache */
+    uint8_t uuid[16];       /* uuid of the indexed cache */
+    uint64_t cache_size;    /* size of the indexed cache file */
+    uint64_t images_offset; /* file offset of the image records */
+    uint64_t symbol_count;  /* total entries over all images */
+    uint64_t refs_offset;   /* file offset of refs[] */
+    uint64_t name_count;    /* entries in refs[] */
+};
+
+struct symbol_index_image {
+    uint64_t symbols_offset; /* file offset of addrs[], 0 if no symbols */
+    uint32_t symbol_count;   /* entries in addrs[] and names[] */
+    uint32_t name_count;     /* entries in by_name[] */
+    uint64_t names_offset;   /* file offset of by_name[] */
+};
+
+/* One name of an image, in by_name[] */
+struct symbol_index_name {
+    uint64_t name; /* cache file offset of the name */
+    uint64_t addr; /* symbol address */
+};
+
+/* refs[] entry: by_name[entry] of image `image` */
+struct symbol_index_name_ref {
+    uint32_t image;
+    uint32_t entry;
+};
+
+/* One result of symbol_index_find_name() */
+struct symbol_index_match {
+    const char *name;     /* raw name in the cache */
+    uint64_t addr;        /* symbol address */
+    uint32_t image_index; /* image defining the symbol */
+};
+
+/* Called once per match; a non-zero return stops the search */
+typedef int (*symbol_index_match_fn)(const struct symbol_index_match *match,
+                                     void *ctx);
+
+/*
+ * A mapped and validated index. Filled by symbol_index_open(), released by
+ * symbol_index_close().
+ */
+struct symbol_index {
+    const uint8_t *data; /* mmap'd index file */
+    size_t size;         /* size of index file */
+    const struct symbol_index_header *header;
+    const struct symbol_index_image *images;
+    const struct symbol_index_name_ref *refs;
+};
+
+/**
+ * Build the index for a mapped cache and write it to index_path.
+ *
+ * Images are collected and sorted on `threads` worker threads (0: one per
+ * online CPU) and written in image order, so the file does not depend on the
+ * thread count. At most 2 * threads images are held in memory at once. The
+ * name table is then merged from the images' by_name[] in one more pass.
+ *
+ * The file is written to a temporary path next to index_path and renamed
+ * into place, so readers never see a partial index.
+ *
+ * @return 0 on success, -1 on failure (error printed to stderr)
+ */
+int symbol_index_build(const struct shared_cache *sc, const char *index_path,
+                       unsigned threads);
+
+/**
+ * Map an index and check that it was built for this cache.
+ *
+ * @return 0 on success, -1 with errno set on failure: ENOENT or another
+ *         open(2) error, EINVAL for a malformed index, ESTALE when the index
+ *         was built for a different cache (uuid or size mismatch) or by a
+ *         different SYMBOL_INDEX_VERSION
+ */
+int symbol_index_open(const char *index_path, const struct shared_cache *sc,
+                      struct symbol_index *idx);
+void symbol_index_close(struct symbol_index *idx);
+
+/**
+ * Find the closest symbol at or below target_addr with the index.
+ *
+ * Outputs and return value match find_symbol_for_address().
+ *
+ * Time Complexity: O(log n + log m)
+ *   where n = rangeTableCount, m = symbols in the containing image
+ */
+int symbol_index_lookup(const struct symbol_index *idx,
+                        const struct shared_cache *sc, uint64_t target_addr,
+                        const char **symbol_name, uint64_t *symbol_addr,
+                        int32_t *image_index_out);
+
+/**
+ * Find symbols by name.
+ *
+ * The query matches a raw name (`_objc_msgSend`), the name as ipsw prints it
+ * with one leading underscore stripped (`objc_msgSend`), or a C++ qualified
+ * name (`WebCore::Node::appendChild`), which matches every overload. With
+ * prefix set, the query only has to match the start of the name, so
+ * `WebCore::Node::app` finds `appendChild` as well.
+ *
+ * Matches are reported in name order, then image order, with every image
+ * that defines the name.
+ *
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Time Complexity: O(p log M + k log k)
+ *   where p = patterns the query expands to, M = names in the index,
+ *   k = matches
+ */
+int symbol_index_find_name(const struct symbol_index *idx,
+                           const struct shared_cache *sc, const char *query,
+                           int prefix, symbol_index_match_fn fn, void *ctx);
+
+#endif /* IPSW_SYMBOL_INDEX_H_ */
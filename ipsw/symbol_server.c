@@ -0,0 +1,1221 @@
+/*
+ * symbol_server.c - Long-lived symbolication service over a unix socket
+ *
+ * See symbol_server.h for the protocol.
+ *
+ * Threads:
+ *   - The calling thread runs a poll(2) loop that accepts connections, reads
+ *     requests, and writes responses. It never resolves an address.
+ *   - Worker threads take complete requests from a queue, resolve them
+ *     against a mapped cache and index, and format the whole response.
+ *
+ * Each connection has at most one request with the workers. Its socket is not
+ * read again until the response is written, so responses stay in request
+ * order, the request can be parsed in place, and a client that does not read
+ * its responses only stalls itself.
+ */
+
+#include "ipsw/symbol_server.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ipsw/dyld_cache.h"
+#include "ipsw/symbol_index.h"
+
+#define MAX_REQUEST_BYTES (32u << 20) /* longest text line or binary request */
+#define READ_CHUNK 65536
+#define TEXT_HEADER_ROOM 64 /* bytes kept free for "OK <count> <latency>" */
+
+/*
+ * A cache the server can answer for. Mapped on first use and unmapped when
+ * it is the least recently used one over the memory budget.
+ */
+struct served_cache {
+    const char *path;
+    char *index_path;
+    uint8_t uuid[16];
+    struct shared_cache sc;
+    struct symbol_index idx;
+    int mapped;
+    unsigned users;     /* requests using the mapping */
+    uint64_t last_used; /* registry clock at the last acquire */
+};
+
+/*
+ * All served caches, sorted by UUID. One lock covers mapping, unmapping,
+ * and the use counts; lookups run outside it.
+ */
+struct cache_registry {
+    struct served_cache *caches;
+    size_t count;
+    uint64_t budget;       /* 0: no limit */
+    uint64_t mapped_bytes; /* caches and indexes currently mapped */
+    uint64_t clock;
+    uint64_t loads;
+    uint64_t evictions;
+    int verbose;
+    pthread_mutex_t lock;
+};
+
+/*
+ * One request handed to the workers, and its response.
+ */
+struct job {
+    struct connection *conn;
+    const char *request; /* in conn->in, stable while the job runs */
+    size_t request_len;
+    uint64_t received_ns; /* when the loop queued it */
+
+    char *response; /* allocated by the worker, freed by the loop */
+    size_t response_start;
+    size_t response_len;
+    uint64_t latency_ns;
+    uint32_t addresses;
+    int error;
+    struct job *next;
+};
+
+struct connection {
+    int fd;
+    char *in; /* NUL-terminated after in_len, for strtoull */
+    size_t in_len;
+    size_t in_cap;
+    size_t scanned; /* bytes of in already searched for a newline */
+
+    char *out;
+    size_t out_pos;
+    size_t out_end;
+
+    struct job job;
+    int busy;        /* job is with the workers */
+    int eof;         /* the peer has finished sending */
+    int close_after; /* close once out is written */
+};
+
+/*
+ * A growable response buffer. Once an allocation fails, further appends are
+ * dropped and `failed` is set.
+ */
+struct out_buf {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+};
+
+/*
+ * Worker-owned buffers reused from one request to the next.
+ */
+struct worker_scratch {
+    uint64_t *addrs;
+    size_t addrs_cap;
+    uint64_t *image_paths; /* (stamp << 32) | string offset, per image */
+    size_t image_paths_cap;
+    uint32_t stamp;
+};
+
+struct server {
+    const struct symbol_server_config *config;
+    struct cache_registry registry;
+    int wake_pipe[2]; /* workers -> loop: a job is done */
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    struct job *queue_head; /* waiting for a worker */
+    struct job *queue_tail;
+    struct job *done; /* waiting for the loop */
+    int stopping;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (unsigned)cpus : 1;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void format_uuid(const uint8_t uuid[16], char out[37]) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t pos = 0;
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+            out[pos++] = '-';
+        out[pos++] = hex[uuid[i] >> 4];
+        out[pos++] = hex[uuid[i] & 0xf];
+    }
+    out[pos] = '\0';
+}
+
+/**
+ * Parse 32 hexadecimal digits, with dashes allowed anywhere between them.
+ *
+ * @return 0 on success, -1 if s[0, len) is not a UUID
+ */
+static int parse_uuid(const char *s, size_t len, uint8_t uuid[16]) {
+    int digits = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '-')
+            continue;
+        if (!isxdigit((unsigned char)s[i]) || digits == 32)
+            return -1;
+        int value = isdigit((unsigned char)s[i])
+                        ? s[i] - '0'
+                        : tolower((unsigned char)s[i]) - 'a' + 10;
+        if (digits % 2 == 0) {
+            uuid[digits / 2] = (uint8_t)(value << 4);
+        } else {
+            uuid[digits / 2] |= (uint8_t)value;
+        }
+        digits++;
+    }
+    return digits == 32 ? 0 : -1;
+}
+
+static int out_reserve(struct out_buf *b, size_t extra) {
+    if (b->failed)
+        return -1;
+    if (b->cap - b->len >= extra)
+        return 0;
+    size_t new_cap = b->cap ? b->cap : 4096;
+    while (new_cap - b->len < extra)
+        new_cap *= 2;
+    char *grown = realloc(b->data, new_cap);
+    if (grown == NULL) {
+        b->failed = 1;
+        return -1;
+    }
+    b->data = grown;
+    b->cap = new_cap;
+    return 0;
+}
+
+static void out_append(struct out_buf *b, const void *data, size_t len) {
+    if (out_reserve(b, len) == 0) {
+        memcpy(b->data + b->len, data, len);
+        b->len += len;
+    }
+}
+
+static void out_printf(struct out_buf *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(b->data ? b->data + b->len : NULL,
+                      b->data ? b->cap - b->len : 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        b->failed = 1;
+        return;
+    }
+    if ((size_t)n >= b->cap - b->len) {
+        if (out_reserve(b, (size_t)n + 1) != 0)
+            return;
+        va_start(ap, fmt);
+        vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+    }
+    b->len += (size_t)n;
+}
+
+/*
+ * Cache registry
+ */
+
+static int compare_served_cache(const void *a, const void *b) {
+    return memcmp(((const struct served_cache *)a)->uuid,
+                  ((const struct served_cache *)b)->uuid, 16);
+}
+
+static uint64_t mapped_size(const struct served_cache *c) {
+    return (uint64_t)c->sc.size + c->idx.size;
+}
+
+/**
+ * Map a cache and its index. Called with the registry lock held.
+ *
+ * @return 0 on success, -1 on failure (reason printed to stderr)
+ */
+static int load_cache(struct cache_registry *reg, struct served_cache *c) {
+    if (open_shared_cache(c->path, &c->sc) != 0)
+        return -1;
+    if (memcmp(c->sc.header->uuid, c->uuid, sizeof(c->uuid)) != 0) {
+        fprintf(stderr, "Error: %s was replaced by a different cache\n",
+                c->path);
+        close_shared_cache(&c->sc);
+        return -1;
+    }
+    if (symbol_index_open(c->index_path, &c->sc, &c->idx) != 0) {
+        fprintf(stderr, "Error: Cannot open symbol index %s: %s\n",
+                c->index_path, strerror(errno));
+        close_shared_cache(&c->sc);
+        return -1;
+    }
+    c->mapped = 1;
+    reg->mapped_bytes += mapped_size(c);
+    reg->loads++;
+    return 0;
+}
+
+static void unload_cache(struct cache_registry *reg, struct served_cache *c) {
+    reg->mapped_bytes -= mapped_size(c);
+    symbol_index_close(&c->idx);
+    close_shared_cache(&c->sc);
+    c->mapped = 0;
+}
+
+/**
+ * Unmap least recently used caches that no request is using until the
+ * mapped bytes fit the budget, or nothing more can be unmapped. The most
+ * recently used cache always stays, so one cache larger than the budget is
+ * not remapped for every request. Called with the registry lock held.
+ */
+static void evict_over_budget(struct cache_registry *reg) {
+    while (reg->budget != 0 && reg->mapped_bytes > reg->budget) {
+        struct served_cache *lru = NULL;
+        for (size_t i = 0; i < reg->count; i++) {
+            struct served_cache *c = &reg->caches[i];
+            if (c->mapped && c->users == 0 && c->last_used != reg->clock &&
+                (lru == NULL || c->last_used < lru->last_used))
+                lru = c;
+        }
+        if (lru == NULL)
+            break;
+
+        if (reg->verbose) {
+            char uuid[37];
+            format_uuid(lru->uuid, uuid);
+            fprintf(stderr, "Evicted %s %s\n", uuid, lru->path);
+        }
+        unload_cache(reg, lru);
+        reg->evictions++;
+    }
+}
+
+/**
+ * Find a cache by UUID and map it if needed. The caller releases it with
+ * release_cache().
+ *
+ * @param status [out] Why no cache was returned
+ * @return       The cache, or NULL
+ */
+static struct served_cache *acquire_cache(struct cache_registry *reg,
+                                          const uint8_t uuid[16],
+                                          enum symbol_server_status *status) {
+    struct served_cache key;
+    memcpy(key.uuid, uuid, sizeof(key.uuid));
+
+    pthread_mutex_lock(&reg->lock);
+    struct served_cache *c = bsearch(&key, reg->caches, reg->count,
+                                     sizeof(*reg->caches),
+                                     compare_served_cache);
+    if (c == NULL) {
+        *status = SYMBOL_SERVER_UNKNOWN_CACHE;
+    } else if (!c->mapped && load_cache(reg, c) != 0) {
+        *status = SYMBOL_SERVER_UNAVAILABLE;
+        c = NULL;
+    } else {
+        c->users++;
+        c->last_used = ++reg->clock;
+        evict_over_budget(reg);
+    }
+    pthread_mutex_unlock(&reg->lock);
+    return c;
+}
+
+static void release_cache(struct cache_registry *reg, struct served_cache *c) {
+    pthread_mutex_lock(&reg->lock);
+    c->users--;
+    evict_over_budget(reg);
+    pthread_mutex_unlock(&reg->lock);
+}
+
+/**
+ * Check every cache and its index, then keep the most recently checked ones
+ * mapped within the budget.
+ *
+ * @return 0 on success, -1 on failure (error printed to stderr)
+ */
+static int registry_init(struct cache_registry *reg,
+                         const struct symbol_server_config *config) {
+    memset(reg, 0, sizeof(*reg));
+    reg->budget = config->memory_budget;
+    reg->verbose = config->verbose;
+    pthread_mutex_init(&reg->lock, NULL);
+    reg->caches = calloc(config->cache_count, sizeof(*reg->caches));
+    if (reg->caches == NULL) {
+        perror("Error allocating caches");
+        return -1;
+    }
+
+    for (size_t i = 0; i < config->cache_count; i++) {
+        struct served_cache *c = &reg->caches[i];
+        const char *path = config->cache_paths[i];
+        size_t len = strlen(path);
+        c->path = path;
+        c->index_path = malloc(len + sizeof(SYMBOL_INDEX_SUFFIX));
+        if (c->index_path == NULL) {
+            perror("Error allocating index path");
+            return -1;
+        }
+        memcpy(c->index_path, path, len);
+        memcpy(c->index_path + len, SYMBOL_INDEX_SUFFIX,
+               sizeof(SYMBOL_INDEX_SUFFIX));
+        reg->count++;
+
+        if (open_shared_cache(c->path, &c->sc) != 0)
+            return -1;
+        memcpy(c->uuid, c->sc.header->uuid, sizeof(c->uuid));
+        if (symbol_index_open(c->index_path, &c->sc, &c->idx) != 0) {
+            fprintf(stderr,
+                    "Error: No usable symbol index for %s (%s: %s); run "
+                    "`ipsw index %s` first\n",
+                    c->path, c->index_path,
+                    errno == ESTALE ? "built for a different cache or ipsw "
+                                      "version"
+                                    : strerror(errno),
+                    c->path);
+            close_shared_cache(&c->sc);
+            return -1;
+        }
+        c->mapped = 1;
+        c->last_used = ++reg->clock;
+        reg->mapped_bytes += mapped_size(c);
+        reg->loads++;
+    }
+
+    /* Sorted for bsearch; mapped caches keep their pointers into the file */
+    qsort(reg->caches, reg->count, sizeof(*reg->caches),
+          compare_served_cache);
+    for (size_t i = 1; i < reg->count; i++) {
+        if (memcmp(reg->caches[i - 1].uuid, reg->caches[i].uuid, 16) == 0) {
+            fprintf(stderr, "Error: %s and %s are the same cache\n",
+                    reg->caches[i - 1].path, reg->caches[i].path);
+            return -1;
+        }
+    }
+    evict_over_budget(reg);
+    return 0;
+}
+
+static void registry_destroy(struct cache_registry *reg) {
+    for (size_t i = 0; i < reg->count; i++) {
+        if (reg->caches[i].mapped)
+            unload_cache(reg, &reg->caches[i]);
+        free(reg->caches[i].index_path);
+    }
+    free(reg->caches);
+    pthread_mutex_destroy(&reg->lock);
+}
+
+/*
+ * Request handling (worker threads)
+ */
+
+static void text_error(struct out_buf *out, const char *fmt, ...) {
+    char message[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(message, sizeof(message), fmt, ap);
+    va_end(ap);
+    out->len = 0;
+    out_printf(out, "ERR %s\n", message);
+}
+
+static void binary_error(struct out_buf *out, enum symbol_server_status status,
+                         const char *message) {
+    struct symbol_server_response header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SYMBOL_SERVER_RESPONSE_MAGIC, sizeof(header.magic));
+    header.status = (uint32_t)status;
+    header.strings_size = (uint32_t)strlen(message) + 1;
+    out->len = 0;
+    out_append(out, &header, sizeof(header));
+    out_append(out, message, header.strings_size);
+}
+
+static const char *status_message(enum symbol_server_status status) {
+    switch (status) {
+    case SYMBOL_SERVER_OK:
+        return "OK";
+    case SYMBOL_SERVER_BAD_REQUEST:
+        return "Bad request";
+    case SYMBOL_SERVER_UNKNOWN_CACHE:
+        return "Unknown cache";
+    case SYMBOL_SERVER_UNAVAILABLE:
+        return "Cannot map cache";
+    }
+    return "Error";
+}
+
+static int grow_addrs(struct worker_scratch *scratch, size_t count) {
+    if (count <= scratch->addrs_cap)
+        return 0;
+    uint64_t *grown = realloc(scratch->addrs, count * sizeof(*grown));
+    if (grown == NULL)
+        return -1;
+    scratch->addrs = grown;
+    scratch->addrs_cap = count;
+    return 0;
+}
+
+/**
+ * Parse a text request line into a UUID and scratch->addrs.
+ *
+ * @return Number of addresses, or -1 with an ERR response in out
+ */
+static int64_t parse_text_request(const char *line, size_t len,
+                                  struct worker_scratch *scratch,
+                                  uint8_t uuid[16], struct out_buf *out) {
+    const char *p = line;
+    const char *end = line + len;
+    int64_t count = -1;
+
+    while (p < end) {
+        while (p < end && isspace((unsigned char)*p))
+            p++;
+        if (p == end)
+            break;
+        const char *token = p;
+        while (p < end && !isspace((unsigned char)*p))
+            p++;
+        int token_len = (int)(p - token);
+
+        if (count < 0) {
+            if (parse_uuid(token, (size_t)(p - token), uuid) != 0) {
+                text_error(out, "Invalid UUID '%.*s'", token_len, token);
+                return -1;
+            }
+            count = 0;
+            continue;
+        }
+
+        char *endptr;
+        uint64_t addr = strtoull(token, &endptr, 16);
+        if (!isxdigit((unsigned char)token[0]) || endptr != p) {
+            text_error(out, "Invalid hexadecimal address '%.*s'", token_len,
+                       token);
+            return -1;
+        }
+        if ((uint64_t)count == SYMBOL_SERVER_MAX_ADDRESSES) {
+            text_error(out, "Too many addresses (at most %u)",
+                       SYMBOL_SERVER_MAX_ADDRESSES);
+            return -1;
+        }
+        if ((size_t)count == scratch->addrs_cap &&
+            grow_addrs(scratch, scratch->addrs_cap ? scratch->addrs_cap * 2
+                                                   : 1024) != 0) {
+            text_error(out, "Out of memory");
+            return -1;
+        }
+        scratch->addrs[count++] = addr;
+    }
+    if (count < 0)
+        text_error(out, "Missing UUID");
+    return count;
+}
+
+/* One result line, in the `ipsw -b` format */
+static void format_text_result(const struct shared_cache *sc, uint64_t addr,
+                               int32_t image_index, const char *sym_name,
+                               uint64_t sym_addr, struct out_buf *out) {
+    const char *dylib_path =
+        image_index >= 0 ? get_image_path(sc, (uint32_t)image_index) : NULL;
+    if (dylib_path == NULL) {
+        out_printf(out, "0x%llx\n", (unsigned long long)addr);
+    } else if (sym_name != NULL) {
+        out_printf(out, "%s (in %s) + 0x%llx\n",
+                   strip_leading_underscore(sym_name), get_basename(dylib_path),
+                   (unsigned long long)(addr - sym_addr));
+    } else {
+        uint64_t dylib_base = sc->images[image_index].address;
+        out_printf(out, "(in %s) + 0x%llx\n", get_basename(dylib_path),
+                   (unsigned long long)(addr - dylib_base));
+    }
+}
+
+/**
+ * Append a string to the string section of a binary response.
+ *
+ * @return Its offset in the section, or SYMBOL_SERVER_NO_STRING
+ */
+static uint32_t append_string(struct out_buf *out, size_t strings_start,
+                              const char *s) {
+    size_t offset = out->len - strings_start;
+    size_t len = strlen(s) + 1;
+    if (offset + len >= SYMBOL_SERVER_NO_STRING) {
+        out->failed = 1;
+        return SYMBOL_SERVER_NO_STRING;
+    }
+    out_append(out, s, len);
+    return (uint32_t)offset;
+}
+
+/**
+ * Resolve a binary request. Results are written in place after the header;
+ * image paths are added to the string section once per response.
+ */
+static void resolve_binary(const struct served_cache *c, const char *payload,
+                           uint32_t count, struct worker_scratch *scratch,
+                           struct out_buf *out) {
+    size_t results_start = sizeof(struct symbol_server_response);
+    size_t strings_start =
+        results_start + (size_t)count * sizeof(struct symbol_server_result);
+    if (out_reserve(out, strings_start) != 0)
+        return;
+    out->len = strings_start;
+
+    uint32_t image_count = c->sc.header->imagesCount;
+    if (image_count > scratch->image_paths_cap) {
+        free(scratch->image_paths);
+        scratch->image_paths = calloc(image_count, sizeof(uint64_t));
+        scratch->image_paths_cap = scratch->image_paths ? image_count : 0;
+        if (scratch->image_paths == NULL) {
+            out->failed = 1;
+            return;
+        }
+    }
+    if (++scratch->stamp == 0) {
+        memset(scratch->image_paths, 0,
+               scratch->image_paths_cap * sizeof(uint64_t));
+        scratch->stamp = 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t addr;
+        memcpy(&addr, payload + (size_t)i * sizeof(addr), sizeof(addr));
+        const char *sym_name;
+        struct symbol_server_result result;
+        memset(&result, 0, sizeof(result));
+        symbol_index_lookup(&c->idx, &c->sc, addr, &sym_name,
+                            &result.symbol_addr, &result.image_index);
+
+        result.image_path = SYMBOL_SERVER_NO_STRING;
+        const char *path =
+            result.image_index >= 0
+                ? get_image_path(&c->sc, (uint32_t)result.image_index)
+                : NULL;
+        if (path != NULL) {
+            uint64_t *cached = &scratch->image_paths[result.image_index];
+            if (*cached >> 32 != scratch->stamp) {
+                *cached = (uint64_t)scratch->stamp << 32 |
+                          append_string(out, strings_start, path);
+            }
+            result.image_path = (uint32_t)*cached;
+        } else {
+            result.image_index = -1;
+        }
+        result.symbol_name =
+            sym_name != NULL ? append_string(out, strings_start, sym_name)
+                             : SYMBOL_SERVER_NO_STRING;
+        if (out->failed)
+            return;
+        memcpy(out->data + results_start + (size_t)i * sizeof(result),
+               &result, sizeof(result));
+    }
+
+    struct symbol_server_response header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SYMBOL_SERVER_RESPONSE_MAGIC, sizeof(header.magic));
+    header.status = SYMBOL_SERVER_OK;
+    header.count = count;
+    header.strings_size = (uint32_t)(out->len - strings_start);
+    memcpy(out->data, &header, sizeof(header));
+}
+
+/**
+ * Resolve one request and format its response into job->response.
+ */
+static void handle_job(struct server *server, struct job *job,
+                       struct worker_scratch *scratch) {
+    struct out_buf out;
+    memset(&out, 0, sizeof(out));
+    int binary = job->request[0] == SYMBOL_SERVER_REQUEST_MAGIC[0];
+    enum symbol_server_status status = SYMBOL_SERVER_OK;
+    struct served_cache *c = NULL;
+    int64_t count;
+
+    if (binary) {
+        /* Framing and magic were checked by the loop */
+        struct symbol_server_request header;
+        memcpy(&header, job->request, sizeof(header));
+        count = header.count;
+        c = acquire_cache(&server->registry, header.uuid, &status);
+        if (c != NULL) {
+            resolve_binary(c, job->request + sizeof(header), header.count,
+                           scratch, &out);
+        } else {
+            binary_error(&out, status, status_message(status));
+        }
+    } else {
+        uint8_t uuid[16];
+        /* Room to put the status line in front of the results */
+        if (out_reserve(&out, TEXT_HEADER_ROOM) == 0)
+            out.len = TEXT_HEADER_ROOM;
+        count = parse_text_request(job->request, job->request_len, scratch,
+                                   uuid, &out);
+        if (count >= 0)
+            c = acquire_cache(&server->registry, uuid, &status);
+        if (count >= 0 && c == NULL) {
+            char text[37];
+            format_uuid(uuid, text);
+            text_error(&out, "%s %s", status_message(status), text);
+        }
+        for (int64_t i = 0; c != NULL && i < count; i++) {
+            const char *sym_name;
+            uint64_t sym_addr;
+            int32_t image_index;
+            symbol_index_lookup(&c->idx, &c->sc, scratch->addrs[i], &sym_name,
+                                &sym_addr, &image_index);
+            format_text_result(&c->sc, scratch->addrs[i], image_index,
+                               sym_name, sym_addr, &out);
+        }
+    }
+    if (c != NULL)
+        release_cache(&server->registry, c);
+
+    job->error = c == NULL || out.failed;
+    job->addresses = job->error ? 0 : (uint32_t)count;
+    if (out.failed) {
+        /* Whatever was formatted is incomplete; answer with a short error */
+        free(out.data);
+        memset(&out, 0, sizeof(out));
+        if (binary) {
+            binary_error(&out, SYMBOL_SERVER_BAD_REQUEST, "Out of memory");
+        } else {
+            text_error(&out, "Out of memory");
+        }
+    }
+    job->latency_ns = now_ns() - job->received_ns;
+
+    job->response_start = 0;
+    if (binary && !job->error) {
+        memcpy(out.data + offsetof(struct symbol_server_response, latency_ns),
+               &job->latency_ns, sizeof(job->latency_ns));
+    } else if (!binary && !job->error) {
+        char header[TEXT_HEADER_ROOM];
+        int n = snprintf(header, sizeof(header), "OK %u %llu\n",
+                         job->addresses,
+                         (unsigned long long)(job->latency_ns / 1000));
+        job->response_start = TEXT_HEADER_ROOM - (size_t)n;
+        memcpy(out.data + job->response_start, header, (size_t)n);
+    }
+    job->response = out.data;
+    job->response_len = out.len - job->response_start;
+}
+
+/**
+ * Worker thread: handle queued jobs until the server stops.
+ */
+static void *serve_worker(void *arg) {
+    struct server *server = arg;
+    struct worker_scratch scratch;
+    memset(&scratch, 0, sizeof(scratch));
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        while (!server->stopping && server->queue_head == NULL)
+            pthread_cond_wait(&server->work, &server->lock);
+        if (server->stopping)
+            break;
+        struct job *job = server->queue_head;
+        server->queue_head = job->next;
+        if (server->queue_head == NULL)
+            server->queue_tail = NULL;
+        pthread_mutex_unlock(&server->lock);
+
+        handle_job(server, job, &scratch);
+
+        pthread_mutex_lock(&server->lock);
+        job->next = server->done;
+        server->done = job;
+        /* A full pipe already has a wakeup pending */
+        ssize_t rc = write(server->wake_pipe[1], "", 1);
+        (void)rc;
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    free(scratch.addrs);
+    free(scratch.image_paths);
+    return NULL;
+}
+
+/*
+ * Event loop (calling thread)
+ */
+
+static void close_connection(struct connection *conn) {
+    close(conn->fd);
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+}
+
+/**
+ * Read what the socket has. Sets conn->eof at end of stream or on an error.
+ */
+static void read_connection(struct connection *conn) {
+    if (conn->in_cap - conn->in_len < READ_CHUNK + 1) {
+        size_t new_cap = conn->in_cap ? conn->in_cap * 2 : READ_CHUNK * 2;
+        char *grown = realloc(conn->in, new_cap);
+        if (grown == NULL) {
+            conn->eof = 1;
+            conn->in_len = 0;
+            return;
+        }
+        conn->in = grown;
+        conn->in_cap = new_cap;
+    }
+
+    ssize_t n = read(conn->fd, conn->in + conn->in_len,
+                     conn->in_cap - conn->in_len - 1);
+    if (n > 0) {
+        conn->in_len += (size_t)n;
+    } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        conn->eof = 1;
+    }
+    conn->in[conn->in_len] = '\0';
+}
+
+/**
+ * Write what the socket accepts.
+ *
+ * @return 0, or -1 if the connection failed
+ */
+static int write_connection(struct connection *conn) {
+    while (conn->out_pos < conn->out_end) {
+        ssize_t n = write(conn->fd, conn->out + conn->out_pos,
+                          conn->out_end - conn->out_pos);
+        if (n < 0)
+            return errno == EAGAIN || errno == EINTR ? 0 : -1;
+        conn->out_pos += (size_t)n;
+    }
+    free(conn->out);
+    conn->out = NULL;
+    conn->out_pos = conn->out_end = 0;
+    return 0;
+}
+
+/* Drop the first len bytes of the input */
+static void consume_input(struct connection *conn, size_t len) {
+    memmove(conn->in, conn->in + len, conn->in_len - len);
+    conn->in_len -= len;
+    conn->in[conn->in_len] = '\0';
+    conn->scanned = 0;
+}
+
+/* Answer a request the loop rejected itself, then close the connection */
+static void reject_request(struct connection *conn, int binary,
+                           const char *message) {
+    struct out_buf out;
+    memset(&out, 0, sizeof(out));
+    if (binary) {
+        binary_error(&out, SYMBOL_SERVER_BAD_REQUEST, message);
+    } else {
+        text_error(&out, "%s", message);
+    }
+    conn->out = out.data;
+    conn->out_end = out.failed ? 0 : out.len;
+    conn->close_after = 1;
+}
+
+/**
+ * If the input holds a complete request, queue it for the workers.
+ *
+ * @return 1 if a request was queued, 0 otherwise
+ */
+static int dispatch_request(struct server *server, struct connection *conn) {
+    for (;;) {
+        if (conn->in_len == 0)
+            return 0;
+
+        size_t len;
+        if (conn->in[0] == SYMBOL_SERVER_REQUEST_MAGIC[0]) {
+            struct symbol_server_request header;
+            if (conn->in_len < sizeof(header)) {
+                if (conn->eof)
+                    reject_request(conn, 1, "Truncated request");
+                return 0;
+            }
+            memcpy(&header, conn->in, sizeof(header));
+            if (memcmp(header.magic, SYMBOL_SERVER_REQUEST_MAGIC,
+                       sizeof(header.magic)) != 0) {
+                reject_request(conn, 1, "Invalid request magic");
+                return 0;
+            }
+            if (header.count > SYMBOL_SERVER_MAX_ADDRESSES) {
+                reject_request(conn, 1, "Too many addresses");
+                return 0;
+            }
+            len = sizeof(header) + (size_t)header.count * sizeof(uint64_t);
+            if (conn->in_len < len) {
+                if (conn->eof)
+                    reject_request(conn, 1, "Truncated request");
+                return 0;
+            }
+        } else {
+            const char *newline = memchr(conn->in + conn->scanned, '\n',
+                                         conn->in_len - conn->scanned);
+            if (newline != NULL) {
+                len = (size_t)(newline - conn->in) + 1;
+            } else if (conn->in_len > MAX_REQUEST_BYTES) {
+                reject_request(conn, 0, "Request too long");
+                return 0;
+            } else if (conn->eof) {
+                len = conn->in_len; /* last line without a newline */
+            } else {
+                conn->scanned = conn->in_len;
+                return 0;
+            }
+
+            /* Blank lines are not requests */
+            size_t i = 0;
+            while (i < len && isspace((unsigned char)conn->in[i]))
+                i++;
+            if (i == len) {
+                consume_input(conn, len);
+                continue;
+            }
+        }
+
+        struct job *job = &conn->job;
+        memset(job, 0, sizeof(*job));
+        job->conn = conn;
+        job->request = conn->in;
+        job->request_len = len;
+        job->received_ns = now_ns();
+        conn->busy = 1;
+
+        pthread_mutex_lock(&server->lock);
+        if (server->queue_tail != NULL) {
+            server->queue_tail->next = job;
+        } else {
+            server->queue_head = job;
+        }
+        server->queue_tail = job;
+        pthread_cond_signal(&server->work);
+        pthread_mutex_unlock(&server->lock);
+        return 1;
+    }
+}
+
+/* Take a finished job's response and account for it */
+static void finish_job(struct server *server, struct job *job,
+                       struct symbol_server_stats *stats) {
+    struct connection *conn = job->conn;
+    conn->busy = 0;
+    consume_input(conn, job->request_len);
+    conn->out = job->response;
+    conn->out_pos = job->response_start;
+    conn->out_end = job->response_start + job->response_len;
+    if (conn->out == NULL)
+        conn->close_after = 1; /* not even an error fit in memory */
+
+    stats->requests++;
+    stats->addresses += job->addresses;
+    stats->errors += (uint64_t)job->error;
+    stats->latency_ns_total += job->latency_ns;
+    if (job->latency_ns > stats->latency_ns_max)
+        stats->latency_ns_max = job->latency_ns;
+    if (server->config->verbose) {
+        fprintf(stderr, "Request on fd %d: %u addresses, %.1f us%s\n",
+                conn->fd, job->addresses, (double)job->latency_ns / 1e3,
+                job->error ? " (error)" : "");
+    }
+}
+
+/**
+ * Create the listening socket. A socket file that nothing listens on is left
+ * over from a server that exited uncleanly, and is replaced.
+ *
+ * @return The socket, or -1 on failure (error printed to stderr)
+ */
+static int open_listen_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: %s\n", path);
+        return -1;
+    }
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Error creating socket");
+        return -1;
+    }
+
+    int rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc != 0 && errno == EADDRINUSE) {
+        struct stat st;
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live = probe >= 0 &&
+                   connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (live) {
+            fprintf(stderr, "Error: A server is already listening on %s\n",
+                    path);
+            close(fd);
+            return -1;
+        }
+        if (lstat(path, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: %s exists and is not a socket\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (rc != 0) {
+        perror("Error binding socket");
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, SOMAXCONN) != 0 || set_nonblocking(fd) != 0) {
+        perror("Error listening on socket");
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Stop and join the workers, then drop responses nobody will write.
+ */
+static void stop_workers(struct server *server, pthread_t *workers,
+                         unsigned count) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = 1;
+    pthread_cond_broadcast(&server->work);
+    pthread_mutex_unlock(&server->lock);
+    for (unsigned i = 0; i < count; i++)
+        pthread_join(workers[i], NULL);
+
+    for (struct job *job = server->done; job != NULL; job = job->next)
+        free(job->response);
+    server->done = NULL;
+}
+
+/**
+ * Poll loop: runs until stop_fd is readable or poll fails, then stops the
+ * workers and closes every connection.
+ *
+ * @return 0 after a requested stop, -1 on failure
+ */
+static int run_loop(struct server *server, int listen_fd, pthread_t *workers,
+                    unsigned worker_count, struct symbol_server_stats *stats) {
+    enum { LISTEN_SLOT, WAKE_SLOT, STOP_SLOT, FIRST_CONN_SLOT };
+    struct connection **conns = NULL;
+    struct pollfd *fds = NULL;
+    size_t conn_count = 0;
+    size_t conn_cap = 0; /* conns[] entries; fds[] has FIRST_CONN_SLOT more */
+    int ret = 0;
+
+    for (;;) {
+        /* Idle connections: start the next buffered request, or close */
+        size_t kept = 0;
+        for (size_t i = 0; i < conn_count; i++) {
+            struct connection *conn = conns[i];
+            if (!conn->busy && conn->out == NULL && !conn->close_after)
+                dispatch_request(server, conn);
+            if (!conn->busy && conn->out == NULL &&
+                (conn->eof || conn->close_after)) {
+                close_connection(conn);
+                continue;
+            }
+            conns[kept++] = conn;
+        }
+        conn_count = kept;
+
+        /* Always room to accept at least one more connection */
+        if (conn_count == conn_cap) {
+            size_t new_cap = conn_cap ? conn_cap * 2 : 64;
+            struct pollfd *grown_fds =
+                realloc(fds, (new_cap + FIRST_CONN_SLOT) * sizeof(*fds));
+            if (grown_fds != NULL)
+                fds = grown_fds;
+            struct connection **grown =
+                realloc(conns, new_cap * sizeof(*conns));
+            if (grown != NULL)
+                conns = grown;
+            if (grown_fds == NULL || grown == NULL) {
+                perror("Error allocating connections");
+                ret = -1;
+                break;
+            }
+            conn_cap = new_cap;
+        }
+
+        fds[LISTEN_SLOT].fd = listen_fd;
+        fds[WAKE_SLOT].fd = server->wake_pipe[0];
+        fds[STOP_SLOT].fd = server->config->stop_fd;
+        for (size_t i = 0; i < FIRST_CONN_SLOT; i++) {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        for (size_t i = 0; i < conn_count; i++) {
+            struct connection *conn = conns[i];
+            struct pollfd *pfd = &fds[FIRST_CONN_SLOT + i];
+            /* Busy connections are not polled, or a hangup would spin */
+            pfd->fd = conn->busy ? -1 : conn->fd;
+            pfd->events = conn->out != NULL ? POLLOUT : POLLIN;
+            pfd->revents = 0;
+        }
+
+        if (poll(fds, FIRST_CONN_SLOT + conn_count, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("Error polling sockets");
+            ret = -1;
+            break;
+        }
+        if (fds[STOP_SLOT].revents != 0)
+            break;
+
+        if (fds[WAKE_SLOT].revents != 0) {
+            char drain[256];
+            while (read(server->wake_pipe[0], drain, sizeof(drain)) > 0) {
+            }
+            pthread_mutex_lock(&server->lock);
+            struct job *done = server->done;
+            server->done = NULL;
+            pthread_mutex_unlock(&server->lock);
+            while (done != NULL) {
+                struct job *next = done->next;
+                finish_job(server, done, stats);
+                done = next;
+            }
+        }
+
+        for (size_t i = 0; i < conn_count; i++) {
+            struct connection *conn = conns[i];
+            short revents = fds[FIRST_CONN_SLOT + i].revents;
+            if (revents == 0 || conn->busy) {
+                continue;
+            } else if (conn->out != NULL) {
+                if (write_connection(conn) != 0) {
+                    free(conn->out);
+                    conn->out = NULL;
+                    conn->close_after = 1;
+                }
+            } else {
+                read_connection(conn);
+            }
+        }
+
+        /* Accept after the connection pass, into the spare slots */
+        while (fds[LISTEN_SLOT].revents != 0 && conn_count < conn_cap) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd < 0)
+                break;
+            struct connection *conn = calloc(1, sizeof(*conn));
+            if (conn == NULL || set_nonblocking(fd) != 0) {
+                free(conn);
+                close(fd);
+                continue;
+            }
+            conn->fd = fd;
+            conns[conn_count++] = conn;
+            stats->connections++;
+        }
+    }
+
+    /* Workers may still reference connections */
+    stop_workers(server, workers, worker_count);
+    for (size_t i = 0; i < conn_count; i++)
+        close_connection(conns[i]);
+    free(conns);
+    free(fds);
+    return ret;
+}
+
+int symbol_server_run(const struct symbol_server_config *config,
+                      struct symbol_server_stats *stats) {
+    struct server server;
+    memset(&server, 0, sizeof(server));
+    memset(stats, 0, sizeof(*stats));
+    server.config = config;
+    server.wake_pipe[0] = server.wake_pipe[1] = -1;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work, NULL);
+
+    unsigned threads = config->threads ? config->threads : default_threads();
+    pthread_t *workers = calloc(threads, sizeof(*workers));
+    int listen_fd = -1;
+    unsigned started = 0;
+    int ret = -1;
+
+    if (workers == NULL) {
+        perror("Error allocating worker threads");
+    } else if (registry_init(&server.registry, config) != 0) {
+        /* Error already printed */
+    } else if (pipe(server.wake_pipe) != 0 ||
+               set_nonblocking(server.wake_pipe[0]) != 0 ||
+               set_nonblocking(server.wake_pipe[1]) != 0) {
+        perror("Error creating wakeup pipe");
+    } else if ((listen_fd = open_listen_socket(config->socket_path)) >= 0) {
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started], NULL, serve_worker,
+                               &server) != 0) {
+                fprintf(stderr, "Error: Cannot start worker thread\n");
+                break;
+            }
+        }
+        if (started == threads) {
+            fprintf(stderr, "Serving %zu cache%s on %s with %u thread%s\n",
+                    server.registry.count,
+                    server.registry.count == 1 ? "" : "s",
+                    config->socket_path, threads, threads == 1 ? "" : "s");
+            for (size_t i = 0; config->verbose && i < server.registry.count;
+                 i++) {
+                char uuid[37];
+                format_uuid(server.registry.caches[i].uuid, uuid);
+                fprintf(stderr, "  %s %s%s\n", uuid,
+                        server.registry.caches[i].path,
+                        server.registry.caches[i].mapped ? "" : " (unmapped)");
+            }
+            ret = run_loop(&server, listen_fd, workers, threads, stats);
+        } else {
+            stop_workers(&server, workers, started);
+        }
+        close(listen_fd);
+        unlink(config->socket_path);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (server.wake_pipe[i] >= 0)
+            close(server.wake_pipe[i]);
+    }
+    stats->loads = server.registry.loads;
+    stats->evictions = server.registry.evictions;
+    registry_destroy(&server.registry);
+    pthread_cond_destroy(&server.work);
+    pthread_mutex_destroy(&server.lock);
+    free(workers);
+    return ret;
+}
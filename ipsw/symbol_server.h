@@ -0,0 +1,119 @@
+/*
+ * symbol_server.h - Long-lived symbolication service over a unix socket
+ *
+ * `ipsw serve` keeps several caches mapped, with their symbol indexes, and
+ * answers batches of addresses over a unix-domain stream socket. Clients name
+ * the cache by UUID. One event loop thread owns the sockets; a pool of worker
+ * threads resolves the batches.
+ *
+ * A connection carries requests one after another, and every request gets
+ * exactly one response, in order. A request is either text or binary, told
+ * apart by its first byte.
+ *
+ * Text request: one line, a UUID and then hexadecimal addresses, separated by
+ * whitespace. The UUID may be written with or without dashes.
+ *
+ *   C3E5F2A0-6B1D-4E7A-9F10-2A5D8C4B7E61 0x180028000 0x1800a1c40
+ *
+ * Text response: a status line, then one line per address in the same format
+ * as `ipsw -b`, in request order:
+ *
+ *   OK <address_count> <latency_us>
+ *   objc_msgSend (in libobjc.A.dylib) + 0x0
+ *   ...
+ *
+ * or a single `ERR <message>` line.
+ *
+ * Binary request: struct symbol_server_request, then uint64_t addresses.
+ * Binary response: struct symbol_server_response, then `count` struct
+ * symbol_server_result, then `strings_size` bytes of NUL-terminated strings.
+ * All fields are in host byte order; the socket never leaves the host.
+ */
+
+#ifndef IPSW_SYMBOL_SERVER_H_
+#define IPSW_SYMBOL_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYMBOL_SERVER_REQUEST_MAGIC "IPSQ"  /* 4 bytes, not null-terminated */
+#define SYMBOL_SERVER_RESPONSE_MAGIC "IPSR" /* 4 bytes, not null-terminated */
+#define SYMBOL_SERVER_MAX_ADDRESSES (1u << 20) /* per request */
+#define SYMBOL_SERVER_NO_STRING UINT32_MAX
+
+/* Binary response status */
+enum symbol_server_status {
+    SYMBOL_SERVER_OK = 0,
+    SYMBOL_SERVER_BAD_REQUEST = 1,   /* malformed or oversized request */
+    SYMBOL_SERVER_UNKNOWN_CACHE = 2, /* no served cache has the UUID */
+    SYMBOL_SERVER_UNAVAILABLE = 3,   /* the cache or its index failed to map */
+};
+
+struct symbol_server_request {
+    char magic[4];    /* SYMBOL_SERVER_REQUEST_MAGIC */
+    uint32_t count;   /* addresses that follow */
+    uint8_t uuid[16]; /* cache to resolve against */
+};
+
+struct symbol_server_response {
+    char magic[4];         /* SYMBOL_SERVER_RESPONSE_MAGIC */
+    uint32_t status;       /* enum symbol_server_status */
+    uint32_t count;        /* results that follow, 0 unless status is OK */
+    uint32_t strings_size; /* bytes of strings after the results */
+    uint64_t latency_ns;   /* request received to response ready */
+};
+
+/*
+ * One address of a binary response, in request order. Strings are offsets
+ * into the string section, or SYMBOL_SERVER_NO_STRING. An error response has
+ * no results, and its string section holds the error message.
+ */
+struct symbol_server_result {
+    uint64_t symbol_addr; /* address of the symbol, if any */
+    int32_t image_index;  /* containing image, or -1 if none */
+    uint32_t image_path;  /* full install name of the image */
+    uint32_t symbol_name; /* raw symbol name */
+    uint32_t reserved;    /* zero */
+};
+
+struct symbol_server_config {
+    const char *socket_path;
+    const char *const *cache_paths; /* each needs <cache>.symidx */
+    size_t cache_count;
+    unsigned threads;       /* worker threads, 0: one per online CPU */
+    uint64_t memory_budget; /* bytes of mapped caches and indexes, 0: none */
+    int stop_fd;            /* the server stops once this is readable */
+    int verbose;            /* log every request to stderr */
+};
+
+/* Totals over one symbol_server_run() */
+struct symbol_server_stats {
+    uint64_t connections;
+    uint64_t requests;
+    uint64_t addresses;
+    uint64_t errors; /* requests answered with an error */
+    uint64_t loads;  /* caches mapped, including at startup */
+    uint64_t evictions;
+    uint64_t latency_ns_total;
+    uint64_t latency_ns_max;
+};
+
+/**
+ * Serve symbolication requests until config->stop_fd becomes readable.
+ *
+ * Every cache must have a usable symbol index at <cache>.symidx. Caches are
+ * mapped at startup while they fit the memory budget, and later on first
+ * use. When the mapped caches and indexes exceed the budget, the least
+ * recently used caches that no request is using are unmapped. The most
+ * recently used cache stays mapped even if it alone exceeds the budget.
+ *
+ * The socket is created at socket_path and removed on return. A stale
+ * socket left by a server that is no longer running is replaced.
+ *
+ * @param stats [out] Totals, filled on success
+ * @return 0 after a requested stop, -1 on failure (error printed to stderr)
+ */
+int symbol_server_run(const struct symbol_server_config *config,
+                      struct symbol_server_stats *stats);
+
+#endif /* IPSW_SYMBOL_SERVER_H_ */
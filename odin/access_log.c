@@ -0,0 +1,529 @@
+/* odin/access_log.c -- RFC-049 asynchronous access log.
+ *
+ * Each ring is a power-of-two array of records with a free-running head
+ * (written by the loop thread) and tail (written by the writer thread), so
+ * head - tail is the fill level and neither side ever waits for the other.
+ * The log's mutex guards only the ring list and the counters; a producer
+ * never takes it. The writer formats records into one batch buffer and
+ * releases the mutex around each write(2), so ring creation and stats never
+ * wait on the disk.
+ */
+
+#include "odin/access_log.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ODIN_ACCESS_LOG_BATCH 65536u
+
+struct odin_access_log_ring_t {
+  /* Loop side: the next slot to fill and the records refused. */
+  _Alignas(64) _Atomic uint64_t head;
+  _Atomic uint64_t dropped;
+  _Atomic int retired;
+  /* Writer side: the next slot to drain, on its own cache line. */
+  _Alignas(64) _Atomic uint64_t tail;
+  odin_access_log_ring_t *next; /* log->rings, under log->mu */
+  size_t mask;
+  odin_access_log_record_t *slots;
+};
+
+struct odin_access_log_t {
+  pthread_mutex_t mu;
+  pthread_cond_t cv;
+  pthread_t thread;
+  odin_access_log_ring_t *rings; /* under mu */
+  int stopping;                  /* under mu */
+  int fd;
+  odin_access_log_format_t format;
+  uint32_t flush_ms;
+  uint64_t written;         /* under mu */
+  uint64_t write_errors;    /* under mu */
+  uint64_t retired_dropped; /* drops of rings already freed, under mu */
+  size_t batch_len;         /* writer thread only */
+  uint64_t batch_records;   /* writer thread only */
+  char batch[ODIN_ACCESS_LOG_BATCH];
+};
+
+static uint64_t clock_us(clockid_t id) {
+  struct timespec ts;
+  (void)clock_gettime(id, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+uint64_t odin_access_log_mono_us(void) { return clock_us(CLOCK_MONOTONIC); }
+
+void odin_access_log_record_begin(odin_access_log_record_t *rec,
+                                  odin_access_log_side_t side) {
+  memset(rec, 0, sizeof(*rec));
+  rec->side = (uint8_t)side;
+  rec->start_wall_us = clock_us(CLOCK_REALTIME);
+  rec->start_mono_us = clock_us(CLOCK_MONOTONIC);
+}
+
+void odin_access_log_record_finish(odin_access_log_record_t *rec) {
+  rec->duration_us = odin_access_log_mono_us() - rec->start_mono_us;
+}
+
+void odin_access_log_record_set_host(odin_access_log_record_t *rec,
+                                     const char *host, size_t host_len,
+                                     uint16_t port) {
+  if (host_len > ODIN_ACCESS_LOG_HOST_MAX) {
+    host_len = ODIN_ACCESS_LOG_HOST_MAX;
+  }
+  if (host_len > 0) {
+    memcpy(rec->host, host, host_len);
+  }
+  rec->host_len = (uint8_t)host_len;
+  rec->port = port;
+}
+
+void odin_access_log_addr_set(odin_access_log_addr_t *out,
+                              const struct sockaddr *sa, socklen_t len) {
+  memset(out, 0, sizeof(*out));
+  if (sa == NULL) {
+    return;
+  }
+  if (sa->sa_family == AF_INET &&
+      len >= (socklen_t)sizeof(struct sockaddr_in)) {
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)sa;
+    out->family = AF_INET;
+    out->port = ntohs(sin->sin_port);
+    memcpy(out->addr, &sin->sin_addr, sizeof(sin->sin_addr));
+  } else if (sa->sa_family == AF_INET6 &&
+             len >= (socklen_t)sizeof(struct sockaddr_in6)) {
+    const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)sa;
+    out->family = AF_INET6;
+    out->port = ntohs(sin6->sin6_port);
+    memcpy(out->addr, &sin6->sin6_addr, sizeof(sin6->sin6_addr));
+  }
+}
+
+/* Bounded line builder; ok drops to 0 once anything did not fit. */
+typedef struct line_t {
+  char *buf;
+  size_t cap;
+  size_t len;
+  int ok;
+} line_t;
+
+static void put(line_t *l, const char *s, size_t n) {
+  if (!l->ok || l->cap - l->len < n) {
+    l->ok = 0;
+    return;
+  }
+  memcpy(l->buf + l->len, s, n);
+  l->len += n;
+}
+
+static void put_str(line_t *l, const char *s) { put(l, s, strlen(s)); }
+
+static void put_u64(line_t *l, uint64_t v) {
+  char tmp[24];
+  const int n = snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)v);
+  put(l, tmp, (size_t)n);
+}
+
+static void put_int(line_t *l, int v) {
+  char tmp[16];
+  const int n = snprintf(tmp, sizeof(tmp), "%d", v);
+  put(l, tmp, (size_t)n);
+}
+
+static void put_time(line_t *l, uint64_t wall_us) {
+  const time_t secs = (time_t)(wall_us / 1000000u);
+  struct tm tm;
+  char tmp[40];
+  if (gmtime_r(&secs, &tm) == NULL) {
+    put_str(l, "-");
+    return;
+  }
+  size_t n = strftime(tmp, sizeof(tmp), "%Y-%m-%dT%H:%M:%S", &tm);
+  n += (size_t)snprintf(tmp + n, sizeof(tmp) - n, ".%03uZ",
+                        (unsigned)((wall_us / 1000u) % 1000u));
+  put(l, tmp, n);
+}
+
+/* Writes "ip:port" ("[ip]:port" for IPv6); returns 0 for an unknown addr. */
+static int put_addr(line_t *l, const odin_access_log_addr_t *a) {
+  char ip[INET6_ADDRSTRLEN];
+  if (a->family == 0 || inet_ntop(a->family, a->addr, ip, sizeof(ip)) == NULL) {
+    return 0;
+  }
+  if (a->family == AF_INET6) {
+    put_str(l, "[");
+    put_str(l, ip);
+    put_str(l, "]");
+  } else {
+    put_str(l, ip);
+  }
+  put_str(l, ":");
+  put_u64(l, a->port);
+  return 1;
+}
+
+/* The host came off the wire: text escapes anything that could split a
+ * field or a line, JSON anything a string may not hold raw. */
+static void put_host(line_t *l, const odin_access_log_record_t *rec,
+                     int json) {
+  static const char hex[] = "0123456789abcdef";
+  for (size_t i = 0; i < rec->host_len; ++i) {
+    const unsigned char c = (unsigned char)rec->host[i];
+    if (json) {
+      if (c == '"' || c == '\\') {
+        const char esc[2] = {'\\', (char)c};
+        put(l, esc, sizeof(esc));
+      } else if (c < 0x20 || c >= 0x7f) {
+        const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+        put(l, esc, sizeof(esc));
+      } else {
+        put(l, (const char *)&c, 1);
+      }
+    } else if (c <= 0x20 || c >= 0x7f || c == '\\') {
+      const char esc[4] = {'\\', 'x', hex[c >> 4], hex[c & 15]};
+      put(l, esc, sizeof(esc));
+    } else {
+      put(l, (const char *)&c, 1);
+    }
+  }
+  put_str(l, ":");
+  put_u64(l, rec->port);
+}
+
+static void put_json_addr(line_t *l, const odin_access_log_addr_t *a) {
+  if (a->family == 0) {
+    put_str(l, "null");
+    return;
+  }
+  put_str(l, "\"");
+  (void)put_addr(l, a);
+  put_str(l, "\"");
+}
+
+static void put_text_addr(line_t *l, const odin_access_log_addr_t *a) {
+  if (!put_addr(l, a)) {
+    put_str(l, "-");
+  }
+}
+
+size_t odin_access_log_format(const odin_access_log_record_t *rec,
+                              odin_access_log_format_t format, char *buf,
+                              size_t cap) {
+  line_t l = {buf, cap, 0, 1};
+  const char *side = rec->side == ODIN_ACCESS_LOG_CLIENT ? "client" : "server";
+  if (format == ODIN_ACCESS_LOG_JSONL) {
+    put_str(&l, "{\"ts\":\"");
+    put_time(&l, rec->start_wall_us);
+    put_str(&l, "\",\"side\":\"");
+    put_str(&l, side);
+    put_str(&l, "\",\"client\":");
+    put_json_addr(&l, &rec->client);
+    put_str(&l, ",\"target\":\"");
+    put_host(&l, rec, 1);
+    put_str(&l, "\",\"upstream\":");
+    put_json_addr(&l, &rec->upstream);
+    put_str(&l, ",\"dial_us\":");
+    put_u64(&l, rec->dial_us);
+    put_str(&l, ",\"bytes_up\":");
+    put_u64(&l, rec->bytes_up);
+    put_str(&l, ",\"bytes_down\":");
+    put_u64(&l, rec->bytes_down);
+    put_str(&l, ",\"duration_us\":");
+    put_u64(&l, rec->duration_us);
+    put_str(&l, ",\"errno\":");
+    put_int(&l, rec->err);
+    put_str(&l, "}\n");
+  } else {
+    put_time(&l, rec->start_wall_us);
+    put_str(&l, " ");
+    put_str(&l, side);
+    put_str(&l, " client=");
+    put_text_addr(&l, &rec->client);
+    put_str(&l, " target=");
+    put_host(&l, rec, 0);
+    put_str(&l, " upstream=");
+    put_text_addr(&l, &rec->upstream);
+    put_str(&l, " dial_us=");
+    put_u64(&l, rec->dial_us);
+    put_str(&l, " bytes_up=");
+    put_u64(&l, rec->bytes_up);
+    put_str(&l, " bytes_down=");
+    put_u64(&l, rec->bytes_down);
+    put_str(&l, " duration_us=");
+    put_u64(&l, rec->duration_us);
+    put_str(&l, " errno=");
+    put_int(&l, rec->err);
+    put_str(&l, "\n");
+  }
+  return l.ok ? l.len : 0;
+}
+
+/* Writes the batch with log->mu released; called and returns with it held. */
+static void flush_batch(odin_access_log_t *log) {
+  if (log->batch_len == 0) {
+    return;
+  }
+  pthread_mutex_unlock(&log->mu);
+  size_t off = 0;
+  int failed = 0;
+  while (off < log->batch_len) {
+    const ssize_t n = write(log->fd, log->batch + off, log->batch_len - off);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      failed = 1;
+      break;
+    }
+    off += (size_t)n;
+  }
+  pthread_mutex_lock(&log->mu);
+  if (failed) {
+    log->write_errors += log->batch_records;
+  } else {
+    log->written += log->batch_records;
+  }
+  log->batch_len = 0;
+  log->batch_records = 0;
+}
+
+static void drain_ring(odin_access_log_t *log, odin_access_log_ring_t *ring) {
+  uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  const uint64_t head =
+      atomic_load_explicit(&ring->head, memory_order_acquire);
+  while (tail != head) {
+    if (sizeof(log->batch) - log->batch_len < ODIN_ACCESS_LOG_LINE_MAX) {
+      flush_batch(log);
+    }
+    log->batch_len += odin_access_log_format(
+        &ring->slots[tail & ring->mask], log->format,
+        log->batch + log->batch_len, sizeof(log->batch) - log->batch_len);
+    log->batch_records += 1;
+    tail += 1;
+  }
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
+
+static void unlink_ring(odin_access_log_t *log, odin_access_log_ring_t *ring) {
+  for (odin_access_log_ring_t **pp = &log->rings; *pp != NULL;
+       pp = &(*pp)->next) {
+    if (*pp == ring) {
+      *pp = ring->next;
+      return;
+    }
+  }
+}
+
+static void free_ring(odin_access_log_ring_t *ring) {
+  free(ring->slots);
+  free(ring);
+}
+
+/* Drains every ring and frees the retired ones. A retired ring's producer is
+ * done, so the head read after the retired flag is final. */
+static void drain_all(odin_access_log_t *log) {
+  odin_access_log_ring_t **pp = &log->rings;
+  while (*pp != NULL) {
+    odin_access_log_ring_t *ring = *pp;
+    const int retired =
+        atomic_load_explicit(&ring->retired, memory_order_acquire);
+    drain_ring(log, ring);
+    if (!retired) {
+      pp = &ring->next;
+      continue;
+    }
+    /* flush_batch may have let a new ring in at the head. */
+    unlink_ring(log, ring);
+    log->retired_dropped +=
+        atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    free_ring(ring);
+  }
+}
+
+static void *writer_main(void *arg) {
+  odin_access_log_t *log = (odin_access_log_t *)arg;
+  pthread_mutex_lock(&log->mu);
+  for (;;) {
+    if (!log->stopping) {
+      struct timespec deadline;
+      (void)clock_gettime(CLOCK_REALTIME, &deadline);
+      const uint64_t ns =
+          (uint64_t)deadline.tv_nsec + (uint64_t)log->flush_ms * 1000000u;
+      deadline.tv_sec += (time_t)(ns / 1000000000u);
+      deadline.tv_nsec = (long)(ns % 1000000000u);
+      (void)pthread_cond_timedwait(&log->cv, &log->mu, &deadline);
+    }
+    const int stopping = log->stopping;
+    drain_all(log);
+    flush_batch(log);
+    if (stopping) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&log->mu);
+  return NULL;
+}
+
+int odin_access_log_create(const odin_access_log_config_t *config,
+                           odin_access_log_t **out) {
+  if (config == NULL || out == NULL || config->fd < 0 ||
+      (config->format != ODIN_ACCESS_LOG_TEXT &&
+       config->format != ODIN_ACCESS_LOG_JSONL)) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_access_log_t *log = (odin_access_log_t *)malloc(sizeof(*log));
+  if (log == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(log, 0, offsetof(odin_access_log_t, batch));
+  log->fd = config->fd;
+  log->format = config->format;
+  log->flush_ms = config->flush_ms != 0 ? config->flush_ms
+                                        : ODIN_ACCESS_LOG_DEFAULT_FLUSH_MS;
+  if (pthread_mutex_init(&log->mu, NULL) != 0) {
+    free(log);
+    errno = ENOMEM;
+    return -1;
+  }
+  if (pthread_cond_init(&log->cv, NULL) != 0) {
+    pthread_mutex_destroy(&log->mu);
+    free(log);
+    errno = ENOMEM;
+    return -1;
+  }
+  /* The writer takes no signals, so SIGINT/SIGTERM reach the loop thread. */
+  sigset_t all;
+  sigset_t old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  const int rc = pthread_create(&log->thread, NULL, writer_main, log);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (rc != 0) {
+    pthread_cond_destroy(&log->cv);
+    pthread_mutex_destroy(&log->mu);
+    free(log);
+    errno = rc;
+    return -1;
+  }
+  *out = log;
+  return 0;
+}
+
+void odin_access_log_stats(odin_access_log_t *log,
+                           odin_access_log_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  if (log == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&log->mu);
+  out->written = log->written;
+  out->write_errors = log->write_errors;
+  out->dropped = log->retired_dropped;
+  for (odin_access_log_ring_t *r = log->rings; r != NULL; r = r->next) {
+    out->dropped += atomic_load_explicit(&r->dropped, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&log->mu);
+}
+
+void odin_access_log_destroy(odin_access_log_t *log) {
+  if (log == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&log->mu);
+  log->stopping = 1;
+  pthread_cond_signal(&log->cv);
+  pthread_mutex_unlock(&log->mu);
+  pthread_join(log->thread, NULL);
+  /* Rings the caller never destroyed were drained by the last pass. */
+  while (log->rings != NULL) {
+    odin_access_log_ring_t *ring = log->rings;
+    log->rings = ring->next;
+    free_ring(ring);
+  }
+  pthread_cond_destroy(&log->cv);
+  pthread_mutex_destroy(&log->mu);
+  free(log);
+}
+
+int odin_access_log_ring_create(odin_access_log_t *log, size_t capacity,
+                                odin_access_log_ring_t **out) {
+  if (log == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (capacity == 0) {
+    capacity = ODIN_ACCESS_LOG_DEFAULT_RING;
+  }
+  size_t slots = 1;
+  while (slots < capacity) {
+    if (slots > SIZE_MAX / 2 / sizeof(odin_access_log_record_t)) {
+      errno = EINVAL;
+      return -1;
+    }
+    slots <<= 1;
+  }
+  odin_access_log_ring_t *ring = NULL;
+  if (posix_memalign((void **)&ring, _Alignof(odin_access_log_ring_t),
+                     sizeof(*ring)) != 0) {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(ring, 0, sizeof(*ring));
+  ring->slots = (odin_access_log_record_t *)malloc(
+      slots * sizeof(odin_access_log_record_t));
+  if (ring->slots == NULL) {
+    free(ring);
+    errno = ENOMEM;
+    return -1;
+  }
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->dropped, 0);
+  atomic_init(&ring->retired, 0);
+  ring->mask = slots - 1;
+  pthread_mutex_lock(&log->mu);
+  ring->next = log->rings;
+  log->rings = ring;
+  pthread_mutex_unlock(&log->mu);
+  *out = ring;
+  return 0;
+}
+
+int odin_access_log_append(odin_access_log_ring_t *ring,
+                           const odin_access_log_record_t *rec) {
+  if (ring == NULL || rec == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  const uint64_t head =
+      atomic_load_explicit(&ring->head, memory_order_relaxed);
+  const uint64_t tail =
+      atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail > ring->mask) {
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+    errno = ENOBUFS;
+    return -1;
+  }
+  ring->slots[head & ring->mask] = *rec;
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return 0;
+}
+
+void odin_access_log_ring_destroy(odin_access_log_ring_t *ring) {
+  if (ring == NULL) {
+    return;
+  }
+  atomic_store_explicit(&ring->retired, 1, memory_order_release);
+}
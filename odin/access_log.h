@@ -0,0 +1,130 @@
+/* odin/access_log.h
+ *
+ * Asynchronous per-tunnel access log (RFC-049).
+ *
+ * One odin_access_log_t owns a writer thread and the fd it writes to. Each
+ * event loop that closes tunnels gets its own odin_access_log_ring_t: a
+ * single-producer, single-consumer ring of fixed-size records. The loop
+ * thread copies a finished tunnel's record into its ring with
+ * odin_access_log_append, which takes no lock, allocates nothing, and makes
+ * no system call; when the ring is full the record is dropped and counted.
+ * The writer thread wakes every flush_ms, drains every ring, formats the
+ * records as text or JSON Lines, and writes them in batches, so a slow disk
+ * never stalls a loop.
+ *
+ * odin_access_log_create and odin_access_log_destroy run on the thread that
+ * owns the log. A ring is created on any thread, then appended to and
+ * destroyed only by the loop thread it belongs to. Destroying a ring hands
+ * it to the writer, which writes what is left in it and frees it; destroy
+ * the rings before the log. odin_access_log_destroy writes every record
+ * still queued, joins the writer, and leaves the fd open. int-returning
+ * functions return 0, or -1 with errno set.
+ */
+
+#ifndef ODIN_ACCESS_LOG_H_
+#define ODIN_ACCESS_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_ACCESS_LOG_HOST_MAX 255u
+#define ODIN_ACCESS_LOG_DEFAULT_RING 1024u
+#define ODIN_ACCESS_LOG_DEFAULT_FLUSH_MS 100u
+/* Longest formatted line, including the newline: every host byte may be
+ * escaped. */
+#define ODIN_ACCESS_LOG_LINE_MAX 2048u
+
+typedef struct odin_access_log_t odin_access_log_t;
+typedef struct odin_access_log_ring_t odin_access_log_ring_t;
+
+typedef enum odin_access_log_format_t {
+  ODIN_ACCESS_LOG_TEXT = 0, /* key=value fields, one line per tunnel */
+  ODIN_ACCESS_LOG_JSONL = 1,
+} odin_access_log_format_t;
+
+typedef enum odin_access_log_side_t {
+  ODIN_ACCESS_LOG_SERVER = 0,
+  ODIN_ACCESS_LOG_CLIENT = 1,
+} odin_access_log_side_t;
+
+/* An address packed for the ring; family 0 means unknown. */
+typedef struct odin_access_log_addr_t {
+  uint8_t family; /* 0, AF_INET, or AF_INET6 */
+  uint16_t port;
+  uint8_t addr[16];
+} odin_access_log_addr_t;
+
+/* One tunnel. bytes_up counts client-to-target bytes and bytes_down the
+ * reverse; dial_us is 0 when no upstream connection was attempted. */
+typedef struct odin_access_log_record_t {
+  uint64_t start_wall_us; /* CLOCK_REALTIME when the tunnel began */
+  uint64_t start_mono_us; /* CLOCK_MONOTONIC, for duration_us */
+  uint64_t duration_us;
+  uint64_t dial_us;
+  uint64_t bytes_up;
+  uint64_t bytes_down;
+  int err; /* close errno; 0 for a clean close */
+  uint8_t side;
+  uint8_t host_len;
+  uint16_t port;
+  odin_access_log_addr_t client;
+  odin_access_log_addr_t upstream; /* the address actually dialed */
+  char host[ODIN_ACCESS_LOG_HOST_MAX];
+} odin_access_log_record_t;
+
+typedef struct odin_access_log_config_t {
+  int fd; /* borrowed; written only by the writer thread */
+  odin_access_log_format_t format;
+  uint32_t flush_ms; /* 0: ODIN_ACCESS_LOG_DEFAULT_FLUSH_MS */
+} odin_access_log_config_t;
+
+typedef struct odin_access_log_stats_t {
+  uint64_t written;      /* records written */
+  uint64_t dropped;      /* records refused by a full ring */
+  uint64_t write_errors; /* records lost to a failed write */
+} odin_access_log_stats_t;
+
+int odin_access_log_create(const odin_access_log_config_t *config,
+                           odin_access_log_t **out);
+void odin_access_log_stats(odin_access_log_t *log,
+                           odin_access_log_stats_t *out);
+void odin_access_log_destroy(odin_access_log_t *log);
+
+/* capacity is rounded up to a power of two; 0 takes
+ * ODIN_ACCESS_LOG_DEFAULT_RING. */
+int odin_access_log_ring_create(odin_access_log_t *log, size_t capacity,
+                                odin_access_log_ring_t **out);
+/* Fails with ENOBUFS, and counts a drop, when the ring is full. */
+int odin_access_log_append(odin_access_log_ring_t *ring,
+                           const odin_access_log_record_t *rec);
+void odin_access_log_ring_destroy(odin_access_log_ring_t *ring);
+
+/* Producer helpers. begin zeroes *rec and stamps both start clocks; finish
+ * sets duration_us. */
+void odin_access_log_record_begin(odin_access_log_record_t *rec,
+                                  odin_access_log_side_t side);
+void odin_access_log_record_finish(odin_access_log_record_t *rec);
+void odin_access_log_record_set_host(odin_access_log_record_t *rec,
+                                     const char *host, size_t host_len,
+                                     uint16_t port);
+/* Leaves *out unknown for anything but AF_INET and AF_INET6. */
+void odin_access_log_addr_set(odin_access_log_addr_t *out,
+                              const struct sockaddr *sa, socklen_t len);
+uint64_t odin_access_log_mono_us(void);
+
+/* Formats one line, newline included, into buf (cap of at least
+ * ODIN_ACCESS_LOG_LINE_MAX) and returns its length. */
+size_t odin_access_log_format(const odin_access_log_record_t *rec,
+                              odin_access_log_format_t format, char *buf,
+                              size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_ACCESS_LOG_H_ */
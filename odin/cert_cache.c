@@ -0,0 +1,180 @@
+/* odin/cert_cache.c -- RFC-042 certificate verification result cache. */
+
+#include "odin/cert_cache.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct cert_cache_entry_t {
+  uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN];
+  uint64_t expires_ms; /* 0: free slot */
+  uint64_t last_used;  /* use clock value of the last hit or insert */
+} cert_cache_entry_t;
+
+struct odin_cert_cache_t {
+  size_t capacity;
+  uint64_t ttl_ms;
+  uint64_t use_clock;
+  int anchor_set;
+  uint8_t anchor[ODIN_CERT_CACHE_DIGEST_LEN];
+  odin_cert_cache_stats_t stats;
+  cert_cache_entry_t entries[];
+};
+
+int odin_cert_cache_create(size_t capacity, uint64_t ttl_ms,
+                           odin_cert_cache_t **out) {
+  if (out == NULL || capacity == 0 || capacity > ODIN_CERT_CACHE_MAX_ENTRIES ||
+      ttl_ms == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_cert_cache_t *cache = (odin_cert_cache_t *)calloc(
+      1, sizeof(*cache) + capacity * sizeof(cache->entries[0]));
+  if (cache == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  cache->capacity = capacity;
+  cache->ttl_ms = ttl_ms;
+  *out = cache;
+  return 0;
+}
+
+static size_t cert_cache_live_count(const odin_cert_cache_t *cache) {
+  size_t live = 0;
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    if (cache->entries[i].expires_ms != 0) {
+      live += 1;
+    }
+  }
+  return live;
+}
+
+void odin_cert_cache_set_anchor(
+    odin_cert_cache_t *cache,
+    const uint8_t anchor[ODIN_CERT_CACHE_DIGEST_LEN]) {
+  if (cache == NULL || anchor == NULL) {
+    return;
+  }
+  if (cache->anchor_set &&
+      memcmp(cache->anchor, anchor, ODIN_CERT_CACHE_DIGEST_LEN) == 0) {
+    return;
+  }
+  cache->stats.invalidations += cert_cache_live_count(cache);
+  memset(cache->entries, 0, cache->capacity * sizeof(cache->entries[0]));
+  memcpy(cache->anchor, anchor, ODIN_CERT_CACHE_DIGEST_LEN);
+  cache->anchor_set = 1;
+}
+
+/* Returns key's live slot, freeing it instead when it has expired. */
+static cert_cache_entry_t *
+cert_cache_find(odin_cert_cache_t *cache,
+                const uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN],
+                uint64_t now_ms) {
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    cert_cache_entry_t *e = &cache->entries[i];
+    if (e->expires_ms == 0 ||
+        memcmp(e->key, key, ODIN_CERT_CACHE_DIGEST_LEN) != 0) {
+      continue;
+    }
+    if (now_ms >= e->expires_ms) {
+      e->expires_ms = 0;
+      cache->stats.expirations += 1;
+      return NULL;
+    }
+    return e;
+  }
+  return NULL;
+}
+
+int odin_cert_cache_lookup(odin_cert_cache_t *cache,
+                           const uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN],
+                           uint64_t now_ms) {
+  if (cache == NULL || key == NULL) {
+    return 0;
+  }
+  cert_cache_entry_t *e = cert_cache_find(cache, key, now_ms);
+  if (e == NULL) {
+    cache->stats.misses += 1;
+    return 0;
+  }
+  e->last_used = ++cache->use_clock;
+  cache->stats.hits += 1;
+  return 1;
+}
+
+void odin_cert_cache_insert(odin_cert_cache_t *cache,
+                            const uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN],
+                            uint64_t not_after_ms, uint64_t now_ms) {
+  if (cache == NULL || key == NULL || not_after_ms <= now_ms) {
+    return;
+  }
+  uint64_t expires_ms = now_ms + cache->ttl_ms;
+  if (expires_ms < now_ms || expires_ms > not_after_ms) {
+    expires_ms = not_after_ms;
+  }
+
+  cert_cache_entry_t *slot = cert_cache_find(cache, key, now_ms);
+  if (slot == NULL) {
+    /* A free or expired slot first; otherwise the least recently used. */
+    cert_cache_entry_t *lru = NULL;
+    for (size_t i = 0; i < cache->capacity && slot == NULL; ++i) {
+      cert_cache_entry_t *e = &cache->entries[i];
+      if (e->expires_ms != 0 && now_ms >= e->expires_ms) {
+        e->expires_ms = 0;
+        cache->stats.expirations += 1;
+      }
+      if (e->expires_ms == 0) {
+        slot = e;
+      } else if (lru == NULL || e->last_used < lru->last_used) {
+        lru = e;
+      }
+    }
+    if (slot == NULL) {
+      slot = lru;
+      cache->stats.evictions += 1;
+    }
+    memcpy(slot->key, key, ODIN_CERT_CACHE_DIGEST_LEN);
+    cache->stats.inserts += 1;
+  }
+  slot->expires_ms = expires_ms;
+  slot->last_used = ++cache->use_clock;
+}
+
+void odin_cert_cache_record_verify(odin_cert_cache_t *cache,
+                                   uint64_t elapsed_ns) {
+  if (cache == NULL) {
+    return;
+  }
+  cache->stats.verifies += 1;
+  cache->stats.verify_ns += elapsed_ns;
+}
+
+void odin_cert_cache_stats(const odin_cert_cache_t *cache,
+                           odin_cert_cache_stats_t *out) {
+  if (out == NULL) {
+    return;
+  }
+  if (cache == NULL) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = cache->stats;
+}
+
+size_t odin_cert_cache_stats_format(const odin_cert_cache_stats_t *stats,
+                                    char *buf, size_t cap) {
+  const int n = snprintf(buf, cap,
+                         "cert=%" PRIu64 "/%" PRIu64 " verifies=%" PRIu64
+                         " verify_us=%" PRIu64,
+                         stats->hits, stats->misses, stats->verifies,
+                         stats->verify_ns / 1000u);
+  return n > 0 ? (size_t)n : 0;
+}
+
+void odin_cert_cache_destroy(odin_cert_cache_t *cache) { free(cache); }
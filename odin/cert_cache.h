@@ -0,0 +1,104 @@
+/* odin/cert_cache.h
+ *
+ * Client certificate verification result cache (RFC-042).
+ *
+ * Remembers server certificate chains that passed full verification, so a
+ * reconnecting client can accept the same chain for the same host without
+ * re-parsing every certificate and running X509_verify_cert again. The owner
+ * computes the key -- a SHA-256 digest over the expected host and the chain
+ * exactly as presented -- and the expiry; the cache itself never parses a
+ * certificate.
+ *
+ * Only successful verifications are stored. An entry is valid until the
+ * earlier of the chain's first notAfter (the caller's not_after_ms) and the
+ * cache TTL counted from the insert; an expired entry is a miss and frees its
+ * slot. When every slot is live, an insert evicts the least recently used
+ * entry.
+ *
+ * Invalidation: the owner describes the trust anchors the stored results were
+ * verified against with an anchor digest. odin_cert_cache_set_anchor with a
+ * digest different from the current one drops every entry, so a reloaded or
+ * edited CA file never vouches for a chain verified against the old one.
+ *
+ * Counters: lookups count as hits or misses; full verifications the owner ran
+ * are reported back with their duration, so the hit rate and the time saved
+ * can be read from one snapshot.
+ *
+ * Times are caller-supplied wall-clock (CLOCK_REALTIME) milliseconds, the
+ * clock certificate validity is measured in. Threading: a cache belongs to
+ * one owner thread (one event loop) and may be shared by every runtime on it.
+ * odin_cert_cache_destroy(NULL) is a no-op.
+ */
+
+#ifndef ODIN_CERT_CACHE_H_
+#define ODIN_CERT_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_CERT_CACHE_DIGEST_LEN 32u
+#define ODIN_CERT_CACHE_MAX_ENTRIES 1024u
+#define ODIN_CERT_CACHE_DEFAULT_ENTRIES 64u
+#define ODIN_CERT_CACHE_DEFAULT_TTL_MS 3600000u /* one hour */
+
+typedef struct odin_cert_cache_t odin_cert_cache_t;
+
+typedef struct odin_cert_cache_stats_t {
+  uint64_t hits;          /* lookups answered from the cache            */
+  uint64_t misses;        /* lookups that needed a full verification    */
+  uint64_t inserts;       /* verified chains stored                     */
+  uint64_t evictions;     /* live entries displaced by an insert        */
+  uint64_t expirations;   /* entries dropped at notAfter or TTL         */
+  uint64_t invalidations; /* entries dropped by an anchor change        */
+  uint64_t verifies;      /* full verifications reported by the owner   */
+  uint64_t verify_ns;     /* their total duration                       */
+} odin_cert_cache_stats_t;
+
+/* Creates an empty cache of capacity entries whose results live at most
+ * ttl_ms. Returns 0, or -1 with errno EINVAL (capacity 0 or
+ * > ODIN_CERT_CACHE_MAX_ENTRIES, ttl_ms 0, or out NULL) or ENOMEM. */
+int odin_cert_cache_create(size_t capacity, uint64_t ttl_ms,
+                           odin_cert_cache_t **out);
+
+/* Sets the trust-anchor digest; a change from the current one (the first
+ * call included) drops every entry. */
+void odin_cert_cache_set_anchor(
+    odin_cert_cache_t *cache, const uint8_t anchor[ODIN_CERT_CACHE_DIGEST_LEN]);
+
+/* Returns 1 when key holds a result still valid at now_ms, else 0. */
+int odin_cert_cache_lookup(odin_cert_cache_t *cache,
+                           const uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN],
+                           uint64_t now_ms);
+
+/* Stores key as verified at now_ms, valid until not_after_ms or the TTL,
+ * whichever is sooner. Ignored when not_after_ms <= now_ms. */
+void odin_cert_cache_insert(odin_cert_cache_t *cache,
+                            const uint8_t key[ODIN_CERT_CACHE_DIGEST_LEN],
+                            uint64_t not_after_ms, uint64_t now_ms);
+
+/* Counts one full verification the owner ran, taking elapsed_ns. */
+void odin_cert_cache_record_verify(odin_cert_cache_t *cache,
+                                   uint64_t elapsed_ns);
+
+void odin_cert_cache_stats(const odin_cert_cache_t *cache,
+                           odin_cert_cache_stats_t *out);
+
+/* Formats stats for the RFC-051 log line as
+ * "cert=H/M verifies=V verify_us=U": hits over misses, then the full
+ * verifications and their total time. snprintf semantics: the result is
+ * truncated to cap - 1 bytes and NUL-terminated when cap > 0, and the
+ * return value is the untruncated length. */
+size_t odin_cert_cache_stats_format(const odin_cert_cache_stats_t *stats,
+                                    char *buf, size_t cap);
+
+void odin_cert_cache_destroy(odin_cert_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_CERT_CACHE_H_ */
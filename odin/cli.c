@@ -5,13 +5,23 @@
  * yields the corresponding status.
  *
  *   <U_C>    = "usage: odin-client --listen ADDR --server ADDR "
- *              "--ca-file FILE"
+ *              "--ca-file FILE [--extra-server ADDR]... "
+ *              "[--addrs-per-server N] [--transparent] "
+ *              "[--frontend http|socks5|auto] [--route RULE]... "
+ *              "[--cert-cache-ttl-ms MS] [--dns-stub-port PORT] "
+ *              "[--access-log FILE] [--access-log-format text|jsonl] "
+ *              "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+ *              "[--qlog-max-bytes N] [--stats-interval-s N]"
  *   <U_S>    = "usage: odin-server --listen ADDR --quic-cert FILE "
- *              "--quic-key FILE"
+ *              "--quic-key FILE [--source-addr IP]... "
+ *              "[--source-policy round-robin|least-used] "
+ *              "[--access-log FILE] [--access-log-format text|jsonl] "
+ *              "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+ *              "[--qlog-max-bytes N] [--stats-interval-s N]"
  *   <U_BOTH> = "usage: 'odin-client --listen ADDR --server ADDR "
- *              "--ca-file FILE' or "
+ *              "--ca-file FILE [OPTION]...' or "
  *              "'odin-server --listen ADDR --quic-cert FILE "
- *              "--quic-key FILE'"
+ *              "--quic-key FILE [OPTION]...'"
  *
  * | status           | out       | err                                      |
  * return |
@@ -30,15 +40,28 @@
 
 #include "odin/cli.h"
 
+#include <arpa/inet.h>
 #include <getopt.h>
+#include <netinet/in.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/socket.h>
 
 #include "odin/cli_client.h"
 #include "odin/cli_server.h"
+#include "odin/dial.h"
 #include "odin/host_addr.h"
 #include "odin/parse_util.h"
+#include "odin/route.h"
+#include "odin/upstream_set.h"
+
+_Static_assert(ODIN_CLI_ROUTE_RULES_MAX == ODIN_ROUTE_RULES_MAX,
+               "--route accepts exactly as many rules as a table holds");
+_Static_assert(ODIN_CLI_EXTRA_SERVERS_MAX + 1 == ODIN_UPSTREAM_SET_MAX,
+               "--extra-server fills every upstream slot but the primary");
+_Static_assert(ODIN_CLI_SOURCE_ADDRS_MAX == ODIN_DIAL_SOURCE_POOL_MAX,
+               "--source-addr accepts exactly as many addresses as a pool");
 
 typedef enum {
   OK_PARSED,
@@ -66,6 +89,64 @@ static parse_listen_port_result_t parse_listen_port(const char *s) {
   return r;
 }
 
+/* Parses a bare ASCII-decimal value in [0, max]; the --listen digit rules
+ * without the port cap. Returns 0, or -1 on anything else. */
+static int parse_decimal(const char *s, uint64_t max, uint64_t *out) {
+  if (s[0] == '\0') {
+    return -1;
+  }
+  uint64_t v = 0;
+  for (const char *p = s; *p != '\0'; ++p) {
+    if (*p < '0' || *p > '9') {
+      return -1;
+    }
+    const uint64_t d = (uint64_t)(*p - '0');
+    if (d > max || v > (max - d) / 10u) {
+      return -1;
+    }
+    v = v * 10u + d;
+  }
+  *out = v;
+  return 0;
+}
+
+/* Index of s in names, or -1. */
+static int parse_keyword(const char *s, const char *const *names,
+                         size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (strcmp(s, names[i]) == 0) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/* Indexed by odin_client_session_frontend_t. */
+static const char *const kFrontends[] = {"http", "socks5", "auto"};
+
+/* Indexed by odin_access_log_format_t. */
+static const char *const kAccessLogFormats[] = {"text", "jsonl"};
+
+/* Indexed by odin_dial_source_policy_t. */
+static const char *const kSourcePolicies[] = {"round-robin", "least-used"};
+
+/* Parses a numeric IPv4 or IPv6 address with no port into *out. Returns 0, or
+ * -1 for anything else (including a host name). */
+static int parse_source_addr(const char *s, struct sockaddr_storage *out) {
+  memset(out, 0, sizeof(*out));
+  struct sockaddr_in *sin = (struct sockaddr_in *)out;
+  if (inet_pton(AF_INET, s, &sin->sin_addr) == 1) {
+    sin->sin_family = AF_INET;
+    return 0;
+  }
+  struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)out;
+  if (inet_pton(AF_INET6, s, &sin6->sin6_addr) == 1) {
+    sin6->sin6_family = AF_INET6;
+    return 0;
+  }
+  return -1;
+}
+
 static const char *cli_basename(const char *path) {
   const char *last = path;
   for (const char *p = path; *p != '\0'; ++p) {
@@ -80,6 +161,20 @@ static const struct option kClientLong[] = {
     {"listen", required_argument, NULL, 'l'},
     {"server", required_argument, NULL, 's'},
     {"ca-file", required_argument, NULL, 1003},
+    {"route", required_argument, NULL, 1004},
+    {"access-log", required_argument, NULL, 1005},
+    {"access-log-format", required_argument, NULL, 1006},
+    {"frontend", required_argument, NULL, 1007},
+    {"transparent", no_argument, NULL, 1008},
+    {"extra-server", required_argument, NULL, 1009},
+    {"addrs-per-server", required_argument, NULL, 1010},
+    {"cert-cache-ttl-ms", required_argument, NULL, 1011},
+    {"dns-stub-port", required_argument, NULL, 1012},
+    {"qlog", required_argument, NULL, 1013},
+    {"qlog-sample", required_argument, NULL, 1014},
+    {"qlog-force-ip", required_argument, NULL, 1015},
+    {"qlog-max-bytes", required_argument, NULL, 1016},
+    {"stats-interval-s", required_argument, NULL, 1019},
     {"help", no_argument, NULL, 'h'},
     {NULL, 0, NULL, 0},
 };
@@ -88,19 +183,22 @@ static const struct option kServerLong[] = {
     {"listen", required_argument, NULL, 'l'},
     {"quic-cert", required_argument, NULL, 1001},
     {"quic-key", required_argument, NULL, 1002},
+    {"source-addr", required_argument, NULL, 1017},
+    {"source-policy", required_argument, NULL, 1018},
+    {"access-log", required_argument, NULL, 1005},
+    {"access-log-format", required_argument, NULL, 1006},
+    {"qlog", required_argument, NULL, 1013},
+    {"qlog-sample", required_argument, NULL, 1014},
+    {"qlog-force-ip", required_argument, NULL, 1015},
+    {"qlog-max-bytes", required_argument, NULL, 1016},
+    {"stats-interval-s", required_argument, NULL, 1019},
     {"help", no_argument, NULL, 'h'},
     {NULL, 0, NULL, 0},
 };
 
 odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
                                  odin_cli_args_t *out) {
-  out->listen_port = 0;
-  out->server_host = NULL;
-  out->server_host_len = 0;
-  out->server_port = 0;
-  out->quic_cert_file = NULL;
-  out->quic_key_file = NULL;
-  out->quic_ca_file = NULL;
+  memset(out, 0, sizeof(*out));
 
   if (argc < 1 || argv[0] == NULL) {
     return ODIN_CLI_ERR_UNKNOWN_MODE;
@@ -148,6 +246,26 @@ odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
   const char *quic_ca_arg = NULL;
   int client_ca_seen = 0;
   int bad_client_ca = 0;
+  int bad_option = 0;
+  const char *route_args[ODIN_CLI_ROUTE_RULES_MAX];
+  size_t route_count = 0;
+  const char *access_log_arg = NULL;
+  int access_log_format = ODIN_ACCESS_LOG_TEXT;
+  int frontend = ODIN_CLIENT_SESSION_FRONTEND_HTTP;
+  int transparent = 0;
+  odin_cli_client_server_t extra_servers[ODIN_CLI_EXTRA_SERVERS_MAX];
+  size_t extra_server_count = 0;
+  uint64_t addrs_per_server = 0;
+  uint64_t cert_cache_ttl_ms = 0;
+  uint64_t dns_stub_port = 0;
+  const char *qlog_arg = NULL;
+  uint64_t qlog_sample_every = 0;
+  const char *qlog_force_ip_arg = NULL;
+  uint64_t qlog_max_bytes = 0;
+  uint64_t stats_interval_s = 0;
+  struct sockaddr_storage source_addrs[ODIN_CLI_SOURCE_ADDRS_MAX];
+  size_t source_addr_count = 0;
+  int source_policy = -1;
 
   for (;;) {
     int longindex = -1;
@@ -184,7 +302,8 @@ odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
         unknown_flag_seen = 1;
         continue;
       }
-      if (c == 1003 && tok[2 + exp_len] == '\0' &&
+      if (c >= 1003 && longopts[longindex].has_arg == required_argument &&
+          tok[2 + exp_len] == '\0' &&
           !(optarg != NULL && optind >= 1 && optind <= argc &&
             optarg == argv[optind - 1])) {
         missing_required_long_arg = 1;
@@ -219,6 +338,118 @@ odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
         }
       }
       break;
+    case 1004:
+      if (optarg[0] == '\0' || route_count == ODIN_CLI_ROUTE_RULES_MAX) {
+        bad_option = 1;
+      } else {
+        route_args[route_count++] = optarg;
+      }
+      break;
+    case 1005:
+      if (optarg[0] == '\0') {
+        bad_option = 1;
+      } else {
+        access_log_arg = optarg;
+      }
+      break;
+    case 1006:
+      access_log_format = parse_keyword(
+          optarg, kAccessLogFormats,
+          sizeof(kAccessLogFormats) / sizeof(kAccessLogFormats[0]));
+      if (access_log_format < 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1007:
+      frontend =
+          parse_keyword(optarg, kFrontends,
+                        sizeof(kFrontends) / sizeof(kFrontends[0]));
+      if (frontend < 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1008:
+      transparent = 1;
+      break;
+    case 1009: {
+      odin_host_addr_t ha;
+      if (extra_server_count == ODIN_CLI_EXTRA_SERVERS_MAX ||
+          odin_host_addr_parse(optarg, &ha) != ODIN_HOST_ADDR_OK) {
+        bad_option = 1;
+      } else {
+        odin_cli_client_server_t *srv = &extra_servers[extra_server_count++];
+        srv->host = ha.host;
+        srv->host_len = ha.host_len;
+        srv->port = ha.port;
+      }
+      break;
+    }
+    case 1010:
+      if (parse_decimal(optarg, ODIN_UPSTREAM_SET_MAX, &addrs_per_server) !=
+              0 ||
+          addrs_per_server == 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1011:
+      if (parse_decimal(optarg, UINT64_MAX, &cert_cache_ttl_ms) != 0 ||
+          cert_cache_ttl_ms == 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1012:
+      if (parse_decimal(optarg, UINT16_MAX, &dns_stub_port) != 0 ||
+          dns_stub_port == 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1013:
+      if (optarg[0] == '\0') {
+        bad_option = 1;
+      } else {
+        qlog_arg = optarg;
+      }
+      break;
+    case 1014:
+      if (parse_decimal(optarg, UINT32_MAX, &qlog_sample_every) != 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1015:
+      if (optarg[0] == '\0') {
+        bad_option = 1;
+      } else {
+        qlog_force_ip_arg = optarg;
+      }
+      break;
+    case 1016:
+      if (parse_decimal(optarg, UINT64_MAX, &qlog_max_bytes) != 0 ||
+          qlog_max_bytes == 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1019:
+      if (parse_decimal(optarg, ODIN_CLI_STATS_INTERVAL_MAX_S,
+                        &stats_interval_s) != 0) {
+        bad_option = 1;
+      }
+      break;
+    case 1017:
+      if (source_addr_count == ODIN_CLI_SOURCE_ADDRS_MAX ||
+          parse_source_addr(optarg, &source_addrs[source_addr_count]) != 0) {
+        bad_option = 1;
+      } else {
+        source_addr_count += 1;
+      }
+      break;
+    case 1018:
+      source_policy =
+          parse_keyword(optarg, kSourcePolicies,
+                        sizeof(kSourcePolicies) / sizeof(kSourcePolicies[0]));
+      if (source_policy < 0) {
+        bad_option = 1;
+      }
+      break;
     case 'h':
       help_seen = 1;
       break;
@@ -230,6 +461,9 @@ odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
       break;
     }
   }
+  if (source_policy >= 0 && source_addr_count == 0) {
+    bad_option = 1; /* a policy needs a pool to apply to */
+  }
   if (optind < argc) {
     /* Stray positional operand: `+` mode short-circuited at it, but the
      * RFC's §4.2.1 precedence routes that through ERR_UNKNOWN_FLAG too. */
@@ -259,20 +493,46 @@ odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
     status = ODIN_CLI_ERR_MISSING_REQUIRED;
   } else if (bad_quic_tls || (is_client && bad_client_ca)) {
     status = ODIN_CLI_ERR_BAD_QUIC_TLS;
+  } else if (bad_option) {
+    status = ODIN_CLI_ERR_BAD_OPTION;
   } else {
     out->listen_port =
         (pr.status == OK_PARSED)
             ? pr.port
             : (uint16_t)(is_client ? ODIN_CLI_DEFAULT_LISTEN_PORT_CLIENT
                                    : ODIN_CLI_DEFAULT_LISTEN_PORT_SERVER);
+    out->access_log_path = access_log_arg;
+    out->access_log_format = (odin_access_log_format_t)access_log_format;
+    out->qlog_path = qlog_arg;
+    out->qlog_sample_every = (uint32_t)qlog_sample_every;
+    out->qlog_force_ip = qlog_force_ip_arg;
+    out->qlog_max_bytes = qlog_max_bytes;
+    out->stats_interval_s = (uint32_t)stats_interval_s;
     if (is_client) {
       out->server_host = sr.host;
       out->server_host_len = sr.host_len;
       out->server_port = sr.port;
       out->quic_ca_file = quic_ca_arg;
+      memcpy(out->route_rules, route_args,
+             route_count * sizeof(route_args[0]));
+      out->route_rule_count = route_count;
+      out->frontend = (odin_client_session_frontend_t)frontend;
+      out->transparent = transparent;
+      memcpy(out->extra_servers, extra_servers,
+             extra_server_count * sizeof(extra_servers[0]));
+      out->extra_server_count = extra_server_count;
+      out->addrs_per_server = (size_t)addrs_per_server;
+      out->cert_cache_ttl_ms = cert_cache_ttl_ms;
+      out->dns_stub_port = (uint16_t)dns_stub_port;
     } else {
       out->quic_cert_file = quic_cert_arg;
       out->quic_key_file = quic_key_arg;
+      memcpy(out->source_addrs, source_addrs,
+             source_addr_count * sizeof(source_addrs[0]));
+      out->source_addr_count = source_addr_count;
+      out->source_policy = source_policy < 0
+                               ? ODIN_DIAL_SOURCE_ROUND_ROBIN
+                               : (odin_dial_source_policy_t)source_policy;
     }
     status = is_client ? ODIN_CLI_OK_CLIENT : ODIN_CLI_OK_SERVER;
   }
@@ -292,28 +552,69 @@ int odin_cli_main(int argc, char *const *argv, FILE *out, FILE *err) {
   const odin_cli_status_t status = odin_cli_parse(argc, argv, &args);
 
   static const char kUC[] =
-      "usage: odin-client --listen ADDR --server ADDR --ca-file FILE";
+      "usage: odin-client --listen ADDR --server ADDR --ca-file FILE "
+      "[--extra-server ADDR]... [--addrs-per-server N] "
+      "[--transparent] [--frontend http|socks5|auto] [--route RULE]... "
+      "[--cert-cache-ttl-ms MS] [--dns-stub-port PORT] "
+      "[--access-log FILE] [--access-log-format text|jsonl] "
+      "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+      "[--qlog-max-bytes N] [--stats-interval-s N]";
   static const char kUS[] =
-      "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE";
+      "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+      "[--source-addr IP]... [--source-policy round-robin|least-used] "
+      "[--access-log FILE] [--access-log-format text|jsonl] "
+      "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+      "[--qlog-max-bytes N] [--stats-interval-s N]";
   static const char kUBoth[] =
-      "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE' or "
-      "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE'";
+      "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE "
+      "[OPTION]...' or "
+      "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+      "[OPTION]...'";
 
   int rc = 2;
   switch (status) {
   case ODIN_CLI_OK_CLIENT: {
     const odin_cli_client_config_t config = {
-        args.listen_port, args.server_host,  args.server_host_len,
-        args.server_port, args.quic_ca_file,
+        .listen_port = args.listen_port,
+        .server_host = args.server_host,
+        .server_host_len = args.server_host_len,
+        .server_port = args.server_port,
+        .quic_ca_file = args.quic_ca_file,
+        .route_rules = args.route_rules,
+        .route_rule_count = args.route_rule_count,
+        .extra_servers = args.extra_servers,
+        .extra_server_count = args.extra_server_count,
+        .addrs_per_server = args.addrs_per_server,
+        .transparent = args.transparent,
+        .frontend = args.frontend,
+        .cert_cache_ttl_ms = args.cert_cache_ttl_ms,
+        .dns_stub_port = args.dns_stub_port,
+        .access_log_path = args.access_log_path,
+        .access_log_format = args.access_log_format,
+        .qlog_path = args.qlog_path,
+        .qlog_sample_every = args.qlog_sample_every,
+        .qlog_force_ip = args.qlog_force_ip,
+        .qlog_max_bytes = args.qlog_max_bytes,
+        .stats_interval_s = args.stats_interval_s,
     };
     (void)fflush(out);
     return odin_cli_run_client(&config, err);
   }
   case ODIN_CLI_OK_SERVER: {
     const odin_cli_server_config_t config = {
-        args.listen_port,
-        args.quic_cert_file,
-        args.quic_key_file,
+        .listen_port = args.listen_port,
+        .quic_cert_file = args.quic_cert_file,
+        .quic_key_file = args.quic_key_file,
+        .source_addrs = args.source_addrs,
+        .source_addr_count = args.source_addr_count,
+        .source_policy = args.source_policy,
+        .access_log_path = args.access_log_path,
+        .access_log_format = args.access_log_format,
+        .qlog_path = args.qlog_path,
+        .qlog_sample_every = args.qlog_sample_every,
+        .qlog_force_ip = args.qlog_force_ip,
+        .qlog_max_bytes = args.qlog_max_bytes,
+        .stats_interval_s = args.stats_interval_s,
     };
     (void)fflush(out);
     rc = odin_cli_run_server(&config, err);
@@ -365,6 +666,12 @@ int odin_cli_main(int argc, char *const *argv, FILE *out, FILE *err) {
     (void)fputc('\n', err);
     rc = 2;
     break;
+  case ODIN_CLI_ERR_BAD_OPTION:
+    (void)fputs("odin: invalid option value\n", err);
+    (void)fputs(kUBoth, err);
+    (void)fputc('\n', err);
+    rc = 2;
+    break;
   }
 
   (void)fflush(out);
@@ -27,8 +27,8 @@
  *   - `--help` / `-h` wins after a valid basename, returning HELP_CLIENT or
  *     HELP_SERVER.
  *   - Long option names are accepted only when spelled exactly
- *     (`--listen`, `--server`, `--quic-cert`, `--quic-key`, `--help`);
- *     abbreviated unique prefixes
+ *     (`--listen`, `--server`, `--quic-cert`, `--quic-key`, `--help`, and
+ *     the optional flags below); abbreviated unique prefixes
  *     (e.g. `--lis`, `--he`) return ERR_UNKNOWN_FLAG.
  *   - `--listen` accepts a bare ASCII-decimal port string matching
  *     `[0-9]+` with value ≤ 65535 (no sign, no `0x`/`0o` prefix, no
@@ -40,10 +40,44 @@
  *     `[v6]:port` (RFC-007 §4.2.3). Empty value, structural malformation,
  *     bad port digits, or host length exceeding the protocol cap returns
  *     ERR_BAD_SERVER without writing the three server fields.
+ *   - Client `--route RULE` (RFC-038) may repeat up to
+ *     ODIN_CLI_ROUTE_RULES_MAX times; `route_rules` aliases the values in
+ *     argv order. The rule grammar is checked when the client compiles the
+ *     table, not here. An empty value or one rule too many returns
+ *     ERR_BAD_OPTION.
+ *   - Client `--extra-server ADDR` (RFC-039) takes the `--server` shapes
+ *     and may repeat up to ODIN_CLI_EXTRA_SERVERS_MAX times; each host
+ *     aliases argv like `server_host`. `--addrs-per-server N` takes a
+ *     decimal N in [1, ODIN_UPSTREAM_SET_MAX]. A malformed ADDR, one
+ *     server too many, or a bad N returns ERR_BAD_OPTION.
+ *   - Client `--transparent` (RFC-040) takes no value and sets
+ *     `transparent` to 1; `--transparent=VALUE` returns ERR_UNKNOWN_FLAG.
+ *   - Client `--frontend http|socks5|auto` (RFC-041) picks the listener
+ *     protocol; it defaults to http. Any other value returns ERR_BAD_OPTION.
+ *   - Client `--cert-cache-ttl-ms MS` (RFC-042) takes a decimal MS in
+ *     [1, UINT64_MAX]; omitting it keeps the default hour. 0 or any other
+ *     value returns ERR_BAD_OPTION.
+ *   - Client `--dns-stub-port PORT` (RFC-045) takes a decimal PORT in
+ *     [1, 65535] and turns the local DNS stub on; 0 or any other value
+ *     returns ERR_BAD_OPTION.
+ *   - Both modes take `--access-log FILE` and
+ *     `--access-log-format text|jsonl` (RFC-049). FILE must be non-empty;
+ *     the format defaults to text and is ignored without a FILE. An empty
+ *     FILE or an unknown format returns ERR_BAD_OPTION.
+ *   - Both modes take `--qlog FILE`, `--qlog-sample N`,
+ *     `--qlog-force-ip IP`, and `--qlog-max-bytes N` (RFC-050). FILE and IP
+ *     must be non-empty and alias argv; IP is checked by the runner. N is
+ *     decimal: [0, UINT32_MAX] for the sample rate, [1, UINT64_MAX] for the
+ *     size cap. Anything else returns ERR_BAD_OPTION.
+ *   - Both modes take `--stats-interval-s N` (RFC-051): every N seconds the
+ *     runner writes one "odin: stats ..." line of QUIC runtime totals to
+ *     err. N is decimal in [0, ODIN_CLI_STATS_INTERVAL_MAX_S]; 0, the
+ *     default, logs nothing. Anything else returns ERR_BAD_OPTION.
  *   - Status precedence within a valid basename (highest wins): HELP_*,
  *     ERR_UNKNOWN_FLAG, ERR_BAD_LISTEN_PORT, ERR_BAD_SERVER,
- *     ERR_MISSING_REQUIRED, OK_*. ERR_UNKNOWN_MODE precedes any of these
- *     because it fires before any flag parsing.
+ *     ERR_MISSING_REQUIRED, ERR_BAD_QUIC_TLS, ERR_BAD_OPTION, OK_*.
+ *     Optional-flag fields are written only on OK_*. ERR_UNKNOWN_MODE
+ *     precedes any of these because it fires before any flag parsing.
  *   - Unknown options, missing option arguments, and stray positional
  *     operands return ERR_UNKNOWN_FLAG before the missing-required,
  *     bad-listen-port, and bad-server checks (precedence is
@@ -59,6 +93,12 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/socket.h>
+
+#include "odin/access_log.h"
+#include "odin/cli_client.h"
+#include "odin/client_session.h"
+#include "odin/dial.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,6 +106,10 @@ extern "C" {
 
 #define ODIN_CLI_DEFAULT_LISTEN_PORT_CLIENT 8080
 #define ODIN_CLI_DEFAULT_LISTEN_PORT_SERVER 4433
+#define ODIN_CLI_ROUTE_RULES_MAX 256u /* == ODIN_ROUTE_RULES_MAX */
+#define ODIN_CLI_EXTRA_SERVERS_MAX 7u /* == ODIN_UPSTREAM_SET_MAX - 1 */
+#define ODIN_CLI_SOURCE_ADDRS_MAX 16u /* == ODIN_DIAL_SOURCE_POOL_MAX */
+#define ODIN_CLI_STATS_INTERVAL_MAX_S 86400u
 
 typedef enum odin_cli_status_t {
   ODIN_CLI_OK_CLIENT = 0,
@@ -78,6 +122,7 @@ typedef enum odin_cli_status_t {
   ODIN_CLI_ERR_BAD_LISTEN_PORT,
   ODIN_CLI_ERR_BAD_SERVER,
   ODIN_CLI_ERR_BAD_QUIC_TLS,
+  ODIN_CLI_ERR_BAD_OPTION,
 } odin_cli_status_t;
 
 typedef struct odin_cli_args_t {
@@ -88,6 +133,25 @@ typedef struct odin_cli_args_t {
   const char *quic_cert_file;
   const char *quic_key_file;
   const char *quic_ca_file;
+  struct sockaddr_storage source_addrs[ODIN_CLI_SOURCE_ADDRS_MAX];
+  size_t source_addr_count;
+  odin_dial_source_policy_t source_policy;
+  const char *route_rules[ODIN_CLI_ROUTE_RULES_MAX];
+  size_t route_rule_count;
+  odin_cli_client_server_t extra_servers[ODIN_CLI_EXTRA_SERVERS_MAX];
+  size_t extra_server_count;
+  size_t addrs_per_server;
+  int transparent;
+  odin_client_session_frontend_t frontend;
+  uint64_t cert_cache_ttl_ms;
+  uint16_t dns_stub_port;
+  const char *access_log_path;
+  odin_access_log_format_t access_log_format;
+  const char *qlog_path;
+  uint32_t qlog_sample_every;
+  const char *qlog_force_ip;
+  uint64_t qlog_max_bytes;
+  uint32_t stats_interval_s; /* 0: no periodic stats line */
 } odin_cli_args_t;
 
 odin_cli_status_t odin_cli_parse(int argc, char *const *argv,
@@ -12,13 +12,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "odin/accept_loop.h"
+#include "odin/access_log.h"
+#include "odin/cert_cache.h"
+#include "odin/client_direct.h"
 #include "odin/client_xqc_runtime.h"
 #include "odin/dns_resolver.h"
+#include "odin/dns_stub.h"
+#include "odin/dns_tunnel.h"
 #include "odin/event_loop.h"
+#include "odin/original_dst.h"
 #include "odin/protocol.h"
+#include "odin/qlog.h"
+#include "odin/route.h"
+#include "odin/upstream_set.h"
+#include "odin/xqc_conn_stats.h"
 
 #if defined(ODIN_CLI_CLIENT_TESTING)
 #include "odin/testing/accept_loop_internal_test.h"
@@ -28,13 +39,28 @@
 #endif
 
 #define ODIN_CLI_CLIENT_SIGNAL_POLL_INTERVAL_US 50000u
+#define ODIN_CLI_CLIENT_UPSTREAM_PROBE_INTERVAL_US 500000u
 
 typedef struct cli_client_state_t cli_client_state_t;
 
+/* One RFC-039 upstream server. Slot 0 mirrors the primary endpoint; its
+ * runtime stays in cli_client_state_t.quic_rt. */
+typedef struct cli_client_upstream_t {
+  odin_xqc_client_runtime_t *rt;
+  char host[ODIN_PROTO_HOST_MAX + 1];
+  struct sockaddr_storage peer;
+  socklen_t peer_len;
+  struct sockaddr_storage local;
+  socklen_t local_len;
+} cli_client_upstream_t;
+
 struct cli_client_state_t {
   int listen_fd;
   int test_wakeup_fd;
   uint16_t actual_port;
+  int transparent;                         /* RFC-040 */
+  odin_client_session_frontend_t frontend; /* RFC-041 */
+  struct sockaddr_in listen_addr;          /* as bound; the ELOOP reference */
   const char *server_host;
   size_t server_host_len;
   char server_host_cstr[ODIN_PROTO_HOST_MAX + 1];
@@ -51,7 +77,22 @@ struct cli_client_state_t {
   socklen_t local_udp_len;
   odin_accept_loop_t *accept_loop;
   odin_xqc_client_runtime_t *quic_rt;
+  odin_route_table_t *route_table;
+  odin_dns_resolver_t *route_resolver;
+  odin_client_direct_t *route_direct;
+  const char *quic_ca_file;
+  odin_cert_cache_t *cert_cache;
+  size_t addrs_per_server;
+  const odin_cli_client_server_t *resolving_server;
+  cli_client_upstream_t upstreams[ODIN_UPSTREAM_SET_MAX];
+  size_t upstream_count;
+  odin_upstream_set_t *upstream_set;
+  odin_event_timer_t *upstream_timer;
   odin_event_timer_t *signal_timer;
+  odin_event_timer_t *stats_timer; /* RFC-051; NULL: no stats line */
+  FILE *stats_err;
+  /* Counts of upstream runtimes already replaced by a reconnect. */
+  odin_xqc_runtime_totals_t retired_totals;
   int sigint_replaced;
   int sigterm_replaced;
   struct sigaction old_sigint;
@@ -59,6 +100,14 @@ struct cli_client_state_t {
   int accept_loop_error_seen;
   int accept_loop_errno;
   int shutdown_requested;
+  odin_dns_tunnel_client_t *dns_tunnel; /* RFC-045; NULL when off */
+  odin_dns_stub_t *dns_stub;
+  int dns_udp_fd;
+  int dns_tcp_fd;
+  int access_log_fd; /* RFC-049; -1 when off */
+  odin_access_log_t *access_log;
+  odin_access_log_ring_t *access_ring;
+  odin_qlog_t *qlog; /* RFC-050; each runtime owns its ring */
 };
 
 static volatile sig_atomic_t g_odin_cli_client_signal_seen;
@@ -83,6 +132,8 @@ static int g_last_xqc_add_recorded;
 static odin_cli_client_test_xqc_add_record_t g_last_xqc_add;
 static int g_last_runtime_config_recorded;
 static odin_cli_client_test_runtime_config_record_t g_last_runtime_config;
+static int g_last_cert_cache_ttl_recorded;
+static uint64_t g_last_cert_cache_ttl_ms;
 static int g_progress_fd = -1;
 static size_t g_progress_min_inflight_sessions;
 static int g_progress_reported;
@@ -198,40 +249,73 @@ static void cli_client_test_record_dns_liveness(size_t *resolvers,
 }
 #endif
 
-static int dns_select_addr(cli_client_state_t *state,
-                           const odin_dns_addr_t *addr) {
+/* Fills peer (with port) and the matching wildcard local UDP address from a
+ * resolved address; returns 1, or 0 for an unusable family. */
+static int fill_endpoint(const odin_dns_addr_t *addr, uint16_t port,
+                         struct sockaddr_storage *peer_out,
+                         socklen_t *peer_len,
+                         struct sockaddr_storage *local_out,
+                         socklen_t *local_len) {
   if (addr->addr.ss_family == AF_INET &&
       addr->addrlen == (socklen_t)sizeof(struct sockaddr_in)) {
-    memcpy(&state->resolved_peer, &addr->addr, sizeof(struct sockaddr_in));
-    state->resolved_peer_len = (socklen_t)sizeof(struct sockaddr_in);
-    struct sockaddr_in *peer = (struct sockaddr_in *)&state->resolved_peer;
-    peer->sin_port = htons(state->server_port);
+    memcpy(peer_out, &addr->addr, sizeof(struct sockaddr_in));
+    *peer_len = (socklen_t)sizeof(struct sockaddr_in);
+    struct sockaddr_in *peer = (struct sockaddr_in *)peer_out;
+    peer->sin_port = htons(port);
 
-    memset(&state->local_udp, 0, sizeof(state->local_udp));
-    struct sockaddr_in *local = (struct sockaddr_in *)&state->local_udp;
+    memset(local_out, 0, sizeof(*local_out));
+    struct sockaddr_in *local = (struct sockaddr_in *)local_out;
     local->sin_family = AF_INET;
     local->sin_addr.s_addr = htonl(INADDR_ANY);
     local->sin_port = htons(0);
-    state->local_udp_len = (socklen_t)sizeof(struct sockaddr_in);
+    *local_len = (socklen_t)sizeof(struct sockaddr_in);
     return 1;
   }
   if (addr->addr.ss_family == AF_INET6 &&
       addr->addrlen == (socklen_t)sizeof(struct sockaddr_in6)) {
-    memcpy(&state->resolved_peer, &addr->addr, sizeof(struct sockaddr_in6));
-    state->resolved_peer_len = (socklen_t)sizeof(struct sockaddr_in6);
-    struct sockaddr_in6 *peer = (struct sockaddr_in6 *)&state->resolved_peer;
-    peer->sin6_port = htons(state->server_port);
+    memcpy(peer_out, &addr->addr, sizeof(struct sockaddr_in6));
+    *peer_len = (socklen_t)sizeof(struct sockaddr_in6);
+    struct sockaddr_in6 *peer = (struct sockaddr_in6 *)peer_out;
+    peer->sin6_port = htons(port);
 
-    memset(&state->local_udp, 0, sizeof(state->local_udp));
-    struct sockaddr_in6 *local = (struct sockaddr_in6 *)&state->local_udp;
+    memset(local_out, 0, sizeof(*local_out));
+    struct sockaddr_in6 *local = (struct sockaddr_in6 *)local_out;
     local->sin6_family = AF_INET6;
     local->sin6_port = htons(0);
-    state->local_udp_len = (socklen_t)sizeof(struct sockaddr_in6);
+    *local_len = (socklen_t)sizeof(struct sockaddr_in6);
     return 1;
   }
   return 0;
 }
 
+static int dns_select_addr(cli_client_state_t *state,
+                           const odin_dns_addr_t *addr) {
+  return fill_endpoint(addr, state->server_port, &state->resolved_peer,
+                       &state->resolved_peer_len, &state->local_udp,
+                       &state->local_udp_len);
+}
+
+/* Appends up to want usable addresses of host (at most ODIN_PROTO_HOST_MAX
+ * bytes) as upstream slots; returns how many it appended. */
+static size_t append_upstreams(cli_client_state_t *state, const char *host,
+                               uint16_t port, const odin_dns_addr_t *addrs,
+                               size_t addr_count, size_t want) {
+  size_t added = 0;
+  for (size_t i = 0; i < addr_count && added < want &&
+                     state->upstream_count < ODIN_UPSTREAM_SET_MAX;
+       ++i) {
+    cli_client_upstream_t *u = &state->upstreams[state->upstream_count];
+    if (!fill_endpoint(&addrs[i], port, &u->peer, &u->peer_len, &u->local,
+                       &u->local_len)) {
+      continue;
+    }
+    memcpy(u->host, host, strlen(host) + 1u);
+    state->upstream_count += 1;
+    added += 1;
+  }
+  return added;
+}
+
 #if defined(ODIN_CLI_CLIENT_TESTING)
 static void dns_event_loop_stop_task(odin_event_loop_t *loop, void *user_data) {
   (void)user_data;
@@ -255,6 +339,11 @@ static void dns_on_done(odin_dns_query_t *query, odin_dns_status_t status,
         break;
       }
     }
+    if (state->dns_success && state->addrs_per_server > 1) {
+      (void)append_upstreams(state, state->server_host_cstr,
+                             state->server_port, addrs, addr_count,
+                             state->addrs_per_server);
+    }
   }
   odin_dns_query_destroy(query);
   state->dns_query = NULL;
@@ -410,8 +499,12 @@ static int quic_runtime_start_call(odin_xqc_client_runtime_t *rt) {
   return odin_xqc_client_runtime_start(rt);
 }
 
+/* dst == NULL: an HTTP CONNECT connection, or an RFC-045 DNS stream when dns
+ * is set; else a redirected one (RFC-040). */
 static int quic_runtime_add_connection_call(odin_xqc_client_runtime_t *rt,
-                                            int conn_fd) {
+                                            int conn_fd,
+                                            const struct sockaddr *dst,
+                                            socklen_t dst_len, int dns) {
 #if defined(ODIN_CLI_CLIENT_TESTING)
   memset(&g_last_xqc_add, 0, sizeof(g_last_xqc_add));
   g_last_xqc_add.fd = conn_fd;
@@ -431,6 +524,13 @@ static int quic_runtime_add_connection_call(odin_xqc_client_runtime_t *rt,
     return -1;
   }
 #endif
+  if (dst != NULL) {
+    return odin_xqc_client_runtime_add_transparent_connection(rt, conn_fd, dst,
+                                                              dst_len);
+  }
+  if (dns) {
+    return odin_xqc_client_runtime_add_dns_connection(rt, conn_fd);
+  }
   return odin_xqc_client_runtime_add_connection(rt, conn_fd);
 }
 
@@ -489,6 +589,18 @@ static const char *install_signal_handlers(cli_client_state_t *state) {
 
 static void cleanup_all(cli_client_state_t *state) {
   cleanup_dns(state);
+  odin_dns_stub_destroy(state->dns_stub);
+  state->dns_stub = NULL;
+  odin_dns_tunnel_client_destroy(state->dns_tunnel);
+  state->dns_tunnel = NULL;
+  if (state->dns_udp_fd >= 0) {
+    (void)close(state->dns_udp_fd);
+    state->dns_udp_fd = -1;
+  }
+  if (state->dns_tcp_fd >= 0) {
+    (void)close(state->dns_tcp_fd);
+    state->dns_tcp_fd = -1;
+  }
   if (state->accept_loop != NULL) {
     odin_accept_loop_destroy(state->accept_loop);
     state->accept_loop = NULL;
@@ -502,10 +614,34 @@ static void cleanup_all(cli_client_state_t *state) {
     odin_event_timer_stop(state->signal_timer);
     state->signal_timer = NULL;
   }
+  if (state->stats_timer != NULL) {
+    odin_event_timer_stop(state->stats_timer);
+    state->stats_timer = NULL;
+  }
+  if (state->upstream_timer != NULL) {
+    odin_event_timer_stop(state->upstream_timer);
+    state->upstream_timer = NULL;
+  }
   if (state->quic_rt != NULL) {
     quic_runtime_force_destroy_call(state->quic_rt);
     state->quic_rt = NULL;
   }
+  for (size_t i = 1; i < state->upstream_count; ++i) {
+    if (state->upstreams[i].rt != NULL) {
+      quic_runtime_force_destroy_call(state->upstreams[i].rt);
+      state->upstreams[i].rt = NULL;
+    }
+  }
+  odin_upstream_set_destroy(state->upstream_set);
+  state->upstream_set = NULL;
+  odin_cert_cache_destroy(state->cert_cache);
+  state->cert_cache = NULL;
+  odin_client_direct_destroy(state->route_direct);
+  state->route_direct = NULL;
+  odin_dns_resolver_destroy(state->route_resolver);
+  state->route_resolver = NULL;
+  odin_route_table_destroy(state->route_table);
+  state->route_table = NULL;
   if (state->loop != NULL) {
     odin_event_loop_destroy(state->loop);
     state->loop = NULL;
@@ -523,9 +659,330 @@ static void cleanup_all(cli_client_state_t *state) {
     }
 #endif
   }
+  /* The sessions are gone, so the ring has its last record. */
+  odin_access_log_ring_destroy(state->access_ring);
+  state->access_ring = NULL;
+  odin_access_log_destroy(state->access_log);
+  state->access_log = NULL;
+  if (state->access_log_fd >= 0) {
+    (void)close(state->access_log_fd);
+    state->access_log_fd = -1;
+  }
+  /* Every runtime destroyed its ring with its engine. */
+  odin_qlog_destroy(state->qlog);
+  state->qlog = NULL;
   restore_signal_handlers(state);
 }
 
+/* Opens the RFC-049 access log and the loop's ring; returns the failed
+ * startup step, or NULL. */
+static const char *start_access_log(cli_client_state_t *state,
+                                    const odin_cli_client_config_t *config) {
+  if (config->access_log_path == NULL || config->access_log_path[0] == '\0') {
+    return NULL;
+  }
+  state->access_log_fd =
+      open(config->access_log_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+           0644);
+  if (state->access_log_fd < 0) {
+    return "access_log_open";
+  }
+  odin_access_log_config_t log_config;
+  memset(&log_config, 0, sizeof(log_config));
+  log_config.fd = state->access_log_fd;
+  log_config.format = config->access_log_format;
+  if (odin_access_log_create(&log_config, &state->access_log) != 0 ||
+      odin_access_log_ring_create(state->access_log, 0, &state->access_ring) !=
+          0) {
+    return "access_log_create";
+  }
+  return NULL;
+}
+
+/* Creates the RFC-050 qlog that every upstream runtime traces into; returns
+ * the failed startup step, or NULL. */
+static const char *start_qlog(cli_client_state_t *state,
+                              const odin_cli_client_config_t *config) {
+  if (config->qlog_path == NULL || config->qlog_path[0] == '\0') {
+    return NULL;
+  }
+  odin_qlog_config_t qlog_config;
+  memset(&qlog_config, 0, sizeof(qlog_config));
+  qlog_config.path = config->qlog_path;
+  qlog_config.max_bytes = config->qlog_max_bytes;
+  qlog_config.sample_every = config->qlog_sample_every;
+  qlog_config.vantage = ODIN_QLOG_CLIENT;
+  struct sockaddr_storage force;
+  socklen_t force_len = 0;
+  if (config->qlog_force_ip != NULL && config->qlog_force_ip[0] != '\0') {
+    if (odin_qlog_parse_ip(config->qlog_force_ip, &force, &force_len) != 0) {
+      return "qlog_config";
+    }
+    qlog_config.force_addr = (const struct sockaddr *)&force;
+    qlog_config.force_addr_len = force_len;
+  }
+  if (odin_qlog_create(&qlog_config, &state->qlog) != 0) {
+    return "qlog_create";
+  }
+  return NULL;
+}
+
+/* Lends rt the session options every upstream shares: the RFC-041 frontend,
+ * the RFC-049 access-log ring, and, once compiled, the RFC-038 route. */
+static void apply_session_options(const cli_client_state_t *state,
+                                  odin_xqc_client_runtime_t *rt) {
+  odin_xqc_client_runtime_set_frontend(rt, state->frontend);
+#if defined(ODIN_CLI_CLIENT_TESTING)
+  g_last_runtime_config.frontend = state->frontend;
+#endif
+  odin_xqc_client_runtime_set_access_log(rt, state->access_ring);
+  if (state->route_table == NULL) {
+    return;
+  }
+  const odin_client_session_route_t route = {
+      state->route_table, odin_client_direct_start, odin_client_direct_cancel,
+      state->route_direct};
+  odin_xqc_client_runtime_set_route(rt, &route);
+}
+
+/* Compiles the RFC-038 rules and lends the table and a direct connector to
+ * the runtime; returns the failed startup step, or NULL. */
+static const char *start_split_routing(cli_client_state_t *state,
+                                       const odin_cli_client_config_t *config) {
+  if (config->route_rule_count == 0) {
+    return NULL;
+  }
+  if (odin_route_table_create(config->route_rules, config->route_rule_count,
+                              NULL, &state->route_table) != 0) {
+    return "route_compile";
+  }
+  if (odin_dns_resolver_create(state->loop, NULL, &state->route_resolver) !=
+      0) {
+    return "route_dns";
+  }
+  if (odin_client_direct_create(state->loop, state->route_resolver,
+                                &state->route_direct) != 0) {
+    return "route_direct";
+  }
+  apply_session_options(state, state->quic_rt);
+  return NULL;
+}
+
+static uint64_t monotonic_ms(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static odin_xqc_client_runtime_t **upstream_rt_slot(cli_client_state_t *state,
+                                                    size_t index) {
+  return index == 0 ? &state->quic_rt : &state->upstreams[index].rt;
+}
+
+/* Creates and starts upstream index's runtime into its slot. */
+static int start_upstream_runtime(cli_client_state_t *state, size_t index) {
+  cli_client_upstream_t *u = &state->upstreams[index];
+  odin_xqc_client_runtime_t **slot = upstream_rt_slot(state, index);
+  odin_xqc_client_runtime_default_config_t runtime_config;
+  memset(&runtime_config, 0, sizeof(runtime_config));
+  runtime_config.loop = state->loop;
+  runtime_config.local_addr = (const struct sockaddr *)&u->local;
+  runtime_config.local_addrlen = u->local_len;
+  runtime_config.peer_addr = (const struct sockaddr *)&u->peer;
+  runtime_config.peer_addrlen = u->peer_len;
+  runtime_config.server_host = u->host;
+  runtime_config.ca_file = state->quic_ca_file;
+  runtime_config.cert_cache = state->cert_cache;
+  runtime_config.qlog = state->qlog;
+  if (quic_runtime_create_default_call(&runtime_config, slot) != 0) {
+    *slot = NULL;
+    return -1;
+  }
+  if (quic_runtime_start_call(*slot) != 0) {
+    quic_runtime_force_destroy_call(*slot);
+    *slot = NULL;
+    return -1;
+  }
+  apply_session_options(state, *slot);
+  return 0;
+}
+
+/* Hands conn_fd to the best upstream, marking refusing ones down. */
+static int add_to_best_upstream(cli_client_state_t *state, int conn_fd,
+                                const struct sockaddr *dst, socklen_t dst_len,
+                                int dns) {
+  for (size_t tries = 0; tries < state->upstream_count; ++tries) {
+    const int i = odin_upstream_set_pick(state->upstream_set);
+    if (i < 0) {
+      break;
+    }
+    odin_xqc_client_runtime_t *rt = *upstream_rt_slot(state, (size_t)i);
+    if (rt != NULL &&
+        quic_runtime_add_connection_call(rt, conn_fd, dst, dst_len, dns) == 0) {
+      return 0;
+    }
+    if (rt != NULL && errno != ENOTCONN) {
+      return -1;
+    }
+    odin_upstream_set_mark_down(state->upstream_set, (size_t)i,
+                                monotonic_ms());
+  }
+  errno = EHOSTUNREACH;
+  return -1;
+}
+
+/* Keeps a replaced runtime's counts in the RFC-051 stats line; its
+ * connection is gone, so nothing of it stays active. */
+static void retire_upstream_totals(cli_client_state_t *state,
+                                   const odin_xqc_client_runtime_t *rt) {
+  odin_xqc_runtime_totals_t t;
+  if (odin_xqc_client_runtime_totals(rt, &t) != 0) {
+    return;
+  }
+  t.conns_active = 0;
+  t.streams_active = 0;
+  t.srtt_us_max = 0;
+  odin_xqc_runtime_totals_merge(&state->retired_totals, &t);
+}
+
+/* Samples every upstream's connection, retires dead ones, and reconnects
+ * those whose backoff has expired. */
+static void upstream_probe_timer(odin_event_loop_t *loop,
+                                 odin_event_timer_t *timer, void *user_data) {
+  (void)loop;
+  (void)timer;
+  cli_client_state_t *state = (cli_client_state_t *)user_data;
+  const uint64_t now = monotonic_ms();
+  for (size_t i = 0; i < state->upstream_count; ++i) {
+    odin_xqc_client_runtime_t **slot = upstream_rt_slot(state, i);
+    odin_xqc_client_runtime_health_t st;
+    st.state = ODIN_XQC_CLIENT_RUNTIME_CLOSED;
+    if (*slot != NULL) {
+      (void)odin_xqc_client_runtime_health(*slot, &st);
+    }
+    if (st.state == ODIN_XQC_CLIENT_RUNTIME_READY) {
+      odin_upstream_set_observe(state->upstream_set, i, st.srtt_us, st.sent,
+                                st.lost);
+      continue;
+    }
+    if (st.state == ODIN_XQC_CLIENT_RUNTIME_CONNECTING) {
+      continue;
+    }
+    odin_upstream_info_t info;
+    (void)odin_upstream_set_info(state->upstream_set, i, &info);
+    if (info.state != ODIN_UPSTREAM_DOWN) {
+      odin_upstream_set_mark_down(state->upstream_set, i, now);
+      continue;
+    }
+    if (!odin_upstream_set_retry_due(state->upstream_set, i, now)) {
+      continue;
+    }
+    if (*slot != NULL) {
+      retire_upstream_totals(state, *slot);
+      quic_runtime_force_destroy_call(*slot);
+      *slot = NULL;
+    }
+    if (start_upstream_runtime(state, i) == 0) {
+      odin_upstream_set_mark_connecting(state->upstream_set, i);
+    } else {
+      odin_upstream_set_mark_down(state->upstream_set, i, now);
+    }
+  }
+}
+
+static void extra_dns_on_done(odin_dns_query_t *query,
+                              odin_dns_status_t status, int err,
+                              const odin_dns_addr_t *addrs, size_t addr_count,
+                              void *user_data) {
+  (void)err;
+  cli_client_state_t *state = (cli_client_state_t *)user_data;
+  state->dns_done = 1;
+  if (status == ODIN_DNS_OK && addrs != NULL) {
+    const odin_cli_client_server_t *srv = state->resolving_server;
+    char host[ODIN_PROTO_HOST_MAX + 1];
+    memcpy(host, srv->host, srv->host_len);
+    host[srv->host_len] = '\0';
+    const size_t want =
+        state->addrs_per_server > 1 ? state->addrs_per_server : 1u;
+    state->dns_success =
+        append_upstreams(state, host, srv->port, addrs, addr_count, want) > 0;
+  }
+  odin_dns_query_destroy(query);
+  state->dns_query = NULL;
+  odin_event_loop_stop(state->loop);
+}
+
+/* Resolves one extra server on the loop, appending its addresses. */
+static int resolve_extra_server(cli_client_state_t *state,
+                                const odin_cli_client_server_t *srv) {
+  if (srv->host == NULL || srv->host_len == 0 ||
+      srv->host_len > ODIN_PROTO_HOST_MAX ||
+      memchr(srv->host, '\0', srv->host_len) != NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  state->resolving_server = srv;
+  state->dns_done = 0;
+  state->dns_success = 0;
+  int rc = -1;
+  if (odin_dns_resolver_create(state->loop, NULL, &state->dns_resolver) == 0 &&
+      odin_dns_resolve_start(state->dns_resolver, srv->host, srv->host_len,
+                             srv->port, AF_UNSPEC, extra_dns_on_done, state,
+                             &state->dns_query) == 0 &&
+      odin_event_loop_run(state->loop) == 0 && state->dns_done &&
+      state->dns_success) {
+    rc = 0;
+  }
+  cleanup_dns(state);
+  state->resolving_server = NULL;
+  return rc;
+}
+
+/* RFC-039: with more than one upstream configured or resolved, starts a
+ * runtime per extra server and the probe timer that scores them; returns the
+ * failed startup step, or NULL. */
+static const char *start_upstreams(cli_client_state_t *state,
+                                   const odin_cli_client_config_t *config) {
+  if (state->upstream_count == 0) {
+    cli_client_upstream_t *u = &state->upstreams[0];
+    memcpy(u->host, state->server_host_cstr,
+           strlen(state->server_host_cstr) + 1u);
+    u->peer = state->resolved_peer;
+    u->peer_len = state->resolved_peer_len;
+    u->local = state->local_udp;
+    u->local_len = state->local_udp_len;
+    state->upstream_count = 1;
+  }
+  for (size_t i = 0; i < config->extra_server_count; ++i) {
+    if (config->extra_servers == NULL ||
+        resolve_extra_server(state, &config->extra_servers[i]) != 0) {
+      return "upstream_dns";
+    }
+  }
+  if (state->upstream_count < 2) {
+    return NULL;
+  }
+  if (odin_upstream_set_create(state->upstream_count, &state->upstream_set) !=
+      0) {
+    return "upstream_set";
+  }
+  for (size_t i = 1; i < state->upstream_count; ++i) {
+    if (start_upstream_runtime(state, i) != 0) {
+      odin_upstream_set_mark_down(state->upstream_set, i, monotonic_ms());
+    }
+  }
+  if (odin_event_timer_start(state->loop,
+                             ODIN_CLI_CLIENT_UPSTREAM_PROBE_INTERVAL_US,
+                             ODIN_CLI_CLIENT_UPSTREAM_PROBE_INTERVAL_US,
+                             upstream_probe_timer, state,
+                             &state->upstream_timer) != 0) {
+    return "upstream_probe_timer";
+  }
+  return NULL;
+}
+
 static int startup_fail(cli_client_state_t *state, FILE *err,
                         const char *step) {
   if (err != NULL) {
@@ -541,11 +998,65 @@ static void cli_client_quic_on_accept(odin_accept_loop_t *al, int conn_fd,
                                       void *user_data) {
   (void)al;
   cli_client_state_t *state = (cli_client_state_t *)user_data;
-  if (quic_runtime_add_connection_call(state->quic_rt, conn_fd) != 0) {
+  odin_xqc_client_runtime_t *rt = state->quic_rt;
+  struct sockaddr_storage dst;
+  socklen_t dst_len = 0;
+  if (state->transparent &&
+      odin_original_dst_get(conn_fd,
+                            (const struct sockaddr *)&state->listen_addr,
+                            sizeof(state->listen_addr), &dst, &dst_len) != 0) {
+    (void)close(conn_fd);
+    return;
+  }
+  const struct sockaddr *dst_arg =
+      state->transparent ? (const struct sockaddr *)&dst : NULL;
+  if (state->upstream_set != NULL) {
+    if (add_to_best_upstream(state, conn_fd, dst_arg, dst_len, 0) != 0) {
+      (void)close(conn_fd);
+    }
+    return;
+  }
+  if (quic_runtime_add_connection_call(rt, conn_fd, dst_arg, dst_len, 0) != 0) {
     (void)close(conn_fd);
   }
 }
 
+/* RFC-045 open_stream: the tunnel client's end of a DNS stream goes to an
+ * upstream like any accepted connection; on -1 the tunnel keeps the fd. */
+static int cli_client_dns_open_stream(int fd, void *user_data) {
+  cli_client_state_t *state = (cli_client_state_t *)user_data;
+  if (state->upstream_set != NULL) {
+    return add_to_best_upstream(state, fd, NULL, 0, 1);
+  }
+  return quic_runtime_add_connection_call(state->quic_rt, fd, NULL, 0, 1);
+}
+
+/* Starts the RFC-045 local DNS stub on 127.0.0.1:port; returns the failed
+ * startup step, or NULL. */
+static const char *start_dns_stub(cli_client_state_t *state, uint16_t port) {
+  if (port == 0) {
+    return NULL;
+  }
+  odin_dns_tunnel_client_config_t dns_config;
+  memset(&dns_config, 0, sizeof(dns_config));
+  dns_config.loop = state->loop;
+  dns_config.open_stream = cli_client_dns_open_stream;
+  dns_config.open_user_data = state;
+  if (odin_dns_tunnel_client_create(&dns_config, &state->dns_tunnel) != 0) {
+    return "dns_tunnel";
+  }
+  if (odin_dns_stub_open(port, &state->dns_udp_fd, &state->dns_tcp_fd) != 0) {
+    state->dns_udp_fd = -1;
+    state->dns_tcp_fd = -1;
+    return "dns_stub_bind";
+  }
+  if (odin_dns_stub_create(state->loop, state->dns_tunnel, state->dns_udp_fd,
+                           state->dns_tcp_fd, &state->dns_stub) != 0) {
+    return "dns_stub";
+  }
+  return NULL;
+}
+
 static void cli_client_on_accept_loop_error(odin_accept_loop_t *al, int err,
                                             void *user_data) {
   (void)al;
@@ -701,14 +1212,76 @@ static void cli_client_signal_poll_timer(odin_event_loop_t *loop,
   odin_event_loop_stop(loop);
 }
 
+/* RFC-051: one line of totals over every upstream runtime, live and
+ * replaced, plus the shared RFC-042 certificate cache, the RFC-046 loop
+ * timings, and, with --route, the RFC-038 decisions, per --stats-interval-s. */
+static void cli_client_stats_timer(odin_event_loop_t *loop,
+                                   odin_event_timer_t *timer,
+                                   void *user_data) {
+  (void)loop;
+  (void)timer;
+  cli_client_state_t *state = (cli_client_state_t *)user_data;
+  odin_xqc_runtime_totals_t totals = state->retired_totals;
+  for (size_t i = 0; i < state->upstream_count; ++i) {
+    const odin_xqc_client_runtime_t *rt = *upstream_rt_slot(state, i);
+    odin_xqc_runtime_totals_t t;
+    if (rt != NULL && odin_xqc_client_runtime_totals(rt, &t) == 0) {
+      odin_xqc_runtime_totals_merge(&totals, &t);
+    }
+  }
+  char line[256];
+  (void)odin_xqc_runtime_totals_format(&totals, line, sizeof(line));
+  odin_cert_cache_stats_t cert;
+  odin_cert_cache_stats(state->cert_cache, &cert);
+  char cert_line[128];
+  (void)odin_cert_cache_stats_format(&cert, cert_line, sizeof(cert_line));
+  odin_event_loop_stats_t loop_stats;
+  odin_event_loop_stats(state->loop, &loop_stats);
+  char loop_line[160];
+  (void)odin_event_loop_stats_format(&loop_stats, loop_line, sizeof(loop_line));
+  char route_line[80];
+  route_line[0] = '\0';
+  if (state->route_table != NULL) {
+    odin_route_stats_t route;
+    odin_route_stats(state->route_table, &route);
+    route_line[0] = ' ';
+    (void)odin_route_stats_format(&route, route_line + 1,
+                                  sizeof(route_line) - 1u);
+  }
+  // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
+  (void)fprintf(state->stats_err, "odin: stats %s %s %s%s\n", line, cert_line,
+                loop_line, route_line);
+  (void)fflush(state->stats_err);
+}
+
+/* RFC-046: at most one slow callback per --stats-interval-s. */
+static void cli_client_slow_report(odin_event_loop_t *loop,
+                                   const odin_event_loop_slow_report_t *report,
+                                   void *user_data) {
+  (void)loop;
+  cli_client_state_t *state = (cli_client_state_t *)user_data;
+  char line[ODIN_EVENT_LOOP_SYMBOL_MAX + 96];
+  (void)odin_event_loop_slow_report_format(report, line, sizeof(line));
+  // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
+  (void)fprintf(state->stats_err, "odin: slow %s\n", line);
+  (void)fflush(state->stats_err);
+}
+
 static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   cli_client_state_t state;
   memset(&state, 0, sizeof(state));
   state.listen_fd = -1;
   state.test_wakeup_fd = -1;
+  state.dns_udp_fd = -1;
+  state.dns_tcp_fd = -1;
+  state.access_log_fd = -1;
   state.server_host = config->server_host;
   state.server_host_len = config->server_host_len;
   state.server_port = config->server_port;
+  state.quic_ca_file = config->quic_ca_file;
+  state.addrs_per_server = config->addrs_per_server;
+  state.transparent = config->transparent;
+  state.frontend = config->frontend;
 
 #if defined(ODIN_CLI_CLIENT_TESTING)
   g_progress_reported = 0;
@@ -761,6 +1334,16 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   if (fcntl(state.listen_fd, F_SETFL, flags | O_NONBLOCK) != 0) {
     return startup_fail(&state, err, "fcntl(F_SETFL)");
   }
+#if defined(IP_TRANSPARENT)
+  if (state.transparent) {
+    /* TPROXY delivers only to IP_TRANSPARENT listeners. It needs
+     * CAP_NET_ADMIN; without it REDIRECT still works, so a refusal is not a
+     * startup failure. */
+    const int on = 1;
+    (void)setsockopt(state.listen_fd, IPPROTO_IP, IP_TRANSPARENT, &on,
+                     sizeof(on));
+  }
+#endif
 
   struct sockaddr_in addr;
   memset(&addr, 0, sizeof(addr));
@@ -798,6 +1381,7 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
     return startup_fail(&state, err, "getsockname");
   }
   state.actual_port = ntohs(bound.sin_port);
+  state.listen_addr = bound;
   record_bound_addr_after_getsockname(&bound);
 
 #if defined(ODIN_CLI_CLIENT_TESTING)
@@ -809,6 +1393,19 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   if (odin_event_loop_create(&state.loop) != 0) {
     return startup_fail(&state, err, "event_loop_create");
   }
+  const odin_event_loop_budget_t budget = {
+      ODIN_EVENT_LOOP_DEFAULT_IO_PER_PASS,
+      ODIN_EVENT_LOOP_DEFAULT_PHASE_US,
+  };
+  odin_event_loop_set_budget(state.loop, &budget);
+  const char *log_fail = start_access_log(&state, config);
+  if (log_fail != NULL) {
+    return startup_fail(&state, err, log_fail);
+  }
+  const char *qlog_fail = start_qlog(&state, config);
+  if (qlog_fail != NULL) {
+    return startup_fail(&state, err, qlog_fail);
+  }
 
   if (resolve_server_endpoint(&state) != 0) {
     return startup_fail(&state, err, "server_dns");
@@ -839,6 +1436,18 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   g_accept_loop_create_calls += 1;
 #endif
 
+  const uint64_t cert_ttl_ms = config->cert_cache_ttl_ms != 0
+                                   ? config->cert_cache_ttl_ms
+                                   : ODIN_CERT_CACHE_DEFAULT_TTL_MS;
+#if defined(ODIN_CLI_CLIENT_TESTING)
+  g_last_cert_cache_ttl_ms = cert_ttl_ms;
+  g_last_cert_cache_ttl_recorded = 1;
+#endif
+  if (odin_cert_cache_create(ODIN_CERT_CACHE_DEFAULT_ENTRIES, cert_ttl_ms,
+                             &state.cert_cache) != 0) {
+    return startup_fail(&state, err, "cert_cache");
+  }
+
   odin_xqc_client_runtime_default_config_t runtime_config;
   memset(&runtime_config, 0, sizeof(runtime_config));
   runtime_config.loop = state.loop;
@@ -848,6 +1457,8 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   runtime_config.peer_addrlen = state.resolved_peer_len;
   runtime_config.server_host = state.server_host_cstr;
   runtime_config.ca_file = config->quic_ca_file;
+  runtime_config.cert_cache = state.cert_cache;
+  runtime_config.qlog = state.qlog;
 #if defined(ODIN_CLI_CLIENT_TESTING) && defined(ODIN_DNS_RESOLVER_TESTING)
   cli_client_test_record_dns_liveness(
       &g_dns_timing.live_resolvers_before_runtime_create,
@@ -864,6 +1475,19 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
   if (quic_runtime_start_call(state.quic_rt) != 0) {
     return startup_fail(&state, err, "xqc_client_runtime_start");
   }
+  apply_session_options(&state, state.quic_rt);
+  const char *route_fail = start_split_routing(&state, config);
+  if (route_fail != NULL) {
+    return startup_fail(&state, err, route_fail);
+  }
+  const char *upstream_fail = start_upstreams(&state, config);
+  if (upstream_fail != NULL) {
+    return startup_fail(&state, err, upstream_fail);
+  }
+  const char *dns_fail = start_dns_stub(&state, config->dns_stub_port);
+  if (dns_fail != NULL) {
+    return startup_fail(&state, err, dns_fail);
+  }
 
   const char *sig_fail = install_signal_handlers(&state);
   if (sig_fail != NULL) {
@@ -883,6 +1507,27 @@ static int run_quic_client(const odin_cli_client_config_t *config, FILE *err) {
     return startup_fail(&state, err, "signal_timer_start");
   }
 
+  if (config->stats_interval_s != 0) {
+    const uint64_t interval_us = (uint64_t)config->stats_interval_s * 1000000u;
+    state.stats_err = err;
+#if defined(ODIN_CLI_CLIENT_TESTING)
+    if (test_consume_failpoint(ODIN_CLI_CLIENT_TEST_FAIL_STATS_TIMER_START) !=
+        0) {
+      return startup_fail(&state, err, "stats_timer_start");
+    }
+#endif
+    const odin_event_loop_stats_config_t loop_stats = {
+        0, interval_us, cli_client_slow_report, &state};
+    if (odin_event_loop_enable_stats(state.loop, &loop_stats) != 0) {
+      return startup_fail(&state, err, "loop_stats");
+    }
+    if (odin_event_timer_start(state.loop, interval_us, interval_us,
+                               cli_client_stats_timer, &state,
+                               &state.stats_timer) != 0) {
+      return startup_fail(&state, err, "stats_timer_start");
+    }
+  }
+
   if (state.server_display_needs_brackets) {
     // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
     (void)fprintf(err,
@@ -922,6 +1567,9 @@ int odin_cli_run_client(const odin_cli_client_config_t *config, FILE *err) {
   memset(&state, 0, sizeof(state));
   state.listen_fd = -1;
   state.test_wakeup_fd = -1;
+  state.dns_udp_fd = -1;
+  state.dns_tcp_fd = -1;
+  state.access_log_fd = -1;
 
   if (config == NULL || err == NULL || config->quic_ca_file == NULL ||
       config->quic_ca_file[0] == '\0') {
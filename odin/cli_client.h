@@ -10,16 +10,61 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "odin/access_log.h"
+#include "odin/qlog.h"
+#include "odin/client_session.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* One more upstream server (RFC-039); host is not NUL-terminated. */
+typedef struct odin_cli_client_server_t {
+  const char *host;
+  size_t host_len;
+  uint16_t port;
+} odin_cli_client_server_t;
+
 typedef struct odin_cli_client_config_t {
   uint16_t listen_port;
   const char *server_host;
   size_t server_host_len;
   uint16_t server_port;
   const char *quic_ca_file;
+  /* RFC-038 split-routing rules (odin/route.h grammar); none tunnels all. */
+  const char *const *route_rules;
+  size_t route_rule_count;
+  /* RFC-039 upstream selection: servers besides server_host, and how many
+   * resolved addresses of each name become servers (0 or 1: the first). */
+  const odin_cli_client_server_t *extra_servers;
+  size_t extra_server_count;
+  size_t addrs_per_server;
+  /* RFC-040: accept connections redirected by iptables REDIRECT / TPROXY
+   * and tunnel each to its original destination, with no HTTP CONNECT. */
+  int transparent;
+  /* RFC-041 listener protocol: HTTP CONNECT (default), SOCKS5, or AUTO to
+   * sniff each connection's first byte on the shared port. Ignored when
+   * transparent. */
+  odin_client_session_frontend_t frontend;
+  /* RFC-042: how long a verified server chain is trusted without a full
+   * re-verification, capped by its notAfter; 0 means the default hour. */
+  uint64_t cert_cache_ttl_ms;
+  /* RFC-045: serve DNS for local applications on 127.0.0.1 UDP and TCP at
+   * this port, resolving every A/AAAA question through the server; 0 is off. */
+  uint16_t dns_stub_port;
+  /* RFC-049: append one access-log line per local connection to this file,
+   * written by a background thread; NULL or "" is off. */
+  const char *access_log_path;
+  odin_access_log_format_t access_log_format;
+  /* RFC-050: write sampled qlog traces of the upstream connections to this
+   * file, rotated by size; NULL or "" is off. */
+  const char *qlog_path;
+  uint32_t qlog_sample_every; /* trace 1 in N connections; 0: forced only */
+  const char *qlog_force_ip;  /* always trace this server IP; NULL: none */
+  uint64_t qlog_max_bytes;    /* 0: ODIN_QLOG_DEFAULT_MAX_BYTES */
+  /* RFC-051: log the upstream runtimes' summed totals to err every this many
+   * seconds; 0 is off. */
+  uint32_t stats_interval_s;
 } odin_cli_client_config_t;
 
 int odin_cli_run_client(const odin_cli_client_config_t *config, FILE *err);
@@ -1,10 +1,13 @@
 /* odin/cli_server.c -- RFC-022 server runner.
  *
  * Binds an IPv4 listener on 0.0.0.0:<listen_port>, creates the event
- * loop, server runtime, default SSRF dial filter, and signal-driven
- * stop polling timer, then runs the loop. All setup failures route
- * through one cleanup that releases CLI-owned objects in reverse
- * creation order and prints one deterministic line on err.
+ * loop with the RFC-047 dispatch budgets, optional RFC-050 qlog, server
+ * runtime, default SSRF dial filter, optional RFC-037 source pool,
+ * optional RFC-049 access log, signal-driven stop polling timer, and
+ * optional RFC-051 stats timer, then runs the loop.
+ * All setup failures route through one cleanup that releases CLI-owned
+ * objects in reverse creation order and prints one deterministic line on
+ * err.
  */
 
 #include "odin/cli_server.h"
@@ -20,9 +23,13 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "odin/access_log.h"
+#include "odin/dial.h"
 #include "odin/event_loop.h"
+#include "odin/qlog.h"
 #include "odin/server_session.h"
 #include "odin/server_xqc_runtime.h"
+#include "odin/xqc_conn_stats.h"
 
 #if defined(ODIN_CLI_SERVER_TESTING)
 #include "odin/testing/cli_server_internal_test.h"
@@ -33,7 +40,15 @@
 typedef struct cli_server_state_t {
   odin_event_loop_t *loop;
   odin_xqc_server_runtime_t *xqc_runtime;
+  odin_dial_tfo_cache_t *tfo_cache;
+  odin_dial_source_pool_t *source_pool; /* RFC-037; NULL: kernel source */
+  int access_log_fd;
+  odin_access_log_t *access_log;
+  odin_access_log_ring_t *access_ring;
+  odin_qlog_t *qlog; /* RFC-050; the runtime owns its ring */
   odin_event_timer_t *signal_timer;
+  odin_event_timer_t *stats_timer; /* RFC-051; NULL: no stats line */
+  FILE *stats_err;
   int sigint_replaced;
   int sigterm_replaced;
   struct sigaction old_sigint;
@@ -50,6 +65,7 @@ static odin_cli_server_test_failpoint_t g_failpoint;
 static int g_failpoint_errno;
 static size_t g_live_xqc_runtimes;
 static odin_cli_server_test_filter_record_t g_filter_record;
+static odin_cli_server_test_source_pool_record_t g_source_pool_record;
 static int g_last_bind_addr_recorded;
 static struct sockaddr_in g_last_bind_addr;
 static int g_progress_fd = -1;
@@ -143,6 +159,54 @@ static void cli_signal_poll_timer(odin_event_loop_t *loop,
   odin_event_loop_stop(loop);
 }
 
+/* RFC-051: one line of runtime totals, then the CONNECT resolver's RFC-044
+ * cache counters, the RFC-046 loop timings, and, with --source-addr, the
+ * RFC-037 per-source counters, per --stats-interval-s. */
+static void cli_stats_timer(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                            void *user_data) {
+  (void)loop;
+  (void)timer;
+  cli_server_state_t *state = (cli_server_state_t *)user_data;
+  odin_xqc_runtime_totals_t totals;
+  if (odin_xqc_server_runtime_totals(state->xqc_runtime, &totals) != 0) {
+    return;
+  }
+  char line[256];
+  (void)odin_xqc_runtime_totals_format(&totals, line, sizeof(line));
+  odin_dns_cache_stats_t dns;
+  odin_xqc_server_runtime_dns_stats(state->xqc_runtime, &dns);
+  char dns_line[160];
+  (void)odin_dns_cache_stats_format(&dns, dns_line, sizeof(dns_line));
+  odin_event_loop_stats_t loop_stats;
+  odin_event_loop_stats(state->loop, &loop_stats);
+  char loop_line[160];
+  (void)odin_event_loop_stats_format(&loop_stats, loop_line, sizeof(loop_line));
+  char pool_line[512];
+  pool_line[0] = '\0';
+  if (state->source_pool != NULL) {
+    pool_line[0] = ' ';
+    (void)odin_dial_source_pool_stats_format(state->source_pool, pool_line + 1,
+                                             sizeof(pool_line) - 1u);
+  }
+  // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
+  (void)fprintf(state->stats_err, "odin: stats %s %s %s%s\n", line, dns_line,
+                loop_line, pool_line);
+  (void)fflush(state->stats_err);
+}
+
+/* RFC-046: at most one slow callback per --stats-interval-s. */
+static void cli_slow_report(odin_event_loop_t *loop,
+                            const odin_event_loop_slow_report_t *report,
+                            void *user_data) {
+  (void)loop;
+  cli_server_state_t *state = (cli_server_state_t *)user_data;
+  char line[ODIN_EVENT_LOOP_SYMBOL_MAX + 96];
+  (void)odin_event_loop_slow_report_format(report, line, sizeof(line));
+  // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
+  (void)fprintf(state->stats_err, "odin: slow %s\n", line);
+  (void)fflush(state->stats_err);
+}
+
 static const char *install_signal_handlers(cli_server_state_t *state) {
   g_odin_cli_server_signal_seen = 0;
   struct sigaction sa;
@@ -187,6 +251,10 @@ static void cleanup_all(cli_server_state_t *state) {
     odin_event_timer_stop(state->signal_timer);
     state->signal_timer = NULL;
   }
+  if (state->stats_timer != NULL) {
+    odin_event_timer_stop(state->stats_timer);
+    state->stats_timer = NULL;
+  }
   if (state->xqc_runtime != NULL) {
     odin_xqc_server_runtime_force_destroy(state->xqc_runtime);
     state->xqc_runtime = NULL;
@@ -198,9 +266,104 @@ static void cleanup_all(cli_server_state_t *state) {
     odin_event_loop_destroy(state->loop);
     state->loop = NULL;
   }
+  odin_dial_tfo_cache_destroy(state->tfo_cache);
+  state->tfo_cache = NULL;
+  /* Every session released its source with its upstream socket. */
+  odin_dial_source_pool_destroy(state->source_pool);
+  state->source_pool = NULL;
+  /* The sessions are gone, so the ring has its last record. */
+  odin_access_log_ring_destroy(state->access_ring);
+  state->access_ring = NULL;
+  odin_access_log_destroy(state->access_log);
+  state->access_log = NULL;
+  if (state->access_log_fd >= 0) {
+    (void)close(state->access_log_fd);
+    state->access_log_fd = -1;
+  }
+  /* The runtime destroyed its ring with its engine. */
+  odin_qlog_destroy(state->qlog);
+  state->qlog = NULL;
   restore_signal_handlers(state);
 }
 
+/* Creates the RFC-037 source pool and lends it to the runtime; returns the
+ * failed startup step, or NULL. */
+static const char *start_source_pool(cli_server_state_t *state,
+                                     const odin_cli_server_config_t *config) {
+  if (config->source_addr_count == 0) {
+    return NULL;
+  }
+  if (odin_dial_source_pool_create(config->source_addrs,
+                                   config->source_addr_count,
+                                   config->source_policy,
+                                   &state->source_pool) != 0) {
+    return "dial_source_pool_create";
+  }
+#if defined(ODIN_CLI_SERVER_TESTING)
+  g_source_pool_record.set_count += 1;
+  g_source_pool_record.source_count = config->source_addr_count;
+  g_source_pool_record.policy = config->source_policy;
+#endif
+  odin_xqc_server_runtime_set_source_pool(state->xqc_runtime,
+                                          state->source_pool);
+  return NULL;
+}
+
+/* Opens the RFC-049 access log and the loop's ring and lends the ring to the
+ * runtime; returns the failed startup step, or NULL. */
+static const char *start_access_log(cli_server_state_t *state,
+                                    const odin_cli_server_config_t *config) {
+  if (config->access_log_path == NULL || config->access_log_path[0] == '\0') {
+    return NULL;
+  }
+  state->access_log_fd =
+      open(config->access_log_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+           0644);
+  if (state->access_log_fd < 0) {
+    return "access_log_open";
+  }
+  odin_access_log_config_t log_config;
+  memset(&log_config, 0, sizeof(log_config));
+  log_config.fd = state->access_log_fd;
+  log_config.format = config->access_log_format;
+  if (odin_access_log_create(&log_config, &state->access_log) != 0 ||
+      odin_access_log_ring_create(state->access_log, 0, &state->access_ring) !=
+          0) {
+    return "access_log_create";
+  }
+  odin_xqc_server_runtime_set_access_log(state->xqc_runtime,
+                                         state->access_ring);
+  return NULL;
+}
+
+/* Creates the RFC-050 qlog that the runtime traces into; returns the failed
+ * startup step, or NULL. */
+static const char *start_qlog(cli_server_state_t *state,
+                              const odin_cli_server_config_t *config) {
+  if (config->qlog_path == NULL || config->qlog_path[0] == '\0') {
+    return NULL;
+  }
+  odin_qlog_config_t qlog_config;
+  memset(&qlog_config, 0, sizeof(qlog_config));
+  qlog_config.path = config->qlog_path;
+  qlog_config.max_bytes = config->qlog_max_bytes;
+  qlog_config.sample_every = config->qlog_sample_every;
+  qlog_config.vantage = ODIN_QLOG_SERVER;
+  struct sockaddr_storage force;
+  socklen_t force_len = 0;
+  if (config->qlog_force_ip != NULL && config->qlog_force_ip[0] != '\0') {
+    if (odin_qlog_parse_ip(config->qlog_force_ip, &force, &force_len) != 0) {
+      return "qlog_config";
+    }
+    qlog_config.force_addr = (const struct sockaddr *)&force;
+    qlog_config.force_addr_len = force_len;
+  }
+  if (odin_qlog_create(&qlog_config, &state->qlog) != 0) {
+    return "qlog_create";
+  }
+  return NULL;
+}
+
 static int startup_fail_quic(cli_server_state_t *state, FILE *err,
                              const char *step) {
   // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
@@ -219,6 +382,7 @@ static int startup_fail_config(FILE *err) {
 static int run_quic_server(const odin_cli_server_config_t *config, FILE *err) {
   cli_server_state_t state;
   memset(&state, 0, sizeof(state));
+  state.access_log_fd = -1;
 
 #if defined(ODIN_CLI_SERVER_TESTING)
   g_progress_reported = 0;
@@ -238,6 +402,15 @@ static int run_quic_server(const odin_cli_server_config_t *config, FILE *err) {
   if (odin_event_loop_create(&state.loop) != 0) {
     return startup_fail_quic(&state, err, "event_loop_create");
   }
+  const odin_event_loop_budget_t budget = {
+      ODIN_EVENT_LOOP_DEFAULT_IO_PER_PASS,
+      ODIN_EVENT_LOOP_DEFAULT_PHASE_US,
+  };
+  odin_event_loop_set_budget(state.loop, &budget);
+  const char *qlog_fail = start_qlog(&state, config);
+  if (qlog_fail != NULL) {
+    return startup_fail_quic(&state, err, qlog_fail);
+  }
 
   struct sockaddr_in local;
   memset(&local, 0, sizeof(local));
@@ -265,6 +438,7 @@ static int run_quic_server(const odin_cli_server_config_t *config, FILE *err) {
   rt_config.engine_config = NULL;
   rt_config.ssl_config = &ssl;
   rt_config.engine_callbacks = &callbacks;
+  rt_config.qlog = state.qlog;
 
 #if defined(ODIN_CLI_SERVER_TESTING)
   if (test_consume_failpoint(
@@ -280,6 +454,18 @@ static int run_quic_server(const odin_cli_server_config_t *config, FILE *err) {
 #endif
 
   install_quic_default_dial_filter(state.xqc_runtime);
+  if (odin_dial_tfo_cache_create(&state.tfo_cache) != 0) {
+    return startup_fail_quic(&state, err, "dial_tfo_cache_create");
+  }
+  odin_xqc_server_runtime_set_tfo_cache(state.xqc_runtime, state.tfo_cache);
+  const char *pool_fail = start_source_pool(&state, config);
+  if (pool_fail != NULL) {
+    return startup_fail_quic(&state, err, pool_fail);
+  }
+  const char *log_fail = start_access_log(&state, config);
+  if (log_fail != NULL) {
+    return startup_fail_quic(&state, err, log_fail);
+  }
 
 #if defined(ODIN_CLI_SERVER_TESTING)
   if (test_consume_failpoint(
@@ -334,6 +520,27 @@ static int run_quic_server(const odin_cli_server_config_t *config, FILE *err) {
     return startup_fail_quic(&state, err, "signal_timer_start");
   }
 
+  if (config->stats_interval_s != 0) {
+    const uint64_t interval_us = (uint64_t)config->stats_interval_s * 1000000u;
+    state.stats_err = err;
+#if defined(ODIN_CLI_SERVER_TESTING)
+    if (test_consume_failpoint(ODIN_CLI_SERVER_TEST_FAIL_STATS_TIMER_START) !=
+        0) {
+      return startup_fail_quic(&state, err, "stats_timer_start");
+    }
+#endif
+    const odin_event_loop_stats_config_t loop_stats = {0, interval_us,
+                                                       cli_slow_report, &state};
+    if (odin_event_loop_enable_stats(state.loop, &loop_stats) != 0) {
+      return startup_fail_quic(&state, err, "loop_stats");
+    }
+    if (odin_event_timer_start(state.loop, interval_us, interval_us,
+                               cli_stats_timer, &state,
+                               &state.stats_timer) != 0) {
+      return startup_fail_quic(&state, err, "stats_timer_start");
+    }
+  }
+
   // NOLINTNEXTLINE(clang-analyzer-security.insecureAPI.DeprecatedOrUnsafeBufferHandling)
   (void)fprintf(err, "odin: mode=server transport=quic listen=%u\n",
                 (unsigned)actual_port);
@@ -18,8 +18,14 @@
 #ifndef ODIN_CLI_SERVER_H_
 #define ODIN_CLI_SERVER_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/socket.h>
+
+#include "odin/access_log.h"
+#include "odin/dial.h"
+#include "odin/qlog.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +35,24 @@ typedef struct odin_cli_server_config_t {
   uint16_t listen_port;
   const char *quic_cert_file;
   const char *quic_key_file;
+  /* RFC-037: bind upstream dials to these local addresses (ports ignored),
+   * picked by source_policy; a count of 0 leaves the source to the kernel. */
+  const struct sockaddr_storage *source_addrs;
+  size_t source_addr_count;
+  odin_dial_source_policy_t source_policy;
+  /* RFC-049: append one access-log line per tunnel to this file, written by a
+   * background thread; NULL or "" is off. */
+  const char *access_log_path;
+  odin_access_log_format_t access_log_format;
+  /* RFC-050: write sampled qlog traces to this file, rotated by size; NULL
+   * or "" is off. */
+  const char *qlog_path;
+  uint32_t qlog_sample_every; /* trace 1 in N connections; 0: forced only */
+  const char *qlog_force_ip;  /* always trace this peer IP; NULL: none */
+  uint64_t qlog_max_bytes;    /* 0: ODIN_QLOG_DEFAULT_MAX_BYTES */
+  /* RFC-051: log the runtime totals to err every this many seconds; 0 is
+   * off. */
+  uint32_t stats_interval_s;
 } odin_cli_server_config_t;
 
 int odin_cli_run_server(const odin_cli_server_config_t *config, FILE *err);
@@ -0,0 +1,157 @@
+/* odin/client_direct.c -- RFC-038 direct connector for split routing.
+ *
+ * One heap attempt per CONNECT: a DNS query, then at most one in-flight dial
+ * over a copy of the first ODIN_CLIENT_DIRECT_ADDRS_MAX answers.
+ */
+
+#include "odin/client_direct.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "odin/dial.h"
+
+struct odin_client_direct_t {
+  odin_event_loop_t *loop;
+  odin_dns_resolver_t *resolver;
+};
+
+typedef struct direct_attempt_t {
+  odin_client_direct_t *direct;
+  odin_dns_query_t *query;
+  odin_dial_t *dial;
+  odin_client_session_direct_done_cb on_done;
+  void *done_user_data;
+  odin_dns_addr_t addrs[ODIN_CLIENT_DIRECT_ADDRS_MAX];
+  size_t addr_count;
+  size_t next;
+  int first_err;
+} direct_attempt_t;
+
+static void dial_next(direct_attempt_t *a);
+
+int odin_client_direct_create(odin_event_loop_t *loop,
+                              odin_dns_resolver_t *resolver,
+                              odin_client_direct_t **out) {
+  if (loop == NULL || resolver == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_client_direct_t *direct =
+      (odin_client_direct_t *)calloc(1, sizeof(*direct));
+  if (direct == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  direct->loop = loop;
+  direct->resolver = resolver;
+  *out = direct;
+  return 0;
+}
+
+void odin_client_direct_destroy(odin_client_direct_t *direct) {
+  free(direct);
+}
+
+/* Frees the attempt, then reports; the caller's on_done may start another. */
+static void finish(direct_attempt_t *a, int fd, int err) {
+  const odin_client_session_direct_done_cb on_done = a->on_done;
+  void *const done_user_data = a->done_user_data;
+  free(a);
+  on_done(fd, err, done_user_data);
+}
+
+static void note_err(direct_attempt_t *a, int err) {
+  if (a->first_err == 0) {
+    a->first_err = err;
+  }
+}
+
+static void dial_on_done(odin_dial_t *dial, odin_dial_status_t status, int fd,
+                         int err, void *user_data) {
+  direct_attempt_t *a = (direct_attempt_t *)user_data;
+  odin_dial_destroy(dial);
+  a->dial = NULL;
+  if (status == ODIN_DIAL_OK) {
+    finish(a, fd, 0);
+    return;
+  }
+  note_err(a, err);
+  dial_next(a);
+}
+
+static void dial_next(direct_attempt_t *a) {
+  while (a->next < a->addr_count) {
+    const odin_dns_addr_t *addr = &a->addrs[a->next];
+    a->next += 1;
+    if (odin_dial_start(a->direct->loop, (const struct sockaddr *)&addr->addr,
+                        addr->addrlen, dial_on_done, a, &a->dial) == 0) {
+      return;
+    }
+    note_err(a, errno);
+  }
+  finish(a, -1, a->first_err != 0 ? a->first_err : EHOSTUNREACH);
+}
+
+static void dns_on_done(odin_dns_query_t *query, odin_dns_status_t status,
+                        int err, const odin_dns_addr_t *addrs,
+                        size_t addr_count, void *user_data) {
+  direct_attempt_t *a = (direct_attempt_t *)user_data;
+  if (status != ODIN_DNS_OK) {
+    odin_dns_query_destroy(query);
+    a->query = NULL;
+    finish(a, -1, err != 0 ? err : EHOSTUNREACH);
+    return;
+  }
+  if (addr_count > ODIN_CLIENT_DIRECT_ADDRS_MAX) {
+    addr_count = ODIN_CLIENT_DIRECT_ADDRS_MAX;
+  }
+  memcpy(a->addrs, addrs, addr_count * sizeof(*addrs));
+  a->addr_count = addr_count;
+  odin_dns_query_destroy(query);
+  a->query = NULL;
+  dial_next(a);
+}
+
+int odin_client_direct_start(const char *host, size_t host_len, uint16_t port,
+                             odin_client_session_direct_done_cb on_done,
+                             void *done_user_data, void *direct_user_data,
+                             void **out_attempt) {
+  odin_client_direct_t *direct = (odin_client_direct_t *)direct_user_data;
+  if (direct == NULL || on_done == NULL || out_attempt == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  direct_attempt_t *a = (direct_attempt_t *)calloc(1, sizeof(*a));
+  if (a == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  a->direct = direct;
+  a->on_done = on_done;
+  a->done_user_data = done_user_data;
+  if (odin_dns_resolve_start(direct->resolver, host, host_len, port,
+                             AF_UNSPEC, dns_on_done, a, &a->query) != 0) {
+    const int saved = errno;
+    free(a);
+    errno = saved;
+    return -1;
+  }
+  *out_attempt = a;
+  return 0;
+}
+
+void odin_client_direct_cancel(void *attempt, void *direct_user_data) {
+  (void)direct_user_data;
+  direct_attempt_t *a = (direct_attempt_t *)attempt;
+  if (a == NULL) {
+    return;
+  }
+  odin_dns_query_destroy(a->query);
+  odin_dial_destroy(a->dial);
+  free(a);
+}
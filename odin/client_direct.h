@@ -0,0 +1,64 @@
+/* odin/client_direct.h
+ *
+ * Direct connector for client split routing (RFC-038).
+ *
+ * odin_client_direct_start and odin_client_direct_cancel implement the
+ * odin_client_session_route_t start_direct / cancel_direct pair, with the
+ * odin_client_direct_t as direct_user_data. An attempt resolves the CONNECT
+ * host with the borrowed odin_dns_resolver_t (an address literal resolves to
+ * itself), then dials the first ODIN_CLIENT_DIRECT_ADDRS_MAX answers in
+ * order, moving to the next address when a dial fails. on_done reports the
+ * first connected fd, whose ownership passes to the caller, or -1 and the
+ * first dial error (the resolver's error when resolution fails, EHOSTUNREACH
+ * when it returns no address). on_done fires exactly once, from a resolver or
+ * dial callback and never from inside odin_client_direct_start; the attempt is
+ * freed before it fires. odin_client_direct_cancel stops an attempt that has
+ * not reported and closes any socket it holds.
+ *
+ * Threading: owner-thread (the loop's thread), no locks. The loop and the
+ * resolver must outlive the connector, and every attempt must have reported
+ * or been cancelled before odin_client_direct_destroy. odin_client_direct_
+ * destroy(NULL) is a no-op.
+ */
+
+#ifndef ODIN_CLIENT_DIRECT_H_
+#define ODIN_CLIENT_DIRECT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "odin/client_session.h"
+#include "odin/dns_resolver.h"
+#include "odin/event_loop.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_CLIENT_DIRECT_ADDRS_MAX 8u
+
+typedef struct odin_client_direct_t odin_client_direct_t;
+
+/* Returns 0, or -1 with errno EINVAL (NULL argument) or ENOMEM. */
+int odin_client_direct_create(odin_event_loop_t *loop,
+                              odin_dns_resolver_t *resolver,
+                              odin_client_direct_t **out);
+
+/* odin_client_session_direct_start_cb; direct_user_data is the connector.
+ * Returns 0 with *out_attempt set, or -1 with errno from the allocation or
+ * from odin_dns_resolve_start. */
+int odin_client_direct_start(const char *host, size_t host_len, uint16_t port,
+                             odin_client_session_direct_done_cb on_done,
+                             void *done_user_data, void *direct_user_data,
+                             void **out_attempt);
+
+/* odin_client_session_direct_cancel_cb. */
+void odin_client_direct_cancel(void *attempt, void *direct_user_data);
+
+void odin_client_direct_destroy(odin_client_direct_t *direct);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_CLIENT_DIRECT_H_ */
@@ -1,17 +1,42 @@
-/* odin/client_session.c -- RFC-023 local-client orchestrator session. */
+/* odin/client_session.c -- RFC-023 local-client orchestrator session.
+ *
+ * RFC-038 adds a routing stage between the HTTP parse and the upstream: a
+ * direct route hands the destination to the lent connector and relays over an
+ * fd transport on the fd it reports, skipping the CONNECT handshake.
+ *
+ * RFC-040 transparent sessions start with the destination already known:
+ * there is no HTTP request to parse and no HTTP response to write, so both
+ * response slots are empty and a failure simply closes the connection.
+ *
+ * RFC-041 adds a SOCKS5 frontend: the same buffer holds the greeting and
+ * request, the method reply goes out as soon as the greeting is complete,
+ * and the RFC 1928 reply takes the place of the HTTP response. Everything
+ * after the request is the same pipeline.
+ *
+ * RFC-049: with an access-log ring lent, the session records the target, how
+ * long the upstream took to become ready, the direct upstream's address, and
+ * the relay's byte counts, and appends the record as it closes.
+ */
 
 #include "odin/client_session.h"
 
+#include <arpa/inet.h>
 #include <errno.h>
+#include <netinet/in.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include "odin/access_log.h"
 #include "odin/connect_session.h"
 #include "odin/http_connect.h"
+#include "odin/protocol.h"
 #include "odin/relay.h"
+#include "odin/socks5.h"
+#include "odin/trace.h"
 #include "odin/transport.h"
 #include "odin/transport_fd.h"
 
@@ -30,6 +55,7 @@ enum {
   ODIN_CLIENT_SESSION_S_WRITING_ERR_HTTP = 4,
   ODIN_CLIENT_SESSION_S_RELAY = 5,
   ODIN_CLIENT_SESSION_S_TERMINAL = 6,
+  ODIN_CLIENT_SESSION_S_DIRECT = 7,
 };
 
 struct odin_client_session_t {
@@ -40,11 +66,17 @@ struct odin_client_session_t {
   int active_depth;
   int destroy_pending;
   int on_close_fired;
+  int transparent; /* RFC-040: no HTTP request or response */
+  odin_client_session_frontend_t frontend; /* AUTO: set by the 1st byte */
+  int socks_method_sent;
   odin_client_session_close_cb on_close;
   void *user_data;
   odin_client_session_upstream_transport_factory_cb create_upstream;
   void *create_upstream_ud;
   odin_client_session_upstream_transport_destroying_cb upstream_destroying;
+  odin_client_session_route_t route; /* table == NULL: tunnel everything */
+  void *direct_attempt;              /* in-flight start_direct, or NULL  */
+  int upstream_fd;                   /* direct upstream socket, or -1    */
   odin_transport_t *downstream_t;
   odin_transport_t *upstream_t;
   odin_connect_session_t *s;
@@ -52,9 +84,16 @@ struct odin_client_session_t {
   uint8_t http_buf[ODIN_HTTP_REQUEST_MAX];
   size_t http_buf_used;
   size_t http_consumed;
-  odin_http_connect_t http_view;
+  const char *target_host; /* into http_buf, or host_text */
+  size_t target_host_len;
+  uint16_t target_port;
+  char host_text[INET6_ADDRSTRLEN];
   odin_http_response_t http_resp;
+  uint8_t socks_resp[ODIN_SOCKS5_METHOD_REPLY_LEN + ODIN_SOCKS5_REPLY_LEN];
   size_t http_resp_off;
+  odin_access_log_ring_t *access_log; /* borrowed; NULL: not logged */
+  uint64_t dial_start_us;             /* 0: no upstream started */
+  odin_access_log_record_t log_rec;   /* filled while access_log is set */
 #if defined(ODIN_CLIENT_SESSION_TESTING)
   int fail_next_http_parse_tail_write_armed;
   int fail_next_http_parse_tail_write_errno;
@@ -78,15 +117,54 @@ static void relay_on_done(odin_relay_t *relay, odin_relay_status_t status,
                           int err, void *user_data);
 static void finish_destroy(odin_client_session_t *cs);
 static void fire_terminal(odin_client_session_t *cs, int err);
+static void append_access_log(odin_client_session_t *cs, int err);
 static void drive_parse_http(odin_client_session_t *cs, unsigned int events);
+static int route_is_direct(odin_client_session_t *cs);
+static void set_target(odin_client_session_t *cs, const char *host,
+                       size_t host_len, uint16_t port);
+static void start_upstream(odin_client_session_t *cs);
 static void start_factory_upstream(odin_client_session_t *cs);
+static void start_direct_upstream(odin_client_session_t *cs);
+static void cancel_direct_attempt(odin_client_session_t *cs);
 static void handle_failure(odin_client_session_t *cs, odin_http_status_t status,
                            int err);
+static void fail_with_response(odin_client_session_t *cs,
+                               odin_http_response_t resp, int err);
+static int write_one_shot_or_terminal(odin_client_session_t *cs,
+                                      odin_transport_t *t, const void *buf,
+                                      size_t len, int eof_errno);
 static void drive_write_http_resp(odin_client_session_t *cs,
                                   unsigned int events);
 static void destroy_upstream_transport(odin_client_session_t *cs,
                                        odin_transport_t *transport);
 
+/* The response a session answers status / err with: HTTP, the SOCKS5 reply
+ * (behind the method reply if that has not gone out yet), or none when
+ * transparent. */
+static odin_http_response_t response_for(odin_client_session_t *cs,
+                                         odin_http_status_t status, int err) {
+  odin_http_response_t resp = {NULL, 0};
+  if (cs->transparent) {
+    return resp;
+  }
+  if (cs->frontend != ODIN_CLIENT_SESSION_FRONTEND_SOCKS5) {
+    return odin_http_response_for_status(status);
+  }
+  size_t len = 0;
+  if (!cs->socks_method_sent) {
+    memcpy(cs->socks_resp, odin_socks5_method_reply(1),
+           ODIN_SOCKS5_METHOD_REPLY_LEN);
+    len = ODIN_SOCKS5_METHOD_REPLY_LEN;
+  }
+  const uint8_t rep = status == ODIN_HTTP_OK
+                          ? ODIN_SOCKS5_REP_SUCCEEDED
+                          : odin_socks5_rep_for_errno(err != 0 ? err : EIO);
+  odin_socks5_write_reply(rep, cs->socks_resp + len);
+  resp.bytes = (const char *)cs->socks_resp;
+  resp.len = len + ODIN_SOCKS5_REPLY_LEN;
+  return resp;
+}
+
 static int client_resp_code_to_errno(uint16_t error_code) {
   switch (error_code) {
   case 0x0001:
@@ -121,6 +199,7 @@ alloc_client_session(odin_event_loop_t *loop, int conn_fd,
   }
   cs->loop = loop;
   cs->conn_fd = conn_fd;
+  cs->upstream_fd = -1;
   cs->state = ODIN_CLIENT_SESSION_S_PARSING;
   cs->on_close = on_close;
   cs->user_data = user_data;
@@ -183,10 +262,97 @@ int odin_client_session_create_with_upstream_transport(
     return -1;
   }
 
+  ODIN_TRACE1(client__session__create, cs);
   *out = cs;
   return 0;
 }
 
+void odin_client_session_set_route(odin_client_session_t *cs,
+                                   const odin_client_session_route_t *route) {
+  if (cs == NULL) {
+    return;
+  }
+  if (route == NULL) {
+    memset(&cs->route, 0, sizeof(cs->route));
+    return;
+  }
+  cs->route = *route;
+}
+
+int odin_client_session_start_transparent(odin_client_session_t *cs,
+                                          const struct sockaddr *dst,
+                                          socklen_t dst_len) {
+  if (cs == NULL || dst == NULL ||
+      cs->state != ODIN_CLIENT_SESSION_S_PARSING || cs->http_buf_used != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  const void *addr = NULL;
+  uint16_t port = 0;
+  if (dst->sa_family == AF_INET &&
+      dst_len >= (socklen_t)sizeof(struct sockaddr_in)) {
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)dst;
+    addr = &sin->sin_addr;
+    port = ntohs(sin->sin_port);
+  } else if (dst->sa_family == AF_INET6 &&
+             dst_len >= (socklen_t)sizeof(struct sockaddr_in6)) {
+    const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)dst;
+    addr = &sin6->sin6_addr;
+    port = ntohs(sin6->sin6_port);
+  }
+  if (addr == NULL || port == 0 ||
+      inet_ntop(dst->sa_family, addr, cs->host_text, sizeof(cs->host_text)) ==
+          NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  cs->transparent = 1;
+  set_target(cs, cs->host_text, strlen(cs->host_text), port);
+  start_upstream(cs);
+  return 0;
+}
+
+int odin_client_session_start_dns_tunnel(odin_client_session_t *cs) {
+  if (cs == NULL || cs->state != ODIN_CLIENT_SESSION_S_PARSING ||
+      cs->http_buf_used != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  cs->transparent = 1;
+  set_target(cs, ODIN_PROTO_DNS_HOST, sizeof(ODIN_PROTO_DNS_HOST) - 1,
+             ODIN_PROTO_DNS_PORT);
+  /* The DNS target is the server itself; no route may send it direct. */
+  start_factory_upstream(cs);
+  return 0;
+}
+
+void odin_client_session_set_frontend(odin_client_session_t *cs,
+                                      odin_client_session_frontend_t frontend) {
+  if (cs == NULL || cs->http_buf_used != 0 ||
+      cs->state != ODIN_CLIENT_SESSION_S_PARSING) {
+    return;
+  }
+  cs->frontend = frontend;
+}
+
+void odin_client_session_set_access_log(odin_client_session_t *cs,
+                                        odin_access_log_ring_t *ring) {
+  if (cs == NULL) {
+    return;
+  }
+  cs->access_log = ring;
+  if (ring == NULL) {
+    return;
+  }
+  odin_access_log_record_begin(&cs->log_rec, ODIN_ACCESS_LOG_CLIENT);
+  struct sockaddr_storage peer;
+  socklen_t peer_len = sizeof(peer);
+  if (getpeername(cs->conn_fd, (struct sockaddr *)&peer, &peer_len) == 0) {
+    odin_access_log_addr_set(&cs->log_rec.client, (struct sockaddr *)&peer,
+                             peer_len);
+  }
+}
+
 void odin_client_session_destroy(odin_client_session_t *cs) {
   if (cs == NULL) {
     return;
@@ -199,6 +365,10 @@ void odin_client_session_destroy(odin_client_session_t *cs) {
 }
 
 static void finish_destroy(odin_client_session_t *cs) {
+  if (cs->access_log != NULL && !cs->on_close_fired) {
+    append_access_log(cs, ECANCELED); /* destroyed before it closed */
+  }
+  cancel_direct_attempt(cs);
   if (cs->relay != NULL) {
     odin_relay_destroy(cs->relay);
     cs->relay = NULL;
@@ -258,6 +428,130 @@ static void client_session_ready(odin_transport_t *t, unsigned int events,
   cs_leave(cs);
 }
 
+static int route_is_direct(odin_client_session_t *cs) {
+  if (cs->route.table == NULL || cs->route.start_direct == NULL) {
+    return 0;
+  }
+  return odin_route_decide(cs->route.table, cs->target_host,
+                           cs->target_host_len,
+                           cs->target_port) == ODIN_ROUTE_DIRECT;
+}
+
+static void set_target(odin_client_session_t *cs, const char *host,
+                       size_t host_len, uint16_t port) {
+  cs->target_host = host;
+  cs->target_host_len = host_len;
+  cs->target_port = port;
+  if (cs->access_log != NULL) {
+    odin_access_log_record_set_host(&cs->log_rec, host, host_len, port);
+    cs->dial_start_us = odin_access_log_mono_us();
+  }
+}
+
+/* The upstream is ready or failed: the RFC-049 dial time ends here. */
+static void note_dial_done(odin_client_session_t *cs) {
+  if (cs->access_log != NULL && cs->dial_start_us != 0) {
+    cs->log_rec.dial_us = odin_access_log_mono_us() - cs->dial_start_us;
+  }
+}
+
+static void start_upstream(odin_client_session_t *cs) {
+  if (route_is_direct(cs)) {
+    start_direct_upstream(cs);
+  } else {
+    start_factory_upstream(cs);
+  }
+}
+
+/* Returns 1 once the HTTP CONNECT is parsed or failed, 0 for more bytes. */
+static int parse_http(odin_client_session_t *cs) {
+  odin_http_connect_t view;
+  size_t consumed = 0;
+  const odin_http_status_t st = odin_http_parse_connect(
+      cs->http_buf, cs->http_buf_used, &consumed, &view);
+  if (st == ODIN_HTTP_NEED_MORE) {
+    return 0;
+  }
+  if (st != ODIN_HTTP_OK) {
+    handle_failure(cs, st, EPROTO);
+    return 1;
+  }
+  cs->http_consumed = consumed;
+  set_target(cs, (const char *)(cs->http_buf + view.host_off), view.host_len,
+             view.port);
+  start_upstream(cs);
+  return 1;
+}
+
+static int socks5_status_to_errno(odin_socks5_status_t st) {
+  switch (st) {
+  case ODIN_SOCKS5_ERR_BAD_COMMAND:
+    return EOPNOTSUPP;
+  case ODIN_SOCKS5_ERR_BAD_ADDR_TYPE:
+    return EAFNOSUPPORT;
+  default:
+    return EPROTO;
+  }
+}
+
+/* Returns 1 once the SOCKS5 request is parsed or failed, 0 for more bytes.
+ * The method reply is written the moment the greeting completes unless the
+ * request is already here, in which case it rides in front of the reply. */
+static int parse_socks5(odin_client_session_t *cs) {
+  size_t greeting = 0;
+  odin_socks5_status_t st =
+      odin_socks5_parse_greeting(cs->http_buf, cs->http_buf_used, &greeting);
+  if (st == ODIN_SOCKS5_NEED_MORE) {
+    return 0;
+  }
+  if (st == ODIN_SOCKS5_ERR_NO_METHOD) {
+    const odin_http_response_t resp = {
+        (const char *)odin_socks5_method_reply(0),
+        ODIN_SOCKS5_METHOD_REPLY_LEN};
+    fail_with_response(cs, resp, EACCES);
+    return 1;
+  }
+  if (st != ODIN_SOCKS5_OK) {
+    const odin_http_response_t none = {NULL, 0};
+    fail_with_response(cs, none, EPROTO);
+    return 1;
+  }
+
+  odin_socks5_request_t req;
+  size_t consumed = 0;
+  st = odin_socks5_parse_request(cs->http_buf + greeting,
+                                 cs->http_buf_used - greeting, &consumed, &req);
+  if (st == ODIN_SOCKS5_NEED_MORE) {
+    if (!cs->socks_method_sent) {
+      if (write_one_shot_or_terminal(cs, cs->downstream_t,
+                                     odin_socks5_method_reply(1),
+                                     ODIN_SOCKS5_METHOD_REPLY_LEN,
+                                     EPIPE) != 0) {
+        return 1;
+      }
+      cs->socks_method_sent = 1;
+    }
+    return 0;
+  }
+  if (st != ODIN_SOCKS5_OK) {
+    handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET,
+                   socks5_status_to_errno(st));
+    return 1;
+  }
+
+  cs->http_consumed = greeting + consumed;
+  const uint8_t *addr = cs->http_buf + greeting + req.addr_off;
+  if (req.atyp == ODIN_SOCKS5_ATYP_DOMAIN) {
+    set_target(cs, (const char *)addr, req.addr_len, req.port);
+  } else {
+    const int af = req.atyp == ODIN_SOCKS5_ATYP_IPV4 ? AF_INET : AF_INET6;
+    (void)inet_ntop(af, addr, cs->host_text, sizeof(cs->host_text));
+    set_target(cs, cs->host_text, strlen(cs->host_text), req.port);
+  }
+  start_upstream(cs);
+  return 1;
+}
+
 static void drive_parse_http(odin_client_session_t *cs, unsigned int events) {
   if ((events & ODIN_TRANSPORT_ERROR) != 0) {
     const int err = odin_transport_error(cs->downstream_t);
@@ -291,25 +585,22 @@ static void drive_parse_http(odin_client_session_t *cs, unsigned int events) {
     }
     }
 
-    odin_http_connect_t view;
-    size_t consumed = 0;
-    const odin_http_status_t st = odin_http_parse_connect(
-        cs->http_buf, cs->http_buf_used, &consumed, &view);
-    if (st == ODIN_HTTP_OK) {
-      cs->http_consumed = consumed;
-      cs->http_view = view;
-      start_factory_upstream(cs);
+    if (cs->frontend == ODIN_CLIENT_SESSION_FRONTEND_AUTO &&
+        cs->http_buf_used > 0) {
+      cs->frontend = cs->http_buf[0] == ODIN_SOCKS5_VERSION
+                         ? ODIN_CLIENT_SESSION_FRONTEND_SOCKS5
+                         : ODIN_CLIENT_SESSION_FRONTEND_HTTP;
+    }
+    const int done = cs->frontend == ODIN_CLIENT_SESSION_FRONTEND_SOCKS5
+                         ? parse_socks5(cs)
+                         : parse_http(cs);
+    if (done) {
       return;
     }
-    if (st == ODIN_HTTP_NEED_MORE) {
-      if (cs->http_buf_used == ODIN_HTTP_REQUEST_MAX) {
-        handle_failure(cs, ODIN_HTTP_ERR_REQUEST_TOO_LARGE, EPROTO);
-        return;
-      }
-      continue;
+    if (cs->http_buf_used == ODIN_HTTP_REQUEST_MAX) {
+      handle_failure(cs, ODIN_HTTP_ERR_REQUEST_TOO_LARGE, EPROTO);
+      return;
     }
-    handle_failure(cs, st, EPROTO);
-    return;
   }
 }
 
@@ -333,10 +624,9 @@ static void start_factory_upstream(odin_client_session_t *cs) {
   }
 
   odin_connect_session_t *s = NULL;
-  if (odin_connect_session_create_client(
-          (const char *)(cs->http_buf + cs->http_view.host_off),
-          cs->http_view.host_len, cs->http_view.port, session_on_done, cs,
-          &s) != 0) {
+  if (odin_connect_session_create_client(cs->target_host, cs->target_host_len,
+                                         cs->target_port, session_on_done, cs,
+                                         &s) != 0) {
     const int saved = errno;
     destroy_upstream_transport(cs, upstream);
     handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET, saved);
@@ -349,11 +639,82 @@ static void start_factory_upstream(odin_client_session_t *cs) {
                                     odin_connect_session_wants(cs->s));
 }
 
+static void direct_on_done(int fd, int err, void *user_data) {
+  odin_client_session_t *cs = (odin_client_session_t *)user_data;
+  cs_enter(cs);
+  cs->direct_attempt = NULL;
+  note_dial_done(cs);
+  if (cs->on_close_fired) {
+    if (fd >= 0) {
+      (void)close(fd);
+    }
+    cs_leave(cs);
+    return;
+  }
+  if (fd < 0) {
+    handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET,
+                   err != 0 ? err : EHOSTUNREACH);
+    cs_leave(cs);
+    return;
+  }
+  cs->upstream_fd = fd;
+  if (cs->access_log != NULL) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(fd, (struct sockaddr *)&peer, &peer_len) == 0) {
+      odin_access_log_addr_set(&cs->log_rec.upstream,
+                               (struct sockaddr *)&peer, peer_len);
+    }
+  }
+  if (odin_fd_transport_create(cs->loop, fd, client_session_ready, cs,
+                               &cs->upstream_t) != 0) {
+    const int saved = errno;
+    (void)close(cs->upstream_fd);
+    cs->upstream_fd = -1;
+    handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET, saved);
+    cs_leave(cs);
+    return;
+  }
+  cs->state = ODIN_CLIENT_SESSION_S_WRITING_OK_HTTP;
+  cs->http_resp = response_for(cs, ODIN_HTTP_OK, 0);
+  cs->http_resp_off = 0;
+  (void)odin_transport_set_interest(cs->downstream_t, ODIN_TRANSPORT_WRITE);
+  cs_leave(cs);
+}
+
+static void start_direct_upstream(odin_client_session_t *cs) {
+  if (odin_transport_set_interest(cs->downstream_t, 0) != 0) {
+    const int saved = errno;
+    handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET, saved);
+    return;
+  }
+  cs->state = ODIN_CLIENT_SESSION_S_DIRECT;
+  void *attempt = NULL;
+  if (cs->route.start_direct(cs->target_host, cs->target_host_len,
+                             cs->target_port, direct_on_done, cs,
+                             cs->route.direct_user_data, &attempt) != 0) {
+    const int saved = errno;
+    handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET, saved);
+    return;
+  }
+  cs->direct_attempt = attempt;
+}
+
+static void cancel_direct_attempt(odin_client_session_t *cs) {
+  if (cs->direct_attempt == NULL) {
+    return;
+  }
+  void *const attempt = cs->direct_attempt;
+  cs->direct_attempt = NULL;
+  cs->route.cancel_direct(attempt, cs->route.direct_user_data);
+}
+
 static void session_on_done(odin_connect_session_t *s,
                             odin_connect_session_status_t status, int err,
                             void *user_data) {
   (void)s;
   odin_client_session_t *cs = (odin_client_session_t *)user_data;
+  note_dial_done(cs);
   if (status == ODIN_CONNECT_SESSION_ERROR) {
     handle_failure(cs, ODIN_HTTP_ERR_BAD_REQUEST_TARGET, err);
     return;
@@ -365,7 +726,7 @@ static void session_on_done(odin_connect_session_t *s,
     return;
   }
   cs->state = ODIN_CLIENT_SESSION_S_WRITING_OK_HTTP;
-  cs->http_resp = odin_http_response_for_status(ODIN_HTTP_OK);
+  cs->http_resp = response_for(cs, ODIN_HTTP_OK, 0);
   cs->http_resp_off = 0;
   (void)odin_transport_set_interest(cs->upstream_t, 0);
   (void)odin_transport_set_interest(cs->downstream_t, ODIN_TRANSPORT_WRITE);
@@ -373,9 +734,20 @@ static void session_on_done(odin_connect_session_t *s,
 
 static void handle_failure(odin_client_session_t *cs, odin_http_status_t status,
                            int err) {
+  fail_with_response(cs, response_for(cs, status, err), err);
+}
+
+static void fail_with_response(odin_client_session_t *cs,
+                               odin_http_response_t resp, int err) {
   cs->state = ODIN_CLIENT_SESSION_S_WRITING_ERR_HTTP;
   cs->pending_err = err;
-  cs->http_resp = odin_http_response_for_status(status);
+  if (cs->transparent) {
+    /* No status line to carry the error: reset rather than a clean EOF the
+     * application could take for an empty reply. */
+    const struct linger rst = {1, 0};
+    (void)setsockopt(cs->conn_fd, SOL_SOCKET, SO_LINGER, &rst, sizeof(rst));
+  }
+  cs->http_resp = resp;
   cs->http_resp_off = 0;
   if (cs->upstream_t != NULL) {
     (void)odin_transport_set_interest(cs->upstream_t, 0);
@@ -456,7 +828,9 @@ static void drive_write_http_resp(odin_client_session_t *cs,
 
   const uint8_t *client_tail = NULL;
   size_t client_tail_len = 0;
-  odin_connect_session_client_tail(cs->s, &client_tail, &client_tail_len);
+  if (cs->s != NULL) { /* a direct upstream has no CONNECT tail */
+    odin_connect_session_client_tail(cs->s, &client_tail, &client_tail_len);
+  }
   if (client_tail_len > 0) {
 #if defined(ODIN_CLIENT_SESSION_TESTING)
     if (cs->fail_next_client_tail_write_armed) {
@@ -490,8 +864,10 @@ static void drive_write_http_resp(odin_client_session_t *cs,
     }
   }
 
-  odin_connect_session_destroy(cs->s);
-  cs->s = NULL;
+  if (cs->s != NULL) {
+    odin_connect_session_destroy(cs->s);
+    cs->s = NULL;
+  }
 #if defined(ODIN_CLIENT_SESSION_TESTING)
   if (cs->fail_next_relay_create_armed) {
     const int errnum = cs->fail_next_relay_create_errno;
@@ -539,12 +915,27 @@ static void relay_on_done(odin_relay_t *relay, odin_relay_status_t status,
   fire_terminal(cs, e);
 }
 
+/* Completes the RFC-049 record; the relay must still be alive. */
+static void append_access_log(odin_client_session_t *cs, int err) {
+  odin_access_log_record_t *rec = &cs->log_rec;
+  if (cs->relay != NULL) {
+    odin_relay_bytes(cs->relay, &rec->bytes_up, &rec->bytes_down);
+  }
+  rec->err = err;
+  odin_access_log_record_finish(rec);
+  (void)odin_access_log_append(cs->access_log, rec);
+}
+
 static void fire_terminal(odin_client_session_t *cs, int err) {
   if (cs->on_close_fired) {
     return;
   }
   cs->on_close_fired = 1;
   cs->state = ODIN_CLIENT_SESSION_S_TERMINAL;
+  if (cs->access_log != NULL) {
+    append_access_log(cs, err);
+  }
+  cancel_direct_attempt(cs);
   if (cs->relay != NULL) {
     odin_relay_destroy(cs->relay);
     cs->relay = NULL;
@@ -565,6 +956,7 @@ static void fire_terminal(odin_client_session_t *cs, int err) {
     (void)close(cs->conn_fd);
     cs->conn_fd = -1;
   }
+  ODIN_TRACE2(client__session__close, cs, err);
   const odin_client_session_close_cb cb = cs->on_close;
   void *const ud = cs->user_data;
   cb(cs, err, ud);
@@ -575,6 +967,12 @@ static void destroy_upstream_transport(odin_client_session_t *cs,
   if (transport == NULL) {
     return;
   }
+  if (cs->upstream_fd >= 0) { /* direct: not the factory's transport */
+    odin_transport_destroy(transport);
+    (void)close(cs->upstream_fd);
+    cs->upstream_fd = -1;
+    return;
+  }
   if (cs->upstream_destroying != NULL) {
     cs->upstream_destroying(transport, cs->create_upstream_ud);
   }
@@ -1,12 +1,49 @@
 /* odin/client_session.h
  *
  * Client-side per-connection orchestrator session (RFC-023).
+ *
+ * Split routing (RFC-038): odin_client_session_set_route lends the session an
+ * odin_route_table_t and a direct connector. Once the HTTP CONNECT is parsed,
+ * the table picks the upstream: ODIN_ROUTE_TUNNEL takes the upstream transport
+ * factory and the RFC-023 CONNECT handshake as before; ODIN_ROUTE_DIRECT calls
+ * start_direct and, when it reports a connected fd, relays over an fd
+ * transport on it with no CONNECT handshake. The connector reports through
+ * on_done exactly once, never from inside start_direct, unless the session
+ * cancels the attempt first; after cancel_direct returns on_done never fires
+ * and the connector closes any fd it opened. A failed direct attempt answers
+ * the client like a failed tunnel handshake. Without a route (the default)
+ * every CONNECT is tunnelled. The table and connector must outlive the
+ * session; owner-thread, no-op when cs == NULL.
+ *
+ * Transparent mode (RFC-040): odin_client_session_start_transparent skips the
+ * HTTP CONNECT. The session takes dst as the destination, routes it like a
+ * parsed CONNECT, and starts the upstream at once; the client sees no 200,
+ * and a failure resets the connection instead of answering with an HTTP
+ * error. Call it right after create, before the loop runs, and after
+ * odin_client_session_set_route.
+ *
+ * DNS streams (RFC-045): odin_client_session_start_dns_tunnel is transparent
+ * mode toward the reserved ODIN_PROTO_DNS_HOST target. It always takes the
+ * upstream factory, whatever the route table says, and then relays the
+ * DNS_QUERY and DNS_ANSWER frames like any other payload.
+ *
+ * Frontends (RFC-041): a session reads an HTTP CONNECT by default.
+ * odin_client_session_set_frontend switches it to SOCKS5 (RFC 1928 CONNECT,
+ * no authentication) or to AUTO, which picks SOCKS5 when the first byte is
+ * the SOCKS version 0x05 and HTTP otherwise. Routing, the upstream, and the
+ * relay do not depend on the frontend; only the request and the replies do.
  */
 
 #ifndef ODIN_CLIENT_SESSION_H_
 #define ODIN_CLIENT_SESSION_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "odin/access_log.h"
 #include "odin/event_loop.h"
+#include "odin/route.h"
 #include "odin/transport.h"
 
 #ifdef __cplusplus
@@ -25,6 +62,30 @@ typedef int (*odin_client_session_upstream_transport_factory_cb)(
 typedef void (*odin_client_session_upstream_transport_destroying_cb)(
     odin_transport_t *transport, void *factory_user_data);
 
+typedef void (*odin_client_session_direct_done_cb)(int fd, int err,
+                                                  void *done_user_data);
+
+typedef int (*odin_client_session_direct_start_cb)(
+    const char *host, size_t host_len, uint16_t port,
+    odin_client_session_direct_done_cb on_done, void *done_user_data,
+    void *direct_user_data, void **out_attempt);
+
+typedef void (*odin_client_session_direct_cancel_cb)(void *attempt,
+                                                     void *direct_user_data);
+
+typedef enum odin_client_session_frontend_t {
+  ODIN_CLIENT_SESSION_FRONTEND_HTTP = 0,
+  ODIN_CLIENT_SESSION_FRONTEND_SOCKS5,
+  ODIN_CLIENT_SESSION_FRONTEND_AUTO,
+} odin_client_session_frontend_t;
+
+typedef struct odin_client_session_route_t {
+  odin_route_table_t *table;
+  odin_client_session_direct_start_cb start_direct;
+  odin_client_session_direct_cancel_cb cancel_direct;
+  void *direct_user_data;
+} odin_client_session_route_t;
+
 int odin_client_session_create_with_upstream_transport(
     odin_event_loop_t *loop, int conn_fd,
     odin_client_session_upstream_transport_factory_cb create_upstream,
@@ -33,6 +94,35 @@ int odin_client_session_create_with_upstream_transport(
     odin_client_session_close_cb on_close, void *user_data,
     odin_client_session_t **out);
 
+/* Copies *route; NULL (or a NULL table) tunnels every CONNECT. */
+void odin_client_session_set_route(odin_client_session_t *cs,
+                                   const odin_client_session_route_t *route);
+
+/* Selects how the session reads its request; ignored once it has read any
+ * bytes. */
+void odin_client_session_set_frontend(odin_client_session_t *cs,
+                                      odin_client_session_frontend_t frontend);
+
+/* Lends the session the owner loop's RFC-049 access-log ring; NULL (the
+ * default) logs nothing. Call it before the session starts: the record's start
+ * time and the client's address are taken here, and the record is appended as
+ * the session closes (with ECANCELED if it is destroyed first). The ring must
+ * outlive the session. */
+void odin_client_session_set_access_log(odin_client_session_t *cs,
+                                        odin_access_log_ring_t *ring);
+
+/* Starts a transparent session toward dst (AF_INET or AF_INET6, nonzero
+ * port). Returns 0, or -1 with errno EINVAL (bad address, or the session has
+ * already read from the client). Upstream failures are reported through
+ * on_close, never from inside this call. */
+int odin_client_session_start_transparent(odin_client_session_t *cs,
+                                          const struct sockaddr *dst,
+                                          socklen_t dst_len);
+
+/* Starts a transparent session toward the RFC-045 DNS target. Returns 0, or
+ * -1 with errno EINVAL under the same conditions as start_transparent. */
+int odin_client_session_start_dns_tunnel(odin_client_session_t *cs);
+
 void odin_client_session_destroy(odin_client_session_t *cs);
 
 #ifdef __cplusplus
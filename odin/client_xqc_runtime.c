@@ -10,14 +10,20 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <openssl/err.h>
+#include <openssl/sha.h>
 #include <openssl/x509.h>
 
 #include "odin/client_session.h"
+#include "odin/qlog.h"
+#include "odin/trace.h"
 #include "odin/transport.h"
 #include "odin/transport_xqc.h"
+#include "odin/xqc_flush_timer.h"
 
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
 #include "odin/testing/client_xqc_runtime_internal_test.h"
@@ -29,6 +35,9 @@ typedef struct odin_xqc_client_stream_ctx_t odin_xqc_client_stream_ctx_t;
 struct odin_xqc_client_pending_fd_t {
   odin_xqc_client_pending_fd_t *next;
   int fd;
+  socklen_t dst_len; /* RFC-040 transparent destination; 0 for HTTP */
+  struct sockaddr_storage dst;
+  int dns; /* RFC-045 DNS stream; dst_len is 0 */
 };
 
 struct odin_xqc_client_stream_ctx_t {
@@ -56,7 +65,17 @@ struct odin_xqc_client_runtime_t {
   xqc_conn_ssl_config_t conn_ssl_config;
   char empty_session_ticket;
   X509_STORE *ca_store;
+  odin_cert_cache_t *cert_cache; /* RFC-042, lent; NULL without ca_file */
   int no_crypto_flag;
+  odin_client_session_route_t route;
+  odin_client_session_frontend_t frontend;
+  odin_access_log_ring_t *access_log; /* RFC-049, lent; NULL: not logged */
+  odin_qlog_ring_t *qlog;             /* RFC-050, owned; NULL: off */
+  int qlog_traced;                    /* RFC-050: qlog_cid is being traced */
+  xqc_cid_t qlog_cid;
+  uint64_t conns_opened;             /* RFC-051 */
+  odin_xqc_runtime_totals_t closed; /* RFC-051: closed connections only */
+  odin_xqc_send_backlog_t send_backlog; /* RFC-035 send probe */
 
   xqc_connection_t *conn;
   xqc_cid_t current_cid;
@@ -468,6 +487,116 @@ static int runtime_leaf_identity_matches(X509 *leaf, const char *server_host) {
                          X509_CHECK_FLAG_NEVER_CHECK_SUBJECT, NULL) == 1;
 }
 
+static uint64_t runtime_wall_ms(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static uint64_t runtime_monotonic_ns(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void runtime_sha256_len(SHA256_CTX *sha, uint64_t len) {
+  uint8_t be[8];
+  for (size_t i = 0; i < sizeof(be); ++i) {
+    be[i] = (uint8_t)(len >> (56u - 8u * i));
+  }
+  SHA256_Update(sha, be, sizeof(be));
+}
+
+/* RFC-042 cache key: the expected host and every presented certificate,
+ * each length-prefixed so no two (host, chain) pairs share an encoding. */
+static void runtime_chain_digest(const char *host, const unsigned char *certs[],
+                                 const size_t cert_len[], size_t certs_len,
+                                 uint8_t out[ODIN_CERT_CACHE_DIGEST_LEN]) {
+  SHA256_CTX sha;
+  SHA256_Init(&sha);
+  const size_t host_len = strlen(host);
+  runtime_sha256_len(&sha, host_len);
+  SHA256_Update(&sha, host, host_len);
+  runtime_sha256_len(&sha, certs_len);
+  for (size_t i = 0; i < certs_len; ++i) {
+    runtime_sha256_len(&sha, cert_len[i]);
+    SHA256_Update(&sha, certs[i], cert_len[i]);
+  }
+  SHA256_Final(out, &sha);
+}
+
+/* RFC-042 cache anchor: the CA file's path and on-disk identity, so an edit
+ * or replacement of the file invalidates results verified against it. */
+static void runtime_ca_anchor_digest(const char *ca_file,
+                                     uint8_t out[ODIN_CERT_CACHE_DIGEST_LEN]) {
+  SHA256_CTX sha;
+  SHA256_Init(&sha);
+  const size_t path_len = strlen(ca_file);
+  runtime_sha256_len(&sha, path_len);
+  SHA256_Update(&sha, ca_file, path_len);
+  struct stat st;
+  if (stat(ca_file, &st) == 0) {
+    runtime_sha256_len(&sha, (uint64_t)st.st_dev);
+    runtime_sha256_len(&sha, (uint64_t)st.st_ino);
+    runtime_sha256_len(&sha, (uint64_t)st.st_size);
+#if defined(__APPLE__)
+    const struct timespec mtim = st.st_mtimespec;
+    const struct timespec ctim = st.st_ctimespec;
+#else
+    const struct timespec mtim = st.st_mtim;
+    const struct timespec ctim = st.st_ctim;
+#endif
+    runtime_sha256_len(&sha, (uint64_t)mtim.tv_sec);
+    runtime_sha256_len(&sha, (uint64_t)mtim.tv_nsec);
+    runtime_sha256_len(&sha, (uint64_t)ctim.tv_sec);
+    runtime_sha256_len(&sha, (uint64_t)ctim.tv_nsec);
+  }
+  SHA256_Final(out, &sha);
+}
+
+/* Earliest notAfter across the verified chain, trust anchor included, as
+ * wall-clock milliseconds; 0 when any is unreadable or already past. */
+static uint64_t runtime_chain_not_after_ms(X509_STORE_CTX *ctx,
+                                           uint64_t now_ms) {
+  STACK_OF(X509) *chain = X509_STORE_CTX_get0_chain(ctx);
+  if (chain == NULL || sk_X509_num(chain) <= 0) {
+    return 0;
+  }
+  uint64_t earliest = UINT64_MAX;
+  for (size_t i = 0; i < (size_t)sk_X509_num(chain); ++i) {
+    int days = 0;
+    int secs = 0;
+    if (ASN1_TIME_diff(&days, &secs, NULL,
+                       X509_get0_notAfter(sk_X509_value(chain, i))) != 1) {
+      return 0;
+    }
+    const int64_t left_s = (int64_t)days * 86400 + secs;
+    if (left_s <= 0) {
+      return 0;
+    }
+    const uint64_t at = now_ms + (uint64_t)left_s * 1000u;
+    if (at < earliest) {
+      earliest = at;
+    }
+  }
+  return earliest;
+}
+
+static int runtime_chain_is_complete(const unsigned char *certs[],
+                                     const size_t cert_len[],
+                                     size_t certs_len) {
+  for (size_t i = 0; i < certs_len; ++i) {
+    if (certs[i] == NULL || cert_len[i] == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 static int runtime_ca_file_cert_verify(const unsigned char *certs[],
                                        const size_t cert_len[],
                                        size_t certs_len, void *conn_user_data) {
@@ -478,6 +607,9 @@ static int runtime_ca_file_cert_verify(const unsigned char *certs[],
   STACK_OF(X509) *intermediates = NULL;
   X509_STORE_CTX *ctx = NULL;
   const int store_ctx_failpoint = runtime_test_take_store_ctx_failpoint();
+  int cache_key_set = 0;
+  uint8_t cache_key[ODIN_CERT_CACHE_DIGEST_LEN];
+  uint64_t verify_start_ns = 0;
 
   odin_xqc_client_runtime_t *rt = NULL;
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
@@ -492,6 +624,18 @@ static int runtime_ca_file_cert_verify(const unsigned char *certs[],
     goto end;
   }
 
+  if (rt->cert_cache != NULL && runtime_chain_is_complete(certs, cert_len,
+                                                          certs_len)) {
+    runtime_chain_digest(rt->server_host, certs, cert_len, certs_len,
+                         cache_key);
+    cache_key_set = 1;
+    if (odin_cert_cache_lookup(rt->cert_cache, cache_key, runtime_wall_ms())) {
+      ok = 1;
+      goto end;
+    }
+    verify_start_ns = runtime_monotonic_ns();
+  }
+
   leaf = runtime_parse_der_cert_exact(certs[0], cert_len[0], 1);
   if (leaf == NULL) {
     goto end;
@@ -552,11 +696,20 @@ static int runtime_ca_file_cert_verify(const unsigned char *certs[],
 
   if (X509_verify_cert(ctx) == 1) {
     ok = 1;
+    if (cache_key_set) {
+      const uint64_t now_ms = runtime_wall_ms();
+      odin_cert_cache_insert(rt->cert_cache, cache_key,
+                             runtime_chain_not_after_ms(ctx, now_ms), now_ms);
+    }
   } else {
     x509_error = X509_STORE_CTX_get_error(ctx);
   }
 
 end:
+  if (verify_start_ns != 0) {
+    odin_cert_cache_record_verify(rt->cert_cache,
+                                  runtime_monotonic_ns() - verify_start_ns);
+  }
   if (ctx != NULL) {
     runtime_test_count_store_ctx_free();
     X509_STORE_CTX_free(ctx);
@@ -915,6 +1068,16 @@ static xqc_int_t runtime_conn_close_call(xqc_engine_t *engine,
 #endif
 }
 
+static xqc_conn_stats_t runtime_conn_get_stats_call(xqc_engine_t *engine,
+                                                    const xqc_cid_t *cid) {
+#if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
+  if (g_client_xqc_test_ops.conn_get_stats != NULL) {
+    return g_client_xqc_test_ops.conn_get_stats(engine, cid);
+  }
+#endif
+  return xqc_conn_get_stats(engine, cid);
+}
+
 static void *
 runtime_get_conn_alp_user_data_by_stream_call(xqc_stream_t *stream) {
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
@@ -1120,6 +1283,8 @@ static void runtime_finish_destroy(odin_xqc_client_runtime_t *rt) {
     runtime_udp_destroy_call(rt->xu);
     rt->xu = NULL;
   }
+  odin_qlog_ring_destroy(rt->qlog);
+  rt->qlog = NULL;
   rt->force_destroy_active = 0;
   runtime_ca_store_free(rt->ca_store);
   rt->ca_store = NULL;
@@ -1204,16 +1369,32 @@ runtime_find_stream_by_transport(odin_xqc_client_runtime_t *rt,
   return NULL;
 }
 
+/* RFC-035: forgets the stream's transport ahead of its destroy. When the
+ * stream may still send, the coalesced bytes and a pending fin go to xquic
+ * first; whatever is left is counted as lost. */
+static void
+runtime_stream_ctx_drop_transport(odin_xqc_client_stream_ctx_t *stream_ctx,
+                                  int may_send) {
+  if (stream_ctx->transport == NULL) {
+    return;
+  }
+  if (may_send) {
+    (void)odin_xqc_stream_transport_flush(stream_ctx->transport);
+  }
+  stream_ctx->rt->closed.bytes_unsent +=
+      odin_xqc_stream_transport_unsent(stream_ctx->transport);
+  runtime_stream_ctx_unlink_map(stream_ctx);
+  stream_ctx->transport = NULL;
+}
+
 static void
 runtime_destroy_stream_ctx_unlinked(odin_xqc_client_stream_ctx_t *stream_ctx,
                                     int close_stream) {
   xqc_stream_t *stream = stream_ctx->stream;
   odin_client_session_t *cs = stream_ctx->cs;
   stream_ctx->cs = NULL;
-  if (stream_ctx->transport != NULL) {
-    runtime_stream_ctx_unlink_map(stream_ctx);
-    stream_ctx->transport = NULL;
-  }
+  runtime_stream_ctx_drop_transport(
+      stream_ctx, close_stream && !stream_ctx->rt->force_destroy_active);
   if (cs != NULL) {
     odin_client_session_destroy(cs);
   }
@@ -1252,7 +1433,9 @@ static int runtime_maybe_finish_destroy(odin_xqc_client_runtime_t *rt) {
   return 1;
 }
 
-static int append_pending_local_fd(odin_xqc_client_runtime_t *rt, int conn_fd) {
+static int append_pending_local_fd(odin_xqc_client_runtime_t *rt, int conn_fd,
+                                   const struct sockaddr *dst,
+                                   socklen_t dst_len, int dns) {
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
   if (rt->fail_next_pending_queue_append_armed) {
     const int errnum = rt->fail_next_pending_queue_append_errno;
@@ -1269,6 +1452,11 @@ static int append_pending_local_fd(odin_xqc_client_runtime_t *rt, int conn_fd) {
     return -1;
   }
   node->fd = conn_fd;
+  node->dst_len = dst_len;
+  node->dns = dns;
+  if (dst_len > 0) {
+    memcpy(&node->dst, dst, dst_len);
+  }
   node->next = NULL;
   if (rt->pending_tail != NULL) {
     rt->pending_tail->next = node;
@@ -1286,10 +1474,35 @@ int odin_xqc_client_runtime_test_append_pending_fd(
     errno = EINVAL;
     return -1;
   }
-  return append_pending_local_fd(rt, conn_fd);
+  return append_pending_local_fd(rt, conn_fd, NULL, 0, 0);
 }
 #endif
 
+/* RFC-035 send probe: the bytes xquic holds for the connection, queued or
+ * unacknowledged, which the stream transport's send watermarks compare
+ * against. */
+static uint64_t runtime_send_unacked(void *user_data) {
+  odin_xqc_client_runtime_t *rt = (odin_xqc_client_runtime_t *)user_data;
+  const xqc_conn_stats_t st = runtime_conn_get_stats_call(
+      odin_xqc_udp_engine(rt->xu), &rt->current_cid);
+  return odin_xqc_send_backlog_update(&rt->send_backlog, &st);
+}
+
+static void runtime_send_accepted(void *user_data, size_t n) {
+  odin_xqc_client_runtime_t *rt = (odin_xqc_client_runtime_t *)user_data;
+  odin_xqc_send_backlog_accepted(&rt->send_backlog, n);
+}
+
+static void runtime_enable_coalescing(odin_xqc_client_runtime_t *rt,
+                                      odin_transport_t *t) {
+  odin_xqc_flush_timer_install(t, rt->loop);
+  odin_xqc_send_probe_t probe;
+  probe.unacked = runtime_send_unacked;
+  probe.accepted = runtime_send_accepted;
+  probe.ctx = rt;
+  odin_xqc_stream_transport_set_send_probe(t, &probe);
+}
+
 static int xqc_client_upstream_factory(odin_transport_ready_cb on_ready,
                                        void *ready_user_data,
                                        void *factory_user_data,
@@ -1316,6 +1529,7 @@ static int xqc_client_upstream_factory(odin_transport_ready_cb on_ready,
     errno = saved;
     return -1;
   }
+  runtime_enable_coalescing(rt, *out);
   stream_ctx->stream = stream;
   stream_ctx->transport = *out;
   runtime_stream_ctx_link_map(rt, stream_ctx);
@@ -1323,7 +1537,8 @@ static int xqc_client_upstream_factory(odin_transport_ready_cb on_ready,
 }
 
 static int create_one_client_session(odin_xqc_client_runtime_t *rt,
-                                     int conn_fd) {
+                                     int conn_fd, const struct sockaddr *dst,
+                                     socklen_t dst_len, int dns) {
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
   if (rt->fail_next_stream_context_alloc_armed) {
     const int errnum = rt->fail_next_stream_context_alloc_errno;
@@ -1349,7 +1564,17 @@ static int create_one_client_session(odin_xqc_client_runtime_t *rt,
     errno = saved;
     return -1;
   }
+  odin_client_session_set_route(stream_ctx->cs, &rt->route);
+  odin_client_session_set_frontend(stream_ctx->cs, rt->frontend);
+  odin_client_session_set_access_log(stream_ctx->cs, rt->access_log);
   runtime_stream_ctx_link_session(rt, stream_ctx);
+  if (dst_len > 0) {
+    /* dst passed transparent_dst_valid and the session is fresh, so this
+     * cannot fail; upstream errors arrive through on_close. */
+    (void)odin_client_session_start_transparent(stream_ctx->cs, dst, dst_len);
+  } else if (dns) {
+    (void)odin_client_session_start_dns_tunnel(stream_ctx->cs);
+  }
   return 0;
 }
 
@@ -1439,6 +1664,15 @@ int odin_xqc_client_runtime_create(
   rt->app_callbacks.stream_cbs.stream_closing_notify =
       runtime_stream_closing_notify;
 
+  if (config->qlog != NULL &&
+      odin_qlog_ring_create(config->qlog, 0, &rt->qlog) != 0) {
+    const int saved = errno;
+    runtime_free_copied_config(rt);
+    free(rt);
+    errno = saved;
+    return -1;
+  }
+
   odin_xqc_udp_config_t udp_config;
   memset(&udp_config, 0, sizeof(udp_config));
   udp_config.loop = config->loop;
@@ -1450,8 +1684,10 @@ int odin_xqc_client_runtime_create(
   udp_config.engine_callbacks = config->engine_callbacks;
   udp_config.transport_callbacks = &rt->transport_callbacks;
   udp_config.app_user_data = rt;
+  udp_config.qlog = rt->qlog;
   if (runtime_udp_create_call(&udp_config, &rt->xu) != 0) {
     const int saved = errno;
+    odin_qlog_ring_destroy(rt->qlog);
     runtime_free_copied_config(rt);
     free(rt);
     errno = saved;
@@ -1462,6 +1698,7 @@ int odin_xqc_client_runtime_create(
                                         sizeof(ODIN_XQC_CLIENT_ALPN) - 1u,
                                         &rt->app_callbacks, rt) != XQC_OK) {
     runtime_udp_destroy_call(rt->xu);
+    odin_qlog_ring_destroy(rt->qlog);
     runtime_free_copied_config(rt);
     free(rt);
     errno = EIO;
@@ -1519,6 +1756,7 @@ int odin_xqc_client_runtime_create_default(
   full_config.token = NULL;
   full_config.token_len = 0;
   full_config.no_crypto_flag = 0;
+  full_config.qlog = config->qlog;
 
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
   g_client_xqc_test_record.default_create_calls += 1;
@@ -1545,7 +1783,13 @@ int odin_xqc_client_runtime_create_default(
   X509_STORE *ca_store = NULL;
   xqc_transport_callbacks_t transport_callbacks;
   memset(&transport_callbacks, 0, sizeof(transport_callbacks));
+  uint8_t ca_anchor[ODIN_CERT_CACHE_DIGEST_LEN];
   if (config->ca_file != NULL) {
+    /* Taken before the load: a file replaced in between then looks changed
+     * to the next runtime, never unchanged. */
+    if (config->cert_cache != NULL) {
+      runtime_ca_anchor_digest(config->ca_file, ca_anchor);
+    }
     if (runtime_load_ca_store(config->ca_file, &ca_store) != 0) {
       return -1;
     }
@@ -1594,6 +1838,10 @@ int odin_xqc_client_runtime_create_default(
   }
   if (ca_store != NULL) {
     (*out)->ca_store = ca_store;
+    if (config->cert_cache != NULL) {
+      odin_cert_cache_set_anchor(config->cert_cache, ca_anchor);
+      (*out)->cert_cache = config->cert_cache;
+    }
 #if defined(ODIN_XQC_CLIENT_RUNTIME_TESTING)
     g_client_xqc_test_record.runtime_owned_ca_store_present = 1;
     g_client_xqc_test_record.verifier_user_data =
@@ -1678,16 +1926,53 @@ int odin_xqc_client_runtime_stop(odin_xqc_client_runtime_t *rt) {
   return 0;
 }
 
-int odin_xqc_client_runtime_add_connection(odin_xqc_client_runtime_t *rt,
-                                           int conn_fd) {
+static int add_local_connection(odin_xqc_client_runtime_t *rt, int conn_fd,
+                                const struct sockaddr *dst, socklen_t dst_len,
+                                int dns) {
   if (rt == NULL || rt->closing || !rt->connect_started || !rt->udp_running) {
     errno = ENOTCONN;
     return -1;
   }
   if (!rt->handshake_done) {
-    return append_pending_local_fd(rt, conn_fd);
+    return append_pending_local_fd(rt, conn_fd, dst, dst_len, dns);
   }
-  return create_one_client_session(rt, conn_fd);
+  return create_one_client_session(rt, conn_fd, dst, dst_len, dns);
+}
+
+int odin_xqc_client_runtime_add_connection(odin_xqc_client_runtime_t *rt,
+                                           int conn_fd) {
+  return add_local_connection(rt, conn_fd, NULL, 0, 0);
+}
+
+static int transparent_dst_valid(const struct sockaddr *dst,
+                                 socklen_t dst_len) {
+  if (dst == NULL) {
+    return 0;
+  }
+  if (dst->sa_family == AF_INET) {
+    return dst_len == (socklen_t)sizeof(struct sockaddr_in) &&
+           ((const struct sockaddr_in *)dst)->sin_port != 0;
+  }
+  if (dst->sa_family == AF_INET6) {
+    return dst_len == (socklen_t)sizeof(struct sockaddr_in6) &&
+           ((const struct sockaddr_in6 *)dst)->sin6_port != 0;
+  }
+  return 0;
+}
+
+int odin_xqc_client_runtime_add_transparent_connection(
+    odin_xqc_client_runtime_t *rt, int conn_fd, const struct sockaddr *dst,
+    socklen_t dst_len) {
+  if (!transparent_dst_valid(dst, dst_len)) {
+    errno = EINVAL;
+    return -1;
+  }
+  return add_local_connection(rt, conn_fd, dst, dst_len, 0);
+}
+
+int odin_xqc_client_runtime_add_dns_connection(odin_xqc_client_runtime_t *rt,
+                                               int conn_fd) {
+  return add_local_connection(rt, conn_fd, NULL, 0, 1);
 }
 
 static void force_destroy_stopped_connection(odin_xqc_client_runtime_t *rt) {
@@ -1703,6 +1988,118 @@ static void force_destroy_stopped_connection(odin_xqc_client_runtime_t *rt) {
   rt->connect_started = 0;
 }
 
+int odin_xqc_client_runtime_health(const odin_xqc_client_runtime_t *rt,
+                                   odin_xqc_client_runtime_health_t *out) {
+  if (rt == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  memset(out, 0, sizeof(*out));
+  if (rt->closing || rt->destroy_pending || !rt->connect_started) {
+    out->state = ODIN_XQC_CLIENT_RUNTIME_CLOSED;
+    return 0;
+  }
+  if (!rt->handshake_done || rt->conn == NULL || !rt->cid_registered) {
+    out->state = ODIN_XQC_CLIENT_RUNTIME_CONNECTING;
+    return 0;
+  }
+  const xqc_conn_stats_t st = runtime_conn_get_stats_call(
+      odin_xqc_udp_engine(rt->xu), &rt->current_cid);
+  out->state = ODIN_XQC_CLIENT_RUNTIME_READY;
+  out->srtt_us = st.srtt;
+  out->sent = st.send_count;
+  out->lost = st.lost_count;
+  return 0;
+}
+
+/* RFC-051: the snapshot of the live connection; rt->conn must be set. */
+static void runtime_conn_snapshot(const odin_xqc_client_runtime_t *rt,
+                                  odin_xqc_conn_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  const xqc_conn_stats_t st = runtime_conn_get_stats_call(
+      odin_xqc_udp_engine(rt->xu), &rt->current_cid);
+  odin_xqc_conn_stats_fill(&st, out);
+  out->cid_len = rt->current_cid.cid_len;
+  memcpy(out->cid, rt->current_cid.cid_buf, rt->current_cid.cid_len);
+  out->peer_len = rt->peer_addrlen;
+  memcpy(&out->peer, &rt->peer_addr_storage, rt->peer_addrlen);
+  for (const odin_xqc_client_stream_ctx_t *stream_ctx =
+           rt->streams_by_transport;
+       stream_ctx != NULL; stream_ctx = stream_ctx->map_next) {
+    if (stream_ctx->stream != NULL) {
+      out->active_streams += 1;
+    }
+  }
+}
+
+static int runtime_conn_is_live(const odin_xqc_client_runtime_t *rt) {
+  return rt->conn != NULL && rt->cid_registered;
+}
+
+int odin_xqc_client_runtime_stats(const odin_xqc_client_runtime_t *rt,
+                                  odin_xqc_conn_stats_t *out, size_t cap,
+                                  size_t *count) {
+  if (rt == NULL || (out == NULL && cap > 0) || count == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  *count = 0;
+  if (runtime_conn_is_live(rt)) {
+    if (cap > 0) {
+      runtime_conn_snapshot(rt, &out[0]);
+    }
+    *count = 1;
+  }
+  return 0;
+}
+
+int odin_xqc_client_runtime_totals(const odin_xqc_client_runtime_t *rt,
+                                   odin_xqc_runtime_totals_t *out) {
+  if (rt == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  *out = rt->closed;
+  out->conns_opened = rt->conns_opened;
+  if (runtime_conn_is_live(rt)) {
+    odin_xqc_conn_stats_t snap;
+    runtime_conn_snapshot(rt, &snap);
+    odin_xqc_runtime_totals_add(out, &snap);
+    out->conns_active = 1;
+    out->streams_active = snap.active_streams;
+    out->srtt_us_max = snap.srtt_us;
+  }
+  return 0;
+}
+
+void odin_xqc_client_runtime_set_route(
+    odin_xqc_client_runtime_t *rt, const odin_client_session_route_t *route) {
+  if (rt == NULL) {
+    return;
+  }
+  if (route == NULL) {
+    memset(&rt->route, 0, sizeof(rt->route));
+    return;
+  }
+  rt->route = *route;
+}
+
+void odin_xqc_client_runtime_set_frontend(
+    odin_xqc_client_runtime_t *rt, odin_client_session_frontend_t frontend) {
+  if (rt == NULL) {
+    return;
+  }
+  rt->frontend = frontend;
+}
+
+void odin_xqc_client_runtime_set_access_log(odin_xqc_client_runtime_t *rt,
+                                            odin_access_log_ring_t *ring) {
+  if (rt == NULL) {
+    return;
+  }
+  rt->access_log = ring;
+}
+
 void odin_xqc_client_runtime_destroy(odin_xqc_client_runtime_t *rt) {
   if (rt == NULL) {
     return;
@@ -1755,6 +2152,26 @@ void odin_xqc_client_runtime_force_destroy(odin_xqc_client_runtime_t *rt) {
   runtime_finish_destroy(rt);
 }
 
+/* RFC-050: decides once, as the connection is created, whether it is
+ * traced. */
+static void runtime_qlog_begin(odin_xqc_client_runtime_t *rt,
+                               const xqc_cid_t *cid) {
+  if (rt->qlog == NULL) {
+    return;
+  }
+  rt->qlog_cid = *cid;
+  rt->qlog_traced = odin_qlog_conn_begin(
+      rt->qlog, cid->cid_buf, cid->cid_len,
+      (const struct sockaddr *)&rt->peer_addr_storage, rt->peer_addrlen);
+}
+
+static void runtime_qlog_end(odin_xqc_client_runtime_t *rt) {
+  if (rt->qlog_traced) {
+    odin_qlog_conn_end(rt->qlog, rt->qlog_cid.cid_buf, rt->qlog_cid.cid_len);
+    rt->qlog_traced = 0;
+  }
+}
+
 static int runtime_conn_create_notify(xqc_connection_t *conn,
                                       const xqc_cid_t *cid,
                                       void *conn_user_data,
@@ -1781,7 +2198,10 @@ static int runtime_conn_create_notify(xqc_connection_t *conn,
   rt->conn = conn;
   rt->current_cid = *cid;
   rt->cid_registered = 1;
+  rt->conns_opened += 1;
   runtime_conn_set_alp_user_data_call(conn, rt);
+  runtime_qlog_begin(rt, cid);
+  ODIN_TRACE2(quic__conn__create, conn, 0);
   return 0;
 }
 
@@ -1802,6 +2222,13 @@ static int runtime_conn_close_notify(xqc_connection_t *conn,
   if (rt->force_destroy_active) {
     return 0;
   }
+  ODIN_TRACE2(quic__conn__close, conn, 0);
+  runtime_qlog_end(rt);
+  if (runtime_conn_is_live(rt)) {
+    odin_xqc_conn_stats_t snap;
+    runtime_conn_snapshot(rt, &snap);
+    odin_xqc_runtime_totals_add(&rt->closed, &snap);
+  }
   if (rt->startup_connecting && !rt->connect_started && !rt->destroy_pending) {
     if (rt->cid_registered) {
       runtime_udp_unregister_conn_call(rt->xu, &rt->current_cid);
@@ -1837,6 +2264,7 @@ static void runtime_conn_handshake_finished(xqc_connection_t *conn,
     return;
   }
   rt->handshake_done = 1;
+  ODIN_TRACE2(quic__handshake__done, conn, 0);
   while (rt->pending_head != NULL) {
     odin_xqc_client_pending_fd_t *node = rt->pending_head;
     rt->pending_head = node->next;
@@ -1844,8 +2272,10 @@ static void runtime_conn_handshake_finished(xqc_connection_t *conn,
       rt->pending_tail = NULL;
     }
     const int fd = node->fd;
+    const int rc = create_one_client_session(
+        rt, fd, (const struct sockaddr *)&node->dst, node->dst_len, node->dns);
     free(node);
-    if (create_one_client_session(rt, fd) != 0) {
+    if (rc != 0) {
       (void)close(fd);
     }
   }
@@ -1935,14 +2365,15 @@ static void runtime_stream_closing_notify(xqc_stream_t *stream,
   odin_xqc_stream_transport_closing_notify(stream, err_code, strm_user_data);
 }
 
+/* The session is closing outside xquic's close callbacks (those destroy the
+ * session with the transport already dropped), so the stream may still send. */
 static void
 runtime_client_session_upstream_destroying(odin_transport_t *transport,
                                            void *factory_user_data) {
   odin_xqc_client_stream_ctx_t *stream_ctx =
       (odin_xqc_client_stream_ctx_t *)factory_user_data;
   if (stream_ctx->transport == transport) {
-    runtime_stream_ctx_unlink_map(stream_ctx);
-    stream_ctx->transport = NULL;
+    runtime_stream_ctx_drop_transport(stream_ctx, 1);
   }
 }
 
@@ -1951,10 +2382,7 @@ static void runtime_client_session_on_close(odin_client_session_t *cs, int err,
   odin_xqc_client_stream_ctx_t *stream_ctx =
       (odin_xqc_client_stream_ctx_t *)user_data;
   xqc_stream_t *stream = stream_ctx->stream;
-  if (stream_ctx->transport != NULL) {
-    runtime_stream_ctx_unlink_map(stream_ctx);
-    stream_ctx->transport = NULL;
-  }
+  runtime_stream_ctx_drop_transport(stream_ctx, 1);
   runtime_stream_ctx_unlink_session(stream_ctx);
   stream_ctx->cs = NULL;
   odin_client_session_destroy(cs);
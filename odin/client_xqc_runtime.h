@@ -3,9 +3,15 @@
 #ifndef ODIN_CLIENT_XQC_RUNTIME_H_
 #define ODIN_CLIENT_XQC_RUNTIME_H_
 
+#include <stdint.h>
 #include <sys/socket.h>
 
+#include "odin/access_log.h"
+#include "odin/cert_cache.h"
+#include "odin/client_session.h"
 #include "odin/event_loop.h"
+#include "odin/qlog.h"
+#include "odin/xqc_conn_stats.h"
 #include "odin/xqc_udp.h"
 #include <xquic/xquic.h>
 
@@ -33,6 +39,9 @@ typedef struct odin_xqc_client_runtime_config_t {
   const unsigned char *token;
   unsigned int token_len;
   int no_crypto_flag;
+  /* RFC-050: optional, lent; must outlive the runtime. The runtime traces a
+   * sample of its connections into it through a ring of its own. */
+  odin_qlog_t *qlog;
 } odin_xqc_client_runtime_config_t;
 
 typedef struct odin_xqc_client_runtime_default_config_t {
@@ -43,8 +52,25 @@ typedef struct odin_xqc_client_runtime_default_config_t {
   socklen_t peer_addrlen;
   const char *server_host;
   const char *ca_file;
+  /* RFC-042: optional verification cache, lent; must outlive the runtime.
+   * Used only with ca_file, whose identity becomes the cache anchor. */
+  odin_cert_cache_t *cert_cache;
+  odin_qlog_t *qlog; /* RFC-050: as in odin_xqc_client_runtime_config_t */
 } odin_xqc_client_runtime_default_config_t;
 
+typedef enum odin_xqc_client_runtime_conn_state_t {
+  ODIN_XQC_CLIENT_RUNTIME_CONNECTING = 0, /* started, handshake pending */
+  ODIN_XQC_CLIENT_RUNTIME_READY,          /* handshake done, taking fds */
+  ODIN_XQC_CLIENT_RUNTIME_CLOSED,         /* connection gone for good   */
+} odin_xqc_client_runtime_conn_state_t;
+
+typedef struct odin_xqc_client_runtime_health_t {
+  odin_xqc_client_runtime_conn_state_t state;
+  uint64_t srtt_us; /* READY only: xquic's smoothed RTT        */
+  uint64_t sent;    /* READY only: packets sent on the conn    */
+  uint64_t lost;    /* READY only: packets declared lost       */
+} odin_xqc_client_runtime_health_t;
+
 int odin_xqc_client_runtime_create(
     const odin_xqc_client_runtime_config_t *config,
     odin_xqc_client_runtime_t **out);
@@ -55,6 +81,45 @@ int odin_xqc_client_runtime_start(odin_xqc_client_runtime_t *rt);
 int odin_xqc_client_runtime_stop(odin_xqc_client_runtime_t *rt);
 int odin_xqc_client_runtime_add_connection(odin_xqc_client_runtime_t *rt,
                                            int conn_fd);
+/* Transparent-mode variant (RFC-040): conn_fd was redirected to the listener
+ * and dst (AF_INET or AF_INET6 with a nonzero port) is where it was headed.
+ * The session skips the HTTP CONNECT and tunnels to dst directly. Returns 0,
+ * or -1 with errno EINVAL (bad dst) or as the plain add above. */
+int odin_xqc_client_runtime_add_transparent_connection(
+    odin_xqc_client_runtime_t *rt, int conn_fd, const struct sockaddr *dst,
+    socklen_t dst_len);
+/* DNS-stream variant (RFC-045): conn_fd carries DNS_QUERY frames from an
+ * odin_dns_tunnel_client_t, and the session opens a stream to the server's
+ * DNS responder instead of parsing a request. Errors as the plain add. */
+int odin_xqc_client_runtime_add_dns_connection(odin_xqc_client_runtime_t *rt,
+                                               int conn_fd);
+/* Health of the runtime's connection for upstream selection (RFC-039).
+ * A runtime that was never started, or whose connection closed, is CLOSED
+ * and refuses odin_xqc_client_runtime_add_connection with ENOTCONN. Returns 0,
+ * or -1 with errno EINVAL. */
+int odin_xqc_client_runtime_health(const odin_xqc_client_runtime_t *rt,
+                                   odin_xqc_client_runtime_health_t *out);
+/* RFC-051: as odin_xqc_server_runtime_stats; the client has at most one
+ * connection, whose peer is the configured server address. */
+int odin_xqc_client_runtime_stats(const odin_xqc_client_runtime_t *rt,
+                                  odin_xqc_conn_stats_t *out, size_t cap,
+                                  size_t *count);
+int odin_xqc_client_runtime_totals(const odin_xqc_client_runtime_t *rt,
+                                   odin_xqc_runtime_totals_t *out);
+/* Copies *route into the runtime and lends it to every later local
+ * connection's client session (RFC-038); NULL tunnels every CONNECT. The table
+ * and connector must outlive the runtime and its sessions. */
+void odin_xqc_client_runtime_set_route(
+    odin_xqc_client_runtime_t *rt, const odin_client_session_route_t *route);
+/* How later local connections' sessions read their request (RFC-041);
+ * HTTP CONNECT until set. */
+void odin_xqc_client_runtime_set_frontend(
+    odin_xqc_client_runtime_t *rt, odin_client_session_frontend_t frontend);
+/* Lends every later local connection's session the loop's RFC-049
+ * access-log ring; NULL logs nothing. The ring must outlive the runtime and
+ * its sessions. */
+void odin_xqc_client_runtime_set_access_log(odin_xqc_client_runtime_t *rt,
+                                            odin_access_log_ring_t *ring);
 void odin_xqc_client_runtime_destroy(odin_xqc_client_runtime_t *rt);
 void odin_xqc_client_runtime_force_destroy(odin_xqc_client_runtime_t *rt);
 
@@ -66,8 +66,18 @@ struct odin_connect_session_t {
   /* Fault state. */
   int err;
   int on_done_fired;
+
+  /* Caller storage (create_*_in): destroy frees nothing. */
+  int embedded;
 };
 
+_Static_assert(sizeof(struct odin_connect_session_t) <=
+                   sizeof(odin_connect_session_storage_t),
+               "ODIN_CONNECT_SESSION_STORAGE_SIZE too small");
+_Static_assert(_Alignof(struct odin_connect_session_t) <=
+                   _Alignof(odin_connect_session_storage_t),
+               "odin_connect_session_storage_t under-aligned");
+
 #if defined(ODIN_CONNECT_SESSION_TESTING)
 static unsigned int g_connect_session_live_count;
 static int g_fail_next_create_client_armed;
@@ -100,29 +110,10 @@ static void fire_on_done_once(odin_connect_session_t *s) {
   cb(s, status, err, ud);
 }
 
-int odin_connect_session_create_client(const char *host, size_t host_len,
-                                       uint16_t port,
-                                       odin_connect_session_done_cb on_done,
-                                       void *user_data,
-                                       odin_connect_session_t **out) {
-#if defined(ODIN_CONNECT_SESSION_TESTING)
-  if (g_fail_next_create_client_armed) {
-    const int errnum = g_fail_next_create_client_errno;
-    g_fail_next_create_client_armed = 0;
-    g_fail_next_create_client_errno = 0;
-    errno = errnum;
-    return -1;
-  }
-#endif
-  if (host_len < 1 || host_len > ODIN_PROTO_HOST_MAX) {
-    errno = EINVAL;
-    return -1;
-  }
-  odin_connect_session_t *s = (odin_connect_session_t *)calloc(1, sizeof(*s));
-  if (s == NULL) {
-    errno = ENOMEM;
-    return -1;
-  }
+/* Client-mode setup on zeroed storage: encodes the CONNECT_REQ into s->buf. */
+static void init_client(odin_connect_session_t *s, const char *host,
+                        size_t host_len, uint16_t port,
+                        odin_connect_session_done_cb on_done, void *user_data) {
   s->mode = ODIN_CONNECT_SESSION_MODE_CLIENT;
   s->state = ODIN_CONNECT_SESSION_C_WRITING_REQ;
   s->on_done = on_done;
@@ -133,8 +124,8 @@ int odin_connect_session_create_client(const char *host, size_t host_len,
   uint8_t portbe[2];
   const odin_proto_status_t pst =
       odin_proto_encode_connect_req(host, host_len, port, iov, hdr, portbe);
-  /* host_len is in [1, 255] per the guard above, so the encoder must succeed.
-   */
+  /* host_len is in [1, 255] per the callers' guard, so the encoder must
+   * succeed. */
   assert(pst == ODIN_PROTO_OK);
   (void)pst;
 
@@ -149,6 +140,87 @@ int odin_connect_session_create_client(const char *host, size_t host_len,
 #if defined(ODIN_CONNECT_SESSION_TESTING)
   g_connect_session_live_count += 1;
 #endif
+}
+
+static void init_server(odin_connect_session_t *s,
+                        odin_connect_session_req_decoded_cb on_req_decoded,
+                        odin_connect_session_done_cb on_done,
+                        void *user_data) {
+  s->mode = ODIN_CONNECT_SESSION_MODE_SERVER;
+  s->state = ODIN_CONNECT_SESSION_S_READING_REQ;
+  s->on_req_decoded = on_req_decoded;
+  s->on_done = on_done;
+  s->user_data = user_data;
+#if defined(ODIN_CONNECT_SESSION_TESTING)
+  g_connect_session_live_count += 1;
+#endif
+}
+
+#if defined(ODIN_CONNECT_SESSION_TESTING)
+static int take_fail_next_create_client(void) {
+  if (g_fail_next_create_client_armed) {
+    const int errnum = g_fail_next_create_client_errno;
+    g_fail_next_create_client_armed = 0;
+    g_fail_next_create_client_errno = 0;
+    errno = errnum;
+    return -1;
+  }
+  return 0;
+}
+
+static int take_fail_next_create_server(void) {
+  if (g_fail_next_create_server_armed) {
+    const int errnum = g_fail_next_create_server_errno;
+    g_fail_next_create_server_armed = 0;
+    g_fail_next_create_server_errno = 0;
+    errno = errnum;
+    return -1;
+  }
+  return 0;
+}
+#endif
+
+int odin_connect_session_create_client(const char *host, size_t host_len,
+                                       uint16_t port,
+                                       odin_connect_session_done_cb on_done,
+                                       void *user_data,
+                                       odin_connect_session_t **out) {
+#if defined(ODIN_CONNECT_SESSION_TESTING)
+  if (take_fail_next_create_client() != 0) {
+    return -1;
+  }
+#endif
+  if (host_len < 1 || host_len > ODIN_PROTO_HOST_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_connect_session_t *s = (odin_connect_session_t *)calloc(1, sizeof(*s));
+  if (s == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  init_client(s, host, host_len, port, on_done, user_data);
+  *out = s;
+  return 0;
+}
+
+int odin_connect_session_create_client_in(
+    odin_connect_session_storage_t *storage, const char *host, size_t host_len,
+    uint16_t port, odin_connect_session_done_cb on_done, void *user_data,
+    odin_connect_session_t **out) {
+#if defined(ODIN_CONNECT_SESSION_TESTING)
+  if (take_fail_next_create_client() != 0) {
+    return -1;
+  }
+#endif
+  if (host_len < 1 || host_len > ODIN_PROTO_HOST_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_connect_session_t *s = (odin_connect_session_t *)(void *)storage;
+  memset(s, 0, sizeof(*s));
+  init_client(s, host, host_len, port, on_done, user_data);
+  s->embedded = 1;
   *out = s;
   return 0;
 }
@@ -158,11 +230,7 @@ int odin_connect_session_create_server(
     odin_connect_session_done_cb on_done, void *user_data,
     odin_connect_session_t **out) {
 #if defined(ODIN_CONNECT_SESSION_TESTING)
-  if (g_fail_next_create_server_armed) {
-    const int errnum = g_fail_next_create_server_errno;
-    g_fail_next_create_server_armed = 0;
-    g_fail_next_create_server_errno = 0;
-    errno = errnum;
+  if (take_fail_next_create_server() != 0) {
     return -1;
   }
 #endif
@@ -171,14 +239,25 @@ int odin_connect_session_create_server(
     errno = ENOMEM;
     return -1;
   }
-  s->mode = ODIN_CONNECT_SESSION_MODE_SERVER;
-  s->state = ODIN_CONNECT_SESSION_S_READING_REQ;
-  s->on_req_decoded = on_req_decoded;
-  s->on_done = on_done;
-  s->user_data = user_data;
+  init_server(s, on_req_decoded, on_done, user_data);
+  *out = s;
+  return 0;
+}
+
+int odin_connect_session_create_server_in(
+    odin_connect_session_storage_t *storage,
+    odin_connect_session_req_decoded_cb on_req_decoded,
+    odin_connect_session_done_cb on_done, void *user_data,
+    odin_connect_session_t **out) {
 #if defined(ODIN_CONNECT_SESSION_TESTING)
-  g_connect_session_live_count += 1;
+  if (take_fail_next_create_server() != 0) {
+    return -1;
+  }
 #endif
+  odin_connect_session_t *s = (odin_connect_session_t *)(void *)storage;
+  memset(s, 0, sizeof(*s));
+  init_server(s, on_req_decoded, on_done, user_data);
+  s->embedded = 1;
   *out = s;
   return 0;
 }
@@ -454,7 +533,9 @@ void odin_connect_session_destroy(odin_connect_session_t *s) {
 #if defined(ODIN_CONNECT_SESSION_TESTING)
   g_connect_session_live_count -= 1;
 #endif
-  free(s);
+  if (!s->embedded) {
+    free(s);
+  }
 }
 
 #if defined(ODIN_CONNECT_SESSION_TESTING)
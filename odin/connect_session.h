@@ -41,6 +41,12 @@
  *   via odin_transport_error (0 is benign and re-arms; non-zero becomes err);
  *   a decoder ODIN_PROTO_ERR_* maps to err = EPROTO.
  *
+ * Caller storage: odin_connect_session_create_client_in / _create_server_in
+ *   build the session inside caller-provided odin_connect_session_storage_t
+ *   with the same argument checks and semantics as the allocating creates;
+ *   odin_connect_session_destroy then releases nothing. The storage must stay
+ *   valid and unmoved until destroy returns and may be reused afterwards.
+ *
  * Threading: all entry points and both callbacks run on the orchestrator's
  * thread; the session adds no locks.
  */
@@ -60,6 +66,16 @@ extern "C" {
 
 typedef struct odin_connect_session_t odin_connect_session_t;
 
+/* Opaque storage sized and aligned for the session (checked at compile time in
+ * connect_session.c); dominated by the 260-byte frame accumulator. */
+#define ODIN_CONNECT_SESSION_STORAGE_SIZE 512u
+
+typedef union odin_connect_session_storage_t {
+  unsigned char bytes[ODIN_CONNECT_SESSION_STORAGE_SIZE];
+  void *align_ptr;
+  uint64_t align_u64;
+} odin_connect_session_storage_t;
+
 typedef enum odin_connect_session_status_t {
   ODIN_CONNECT_SESSION_OK = 0,
   ODIN_CONNECT_SESSION_ERROR,
@@ -88,6 +104,17 @@ int odin_connect_session_create_server(
     odin_connect_session_done_cb on_done, void *user_data,
     odin_connect_session_t **out);
 
+int odin_connect_session_create_client_in(
+    odin_connect_session_storage_t *storage, const char *host, size_t host_len,
+    uint16_t port, odin_connect_session_done_cb on_done, void *user_data,
+    odin_connect_session_t **out);
+
+int odin_connect_session_create_server_in(
+    odin_connect_session_storage_t *storage,
+    odin_connect_session_req_decoded_cb on_req_decoded,
+    odin_connect_session_done_cb on_done, void *user_data,
+    odin_connect_session_t **out);
+
 odin_connect_session_drive_t
 odin_connect_session_drive(odin_connect_session_t *s, odin_transport_t *t,
                            unsigned int events);
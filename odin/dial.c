@@ -8,17 +8,31 @@
  * single active registration and fires on_done exactly once as its final
  * action, transferring the connected fd to the caller on success or closing it
  * on failure. The dial performs no name resolution and selects no transport.
+ *
+ * RFC-036 adds TCP Fast Open: a TFO attempt sends the caller's early data with
+ * the deferred connect, classifies the outcome from TCP_INFO at completion,
+ * and records it in the shared per-destination cache. RFC-037 binds sockets to
+ * a source-address pool with IP_BIND_ADDRESS_NO_PORT and fails over between
+ * sources on port exhaustion.
  */
 
 #include "odin/dial.h"
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "odin/trace.h"
+
 #if defined(ODIN_DIAL_TESTING)
 #include "odin/testing/dial_internal_test.h"
 #endif
@@ -37,8 +51,53 @@ struct odin_dial_t {
   int pending_err;           /* errno to deliver on the deferred path    */
   odin_event_io_t *io;       /* WRITE watch while connecting; else NULL  */
   odin_event_timer_t *timer; /* deferred-error timer; else NULL          */
+  int embedded;              /* caller storage: destroy frees nothing    */
+  odin_event_loop_t *loop;
+  odin_dial_tfo_cache_t *tfo; /* non-NULL: TFO may be attempted          */
+  int tfo_attempt;            /* the current socket carries TFO           */
+  size_t early_sent;          /* early bytes the SYN took                 */
+  odin_dial_source_pool_t *sources; /* NULL: implicit source address   */
+  int source;                       /* pool index bound, or -1         */
+  int source_held;                  /* the dial holds source's live count */
+  socklen_t addrlen;
+  struct sockaddr_storage addr; /* kept for the plain redial              */
+};
+
+/* One pool member and its counters. */
+typedef struct odin_dial_source_t {
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  odin_dial_source_stats_t stats;
+} odin_dial_source_t;
+
+struct odin_dial_source_pool_t {
+  odin_dial_source_policy_t policy;
+  size_t count;
+  size_t next; /* rotation cursor */
+  odin_dial_source_t src[ODIN_DIAL_SOURCE_POOL_MAX];
 };
 
+/* One cache slot: the destination key and its backoff state. */
+typedef struct odin_dial_tfo_entry_t {
+  unsigned char key[20]; /* family, port, address; all-zero when unused */
+  uint32_t failures;     /* consecutive failures                        */
+  uint64_t retry_at_ms;  /* TFO allowed again at this monotonic time    */
+} odin_dial_tfo_entry_t;
+
+struct odin_dial_tfo_cache_t {
+  odin_dial_tfo_entry_t slots[ODIN_DIAL_TFO_CACHE_SLOTS];
+};
+
+#if defined(ODIN_DIAL_TESTING)
+static uint64_t g_test_now_ms;
+static int g_test_tfo_err;
+#endif
+
+_Static_assert(sizeof(odin_dial_t) <= sizeof(odin_dial_storage_t),
+               "ODIN_DIAL_STORAGE_SIZE too small");
+_Static_assert(_Alignof(odin_dial_t) <= _Alignof(odin_dial_storage_t),
+               "odin_dial_storage_t under-aligned");
+
 /* Makes fd nonblocking. Returns 0, or -1 with errno set. */
 static int set_nonblocking(int fd) {
   const int flags = fcntl(fd, F_GETFL, 0);
@@ -60,6 +119,146 @@ static int so_error(int fd) {
   return err;
 }
 
+static uint64_t now_ms(void) {
+#if defined(ODIN_DIAL_TESTING)
+  if (g_test_now_ms != 0) {
+    return g_test_now_ms;
+  }
+#endif
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Fills key with the destination's family, port, and address. Returns 0 for
+ * families TFO does not apply to. */
+static int tfo_key(const struct sockaddr *addr, socklen_t addrlen,
+                   unsigned char key[20]) {
+  memset(key, 0, 20);
+  if (addr->sa_family == AF_INET && addrlen >= sizeof(struct sockaddr_in)) {
+    const struct sockaddr_in *in = (const struct sockaddr_in *)addr;
+    key[0] = 4;
+    memcpy(key + 2, &in->sin_port, 2);
+    memcpy(key + 4, &in->sin_addr, 4);
+    return 1;
+  }
+  if (addr->sa_family == AF_INET6 && addrlen >= sizeof(struct sockaddr_in6)) {
+    const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)addr;
+    key[0] = 6;
+    memcpy(key + 2, &in6->sin6_port, 2);
+    memcpy(key + 4, &in6->sin6_addr, 16);
+    return 1;
+  }
+  return 0;
+}
+
+/* FNV-1a over the key, folded onto the table. */
+static size_t tfo_slot(const unsigned char key[20]) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < 20; ++i) {
+    h = (h ^ key[i]) * 16777619u;
+  }
+  return h % ODIN_DIAL_TFO_CACHE_SLOTS;
+}
+
+/* Records one TFO outcome for the dial's destination. */
+static void tfo_note(odin_dial_t *d, int ok) {
+  unsigned char key[20];
+  if (!tfo_key((const struct sockaddr *)&d->addr, d->addrlen, key)) {
+    return;
+  }
+  odin_dial_tfo_entry_t *e = &d->tfo->slots[tfo_slot(key)];
+  if (ok) {
+    if (memcmp(e->key, key, sizeof(key)) == 0) {
+      memset(e, 0, sizeof(*e));
+    }
+    return;
+  }
+  if (memcmp(e->key, key, sizeof(key)) != 0) {
+    memcpy(e->key, key, sizeof(key));
+    e->failures = 0;
+  }
+  uint64_t backoff = ODIN_DIAL_TFO_BACKOFF_MS;
+  for (uint32_t i = 0;
+       i < e->failures && backoff < ODIN_DIAL_TFO_BACKOFF_MAX_MS; ++i) {
+    backoff *= 2;
+  }
+  if (backoff > ODIN_DIAL_TFO_BACKOFF_MAX_MS) {
+    backoff = ODIN_DIAL_TFO_BACKOFF_MAX_MS;
+  }
+  e->failures += 1;
+  e->retry_at_ms = now_ms() + backoff;
+}
+
+/* Whether the SYN-ACK acknowledged the data sent in the SYN. */
+static int tfo_syn_data_acked(int fd) {
+#if defined(TCPI_OPT_SYN_DATA)
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+  memset(&info, 0, sizeof(info));
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0) {
+    return (info.tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+  }
+#else
+  (void)fd;
+#endif
+  return 0;
+}
+
+/* Gives back the live count the dial holds on its source, if any. */
+static void source_put(odin_dial_t *d) {
+  if (d->source_held) {
+    d->sources->src[d->source].stats.live -= 1;
+    d->source_held = 0;
+  }
+}
+
+/* Closes the socket the dial still owns and gives back its source. */
+static void drop_socket(odin_dial_t *d) {
+  if (d->fd >= 0) {
+    close(d->fd);
+    d->fd = -1;
+  }
+  source_put(d);
+}
+
+static int source_pool_has_family(const odin_dial_source_pool_t *pool,
+                                  int family) {
+  for (size_t i = 0; i < pool->count; ++i) {
+    if (pool->src[i].addr.ss_family == family) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Picks the next source of family not in tried (a bitmask of indices) per the
+ * pool's policy, or -1 when none is left. Round-robin takes the first match
+ * after the cursor; least-used the match with the fewest live sockets to any
+ * destination, ties going to the one nearest the cursor. */
+static int source_pick(odin_dial_source_pool_t *pool, int family,
+                       uint32_t tried) {
+  int best = -1;
+  for (size_t k = 0; k < pool->count; ++k) {
+    const size_t i = (pool->next + k) % pool->count;
+    const odin_dial_source_t *src = &pool->src[i];
+    if (src->addr.ss_family != family || (tried & (1u << i)) != 0) {
+      continue;
+    }
+    if (pool->policy == ODIN_DIAL_SOURCE_ROUND_ROBIN) {
+      best = (int)i;
+      break;
+    }
+    if (best < 0 || src->stats.live < pool->src[best].stats.live) {
+      best = (int)i;
+    }
+  }
+  if (best >= 0) {
+    pool->next = ((size_t)best + 1) % pool->count;
+  }
+  return best;
+}
+
 /* The single completion step: stop whichever registration is active, then
  * transfer the fd (err == 0) or close it (err != 0), then fire on_done as the
  * last statement -- no dial field is touched after the callback returns, so
@@ -73,19 +272,22 @@ static void complete(odin_dial_t *d, int err) {
     odin_event_timer_stop(d->timer);
     d->timer = NULL;
   }
+  ODIN_TRACE2(dial__done, d, err);
   const odin_dial_cb cb = d->on_done;
   void *const ud = d->user_data;
   if (err == 0) {
+    d->source_held = 0; /* the live count travels with the fd */
     const int out_fd = d->fd;
     d->fd = -1; /* transfer ownership to caller */
     cb(d, ODIN_DIAL_OK, out_fd, 0, ud);
   } else {
-    close(d->fd);
-    d->fd = -1; /* dial owned it; close on failure */
+    drop_socket(d); /* dial owned it; close on failure */
     cb(d, ODIN_DIAL_ERROR, -1, err, ud);
   }
 }
 
+static int redial_plain(odin_dial_t *d);
+
 /* WRITE-watch readiness: the socket is writable only once connect(2) resolved,
  * so SO_ERROR is the authoritative outcome. */
 static void on_writable(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
@@ -94,7 +296,27 @@ static void on_writable(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
   (void)io;
   (void)events;
   odin_dial_t *d = (odin_dial_t *)user_data;
-  complete(d, so_error(fd));
+  int err = so_error(fd);
+  if (d->tfo_attempt) {
+#if defined(ODIN_DIAL_TESTING)
+    if (g_test_tfo_err != 0) {
+      err = g_test_tfo_err;
+      g_test_tfo_err = 0;
+    }
+#endif
+    if (err == 0) {
+      if (d->early_sent > 0) {
+        tfo_note(d, tfo_syn_data_acked(fd));
+      }
+    } else if (err == ETIMEDOUT || err == ECONNRESET) {
+      tfo_note(d, 0);
+      if (redial_plain(d) == 0) {
+        return;
+      }
+      err = errno;
+    }
+  }
+  complete(d, err);
 }
 
 /* Deferred delivery of an immediate connect(2) failure on the next loop turn.
@@ -107,6 +329,152 @@ static void on_deferred_error(odin_event_loop_t *loop,
   complete(d, d->pending_err);
 }
 
+/* Creates the socket, binds it to a pool source when one applies, optionally
+ * sets TCP_FASTOPEN_CONNECT and sends early data, issues connect(2), and
+ * registers the attempt. A source that reports EADDRNOTAVAIL or EADDRINUSE is
+ * counted and the next one tried; when every matching source is exhausted the
+ * EADDRNOTAVAIL takes the deferred-error path like any immediate connect(2)
+ * failure. Returns 0, or -1 with errno set and no socket, source count, or
+ * registration left behind. */
+static int dial_connect(odin_dial_t *d, const void *data, size_t len) {
+  const struct sockaddr *addr = (const struct sockaddr *)&d->addr;
+  const int use_sources = d->sources != NULL &&
+                          source_pool_has_family(d->sources, addr->sa_family);
+  uint32_t tried = 0;
+  int r = 0;
+  for (;;) {
+    d->pending_err = 0;
+    d->tfo_attempt = 0;
+    d->early_sent = 0;
+    d->fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (d->fd < 0) {
+      return -1;
+    }
+    if (set_nonblocking(d->fd) != 0) {
+      const int saved = errno;
+      drop_socket(d);
+      errno = saved;
+      return -1;
+    }
+    r = 0;
+    if (use_sources) {
+      const int idx = source_pick(d->sources, addr->sa_family, tried);
+      if (idx < 0) {
+        r = -1;
+        errno = EADDRNOTAVAIL;
+        break;
+      }
+      tried |= 1u << (unsigned)idx;
+      odin_dial_source_t *src = &d->sources->src[idx];
+      d->source = idx;
+      d->source_held = 1;
+      src->stats.live += 1;
+      src->stats.dials += 1;
+#if defined(IP_BIND_ADDRESS_NO_PORT)
+      const int one = 1;
+      (void)setsockopt(d->fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one,
+                       sizeof(one));
+#endif
+      r = bind(d->fd, (const struct sockaddr *)&src->addr, src->addrlen);
+    }
+#if defined(TCP_FASTOPEN_CONNECT)
+    if (r == 0 && d->tfo != NULL && len > 0 &&
+        odin_dial_tfo_cache_allows(d->tfo, addr, d->addrlen)) {
+      const int one = 1;
+      d->tfo_attempt = setsockopt(d->fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                                  &one, sizeof(one)) == 0;
+    }
+#endif
+    if (r == 0) {
+      r = connect(d->fd, addr, d->addrlen);
+    }
+    if (r < 0 && d->source_held &&
+        (errno == EADDRNOTAVAIL || errno == EADDRINUSE)) {
+      d->sources->src[d->source].stats.exhausted += 1;
+      drop_socket(d);
+      continue;
+    }
+    break;
+  }
+
+  if (r == 0 && d->tfo_attempt) {
+    /* With a cookie cached the connect was deferred: this send emits the SYN
+     * and carries as much of data as fits. EINPROGRESS means the SYN went out
+     * without data. Anything else leaves no SYN in flight, so start over
+     * without TFO rather than wait on a socket that will never connect. */
+    const ssize_t n = send(d->fd, data, len, MSG_NOSIGNAL);
+    if (n > 0) {
+      d->early_sent = (size_t)n;
+    } else if (n == 0 || errno != EINPROGRESS) {
+      drop_socket(d);
+      d->tfo = NULL;
+      return dial_connect(d, NULL, 0);
+    }
+  }
+  if (r == 0 || (r < 0 && (errno == EINPROGRESS || errno == EINTR))) {
+    if (odin_event_io_start(d->loop, d->fd, ODIN_EVENT_WRITE, on_writable, d,
+                            &d->io) != 0) {
+      const int saved = errno;
+      drop_socket(d);
+      errno = saved;
+      return -1;
+    }
+  } else {
+    d->pending_err = errno;
+    if (odin_event_timer_start(d->loop, 0, 0, on_deferred_error, d,
+                               &d->timer) != 0) {
+      const int saved = errno;
+      drop_socket(d);
+      errno = saved;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Fallback after a failed TFO attempt: drop the socket and its watch, then
+ * dial the same address once more without TFO. */
+static int redial_plain(odin_dial_t *d) {
+  odin_event_io_stop(d->io);
+  d->io = NULL;
+  drop_socket(d);
+  d->tfo = NULL;
+  return dial_connect(d, NULL, 0);
+}
+
+/* Shared setup for every entry point: d is zeroed storage (heap or caller).
+ * Returns 0, or -1 with errno set and no socket or registration left behind;
+ * the caller releases d on failure. */
+static int dial_begin(odin_dial_t *d, odin_event_loop_t *loop,
+                      const struct sockaddr *addr, socklen_t addrlen,
+                      const odin_dial_opts_t *opts, odin_dial_cb on_done,
+                      void *user_data) {
+  if (addrlen > sizeof(d->addr)) {
+    errno = EINVAL;
+    return -1;
+  }
+  d->on_done = on_done;
+  d->user_data = user_data;
+  d->loop = loop;
+  d->source = -1;
+  d->addrlen = addrlen;
+  memcpy(&d->addr, addr, addrlen);
+  const void *early_data = NULL;
+  size_t early_len = 0;
+  if (opts != NULL) {
+    d->tfo = opts->tfo;
+    d->sources = opts->sources;
+    early_data = opts->early_data;
+    early_len = opts->early_len;
+  }
+  ODIN_TRACE2(dial__start, d, addr->sa_family);
+  if (dial_connect(d, early_data, early_len) != 0) {
+    ODIN_TRACE2(dial__done, d, errno);
+    return -1;
+  }
+  return 0;
+}
+
 int odin_dial_start(odin_event_loop_t *loop, const struct sockaddr *addr,
                     socklen_t addrlen, odin_dial_cb on_done, void *user_data,
                     odin_dial_t **out) {
@@ -120,50 +488,154 @@ int odin_dial_start(odin_event_loop_t *loop, const struct sockaddr *addr,
     errno = ENOMEM;
     return -1;
   }
-  d->on_done = on_done;
-  d->user_data = user_data;
-  d->pending_err = 0;
-  d->fd = socket(addr->sa_family, SOCK_STREAM, 0);
-  if (d->fd < 0) {
+  if (dial_begin(d, loop, addr, addrlen, NULL, on_done, user_data) != 0) {
     const int saved = errno;
     free(d);
     errno = saved;
     return -1;
   }
-  if (set_nonblocking(d->fd) != 0) {
-    const int saved = errno;
-    close(d->fd);
-    free(d);
-    errno = saved;
+  *out = d;
+  return 0;
+}
+
+int odin_dial_start_in(odin_dial_storage_t *storage, odin_event_loop_t *loop,
+                       const struct sockaddr *addr, socklen_t addrlen,
+                       odin_dial_cb on_done, void *user_data,
+                       odin_dial_t **out) {
+#if defined(ODIN_DIAL_TESTING) && defined(ODIN_CLI_SERVER_TESTING)
+  if (odin_cli_server_test_maybe_probe_dial_start(addr, addrlen) != 0) {
     return -1;
   }
+#endif
+  return odin_dial_start_opts_in(storage, loop, addr, addrlen, NULL, on_done,
+                                 user_data, out);
+}
 
-  const int r = connect(d->fd, addr, addrlen);
-  if (r == 0 || (r < 0 && (errno == EINPROGRESS || errno == EINTR))) {
-    if (odin_event_io_start(loop, d->fd, ODIN_EVENT_WRITE, on_writable, d,
-                            &d->io) != 0) {
-      const int saved = errno;
-      close(d->fd);
-      free(d);
-      errno = saved;
+int odin_dial_start_opts_in(odin_dial_storage_t *storage,
+                            odin_event_loop_t *loop,
+                            const struct sockaddr *addr, socklen_t addrlen,
+                            const odin_dial_opts_t *opts, odin_dial_cb on_done,
+                            void *user_data, odin_dial_t **out) {
+  odin_dial_t *d = (odin_dial_t *)(void *)storage;
+  memset(d, 0, sizeof(*d));
+  if (dial_begin(d, loop, addr, addrlen, opts, on_done, user_data) != 0) {
+    return -1;
+  }
+  d->embedded = 1;
+  *out = d;
+  return 0;
+}
+
+size_t odin_dial_early_sent(const odin_dial_t *dial) {
+  return dial->early_sent;
+}
+
+int odin_dial_tfo_cache_create(odin_dial_tfo_cache_t **out) {
+  odin_dial_tfo_cache_t *cache =
+      (odin_dial_tfo_cache_t *)calloc(1, sizeof(*cache));
+  if (cache == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  *out = cache;
+  return 0;
+}
+
+int odin_dial_tfo_cache_allows(const odin_dial_tfo_cache_t *cache,
+                               const struct sockaddr *addr, socklen_t addrlen) {
+  unsigned char key[20];
+  if (!tfo_key(addr, addrlen, key)) {
+    return 0;
+  }
+  const odin_dial_tfo_entry_t *e = &cache->slots[tfo_slot(key)];
+  if (memcmp(e->key, key, sizeof(key)) != 0) {
+    return 1;
+  }
+  return now_ms() >= e->retry_at_ms;
+}
+
+void odin_dial_tfo_cache_destroy(odin_dial_tfo_cache_t *cache) { free(cache); }
+
+int odin_dial_source(const odin_dial_t *dial) { return dial->source; }
+
+int odin_dial_source_pool_create(const struct sockaddr_storage *addrs,
+                                 size_t count,
+                                 odin_dial_source_policy_t policy,
+                                 odin_dial_source_pool_t **out) {
+  if (count == 0 || count > ODIN_DIAL_SOURCE_POOL_MAX ||
+      (policy != ODIN_DIAL_SOURCE_ROUND_ROBIN &&
+       policy != ODIN_DIAL_SOURCE_LEAST_USED)) {
+    errno = EINVAL;
+    return -1;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (addrs[i].ss_family != AF_INET && addrs[i].ss_family != AF_INET6) {
+      errno = EINVAL;
       return -1;
     }
-  } else {
-    d->pending_err = errno;
-    if (odin_event_timer_start(loop, 0, 0, on_deferred_error, d, &d->timer) !=
-        0) {
-      const int saved = errno;
-      close(d->fd);
-      free(d);
-      errno = saved;
-      return -1;
+  }
+  odin_dial_source_pool_t *pool =
+      (odin_dial_source_pool_t *)calloc(1, sizeof(*pool));
+  if (pool == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  pool->policy = policy;
+  pool->count = count;
+  for (size_t i = 0; i < count; ++i) {
+    odin_dial_source_t *src = &pool->src[i];
+    src->addr = addrs[i];
+    if (src->addr.ss_family == AF_INET) {
+      ((struct sockaddr_in *)&src->addr)->sin_port = 0;
+      src->addrlen = sizeof(struct sockaddr_in);
+    } else {
+      ((struct sockaddr_in6 *)&src->addr)->sin6_port = 0;
+      src->addrlen = sizeof(struct sockaddr_in6);
     }
   }
+  *out = pool;
+  return 0;
+}
 
-  *out = d;
+void odin_dial_source_pool_release(odin_dial_source_pool_t *pool, int index) {
+  if (pool == NULL || index < 0 || (size_t)index >= pool->count ||
+      pool->src[index].stats.live == 0) {
+    return;
+  }
+  pool->src[index].stats.live -= 1;
+}
+
+int odin_dial_source_pool_stats(const odin_dial_source_pool_t *pool,
+                                size_t index, odin_dial_source_stats_t *out) {
+  if (index >= pool->count) {
+    errno = EINVAL;
+    return -1;
+  }
+  *out = pool->src[index].stats;
   return 0;
 }
 
+size_t odin_dial_source_pool_stats_format(const odin_dial_source_pool_t *pool,
+                                          char *buf, size_t cap) {
+  size_t len = 0;
+  for (size_t i = 0; i < pool->count; ++i) {
+    const odin_dial_source_stats_t *st = &pool->src[i].stats;
+    const int fits = len < cap;
+    const int n = snprintf(fits ? buf + len : NULL, fits ? cap - len : 0,
+                           "%s%" PRIu64 "/%" PRIu64 "/%" PRIu32,
+                           i == 0 ? "src=" : ",", st->dials, st->exhausted,
+                           st->live);
+    if (n > 0) {
+      len += (size_t)n;
+    }
+  }
+  return len;
+}
+
+void odin_dial_source_pool_destroy(odin_dial_source_pool_t *pool) {
+  free(pool);
+}
+
 void odin_dial_destroy(odin_dial_t *dial) {
   if (dial == NULL) {
     return;
@@ -176,14 +648,17 @@ void odin_dial_destroy(odin_dial_t *dial) {
     odin_event_timer_stop(dial->timer);
     dial->timer = NULL;
   }
-  if (dial->fd >= 0) {
-    close(dial->fd); /* still owned: in-flight or aborted */
-    dial->fd = -1;
+  drop_socket(dial); /* still owned: in-flight or aborted */
+  if (!dial->embedded) {
+    free(dial);
   }
-  free(dial);
 }
 
 #if defined(ODIN_DIAL_TESTING)
+void odin_dial_test_set_now_ms(uint64_t ms) { g_test_now_ms = ms; }
+
+void odin_dial_test_fail_next_tfo(int err) { g_test_tfo_err = err; }
+
 int odin_dial_test_fd(odin_dial_t *dial) {
   if (dial->fd < 0) {
     errno = ENOENT;
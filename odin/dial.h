@@ -27,11 +27,38 @@
  * dial created already closed; status is the authoritative signal. Even a
  * connect(2) that completes synchronously is reported on a later loop turn,
  * never re-entrantly from within odin_dial_start.
+ *
+ * Options: odin_dial_start_opts_in takes an odin_dial_opts_t naming the shared,
+ * owner-thread helpers a dial may use. Each one is borrowed and must outlive
+ * every dial and every socket that references it.
+ *
+ * TCP Fast Open (RFC-036): odin_dial_opts_t.tfo may carry early data in the
+ * SYN through TCP_FASTOPEN_CONNECT on Linux. A shared odin_dial_tfo_cache_t
+ * records per-destination outcomes; a destination whose SYN data was not
+ * acknowledged, or whose TFO connect timed out or was reset, is dialed without
+ * TFO until a backoff expires, and the failing attempt itself is retried once
+ * as a plain connect. odin_dial_early_sent reports how many early bytes the
+ * SYN took, so the caller writes only the rest.
+ *
+ * Source addresses (RFC-037): odin_dial_opts_t.sources binds each socket to a
+ * local address from an odin_dial_source_pool_t with IP_BIND_ADDRESS_NO_PORT,
+ * so the kernel picks the port per 4-tuple at connect time instead of from
+ * one address's ephemeral range. A source that reports EADDRNOTAVAIL or
+ * EADDRINUSE is counted as exhausted and the dial moves to the next source of
+ * the same family. The pool counts live sockets per source, summed over all
+ * destinations, so least-used balances each source's total rather than its
+ * sockets to one host. The dial holds one count from connect until
+ * on_done(ERROR) or destroy, and on ODIN_DIAL_OK the count passes to the fd's
+ * new owner, which returns it with
+ * odin_dial_source_pool_release(pool, odin_dial_source(dial)) when it closes
+ * the fd.
  */
 
 #ifndef ODIN_DIAL_H_
 #define ODIN_DIAL_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/socket.h>
 
 #include "odin/event_loop.h"
@@ -42,11 +69,55 @@ extern "C" {
 
 typedef struct odin_dial_t odin_dial_t;
 
+/* Opaque storage sized and aligned for the dial object (checked at compile time
+ * in dial.c), for odin_dial_start_in. */
+#define ODIN_DIAL_STORAGE_SIZE 256u
+
+typedef union odin_dial_storage_t {
+  unsigned char bytes[ODIN_DIAL_STORAGE_SIZE];
+  void *align_ptr;
+  uint64_t align_u64;
+} odin_dial_storage_t;
+
 typedef enum odin_dial_status_t {
   ODIN_DIAL_OK = 0,
   ODIN_DIAL_ERROR,
 } odin_dial_status_t;
 
+/* Per-destination TFO outcomes, keyed by address and port. The table is
+ * direct-mapped and bounded; a colliding destination evicts the older entry. A
+ * failure disables TFO for ODIN_DIAL_TFO_BACKOFF_MS, doubling per consecutive
+ * failure up to ODIN_DIAL_TFO_BACKOFF_MAX_MS; a success clears the entry. */
+typedef struct odin_dial_tfo_cache_t odin_dial_tfo_cache_t;
+
+#define ODIN_DIAL_TFO_CACHE_SLOTS 256u
+#define ODIN_DIAL_TFO_BACKOFF_MS 60000u
+#define ODIN_DIAL_TFO_BACKOFF_MAX_MS 3600000u
+
+/* Bounded pool of local source addresses (RFC-037). */
+typedef struct odin_dial_source_pool_t odin_dial_source_pool_t;
+
+#define ODIN_DIAL_SOURCE_POOL_MAX 16u
+
+typedef enum odin_dial_source_policy_t {
+  ODIN_DIAL_SOURCE_ROUND_ROBIN = 0, /* rotate through matching sources     */
+  ODIN_DIAL_SOURCE_LEAST_USED,      /* fewest live sockets, rotation on ties */
+} odin_dial_source_policy_t;
+
+typedef struct odin_dial_source_stats_t {
+  uint64_t dials;     /* connects issued from this source              */
+  uint64_t exhausted; /* EADDRNOTAVAIL / EADDRINUSE from bind or connect */
+  uint32_t live;      /* unreleased sockets, all destinations combined */
+} odin_dial_source_stats_t;
+
+/* Borrowed helpers for odin_dial_start_opts_in; NULL / 0 members are off. */
+typedef struct odin_dial_opts_t {
+  odin_dial_tfo_cache_t *tfo;
+  const void *early_data; /* offered as SYN data when tfo allows it */
+  size_t early_len;
+  odin_dial_source_pool_t *sources;
+} odin_dial_opts_t;
+
 typedef void (*odin_dial_cb)(odin_dial_t *dial, odin_dial_status_t status,
                              int fd, int err, void *user_data);
 
@@ -64,6 +135,79 @@ int odin_dial_start(odin_event_loop_t *loop, const struct sockaddr *addr,
                     socklen_t addrlen, odin_dial_cb on_done, void *user_data,
                     odin_dial_t **out);
 
+/* odin_dial_start without the allocation: builds the dial inside
+ * caller-provided storage, with identical setup, failure, and completion
+ * semantics minus the ENOMEM case. odin_dial_destroy then releases no memory;
+ * the storage must stay valid and unmoved until it returns (or until on_done
+ * has returned, for a dial the caller never destroys) and may be reused
+ * immediately afterwards. On failure the storage is left unused.
+ */
+int odin_dial_start_in(odin_dial_storage_t *storage, odin_event_loop_t *loop,
+                       const struct sockaddr *addr, socklen_t addrlen,
+                       odin_dial_cb on_done, void *user_data,
+                       odin_dial_t **out);
+
+/* odin_dial_start_in with options (NULL opts is odin_dial_start_in). TFO is
+ * attempted only for AF_INET / AF_INET6 when opts->tfo is non-NULL,
+ * early_len > 0, the kernel accepts TCP_FASTOPEN_CONNECT, and the cache has no
+ * live backoff for addr. early_data need only stay valid for the duration of
+ * the call. A TFO attempt that completes with ETIMEDOUT or ECONNRESET is
+ * recorded and redialed once without TFO before on_done fires. With
+ * opts->sources, a dial whose every matching source is exhausted fails through
+ * on_done with EADDRNOTAVAIL; a family with no source in the pool dials from
+ * the implicit address.
+ */
+int odin_dial_start_opts_in(odin_dial_storage_t *storage,
+                            odin_event_loop_t *loop,
+                            const struct sockaddr *addr, socklen_t addrlen,
+                            const odin_dial_opts_t *opts, odin_dial_cb on_done,
+                            void *user_data, odin_dial_t **out);
+
+/* Bytes of the early data the connected socket already carries, 0 when TFO
+ * was not used or the SYN took none. Meaningful from inside an ODIN_DIAL_OK
+ * on_done until the dial is destroyed. */
+size_t odin_dial_early_sent(const odin_dial_t *dial);
+
+/* Creates an empty cache. Returns 0, or -1 with errno == ENOMEM. */
+int odin_dial_tfo_cache_create(odin_dial_tfo_cache_t **out);
+
+/* Returns 1 when the cache has no live backoff for addr, else 0. */
+int odin_dial_tfo_cache_allows(const odin_dial_tfo_cache_t *cache,
+                               const struct sockaddr *addr, socklen_t addrlen);
+
+/* Frees the cache; NULL is a no-op. No dial may still reference it. */
+void odin_dial_tfo_cache_destroy(odin_dial_tfo_cache_t *cache);
+
+/* Index into the pool of the source the dial bound, or -1 when it bound none.
+ * Meaningful from inside on_done until the dial is destroyed. */
+int odin_dial_source(const odin_dial_t *dial);
+
+/* Copies count AF_INET / AF_INET6 addresses (ports ignored) into a new pool.
+ * Returns 0, or -1 with errno set: EINVAL for count == 0, count >
+ * ODIN_DIAL_SOURCE_POOL_MAX, an unknown policy, or another family; ENOMEM. */
+int odin_dial_source_pool_create(const struct sockaddr_storage *addrs,
+                                 size_t count,
+                                 odin_dial_source_policy_t policy,
+                                 odin_dial_source_pool_t **out);
+
+/* Returns one live socket's count to source index; index < 0 is a no-op. */
+void odin_dial_source_pool_release(odin_dial_source_pool_t *pool, int index);
+
+/* Copies source index's counters to *out. Returns 0, or -1 with errno ==
+ * EINVAL when index is out of range. */
+int odin_dial_source_pool_stats(const odin_dial_source_pool_t *pool,
+                                size_t index, odin_dial_source_stats_t *out);
+
+/* Formats every source's counters for the RFC-051 log line as
+ * "src=D/E/L,D/E/L,...": dials, exhausted, and live, in pool order.
+ * snprintf semantics; returns the untruncated length. */
+size_t odin_dial_source_pool_stats_format(const odin_dial_source_pool_t *pool,
+                                          char *buf, size_t cap);
+
+/* Frees the pool; NULL is a no-op. No dial or socket may still reference it.
+ */
+void odin_dial_source_pool_destroy(odin_dial_source_pool_t *pool);
+
 /* Stops any still-active loop registration (the WRITE watch or the
  * deferred-error timer), closes the socket only if the dial still owns it (an
  * in-flight or aborted attempt -- after ODIN_DIAL_OK the socket has passed to
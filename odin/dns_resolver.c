@@ -8,6 +8,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <netinet/in.h>
 #include <pthread.h>
@@ -15,7 +16,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/time.h>
+#include <time.h>
+
+#include "odin/trace.h"
 
 typedef struct odin_dns_watch_t odin_dns_watch_t;
 
@@ -27,12 +32,66 @@ struct odin_dns_watch_t {
   odin_dns_watch_t *next;
 };
 
+/* One cached answer per (name, family). An expired entry keeps its slot and
+ * its use counts until a new name needs the slot, so a hot name that expired
+ * is still recognised as hot. */
+typedef struct odin_dns_cache_entry_t {
+  char name[ODIN_DNS_NAME_MAX + 1];
+  size_t name_len; /* 0: free slot */
+  int family;
+  uint32_t hash; /* cache_hash of the case-folded name and family */
+  uint32_t next; /* next entry in the bucket, as index + 1; 0 ends */
+  odin_dns_addr_t *addrs;
+  size_t addr_count;
+  uint64_t refresh_ms;
+  uint64_t expires_ms;
+  uint64_t last_used;
+  uint32_t uses;       /* lookups since this answer was stored */
+  uint32_t prior_uses; /* lookups during the previous answer    */
+  odin_dns_query_t *refresh;
+} odin_dns_cache_entry_t;
+
+typedef struct odin_dns_cache_t {
+  odin_dns_cache_entry_t *entries;
+  size_t capacity;
+  size_t used;       /* slots handed out; entries[used..] are free */
+  uint32_t *buckets; /* chain heads, as entry index + 1; 0: empty */
+  uint32_t bucket_mask;
+  int refresh_percent;
+  uint64_t refresh_interval_ms;
+  uint64_t refresh_tat_ms; /* rate limit: theoretical arrival time */
+  uint64_t use_clock;
+  odin_event_timer_t *sweep_timer;
+  odin_dns_cache_stats_t stats;
+} odin_dns_cache_t;
+
 struct odin_dns_resolver_t {
   odin_event_loop_t *loop;
   char *servers_csv;
   int timeout_ms;
   int tries;
   odin_dns_query_t *queries;
+  odin_dns_cache_t *cache;
+};
+
+/* One child query per family; each slot is cleared when its answer lands. A
+ * numeric host starts only the child for its own family. */
+struct odin_dns_stream_t {
+  odin_dns_query_t *v4;
+  odin_dns_query_t *v6;
+  odin_dns_partial_cb on_partial;
+  odin_dns_stream_done_cb on_done;
+  void *user_data;
+  odin_dns_query_t *one_shot; /* AF_UNSPEC query this stream answers */
+  size_t pending;
+  size_t usable;
+  int first_err;
+  int in_callback;
+  int destroy_requested;
+#if defined(ODIN_DNS_RESOLVER_TESTING)
+  int test_mirror_op; /* scripted answer the A child took; 0: none */
+  int test_mirror_status;
+#endif
 };
 
 struct odin_dns_query_t {
@@ -61,6 +120,14 @@ struct odin_dns_query_t {
   int destroying;
   int suppress_callbacks;
   int in_callback;
+  int cache_store;              /* store a successful answer (RFC-044) */
+  odin_dns_addr_t *cache_addrs; /* answer taken from the cache         */
+  size_t cache_addr_count;
+  odin_dns_stream_t *stream;     /* AF_UNSPEC: the per-family lookups  */
+  odin_dns_addr_t *merged_addrs; /* AF_UNSPEC: partial answers so far  */
+  size_t merged_count;
+  int merged_ok;  /* some family answered */
+  int merged_err; /* first family error   */
 #if defined(ODIN_DNS_RESOLVER_TESTING)
   int test_result_allocated;
   int test_addr_result_ready;
@@ -88,6 +155,7 @@ static odin_dns_resolver_test_addr_result_t *g_addr_results;
 static size_t g_addr_results_len;
 static size_t g_addr_results_cap;
 static int g_fail_next_result_alloc;
+static uint64_t g_test_now_ms;
 
 static void test_live_resolvers_add(void) {
   pthread_mutex_lock(&g_test_mu);
@@ -452,6 +520,30 @@ complete_test_addr_result(odin_dns_query_t *query,
   }
 }
 
+static void stream_on_family(odin_dns_query_t *query, odin_dns_status_t status,
+                             int err, const odin_dns_addr_t *addrs,
+                             size_t addr_count, void *user_data);
+
+/* A scripted answer stands for one lookup. Under an AF_UNSPEC one-shot the A
+ * child takes it and the AAAA child mirrors it (an address list becomes an
+ * empty answer), so scripts written for one lookup keep their meaning. */
+static odin_dns_stream_t *one_shot_stream(odin_dns_query_t *query) {
+  if (query->on_done != stream_on_family) {
+    return NULL;
+  }
+  odin_dns_stream_t *stream = (odin_dns_stream_t *)query->user_data;
+  return stream->one_shot != NULL ? stream : NULL;
+}
+
+static void complete_test_mirror(odin_dns_query_t *query,
+                                 const odin_dns_stream_t *stream) {
+  if (stream->test_mirror_op == ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS) {
+    complete_test_empty_success(query);
+  } else if (stream->test_mirror_op == ODIN_DNS_TEST_CARES_RESULT_STATUS) {
+    complete_test_result(query, stream->test_mirror_status);
+  }
+}
+
 static void dns_ares_getaddrinfo(odin_dns_query_t *query, const char *node,
                                  const char *service,
                                  const struct ares_addrinfo_hints *hints) {
@@ -463,23 +555,34 @@ static void dns_ares_getaddrinfo(odin_dns_query_t *query, const char *node,
   g_obs.last_ai_family = hints != NULL ? hints->ai_family : 0;
   pthread_mutex_unlock(&g_test_mu);
 
-  memset(&addr_result, 0, sizeof(addr_result));
-  if (test_pop_addr_result(&addr_result)) {
-    complete_test_addr_result(query, &addr_result);
-    return;
-  }
-
-  if (test_pop_step(ODIN_DNS_TEST_CARES_RESULT_PENDING, &step)) {
+  odin_dns_stream_t *one_shot = one_shot_stream(query);
+  if (one_shot != NULL && query->family == AF_INET6 &&
+      one_shot->test_mirror_op != 0) {
+    complete_test_mirror(query, one_shot);
     return;
   }
 
-  if (test_pop_step(ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS, &step)) {
-    complete_test_empty_success(query);
+  memset(&addr_result, 0, sizeof(addr_result));
+  if (test_pop_addr_result(&addr_result)) {
+    if (one_shot != NULL) {
+      one_shot->test_mirror_op = ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS;
+    }
+    complete_test_addr_result(query, &addr_result);
     return;
   }
 
-  if (test_pop_step(ODIN_DNS_TEST_CARES_RESULT_STATUS, &step)) {
-    complete_test_result(query, step.status);
+  if (test_pop_step(ODIN_DNS_TEST_CARES_RESULT_PENDING, &step) ||
+      test_pop_step(ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS, &step) ||
+      test_pop_step(ODIN_DNS_TEST_CARES_RESULT_STATUS, &step)) {
+    if (one_shot != NULL) {
+      one_shot->test_mirror_op = step.op;
+      one_shot->test_mirror_status = step.status;
+    }
+    if (step.op == ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS) {
+      complete_test_empty_success(query);
+    } else if (step.op == ODIN_DNS_TEST_CARES_RESULT_STATUS) {
+      complete_test_result(query, step.status);
+    }
     return;
   }
 
@@ -746,12 +849,18 @@ static void free_recorded_result(odin_dns_query_t *query) {
 }
 
 static void free_query_storage(odin_dns_query_t *query) {
+  free(query->merged_addrs);
+  free(query->cache_addrs);
   free(query->name);
   free(query);
   test_live_queries_sub();
 }
 
 static void cleanup_query(odin_dns_query_t *query) {
+  if (query->stream != NULL) {
+    odin_dns_stream_destroy(query->stream);
+    query->stream = NULL;
+  }
   stop_all_watches(query);
   clear_timeout_timer(query);
   clear_finalizer_timer(query);
@@ -1036,6 +1145,214 @@ static int copy_test_addr_results(odin_dns_query_t *query,
 }
 #endif
 
+static uint64_t dns_now_ms(void) {
+#if defined(ODIN_DNS_RESOLVER_TESTING)
+  if (g_test_now_ms != 0) {
+    return g_test_now_ms;
+  }
+#endif
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void set_addr_port(odin_dns_addr_t *addr, uint16_t port) {
+  if (addr->addr.ss_family == AF_INET) {
+    ((struct sockaddr_in *)&addr->addr)->sin_port = htons(port);
+  } else if (addr->addr.ss_family == AF_INET6) {
+    ((struct sockaddr_in6 *)&addr->addr)->sin6_port = htons(port);
+  }
+}
+
+static unsigned char ascii_fold(unsigned char c) {
+  return c >= 'A' && c <= 'Z' ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+/* FNV-1a over the case-folded name, with the family mixed in last. */
+static uint32_t cache_hash(const char *name, size_t name_len, int family) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < name_len; ++i) {
+    h = (h ^ ascii_fold((unsigned char)name[i])) * 16777619u;
+  }
+  return (h ^ (uint32_t)family) * 16777619u;
+}
+
+static odin_dns_cache_entry_t *cache_find(odin_dns_cache_t *cache,
+                                          const char *name, size_t name_len,
+                                          int family, uint32_t hash) {
+  uint32_t next = cache->buckets[hash & cache->bucket_mask];
+  while (next != 0) {
+    odin_dns_cache_entry_t *e = &cache->entries[next - 1];
+    if (e->hash == hash && e->name_len == name_len && e->family == family &&
+        strncasecmp(e->name, name, name_len) == 0) {
+      return e;
+    }
+    next = e->next;
+  }
+  return NULL;
+}
+
+static void cache_link(odin_dns_cache_t *cache, odin_dns_cache_entry_t *e) {
+  uint32_t *head = &cache->buckets[e->hash & cache->bucket_mask];
+  e->next = *head;
+  *head = (uint32_t)(e - cache->entries) + 1u;
+}
+
+static void cache_unlink(odin_dns_cache_t *cache, odin_dns_cache_entry_t *e) {
+  const uint32_t self = (uint32_t)(e - cache->entries) + 1u;
+  uint32_t *link = &cache->buckets[e->hash & cache->bucket_mask];
+  while (*link != self) {
+    link = &cache->entries[*link - 1].next;
+  }
+  *link = e->next;
+}
+
+static void cache_release_entry(odin_dns_cache_entry_t *e) {
+  odin_dns_query_destroy(e->refresh);
+  free(e->addrs);
+  memset(e, 0, sizeof(*e));
+}
+
+/* Finds the live entry for (name, family) and records the lookup against it,
+ * or returns NULL. A miss is recorded only when count_miss is set; the caller
+ * records the hit with cache_count_hit once the answer is delivered. */
+static const odin_dns_cache_entry_t *
+cache_hit(odin_dns_cache_t *cache, const char *name, size_t name_len,
+          int family, uint64_t now, int count_miss, int *hot_out) {
+  odin_dns_cache_entry_t *e = cache_find(cache, name, name_len, family,
+                                         cache_hash(name, name_len, family));
+  const int live = e != NULL && now < e->expires_ms;
+  if (!live && !count_miss) {
+    return NULL;
+  }
+  cache->stats.lookups += 1;
+  if (e == NULL) {
+    cache->stats.misses += 1;
+    return NULL;
+  }
+  const int hot = e->uses + e->prior_uses >= ODIN_DNS_CACHE_HOT_USES;
+  e->uses += 1;
+  e->last_used = ++cache->use_clock;
+  if (hot) {
+    cache->stats.hot_lookups += 1;
+  }
+  if (!live) {
+    cache->stats.misses += 1;
+    return NULL;
+  }
+  *hot_out = hot;
+  return e;
+}
+
+static void cache_count_hit(odin_dns_cache_t *cache, int hot) {
+  cache->stats.hits += 1;
+  if (hot) {
+    cache->stats.hot_hits += 1;
+  }
+}
+
+/* Copies up to cap of e's addresses with the requested port and the TTL the
+ * entry has left, so a downstream cache (RFC-045) never keeps the answer past
+ * this entry's expiry. */
+static size_t cache_copy_answer(const odin_dns_cache_entry_t *e, uint64_t now,
+                                uint16_t port, odin_dns_addr_t *addrs,
+                                size_t cap) {
+  const size_t n = e->addr_count < cap ? e->addr_count : cap;
+  const int left_s = (int)((e->expires_ms - now + 999u) / 1000u);
+  memcpy(addrs, e->addrs, n * sizeof(addrs[0]));
+  for (size_t i = 0; i < n; ++i) {
+    set_addr_port(&addrs[i], port);
+    if (addrs[i].ttl > left_s) {
+      addrs[i].ttl = left_s;
+    }
+  }
+  return n;
+}
+
+/* Records one lookup and, on a live entry, copies its answer into query for
+ * delivery from the loop. Returns 1 on a hit. */
+static int cache_lookup(odin_dns_cache_t *cache, odin_dns_query_t *query) {
+  const uint64_t now = dns_now_ms();
+  int hot = 0;
+  const odin_dns_cache_entry_t *e = cache_hit(
+      cache, query->name, strlen(query->name), query->family, now, 1, &hot);
+  if (e == NULL) {
+    return 0;
+  }
+  query->cache_addrs =
+      (odin_dns_addr_t *)calloc(e->addr_count, sizeof(query->cache_addrs[0]));
+  if (query->cache_addrs == NULL) {
+    cache->stats.misses += 1;
+    return 0;
+  }
+  query->cache_addr_count = cache_copy_answer(e, now, query->port,
+                                              query->cache_addrs,
+                                              e->addr_count);
+  cache_count_hit(cache, hot);
+  return 1;
+}
+
+/* Stores a successful answer for query's name. Answers without a positive TTL
+ * (address literals, empty answers) are not cached. */
+static void cache_store(odin_dns_cache_t *cache, const odin_dns_query_t *query,
+                        const odin_dns_addr_t *addrs, size_t addr_count) {
+  int ttl_s = ODIN_DNS_CACHE_MAX_TTL_S;
+  for (size_t i = 0; i < addr_count; ++i) {
+    if (addrs[i].ttl < ttl_s) {
+      ttl_s = addrs[i].ttl;
+    }
+  }
+  if (addr_count == 0 || ttl_s <= 0) {
+    return;
+  }
+  odin_dns_addr_t *copy =
+      (odin_dns_addr_t *)malloc(addr_count * sizeof(copy[0]));
+  if (copy == NULL) {
+    return;
+  }
+  memcpy(copy, addrs, addr_count * sizeof(copy[0]));
+
+  const size_t name_len = strlen(query->name);
+  const uint32_t hash = cache_hash(query->name, name_len, query->family);
+  odin_dns_cache_entry_t *e =
+      cache_find(cache, query->name, name_len, query->family, hash);
+  if (e != NULL) {
+    e->prior_uses = e->uses;
+    e->uses = 0;
+  } else {
+    /* A free slot first; otherwise the least recently used entry. Only a new
+     * name on a full cache pays for the scan. */
+    if (cache->used < cache->capacity) {
+      e = &cache->entries[cache->used++];
+    } else {
+      e = &cache->entries[0];
+      for (size_t i = 1; i < cache->capacity; ++i) {
+        if (cache->entries[i].last_used < e->last_used) {
+          e = &cache->entries[i];
+        }
+      }
+      cache_unlink(cache, e);
+      cache_release_entry(e);
+      cache->stats.evictions += 1;
+    }
+    memcpy(e->name, query->name, name_len);
+    e->name[name_len] = '\0';
+    e->name_len = name_len;
+    e->family = query->family;
+    e->hash = hash;
+    e->uses = 1; /* the lookup that missed */
+    e->last_used = ++cache->use_clock;
+    cache_link(cache, e);
+  }
+  free(e->addrs);
+  e->addrs = copy;
+  e->addr_count = addr_count;
+  const uint64_t now = dns_now_ms();
+  const uint64_t ttl_ms = (uint64_t)ttl_s * 1000u;
+  e->refresh_ms = now + ttl_ms * (uint64_t)cache->refresh_percent / 100u;
+  e->expires_ms = now + ttl_ms;
+}
+
 static void run_finalizer(odin_dns_query_t *query) {
   if (query->destroying || query->completed) {
     return;
@@ -1051,7 +1368,13 @@ static void run_finalizer(odin_dns_query_t *query) {
   odin_dns_addr_t *addrs = NULL;
   size_t addr_count = 0;
 
-  if (!query->fatal_pending && query->result_status == ARES_SUCCESS) {
+  if (query->cache_addrs != NULL) {
+    addrs = query->cache_addrs;
+    addr_count = query->cache_addr_count;
+    query->cache_addrs = NULL;
+    status = ODIN_DNS_OK;
+    err = 0;
+  } else if (!query->fatal_pending && query->result_status == ARES_SUCCESS) {
 #if defined(ODIN_DNS_RESOLVER_TESTING)
     if (query->test_addr_result_ready) {
       if (copy_test_addr_results(query, &addrs, &addr_count) == 0) {
@@ -1076,7 +1399,13 @@ static void run_finalizer(odin_dns_query_t *query) {
   free_recorded_result(query);
   destroy_channel(query);
   query->completed = 1;
+  if (status == ODIN_DNS_OK && query->cache_store &&
+      query->resolver->cache != NULL) {
+    cache_store(query->resolver->cache, query, addrs, addr_count);
+  }
 
+  ODIN_TRACE3(dns__done, query, err,
+              status == ODIN_DNS_OK ? addr_count : (size_t)0);
   odin_dns_cb cb = query->on_done;
   void *user_data = query->user_data;
   query->in_callback = 1;
@@ -1222,10 +1551,12 @@ int odin_dns_resolver_create(odin_event_loop_t *loop,
   return 0;
 }
 
-int odin_dns_resolve_start(odin_dns_resolver_t *resolver, const char *name,
-                           size_t name_len, uint16_t port, int family,
-                           odin_dns_cb on_done, void *user_data,
-                           odin_dns_query_t **out) {
+/* refresh: a background refresh (RFC-044), which skips the cache lookup but
+ * still stores its answer. */
+static int resolve_start(odin_dns_resolver_t *resolver, const char *name,
+                         size_t name_len, uint16_t port, int family,
+                         odin_dns_cb on_done, void *user_data, int refresh,
+                         odin_dns_query_t **out) {
   if (out == NULL) {
     errno = EINVAL;
     return -1;
@@ -1267,6 +1598,23 @@ int odin_dns_resolve_start(odin_dns_resolver_t *resolver, const char *name,
     return -1;
   }
 
+  if (resolver->cache != NULL) {
+    if (!refresh && cache_lookup(resolver->cache, query)) {
+      link_query(resolver, query);
+      if (arm_finalizer_timer(query) != 0) {
+        const int err = errno;
+        cleanup_query(query);
+        errno = err;
+        return -1;
+      }
+      query->published = 1;
+      ODIN_TRACE4(dns__start, query, query->name, family, 1);
+      *out = query;
+      return 0;
+    }
+    query->cache_store = 1;
+  }
+
   struct ares_options options;
   memset(&options, 0, sizeof(options));
   options.flags = ARES_FLAG_NOALIASES | ARES_FLAG_NOSEARCH;
@@ -1320,11 +1668,118 @@ int odin_dns_resolve_start(odin_dns_resolver_t *resolver, const char *name,
     return -1;
   }
 
+  query->published = 1;
+  ODIN_TRACE4(dns__start, query, query->name, family, 0);
+  *out = query;
+  return 0;
+}
+
+static int stream_start(odin_dns_resolver_t *resolver, const char *name,
+                        size_t name_len, uint16_t port,
+                        odin_dns_partial_cb on_partial,
+                        odin_dns_stream_done_cb on_done, void *user_data,
+                        odin_dns_query_t *one_shot, odin_dns_stream_t **out);
+
+/* An AF_UNSPEC one-shot is a stream whose partials are gathered and handed
+ * over together once every family has answered (RFC-043). */
+static void one_shot_partial(odin_dns_stream_t *stream, int family,
+                             odin_dns_status_t status, int err,
+                             const odin_dns_addr_t *addrs, size_t addr_count,
+                             void *user_data) {
+  (void)stream;
+  (void)family;
+  odin_dns_query_t *query = (odin_dns_query_t *)user_data;
+  if (status != ODIN_DNS_OK) {
+    if (query->merged_err == 0) {
+      query->merged_err = err;
+    }
+    return;
+  }
+  query->merged_ok = 1;
+  if (addr_count == 0 || query->fatal_pending) {
+    return;
+  }
+  odin_dns_addr_t *grown = (odin_dns_addr_t *)realloc(
+      query->merged_addrs,
+      (query->merged_count + addr_count) * sizeof(*grown));
+  if (grown == NULL) {
+    enter_fatal(query, ENOMEM);
+    return;
+  }
+  memcpy(&grown[query->merged_count], addrs, addr_count * sizeof(*grown));
+  query->merged_addrs = grown;
+  query->merged_count += addr_count;
+}
+
+static void one_shot_done(odin_dns_stream_t *stream, odin_dns_status_t status,
+                          int err, void *user_data) {
+  (void)stream;
+  (void)status;
+  (void)err;
+  odin_dns_query_t *query = (odin_dns_query_t *)user_data;
+  odin_dns_addr_t *addrs = query->merged_addrs;
+  const size_t addr_count = query->merged_count;
+  query->merged_addrs = NULL;
+  query->merged_count = 0;
+
+  odin_dns_status_t out = ODIN_DNS_OK;
+  int out_err = 0;
+  if (query->fatal_pending) {
+    out = ODIN_DNS_ERROR;
+    out_err = query->fatal_errno;
+  } else if (!query->merged_ok) {
+    out = ODIN_DNS_ERROR;
+    out_err = query->merged_err != 0 ? query->merged_err : EHOSTUNREACH;
+  }
+  query->completed = 1;
+  query->in_callback = 1;
+  query->on_done(query, out, out_err, out == ODIN_DNS_OK ? addrs : NULL,
+                 out == ODIN_DNS_OK ? addr_count : 0, query->user_data);
+  free(addrs);
+}
+
+static int one_shot_start(odin_dns_resolver_t *resolver, const char *name,
+                          size_t name_len, uint16_t port, odin_dns_cb on_done,
+                          void *user_data, odin_dns_query_t **out) {
+  if (out == NULL || resolver == NULL || on_done == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_dns_query_t *query = (odin_dns_query_t *)calloc(1, sizeof(*query));
+  if (query == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  test_live_queries_add();
+  query->port = port;
+  query->family = AF_UNSPEC;
+  query->on_done = on_done;
+  query->user_data = user_data;
+  if (stream_start(resolver, name, name_len, port, one_shot_partial,
+                   one_shot_done, query, query, &query->stream) != 0) {
+    const int err = errno;
+    free_query_storage(query);
+    errno = err;
+    return -1;
+  }
+  link_query(resolver, query);
   query->published = 1;
   *out = query;
   return 0;
 }
 
+int odin_dns_resolve_start(odin_dns_resolver_t *resolver, const char *name,
+                           size_t name_len, uint16_t port, int family,
+                           odin_dns_cb on_done, void *user_data,
+                           odin_dns_query_t **out) {
+  if (family == AF_UNSPEC) {
+    return one_shot_start(resolver, name, name_len, port, on_done, user_data,
+                          out);
+  }
+  return resolve_start(resolver, name, name_len, port, family, on_done,
+                       user_data, 0, out);
+}
+
 void odin_dns_query_destroy(odin_dns_query_t *query) {
   if (query == NULL) {
     return;
@@ -1334,6 +1789,313 @@ void odin_dns_query_destroy(odin_dns_query_t *query) {
   cleanup_query(query);
 }
 
+static void stream_on_family(odin_dns_query_t *query, odin_dns_status_t status,
+                             int err, const odin_dns_addr_t *addrs,
+                             size_t addr_count, void *user_data) {
+  odin_dns_stream_t *stream = (odin_dns_stream_t *)user_data;
+  const int family = query->family;
+  if (family == AF_INET) {
+    stream->v4 = NULL;
+  } else {
+    stream->v6 = NULL;
+  }
+  odin_dns_query_destroy(query);
+  stream->pending -= 1;
+
+  if (status == ODIN_DNS_OK) {
+    stream->usable += addr_count;
+  } else if (stream->first_err == 0) {
+    stream->first_err = err;
+  }
+
+  stream->in_callback = 1;
+  stream->on_partial(stream, family, status, err, addrs, addr_count,
+                     stream->user_data);
+  if (stream->pending == 0 && !stream->destroy_requested) {
+    if (stream->usable > 0) {
+      stream->on_done(stream, ODIN_DNS_OK, 0, stream->user_data);
+    } else {
+      stream->on_done(stream, ODIN_DNS_ERROR,
+                      stream->first_err != 0 ? stream->first_err : EHOSTUNREACH,
+                      stream->user_data);
+    }
+  }
+  stream->in_callback = 0;
+  if (stream->destroy_requested) {
+    free(stream);
+  }
+}
+
+/* The family a numeric host names, else AF_UNSPEC. Asking the other family
+ * for a literal costs a lookup that cannot answer. */
+static int literal_family(const char *name, size_t name_len) {
+  char text[INET6_ADDRSTRLEN];
+  unsigned char bin[sizeof(struct in6_addr)];
+  if (name == NULL || name_len == 0 || name_len >= sizeof(text) ||
+      memchr(name, '\0', name_len) != NULL) {
+    return AF_UNSPEC;
+  }
+  memcpy(text, name, name_len);
+  text[name_len] = '\0';
+  if (inet_pton(AF_INET, text, bin) == 1) {
+    return AF_INET;
+  }
+  if (inet_pton(AF_INET6, text, bin) == 1) {
+    return AF_INET6;
+  }
+  return AF_UNSPEC;
+}
+
+static int stream_start(odin_dns_resolver_t *resolver, const char *name,
+                        size_t name_len, uint16_t port,
+                        odin_dns_partial_cb on_partial,
+                        odin_dns_stream_done_cb on_done, void *user_data,
+                        odin_dns_query_t *one_shot, odin_dns_stream_t **out) {
+  if (out == NULL || on_partial == NULL || on_done == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_dns_stream_t *stream = (odin_dns_stream_t *)calloc(1, sizeof(*stream));
+  if (stream == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  stream->on_partial = on_partial;
+  stream->on_done = on_done;
+  stream->user_data = user_data;
+  stream->one_shot = one_shot;
+
+  /* Answers are always delivered from the loop, never inside start, so both
+   * children exist before either callback can run. */
+  const int only = literal_family(name, name_len);
+  if (only != AF_INET6 &&
+      resolve_start(resolver, name, name_len, port, AF_INET, stream_on_family,
+                    stream, 0, &stream->v4) != 0) {
+    const int err = errno;
+    free(stream);
+    errno = err;
+    return -1;
+  }
+  if (only != AF_INET &&
+      resolve_start(resolver, name, name_len, port, AF_INET6,
+                    stream_on_family, stream, 0, &stream->v6) != 0) {
+    const int err = errno;
+    odin_dns_query_destroy(stream->v4);
+    free(stream);
+    errno = err;
+    return -1;
+  }
+  stream->pending = (stream->v4 != NULL) + (stream->v6 != NULL);
+  *out = stream;
+  return 0;
+}
+
+int odin_dns_resolve_stream_start(odin_dns_resolver_t *resolver,
+                                  const char *name, size_t name_len,
+                                  uint16_t port, odin_dns_partial_cb on_partial,
+                                  odin_dns_stream_done_cb on_done,
+                                  void *user_data, odin_dns_stream_t **out) {
+  return stream_start(resolver, name, name_len, port, on_partial, on_done,
+                      user_data, NULL, out);
+}
+
+void odin_dns_stream_destroy(odin_dns_stream_t *stream) {
+  if (stream == NULL) {
+    return;
+  }
+  odin_dns_query_destroy(stream->v4);
+  odin_dns_query_destroy(stream->v6);
+  stream->v4 = NULL;
+  stream->v6 = NULL;
+  if (stream->in_callback) {
+    stream->destroy_requested = 1;
+    return;
+  }
+  free(stream);
+}
+
+static void cache_refresh_done(odin_dns_query_t *query,
+                               odin_dns_status_t status, int err,
+                               const odin_dns_addr_t *addrs, size_t addr_count,
+                               void *user_data) {
+  (void)err;
+  (void)addrs;
+  odin_dns_cache_entry_t *e = (odin_dns_cache_entry_t *)user_data;
+  odin_dns_cache_t *cache = query->resolver->cache;
+  e->refresh = NULL;
+  odin_dns_query_destroy(query);
+  if (status != ODIN_DNS_OK || addr_count == 0) {
+    cache->stats.refresh_failures += 1;
+  }
+}
+
+/* Rate limit as a generic cell: each refresh advances the theoretical arrival
+ * time by one interval, and a refresh is allowed while that time stays within
+ * one second of now, i.e. a burst of refresh_per_sec, then refresh_per_sec per
+ * second. */
+static int cache_take_refresh_token(odin_dns_cache_t *cache, uint64_t now) {
+  const uint64_t tat =
+      cache->refresh_tat_ms > now ? cache->refresh_tat_ms : now;
+  if (tat + cache->refresh_interval_ms > now + 1000u) {
+    return 0;
+  }
+  cache->refresh_tat_ms = tat + cache->refresh_interval_ms;
+  return 1;
+}
+
+/* Starts a background refresh for each hot, still-live entry past its
+ * refresh point. Expired entries are left to the next lookup. */
+static void cache_sweep(odin_dns_resolver_t *resolver) {
+  odin_dns_cache_t *cache = resolver->cache;
+  const uint64_t now = dns_now_ms();
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    odin_dns_cache_entry_t *e = &cache->entries[i];
+    if (e->name_len == 0 || e->refresh != NULL || now < e->refresh_ms ||
+        now >= e->expires_ms || e->uses == 0 ||
+        e->uses + e->prior_uses < ODIN_DNS_CACHE_HOT_USES) {
+      continue;
+    }
+    if (!cache_take_refresh_token(cache, now)) {
+      cache->stats.refresh_deferred += 1;
+      continue;
+    }
+    if (resolve_start(resolver, e->name, e->name_len, 0, e->family,
+                      cache_refresh_done, e, 1, &e->refresh) != 0) {
+      e->refresh = NULL;
+      cache->stats.refresh_failures += 1;
+      continue;
+    }
+    cache->stats.refreshes += 1;
+  }
+}
+
+static void on_cache_sweep(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                           void *user_data) {
+  (void)loop;
+  (void)timer;
+  cache_sweep((odin_dns_resolver_t *)user_data);
+}
+
+int odin_dns_resolver_set_cache(odin_dns_resolver_t *resolver,
+                                const odin_dns_cache_config_t *config) {
+  const odin_dns_cache_config_t defaults = {0, 0, 0};
+  if (config == NULL) {
+    config = &defaults;
+  }
+  if (resolver == NULL || config->entries > ODIN_DNS_CACHE_MAX_ENTRIES ||
+      config->refresh_percent < 0 || config->refresh_percent > 99 ||
+      config->refresh_per_sec < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (resolver->cache != NULL) {
+    errno = EALREADY;
+    return -1;
+  }
+  odin_dns_cache_t *cache = (odin_dns_cache_t *)calloc(1, sizeof(*cache));
+  if (cache == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  cache->capacity = config->entries != 0 ? config->entries
+                                         : ODIN_DNS_CACHE_DEFAULT_ENTRIES;
+  cache->refresh_percent = config->refresh_percent != 0
+                               ? config->refresh_percent
+                               : ODIN_DNS_REFRESH_DEFAULT_PERCENT;
+  const int per_sec = config->refresh_per_sec != 0
+                          ? config->refresh_per_sec
+                          : ODIN_DNS_REFRESH_DEFAULT_PER_SEC;
+  cache->refresh_interval_ms =
+      per_sec >= 1000 ? 1u : 1000u / (uint64_t)per_sec;
+  /* At least two buckets per entry keeps chains short at any fill. */
+  size_t buckets = 2;
+  while (buckets < cache->capacity * 2u) {
+    buckets *= 2u;
+  }
+  cache->bucket_mask = (uint32_t)(buckets - 1u);
+  cache->entries = (odin_dns_cache_entry_t *)calloc(cache->capacity,
+                                                    sizeof(cache->entries[0]));
+  cache->buckets = (uint32_t *)calloc(buckets, sizeof(cache->buckets[0]));
+  if (cache->entries == NULL || cache->buckets == NULL) {
+    free(cache->buckets);
+    free(cache->entries);
+    free(cache);
+    errno = ENOMEM;
+    return -1;
+  }
+  if (odin_event_timer_start(resolver->loop,
+                             ODIN_DNS_REFRESH_SWEEP_MS * 1000u,
+                             ODIN_DNS_REFRESH_SWEEP_MS * 1000u, on_cache_sweep,
+                             resolver, &cache->sweep_timer) != 0) {
+    const int err = errno;
+    free(cache->buckets);
+    free(cache->entries);
+    free(cache);
+    errno = err;
+    return -1;
+  }
+  resolver->cache = cache;
+  return 0;
+}
+
+size_t odin_dns_resolver_cache_get(odin_dns_resolver_t *resolver,
+                                   const char *name, size_t name_len,
+                                   uint16_t port, int family,
+                                   odin_dns_addr_t *addrs, size_t cap) {
+  if (resolver == NULL || resolver->cache == NULL || name == NULL ||
+      name_len == 0 || name_len > ODIN_DNS_NAME_MAX || addrs == NULL ||
+      cap == 0) {
+    return 0;
+  }
+  const uint64_t now = dns_now_ms();
+  int hot = 0;
+  const odin_dns_cache_entry_t *e =
+      cache_hit(resolver->cache, name, name_len, family, now, 0, &hot);
+  if (e == NULL) {
+    return 0;
+  }
+  cache_count_hit(resolver->cache, hot);
+  return cache_copy_answer(e, now, port, addrs, cap);
+}
+
+void odin_dns_resolver_cache_stats(const odin_dns_resolver_t *resolver,
+                                   odin_dns_cache_stats_t *out) {
+  if (out == NULL) {
+    return;
+  }
+  if (resolver == NULL || resolver->cache == NULL) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = resolver->cache->stats;
+}
+
+size_t odin_dns_cache_stats_format(const odin_dns_cache_stats_t *stats,
+                                   char *buf, size_t cap) {
+  const int n =
+      snprintf(buf, cap,
+               "dns=%" PRIu64 "/%" PRIu64 " hot=%" PRIu64 "/%" PRIu64
+               " refresh=%" PRIu64 "/%" PRIu64 "/%" PRIu64,
+               stats->hits, stats->misses, stats->hot_hits, stats->hot_lookups,
+               stats->refreshes, stats->refresh_failures,
+               stats->refresh_deferred);
+  return n > 0 ? (size_t)n : 0;
+}
+
+/* Runs after every query is gone, so no entry still owns a refresh. */
+static void cache_destroy(odin_dns_cache_t *cache) {
+  if (cache == NULL) {
+    return;
+  }
+  odin_event_timer_stop(cache->sweep_timer);
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    free(cache->entries[i].addrs);
+  }
+  free(cache->buckets);
+  free(cache->entries);
+  free(cache);
+}
+
 void odin_dns_resolver_destroy(odin_dns_resolver_t *resolver) {
   if (resolver == NULL) {
     return;
@@ -1347,9 +2109,15 @@ void odin_dns_resolver_destroy(odin_dns_resolver_t *resolver) {
     query->next = NULL;
     query->destroying = 1;
     query->suppress_callbacks = 1;
+    if (query->stream != NULL) {
+      /* Its children are on this list too and are freed in turn. */
+      query->stream->v4 = NULL;
+      query->stream->v6 = NULL;
+    }
     cleanup_query(query);
     query = next;
   }
+  cache_destroy(resolver->cache);
   free(resolver->servers_csv);
   free(resolver);
   test_live_resolvers_sub();
@@ -1481,6 +2249,17 @@ int odin_dns_resolver_test_fail_next_result_alloc(void) {
   return 0;
 }
 
+void odin_dns_resolver_test_set_now_ms(uint64_t ms) { g_test_now_ms = ms; }
+
+int odin_dns_resolver_test_refresh_sweep(odin_dns_resolver_t *resolver) {
+  if (resolver == NULL || resolver->cache == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  cache_sweep(resolver);
+  return 0;
+}
+
 int odin_dns_resolver_test_first_watch(odin_dns_query_t *query,
                                        odin_event_io_t **out_io, int *out_fd) {
   if (query == NULL || out_io == NULL || out_fd == NULL) {
@@ -15,8 +15,18 @@ extern "C" {
 
 #define ODIN_DNS_NAME_MAX 255
 
+/* RFC-044 answer cache limits and refresh-ahead defaults. */
+#define ODIN_DNS_CACHE_MAX_ENTRIES 4096u
+#define ODIN_DNS_CACHE_DEFAULT_ENTRIES 256u
+#define ODIN_DNS_CACHE_MAX_TTL_S 3600
+#define ODIN_DNS_CACHE_HOT_USES 3u
+#define ODIN_DNS_REFRESH_DEFAULT_PERCENT 80
+#define ODIN_DNS_REFRESH_DEFAULT_PER_SEC 20
+#define ODIN_DNS_REFRESH_SWEEP_MS 250u
+
 typedef struct odin_dns_resolver_t odin_dns_resolver_t;
 typedef struct odin_dns_query_t odin_dns_query_t;
+typedef struct odin_dns_stream_t odin_dns_stream_t;
 
 typedef enum odin_dns_status_t {
   ODIN_DNS_OK = 0,
@@ -29,6 +39,32 @@ typedef struct odin_dns_resolver_config_t {
   int tries;
 } odin_dns_resolver_config_t;
 
+/* Answer cache with refresh-ahead (RFC-044). Zero fields take the defaults
+ * above. refresh_percent is the share of an answer's TTL after which a hot
+ * name is re-resolved in the background; refresh_per_sec caps those
+ * background queries. */
+typedef struct odin_dns_cache_config_t {
+  size_t entries;
+  int refresh_percent;
+  int refresh_per_sec;
+} odin_dns_cache_config_t;
+
+/* A lookup is hot when its name was asked for at least
+ * ODIN_DNS_CACHE_HOT_USES times over its current and previous answer;
+ * hot_hits / hot_lookups is the share of hot lookups that never waited on
+ * DNS. */
+typedef struct odin_dns_cache_stats_t {
+  uint64_t lookups;          /* resolve starts that consulted the cache   */
+  uint64_t hits;             /* answered from a live entry                */
+  uint64_t misses;           /* went to the network                       */
+  uint64_t hot_lookups;      /* lookups of hot names                      */
+  uint64_t hot_hits;         /* hot lookups answered from the cache       */
+  uint64_t refreshes;        /* background refreshes started              */
+  uint64_t refresh_failures; /* refreshes that failed or found nothing    */
+  uint64_t refresh_deferred; /* due refreshes held back by the rate limit */
+  uint64_t evictions;        /* entries displaced by a new name           */
+} odin_dns_cache_stats_t;
+
 typedef struct odin_dns_addr_t {
   struct sockaddr_storage addr;
   socklen_t addrlen;
@@ -39,6 +75,23 @@ typedef void (*odin_dns_cb)(odin_dns_query_t *query, odin_dns_status_t status,
                             int err, const odin_dns_addr_t *addrs,
                             size_t addr_count, void *user_data);
 
+/* Streaming resolution (RFC-043): A and AAAA are asked independently and each
+ * family's answer is handed to on_partial as soon as it lands, so a caller can
+ * start connecting before the slower family finishes. family is AF_INET or
+ * AF_INET6; addrs is valid only for the duration of the call. on_done follows
+ * the last partial: ODIN_DNS_OK when any family produced an address, else
+ * ODIN_DNS_ERROR with the first family's errno. Either callback may call
+ * odin_dns_stream_destroy, which suppresses every later callback. A numeric
+ * host asks only its own family. An AF_UNSPEC odin_dns_resolve_start runs on
+ * a stream and reports every family's addresses in one callback. */
+typedef void (*odin_dns_partial_cb)(odin_dns_stream_t *stream, int family,
+                                    odin_dns_status_t status, int err,
+                                    const odin_dns_addr_t *addrs,
+                                    size_t addr_count, void *user_data);
+typedef void (*odin_dns_stream_done_cb)(odin_dns_stream_t *stream,
+                                        odin_dns_status_t status, int err,
+                                        void *user_data);
+
 int odin_dns_resolver_create(odin_event_loop_t *loop,
                              const odin_dns_resolver_config_t *config,
                              odin_dns_resolver_t **out);
@@ -47,8 +100,43 @@ int odin_dns_resolve_start(odin_dns_resolver_t *resolver, const char *name,
                            odin_dns_cb on_done, void *user_data,
                            odin_dns_query_t **out);
 void odin_dns_query_destroy(odin_dns_query_t *query);
+int odin_dns_resolve_stream_start(odin_dns_resolver_t *resolver,
+                                  const char *name, size_t name_len,
+                                  uint16_t port, odin_dns_partial_cb on_partial,
+                                  odin_dns_stream_done_cb on_done,
+                                  void *user_data, odin_dns_stream_t **out);
+void odin_dns_stream_destroy(odin_dns_stream_t *stream);
 void odin_dns_resolver_destroy(odin_dns_resolver_t *resolver);
 
+/* Turns on the answer cache; config NULL takes every default. A cached answer
+ * is still delivered from the loop, never inside odin_dns_resolve_start, with
+ * the requested port and each TTL cut to what the entry has left. Returns 0,
+ * or -1 with errno EINVAL (resolver NULL, entries >
+ * ODIN_DNS_CACHE_MAX_ENTRIES, refresh_percent outside 0..99, or
+ * refresh_per_sec < 0), EALREADY, or ENOMEM. */
+int odin_dns_resolver_set_cache(odin_dns_resolver_t *resolver,
+                                const odin_dns_cache_config_t *config);
+
+/* Synchronous cache probe: copies up to cap addresses of the live answer for
+ * (name, family) into addrs with the requested port and the TTL left, and
+ * returns how many were copied. Allocates nothing and runs no callback.
+ * Returns 0 on a miss, when the cache is off, or on bad arguments; a miss is
+ * not counted, since the query that follows it counts it. */
+size_t odin_dns_resolver_cache_get(odin_dns_resolver_t *resolver,
+                                   const char *name, size_t name_len,
+                                   uint16_t port, int family,
+                                   odin_dns_addr_t *addrs, size_t cap);
+
+/* Zeroes out when resolver is NULL or has no cache. */
+void odin_dns_resolver_cache_stats(const odin_dns_resolver_t *resolver,
+                                   odin_dns_cache_stats_t *out);
+
+/* Formats stats for the RFC-051 log line as "dns=H/M hot=HH/HL refresh=S/F/D":
+ * hits over misses, hot hits over hot lookups, then refreshes started,
+ * failed, and deferred. snprintf semantics; returns the untruncated length. */
+size_t odin_dns_cache_stats_format(const odin_dns_cache_stats_t *stats,
+                                   char *buf, size_t cap);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,690 @@
+/* odin/dns_stub.c -- RFC-045 local stub DNS listener over the tunnel. */
+
+#include "odin/dns_stub.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "odin/dns_tunnel.h"
+#include "odin/event_loop.h"
+#include "odin/protocol.h"
+
+#define DNS_HEADER_SIZE 12u
+#define DNS_FLAG_QR 0x8000u
+#define DNS_FLAG_OPCODE 0x7800u
+#define DNS_FLAG_TC 0x0200u
+#define DNS_FLAG_RD 0x0100u
+#define DNS_FLAG_RA 0x0080u
+#define DNS_ANSWER_FIXED 12u /* name pointer, type, class, ttl, rdlength */
+#define STUB_RESPONSE_MAX                                                     \
+  (ODIN_DNS_STUB_QUESTION_MAX +                                               \
+   ODIN_PROTO_DNS_ADDR_MAX * (DNS_ANSWER_FIXED + 16u))
+#define STUB_UDP_READS_PER_EVENT 64
+#define STUB_ACCEPTS_PER_EVENT 16
+#define STUB_UDP_RECV_MAX 4096u
+#define STUB_IDLE_SWEEP_US 1000000u
+
+typedef struct stub_conn_t stub_conn_t;
+typedef struct stub_req_t stub_req_t;
+
+struct stub_req_t {
+  odin_dns_stub_t *stub;
+  stub_conn_t *conn; /* NULL: UDP */
+  stub_req_t *prev;
+  stub_req_t *next;
+  odin_dns_tunnel_request_t *treq;
+  struct sockaddr_storage peer;
+  socklen_t peer_len;
+  odin_dns_stub_question_t q;
+  uint8_t query[ODIN_DNS_STUB_QUESTION_MAX];
+};
+
+struct stub_conn_t {
+  odin_dns_stub_t *stub;
+  stub_conn_t *prev;
+  stub_conn_t *next;
+  int fd;
+  odin_event_io_t *io;
+  unsigned int io_events;
+  int read_eof;
+  size_t pending;
+  stub_req_t *reqs;
+  uint64_t last_active_ms;
+  size_t in_used;
+  size_t out_used;
+  size_t out_cap;
+  uint8_t *out;
+  uint8_t in[2 + ODIN_DNS_STUB_TCP_MSG_MAX];
+};
+
+struct odin_dns_stub_t {
+  odin_event_loop_t *loop;
+  odin_dns_tunnel_client_t *tunnel;
+  int udp_fd;
+  int tcp_fd;
+  odin_event_io_t *udp_io;
+  odin_event_io_t *tcp_io;
+  odin_event_timer_t *idle_timer;
+  stub_req_t *udp_reqs;
+  size_t udp_pending;
+  stub_conn_t *conns;
+  size_t conn_count;
+};
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static int set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags == -1) {
+    return -1;
+  }
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static uint16_t rd16(const uint8_t *p) {
+  return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+}
+
+static void wr16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)(v & 0xFFu);
+}
+
+/* ---- wire format ------------------------------------------------------- */
+
+int odin_dns_stub_parse_query(const uint8_t *msg, size_t len,
+                              odin_dns_stub_question_t *out) {
+  if (msg == NULL || out == NULL || len < DNS_HEADER_SIZE) {
+    return -1;
+  }
+  const uint16_t flags = rd16(msg + 2);
+  if ((flags & DNS_FLAG_QR) != 0) {
+    return -1;
+  }
+  memset(out, 0, sizeof(*out));
+  out->id = rd16(msg);
+  out->flags = flags;
+  out->question_end = DNS_HEADER_SIZE;
+  if ((flags & DNS_FLAG_OPCODE) != 0) {
+    out->rcode = ODIN_DNS_RCODE_NOTIMP;
+    return 0;
+  }
+  if (rd16(msg + 4) != 1) {
+    out->rcode = ODIN_DNS_RCODE_FORMERR;
+    return 0;
+  }
+
+  size_t off = DNS_HEADER_SIZE;
+  size_t n = 0;
+  int unusable = 0;
+  for (;;) {
+    if (off >= len) {
+      out->rcode = ODIN_DNS_RCODE_FORMERR;
+      return 0;
+    }
+    const size_t label = msg[off++];
+    if (label == 0) {
+      break;
+    }
+    /* 0xC0 pointers have no business in a question; 0x40 and 0x80 are
+     * reserved label types. */
+    if (label > 63 || off + label > len ||
+        n + (n > 0 ? 1 : 0) + label > ODIN_PROTO_HOST_MAX) {
+      out->rcode = ODIN_DNS_RCODE_FORMERR;
+      return 0;
+    }
+    if (n > 0) {
+      out->name[n++] = '.';
+    }
+    for (size_t i = 0; i < label; ++i) {
+      const uint8_t c = msg[off + i];
+      if (c == '.' || c == '\0') {
+        unusable = 1;
+      }
+      out->name[n++] = (char)c;
+    }
+    off += label;
+  }
+  if (off + 4 > len) {
+    out->rcode = ODIN_DNS_RCODE_FORMERR;
+    return 0;
+  }
+  out->name[n] = '\0';
+  out->name_len = n;
+  out->qtype = rd16(msg + off);
+  out->qclass = rd16(msg + off + 2);
+  out->question_end = off + 4;
+  if (n == 0 || unusable || out->qclass != ODIN_DNS_CLASS_IN) {
+    out->rcode = ODIN_DNS_RCODE_REFUSED;
+  }
+  return 0;
+}
+
+size_t odin_dns_stub_build_response(const uint8_t *query,
+                                    const odin_dns_stub_question_t *q,
+                                    int rcode, uint32_t ttl,
+                                    const uint8_t *addrs, size_t count,
+                                    uint8_t *out, size_t cap) {
+  const size_t qend = q->question_end;
+  memcpy(out, query, qend);
+  size_t alen = 0;
+  if (q->qtype == ODIN_DNS_TYPE_A) {
+    alen = 4;
+  } else if (q->qtype == ODIN_DNS_TYPE_AAAA) {
+    alen = 16;
+  }
+  if (alen == 0 || addrs == NULL) {
+    count = 0;
+  }
+  const size_t fit = (cap - qend) / (DNS_ANSWER_FIXED + alen);
+  const size_t keep = count < fit ? count : fit;
+
+  uint16_t flags = (uint16_t)(DNS_FLAG_QR | DNS_FLAG_RA |
+                              (q->flags & (DNS_FLAG_OPCODE | DNS_FLAG_RD)) |
+                              ((unsigned)rcode & 0x0Fu));
+  if (keep < count) {
+    flags |= DNS_FLAG_TC;
+  }
+  wr16(out + 2, flags);
+  wr16(out + 4, qend > DNS_HEADER_SIZE ? 1 : 0);
+  wr16(out + 6, (uint16_t)keep);
+  wr16(out + 8, 0);
+  wr16(out + 10, 0);
+
+  size_t off = qend;
+  for (size_t i = 0; i < keep; ++i) {
+    wr16(out + off, 0xC000u | DNS_HEADER_SIZE); /* the question's name */
+    wr16(out + off + 2, q->qtype);
+    wr16(out + off + 4, ODIN_DNS_CLASS_IN);
+    out[off + 6] = (uint8_t)(ttl >> 24);
+    out[off + 7] = (uint8_t)(ttl >> 16);
+    out[off + 8] = (uint8_t)(ttl >> 8);
+    out[off + 9] = (uint8_t)ttl;
+    wr16(out + off + 10, (uint16_t)alen);
+    memcpy(out + off + DNS_ANSWER_FIXED, addrs + i * alen, alen);
+    off += DNS_ANSWER_FIXED + alen;
+  }
+  return off;
+}
+
+/* Closes whichever sockets are open, preserving errno, and returns -1. */
+static int close_both(int udp, int tcp) {
+  const int saved = errno;
+  (void)close(udp);
+  if (tcp >= 0) {
+    (void)close(tcp);
+  }
+  errno = saved;
+  return -1;
+}
+
+int odin_dns_stub_open(uint16_t port, int *udp_fd, int *tcp_fd) {
+  if (udp_fd == NULL || tcp_fd == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  struct sockaddr_in sin;
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family = AF_INET;
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sin.sin_port = htons(port);
+  socklen_t sin_len = (socklen_t)sizeof(sin);
+
+  const int udp = socket(AF_INET, SOCK_DGRAM, 0);
+  if (udp < 0) {
+    return -1;
+  }
+  if (set_nonblocking(udp) != 0 ||
+      bind(udp, (const struct sockaddr *)&sin, sin_len) != 0 ||
+      getsockname(udp, (struct sockaddr *)&sin, &sin_len) != 0) {
+    return close_both(udp, -1);
+  }
+  /* The TCP socket takes the UDP one's port, so port 0 yields one port. */
+  const int tcp = socket(AF_INET, SOCK_STREAM, 0);
+  const int one = 1;
+  if (tcp < 0 || set_nonblocking(tcp) != 0 ||
+      setsockopt(tcp, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+      bind(tcp, (const struct sockaddr *)&sin, sin_len) != 0 ||
+      listen(tcp, 64) != 0) {
+    return close_both(udp, tcp);
+  }
+  *udp_fd = udp;
+  *tcp_fd = tcp;
+  return 0;
+}
+
+/* ---- requests ---------------------------------------------------------- */
+
+static stub_req_t **req_head(stub_req_t *req) {
+  return req->conn != NULL ? &req->conn->reqs : &req->stub->udp_reqs;
+}
+
+static void req_link(stub_req_t *req) {
+  stub_req_t **head = req_head(req);
+  req->prev = NULL;
+  req->next = *head;
+  if (*head != NULL) {
+    (*head)->prev = req;
+  }
+  *head = req;
+  if (req->conn != NULL) {
+    req->conn->pending += 1;
+  } else {
+    req->stub->udp_pending += 1;
+  }
+}
+
+static void req_unlink_free(stub_req_t *req) {
+  if (req->prev != NULL) {
+    req->prev->next = req->next;
+  } else {
+    *req_head(req) = req->next;
+  }
+  if (req->next != NULL) {
+    req->next->prev = req->prev;
+  }
+  if (req->conn != NULL) {
+    req->conn->pending -= 1;
+  } else {
+    req->stub->udp_pending -= 1;
+  }
+  odin_dns_tunnel_request_cancel(req->treq);
+  free(req);
+}
+
+/* ---- TCP connections --------------------------------------------------- */
+
+static void conn_close(stub_conn_t *conn) {
+  odin_dns_stub_t *stub = conn->stub;
+  while (conn->reqs != NULL) {
+    req_unlink_free(conn->reqs);
+  }
+  if (conn->io != NULL) {
+    odin_event_io_stop(conn->io);
+  }
+  (void)close(conn->fd);
+  if (conn->prev != NULL) {
+    conn->prev->next = conn->next;
+  } else {
+    stub->conns = conn->next;
+  }
+  if (conn->next != NULL) {
+    conn->next->prev = conn->prev;
+  }
+  stub->conn_count -= 1;
+  free(conn->out);
+  free(conn);
+}
+
+static int conn_append(stub_conn_t *conn, const uint8_t *msg, size_t len) {
+  const size_t need = conn->out_used + 2 + len;
+  if (need > conn->out_cap) {
+    size_t cap = conn->out_cap != 0 ? conn->out_cap : 1024u;
+    while (cap < need) {
+      cap *= 2;
+    }
+    uint8_t *grown = (uint8_t *)realloc(conn->out, cap);
+    if (grown == NULL) {
+      return -1;
+    }
+    conn->out = grown;
+    conn->out_cap = cap;
+  }
+  wr16(conn->out + conn->out_used, (uint16_t)len);
+  memcpy(conn->out + conn->out_used + 2, msg, len);
+  conn->out_used = need;
+  return 0;
+}
+
+static void on_conn_io(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                       unsigned int events, void *user_data);
+
+/* Watches exactly what the connection can make progress on; with nothing to
+ * read or write (every pending slot used) the watch is dropped. */
+static int conn_set_events(stub_conn_t *conn, unsigned int events) {
+  if (events == conn->io_events) {
+    return 0;
+  }
+  if (events == 0) {
+    odin_event_io_stop(conn->io);
+    conn->io = NULL;
+  } else if (conn->io == NULL) {
+    if (odin_event_io_start(conn->stub->loop, conn->fd, events, on_conn_io,
+                            conn, &conn->io) != 0) {
+      conn->io = NULL;
+      return -1;
+    }
+  } else if (odin_event_io_update(conn->io, events) != 0) {
+    return -1;
+  }
+  conn->io_events = events;
+  return 0;
+}
+
+static void stub_handle(odin_dns_stub_t *stub, stub_conn_t *conn,
+                        const uint8_t *msg, size_t len,
+                        const struct sockaddr_storage *peer,
+                        socklen_t peer_len);
+
+/* Handles every complete message the pending cap admits. Returns -1 on a
+ * framing error. */
+static int conn_parse(stub_conn_t *conn) {
+  size_t off = 0;
+  int rc = 0;
+  while (conn->in_used - off >= 2 &&
+         conn->pending < ODIN_DNS_STUB_TCP_PENDING_MAX) {
+    const size_t mlen = rd16(conn->in + off);
+    if (mlen == 0 || mlen > ODIN_DNS_STUB_TCP_MSG_MAX) {
+      rc = -1;
+      break;
+    }
+    if (conn->in_used - off < 2 + mlen) {
+      break;
+    }
+    stub_handle(conn->stub, conn, conn->in + off + 2, mlen, NULL, 0);
+    off += 2 + mlen;
+  }
+  memmove(conn->in, conn->in + off, conn->in_used - off);
+  conn->in_used -= off;
+  return rc;
+}
+
+/* Returns -1 after closing the connection. */
+static int conn_pump(stub_conn_t *conn) {
+  if (conn_parse(conn) != 0) {
+    conn_close(conn);
+    return -1;
+  }
+  while (conn->out_used > 0) {
+    const ssize_t n = send(conn->fd, conn->out, conn->out_used, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      conn_close(conn);
+      return -1;
+    }
+    memmove(conn->out, conn->out + n, conn->out_used - (size_t)n);
+    conn->out_used -= (size_t)n;
+    conn->last_active_ms = now_ms();
+  }
+  if (conn->read_eof && conn->pending == 0 && conn->out_used == 0) {
+    conn_close(conn);
+    return -1;
+  }
+  unsigned int events = 0;
+  if (!conn->read_eof && conn->pending < ODIN_DNS_STUB_TCP_PENDING_MAX &&
+      conn->in_used < sizeof(conn->in)) {
+    events |= ODIN_EVENT_READ;
+  }
+  if (conn->out_used > 0) {
+    events |= ODIN_EVENT_WRITE;
+  }
+  if (conn_set_events(conn, events) != 0) {
+    conn_close(conn);
+    return -1;
+  }
+  return 0;
+}
+
+static void on_conn_io(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                       unsigned int events, void *user_data) {
+  (void)loop;
+  (void)io;
+  stub_conn_t *conn = (stub_conn_t *)user_data;
+  if ((events & (ODIN_EVENT_READ | ODIN_EVENT_ERROR)) != 0) {
+    while (!conn->read_eof && conn->in_used < sizeof(conn->in)) {
+      const ssize_t n = recv(fd, conn->in + conn->in_used,
+                             sizeof(conn->in) - conn->in_used, 0);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      if (n < 0) {
+        conn_close(conn);
+        return;
+      }
+      if (n == 0) {
+        conn->read_eof = 1;
+        break;
+      }
+      conn->in_used += (size_t)n;
+      conn->last_active_ms = now_ms();
+      if (conn->pending >= ODIN_DNS_STUB_TCP_PENDING_MAX) {
+        break;
+      }
+      if (conn_parse(conn) != 0) {
+        conn_close(conn);
+        return;
+      }
+    }
+  }
+  (void)conn_pump(conn);
+}
+
+static void on_accept(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                      unsigned int events, void *user_data) {
+  (void)io;
+  (void)events;
+  odin_dns_stub_t *stub = (odin_dns_stub_t *)user_data;
+  for (int i = 0; i < STUB_ACCEPTS_PER_EVENT; ++i) {
+    const int cfd = accept(fd, NULL, NULL);
+    if (cfd < 0) {
+      return;
+    }
+    stub_conn_t *conn = NULL;
+    if (stub->conn_count < ODIN_DNS_STUB_TCP_CONN_MAX &&
+        set_nonblocking(cfd) == 0) {
+      conn = (stub_conn_t *)calloc(1, sizeof(*conn));
+    }
+    if (conn == NULL) {
+      (void)close(cfd);
+      continue;
+    }
+    conn->stub = stub;
+    conn->fd = cfd;
+    conn->last_active_ms = now_ms();
+    if (odin_event_io_start(loop, cfd, ODIN_EVENT_READ, on_conn_io, conn,
+                            &conn->io) != 0) {
+      (void)close(cfd);
+      free(conn);
+      continue;
+    }
+    conn->io_events = ODIN_EVENT_READ;
+    conn->next = stub->conns;
+    if (stub->conns != NULL) {
+      stub->conns->prev = conn;
+    }
+    stub->conns = conn;
+    stub->conn_count += 1;
+  }
+}
+
+static void on_idle_sweep(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                          void *user_data) {
+  (void)loop;
+  (void)timer;
+  odin_dns_stub_t *stub = (odin_dns_stub_t *)user_data;
+  const uint64_t now = now_ms();
+  stub_conn_t *conn = stub->conns;
+  while (conn != NULL) {
+    stub_conn_t *next = conn->next;
+    if (conn->pending == 0 && conn->out_used == 0 &&
+        now - conn->last_active_ms >= ODIN_DNS_STUB_TCP_IDLE_MS) {
+      conn_close(conn);
+    }
+    conn = next;
+  }
+}
+
+/* ---- answering --------------------------------------------------------- */
+
+static void stub_reply(odin_dns_stub_t *stub, stub_conn_t *conn,
+                       const struct sockaddr_storage *peer, socklen_t peer_len,
+                       const uint8_t *query, const odin_dns_stub_question_t *q,
+                       int rcode, uint32_t ttl, const uint8_t *addrs,
+                       size_t count) {
+  uint8_t resp[STUB_RESPONSE_MAX];
+  const size_t cap = conn != NULL ? sizeof(resp) : ODIN_DNS_STUB_UDP_MAX;
+  const size_t len = odin_dns_stub_build_response(query, q, rcode, ttl, addrs,
+                                                  count, resp, cap);
+  if (conn != NULL) {
+    (void)conn_append(conn, resp, len);
+    return;
+  }
+  /* UDP is best-effort: a reply the socket cannot take now is dropped and
+   * the application retries. */
+  (void)sendto(stub->udp_fd, resp, len, 0, (const struct sockaddr *)peer,
+               peer_len);
+}
+
+static void stub_on_answer(odin_dns_tunnel_request_t *treq, uint8_t rcode,
+                           uint32_t ttl, const uint8_t *addrs, size_t count,
+                           void *user_data) {
+  (void)treq;
+  stub_req_t *req = (stub_req_t *)user_data;
+  req->treq = NULL; /* the tunnel frees it when this returns */
+  stub_conn_t *conn = req->conn;
+  stub_reply(req->stub, conn, &req->peer, req->peer_len, req->query, &req->q,
+             rcode == ODIN_PROTO_DNS_RCODE_OK ? ODIN_DNS_RCODE_NOERROR
+                                              : ODIN_DNS_RCODE_SERVFAIL,
+             ttl, addrs, count);
+  req_unlink_free(req);
+  if (conn != NULL) {
+    (void)conn_pump(conn);
+  }
+}
+
+static void stub_handle(odin_dns_stub_t *stub, stub_conn_t *conn,
+                        const uint8_t *msg, size_t len,
+                        const struct sockaddr_storage *peer,
+                        socklen_t peer_len) {
+  odin_dns_stub_question_t q;
+  if (odin_dns_stub_parse_query(msg, len, &q) != 0) {
+    return;
+  }
+  if (q.rcode != ODIN_DNS_RCODE_NOERROR ||
+      (q.qtype != ODIN_DNS_TYPE_A && q.qtype != ODIN_DNS_TYPE_AAAA)) {
+    stub_reply(stub, conn, peer, peer_len, msg, &q, q.rcode, 0, NULL, 0);
+    return;
+  }
+  stub_req_t *req = NULL;
+  if (conn != NULL || stub->udp_pending < ODIN_DNS_STUB_UDP_PENDING_MAX) {
+    req = (stub_req_t *)calloc(1, sizeof(*req));
+  }
+  if (req == NULL) {
+    stub_reply(stub, conn, peer, peer_len, msg, &q, ODIN_DNS_RCODE_SERVFAIL,
+               0, NULL, 0);
+    return;
+  }
+  req->stub = stub;
+  req->conn = conn;
+  req->q = q;
+  memcpy(req->query, msg, q.question_end);
+  if (peer != NULL) {
+    memcpy(&req->peer, peer, (size_t)peer_len);
+    req->peer_len = peer_len;
+  }
+  const int af = q.qtype == ODIN_DNS_TYPE_A ? AF_INET : AF_INET6;
+  if (odin_dns_tunnel_resolve(stub->tunnel, q.name, q.name_len, af,
+                              stub_on_answer, req, &req->treq) != 0) {
+    free(req);
+    stub_reply(stub, conn, peer, peer_len, msg, &q, ODIN_DNS_RCODE_SERVFAIL,
+               0, NULL, 0);
+    return;
+  }
+  req_link(req);
+}
+
+static void on_udp(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                   unsigned int events, void *user_data) {
+  (void)loop;
+  (void)io;
+  (void)events;
+  odin_dns_stub_t *stub = (odin_dns_stub_t *)user_data;
+  uint8_t buf[STUB_UDP_RECV_MAX];
+  for (int i = 0; i < STUB_UDP_READS_PER_EVENT; ++i) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = (socklen_t)sizeof(peer);
+    const ssize_t n = recvfrom(fd, buf, sizeof(buf), 0,
+                               (struct sockaddr *)&peer, &peer_len);
+    if (n < 0) {
+      return;
+    }
+    stub_handle(stub, NULL, buf, (size_t)n, &peer, peer_len);
+  }
+}
+
+int odin_dns_stub_create(odin_event_loop_t *loop,
+                         odin_dns_tunnel_client_t *tunnel, int udp_fd,
+                         int tcp_fd, odin_dns_stub_t **out) {
+  if (loop == NULL || tunnel == NULL || out == NULL ||
+      (udp_fd < 0 && tcp_fd < 0)) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_dns_stub_t *stub = (odin_dns_stub_t *)calloc(1, sizeof(*stub));
+  if (stub == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  stub->loop = loop;
+  stub->tunnel = tunnel;
+  stub->udp_fd = udp_fd;
+  stub->tcp_fd = tcp_fd;
+  if ((udp_fd >= 0 && odin_event_io_start(loop, udp_fd, ODIN_EVENT_READ,
+                                          on_udp, stub, &stub->udp_io) != 0) ||
+      (tcp_fd >= 0 &&
+       (odin_event_io_start(loop, tcp_fd, ODIN_EVENT_READ, on_accept, stub,
+                            &stub->tcp_io) != 0 ||
+        odin_event_timer_start(loop, STUB_IDLE_SWEEP_US, STUB_IDLE_SWEEP_US,
+                               on_idle_sweep, stub,
+                               &stub->idle_timer) != 0))) {
+    const int saved = errno;
+    odin_dns_stub_destroy(stub);
+    errno = saved;
+    return -1;
+  }
+  *out = stub;
+  return 0;
+}
+
+void odin_dns_stub_destroy(odin_dns_stub_t *stub) {
+  if (stub == NULL) {
+    return;
+  }
+  while (stub->udp_reqs != NULL) {
+    req_unlink_free(stub->udp_reqs);
+  }
+  while (stub->conns != NULL) {
+    conn_close(stub->conns);
+  }
+  if (stub->udp_io != NULL) {
+    odin_event_io_stop(stub->udp_io);
+  }
+  if (stub->tcp_io != NULL) {
+    odin_event_io_stop(stub->tcp_io);
+  }
+  if (stub->idle_timer != NULL) {
+    odin_event_timer_stop(stub->idle_timer);
+  }
+  free(stub);
+}
@@ -0,0 +1,107 @@
+/* odin/dns_stub.h
+ *
+ * Local stub DNS listener backed by the RFC-045 tunnel.
+ *
+ * odin_dns_stub_t answers RFC 1035 queries from local applications on a UDP
+ * and a TCP socket (RFC 7766 two-byte length framing, pipelined queries
+ * answered in completion order). Each A or AAAA question becomes one
+ * odin_dns_tunnel_resolve, so the name never reaches a local resolver and
+ * repeated names come from the tunnel client's cache. The stub is
+ * deliberately narrow:
+ *
+ *   - One question per message, else FORMERR. A class other than IN, the
+ *     root name, or a label holding a '.' or NUL is REFUSED.
+ *   - A and AAAA resolve through the tunnel; every other type gets an empty
+ *     NOERROR answer, so applications fall back to A/AAAA.
+ *   - A tunnel failure is SERVFAIL; a name with no data is an empty NOERROR.
+ *   - Opcodes other than QUERY are NOTIMP. EDNS is not echoed, so UDP
+ *     answers stay within 512 bytes and set TC when addresses were left out.
+ *
+ * odin_dns_stub_open binds both sockets to 127.0.0.1:port (port 0 picks one
+ * port for both); the stub borrows the fds and the caller closes them after
+ * odin_dns_stub_destroy. Owner-thread APIs; int-returning functions return
+ * 0, or -1 with errno set.
+ */
+
+#ifndef ODIN_DNS_STUB_H_
+#define ODIN_DNS_STUB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "odin/dns_tunnel.h"
+#include "odin/event_loop.h"
+#include "odin/protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_DNS_STUB_UDP_MAX 512u
+#define ODIN_DNS_STUB_UDP_PENDING_MAX 256u
+#define ODIN_DNS_STUB_TCP_CONN_MAX 64u
+#define ODIN_DNS_STUB_TCP_PENDING_MAX 32u
+#define ODIN_DNS_STUB_TCP_MSG_MAX 4096u
+#define ODIN_DNS_STUB_TCP_IDLE_MS 10000u
+
+#define ODIN_DNS_RCODE_NOERROR 0
+#define ODIN_DNS_RCODE_FORMERR 1
+#define ODIN_DNS_RCODE_SERVFAIL 2
+#define ODIN_DNS_RCODE_NOTIMP 4
+#define ODIN_DNS_RCODE_REFUSED 5
+
+#define ODIN_DNS_TYPE_A 1
+#define ODIN_DNS_TYPE_AAAA 28
+#define ODIN_DNS_CLASS_IN 1
+
+/* Header plus the longest question the stub accepts: a name of up to
+ * ODIN_PROTO_HOST_MAX dotted bytes (two more on the wire), type, class. */
+#define ODIN_DNS_STUB_QUESTION_MAX (12u + ODIN_PROTO_HOST_MAX + 2u + 4u)
+
+typedef struct odin_dns_stub_t odin_dns_stub_t;
+
+/* A parsed query. rcode is NOERROR when the question is usable; otherwise it
+ * is the rcode to answer with, and question_end is 12 when even the question
+ * could not be read. name is the dotted form without the trailing dot. */
+typedef struct odin_dns_stub_question_t {
+  uint16_t id;
+  uint16_t flags;
+  uint16_t qtype;
+  uint16_t qclass;
+  int rcode;
+  size_t question_end;
+  size_t name_len;
+  char name[ODIN_PROTO_HOST_MAX + 1];
+} odin_dns_stub_question_t;
+
+/* Returns 0 with *out filled, or -1 when msg is not a query worth answering
+ * (shorter than a header, or a response). */
+int odin_dns_stub_parse_query(const uint8_t *msg, size_t len,
+                              odin_dns_stub_question_t *out);
+
+/* Writes the response to query (its first q->question_end bytes) into out
+ * and returns its length. count packed addresses of q->qtype's size become
+ * answers with ttl; as many as fit in cap are kept, and TC is set when any
+ * were left out. cap must hold at least q->question_end bytes. */
+size_t odin_dns_stub_build_response(const uint8_t *query,
+                                    const odin_dns_stub_question_t *q,
+                                    int rcode, uint32_t ttl,
+                                    const uint8_t *addrs, size_t count,
+                                    uint8_t *out, size_t cap);
+
+/* Binds a nonblocking UDP and TCP socket to 127.0.0.1:port and listens on
+ * the TCP one. On -1 neither fd is open. */
+int odin_dns_stub_open(uint16_t port, int *udp_fd, int *tcp_fd);
+
+/* udp_fd or tcp_fd may be -1 to serve only the other transport. */
+int odin_dns_stub_create(odin_event_loop_t *loop,
+                         odin_dns_tunnel_client_t *tunnel, int udp_fd,
+                         int tcp_fd, odin_dns_stub_t **out);
+/* Cancels every pending lookup and closes every accepted connection. */
+void odin_dns_stub_destroy(odin_dns_stub_t *stub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_DNS_STUB_H_ */
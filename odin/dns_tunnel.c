@@ -0,0 +1,1063 @@
+/* odin/dns_tunnel.c -- RFC-045 DNS over odin: server responder and client.
+ *
+ * The responder parses DNS_QUERY frames from the stream, runs each through
+ * odin_dns_resolve_start, and appends a DNS_ANSWER to one output buffer as
+ * each lookup lands. The buffer reserves room for an answer to every query
+ * in flight, so an answer never waits on buffer space; reading stops
+ * instead. The client keeps one slot per (name, family): a slot is either a
+ * cached answer or a query on the stream, and the slot index is the frame
+ * id.
+ */
+
+#include "odin/dns_tunnel.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "odin/dns_resolver.h"
+#include "odin/event_loop.h"
+#include "odin/protocol.h"
+#include "odin/transport.h"
+
+#if defined(ODIN_DNS_TUNNEL_TESTING)
+#include "odin/testing/dns_tunnel_internal_test.h"
+#endif
+
+#define SERVER_IN_SIZE 4096u
+#define SERVER_OUT_SIZE                                                       \
+  (ODIN_DNS_TUNNEL_INFLIGHT_MAX * ODIN_PROTO_DNS_ANSWER_MAX)
+#define SERVER_READS_PER_EVENT 16
+#define CLIENT_IN_SIZE 4096u
+#define CLIENT_OUT_SIZE 16384u
+#define ADDR_BYTES_MAX (ODIN_PROTO_DNS_ADDR_MAX * 16u)
+
+#if defined(ODIN_DNS_TUNNEL_TESTING)
+static uint64_t g_test_now_ms;
+#endif
+
+static uint64_t now_ms(void) {
+#if defined(ODIN_DNS_TUNNEL_TESTING)
+  if (g_test_now_ms != 0) {
+    return g_test_now_ms;
+  }
+#endif
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static int proto_family_to_af(uint8_t family) {
+  return family == ODIN_PROTO_DNS_FAMILY_V4 ? AF_INET : AF_INET6;
+}
+
+/* ---- server responder -------------------------------------------------- */
+
+typedef struct server_slot_t {
+  odin_dns_tunnel_server_t *srv;
+  odin_dns_query_t *query; /* NULL: free */
+  uint16_t id;
+  uint8_t family;
+} server_slot_t;
+
+struct odin_dns_tunnel_server_t {
+  odin_dns_resolver_t *resolver;
+  odin_transport_t *t;
+  odin_dns_tunnel_filter_cb filter;
+  void *filter_ud;
+  odin_dns_tunnel_server_done_cb on_done;
+  void *user_data;
+  int read_eof;
+  int done_fired;
+  int active_depth;
+  int destroy_pending;
+  size_t inflight;
+  size_t in_used;
+  size_t out_used;
+  server_slot_t slots[ODIN_DNS_TUNNEL_INFLIGHT_MAX];
+  uint8_t in[SERVER_IN_SIZE];
+  uint8_t out[SERVER_OUT_SIZE];
+};
+
+/* A query is admitted only while the output buffer can still hold an answer
+ * for it and for every query already in flight. */
+static int server_can_admit(const odin_dns_tunnel_server_t *srv) {
+  return srv->inflight < ODIN_DNS_TUNNEL_INFLIGHT_MAX &&
+         srv->out_used + (srv->inflight + 1) * ODIN_PROTO_DNS_ANSWER_MAX <=
+             SERVER_OUT_SIZE;
+}
+
+static void server_append_answer(odin_dns_tunnel_server_t *srv, uint16_t id,
+                                 uint8_t family, uint8_t rcode, uint32_t ttl,
+                                 const uint8_t *addrs, size_t count) {
+  size_t len = 0;
+  const odin_proto_status_t st = odin_proto_encode_dns_answer(
+      id, family, rcode, ttl, addrs, count, srv->out + srv->out_used,
+      SERVER_OUT_SIZE - srv->out_used, &len);
+  assert(st == ODIN_PROTO_OK);
+  (void)st;
+  srv->out_used += len;
+}
+
+static void server_cancel_queries(odin_dns_tunnel_server_t *srv) {
+  for (size_t i = 0; i < ODIN_DNS_TUNNEL_INFLIGHT_MAX; ++i) {
+    if (srv->slots[i].query != NULL) {
+      odin_dns_query_destroy(srv->slots[i].query);
+      srv->slots[i].query = NULL;
+    }
+  }
+  srv->inflight = 0;
+}
+
+static void server_finish(odin_dns_tunnel_server_t *srv, int err) {
+  if (srv->done_fired) {
+    return;
+  }
+  srv->done_fired = 1;
+  server_cancel_queries(srv);
+  (void)odin_transport_set_interest(srv->t, 0);
+  srv->on_done(srv, err, srv->user_data);
+}
+
+static void server_enter(odin_dns_tunnel_server_t *srv) {
+  srv->active_depth += 1;
+}
+
+static void server_leave(odin_dns_tunnel_server_t *srv) {
+  srv->active_depth -= 1;
+  if (srv->active_depth == 0 && srv->destroy_pending) {
+    free(srv);
+  }
+}
+
+static void server_on_answer(odin_dns_query_t *query, odin_dns_status_t status,
+                             int err, const odin_dns_addr_t *addrs,
+                             size_t addr_count, void *user_data);
+static void server_pump(odin_dns_tunnel_server_t *srv);
+
+static void server_start_query(odin_dns_tunnel_server_t *srv,
+                               const odin_proto_dns_query_view_t *view) {
+  server_slot_t *slot = NULL;
+  for (size_t i = 0; i < ODIN_DNS_TUNNEL_INFLIGHT_MAX; ++i) {
+    if (srv->slots[i].query == NULL) {
+      slot = &srv->slots[i];
+      break;
+    }
+  }
+  assert(slot != NULL);
+  slot->srv = srv;
+  slot->id = view->id;
+  slot->family = view->family;
+  if (odin_dns_resolve_start(srv->resolver,
+                             (const char *)srv->in + view->name_off,
+                             view->name_len, 0,
+                             proto_family_to_af(view->family),
+                             server_on_answer, slot, &slot->query) != 0) {
+    slot->query = NULL;
+    server_append_answer(srv, view->id, view->family,
+                         ODIN_PROTO_DNS_RCODE_FAIL, 0, NULL, 0);
+    return;
+  }
+  srv->inflight += 1;
+}
+
+/* Starts every complete query in the input buffer that can be admitted.
+ * Returns -1 on a malformed frame. */
+static int server_parse(odin_dns_tunnel_server_t *srv) {
+  size_t off = 0;
+  int rc = 0;
+  while (off < srv->in_used && server_can_admit(srv)) {
+    odin_proto_dns_query_view_t view;
+    size_t consumed = 0;
+    const odin_proto_status_t st = odin_proto_decode_dns_query(
+        srv->in + off, srv->in_used - off, &consumed, &view);
+    if (st == ODIN_PROTO_NEED_MORE) {
+      break;
+    }
+    if (st != ODIN_PROTO_OK) {
+      rc = -1;
+      break;
+    }
+    view.name_off += off;
+    server_start_query(srv, &view);
+    off += consumed;
+  }
+  memmove(srv->in, srv->in + off, srv->in_used - off);
+  srv->in_used -= off;
+  return rc;
+}
+
+/* Writes as much pending output as the transport takes. Returns -1 after
+ * finishing the responder on a write error. */
+static int server_flush(odin_dns_tunnel_server_t *srv) {
+  while (srv->out_used > 0) {
+    size_t n = 0;
+    const odin_transport_io_t io =
+        odin_transport_write(srv->t, srv->out, srv->out_used, &n);
+    if (io == ODIN_TRANSPORT_AGAIN) {
+      return 0;
+    }
+    if (io != ODIN_TRANSPORT_OK) {
+      server_finish(srv, io == ODIN_TRANSPORT_IO_ERROR ? errno : EPIPE);
+      return -1;
+    }
+    if (n == 0) {
+      return 0;
+    }
+    memmove(srv->out, srv->out + n, srv->out_used - n);
+    srv->out_used -= n;
+  }
+  return 0;
+}
+
+static unsigned int server_wants(const odin_dns_tunnel_server_t *srv) {
+  unsigned int mask = 0;
+  if (!srv->read_eof && srv->in_used < SERVER_IN_SIZE &&
+      server_can_admit(srv)) {
+    mask |= ODIN_TRANSPORT_READ;
+  }
+  if (srv->out_used > 0) {
+    mask |= ODIN_TRANSPORT_WRITE;
+  }
+  return mask;
+}
+
+static void server_read(odin_dns_tunnel_server_t *srv) {
+  for (int i = 0; i < SERVER_READS_PER_EVENT; ++i) {
+    if (srv->done_fired || srv->read_eof || srv->in_used >= SERVER_IN_SIZE ||
+        !server_can_admit(srv)) {
+      return;
+    }
+    size_t n = 0;
+    const odin_transport_io_t io =
+        odin_transport_read(srv->t, srv->in + srv->in_used,
+                            SERVER_IN_SIZE - srv->in_used, &n);
+    switch (io) {
+    case ODIN_TRANSPORT_OK:
+      srv->in_used += n;
+      if (server_parse(srv) != 0) {
+        server_finish(srv, EPROTO);
+        return;
+      }
+      break;
+    case ODIN_TRANSPORT_AGAIN:
+      return;
+    case ODIN_TRANSPORT_EOF:
+      srv->read_eof = 1;
+      return;
+    case ODIN_TRANSPORT_IO_ERROR: {
+      const int saved = errno;
+      server_finish(srv, saved);
+      return;
+    }
+    }
+  }
+}
+
+/* Flushes, starts whatever the freed room admits, and re-arms interest. The
+ * client's half-close ends the responder once every answer is written. */
+static void server_pump(odin_dns_tunnel_server_t *srv) {
+  if (srv->done_fired || server_flush(srv) != 0) {
+    return;
+  }
+  if (server_parse(srv) != 0) {
+    server_finish(srv, EPROTO);
+    return;
+  }
+  if (server_flush(srv) != 0) {
+    return;
+  }
+  if (srv->read_eof && srv->inflight == 0 && srv->out_used == 0) {
+    /* Whatever is left is a frame the client never finished. */
+    server_finish(srv, srv->in_used == 0 ? 0 : EPROTO);
+    return;
+  }
+  if (odin_transport_set_interest(srv->t, server_wants(srv)) != 0) {
+    const int saved = errno;
+    server_finish(srv, saved);
+  }
+}
+
+static void server_on_answer(odin_dns_query_t *query, odin_dns_status_t status,
+                             int err, const odin_dns_addr_t *addrs,
+                             size_t addr_count, void *user_data) {
+  server_slot_t *slot = (server_slot_t *)user_data;
+  odin_dns_tunnel_server_t *srv = slot->srv;
+  server_enter(srv);
+  slot->query = NULL;
+  odin_dns_query_destroy(query);
+  srv->inflight -= 1;
+
+  uint8_t packed[ADDR_BYTES_MAX];
+  size_t count = 0;
+  uint32_t ttl = UINT32_MAX;
+  const int af = proto_family_to_af(slot->family);
+  for (size_t i = 0; status == ODIN_DNS_OK && i < addr_count &&
+                     count < ODIN_PROTO_DNS_ADDR_MAX;
+       ++i) {
+    const odin_dns_addr_t *a = &addrs[i];
+    if (a->addr.ss_family != af) {
+      continue;
+    }
+    if (srv->filter != NULL &&
+        srv->filter((const struct sockaddr *)&a->addr, a->addrlen,
+                    srv->filter_ud) != 0) {
+      continue;
+    }
+    if (af == AF_INET) {
+      const struct sockaddr_in *sin = (const struct sockaddr_in *)&a->addr;
+      memcpy(packed + count * 4, &sin->sin_addr, 4);
+    } else {
+      const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)&a->addr;
+      memcpy(packed + count * 16, &sin6->sin6_addr, 16);
+    }
+    if (a->ttl < 0) {
+      ttl = 0;
+    } else if ((uint32_t)a->ttl < ttl) {
+      ttl = (uint32_t)a->ttl;
+    }
+    count += 1;
+  }
+  if (count == 0) {
+    ttl = 0;
+  }
+  /* A name with no data is a clean empty answer, not a failure. */
+  const uint8_t rcode = (status == ODIN_DNS_OK || err == EHOSTUNREACH)
+                            ? ODIN_PROTO_DNS_RCODE_OK
+                            : ODIN_PROTO_DNS_RCODE_FAIL;
+  server_append_answer(srv, slot->id, slot->family, rcode, ttl, packed, count);
+  server_pump(srv);
+  server_leave(srv);
+}
+
+int odin_dns_tunnel_server_create(odin_dns_resolver_t *resolver,
+                                  odin_transport_t *t, const uint8_t *prefix,
+                                  size_t prefix_len,
+                                  odin_dns_tunnel_filter_cb filter,
+                                  void *filter_ud,
+                                  odin_dns_tunnel_server_done_cb on_done,
+                                  void *user_data,
+                                  odin_dns_tunnel_server_t **out) {
+  if (resolver == NULL || t == NULL || on_done == NULL || out == NULL ||
+      (prefix == NULL && prefix_len != 0) || prefix_len > SERVER_IN_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_dns_tunnel_server_t *srv =
+      (odin_dns_tunnel_server_t *)calloc(1, sizeof(*srv));
+  if (srv == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  srv->resolver = resolver;
+  srv->t = t;
+  srv->filter = filter;
+  srv->filter_ud = filter_ud;
+  srv->on_done = on_done;
+  srv->user_data = user_data;
+  if (prefix_len > 0) {
+    memcpy(srv->in, prefix, prefix_len);
+    srv->in_used = prefix_len;
+  }
+  if (server_parse(srv) != 0) {
+    server_cancel_queries(srv);
+    free(srv);
+    errno = EPROTO;
+    return -1;
+  }
+  if (odin_transport_set_interest(t, server_wants(srv)) != 0) {
+    const int saved = errno;
+    server_cancel_queries(srv);
+    free(srv);
+    errno = saved;
+    return -1;
+  }
+  *out = srv;
+  return 0;
+}
+
+void odin_dns_tunnel_server_ready(odin_transport_t *t, unsigned int events,
+                                  void *user_data) {
+  odin_dns_tunnel_server_t *srv = (odin_dns_tunnel_server_t *)user_data;
+  server_enter(srv);
+  if (srv->done_fired) {
+    server_leave(srv);
+    return;
+  }
+  if ((events & ODIN_TRANSPORT_ERROR) != 0) {
+    const int err = odin_transport_error(t);
+    if (err != 0) {
+      server_finish(srv, err);
+      server_leave(srv);
+      return;
+    }
+  }
+  if ((events & ODIN_TRANSPORT_READ) != 0) {
+    server_read(srv);
+  }
+  server_pump(srv);
+  server_leave(srv);
+}
+
+void odin_dns_tunnel_server_destroy(odin_dns_tunnel_server_t *srv) {
+  if (srv == NULL) {
+    return;
+  }
+  srv->done_fired = 1;
+  server_cancel_queries(srv);
+  if (srv->active_depth != 0) {
+    srv->destroy_pending = 1;
+    return;
+  }
+  free(srv);
+}
+
+/* ---- client ------------------------------------------------------------ */
+
+enum {
+  CLIENT_SLOT_IDLE = 0, /* free, or holding a cached answer */
+  CLIENT_SLOT_QUEUED,   /* waiting for room in the stream's output  */
+  CLIENT_SLOT_SENT,     /* written; waiting for its DNS_ANSWER       */
+};
+
+typedef struct client_slot_t {
+  int state;
+  uint8_t family;   /* ODIN_PROTO_DNS_FAMILY_V4 or _V6 */
+  uint8_t name_len; /* 0: never used */
+  uint8_t rcode;
+  uint8_t count;
+  uint32_t ttl;
+  uint64_t expires_ms; /* answer is live before this; 0: none */
+  uint64_t last_used;
+  odin_dns_tunnel_request_t *waiters;
+  char name[ODIN_PROTO_HOST_MAX];
+  uint8_t addrs[ADDR_BYTES_MAX];
+} client_slot_t;
+
+struct odin_dns_tunnel_request_t {
+  odin_dns_tunnel_client_t *client;
+  odin_dns_tunnel_request_t *prev;
+  odin_dns_tunnel_request_t *next;
+  client_slot_t *slot; /* waiting on slot; NULL: on the ready list */
+  odin_dns_tunnel_cb cb;
+  void *user_data;
+  uint8_t rcode;
+  uint32_t ttl;
+  size_t count;
+  uint8_t addrs[ADDR_BYTES_MAX];
+};
+
+struct odin_dns_tunnel_client_t {
+  odin_event_loop_t *loop;
+  odin_dns_tunnel_open_cb open_stream;
+  void *open_user_data;
+  uint32_t timeout_ms;
+  int fd; /* our end of the DNS stream, or -1 */
+  odin_event_io_t *io;
+  unsigned int io_events;
+  odin_event_timer_t *progress_timer; /* armed while queries are SENT */
+  odin_event_timer_t *deliver_timer;  /* armed while ready is non-empty */
+  size_t queued;
+  size_t sent;
+  size_t in_used;
+  size_t out_used;
+  uint64_t use_clock;
+  int active_depth;
+  int destroy_pending;
+  odin_dns_tunnel_request_t *ready;
+  odin_dns_tunnel_request_t *ready_tail;
+  odin_dns_tunnel_client_stats_t stats;
+  size_t slot_count;
+  client_slot_t *slots;
+  uint8_t in[CLIENT_IN_SIZE];
+  uint8_t out[CLIENT_OUT_SIZE];
+};
+
+static int set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags == -1) {
+    return -1;
+  }
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void request_unlink(odin_dns_tunnel_request_t *req) {
+  odin_dns_tunnel_client_t *client = req->client;
+  odin_dns_tunnel_request_t **head =
+      req->slot != NULL ? &req->slot->waiters : &client->ready;
+  if (req->prev != NULL) {
+    req->prev->next = req->next;
+  } else {
+    *head = req->next;
+  }
+  if (req->next != NULL) {
+    req->next->prev = req->prev;
+  } else if (req->slot == NULL) {
+    client->ready_tail = req->prev;
+  }
+  req->prev = NULL;
+  req->next = NULL;
+}
+
+static void request_push_waiter(client_slot_t *slot,
+                                odin_dns_tunnel_request_t *req) {
+  req->slot = slot;
+  req->prev = NULL;
+  req->next = slot->waiters;
+  if (slot->waiters != NULL) {
+    slot->waiters->prev = req;
+  }
+  slot->waiters = req;
+}
+
+/* Copies slot's answer into req and appends req to the ready list. */
+static void request_make_ready(odin_dns_tunnel_client_t *client,
+                               odin_dns_tunnel_request_t *req,
+                               const client_slot_t *slot) {
+  req->rcode = slot->rcode;
+  req->ttl = slot->ttl;
+  req->count = slot->count;
+  memcpy(req->addrs, slot->addrs,
+         slot->count * odin_proto_dns_addr_len(slot->family));
+  req->slot = NULL;
+  req->next = NULL;
+  req->prev = client->ready_tail;
+  if (client->ready_tail != NULL) {
+    client->ready_tail->next = req;
+  } else {
+    client->ready = req;
+  }
+  client->ready_tail = req;
+  if (req->rcode != ODIN_PROTO_DNS_RCODE_OK) {
+    client->stats.failures += 1;
+  }
+}
+
+static void client_enter(odin_dns_tunnel_client_t *client) {
+  client->active_depth += 1;
+}
+
+static void client_free(odin_dns_tunnel_client_t *client);
+
+static void client_leave(odin_dns_tunnel_client_t *client) {
+  client->active_depth -= 1;
+  if (client->active_depth == 0 && client->destroy_pending) {
+    client_free(client);
+  }
+}
+
+static void client_drain_ready(odin_dns_tunnel_client_t *client) {
+  while (client->ready != NULL && !client->destroy_pending) {
+    odin_dns_tunnel_request_t *req = client->ready;
+    request_unlink(req);
+    req->cb(req, req->rcode, req->ttl, req->addrs, req->count,
+            req->user_data);
+    free(req);
+  }
+}
+
+/* Hands the slot's answer to every waiter and drains the ready list. */
+static void client_complete_slot(odin_dns_tunnel_client_t *client,
+                                 client_slot_t *slot) {
+  slot->state = CLIENT_SLOT_IDLE;
+  while (slot->waiters != NULL) {
+    odin_dns_tunnel_request_t *req = slot->waiters;
+    request_unlink(req);
+    request_make_ready(client, req, slot);
+  }
+}
+
+static void client_stop_progress_timer(odin_dns_tunnel_client_t *client) {
+  if (client->progress_timer != NULL) {
+    odin_event_timer_stop(client->progress_timer);
+    client->progress_timer = NULL;
+  }
+}
+
+/* Drops the DNS stream and fails every query queued or sent on it. */
+static void client_drop_stream(odin_dns_tunnel_client_t *client) {
+  if (client->io != NULL) {
+    odin_event_io_stop(client->io);
+    client->io = NULL;
+  }
+  if (client->fd >= 0) {
+    (void)close(client->fd);
+    client->fd = -1;
+  }
+  client_stop_progress_timer(client);
+  client->io_events = 0;
+  client->in_used = 0;
+  client->out_used = 0;
+  client->queued = 0;
+  client->sent = 0;
+  for (size_t i = 0; i < client->slot_count; ++i) {
+    client_slot_t *slot = &client->slots[i];
+    if (slot->state == CLIENT_SLOT_IDLE) {
+      continue;
+    }
+    slot->rcode = ODIN_PROTO_DNS_RCODE_FAIL;
+    slot->ttl = 0;
+    slot->count = 0;
+    slot->expires_ms = 0;
+    client_complete_slot(client, slot);
+  }
+}
+
+static void on_progress_timeout(odin_event_loop_t *loop,
+                                odin_event_timer_t *timer, void *user_data);
+
+/* Restarts the progress deadline while any query is awaiting its answer. */
+static void client_rearm_progress(odin_dns_tunnel_client_t *client) {
+  if (client->sent == 0) {
+    client_stop_progress_timer(client);
+    return;
+  }
+  const uint64_t delay_us = (uint64_t)client->timeout_ms * 1000u;
+  if (client->progress_timer != NULL) {
+    (void)odin_event_timer_reset(client->progress_timer, delay_us, 0);
+    return;
+  }
+  if (odin_event_timer_start(client->loop, delay_us, 0, on_progress_timeout,
+                             client, &client->progress_timer) != 0) {
+    client->progress_timer = NULL;
+  }
+}
+
+/* Encodes queued queries into the output buffer, oldest slot first. */
+static void client_fill_out(odin_dns_tunnel_client_t *client) {
+  const int had_sent = client->sent > 0;
+  for (size_t i = 0; i < client->slot_count && client->queued > 0; ++i) {
+    client_slot_t *slot = &client->slots[i];
+    if (slot->state != CLIENT_SLOT_QUEUED) {
+      continue;
+    }
+    size_t len = 0;
+    if (odin_proto_encode_dns_query(
+            (uint16_t)i, slot->family, slot->name, slot->name_len,
+            client->out + client->out_used,
+            CLIENT_OUT_SIZE - client->out_used, &len) != ODIN_PROTO_OK) {
+      break;
+    }
+    client->out_used += len;
+    slot->state = CLIENT_SLOT_SENT;
+    client->queued -= 1;
+    client->sent += 1;
+    client->stats.queries += 1;
+  }
+  if (!had_sent && client->sent > 0) {
+    client_rearm_progress(client);
+  }
+}
+
+static int client_update_io(odin_dns_tunnel_client_t *client) {
+  unsigned int events = ODIN_EVENT_READ;
+  if (client->out_used > 0 || client->queued > 0) {
+    events |= ODIN_EVENT_WRITE;
+  }
+  if (events == client->io_events) {
+    return 0;
+  }
+  if (odin_event_io_update(client->io, events) != 0) {
+    return -1;
+  }
+  client->io_events = events;
+  return 0;
+}
+
+/* Returns -1 after dropping the stream on a write error. */
+static int client_flush(odin_dns_tunnel_client_t *client) {
+  client_fill_out(client);
+  while (client->out_used > 0) {
+    const ssize_t n =
+        send(client->fd, client->out, client->out_used, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      client_drop_stream(client);
+      return -1;
+    }
+    memmove(client->out, client->out + n, client->out_used - (size_t)n);
+    client->out_used -= (size_t)n;
+    client_fill_out(client);
+  }
+  if (client_update_io(client) != 0) {
+    client_drop_stream(client);
+    return -1;
+  }
+  return 0;
+}
+
+static void client_apply_answer(odin_dns_tunnel_client_t *client,
+                                const uint8_t *frame,
+                                const odin_proto_dns_answer_view_t *view) {
+  if (view->id >= client->slot_count) {
+    return;
+  }
+  client_slot_t *slot = &client->slots[view->id];
+  if (slot->state != CLIENT_SLOT_SENT || slot->family != view->family) {
+    return;
+  }
+  client->sent -= 1;
+  const uint32_t ttl = view->ttl > (uint32_t)ODIN_DNS_CACHE_MAX_TTL_S
+                           ? (uint32_t)ODIN_DNS_CACHE_MAX_TTL_S
+                           : view->ttl;
+  slot->rcode = view->rcode;
+  slot->ttl = ttl;
+  slot->count = (uint8_t)view->count;
+  memcpy(slot->addrs, frame + view->addrs_off,
+         view->count * odin_proto_dns_addr_len(view->family));
+  slot->expires_ms = (view->rcode == ODIN_PROTO_DNS_RCODE_OK && ttl > 0)
+                         ? now_ms() + (uint64_t)ttl * 1000u
+                         : 0;
+  client_complete_slot(client, slot);
+}
+
+/* Returns -1 after dropping the stream on EOF, an error, or a bad frame. */
+static int client_read(odin_dns_tunnel_client_t *client) {
+  for (;;) {
+    const ssize_t n = recv(client->fd, client->in + client->in_used,
+                           CLIENT_IN_SIZE - client->in_used, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return 0;
+    }
+    if (n <= 0) {
+      client_drop_stream(client);
+      return -1;
+    }
+    client->in_used += (size_t)n;
+    size_t off = 0;
+    while (off < client->in_used) {
+      odin_proto_dns_answer_view_t view;
+      size_t consumed = 0;
+      const odin_proto_status_t st = odin_proto_decode_dns_answer(
+          client->in + off, client->in_used - off, &consumed, &view);
+      if (st == ODIN_PROTO_NEED_MORE) {
+        break;
+      }
+      if (st != ODIN_PROTO_OK) {
+        client_drop_stream(client);
+        return -1;
+      }
+      client_apply_answer(client, client->in + off, &view);
+      off += consumed;
+    }
+    memmove(client->in, client->in + off, client->in_used - off);
+    client->in_used -= off;
+    client_rearm_progress(client);
+  }
+}
+
+static void on_stream_io(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                         unsigned int events, void *user_data) {
+  (void)loop;
+  (void)io;
+  (void)fd;
+  odin_dns_tunnel_client_t *client = (odin_dns_tunnel_client_t *)user_data;
+  client_enter(client);
+  int rc = 0;
+  if ((events & (ODIN_EVENT_READ | ODIN_EVENT_ERROR)) != 0) {
+    rc = client_read(client);
+  }
+  if (rc == 0 && (events & ODIN_EVENT_WRITE) != 0) {
+    (void)client_flush(client);
+  }
+  client_drain_ready(client);
+  client_leave(client);
+}
+
+static void on_progress_timeout(odin_event_loop_t *loop,
+                                odin_event_timer_t *timer, void *user_data) {
+  (void)loop;
+  odin_dns_tunnel_client_t *client = (odin_dns_tunnel_client_t *)user_data;
+  if (client->progress_timer == timer) {
+    client->progress_timer = NULL;
+  }
+  client_enter(client);
+  client_drop_stream(client);
+  client_drain_ready(client);
+  client_leave(client);
+}
+
+static void on_deliver(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                       void *user_data) {
+  (void)loop;
+  odin_dns_tunnel_client_t *client = (odin_dns_tunnel_client_t *)user_data;
+  if (client->deliver_timer == timer) {
+    client->deliver_timer = NULL;
+  }
+  client_enter(client);
+  client_drain_ready(client);
+  client_leave(client);
+}
+
+static int client_open_stream(odin_dns_tunnel_client_t *client) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return -1;
+  }
+  if (set_nonblocking(fds[0]) != 0 || set_nonblocking(fds[1]) != 0) {
+    const int saved = errno;
+    (void)close(fds[0]);
+    (void)close(fds[1]);
+    errno = saved;
+    return -1;
+  }
+  if (odin_event_io_start(client->loop, fds[0], ODIN_EVENT_READ, on_stream_io,
+                          client, &client->io) != 0) {
+    const int saved = errno;
+    client->io = NULL;
+    (void)close(fds[0]);
+    (void)close(fds[1]);
+    errno = saved;
+    return -1;
+  }
+  if (client->open_stream(fds[1], client->open_user_data) != 0) {
+    const int saved = errno;
+    odin_event_io_stop(client->io);
+    client->io = NULL;
+    (void)close(fds[0]);
+    (void)close(fds[1]);
+    errno = saved;
+    return -1;
+  }
+  client->fd = fds[0];
+  client->io_events = ODIN_EVENT_READ;
+  client->stats.streams += 1;
+  return 0;
+}
+
+static client_slot_t *client_find(odin_dns_tunnel_client_t *client,
+                                  const char *name, size_t name_len,
+                                  uint8_t family) {
+  for (size_t i = 0; i < client->slot_count; ++i) {
+    client_slot_t *slot = &client->slots[i];
+    if (slot->name_len == name_len && slot->family == family &&
+        strncasecmp(slot->name, name, name_len) == 0) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+/* A never-used slot, else the least recently used idle one. */
+static client_slot_t *client_take_slot(odin_dns_tunnel_client_t *client) {
+  client_slot_t *victim = NULL;
+  for (size_t i = 0; i < client->slot_count; ++i) {
+    client_slot_t *slot = &client->slots[i];
+    if (slot->name_len == 0) {
+      return slot;
+    }
+    if (slot->state == CLIENT_SLOT_IDLE &&
+        (victim == NULL || slot->last_used < victim->last_used)) {
+      victim = slot;
+    }
+  }
+  return victim;
+}
+
+static int client_arm_deliver(odin_dns_tunnel_client_t *client) {
+  if (client->deliver_timer != NULL) {
+    return 0;
+  }
+  if (odin_event_timer_start(client->loop, 0, 0, on_deliver, client,
+                             &client->deliver_timer) != 0) {
+    client->deliver_timer = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+int odin_dns_tunnel_client_create(const odin_dns_tunnel_client_config_t *config,
+                                  odin_dns_tunnel_client_t **out) {
+  if (config == NULL || config->loop == NULL || config->open_stream == NULL ||
+      out == NULL ||
+      config->cache_entries > ODIN_DNS_TUNNEL_CACHE_MAX_ENTRIES) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_dns_tunnel_client_t *client =
+      (odin_dns_tunnel_client_t *)calloc(1, sizeof(*client));
+  if (client == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  client->slot_count = config->cache_entries != 0
+                           ? config->cache_entries
+                           : ODIN_DNS_TUNNEL_CACHE_DEFAULT_ENTRIES;
+  client->slots =
+      (client_slot_t *)calloc(client->slot_count, sizeof(client->slots[0]));
+  if (client->slots == NULL) {
+    free(client);
+    errno = ENOMEM;
+    return -1;
+  }
+  client->loop = config->loop;
+  client->open_stream = config->open_stream;
+  client->open_user_data = config->open_user_data;
+  client->timeout_ms = config->timeout_ms != 0
+                           ? config->timeout_ms
+                           : ODIN_DNS_TUNNEL_DEFAULT_TIMEOUT_MS;
+  client->fd = -1;
+  *out = client;
+  return 0;
+}
+
+int odin_dns_tunnel_resolve(odin_dns_tunnel_client_t *client, const char *name,
+                            size_t name_len, int family, odin_dns_tunnel_cb cb,
+                            void *user_data, odin_dns_tunnel_request_t **out) {
+  if (client == NULL || name == NULL || name_len == 0 ||
+      name_len > ODIN_PROTO_HOST_MAX || cb == NULL || out == NULL ||
+      (family != AF_INET && family != AF_INET6)) {
+    errno = EINVAL;
+    return -1;
+  }
+  const uint8_t pf = family == AF_INET ? ODIN_PROTO_DNS_FAMILY_V4
+                                       : ODIN_PROTO_DNS_FAMILY_V6;
+  odin_dns_tunnel_request_t *req =
+      (odin_dns_tunnel_request_t *)calloc(1, sizeof(*req));
+  if (req == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  req->client = client;
+  req->cb = cb;
+  req->user_data = user_data;
+
+  const uint64_t now = now_ms();
+  client_slot_t *slot = client_find(client, name, name_len, pf);
+  if (slot != NULL && slot->state != CLIENT_SLOT_IDLE) {
+    slot->last_used = ++client->use_clock;
+    request_push_waiter(slot, req);
+    client->stats.lookups += 1;
+    client->stats.coalesced += 1;
+    *out = req;
+    return 0;
+  }
+  if (slot != NULL && now < slot->expires_ms) {
+    if (client_arm_deliver(client) != 0) {
+      const int saved = errno;
+      free(req);
+      errno = saved;
+      return -1;
+    }
+    slot->last_used = ++client->use_clock;
+    request_make_ready(client, req, slot);
+    client->stats.lookups += 1;
+    client->stats.hits += 1;
+    *out = req;
+    return 0;
+  }
+  if (slot == NULL) {
+    slot = client_take_slot(client);
+    if (slot == NULL) {
+      free(req);
+      errno = ENOBUFS;
+      return -1;
+    }
+  }
+  if (client->fd < 0 && client_open_stream(client) != 0) {
+    const int saved = errno;
+    free(req);
+    errno = saved;
+    return -1;
+  }
+  memcpy(slot->name, name, name_len);
+  slot->name_len = (uint8_t)name_len;
+  slot->family = pf;
+  slot->expires_ms = 0;
+  slot->state = CLIENT_SLOT_QUEUED;
+  slot->last_used = ++client->use_clock;
+  request_push_waiter(slot, req);
+  client->queued += 1;
+  client->stats.lookups += 1;
+  if (client_update_io(client) != 0) {
+    /* The query stays queued; the stream is retried by the next lookup. */
+    client_drop_stream(client);
+    (void)client_arm_deliver(client);
+  }
+  *out = req;
+  return 0;
+}
+
+void odin_dns_tunnel_request_cancel(odin_dns_tunnel_request_t *req) {
+  if (req == NULL) {
+    return;
+  }
+  request_unlink(req);
+  free(req);
+}
+
+void odin_dns_tunnel_client_stats(const odin_dns_tunnel_client_t *client,
+                                  odin_dns_tunnel_client_stats_t *out) {
+  if (out == NULL) {
+    return;
+  }
+  if (client == NULL) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = client->stats;
+}
+
+static void client_free(odin_dns_tunnel_client_t *client) {
+  for (size_t i = 0; i < client->slot_count; ++i) {
+    while (client->slots[i].waiters != NULL) {
+      odin_dns_tunnel_request_t *req = client->slots[i].waiters;
+      request_unlink(req);
+      free(req);
+    }
+  }
+  while (client->ready != NULL) {
+    odin_dns_tunnel_request_t *req = client->ready;
+    request_unlink(req);
+    free(req);
+  }
+  free(client->slots);
+  free(client);
+}
+
+void odin_dns_tunnel_client_destroy(odin_dns_tunnel_client_t *client) {
+  if (client == NULL) {
+    return;
+  }
+  if (client->io != NULL) {
+    odin_event_io_stop(client->io);
+    client->io = NULL;
+  }
+  if (client->fd >= 0) {
+    (void)close(client->fd);
+    client->fd = -1;
+  }
+  client_stop_progress_timer(client);
+  if (client->deliver_timer != NULL) {
+    odin_event_timer_stop(client->deliver_timer);
+    client->deliver_timer = NULL;
+  }
+  if (client->active_depth != 0) {
+    client->destroy_pending = 1;
+    return;
+  }
+  client_free(client);
+}
+
+#if defined(ODIN_DNS_TUNNEL_TESTING)
+
+void odin_dns_tunnel_test_set_now_ms(uint64_t ms) { g_test_now_ms = ms; }
+
+#endif /* defined(ODIN_DNS_TUNNEL_TESTING) */
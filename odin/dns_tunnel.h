@@ -0,0 +1,138 @@
+/* odin/dns_tunnel.h
+ *
+ * DNS over odin (RFC-045): name resolution carried on an odin/1 stream.
+ *
+ * A DNS stream is an ordinary CONNECT to the reserved target
+ * ODIN_PROTO_DNS_HOST port ODIN_PROTO_DNS_PORT. Once the server has answered
+ * it OK, the client writes DNS_QUERY frames and the server writes one
+ * DNS_ANSWER per query, in completion order (RFC-001 protocol.h). Queries are
+ * pipelined, so one stream carries a batch of lookups in each direction and
+ * a slow name never holds up the others.
+ *
+ * Server responder: odin_dns_tunnel_server_create takes over a server
+ * session's downstream transport after the CONNECT_RESP. It resolves each
+ * query through the server's odin_dns_resolver_t, so answers share the
+ * RFC-044 cache and refresh-ahead with CONNECT. At most
+ * ODIN_DNS_TUNNEL_INFLIGHT_MAX queries run at once; beyond that, and while
+ * answers wait on a slow reader, the responder stops reading. An installed
+ * address filter drops every answer address it refuses, so the tunnel never
+ * reveals an address the server would not dial. on_done fires once: err 0
+ * after the client half-closes with every answer written, else the error.
+ * The caller destroys the responder after on_done, or earlier to abort;
+ * destroy is legal from inside on_done.
+ *
+ * Client: odin_dns_tunnel_client_t resolves names over a DNS stream that it
+ * opens lazily through open_stream, handing over one end of a socketpair
+ * (the client runtime relays it like any local connection). It keeps a
+ * bounded answer cache honouring the server's TTLs, and coalesces a lookup
+ * for a (name, family) already in flight onto that query. Queued queries are
+ * written together on the next writable event. A stream that fails, closes,
+ * or delivers no answer for timeout_ms while queries are outstanding is
+ * dropped and every pending lookup fails; the next lookup opens a new one.
+ * Callbacks never run inside odin_dns_tunnel_resolve; cancelling a request
+ * suppresses its callback.
+ *
+ * Owner-thread APIs. int-returning functions return 0, or -1 with errno set.
+ */
+
+#ifndef ODIN_DNS_TUNNEL_H_
+#define ODIN_DNS_TUNNEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "odin/dns_resolver.h"
+#include "odin/event_loop.h"
+#include "odin/protocol.h"
+#include "odin/transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_DNS_TUNNEL_INFLIGHT_MAX 64u
+#define ODIN_DNS_TUNNEL_CACHE_DEFAULT_ENTRIES 256u
+#define ODIN_DNS_TUNNEL_CACHE_MAX_ENTRIES 4096u
+#define ODIN_DNS_TUNNEL_DEFAULT_TIMEOUT_MS 5000u
+
+typedef struct odin_dns_tunnel_server_t odin_dns_tunnel_server_t;
+typedef struct odin_dns_tunnel_client_t odin_dns_tunnel_client_t;
+typedef struct odin_dns_tunnel_request_t odin_dns_tunnel_request_t;
+
+/* Same contract as odin_server_session_dial_filter_cb: nonzero refuses. */
+typedef int (*odin_dns_tunnel_filter_cb)(const struct sockaddr *addr,
+                                         socklen_t addrlen, void *user_data);
+
+typedef void (*odin_dns_tunnel_server_done_cb)(odin_dns_tunnel_server_t *srv,
+                                               int err, void *user_data);
+
+/* t is borrowed and must outlive the responder; the caller routes t's
+ * readiness to odin_dns_tunnel_server_ready. prefix holds bytes the client
+ * sent behind its CONNECT_REQ and is consumed before any read. Returns 0, or
+ * -1 with errno EINVAL, ENOMEM, or EPROTO (prefix is not DNS_QUERY frames). */
+int odin_dns_tunnel_server_create(odin_dns_resolver_t *resolver,
+                                  odin_transport_t *t, const uint8_t *prefix,
+                                  size_t prefix_len,
+                                  odin_dns_tunnel_filter_cb filter,
+                                  void *filter_ud,
+                                  odin_dns_tunnel_server_done_cb on_done,
+                                  void *user_data,
+                                  odin_dns_tunnel_server_t **out);
+/* Readiness entry point; user_data is the responder. */
+void odin_dns_tunnel_server_ready(odin_transport_t *t, unsigned int events,
+                                  void *user_data);
+void odin_dns_tunnel_server_destroy(odin_dns_tunnel_server_t *srv);
+
+/* Takes ownership of fd, a connected nonblocking stream socket, on 0. */
+typedef int (*odin_dns_tunnel_open_cb)(int fd, void *user_data);
+
+/* Zero fields take the defaults above. */
+typedef struct odin_dns_tunnel_client_config_t {
+  odin_event_loop_t *loop;
+  odin_dns_tunnel_open_cb open_stream;
+  void *open_user_data;
+  size_t cache_entries;
+  uint32_t timeout_ms;
+} odin_dns_tunnel_client_config_t;
+
+typedef struct odin_dns_tunnel_client_stats_t {
+  uint64_t lookups;   /* odin_dns_tunnel_resolve calls that started     */
+  uint64_t hits;      /* answered from the client cache                 */
+  uint64_t coalesced; /* joined a query already in flight               */
+  uint64_t queries;   /* DNS_QUERY frames written                       */
+  uint64_t failures;  /* lookups that completed with RCODE_FAIL         */
+  uint64_t streams;   /* DNS streams opened                             */
+} odin_dns_tunnel_client_stats_t;
+
+/* rcode is ODIN_PROTO_DNS_RCODE_OK (count may be 0: no such name or no
+ * data) or ODIN_PROTO_DNS_RCODE_FAIL. addrs holds count packed addresses of
+ * the requested family and is valid only during the call. The request is
+ * freed when the callback returns. */
+typedef void (*odin_dns_tunnel_cb)(odin_dns_tunnel_request_t *req,
+                                   uint8_t rcode, uint32_t ttl,
+                                   const uint8_t *addrs, size_t count,
+                                   void *user_data);
+
+int odin_dns_tunnel_client_create(const odin_dns_tunnel_client_config_t *config,
+                                  odin_dns_tunnel_client_t **out);
+/* family is AF_INET or AF_INET6; name is 1..ODIN_PROTO_HOST_MAX bytes. Returns
+ * 0, or -1 with errno EINVAL, ENOMEM, or ENOBUFS (every cache slot holds a
+ * query in flight). */
+int odin_dns_tunnel_resolve(odin_dns_tunnel_client_t *client, const char *name,
+                            size_t name_len, int family, odin_dns_tunnel_cb cb,
+                            void *user_data, odin_dns_tunnel_request_t **out);
+/* Suppresses the callback and frees req; the query itself keeps running for
+ * other waiters and the cache. No-op for NULL. */
+void odin_dns_tunnel_request_cancel(odin_dns_tunnel_request_t *req);
+void odin_dns_tunnel_client_stats(const odin_dns_tunnel_client_t *client,
+                                  odin_dns_tunnel_client_stats_t *out);
+/* Pending requests are freed without their callbacks; their owners must not
+ * cancel them afterwards. Legal from inside a request callback. */
+void odin_dns_tunnel_client_destroy(odin_dns_tunnel_client_t *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_DNS_TUNNEL_H_ */
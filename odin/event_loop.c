@@ -1,3 +1,7 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* dladdr(3) */
+#endif
+
 #include "odin/event_loop.h"
 
 #if defined(ODIN_EVENT_LOOP_TESTING)
@@ -5,11 +9,14 @@
 #endif
 
 #include <assert.h>
+#include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -24,9 +31,12 @@
 #error "odin/event_loop supports only macOS kqueue and Linux epoll"
 #endif
 
+#include "odin/trace.h"
+
 typedef struct odin_event_task_t odin_event_task_t;
 typedef struct odin_timer_heap_entry_t odin_timer_heap_entry_t;
 typedef struct odin_ready_item_t odin_ready_item_t;
+typedef struct odin_event_loop_instr_t odin_event_loop_instr_t;
 #if defined(ODIN_EVENT_LOOP_TESTING) && defined(__APPLE__)
 typedef struct odin_kqueue_registered_t odin_kqueue_registered_t;
 #endif
@@ -80,6 +90,19 @@ struct odin_ready_item_t {
   uint64_t sequence;
 };
 
+/* RFC-046 instrumentation state, allocated by odin_event_loop_enable_stats.
+ * slots is an open-addressed table keyed by callback address; fn 0 marks a
+ * free slot. */
+struct odin_event_loop_instr_t {
+  odin_event_loop_stats_config_t config;
+  odin_event_loop_stats_t stats;
+  uint64_t wake_us;
+  uint64_t next_report_us;
+  uint64_t suppressed;
+  char symbol[ODIN_EVENT_LOOP_SYMBOL_MAX];
+  odin_event_loop_cb_stats_t slots[ODIN_EVENT_LOOP_CB_SLOTS];
+};
+
 #if defined(ODIN_EVENT_LOOP_TESTING) && defined(__APPLE__)
 struct odin_kqueue_registered_t {
   int fd;
@@ -108,6 +131,11 @@ struct odin_event_loop_t {
   uint64_t next_io_sequence;
   uint64_t next_timer_sequence;
   size_t snapshot_depth;
+  odin_event_loop_instr_t *instr;
+  int budgeted;
+  odin_event_loop_budget_t budget;
+  odin_ready_item_t *carry; /* sorted readiness a budget left over */
+  size_t carry_len;
 #if defined(ODIN_EVENT_LOOP_TESTING)
   int use_fake_now;
   uint64_t fake_now_us;
@@ -164,11 +192,136 @@ static uint64_t monotonic_us(odin_event_loop_t *loop) {
   return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
 }
 
+static void hist_record(odin_event_loop_hist_t *h, uint64_t us) {
+  size_t bucket = 0;
+  for (uint64_t v = us; v != 0 && bucket + 1 < ODIN_EVENT_LOOP_HIST_BUCKETS;
+       v >>= 1) {
+    bucket += 1;
+  }
+  h->count += 1;
+  h->sum_us += us;
+  if (us > h->max_us) {
+    h->max_us = us;
+  }
+  h->buckets[bucket] += 1;
+}
+
+static odin_event_loop_cb_stats_t *instr_slot(odin_event_loop_instr_t *instr,
+                                              uintptr_t fn, int kind) {
+  const size_t mask = ODIN_EVENT_LOOP_CB_SLOTS - 1;
+  size_t i = (size_t)((fn >> 4) * 0x9E3779B97F4A7C15ull >> 32) & mask;
+  for (size_t probes = 0; probes < ODIN_EVENT_LOOP_CB_SLOTS; ++probes) {
+    odin_event_loop_cb_stats_t *slot = &instr->slots[i];
+    if (slot->fn == fn) {
+      return slot;
+    }
+    if (slot->fn == 0) {
+      slot->fn = fn;
+      slot->kind = kind;
+      instr->stats.callbacks += 1;
+      return slot;
+    }
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+static void instr_report_slow(odin_event_loop_t *loop, uintptr_t fn, int kind,
+                              uint64_t elapsed_us, uint64_t now_us) {
+  odin_event_loop_instr_t *instr = loop->instr;
+  instr->stats.slow_callbacks += 1;
+  if (instr->config.on_slow == NULL) {
+    return;
+  }
+  if (instr->stats.slow_reports > 0 && now_us < instr->next_report_us) {
+    instr->suppressed += 1;
+    return;
+  }
+  instr->stats.slow_reports += 1;
+  instr->next_report_us = now_us + instr->config.report_interval_us;
+  (void)odin_event_loop_symbol(fn, instr->symbol, sizeof(instr->symbol));
+  odin_event_loop_slow_report_t report;
+  report.fn = fn;
+  report.kind = kind;
+  report.elapsed_us = elapsed_us;
+  report.suppressed = instr->suppressed;
+  report.symbol = instr->symbol;
+  instr->suppressed = 0;
+  instr->config.on_slow(loop, &report, instr->config.user_data);
+}
+
+/* Charges one callback run that started at start_us to fn. */
+static void instr_note_run(odin_event_loop_t *loop, uintptr_t fn, int kind,
+                           uint64_t start_us) {
+  odin_event_loop_instr_t *instr = loop->instr;
+  const uint64_t end_us = monotonic_us(loop);
+  const uint64_t elapsed_us = end_us > start_us ? end_us - start_us : 0;
+  hist_record(&instr->stats.callback, elapsed_us);
+  odin_event_loop_cb_stats_t *slot = instr_slot(instr, fn, kind);
+  if (slot != NULL) {
+    hist_record(&slot->run, elapsed_us);
+  } else {
+    instr->stats.untracked += 1;
+  }
+  if (elapsed_us >= instr->config.slow_us) {
+    instr_report_slow(loop, fn, kind, elapsed_us, end_us);
+  }
+}
+
+/* Backend wait boundaries: the busy time between a wake-up and the next wait
+ * is one iteration. */
+static void instr_note_wait(odin_event_loop_t *loop) {
+  odin_event_loop_instr_t *instr = loop->instr;
+  const uint64_t now_us = monotonic_us(loop);
+  hist_record(&instr->stats.iteration,
+              now_us > instr->wake_us ? now_us - instr->wake_us : 0);
+}
+
+static void instr_note_wake(odin_event_loop_t *loop) {
+  loop->instr->wake_us = monotonic_us(loop);
+}
+
+/* RFC-047: the time by which the current phase should end, or UINT64_MAX. */
+static uint64_t phase_deadline(odin_event_loop_t *loop) {
+  if (!loop->budgeted || loop->budget.phase_us == 0) {
+    return UINT64_MAX;
+  }
+  const uint64_t now_us = monotonic_us(loop);
+  return UINT64_MAX - now_us <= loop->budget.phase_us
+             ? UINT64_MAX
+             : now_us + loop->budget.phase_us;
+}
+
+/* True once a phase that has dispatched done callbacks, at most max of them
+ * (0: any number), should yield. */
+static int phase_spent(odin_event_loop_t *loop, size_t done, size_t max,
+                       uint64_t deadline_us) {
+  if (done == 0) {
+    return 0;
+  }
+  if (max != 0 && done >= max) {
+    return 1;
+  }
+  return deadline_us != UINT64_MAX && monotonic_us(loop) >= deadline_us;
+}
+
 static void enter_dispatch_snapshot(odin_event_loop_t *loop) {
   loop->snapshot_depth += 1;
 }
 
+/* Drops io's carried readiness before its handle is freed. */
+static void carry_forget(odin_event_loop_t *loop, odin_event_io_t *io) {
+  size_t kept = 0;
+  for (size_t i = 0; i < loop->carry_len; ++i) {
+    if (loop->carry[i].io != io) {
+      loop->carry[kept++] = loop->carry[i];
+    }
+  }
+  loop->carry_len = kept;
+}
+
 static void free_io_handle(odin_event_io_t *io) {
+  carry_forget(io->loop, io);
 #if defined(ODIN_EVENT_LOOP_TESTING)
   g_live_ios -= 1;
 #endif
@@ -384,6 +537,20 @@ static void cancel_queued_tasks(odin_event_loop_t *loop) {
   }
 }
 
+/* Puts the unclaimed rest of a task snapshot back ahead of anything posted
+ * since, keeping FIFO order. */
+static void requeue_tasks(odin_event_loop_t *loop, odin_event_task_t *rest) {
+  odin_event_task_t *last = rest;
+  while (last->next != NULL) {
+    last = last->next;
+  }
+  last->next = loop->task_head;
+  if (loop->task_head == NULL) {
+    loop->task_tail = last;
+  }
+  loop->task_head = rest;
+}
+
 static void drain_posted_tasks(odin_event_loop_t *loop) {
   odin_event_task_t *snapshot = loop->task_head;
   if (snapshot == NULL) {
@@ -392,11 +559,28 @@ static void drain_posted_tasks(odin_event_loop_t *loop) {
   loop->task_head = NULL;
   loop->task_tail = NULL;
   enter_dispatch_snapshot(loop);
+  const uint64_t deadline_us = phase_deadline(loop);
+  size_t done = 0;
   while (snapshot != NULL) {
+    /* Budgets never cut a phase after stop: callbacks a snapshot claimed
+     * still run (RFC-010). The timer and I/O phases do the same. */
+    if (loop->budgeted && !loop->stop_requested &&
+        phase_spent(loop, done, 0, deadline_us)) {
+      requeue_tasks(loop, snapshot);
+      break;
+    }
     odin_event_task_t *next = snapshot->next;
-    snapshot->cb(loop, snapshot->user_data);
+    if (loop->instr == NULL) {
+      snapshot->cb(loop, snapshot->user_data);
+    } else {
+      const uint64_t start_us = monotonic_us(loop);
+      snapshot->cb(loop, snapshot->user_data);
+      instr_note_run(loop, (uintptr_t)snapshot->cb, ODIN_EVENT_CB_TASK,
+                     start_us);
+    }
     free_task(snapshot);
     snapshot = next;
+    done += 1;
   }
   leave_dispatch_snapshot(loop);
 }
@@ -719,19 +903,82 @@ static void sort_ready_items(odin_ready_item_t *items, size_t count) {
   }
 }
 
-static void dispatch_ready_items(odin_event_loop_t *loop,
-                                 odin_ready_item_t *items, size_t count) {
-  sort_ready_items(items, count);
+/* Keeps readiness a budget left undispatched for the next pass. Losing it to
+ * ENOMEM is harmless: watches are level-triggered, so the next wait reports
+ * it again. */
+static void carry_ready_items(odin_event_loop_t *loop,
+                              const odin_ready_item_t *items, size_t count) {
+  free(loop->carry);
+  loop->carry = (odin_ready_item_t *)malloc(count * sizeof(items[0]));
+  loop->carry_len = 0;
+  if (loop->carry != NULL) {
+    memcpy(loop->carry, items, count * sizeof(items[0]));
+    loop->carry_len = count;
+  }
+}
+
+static void dispatch_sorted_items(odin_event_loop_t *loop,
+                                  odin_ready_item_t *items, size_t count) {
   enter_dispatch_snapshot(loop);
-  for (size_t i = 0; i < count; ++i) {
+  const uint64_t deadline_us = phase_deadline(loop);
+  size_t done = 0;
+  size_t i = 0;
+  for (; i < count; ++i) {
+    if (loop->budgeted && !loop->stop_requested &&
+        phase_spent(loop, done, loop->budget.io_per_pass, deadline_us)) {
+      carry_ready_items(loop, items + i, count - i);
+      break;
+    }
     odin_event_io_t *io = items[i].io;
-    if (io->active && io->generation == items[i].generation) {
+    if (!io->active || io->generation != items[i].generation) {
+      continue;
+    }
+    if (loop->instr == NULL) {
       io->cb(loop, io, io->fd, items[i].events, io->user_data);
+    } else {
+      const odin_event_io_cb cb = io->cb;
+      const uint64_t start_us = monotonic_us(loop);
+      cb(loop, io, io->fd, items[i].events, io->user_data);
+      instr_note_run(loop, (uintptr_t)cb, ODIN_EVENT_CB_IO, start_us);
     }
+    done += 1;
   }
   leave_dispatch_snapshot(loop);
 }
 
+static void dispatch_ready_items(odin_event_loop_t *loop,
+                                 odin_ready_item_t *items, size_t count) {
+  sort_ready_items(items, count);
+  dispatch_sorted_items(loop, items, count);
+}
+
+/* Dispatches carried readiness in place of a backend wait. */
+static void dispatch_carry(odin_event_loop_t *loop) {
+  odin_ready_item_t *items = loop->carry;
+  const size_t count = loop->carry_len;
+  loop->carry = NULL;
+  loop->carry_len = 0;
+  dispatch_sorted_items(loop, items, count);
+  free(items);
+}
+
+/* Pushes still-live entries of a due-timer snapshot back onto the heap with
+ * their deadlines and sequences, so they stay due and keep their order. */
+static int requeue_timers(odin_event_loop_t *loop,
+                          const odin_timer_heap_entry_t *rest, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    odin_event_timer_t *timer = rest[i].timer;
+    if (!timer->active || timer->generation != rest[i].generation) {
+      continue;
+    }
+    if (timer_heap_prepare_push(loop) != 0) {
+      return -1;
+    }
+    timer_heap_push_prepared(loop, timer);
+  }
+  return 0;
+}
+
 static int dispatch_due_timers(odin_event_loop_t *loop) {
   odin_timer_heap_entry_t *snapshot = NULL;
   size_t count = 0;
@@ -769,13 +1016,31 @@ static int dispatch_due_timers(odin_event_loop_t *loop) {
     snapshot[count++] = entry;
   }
 
+  const uint64_t deadline_us = phase_deadline(loop);
+  size_t fired = 0;
   for (size_t i = 0; i < count; ++i) {
+    if (loop->budgeted && !loop->stop_requested &&
+        phase_spent(loop, fired, 0, deadline_us)) {
+      rc = requeue_timers(loop, snapshot + i, count - i);
+      break;
+    }
     odin_event_timer_t *timer = snapshot[i].timer;
     if (!timer->active || timer->generation != snapshot[i].generation) {
       continue;
     }
+    fired += 1;
     const unsigned int fired_generation = timer->generation;
-    timer->cb(loop, timer, timer->user_data);
+    if (loop->instr == NULL) {
+      timer->cb(loop, timer, timer->user_data);
+    } else {
+      const odin_event_timer_cb cb = timer->cb;
+      const uint64_t start_us = monotonic_us(loop);
+      hist_record(&loop->instr->stats.timer_lateness,
+                  start_us > snapshot[i].due_us ? start_us - snapshot[i].due_us
+                                                : 0);
+      cb(loop, timer, timer->user_data);
+      instr_note_run(loop, (uintptr_t)cb, ODIN_EVENT_CB_TIMER, start_us);
+    }
     if (timer->active && timer->generation == fired_generation &&
         timer->repeat_us > 0) {
       const uint64_t now = monotonic_us(loop);
@@ -861,8 +1126,16 @@ static int backend_wait(odin_event_loop_t *loop, int force_nonblocking) {
   }
 #endif
 
+  if (loop->carry_len > 0) {
+    dispatch_carry(loop);
+    return 0;
+  }
   uint64_t next_due = 0;
   const int has_due = first_live_timer_deadline(loop, &next_due);
+  if (loop->instr != NULL) {
+    instr_note_wait(loop);
+  }
+  ODIN_TRACE1(loop__iter__done, loop);
 #if defined(__linux__)
   if (arm_timerfd(loop, has_due, next_due) != 0) {
     return -1;
@@ -870,6 +1143,10 @@ static int backend_wait(odin_event_loop_t *loop, int force_nonblocking) {
   struct epoll_event events[64];
   const int timeout_ms = force_nonblocking ? 0 : -1;
   const int n = epoll_wait(loop->backend_fd, events, 64, timeout_ms);
+  if (loop->instr != NULL) {
+    instr_note_wake(loop);
+  }
+  ODIN_TRACE1(loop__iter__start, loop);
   if (n < 0) {
     return -1;
   }
@@ -917,6 +1194,10 @@ static int backend_wait(odin_event_loop_t *loop, int force_nonblocking) {
     timeout_ptr = &timeout;
   }
   const int n = kevent(loop->backend_fd, NULL, 0, events, 64, timeout_ptr);
+  if (loop->instr != NULL) {
+    instr_note_wake(loop);
+  }
+  ODIN_TRACE1(loop__iter__start, loop);
   if (n < 0) {
     return -1;
   }
@@ -1048,6 +1329,10 @@ int odin_event_loop_run(odin_event_loop_t *loop) {
   }
   loop->running = 1;
   loop->stop_requested = 0;
+  if (loop->instr != NULL) {
+    instr_note_wake(loop);
+  }
+  ODIN_TRACE1(loop__iter__start, loop);
 
   int rc = 0;
   int saved_errno = 0;
@@ -1134,6 +1419,8 @@ void odin_event_loop_destroy(odin_event_loop_t *loop) {
 #endif
 #endif
   free(loop->timer_heap);
+  free(loop->instr);
+  free(loop->carry);
   backend_close(loop);
 #if defined(ODIN_EVENT_LOOP_TESTING)
   g_live_loops -= 1;
@@ -1291,6 +1578,131 @@ int odin_event_post(odin_event_loop_t *loop, odin_event_task_cb cb,
   return append_task(loop, cb, user_data);
 }
 
+void odin_event_loop_set_budget(odin_event_loop_t *loop,
+                                const odin_event_loop_budget_t *budget) {
+  assert_owner(loop);
+  memset(&loop->budget, 0, sizeof(loop->budget));
+  if (budget != NULL) {
+    loop->budget = *budget;
+  }
+  loop->budgeted = loop->budget.io_per_pass != 0 || loop->budget.phase_us != 0;
+}
+
+int odin_event_loop_enable_stats(odin_event_loop_t *loop,
+                                 const odin_event_loop_stats_config_t *config) {
+  assert_owner(loop);
+  if (loop->instr != NULL) {
+    errno = EALREADY;
+    return -1;
+  }
+  odin_event_loop_instr_t *instr =
+      (odin_event_loop_instr_t *)calloc(1, sizeof(*instr));
+  if (instr == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  if (config != NULL) {
+    instr->config = *config;
+  }
+  if (instr->config.slow_us == 0) {
+    instr->config.slow_us = ODIN_EVENT_LOOP_DEFAULT_SLOW_US;
+  }
+  if (instr->config.report_interval_us == 0) {
+    instr->config.report_interval_us =
+        ODIN_EVENT_LOOP_DEFAULT_REPORT_INTERVAL_US;
+  }
+  loop->instr = instr;
+  instr_note_wake(loop);
+  return 0;
+}
+
+void odin_event_loop_stats(const odin_event_loop_t *loop,
+                           odin_event_loop_stats_t *out) {
+  assert(loop != NULL && out != NULL);
+  assert(pthread_equal(pthread_self(), loop->owner));
+  if (loop->instr == NULL) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = loop->instr->stats;
+}
+
+size_t odin_event_loop_callback_stats(const odin_event_loop_t *loop,
+                                      odin_event_loop_cb_stats_t *out,
+                                      size_t cap) {
+  assert(loop != NULL && (out != NULL || cap == 0));
+  assert(pthread_equal(pthread_self(), loop->owner));
+  if (loop->instr == NULL) {
+    return 0;
+  }
+  size_t filled = 0;
+  for (size_t i = 0; i < ODIN_EVENT_LOOP_CB_SLOTS; ++i) {
+    const odin_event_loop_cb_stats_t *slot = &loop->instr->slots[i];
+    if (slot->fn == 0) {
+      continue;
+    }
+    size_t j = filled < cap ? filled++ : cap;
+    while (j > 0 && out[j - 1].run.sum_us < slot->run.sum_us) {
+      if (j < cap) {
+        out[j] = out[j - 1];
+      }
+      --j;
+    }
+    if (j < cap) {
+      out[j] = *slot;
+    }
+  }
+  return loop->instr->stats.callbacks;
+}
+
+size_t odin_event_loop_symbol(uintptr_t fn, char *buf, size_t cap) {
+  Dl_info info;
+  memset(&info, 0, sizeof(info));
+  int n = 0;
+  if (dladdr((void *)fn, &info) == 0 || info.dli_fname == NULL) {
+    n = snprintf(buf, cap, "0x%" PRIxPTR, fn);
+  } else if (info.dli_sname != NULL && (uintptr_t)info.dli_saddr == fn) {
+    n = snprintf(buf, cap, "%s", info.dli_sname);
+  } else {
+    /* Static functions have no dynamic symbol; module+offset is what
+     * addr2line and atos take. */
+    const char *module = strrchr(info.dli_fname, '/');
+    module = module != NULL ? module + 1 : info.dli_fname;
+    n = snprintf(buf, cap, "%s+0x%" PRIxPTR, module,
+                 fn - (uintptr_t)info.dli_fbase);
+  }
+  return n > 0 ? (size_t)n : 0;
+}
+
+static uint64_t hist_mean_us(const odin_event_loop_hist_t *h) {
+  return h->count != 0 ? h->sum_us / h->count : 0;
+}
+
+size_t odin_event_loop_stats_format(const odin_event_loop_stats_t *stats,
+                                    char *buf, size_t cap) {
+  const int n = snprintf(
+      buf, cap,
+      "loop_us=%" PRIu64 "/%" PRIu64 " late_us=%" PRIu64 "/%" PRIu64
+      " cb_us=%" PRIu64 "/%" PRIu64 " slow=%" PRIu64,
+      hist_mean_us(&stats->iteration), stats->iteration.max_us,
+      hist_mean_us(&stats->timer_lateness), stats->timer_lateness.max_us,
+      hist_mean_us(&stats->callback), stats->callback.max_us,
+      stats->slow_callbacks);
+  return n > 0 ? (size_t)n : 0;
+}
+
+size_t odin_event_loop_slow_report_format(
+    const odin_event_loop_slow_report_t *report, char *buf, size_t cap) {
+  const char *kind = report->kind == ODIN_EVENT_CB_IO      ? "io"
+                     : report->kind == ODIN_EVENT_CB_TIMER ? "timer"
+                                                           : "task";
+  const int n = snprintf(buf, cap,
+                         "cb=%s kind=%s us=%" PRIu64 " suppressed=%" PRIu64,
+                         report->symbol != NULL ? report->symbol : "?", kind,
+                         report->elapsed_us, report->suppressed);
+  return n > 0 ? (size_t)n : 0;
+}
+
 #if defined(ODIN_EVENT_LOOP_TESTING)
 void odin_event_loop_test_set_now_us(odin_event_loop_t *loop, uint64_t now_us) {
   assert_owner(loop);
@@ -11,6 +11,7 @@
 #ifndef ODIN_EVENT_LOOP_H_
 #define ODIN_EVENT_LOOP_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -95,6 +96,134 @@ typedef void (*odin_event_task_cb)(odin_event_loop_t *loop, void *user_data);
 int odin_event_post(odin_event_loop_t *loop, odin_event_task_cb cb,
                     void *user_data);
 
+/* Fair dispatch budgets (RFC-047), off until odin_event_loop_set_budget.
+ *
+ * Each run pass dispatches a task phase, a timer phase, and an I/O phase.
+ * io_per_pass caps the I/O callbacks one pass dispatches; readiness left over
+ * is carried into the next pass, which dispatches it without another backend
+ * wait once tasks and due timers have run. phase_us caps the time any one
+ * phase may take: the phase ends after the callback that crosses it, tasks
+ * left over go back to the head of the task queue, and due timers left over
+ * stay due. Every phase dispatches at least one callback. Zero fields are
+ * unlimited; the defaults below are what the CLI runners use.
+ */
+#define ODIN_EVENT_LOOP_DEFAULT_IO_PER_PASS 16u
+#define ODIN_EVENT_LOOP_DEFAULT_PHASE_US 2000u
+
+typedef struct odin_event_loop_budget_t {
+  size_t io_per_pass;
+  uint64_t phase_us;
+} odin_event_loop_budget_t;
+
+/* budget NULL, or all zero, turns budgets off. Legal while the loop runs;
+ * takes effect at the next phase. */
+void odin_event_loop_set_budget(odin_event_loop_t *loop,
+                                const odin_event_loop_budget_t *budget);
+
+/* Instrumentation (RFC-046), off until odin_event_loop_enable_stats.
+ *
+ * An instrumented loop times every callback it dispatches and records, in
+ * microseconds of the loop's monotonic clock:
+ *
+ *   - iteration: busy time from each backend wake-up to the next wait;
+ *   - timer lateness: how far past its deadline each timer callback started;
+ *   - callback run time, overall and per callback address (I/O, timer, and
+ *     task callbacks alike), in up to ODIN_EVENT_LOOP_CB_SLOTS addresses.
+ *
+ * A callback that runs for slow_us or longer counts as slow. When on_slow is
+ * set, at most one slow callback per report_interval_us is reported to it,
+ * with the callback's symbol and the number of slow callbacks skipped since
+ * the previous report. A loop without instrumentation pays one branch per
+ * dispatched callback and per backend wait.
+ */
+#define ODIN_EVENT_LOOP_HIST_BUCKETS 32u
+#define ODIN_EVENT_LOOP_CB_SLOTS 128u
+#define ODIN_EVENT_LOOP_SYMBOL_MAX 128u
+#define ODIN_EVENT_LOOP_DEFAULT_SLOW_US 10000u
+#define ODIN_EVENT_LOOP_DEFAULT_REPORT_INTERVAL_US 1000000u
+
+#define ODIN_EVENT_CB_IO 1
+#define ODIN_EVENT_CB_TIMER 2
+#define ODIN_EVENT_CB_TASK 3
+
+/* Bucket 0 counts 0 us and bucket i counts [2^(i-1), 2^i) us; the last
+ * bucket also takes everything longer. */
+typedef struct odin_event_loop_hist_t {
+  uint64_t count;
+  uint64_t sum_us;
+  uint64_t max_us;
+  uint64_t buckets[ODIN_EVENT_LOOP_HIST_BUCKETS];
+} odin_event_loop_hist_t;
+
+typedef struct odin_event_loop_stats_t {
+  odin_event_loop_hist_t iteration;
+  odin_event_loop_hist_t timer_lateness;
+  odin_event_loop_hist_t callback;
+  uint64_t slow_callbacks; /* runs of slow_us or longer                  */
+  uint64_t slow_reports;   /* of those, passed to on_slow               */
+  uint64_t untracked;      /* runs of callbacks that found no free slot */
+  size_t callbacks;        /* distinct callback addresses tracked       */
+} odin_event_loop_stats_t;
+
+typedef struct odin_event_loop_cb_stats_t {
+  uintptr_t fn;
+  int kind; /* ODIN_EVENT_CB_* */
+  odin_event_loop_hist_t run;
+} odin_event_loop_cb_stats_t;
+
+/* symbol is valid only during the call. */
+typedef struct odin_event_loop_slow_report_t {
+  uintptr_t fn;
+  int kind;
+  uint64_t elapsed_us;
+  uint64_t suppressed; /* slow callbacks not reported since the last report */
+  const char *symbol;
+} odin_event_loop_slow_report_t;
+
+typedef void (*odin_event_loop_slow_cb)(
+    odin_event_loop_t *loop, const odin_event_loop_slow_report_t *report,
+    void *user_data);
+
+/* Zero fields take the defaults above; on_slow NULL only counts. */
+typedef struct odin_event_loop_stats_config_t {
+  uint64_t slow_us;
+  uint64_t report_interval_us;
+  odin_event_loop_slow_cb on_slow;
+  void *user_data;
+} odin_event_loop_stats_config_t;
+
+/* Turns instrumentation on for the life of the loop; config NULL takes every
+ * default. Legal while the loop runs. Returns 0, or -1 with errno EALREADY or
+ * ENOMEM. */
+int odin_event_loop_enable_stats(odin_event_loop_t *loop,
+                                 const odin_event_loop_stats_config_t *config);
+
+/* Zeroes *out when instrumentation is off. */
+void odin_event_loop_stats(const odin_event_loop_t *loop,
+                           odin_event_loop_stats_t *out);
+
+/* Copies up to cap tracked callbacks into out, longest total run time first,
+ * and returns how many are tracked. */
+size_t odin_event_loop_callback_stats(const odin_event_loop_t *loop,
+                                      odin_event_loop_cb_stats_t *out,
+                                      size_t cap);
+
+/* Writes fn's symbol, or module+offset when it has no exported name, as a
+ * NUL-terminated string truncated to cap. Returns its untruncated length. */
+size_t odin_event_loop_symbol(uintptr_t fn, char *buf, size_t cap);
+
+/* Formats stats for the RFC-051 log line as
+ * "loop_us=A/M late_us=A/M cb_us=A/M slow=S": the mean and maximum of the
+ * iteration, timer lateness, and callback histograms, then the slow count.
+ * snprintf semantics; returns the untruncated length. */
+size_t odin_event_loop_stats_format(const odin_event_loop_stats_t *stats,
+                                    char *buf, size_t cap);
+
+/* Formats a slow report as "cb=SYMBOL kind=io|timer|task us=N suppressed=K".
+ * snprintf semantics; returns the untruncated length. */
+size_t odin_event_loop_slow_report_format(
+    const odin_event_loop_slow_report_t *report, char *buf, size_t cap);
+
 #ifdef __cplusplus
 }
 #endif
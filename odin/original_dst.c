@@ -0,0 +1,142 @@
+/* odin/original_dst.c -- RFC-040 original-destination recovery. */
+
+#include "odin/original_dst.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#if defined(ODIN_ORIGINAL_DST_TESTING)
+#include "odin/testing/original_dst_internal_test.h"
+
+static struct sockaddr_storage g_test_redirect;
+static socklen_t g_test_redirect_len;
+#endif
+
+#if defined(__linux__)
+/* <linux/netfilter_ipv4.h> and <linux/netfilter_ipv6/ip6_tables.h> define
+ * these; both headers clash with <netinet/in.h>, so the values are spelled
+ * out here. They are kernel ABI. */
+#ifndef SO_ORIGINAL_DST
+#define SO_ORIGINAL_DST 80
+#endif
+#ifndef IP6T_SO_ORIGINAL_DST
+#define IP6T_SO_ORIGINAL_DST 80
+#endif
+
+/* Reads the conntrack destination of a NAT-redirected socket of family. */
+static int conntrack_dst(int fd, int family, struct sockaddr_storage *out,
+                         socklen_t *out_len) {
+#if defined(ODIN_ORIGINAL_DST_TESTING)
+  if (g_test_redirect_len != 0) {
+    memcpy(out, &g_test_redirect, g_test_redirect_len);
+    *out_len = g_test_redirect_len;
+    g_test_redirect_len = 0;
+    return 0;
+  }
+#endif
+  socklen_t len = sizeof(*out);
+  const int rc = family == AF_INET6
+                     ? getsockopt(fd, IPPROTO_IPV6, IP6T_SO_ORIGINAL_DST, out,
+                                  &len)
+                     : getsockopt(fd, IPPROTO_IP, SO_ORIGINAL_DST, out, &len);
+  if (rc != 0) {
+    return -1;
+  }
+  *out_len = len;
+  return 0;
+}
+#endif
+
+static int is_wildcard(const struct sockaddr *sa) {
+  if (sa->sa_family == AF_INET) {
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)sa;
+    return sin->sin_addr.s_addr == htonl(INADDR_ANY);
+  }
+  const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)sa;
+  return IN6_IS_ADDR_UNSPECIFIED(&sin6->sin6_addr);
+}
+
+/* 1 when dst is the address listen_addr accepts on: same family and port,
+ * and the same address unless the listener is a wildcard. */
+static int is_listener(const struct sockaddr_storage *dst,
+                       const struct sockaddr *listen_addr) {
+  if (dst->ss_family != listen_addr->sa_family) {
+    return 0;
+  }
+  if (dst->ss_family == AF_INET) {
+    const struct sockaddr_in *a = (const struct sockaddr_in *)dst;
+    const struct sockaddr_in *l = (const struct sockaddr_in *)listen_addr;
+    return a->sin_port == l->sin_port &&
+           (is_wildcard(listen_addr) ||
+            a->sin_addr.s_addr == l->sin_addr.s_addr);
+  }
+  const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)dst;
+  const struct sockaddr_in6 *l = (const struct sockaddr_in6 *)listen_addr;
+  return a->sin6_port == l->sin6_port &&
+         (is_wildcard(listen_addr) ||
+          memcmp(&a->sin6_addr, &l->sin6_addr, sizeof(a->sin6_addr)) == 0);
+}
+
+int odin_original_dst_get(int conn_fd, const struct sockaddr *listen_addr,
+                          socklen_t listen_len, struct sockaddr_storage *out,
+                          socklen_t *out_len) {
+  if (conn_fd < 0 || listen_addr == NULL || out == NULL || out_len == NULL ||
+      (listen_addr->sa_family == AF_INET &&
+       listen_len < (socklen_t)sizeof(struct sockaddr_in)) ||
+      (listen_addr->sa_family == AF_INET6 &&
+       listen_len < (socklen_t)sizeof(struct sockaddr_in6))) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (listen_addr->sa_family != AF_INET && listen_addr->sa_family != AF_INET6) {
+    errno = EAFNOSUPPORT;
+    return -1;
+  }
+
+  struct sockaddr_storage dst;
+  memset(&dst, 0, sizeof(dst));
+  socklen_t dst_len = sizeof(dst);
+  if (getsockname(conn_fd, (struct sockaddr *)&dst, &dst_len) != 0) {
+    return -1;
+  }
+  if (dst.ss_family != AF_INET && dst.ss_family != AF_INET6) {
+    errno = EAFNOSUPPORT;
+    return -1;
+  }
+#if defined(__linux__)
+  struct sockaddr_storage nat;
+  memset(&nat, 0, sizeof(nat));
+  socklen_t nat_len = 0;
+  if (conntrack_dst(conn_fd, dst.ss_family, &nat, &nat_len) == 0 &&
+      (nat.ss_family == AF_INET || nat.ss_family == AF_INET6)) {
+    dst = nat;
+    dst_len = nat_len;
+  }
+#endif
+  if (is_listener(&dst, listen_addr)) {
+    errno = ELOOP;
+    return -1;
+  }
+  *out = dst;
+  *out_len = dst_len;
+  return 0;
+}
+
+#if defined(ODIN_ORIGINAL_DST_TESTING)
+
+int odin_original_dst_test_redirect_next(const struct sockaddr *dst,
+                                         socklen_t dst_len) {
+  if (dst == NULL || dst_len == 0 || dst_len > sizeof(g_test_redirect)) {
+    errno = EINVAL;
+    return -1;
+  }
+  memcpy(&g_test_redirect, dst, dst_len);
+  g_test_redirect_len = dst_len;
+  return 0;
+}
+
+#endif /* defined(ODIN_ORIGINAL_DST_TESTING) */
@@ -0,0 +1,45 @@
+/* odin/original_dst.h
+ *
+ * Original-destination recovery for transparent client mode (RFC-040).
+ *
+ * A connection the kernel redirected to the client's listener still carries
+ * the address the application dialed:
+ *
+ *   - iptables REDIRECT / nftables redirect (Linux NAT) rewrite the
+ *     destination to the listener and keep the original in conntrack, where
+ *     SO_ORIGINAL_DST (IPv4) and IP6T_SO_ORIGINAL_DST (IPv6) read it back;
+ *   - TPROXY (Linux) and pf divert-to leave the destination alone, so the
+ *     accepted socket's local address is the original destination.
+ *
+ * odin_original_dst_get tries SO_ORIGINAL_DST first (Linux only) and falls
+ * back to getsockname. A connection made straight to the listener has no
+ * conntrack entry and a local address equal to the listener's own; tunnelling
+ * it would make the client dial itself, so that case fails with ELOOP. A
+ * listener bound to a wildcard address matches any local address on its port.
+ *
+ * Threading: stateless; callable from any thread.
+ */
+
+#ifndef ODIN_ORIGINAL_DST_H_
+#define ODIN_ORIGINAL_DST_H_
+
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Writes conn_fd's original destination (AF_INET or AF_INET6) to *out and
+ * its length to *out_len. listen_addr is the listener conn_fd was accepted
+ * from. Returns 0, or -1 with errno EINVAL (NULL argument or bad length),
+ * ELOOP (not redirected: the destination is the listener itself),
+ * EAFNOSUPPORT (not an IP socket), or getsockname's errno. */
+int odin_original_dst_get(int conn_fd, const struct sockaddr *listen_addr,
+                          socklen_t listen_len, struct sockaddr_storage *out,
+                          socklen_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_ORIGINAL_DST_H_ */
@@ -1,10 +1,12 @@
-/* odin/protocol.c — RFC-001 codec implementation. */
+/* odin/protocol.c — RFC-001 codec implementation, with the RFC-045 DNS
+ * frames. */
 
 #include "odin/protocol.h"
 
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 void odin_proto_encode_connect_resp(uint16_t error_code,
                                     odin_proto_connect_resp_frame_t *out) {
@@ -113,3 +115,176 @@ odin_proto_decode_connect_req(const uint8_t *buf, size_t n,
   *out_consumed = total;
   return ODIN_PROTO_OK;
 }
+
+size_t odin_proto_dns_addr_len(uint8_t family) {
+  switch (family) {
+  case ODIN_PROTO_DNS_FAMILY_V4:
+    return 4;
+  case ODIN_PROTO_DNS_FAMILY_V6:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+/* Checks the version and frame_type prefix shared by the DNS frames. */
+static odin_proto_status_t check_prefix(const uint8_t *buf, size_t n,
+                                        uint8_t frame_type) {
+  if (n < 1) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+  if (buf[0] != ODIN_PROTO_VERSION_V1) {
+    return ODIN_PROTO_ERR_BAD_VERSION;
+  }
+  if (n < 2) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+  if (buf[1] != frame_type) {
+    return ODIN_PROTO_ERR_BAD_FRAME_TYPE;
+  }
+  return ODIN_PROTO_OK;
+}
+
+odin_proto_status_t odin_proto_encode_dns_query(uint16_t id, uint8_t family,
+                                                const char *name,
+                                                size_t name_len, uint8_t *out,
+                                                size_t cap, size_t *out_len) {
+  assert(name != NULL);
+  assert(out != NULL);
+  assert(out_len != NULL);
+
+  if (name_len < 1 || name_len > ODIN_PROTO_HOST_MAX) {
+    return ODIN_PROTO_ERR_HOST_LEN_INVALID;
+  }
+  if (odin_proto_dns_addr_len(family) == 0) {
+    return ODIN_PROTO_ERR_BAD_FAMILY;
+  }
+  const size_t total = (size_t)6 + name_len;
+  if (cap < total) {
+    return ODIN_PROTO_ERR_BUF_TOO_SMALL;
+  }
+
+  out[0] = ODIN_PROTO_VERSION_V1;
+  out[1] = ODIN_PROTO_FRAME_DNS_QUERY;
+  out[2] = (uint8_t)((id >> 8) & 0xFFu);
+  out[3] = (uint8_t)(id & 0xFFu);
+  out[4] = family;
+  out[5] = (uint8_t)name_len;
+  memcpy(out + 6, name, name_len);
+  *out_len = total;
+  return ODIN_PROTO_OK;
+}
+
+odin_proto_status_t
+odin_proto_decode_dns_query(const uint8_t *buf, size_t n, size_t *out_consumed,
+                            odin_proto_dns_query_view_t *out) {
+  assert(buf != NULL);
+  assert(out_consumed != NULL);
+  assert(out != NULL);
+
+  const odin_proto_status_t st =
+      check_prefix(buf, n, ODIN_PROTO_FRAME_DNS_QUERY);
+  if (st != ODIN_PROTO_OK) {
+    return st;
+  }
+  if (n < 6) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+  if (odin_proto_dns_addr_len(buf[4]) == 0) {
+    return ODIN_PROTO_ERR_BAD_FAMILY;
+  }
+  const uint8_t name_len = buf[5];
+  if (name_len < 1) {
+    return ODIN_PROTO_ERR_HOST_LEN_INVALID;
+  }
+  const size_t total = (size_t)6 + (size_t)name_len;
+  if (n < total) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+
+  out->id = (uint16_t)(((uint16_t)buf[2] << 8) | (uint16_t)buf[3]);
+  out->family = buf[4];
+  out->name_off = 6;
+  out->name_len = name_len;
+  *out_consumed = total;
+  return ODIN_PROTO_OK;
+}
+
+odin_proto_status_t odin_proto_encode_dns_answer(uint16_t id, uint8_t family,
+                                                 uint8_t rcode, uint32_t ttl,
+                                                 const uint8_t *addrs,
+                                                 size_t count, uint8_t *out,
+                                                 size_t cap, size_t *out_len) {
+  assert(addrs != NULL || count == 0);
+  assert(out != NULL);
+  assert(out_len != NULL);
+
+  const size_t alen = odin_proto_dns_addr_len(family);
+  if (alen == 0) {
+    return ODIN_PROTO_ERR_BAD_FAMILY;
+  }
+  if (count > ODIN_PROTO_DNS_ADDR_MAX) {
+    return ODIN_PROTO_ERR_BAD_COUNT;
+  }
+  const size_t total = ODIN_PROTO_DNS_ANSWER_HEADER_SIZE + count * alen;
+  if (cap < total) {
+    return ODIN_PROTO_ERR_BUF_TOO_SMALL;
+  }
+
+  out[0] = ODIN_PROTO_VERSION_V1;
+  out[1] = ODIN_PROTO_FRAME_DNS_ANSWER;
+  out[2] = (uint8_t)((id >> 8) & 0xFFu);
+  out[3] = (uint8_t)(id & 0xFFu);
+  out[4] = family;
+  out[5] = rcode;
+  out[6] = (uint8_t)((ttl >> 24) & 0xFFu);
+  out[7] = (uint8_t)((ttl >> 16) & 0xFFu);
+  out[8] = (uint8_t)((ttl >> 8) & 0xFFu);
+  out[9] = (uint8_t)(ttl & 0xFFu);
+  out[10] = (uint8_t)count;
+  if (count > 0) {
+    memcpy(out + ODIN_PROTO_DNS_ANSWER_HEADER_SIZE, addrs, count * alen);
+  }
+  *out_len = total;
+  return ODIN_PROTO_OK;
+}
+
+odin_proto_status_t
+odin_proto_decode_dns_answer(const uint8_t *buf, size_t n,
+                             size_t *out_consumed,
+                             odin_proto_dns_answer_view_t *out) {
+  assert(buf != NULL);
+  assert(out_consumed != NULL);
+  assert(out != NULL);
+
+  const odin_proto_status_t st =
+      check_prefix(buf, n, ODIN_PROTO_FRAME_DNS_ANSWER);
+  if (st != ODIN_PROTO_OK) {
+    return st;
+  }
+  if (n < ODIN_PROTO_DNS_ANSWER_HEADER_SIZE) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+  const size_t alen = odin_proto_dns_addr_len(buf[4]);
+  if (alen == 0) {
+    return ODIN_PROTO_ERR_BAD_FAMILY;
+  }
+  const size_t count = buf[10];
+  if (count > ODIN_PROTO_DNS_ADDR_MAX) {
+    return ODIN_PROTO_ERR_BAD_COUNT;
+  }
+  const size_t total = ODIN_PROTO_DNS_ANSWER_HEADER_SIZE + count * alen;
+  if (n < total) {
+    return ODIN_PROTO_NEED_MORE;
+  }
+
+  out->id = (uint16_t)(((uint16_t)buf[2] << 8) | (uint16_t)buf[3]);
+  out->family = buf[4];
+  out->rcode = buf[5];
+  out->ttl = ((uint32_t)buf[6] << 24) | ((uint32_t)buf[7] << 16) |
+             ((uint32_t)buf[8] << 8) | (uint32_t)buf[9];
+  out->count = count;
+  out->addrs_off = ODIN_PROTO_DNS_ANSWER_HEADER_SIZE;
+  *out_consumed = total;
+  return ODIN_PROTO_OK;
+}
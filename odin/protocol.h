@@ -19,25 +19,52 @@
  *     +---------+------------+--------------+
  *     Total: 4 bytes (fixed).
  *
+ *   DNS_QUERY (Client -> Server, frame_type = 0x03, RFC-045):
+ *     +---------+------------+------+--------+----------+----------------+
+ *     | version | frame_type |  id  | family | name_len |   name bytes   |
+ *     | 1 byte  |   1 byte   | 2 B  | 1 byte |  1 byte  | name_len bytes |
+ *     +---------+------------+------+--------+----------+----------------+
+ *     Total: 6 + name_len bytes; name_len in [1, 255]; max 261 bytes.
+ *
+ *   DNS_ANSWER (Server -> Client, frame_type = 0x04, RFC-045):
+ *     +---------+------------+------+--------+-------+------+-------+-------+
+ *     | version | frame_type |  id  | family | rcode | ttl  | count | addrs |
+ *     | 1 byte  |   1 byte   | 2 B  | 1 byte | 1 B   | 4 B  |  1 B  |   *   |
+ *     +---------+------------+------+--------+-------+------+-------+-------+
+ *     Total: 11 + count * (4 or 16) bytes; count in [0, 16]; max 267 bytes.
+ *
+ * DNS frames travel only on a DNS stream: one whose CONNECT_REQ names
+ * ODIN_PROTO_DNS_HOST port ODIN_PROTO_DNS_PORT and was answered OK. The
+ * .invalid name can never be a real CONNECT target (RFC 2606).
+ *
  * Field semantics (v1):
  *   version    = 0x01 (else ERR_BAD_VERSION).
- *   frame_type = 0x01 (CONNECT_REQ) or 0x02 (CONNECT_RESP); else
- *                ERR_BAD_FRAME_TYPE.
+ *   frame_type = 0x01 (CONNECT_REQ), 0x02 (CONNECT_RESP), 0x03
+ *                (DNS_QUERY), or 0x04 (DNS_ANSWER); each decoder accepts
+ *                only its own type, else ERR_BAD_FRAME_TYPE.
  *   host_len   in [1, 255]; zero -> ERR_HOST_LEN_INVALID.
  *   error_code 0x0000 = OK; non-zero is a Server-assigned failure reason
  *              (v1 reserves the 16-bit space; specific assignments belong
  *              to follow-up RFCs).
+ *   id         echoes the query in its answer; answers may arrive in any
+ *              order.
+ *   family     4 (A) or 6 (AAAA); else ERR_BAD_FAMILY.
+ *   rcode      0x00 = resolved, count may be 0 (no such name or no data);
+ *              0x01 = resolution failed.
+ *   ttl        seconds the answer may be cached.
+ *   count      in [0, 16]; more -> ERR_BAD_COUNT.
  *
- * Multi-byte integers (port, error_code) are big-endian; 1-byte fields are
- * endianness-agnostic. host bytes are opaque — DNS hostname syntax and
- * IP-literal grammar are the Server's concern, and the codec does not
- * reject embedded NUL. Each frame is self-delimiting from its own bytes:
+ * Multi-byte integers (port, error_code, id, ttl) are big-endian; 1-byte
+ * fields are endianness-agnostic. host bytes are opaque — DNS hostname
+ * syntax and IP-literal grammar are the Server's concern, and the codec does
+ * not reject embedded NUL. Each frame is self-delimiting from its own bytes:
  * CONNECT_REQ's total size is 5 + host_len (byte 2),
- * CONNECT_RESP's is fixed at 4. QUIC streams are byte-oriented, so the
- * decoders are prefix parsers that consume one frame and leave any
- * trailing bytes for the next layer. No padding, no reserved bits in v1;
- * the 1-byte version is the sole forward-compatibility lever (a future
- * v2 bumps to 0x02, v1 decoders see ERR_BAD_VERSION).
+ * CONNECT_RESP's is fixed at 4, DNS_QUERY's is 6 + name_len, and
+ * DNS_ANSWER's is 11 + count times the family's address size. QUIC streams
+ * are byte-oriented, so the decoders are prefix parsers that consume one
+ * frame and leave any trailing bytes for the next layer. No padding, no
+ * reserved bits in v1; the 1-byte version is the sole forward-compatibility
+ * lever (a future v2 bumps to 0x02, v1 decoders see ERR_BAD_VERSION).
  */
 
 #ifndef ODIN_PROTOCOL_H_
@@ -57,6 +84,20 @@ extern "C" {
 #define ODIN_PROTO_CONNECT_REQ_MAX (5 + ODIN_PROTO_HOST_MAX) /* 260 */
 #define ODIN_PROTO_CONNECT_RESP_SIZE 4
 
+#define ODIN_PROTO_FRAME_DNS_QUERY 0x03
+#define ODIN_PROTO_FRAME_DNS_ANSWER 0x04
+#define ODIN_PROTO_DNS_HOST "dns.odin.invalid"
+#define ODIN_PROTO_DNS_PORT 53
+#define ODIN_PROTO_DNS_FAMILY_V4 4
+#define ODIN_PROTO_DNS_FAMILY_V6 6
+#define ODIN_PROTO_DNS_RCODE_OK 0x00
+#define ODIN_PROTO_DNS_RCODE_FAIL 0x01
+#define ODIN_PROTO_DNS_ADDR_MAX 16
+#define ODIN_PROTO_DNS_QUERY_MAX (6 + ODIN_PROTO_HOST_MAX) /* 261 */
+#define ODIN_PROTO_DNS_ANSWER_HEADER_SIZE 11
+#define ODIN_PROTO_DNS_ANSWER_MAX                                             \
+  (ODIN_PROTO_DNS_ANSWER_HEADER_SIZE + ODIN_PROTO_DNS_ADDR_MAX * 16) /* 267 */
+
 typedef enum {
   ODIN_PROTO_OK = 0,
   ODIN_PROTO_NEED_MORE,
@@ -64,6 +105,8 @@ typedef enum {
   ODIN_PROTO_ERR_HOST_LEN_INVALID,
   ODIN_PROTO_ERR_BAD_VERSION,
   ODIN_PROTO_ERR_BAD_FRAME_TYPE,
+  ODIN_PROTO_ERR_BAD_FAMILY,
+  ODIN_PROTO_ERR_BAD_COUNT,
 } odin_proto_status_t;
 
 typedef struct {
@@ -100,6 +143,49 @@ odin_proto_status_t odin_proto_decode_connect_resp(const uint8_t *buf, size_t n,
                                                    size_t *out_consumed,
                                                    uint16_t *out_error_code);
 
+/* DNS frames (RFC-045) are small and batched, so they encode into a flat
+ * buffer rather than an iovec: each encoder writes one frame at out, sets
+ * *out_len, and returns ERR_BUF_TOO_SMALL (nothing written) when cap cannot
+ * hold it. addrs is count packed addresses of the family's size (4 or 16). */
+odin_proto_status_t odin_proto_encode_dns_query(uint16_t id, uint8_t family,
+                                                const char *name,
+                                                size_t name_len, uint8_t *out,
+                                                size_t cap, size_t *out_len);
+
+odin_proto_status_t odin_proto_encode_dns_answer(uint16_t id, uint8_t family,
+                                                 uint8_t rcode, uint32_t ttl,
+                                                 const uint8_t *addrs,
+                                                 size_t count, uint8_t *out,
+                                                 size_t cap, size_t *out_len);
+
+typedef struct {
+  uint16_t id;
+  uint8_t family;
+  size_t name_off;
+  size_t name_len;
+} odin_proto_dns_query_view_t;
+
+typedef struct {
+  uint16_t id;
+  uint8_t family;
+  uint8_t rcode;
+  uint32_t ttl;
+  size_t count;
+  size_t addrs_off; /* count packed addresses of odin_proto_dns_addr_len */
+} odin_proto_dns_answer_view_t;
+
+odin_proto_status_t
+odin_proto_decode_dns_query(const uint8_t *buf, size_t n, size_t *out_consumed,
+                            odin_proto_dns_query_view_t *out);
+
+odin_proto_status_t
+odin_proto_decode_dns_answer(const uint8_t *buf, size_t n,
+                             size_t *out_consumed,
+                             odin_proto_dns_answer_view_t *out);
+
+/* 4 for ODIN_PROTO_DNS_FAMILY_V4, 16 for _V6, else 0. */
+size_t odin_proto_dns_addr_len(uint8_t family);
+
 #ifdef __cplusplus
 }
 #endif
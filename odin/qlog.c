@@ -0,0 +1,777 @@
+/* odin/qlog.c -- RFC-050 sampled qlog output.
+ *
+ * The ring is a power-of-two byte array of variable-size entries with the
+ * same free-running head and tail as RFC-049's access-log ring. Each entry is
+ * a fixed header plus the raw event line, padded to 8 bytes; an entry that
+ * would straddle the end is preceded by a pad entry that fills the rest of
+ * the array, so every entry is contiguous. The writer does all escaping and
+ * framing, and owns the file: it writes the qlog header at the top of every
+ * new file and renames the chain of rotated files itself.
+ */
+
+#include "odin/qlog.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ODIN_QLOG_BATCH 65536u
+/* Longest framed record: every event byte may become \u00HH. */
+#define ODIN_QLOG_RECORD_MAX (ODIN_QLOG_EVENT_MAX * 6u + 512u)
+#define ODIN_QLOG_RING_MIN 65536u
+
+enum {
+  QLOG_PAD = 0,
+  QLOG_START = 1,
+  QLOG_EVENT = 2,
+  QLOG_END = 3,
+};
+
+typedef struct qlog_entry_t {
+  uint32_t size; /* bytes to the next entry, a multiple of 8 */
+  uint8_t kind;
+  uint8_t cid_len;
+  uint8_t forced;
+  uint8_t family; /* QLOG_START: 0, AF_INET, or AF_INET6 */
+  uint64_t wall_us;
+  int32_t importance;
+  uint16_t len; /* event bytes after the header */
+  uint16_t port;
+  uint8_t cid[ODIN_QLOG_CID_MAX];
+  uint8_t addr[16];
+} qlog_entry_t;
+
+typedef struct qlog_traced_t {
+  size_t hex_len;
+  char hex[ODIN_QLOG_CID_MAX * 2];
+} qlog_traced_t;
+
+struct odin_qlog_ring_t {
+  /* Loop side: the next byte to fill and the records refused. */
+  _Alignas(64) _Atomic uint64_t head;
+  _Atomic uint64_t dropped;
+  _Atomic int retired;
+  /* Writer side: the next byte to drain, on its own cache line. */
+  _Alignas(64) _Atomic uint64_t tail;
+  odin_qlog_ring_t *next; /* log->rings, under log->mu */
+  const odin_qlog_t *log; /* sampling config; read-only after create */
+  size_t mask;
+  uint8_t *buf;
+  /* Loop thread only. */
+  uint64_t seen;
+  size_t traced_count;
+  qlog_traced_t traced[ODIN_QLOG_CONN_MAX];
+};
+
+struct odin_qlog_t {
+  pthread_mutex_t mu;
+  pthread_cond_t cv;
+  pthread_t thread;
+  odin_qlog_ring_t *rings;  /* under mu */
+  int stopping;             /* under mu */
+  uint64_t written;         /* under mu */
+  uint64_t write_errors;    /* under mu */
+  uint64_t rotations;       /* under mu */
+  uint64_t retired_dropped; /* drops of rings already freed, under mu */
+  /* Set at create. */
+  char *path;
+  char *rotated; /* path plus room for ".<keep>" */
+  size_t rotated_cap;
+  uint64_t max_bytes;
+  uint32_t keep;
+  uint32_t sample_every;
+  uint32_t flush_ms;
+  odin_qlog_vantage_t vantage;
+  struct sockaddr_storage force;
+  socklen_t force_len;
+  /* Writer thread only. */
+  int fd;
+  uint64_t file_bytes;
+  size_t batch_len;
+  uint64_t batch_records;
+  char batch[ODIN_QLOG_BATCH];
+};
+
+static const char kHex[] = "0123456789abcdef";
+
+static uint64_t wall_us(void) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static size_t round8(size_t n) { return (n + 7u) & ~(size_t)7u; }
+
+/* Reserves need contiguous bytes, padding over the end of the array when it
+ * has to; returns NULL, and counts a drop, when the ring is full. */
+static uint8_t *ring_reserve(odin_qlog_ring_t *ring, size_t need,
+                             uint64_t *head_out) {
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  const uint64_t tail =
+      atomic_load_explicit(&ring->tail, memory_order_acquire);
+  const size_t cap = ring->mask + 1u;
+  const size_t pos = (size_t)(head & ring->mask);
+  const size_t room = cap - pos;
+  const size_t pad = room < need ? room : 0;
+  if ((size_t)(head - tail) + pad + need > cap) {
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+    return NULL;
+  }
+  if (pad != 0) {
+    qlog_entry_t *p = (qlog_entry_t *)(void *)(ring->buf + pos);
+    p->size = (uint32_t)pad;
+    p->kind = QLOG_PAD;
+    head += pad;
+  }
+  *head_out = head;
+  return ring->buf + (size_t)(head & ring->mask);
+}
+
+static void ring_publish(odin_qlog_ring_t *ring, uint64_t head, size_t size) {
+  atomic_store_explicit(&ring->head, head + size, memory_order_release);
+}
+
+static void push(odin_qlog_ring_t *ring, const qlog_entry_t *hdr,
+                 const char *line, size_t len) {
+  const size_t size = round8(sizeof(qlog_entry_t) + len);
+  uint64_t head = 0;
+  uint8_t *at = ring_reserve(ring, size, &head);
+  if (at == NULL) {
+    return;
+  }
+  qlog_entry_t *e = (qlog_entry_t *)(void *)at;
+  *e = *hdr;
+  e->size = (uint32_t)size;
+  e->len = (uint16_t)len;
+  if (len > 0) {
+    memcpy(at + sizeof(qlog_entry_t), line, len);
+  }
+  ring_publish(ring, head, size);
+}
+
+static void cid_hex(const uint8_t *cid, size_t len, char *out) {
+  for (size_t i = 0; i < len; ++i) {
+    out[2 * i] = kHex[cid[i] >> 4];
+    out[2 * i + 1] = kHex[cid[i] & 15];
+  }
+}
+
+static int addr_matches(const struct sockaddr_storage *want, socklen_t want_len,
+                        const struct sockaddr *peer, socklen_t peer_len) {
+  if (want_len == 0 || peer == NULL || peer->sa_family != want->ss_family) {
+    return 0;
+  }
+  if (peer->sa_family == AF_INET &&
+      peer_len >= (socklen_t)sizeof(struct sockaddr_in)) {
+    const struct sockaddr_in *w = (const struct sockaddr_in *)want;
+    const struct sockaddr_in *p = (const struct sockaddr_in *)peer;
+    return w->sin_addr.s_addr == p->sin_addr.s_addr &&
+           (w->sin_port == 0 || w->sin_port == p->sin_port);
+  }
+  if (peer->sa_family == AF_INET6 &&
+      peer_len >= (socklen_t)sizeof(struct sockaddr_in6)) {
+    const struct sockaddr_in6 *w = (const struct sockaddr_in6 *)want;
+    const struct sockaddr_in6 *p = (const struct sockaddr_in6 *)peer;
+    return memcmp(&w->sin6_addr, &p->sin6_addr, sizeof(p->sin6_addr)) == 0 &&
+           (w->sin6_port == 0 || w->sin6_port == p->sin6_port);
+  }
+  return 0;
+}
+
+static qlog_traced_t *find_traced(odin_qlog_ring_t *ring, const char *hex,
+                                  size_t hex_len) {
+  for (size_t i = 0; i < ring->traced_count; ++i) {
+    if (ring->traced[i].hex_len == hex_len &&
+        memcmp(ring->traced[i].hex, hex, hex_len) == 0) {
+      return &ring->traced[i];
+    }
+  }
+  return NULL;
+}
+
+int odin_qlog_conn_begin(odin_qlog_ring_t *ring, const uint8_t *cid,
+                         size_t cid_len, const struct sockaddr *peer,
+                         socklen_t peer_len) {
+  if (ring == NULL || cid == NULL || cid_len == 0 ||
+      cid_len > ODIN_QLOG_CID_MAX) {
+    return 0;
+  }
+  const odin_qlog_t *log = ring->log;
+  const int forced = addr_matches(&log->force, log->force_len, peer, peer_len);
+  if (!forced) {
+    if (log->sample_every == 0) {
+      return 0;
+    }
+    const uint64_t n = ring->seen++;
+    if (n % log->sample_every != 0) {
+      return 0;
+    }
+  }
+  char hex[ODIN_QLOG_CID_MAX * 2];
+  cid_hex(cid, cid_len, hex);
+  if (find_traced(ring, hex, cid_len * 2) != NULL) {
+    return 1;
+  }
+  if (ring->traced_count == ODIN_QLOG_CONN_MAX) {
+    return 0;
+  }
+  qlog_traced_t *t = &ring->traced[ring->traced_count++];
+  t->hex_len = cid_len * 2;
+  memcpy(t->hex, hex, t->hex_len);
+
+  qlog_entry_t e;
+  memset(&e, 0, sizeof(e));
+  e.kind = QLOG_START;
+  e.wall_us = wall_us();
+  e.forced = (uint8_t)forced;
+  e.cid_len = (uint8_t)cid_len;
+  memcpy(e.cid, cid, cid_len);
+  if (peer != NULL && peer->sa_family == AF_INET &&
+      peer_len >= (socklen_t)sizeof(struct sockaddr_in)) {
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)peer;
+    e.family = AF_INET;
+    e.port = ntohs(sin->sin_port);
+    memcpy(e.addr, &sin->sin_addr, sizeof(sin->sin_addr));
+  } else if (peer != NULL && peer->sa_family == AF_INET6 &&
+             peer_len >= (socklen_t)sizeof(struct sockaddr_in6)) {
+    const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)peer;
+    e.family = AF_INET6;
+    e.port = ntohs(sin6->sin6_port);
+    memcpy(e.addr, &sin6->sin6_addr, sizeof(sin6->sin6_addr));
+  }
+  push(ring, &e, NULL, 0);
+  return 1;
+}
+
+void odin_qlog_conn_end(odin_qlog_ring_t *ring, const uint8_t *cid,
+                        size_t cid_len) {
+  if (ring == NULL || cid == NULL || cid_len == 0 ||
+      cid_len > ODIN_QLOG_CID_MAX || ring->traced_count == 0) {
+    return;
+  }
+  char hex[ODIN_QLOG_CID_MAX * 2];
+  cid_hex(cid, cid_len, hex);
+  qlog_traced_t *t = find_traced(ring, hex, cid_len * 2);
+  if (t == NULL) {
+    return;
+  }
+  *t = ring->traced[--ring->traced_count];
+  qlog_entry_t e;
+  memset(&e, 0, sizeof(e));
+  e.kind = QLOG_END;
+  e.wall_us = wall_us();
+  e.cid_len = (uint8_t)cid_len;
+  memcpy(e.cid, cid, cid_len);
+  push(ring, &e, NULL, 0);
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void odin_qlog_event(odin_qlog_ring_t *ring, int importance, const char *line,
+                     size_t len) {
+  /* The common case: nothing on this loop is traced. */
+  if (ring == NULL || ring->traced_count == 0 || line == NULL) {
+    return;
+  }
+  static const char kKey[] = "scid:";
+  const size_t key_len = sizeof(kKey) - 1u;
+  size_t at = 0;
+  for (; at + key_len <= len; ++at) {
+    if (memcmp(line + at, kKey, key_len) == 0) {
+      break;
+    }
+  }
+  if (at + key_len > len) {
+    return;
+  }
+  at += key_len;
+  char hex[ODIN_QLOG_CID_MAX * 2];
+  size_t hex_len = 0;
+  while (at + hex_len < len && hex_value(line[at + hex_len]) >= 0) {
+    if (hex_len == sizeof(hex)) {
+      return;
+    }
+    const char c = line[at + hex_len];
+    hex[hex_len++] = (char)(c >= 'A' && c <= 'F' ? c - 'A' + 'a' : c);
+  }
+  if (hex_len == 0 || (hex_len & 1u) != 0 ||
+      find_traced(ring, hex, hex_len) == NULL) {
+    return;
+  }
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+    len -= 1;
+  }
+  if (len > ODIN_QLOG_EVENT_MAX) {
+    len = ODIN_QLOG_EVENT_MAX;
+  }
+  qlog_entry_t e;
+  memset(&e, 0, sizeof(e));
+  e.kind = QLOG_EVENT;
+  e.wall_us = wall_us();
+  e.importance = importance;
+  e.cid_len = (uint8_t)(hex_len / 2);
+  for (size_t i = 0; i < e.cid_len; ++i) {
+    e.cid[i] =
+        (uint8_t)((hex_value(hex[2 * i]) << 4) | hex_value(hex[2 * i + 1]));
+  }
+  push(ring, &e, line, len);
+}
+
+/* ---- writer ---- */
+
+static void put(odin_qlog_t *log, const char *s, size_t n) {
+  memcpy(log->batch + log->batch_len, s, n);
+  log->batch_len += n;
+}
+
+static void put_str(odin_qlog_t *log, const char *s) { put(log, s, strlen(s)); }
+
+static void put_fmt_u64(odin_qlog_t *log, uint64_t v) {
+  char tmp[24];
+  const int n = snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)v);
+  put(log, tmp, (size_t)n);
+}
+
+static void put_escaped(odin_qlog_t *log, const uint8_t *s, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t c = s[i];
+    if (c == '"' || c == '\\') {
+      const char esc[2] = {'\\', (char)c};
+      put(log, esc, sizeof(esc));
+    } else if (c < 0x20 || c >= 0x7f) {
+      const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15]};
+      put(log, esc, sizeof(esc));
+    } else {
+      put(log, (const char *)&c, 1);
+    }
+  }
+}
+
+static void format_entry(odin_qlog_t *log, const qlog_entry_t *e,
+                         const uint8_t *line) {
+  char tmp[64];
+  put_str(log, "\x1e{\"time\":");
+  put_fmt_u64(log, e->wall_us / 1000u);
+  const int n =
+      snprintf(tmp, sizeof(tmp), ".%03u", (unsigned)(e->wall_us % 1000u));
+  put(log, tmp, (size_t)n);
+  if (e->kind == QLOG_START) {
+    put_str(log, ",\"name\":\"connectivity:connection_started\"");
+  } else if (e->kind == QLOG_END) {
+    put_str(log, ",\"name\":\"connectivity:connection_closed\"");
+  } else {
+    put_str(log, ",\"name\":\"xquic:event\"");
+  }
+  put_str(log, ",\"group_id\":\"");
+  char hex[ODIN_QLOG_CID_MAX * 2];
+  cid_hex(e->cid, e->cid_len, hex);
+  put(log, hex, (size_t)e->cid_len * 2u);
+  put_str(log, "\",\"data\":{");
+  if (e->kind == QLOG_START) {
+    /* The peer is the source of a server's connection, the destination of a
+     * client's. */
+    const char *end = log->vantage == ODIN_QLOG_CLIENT ? "dst" : "src";
+    char ip[INET6_ADDRSTRLEN];
+    if (e->family != 0 && inet_ntop(e->family, e->addr, ip, sizeof(ip))) {
+      put_str(log, "\"");
+      put_str(log, end);
+      put_str(log, "_ip\":\"");
+      put_str(log, ip);
+      put_str(log, "\",\"");
+      put_str(log, end);
+      put_str(log, "_port\":");
+      put_fmt_u64(log, e->port);
+      put_str(log, ",");
+    }
+    put_str(log, "\"trigger\":");
+    put_str(log, e->forced ? "\"forced\"" : "\"sampled\"");
+  } else if (e->kind == QLOG_EVENT) {
+    const int m = snprintf(tmp, sizeof(tmp), "\"importance\":%d,\"line\":\"",
+                           (int)e->importance);
+    put(log, tmp, (size_t)m);
+    put_escaped(log, line, e->len);
+    put_str(log, "\"");
+  }
+  put_str(log, "}}\n");
+}
+
+static size_t header(const odin_qlog_t *log, char *buf, size_t cap) {
+  const int n = snprintf(
+      buf, cap,
+      "\x1e{\"qlog_version\":\"0.3\",\"qlog_format\":\"JSON-SEQ\","
+      "\"title\":\"odin\",\"trace\":{\"vantage_point\":{\"type\":\"%s\"},"
+      "\"common_fields\":{\"time_format\":\"absolute\"}}}\n",
+      log->vantage == ODIN_QLOG_CLIENT ? "client" : "server");
+  return n > 0 ? (size_t)n : 0;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+  size_t off = 0;
+  while (off < len) {
+    const ssize_t n = write(fd, buf + off, len - off);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    off += (size_t)n;
+  }
+  return 0;
+}
+
+/* Writer thread, mu released. Moves path.i to path.i+1 for i = keep-1..1,
+ * path to path.1, and starts a fresh path. */
+static int rotate(odin_qlog_t *log) {
+  if (log->fd >= 0) {
+    close(log->fd);
+    log->fd = -1;
+  }
+  char *from = (char *)malloc(log->rotated_cap);
+  if (from == NULL) {
+    return -1;
+  }
+  for (uint32_t i = log->keep; i > 1; --i) {
+    (void)snprintf(from, log->rotated_cap, "%s.%u", log->path, i - 1u);
+    (void)snprintf(log->rotated, log->rotated_cap, "%s.%u", log->path, i);
+    (void)rename(from, log->rotated);
+  }
+  free(from);
+  (void)snprintf(log->rotated, log->rotated_cap, "%s.1", log->path);
+  (void)rename(log->path, log->rotated);
+  log->fd = open(log->path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                 0644);
+  log->file_bytes = 0;
+  return log->fd >= 0 ? 0 : -1;
+}
+
+/* Writes the batch with log->mu released; called and returns with it held. */
+static void flush_batch(odin_qlog_t *log) {
+  if (log->batch_len == 0) {
+    return;
+  }
+  pthread_mutex_unlock(&log->mu);
+  if (log->fd < 0) {
+    /* A failed rotation left no file; try again. */
+    log->fd = open(log->path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    log->file_bytes = 0;
+  }
+  int failed = log->fd < 0;
+  if (!failed && log->file_bytes == 0) {
+    char head[256];
+    const size_t n = header(log, head, sizeof(head));
+    failed = write_all(log->fd, head, n) != 0;
+    log->file_bytes += failed ? 0 : n;
+  }
+  if (!failed) {
+    failed = write_all(log->fd, log->batch, log->batch_len) != 0;
+    log->file_bytes += failed ? 0 : log->batch_len;
+  }
+  int rotated = 0;
+  if (log->file_bytes >= log->max_bytes) {
+    (void)rotate(log);
+    rotated = 1;
+  }
+  pthread_mutex_lock(&log->mu);
+  if (failed) {
+    log->write_errors += log->batch_records;
+  } else {
+    log->written += log->batch_records;
+  }
+  log->rotations += (uint64_t)rotated;
+  log->batch_len = 0;
+  log->batch_records = 0;
+}
+
+static void drain_ring(odin_qlog_t *log, odin_qlog_ring_t *ring) {
+  uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  const uint64_t head =
+      atomic_load_explicit(&ring->head, memory_order_acquire);
+  while (tail != head) {
+    const uint8_t *at = ring->buf + (size_t)(tail & ring->mask);
+    const qlog_entry_t *e = (const qlog_entry_t *)(const void *)at;
+    if (e->kind != QLOG_PAD) {
+      if (sizeof(log->batch) - log->batch_len < ODIN_QLOG_RECORD_MAX) {
+        flush_batch(log);
+      }
+      format_entry(log, e, at + sizeof(qlog_entry_t));
+      log->batch_records += 1;
+    }
+    tail += e->size;
+  }
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
+
+static void unlink_ring(odin_qlog_t *log, odin_qlog_ring_t *ring) {
+  for (odin_qlog_ring_t **pp = &log->rings; *pp != NULL; pp = &(*pp)->next) {
+    if (*pp == ring) {
+      *pp = ring->next;
+      return;
+    }
+  }
+}
+
+static void free_ring(odin_qlog_ring_t *ring) {
+  free(ring->buf);
+  free(ring);
+}
+
+/* Drains every ring and frees the retired ones (RFC-049 §3.2.3). */
+static void drain_all(odin_qlog_t *log) {
+  odin_qlog_ring_t **pp = &log->rings;
+  while (*pp != NULL) {
+    odin_qlog_ring_t *ring = *pp;
+    const int retired =
+        atomic_load_explicit(&ring->retired, memory_order_acquire);
+    drain_ring(log, ring);
+    if (!retired) {
+      pp = &ring->next;
+      continue;
+    }
+    unlink_ring(log, ring);
+    log->retired_dropped +=
+        atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    free_ring(ring);
+  }
+}
+
+static void *writer_main(void *arg) {
+  odin_qlog_t *log = (odin_qlog_t *)arg;
+  pthread_mutex_lock(&log->mu);
+  for (;;) {
+    if (!log->stopping) {
+      struct timespec deadline;
+      (void)clock_gettime(CLOCK_REALTIME, &deadline);
+      const uint64_t ns =
+          (uint64_t)deadline.tv_nsec + (uint64_t)log->flush_ms * 1000000u;
+      deadline.tv_sec += (time_t)(ns / 1000000000u);
+      deadline.tv_nsec = (long)(ns % 1000000000u);
+      (void)pthread_cond_timedwait(&log->cv, &log->mu, &deadline);
+    }
+    const int stopping = log->stopping;
+    drain_all(log);
+    flush_batch(log);
+    if (stopping) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&log->mu);
+  return NULL;
+}
+
+static void free_log(odin_qlog_t *log) {
+  if (log->fd >= 0) {
+    close(log->fd);
+  }
+  free(log->rotated);
+  free(log->path);
+  free(log);
+}
+
+int odin_qlog_create(const odin_qlog_config_t *config, odin_qlog_t **out) {
+  if (config == NULL || out == NULL || config->path == NULL ||
+      config->path[0] == '\0' ||
+      (config->vantage != ODIN_QLOG_SERVER &&
+       config->vantage != ODIN_QLOG_CLIENT) ||
+      (config->force_addr != NULL &&
+       (config->force_addr_len == 0 ||
+        config->force_addr_len > (socklen_t)sizeof(struct sockaddr_storage)))) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_qlog_t *log = (odin_qlog_t *)malloc(sizeof(*log));
+  if (log == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(log, 0, offsetof(odin_qlog_t, batch));
+  log->fd = -1;
+  log->max_bytes =
+      config->max_bytes != 0 ? config->max_bytes : ODIN_QLOG_DEFAULT_MAX_BYTES;
+  log->keep = config->keep != 0 ? config->keep : ODIN_QLOG_DEFAULT_KEEP;
+  log->sample_every = config->sample_every;
+  log->flush_ms =
+      config->flush_ms != 0 ? config->flush_ms : ODIN_QLOG_DEFAULT_FLUSH_MS;
+  log->vantage = config->vantage;
+  if (config->force_addr != NULL) {
+    memcpy(&log->force, config->force_addr, config->force_addr_len);
+    log->force_len = config->force_addr_len;
+  }
+  const size_t path_len = strlen(config->path);
+  log->path = (char *)malloc(path_len + 1u);
+  log->rotated_cap = path_len + 16u;
+  log->rotated = (char *)malloc(log->rotated_cap);
+  if (log->path == NULL || log->rotated == NULL) {
+    free_log(log);
+    errno = ENOMEM;
+    return -1;
+  }
+  memcpy(log->path, config->path, path_len + 1u);
+  log->fd = open(log->path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  struct stat st;
+  if (log->fd < 0 || fstat(log->fd, &st) != 0) {
+    const int saved = errno;
+    free_log(log);
+    errno = saved;
+    return -1;
+  }
+  log->file_bytes = (uint64_t)st.st_size;
+  if (pthread_mutex_init(&log->mu, NULL) != 0) {
+    free_log(log);
+    errno = ENOMEM;
+    return -1;
+  }
+  if (pthread_cond_init(&log->cv, NULL) != 0) {
+    pthread_mutex_destroy(&log->mu);
+    free_log(log);
+    errno = ENOMEM;
+    return -1;
+  }
+  /* The writer never handles a signal; the loops own them. */
+  sigset_t all;
+  sigset_t old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  const int rc = pthread_create(&log->thread, NULL, writer_main, log);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (rc != 0) {
+    pthread_cond_destroy(&log->cv);
+    pthread_mutex_destroy(&log->mu);
+    free_log(log);
+    errno = rc;
+    return -1;
+  }
+  *out = log;
+  return 0;
+}
+
+int odin_qlog_parse_ip(const char *ip, struct sockaddr_storage *out,
+                       socklen_t *out_len) {
+  if (ip == NULL || out == NULL || out_len == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  memset(out, 0, sizeof(*out));
+  struct sockaddr_in *sin = (struct sockaddr_in *)out;
+  if (inet_pton(AF_INET, ip, &sin->sin_addr) == 1) {
+    sin->sin_family = AF_INET;
+    *out_len = (socklen_t)sizeof(*sin);
+    return 0;
+  }
+  struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)out;
+  if (inet_pton(AF_INET6, ip, &sin6->sin6_addr) == 1) {
+    sin6->sin6_family = AF_INET6;
+    *out_len = (socklen_t)sizeof(*sin6);
+    return 0;
+  }
+  errno = EINVAL;
+  return -1;
+}
+
+void odin_qlog_stats(odin_qlog_t *log, odin_qlog_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  if (log == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&log->mu);
+  out->written = log->written;
+  out->write_errors = log->write_errors;
+  out->rotations = log->rotations;
+  out->dropped = log->retired_dropped;
+  for (odin_qlog_ring_t *r = log->rings; r != NULL; r = r->next) {
+    out->dropped += atomic_load_explicit(&r->dropped, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&log->mu);
+}
+
+void odin_qlog_destroy(odin_qlog_t *log) {
+  if (log == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&log->mu);
+  log->stopping = 1;
+  pthread_cond_signal(&log->cv);
+  pthread_mutex_unlock(&log->mu);
+  pthread_join(log->thread, NULL);
+  while (log->rings != NULL) {
+    odin_qlog_ring_t *ring = log->rings;
+    log->rings = ring->next;
+    free_ring(ring);
+  }
+  pthread_cond_destroy(&log->cv);
+  pthread_mutex_destroy(&log->mu);
+  free_log(log);
+}
+
+int odin_qlog_ring_create(odin_qlog_t *log, size_t capacity,
+                          odin_qlog_ring_t **out) {
+  if (log == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (capacity == 0) {
+    capacity = ODIN_QLOG_DEFAULT_RING;
+  }
+  size_t bytes = ODIN_QLOG_RING_MIN;
+  while (bytes < capacity) {
+    if (bytes > SIZE_MAX / 2u) {
+      errno = EINVAL;
+      return -1;
+    }
+    bytes <<= 1;
+  }
+  odin_qlog_ring_t *ring = NULL;
+  if (posix_memalign((void **)&ring, _Alignof(odin_qlog_ring_t),
+                     sizeof(*ring)) != 0) {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(ring, 0, sizeof(*ring));
+  ring->buf = (uint8_t *)malloc(bytes);
+  if (ring->buf == NULL) {
+    free(ring);
+    errno = ENOMEM;
+    return -1;
+  }
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->dropped, 0);
+  atomic_init(&ring->retired, 0);
+  ring->mask = bytes - 1u;
+  ring->log = log;
+  pthread_mutex_lock(&log->mu);
+  ring->next = log->rings;
+  log->rings = ring;
+  pthread_mutex_unlock(&log->mu);
+  *out = ring;
+  return 0;
+}
+
+void odin_qlog_ring_destroy(odin_qlog_ring_t *ring) {
+  if (ring == NULL) {
+    return;
+  }
+  atomic_store_explicit(&ring->retired, 1, memory_order_release);
+}
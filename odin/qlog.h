@@ -0,0 +1,105 @@
+/* odin/qlog.h
+ *
+ * Sampled qlog output for QUIC connections (RFC-050).
+ *
+ * One odin_qlog_t owns a writer thread and a size-rotated JSON-SEQ file
+ * (RFC 7464: each record is 0x1e, a JSON object, and a newline). Each QUIC
+ * runtime creates one odin_qlog_ring_t for its loop and hands it to its
+ * odin_xqc_udp_t, which turns on xquic's event log and passes every event
+ * line to odin_qlog_event.
+ *
+ * The runtime calls odin_qlog_conn_begin as a connection is created. It
+ * decides once whether that connection is traced: always when the peer
+ * matches force_addr, otherwise one connection in sample_every. Events are
+ * matched to traced connections by the "scid:" field xquic prints in each
+ * line. A traced connection's events are copied, raw, into the ring without a
+ * lock, an allocation, or a system call; everything else is discarded on the
+ * loop thread. The writer escapes and frames the records, writes them in
+ * batches, and rotates path to path.1 .. path.<keep> once the file reaches
+ * max_bytes.
+ *
+ * Threading and lifetime follow RFC-049's access log: create and destroy the
+ * log on its owner thread; a ring is used and destroyed only by its loop
+ * thread; destroy the rings before the log. int-returning functions return
+ * 0, or -1 with errno set.
+ */
+
+#ifndef ODIN_QLOG_H_
+#define ODIN_QLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_QLOG_DEFAULT_MAX_BYTES (64u * 1024u * 1024u)
+#define ODIN_QLOG_DEFAULT_KEEP 4u
+#define ODIN_QLOG_DEFAULT_RING (1024u * 1024u)
+#define ODIN_QLOG_DEFAULT_FLUSH_MS 100u
+/* Longer event lines are truncated. */
+#define ODIN_QLOG_EVENT_MAX 2048u
+/* Connections traced at once per ring; more are not sampled. */
+#define ODIN_QLOG_CONN_MAX 32u
+#define ODIN_QLOG_CID_MAX 20u
+
+typedef struct odin_qlog_t odin_qlog_t;
+typedef struct odin_qlog_ring_t odin_qlog_ring_t;
+
+typedef enum odin_qlog_vantage_t {
+  ODIN_QLOG_SERVER = 0,
+  ODIN_QLOG_CLIENT = 1,
+} odin_qlog_vantage_t;
+
+typedef struct odin_qlog_config_t {
+  const char *path;      /* opened O_APPEND; rotated by the writer */
+  uint64_t max_bytes;    /* 0: ODIN_QLOG_DEFAULT_MAX_BYTES */
+  uint32_t keep;         /* rotated files kept; 0: ODIN_QLOG_DEFAULT_KEEP */
+  uint32_t sample_every; /* trace 1 in N connections; 0: forced only */
+  /* Connections whose peer has this address are always traced; a port of
+   * 0 matches any port. NULL forces none. Copied. */
+  const struct sockaddr *force_addr;
+  socklen_t force_addr_len;
+  odin_qlog_vantage_t vantage;
+  uint32_t flush_ms; /* 0: ODIN_QLOG_DEFAULT_FLUSH_MS */
+} odin_qlog_config_t;
+
+typedef struct odin_qlog_stats_t {
+  uint64_t written;      /* records written */
+  uint64_t dropped;      /* records refused by a full ring */
+  uint64_t write_errors; /* records lost to a failed write */
+  uint64_t rotations;
+} odin_qlog_stats_t;
+
+int odin_qlog_create(const odin_qlog_config_t *config, odin_qlog_t **out);
+/* Packs a numeric IPv4 or IPv6 address, with port 0, for force_addr; fails
+ * with EINVAL for anything else. */
+int odin_qlog_parse_ip(const char *ip, struct sockaddr_storage *out,
+                       socklen_t *out_len);
+void odin_qlog_stats(odin_qlog_t *log, odin_qlog_stats_t *out);
+void odin_qlog_destroy(odin_qlog_t *log);
+
+/* capacity is in bytes, rounded up to a power of two of at least 64 KiB; 0
+ * takes ODIN_QLOG_DEFAULT_RING. */
+int odin_qlog_ring_create(odin_qlog_t *log, size_t capacity,
+                          odin_qlog_ring_t **out);
+void odin_qlog_ring_destroy(odin_qlog_ring_t *ring);
+
+/* Loop thread. begin returns 1 when the connection is traced, else 0; end
+ * stops tracing it. cid is the connection's source CID as xquic prints it. */
+int odin_qlog_conn_begin(odin_qlog_ring_t *ring, const uint8_t *cid,
+                         size_t cid_len, const struct sockaddr *peer,
+                         socklen_t peer_len);
+void odin_qlog_conn_end(odin_qlog_ring_t *ring, const uint8_t *cid,
+                        size_t cid_len);
+/* One xquic event line; importance is xquic's qlog_event_importance_t. */
+void odin_qlog_event(odin_qlog_ring_t *ring, int importance, const char *line,
+                     size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_QLOG_H_ */
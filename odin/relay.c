@@ -1,14 +1,24 @@
-/* odin/relay.c -- RFC-014 transport-agnostic bidirectional byte relay.
+/* odin/relay.c -- RFC-014 bidirectional byte relay with RFC-034 fast paths.
  *
  * Forwards bytes between two caller-owned odin_transport_t endpoints (RFC-013)
- * through the odin_transport_* dispatchers: every read, write, half-close,
- * readiness/interest change, and asynchronous-error probe goes through the
- * vtable, so the relay names no concrete transport and carries none of a
- * transport's dependencies. It provides fixed 64 KiB
- * per-direction backpressure buffering, end-of-stream-as-shutdown_write
- * propagation, single-error aggregation, and exactly-once completion. It owns
- * its object and its two buffers only: it destroys neither transport and closes
- * no fd.
+ * with fixed 64 KiB per-direction backpressure buffering,
+ * end-of-stream-as-shutdown_write propagation, single-error aggregation, and
+ * exactly-once completion. It owns its object and its two buffers only: it
+ * destroys neither transport and closes no fd.
+ *
+ * Each endpoint's I/O path is fixed at start by vtable identity. An fd or xqc
+ * stream transport is read and written through its direct entry points
+ * (odin_fd_transport_read/_write, odin_xqc_stream_transport_read/_write), and
+ * a relay with either such endpoint runs in pump mode: one readiness loops
+ * read -> write until the source would block, the sink would block, or a
+ * per-readiness byte budget is spent. Any other transport goes through the
+ * odin_transport_* dispatchers, and a relay between two of them keeps the
+ * RFC-014 one-read-per-readiness path. Half-close, interest changes, and the
+ * asynchronous-error probe always use the dispatchers.
+ *
+ * Naming the direct entry points makes the relay depend on
+ * //odin:odin_transport_fd and //odin:odin_transport_xqc, and through the
+ * latter on xquic's headers; the relay itself calls no xquic API.
  */
 
 #include "odin/relay.h"
@@ -16,11 +26,18 @@
 #include <errno.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "odin/trace.h"
 #include "odin/transport.h"
+#include "odin/transport_fd.h"
+#include "odin/transport_xqc.h"
 
 /* Fixed per-direction buffer capacity: 64 KiB (§3.2.2 CAP). */
-#define ODIN_RELAY_CAP 65536u
+#define ODIN_RELAY_CAP ODIN_RELAY_BUFFER_SIZE
+
+/* Bytes one pump-mode readiness may read before yielding the loop (§3.2.3). */
+#define ODIN_RELAY_PUMP_BUDGET (4u * ODIN_RELAY_CAP)
 
 /* Direction indices: A = a -> b, B = b -> a. */
 #define ODIN_RELAY_DIR_A 0
@@ -34,6 +51,13 @@ enum {
   ODIN_RELAY_OUTCOME_ERROR,
 };
 
+/* How a direction reaches an endpoint (RFC-034), fixed at start. */
+enum {
+  ODIN_RELAY_IO_VTABLE = 0, /* odin_transport_* dispatchers */
+  ODIN_RELAY_IO_FD,         /* odin_fd_transport_read/_write */
+  ODIN_RELAY_IO_XQC,        /* odin_xqc_stream_transport_read/_write */
+};
+
 /* do_read result classification. */
 enum {
   ODIN_RELAY_READ_AGAIN = 0,
@@ -52,6 +76,10 @@ typedef struct {
   size_t len;
   int read_eof;
   int write_shut;
+  int src_io;  /* ODIN_RELAY_IO_*: how src_t is read (RFC-034) */
+  int sink_io; /* ODIN_RELAY_IO_*: how sink_t is written       */
+  /* Bytes the sink accepted: odin_relay_bytes and the RFC-048 probes. */
+  uint64_t moved;
 } odin_relay_dir_t;
 
 /* One watched endpoint: sources one direction, sinks the other. cur is the last
@@ -73,9 +101,19 @@ struct odin_relay_t {
   int torn_down;
   int active_depth;
   int destroy_pending;
+  int embedded; /* caller storage: object and buffers are not freed */
+  int pump;     /* RFC-034 pump mode: an endpoint has direct I/O */
 };
 
+_Static_assert(sizeof(odin_relay_t) <= ODIN_RELAY_STATE_SIZE,
+               "ODIN_RELAY_STATE_SIZE too small");
+_Static_assert(_Alignof(odin_relay_t) <= _Alignof(odin_relay_storage_t),
+               "odin_relay_storage_t under-aligned");
+
 static void free_relay(odin_relay_t *r) {
+  if (r->embedded) {
+    return;
+  }
   free(r->dir[ODIN_RELAY_DIR_A].buf);
   free(r->dir[ODIN_RELAY_DIR_B].buf);
   free(r);
@@ -101,7 +139,19 @@ static int do_read(odin_relay_t *r, odin_relay_dir_t *d) {
     run = ODIN_RELAY_CAP - tail;
   }
   size_t n = 0;
-  switch (odin_transport_read(d->src_t, d->buf + tail, run, &n)) {
+  odin_transport_io_t io;
+  switch (d->src_io) {
+  case ODIN_RELAY_IO_FD:
+    io = odin_fd_transport_read(d->src_t, d->buf + tail, run, &n);
+    break;
+  case ODIN_RELAY_IO_XQC:
+    io = odin_xqc_stream_transport_read(d->src_t, d->buf + tail, run, &n);
+    break;
+  default:
+    io = odin_transport_read(d->src_t, d->buf + tail, run, &n);
+    break;
+  }
+  switch (io) {
   case ODIN_TRANSPORT_OK:
     d->len += n;
     return ODIN_RELAY_READ_PROGRESS;
@@ -119,26 +169,73 @@ static int do_read(odin_relay_t *r, odin_relay_dir_t *d) {
 }
 
 /* Drains d's contiguous buffered run at head (min(len, CAP-head)). write never
- * returns EOF (RFC-013), so any non-OK/AGAIN result is a genuine fault. */
-static void do_write(odin_relay_t *r, odin_relay_dir_t *d) {
+ * returns EOF (RFC-013), so any non-OK/AGAIN result is a genuine fault. Returns
+ * 1 when the whole run was accepted, 0 when the sink took less (or failed). */
+static int do_write(odin_relay_t *r, odin_relay_dir_t *d) {
   size_t run = d->len;
   if (run > ODIN_RELAY_CAP - d->head) {
     run = ODIN_RELAY_CAP - d->head;
   }
   size_t n = 0;
-  switch (odin_transport_write(d->sink_t, d->buf + d->head, run, &n)) {
+  const unsigned char *p = d->buf + d->head;
+  odin_transport_io_t io;
+  switch (d->sink_io) {
+  case ODIN_RELAY_IO_FD:
+    io = odin_fd_transport_write(d->sink_t, p, run, &n);
+    break;
+  case ODIN_RELAY_IO_XQC:
+    io = odin_xqc_stream_transport_write(d->sink_t, p, run, &n);
+    break;
+  default:
+    io = odin_transport_write(d->sink_t, p, run, &n);
+    break;
+  }
+  switch (io) {
   case ODIN_TRANSPORT_OK:
     d->head = (d->head + n) % ODIN_RELAY_CAP;
     d->len -= n;
-    return;
+    d->moved += n;
+    return n == run;
   case ODIN_TRANSPORT_AGAIN:
-    return;
+    return 0;
   case ODIN_TRANSPORT_EOF:
   case ODIN_TRANSPORT_IO_ERROR:
     break;
   }
   r->outcome = ODIN_RELAY_OUTCOME_ERROR;
   r->err = errno;
+  return 0;
+}
+
+/* Pump mode: writes d's buffered bytes until it is empty or the sink stops
+ * accepting a whole run. Returns 1 when d drained. */
+static int pump_flush(odin_relay_t *r, odin_relay_dir_t *d) {
+  while (r->outcome == ODIN_RELAY_OUTCOME_NONE && d->len > 0) {
+    if (!do_write(r, d)) {
+      return 0;
+    }
+  }
+  return d->len == 0;
+}
+
+/* Pump mode: read -> flush until the source would block or ends, the ring is
+ * still full after a flush (sink blocked), or ODIN_RELAY_PUMP_BUDGET bytes have
+ * been read. Returns 1 when any read made progress. */
+static int pump_fill(odin_relay_t *r, odin_relay_dir_t *d) {
+  size_t budget = ODIN_RELAY_PUMP_BUDGET;
+  int progress = 0;
+  while (r->outcome == ODIN_RELAY_OUTCOME_NONE && d->read_eof == 0 &&
+         d->len < ODIN_RELAY_CAP && budget > 0) {
+    const size_t before = d->len;
+    if (do_read(r, d) != ODIN_RELAY_READ_PROGRESS) {
+      break;
+    }
+    progress = 1;
+    const size_t got = d->len - before;
+    budget = (got < budget) ? budget - got : 0;
+    (void)pump_flush(r, d);
+  }
+  return progress;
 }
 
 /* Recomputes one endpoint's interest: READ while its source can still fill
@@ -229,6 +326,8 @@ static void teardown(odin_relay_t *r) {
   const odin_relay_status_t st =
       (r->outcome == ODIN_RELAY_OUTCOME_OK) ? ODIN_RELAY_OK : ODIN_RELAY_ERROR;
   const int e = (st == ODIN_RELAY_OK) ? 0 : r->err;
+  ODIN_TRACE4(relay__done, r, e, r->dir[ODIN_RELAY_DIR_A].moved,
+              r->dir[ODIN_RELAY_DIR_B].moved);
   cb(r, st, e, ud);
 }
 
@@ -258,13 +357,64 @@ int odin_relay_create(odin_relay_done_cb on_done, void *user_data,
   return 0;
 }
 
+void odin_relay_create_in(odin_relay_storage_t *storage,
+                          odin_relay_done_cb on_done, void *user_data,
+                          odin_relay_t **out) {
+  odin_relay_t *r = (odin_relay_t *)(void *)&storage->state;
+  memset(r, 0, sizeof(*r));
+  r->dir[ODIN_RELAY_DIR_A].buf = storage->buf[ODIN_RELAY_DIR_A];
+  r->dir[ODIN_RELAY_DIR_B].buf = storage->buf[ODIN_RELAY_DIR_B];
+  r->on_done = on_done;
+  r->user_data = user_data;
+  r->outcome = ODIN_RELAY_OUTCOME_NONE;
+  r->embedded = 1;
+  *out = r;
+}
+
+/* Pump-mode readiness handler body (RFC-034 §3.2.3): a writable endpoint
+ * flushes the direction it sinks and, if that direction had filled the ring
+ * (so its source was throttled) and is now empty, refills it at once; a
+ * readable endpoint pumps the direction it sources straight through to the
+ * peer. Returns 1 when a read made progress, for the ERROR-readiness probe. */
+static int pump_ready(odin_relay_t *r, odin_relay_end_t *e,
+                      unsigned int events) {
+  const int err = (events & ODIN_TRANSPORT_ERROR) != 0;
+  int progress = 0;
+  if (r->outcome == ODIN_RELAY_OUTCOME_NONE && e->sink->len > 0 &&
+      ((events & ODIN_TRANSPORT_WRITE) || err)) {
+    const int was_full = e->sink->len == ODIN_RELAY_CAP;
+    if (pump_flush(r, e->sink) && was_full) {
+      (void)pump_fill(r, e->sink);
+    }
+  }
+  if ((events & ODIN_TRANSPORT_READ) || err) {
+    progress = pump_fill(r, e->src);
+  }
+  return progress;
+}
+
+/* The bound endpoint t is, or NULL for a transport this relay never bound
+ * (including any readiness before start, when neither end is bound). */
+static odin_relay_end_t *end_of(odin_relay_t *r, const odin_transport_t *t) {
+  if (t == NULL) {
+    return NULL;
+  }
+  if (t == r->end[0].t) {
+    return &r->end[0];
+  }
+  if (t == r->end[1].t) {
+    return &r->end[1];
+  }
+  return NULL;
+}
+
 /* Readiness handler: flush the ready endpoint's sink, drain its source,
  * classify an ODIN_TRANSPORT_ERROR readiness via do_read/odin_transport_error,
  * then drive; teardown when an outcome is set. Skips every sub-step once
- * outcome
- * != NONE (so a same-batch sibling that still re-enters becomes a no-op).
- * sink->sink_t == t and src->src_t == t by construction, so both ops act on the
- * endpoint that fired. */
+ * outcome != NONE (so a same-batch sibling that still re-enters becomes a
+ * no-op). sink->sink_t == t and src->src_t == t by construction, so both ops
+ * act on the endpoint that fired. In pump mode pump_ready replaces the single
+ * write and read. */
 void odin_relay_ready(odin_transport_t *t, unsigned int events,
                       void *user_data) {
   odin_relay_t *r = (odin_relay_t *)user_data;
@@ -273,20 +423,29 @@ void odin_relay_ready(odin_transport_t *t, unsigned int events,
     (void)relay_leave(r);
     return;
   }
-  odin_relay_end_t *e = (t == r->end[0].t) ? &r->end[0] : &r->end[1];
+  odin_relay_end_t *e = end_of(r, t);
+  if (e == NULL) {
+    (void)relay_leave(r);
+    return;
+  }
   odin_relay_dir_t *src = e->src;
   odin_relay_dir_t *sink = e->sink;
   const int err = (events & ODIN_TRANSPORT_ERROR) != 0;
 
-  if (r->outcome == ODIN_RELAY_OUTCOME_NONE && sink->len > 0 &&
-      ((events & ODIN_TRANSPORT_WRITE) || err)) {
-    do_write(r, sink);
-  }
-
   int rd = ODIN_RELAY_READ_AGAIN;
-  if (r->outcome == ODIN_RELAY_OUTCOME_NONE && src->read_eof == 0 &&
-      src->len < ODIN_RELAY_CAP && ((events & ODIN_TRANSPORT_READ) || err)) {
-    rd = do_read(r, src);
+  if (r->pump) {
+    if (pump_ready(r, e, events)) {
+      rd = ODIN_RELAY_READ_PROGRESS;
+    }
+  } else {
+    if (r->outcome == ODIN_RELAY_OUTCOME_NONE && sink->len > 0 &&
+        ((events & ODIN_TRANSPORT_WRITE) || err)) {
+      (void)do_write(r, sink);
+    }
+    if (r->outcome == ODIN_RELAY_OUTCOME_NONE && src->read_eof == 0 &&
+        src->len < ODIN_RELAY_CAP && ((events & ODIN_TRANSPORT_READ) || err)) {
+      rd = do_read(r, src);
+    }
   }
 
   if (r->outcome == ODIN_RELAY_OUTCOME_NONE && err && src->read_eof == 0 &&
@@ -308,6 +467,16 @@ void odin_relay_ready(odin_transport_t *t, unsigned int events,
   (void)relay_leave(r);
 }
 
+static int endpoint_io(const odin_transport_t *t) {
+  if (odin_fd_transport_is(t)) {
+    return ODIN_RELAY_IO_FD;
+  }
+  if (odin_xqc_stream_transport_is(t)) {
+    return ODIN_RELAY_IO_XQC;
+  }
+  return ODIN_RELAY_IO_VTABLE;
+}
+
 int odin_relay_start(odin_relay_t *relay, odin_transport_t *a,
                      odin_transport_t *b) {
   /* dir A: a -> b; dir B: b -> a. */
@@ -316,6 +485,15 @@ int odin_relay_start(odin_relay_t *relay, odin_transport_t *a,
   relay->dir[ODIN_RELAY_DIR_B].src_t = b;
   relay->dir[ODIN_RELAY_DIR_B].sink_t = a;
 
+  /* RFC-034: specialize on fd and xqc endpoints by vtable identity. */
+  const int a_io = endpoint_io(a);
+  const int b_io = endpoint_io(b);
+  relay->dir[ODIN_RELAY_DIR_A].src_io = a_io;
+  relay->dir[ODIN_RELAY_DIR_A].sink_io = b_io;
+  relay->dir[ODIN_RELAY_DIR_B].src_io = b_io;
+  relay->dir[ODIN_RELAY_DIR_B].sink_io = a_io;
+  relay->pump = a_io != ODIN_RELAY_IO_VTABLE || b_io != ODIN_RELAY_IO_VTABLE;
+
   /* end[0] = a sources A, sinks B; end[1] = b sources B, sinks A. */
   relay->end[0].t = a;
   relay->end[0].src = &relay->dir[ODIN_RELAY_DIR_A];
@@ -337,9 +515,20 @@ int odin_relay_start(odin_relay_t *relay, odin_transport_t *a,
     return -1;
   }
   relay->end[1].cur = ODIN_TRANSPORT_READ;
+  ODIN_TRACE2(relay__start, relay, relay->pump);
   return 0;
 }
 
+void odin_relay_bytes(const odin_relay_t *relay, uint64_t *a_to_b,
+                      uint64_t *b_to_a) {
+  if (a_to_b != NULL) {
+    *a_to_b = relay->dir[ODIN_RELAY_DIR_A].moved;
+  }
+  if (b_to_a != NULL) {
+    *b_to_a = relay->dir[ODIN_RELAY_DIR_B].moved;
+  }
+}
+
 void odin_relay_destroy(odin_relay_t *relay) {
   if (relay == NULL) {
     return;
@@ -7,8 +7,16 @@
  * the odin_transport_* dispatchers instead of raw fds and odin_event_io_*. It
  * provides fixed 64 KiB per-direction backpressure buffering,
  * end-of-stream-as-shutdown_write propagation, single-error aggregation, and
- * exactly-once completion. It depends only on odin/transport.h: it issues no
- * syscalls and registers no watches directly.
+ * exactly-once completion. It depends on odin/transport.h and, for the
+ * RFC-034 fast path, odin/transport_fd.h and odin/transport_xqc.h, which
+ * bring in xquic's headers; it issues no syscalls, calls no xquic API, and
+ * registers no watches directly.
+ *
+ * Fast path (RFC-034): when either endpoint is an fd or xqc stream transport,
+ * each readiness pumps bytes read -> write until the source or sink would
+ * block, bounded by a per-readiness byte budget, and those endpoints are called
+ * directly rather than through the vtable. Completion and error semantics are
+ * unchanged.
  *
  * Two-phase lifecycle: odin_relay_create allocates the relay and its two
  * buffers but binds nothing; the caller then builds the two transports with
@@ -33,11 +41,21 @@
  * status is the authoritative signal. A relay that is created but never started
  * never fires on_done. All entry points and odin_relay_ready run on the owner
  * thread; the relay adds no locks.
+ *
+ * Caller storage: odin_relay_create_in builds the relay inside a
+ * caller-provided odin_relay_storage_t whose trailing buf[] supplies the two
+ * direction buffers, so relay object and buffers cost no allocation of their
+ * own. odin_relay_destroy then releases nothing. The storage must stay valid
+ * and unmoved until destroy has returned and no odin_relay_ready frame for the
+ * relay is still on the stack -- the same point at which the allocating
+ * variant would have freed.
  */
 
 #ifndef ODIN_RELAY_H_
 #define ODIN_RELAY_H_
 
+#include <stdint.h>
+
 #include "odin/transport.h"
 
 #ifdef __cplusplus
@@ -46,6 +64,22 @@ extern "C" {
 
 typedef struct odin_relay_t odin_relay_t;
 
+/* Per-direction buffer capacity. */
+#define ODIN_RELAY_BUFFER_SIZE 65536u
+
+/* Opaque relay state, sized and aligned for the relay object (checked at
+ * compile time in relay.c). */
+#define ODIN_RELAY_STATE_SIZE 256u
+
+typedef struct odin_relay_storage_t {
+  union {
+    unsigned char bytes[ODIN_RELAY_STATE_SIZE];
+    void *align_ptr;
+    uint64_t align_u64;
+  } state;
+  unsigned char buf[2][ODIN_RELAY_BUFFER_SIZE];
+} odin_relay_storage_t;
+
 typedef enum odin_relay_status_t {
   ODIN_RELAY_OK = 0,
   ODIN_RELAY_ERROR,
@@ -63,11 +97,19 @@ typedef void (*odin_relay_done_cb)(odin_relay_t *relay,
 int odin_relay_create(odin_relay_done_cb on_done, void *user_data,
                       odin_relay_t **out);
 
+/* odin_relay_create without the allocation: initializes the relay in
+ * storage->state and points its two directions at storage->buf. Never fails.
+ * on_done must be non-null. Owner-thread API.
+ */
+void odin_relay_create_in(odin_relay_storage_t *storage,
+                          odin_relay_done_cb on_done, void *user_data,
+                          odin_relay_t **out);
+
 /* The relay's exported readiness trampoline: install it as the on_ready of BOTH
  * transports, with user_data set to the odin_relay_t * from create. It is the
- * only readiness entry point and identifies which endpoint fired by comparing t
- * to the two bound transports. Precondition: invoked only with one of the two
- * bound transports and the matching relay handle.
+ * only readiness entry point and identifies which endpoint fired by matching t
+ * exactly against the two bound transports. A readiness for any other
+ * transport, or one delivered before odin_relay_start, is ignored.
  */
 void odin_relay_ready(odin_transport_t *t, unsigned int events,
                       void *user_data);
@@ -82,6 +124,14 @@ void odin_relay_ready(odin_transport_t *t, unsigned int events,
 int odin_relay_start(odin_relay_t *relay, odin_transport_t *a,
                      odin_transport_t *b);
 
+/* Bytes the relay has written to b (a_to_b) and to a (b_to_a) so far; either
+ * out pointer may be NULL. Valid from create until destroy, including inside
+ * on_done, where they are the final totals the RFC-048 relay__done probe
+ * reports. Owner-thread API.
+ */
+void odin_relay_bytes(const odin_relay_t *relay, uint64_t *a_to_b,
+                      uint64_t *b_to_a);
+
 /* Stops any interest the relay still holds (odin_transport_set_interest(t, 0)
  * on each still-watched endpoint), frees the two buffers and the relay object,
  * and never invokes on_done; odin_relay_destroy(NULL) is a no-op. Callable from
@@ -0,0 +1,370 @@
+/* odin/route.c -- RFC-038 client split-routing rule table.
+ *
+ * Rules compile into a flat array in rule order. Address targets are stored
+ * as masked network bytes plus a prefix length; name targets are lowercased
+ * into one shared buffer. A decision parses the host as an address once, then
+ * scans the rules, so matching a name costs one suffix compare per name rule
+ * and matching a literal one masked compare per prefix rule.
+ */
+
+#include "odin/route.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "odin/parse_util.h"
+
+#define ODIN_ROUTE_NAME_MAX 253u
+
+enum {
+  ODIN_ROUTE_MATCH_ANY = 0,
+  ODIN_ROUTE_MATCH_NAME,
+  ODIN_ROUTE_MATCH_PREFIX4,
+  ODIN_ROUTE_MATCH_PREFIX6,
+};
+
+typedef struct odin_route_rule_t {
+  odin_route_action_t action;
+  int kind;
+  uint16_t port;      /* 0: any port */
+  uint8_t prefix_len; /* prefix rules */
+  uint8_t addr[16];   /* prefix rules, host bits cleared */
+  size_t name_off;    /* name rules, into table->names */
+  size_t name_len;
+  uint64_t hits;
+} odin_route_rule_t;
+
+struct odin_route_table_t {
+  size_t count;
+  odin_route_rule_t *rules;
+  char *names;
+  odin_route_stats_t stats;
+};
+
+static char lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static int name_byte_ok(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+}
+
+/* Splits s into at most 4 space-separated fields; returns the field count. */
+static size_t split_fields(const char *s, const char *field[4],
+                           size_t len[4]) {
+  size_t n = 0;
+  while (*s != '\0') {
+    while (*s == ' ') {
+      ++s;
+    }
+    if (*s == '\0') {
+      break;
+    }
+    const char *start = s;
+    while (*s != '\0' && *s != ' ') {
+      ++s;
+    }
+    if (n == 4) {
+      return 5;
+    }
+    field[n] = start;
+    len[n] = (size_t)(s - start);
+    ++n;
+  }
+  return n;
+}
+
+/* Parses an address or CIDR prefix into r; returns 0, or -1 when text is not
+ * one (the caller then tries it as a name). */
+static int parse_prefix(const char *text, size_t len, odin_route_rule_t *r) {
+  char buf[INET6_ADDRSTRLEN + 4];
+  if (len == 0 || len >= sizeof(buf)) {
+    return -1;
+  }
+  memcpy(buf, text, len);
+  buf[len] = '\0';
+  char *slash = strchr(buf, '/');
+  if (slash != NULL) {
+    *slash = '\0';
+  }
+  unsigned int max_bits;
+  if (inet_pton(AF_INET, buf, r->addr) == 1) {
+    r->kind = ODIN_ROUTE_MATCH_PREFIX4;
+    max_bits = 32;
+  } else if (inet_pton(AF_INET6, buf, r->addr) == 1) {
+    r->kind = ODIN_ROUTE_MATCH_PREFIX6;
+    max_bits = 128;
+  } else {
+    return -1;
+  }
+  unsigned int bits = max_bits;
+  if (slash != NULL) {
+    const char *digits = slash + 1;
+    const size_t n = strlen(digits);
+    if (n == 0 || n > 3) {
+      return -1;
+    }
+    bits = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (digits[i] < '0' || digits[i] > '9') {
+        return -1;
+      }
+      bits = bits * 10u + (unsigned int)(digits[i] - '0');
+    }
+    if (bits > max_bits) {
+      return -1;
+    }
+  }
+  r->prefix_len = (uint8_t)bits;
+  for (unsigned int i = 0; i < max_bits / 8u; ++i) {
+    if (i * 8u >= bits) {
+      r->addr[i] = 0;
+    } else if (i * 8u + 8u > bits) {
+      r->addr[i] &= (uint8_t)(0xffu << (8u - (bits - i * 8u)));
+    }
+  }
+  return 0;
+}
+
+/* Validates a name target and returns its canonical span (leading '.' and one
+ * trailing '.' dropped) through off / len; -1 when malformed. */
+static int parse_name(const char *text, size_t len, size_t *off,
+                      size_t *out_len) {
+  size_t start = 0;
+  if (len > 0 && text[0] == '.') {
+    start = 1;
+  }
+  if (len > start && text[len - 1] == '.') {
+    --len;
+  }
+  if (len <= start || len - start > ODIN_ROUTE_NAME_MAX) {
+    return -1;
+  }
+  if (text[start] == '.') {
+    return -1;
+  }
+  for (size_t i = start; i < len; ++i) {
+    if (!name_byte_ok(text[i]) ||
+        (text[i] == '.' && i > start && text[i - 1] == '.')) {
+      return -1;
+    }
+  }
+  *off = start;
+  *out_len = len - start;
+  return 0;
+}
+
+/* Compiles one rule string into r; name bytes go to names + *names_used. */
+static int compile_rule(const char *rule, odin_route_rule_t *r, char *names,
+                        size_t *names_used) {
+  const char *field[4];
+  size_t len[4];
+  const size_t n = split_fields(rule, field, len);
+  if (n < 2 || n > 3) {
+    return -1;
+  }
+  if (len[0] == 6 && memcmp(field[0], "direct", 6) == 0) {
+    r->action = ODIN_ROUTE_DIRECT;
+  } else if (len[0] == 6 && memcmp(field[0], "tunnel", 6) == 0) {
+    r->action = ODIN_ROUTE_TUNNEL;
+  } else {
+    return -1;
+  }
+  if (n == 3) {
+    const odin_parse_util_port_result_t pr =
+        odin_parse_util_port((const uint8_t *)field[2], len[2]);
+    if (pr.status != ODIN_PARSE_UTIL_PORT_OK || pr.port == 0) {
+      return -1;
+    }
+    r->port = pr.port;
+  }
+  if (len[1] == 1 && field[1][0] == '*') {
+    r->kind = ODIN_ROUTE_MATCH_ANY;
+    return 0;
+  }
+  if (parse_prefix(field[1], len[1], r) == 0) {
+    return 0;
+  }
+  size_t off = 0;
+  size_t name_len = 0;
+  if (parse_name(field[1], len[1], &off, &name_len) != 0) {
+    return -1;
+  }
+  r->kind = ODIN_ROUTE_MATCH_NAME;
+  r->name_off = *names_used;
+  r->name_len = name_len;
+  for (size_t i = 0; i < name_len; ++i) {
+    names[*names_used + i] = lower(field[1][off + i]);
+  }
+  *names_used += name_len;
+  return 0;
+}
+
+int odin_route_table_create(const char *const *rules, size_t count,
+                            size_t *out_bad, odin_route_table_t **out) {
+  if (out == NULL || count > ODIN_ROUTE_RULES_MAX ||
+      (count > 0 && rules == NULL)) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t names_cap = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (rules[i] == NULL) {
+      if (out_bad != NULL) {
+        *out_bad = i;
+      }
+      errno = EINVAL;
+      return -1;
+    }
+    names_cap += strlen(rules[i]);
+  }
+  odin_route_table_t *t = (odin_route_table_t *)calloc(1, sizeof(*t));
+  if (t == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  t->rules = (odin_route_rule_t *)calloc(count > 0 ? count : 1,
+                                         sizeof(*t->rules));
+  t->names = (char *)malloc(names_cap > 0 ? names_cap : 1);
+  if (t->rules == NULL || t->names == NULL) {
+    odin_route_table_destroy(t);
+    errno = ENOMEM;
+    return -1;
+  }
+  size_t names_used = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (compile_rule(rules[i], &t->rules[i], t->names, &names_used) != 0) {
+      odin_route_table_destroy(t);
+      if (out_bad != NULL) {
+        *out_bad = i;
+      }
+      errno = EINVAL;
+      return -1;
+    }
+  }
+  t->count = count;
+  *out = t;
+  return 0;
+}
+
+static int prefix_matches(const odin_route_rule_t *r, const uint8_t *addr) {
+  const unsigned int full = r->prefix_len / 8u;
+  if (memcmp(r->addr, addr, full) != 0) {
+    return 0;
+  }
+  const unsigned int rest = r->prefix_len % 8u;
+  if (rest == 0) {
+    return 1;
+  }
+  const uint8_t mask = (uint8_t)(0xffu << (8u - rest));
+  return (addr[full] & mask) == r->addr[full];
+}
+
+static int name_matches(const odin_route_table_t *t, const odin_route_rule_t *r,
+                        const char *host, size_t host_len) {
+  if (host_len < r->name_len) {
+    return 0;
+  }
+  const size_t skip = host_len - r->name_len;
+  if (skip > 0 && host[skip - 1] != '.') {
+    return 0;
+  }
+  const char *name = t->names + r->name_off;
+  for (size_t i = 0; i < r->name_len; ++i) {
+    if (lower(host[skip + i]) != name[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+odin_route_action_t odin_route_decide(odin_route_table_t *table,
+                                      const char *host, size_t host_len,
+                                      uint16_t port) {
+  int family = AF_UNSPEC;
+  uint8_t addr[16];
+  char buf[INET6_ADDRSTRLEN];
+  if (host_len > 0 && host_len < sizeof(buf)) {
+    memcpy(buf, host, host_len);
+    buf[host_len] = '\0';
+    if (inet_pton(AF_INET, buf, addr) == 1) {
+      family = AF_INET;
+    } else if (inet_pton(AF_INET6, buf, addr) == 1) {
+      family = AF_INET6;
+    }
+  }
+  if (family == AF_UNSPEC && host_len > 0 && host[host_len - 1] == '.') {
+    --host_len;
+  }
+
+  for (size_t i = 0; i < table->count; ++i) {
+    odin_route_rule_t *r = &table->rules[i];
+    if (r->port != 0 && r->port != port) {
+      continue;
+    }
+    int match = 0;
+    switch (r->kind) {
+    case ODIN_ROUTE_MATCH_ANY:
+      match = 1;
+      break;
+    case ODIN_ROUTE_MATCH_NAME:
+      match = family == AF_UNSPEC && name_matches(table, r, host, host_len);
+      break;
+    case ODIN_ROUTE_MATCH_PREFIX4:
+      match = family == AF_INET && prefix_matches(r, addr);
+      break;
+    case ODIN_ROUTE_MATCH_PREFIX6:
+      match = family == AF_INET6 && prefix_matches(r, addr);
+      break;
+    default:
+      break;
+    }
+    if (match) {
+      r->hits += 1;
+      if (r->action == ODIN_ROUTE_DIRECT) {
+        table->stats.direct += 1;
+      } else {
+        table->stats.tunnel += 1;
+      }
+      return r->action;
+    }
+  }
+  table->stats.tunnel += 1;
+  table->stats.defaulted += 1;
+  return ODIN_ROUTE_TUNNEL;
+}
+
+void odin_route_stats(const odin_route_table_t *table,
+                      odin_route_stats_t *out) {
+  *out = table->stats;
+}
+
+size_t odin_route_stats_format(const odin_route_stats_t *stats, char *buf,
+                               size_t cap) {
+  const int n = snprintf(buf, cap,
+                         "route=%" PRIu64 "/%" PRIu64 "/%" PRIu64,
+                         stats->tunnel, stats->direct, stats->defaulted);
+  return n > 0 ? (size_t)n : 0;
+}
+
+uint64_t odin_route_rule_hits(const odin_route_table_t *table, size_t index) {
+  return index < table->count ? table->rules[index].hits : 0;
+}
+
+void odin_route_table_destroy(odin_route_table_t *table) {
+  if (table == NULL) {
+    return;
+  }
+  free(table->rules);
+  free(table->names);
+  free(table);
+}
@@ -0,0 +1,82 @@
+/* odin/route.h
+ *
+ * Client split-routing rule table (RFC-038).
+ *
+ * A table is compiled once, at startup, from rule strings of the form
+ *
+ *   ACTION TARGET [PORT]
+ *
+ * ACTION is "direct" or "tunnel". TARGET is "*" (every destination), an IPv4
+ * or IPv6 prefix in CIDR notation (a bare address is a full-length prefix), or
+ * a domain name, which matches that name and every name below it; a leading
+ * '.' is accepted and ignored. PORT, when present, is a decimal port 1-65535
+ * the destination port must equal. Fields are separated by spaces.
+ *
+ * odin_route_decide matches a CONNECT destination against the rules in order.
+ * The first match wins; a destination no rule matches is tunnelled. Name rules
+ * compare case-insensitively against the host as the client sent it, with one
+ * trailing '.' ignored. Prefix rules match only destinations that are address
+ * literals, so a decision never waits on DNS.
+ *
+ * Counters: every decision counts against its action and against the rule that
+ * made it; decisions no rule matched count as defaulted.
+ *
+ * Threading: a table belongs to one owner thread (one event loop);
+ * odin_route_decide updates the counters without locks.
+ * odin_route_table_destroy(NULL) is a no-op.
+ */
+
+#ifndef ODIN_ROUTE_H_
+#define ODIN_ROUTE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_ROUTE_RULES_MAX 256u
+
+typedef struct odin_route_table_t odin_route_table_t;
+
+typedef enum odin_route_action_t {
+  ODIN_ROUTE_TUNNEL = 0,
+  ODIN_ROUTE_DIRECT,
+} odin_route_action_t;
+
+typedef struct odin_route_stats_t {
+  uint64_t tunnel;    /* decisions that picked the QUIC upstream */
+  uint64_t direct;    /* decisions that picked a local dial      */
+  uint64_t defaulted; /* decisions no rule matched (tunnelled)   */
+} odin_route_stats_t;
+
+/* Compiles count rule strings (count may be 0). Returns 0, or -1 with errno
+ * EINVAL for a malformed rule or count > ODIN_ROUTE_RULES_MAX, or ENOMEM. On
+ * EINVAL for a malformed rule, *out_bad (when non-NULL) is its index. */
+int odin_route_table_create(const char *const *rules, size_t count,
+                            size_t *out_bad, odin_route_table_t **out);
+
+/* host is the bracket-free CONNECT host, host_len bytes, not NUL-terminated. */
+odin_route_action_t odin_route_decide(odin_route_table_t *table,
+                                      const char *host, size_t host_len,
+                                      uint16_t port);
+
+void odin_route_stats(const odin_route_table_t *table, odin_route_stats_t *out);
+
+/* Formats stats for the RFC-051 log line as "route=T/D/F": tunnelled, direct,
+ * and defaulted decisions. snprintf semantics; returns the untruncated
+ * length. */
+size_t odin_route_stats_format(const odin_route_stats_t *stats, char *buf,
+                               size_t cap);
+
+/* Decisions made by rule index; 0 for an index past the last rule. */
+uint64_t odin_route_rule_hits(const odin_route_table_t *table, size_t index);
+
+void odin_route_table_destroy(odin_route_table_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_ROUTE_H_ */
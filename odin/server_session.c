@@ -5,7 +5,13 @@
  * accepted nonblocking conn_fd runs end-to-end. A single trampoline
  * (server_session_ready) is installed as the downstream and (later) upstream
  * transports' on_ready and dispatches into odin_connect_session_drive while
- * the session is alive and into odin_relay_ready afterwards.
+ * the session is alive and into odin_relay_ready afterwards. Every sub-object
+ * is built in place inside the session's odin_server_session_storage_t
+ * (RFC-033), so the session is one allocation or one caller-supplied block.
+ * A CONNECT to the reserved DNS target (RFC-045) skips the dial and hands the
+ * downstream transport to a DNS tunnel responder instead of a relay. With an
+ * RFC-049 ring lent, the session fills one access-log record as it learns
+ * each field and appends it when it closes.
  */
 
 #include "odin/server_session.h"
@@ -20,11 +26,14 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "odin/access_log.h"
 #include "odin/connect_session.h"
 #include "odin/dial.h"
+#include "odin/dns_tunnel.h"
 #include "odin/event_loop.h"
 #include "odin/protocol.h"
 #include "odin/relay.h"
+#include "odin/trace.h"
 #include "odin/transport.h"
 #include "odin/transport_fd.h"
 
@@ -42,6 +51,10 @@ enum {
   ODIN_SERVER_SESSION_S_RESOLVING = 7,
 };
 
+/* Addresses per family taken from a cache hit; the dial uses the first one the
+ * filter admits, so a longer answer only adds fallbacks. */
+#define ODIN_SERVER_SESSION_CACHED_ADDRS 8u
+
 struct odin_server_session_t {
   odin_event_loop_t *loop;
   int conn_fd;
@@ -58,14 +71,28 @@ struct odin_server_session_t {
   void *user_data;
   odin_server_session_dial_filter_cb dial_filter;
   void *dial_filter_ud;
+  odin_server_session_downstream_destroying_cb downstream_destroying;
+  void *downstream_destroying_ud;
+  odin_dial_tfo_cache_t *tfo_cache; /* borrowed; NULL: no TFO */
+  size_t tail_sent;                 /* tail bytes the SYN carried */
+  odin_dial_source_pool_t *sources; /* borrowed; NULL: implicit source */
+  int source_idx;                   /* pool source dial_fd holds, or -1 */
   odin_transport_t *downstream_t;
   odin_transport_t *upstream_t;
   odin_connect_session_t *s;
   odin_dns_resolver_t *resolver;
-  odin_dns_query_t *dns_query;
+  odin_dns_stream_t *lookup; /* RFC-043 A/AAAA answers while resolving */
+  int lookup_start_err;       /* first dial start failure across answers */
+  int lookup_filter_err;      /* first filter denial across answers */
   int owns_resolver;
   odin_dial_t *dial;
   odin_relay_t *relay;
+  odin_dns_tunnel_server_t *dns_tunnel; /* RFC-045 stream; else NULL */
+  int dns_stream;                       /* CONNECT named the DNS target */
+  odin_server_session_release_cb on_release; /* NULL: storage is malloc'd */
+  odin_access_log_ring_t *access_log; /* borrowed; NULL: not logged */
+  uint64_t dial_start_us;
+  odin_access_log_record_t log_rec; /* filled while access_log is set */
 #if defined(ODIN_SERVER_SESSION_TESTING)
   int fail_next_dial_armed;
   int fail_next_dial_errno;
@@ -84,6 +111,13 @@ struct odin_server_session_t {
 #endif
 };
 
+_Static_assert(sizeof(struct odin_server_session_t) <=
+                   ODIN_SERVER_SESSION_STATE_SIZE,
+               "ODIN_SERVER_SESSION_STATE_SIZE too small");
+_Static_assert(_Alignof(struct odin_server_session_t) <=
+                   _Alignof(odin_server_session_storage_t),
+               "odin_server_session_storage_t under-aligned");
+
 static void server_session_ready(odin_transport_t *t, unsigned int events,
                                  void *user_data);
 static void session_on_req_decoded(odin_connect_session_t *s, void *user_data);
@@ -92,16 +126,23 @@ static void session_on_done(odin_connect_session_t *s,
                             void *user_data);
 static void dial_on_done(odin_dial_t *dial, odin_dial_status_t status, int fd,
                          int err, void *user_data);
-static void dns_on_done(odin_dns_query_t *query, odin_dns_status_t status,
-                        int err, const odin_dns_addr_t *addrs,
-                        size_t addr_count, void *user_data);
+static void dns_on_partial(odin_dns_stream_t *stream, int family,
+                           odin_dns_status_t status, int err,
+                           const odin_dns_addr_t *addrs, size_t addr_count,
+                           void *user_data);
+static void dns_on_done(odin_dns_stream_t *stream, odin_dns_status_t status,
+                        int err, void *user_data);
 static void relay_on_done(odin_relay_t *relay, odin_relay_status_t status,
                           int err, void *user_data);
-static void select_and_dial(odin_server_session_t *ss,
-                            const odin_dns_addr_t *addrs, size_t addr_count);
+static void dns_tunnel_on_done(odin_dns_tunnel_server_t *srv, int err,
+                               void *user_data);
+static int select_and_dial(odin_server_session_t *ss,
+                           const odin_dns_addr_t *addrs, size_t addr_count);
 static void handle_dial_result(odin_server_session_t *ss, int err);
 static void fire_terminal(odin_server_session_t *ss, int err);
+static void append_access_log(odin_server_session_t *ss, int err);
 static void finish_destroy(odin_server_session_t *ss);
+static void close_dial_fd(odin_server_session_t *ss);
 
 #if defined(ODIN_SERVER_SESSION_TESTING)
 static unsigned int g_server_session_live_count;
@@ -129,18 +170,28 @@ static void ss_leave(odin_server_session_t *ss) {
   }
 }
 
+/* The session state sits at the front of its storage; the sub-object slots
+ * follow it. */
+static odin_server_session_storage_t *
+session_storage(odin_server_session_t *ss) {
+  return (odin_server_session_storage_t *)(void *)ss;
+}
+
+/* Initializes the session state inside storage (malloc'd when on_release is
+ * NULL); the sub-object slots are initialized by their own *_in creates. */
 static odin_server_session_t *
-alloc_session(odin_event_loop_t *loop, int conn_fd,
-              odin_dns_resolver_t *resolver, int owns_resolver,
-              odin_server_session_close_cb on_close, void *user_data) {
-  odin_server_session_t *ss = (odin_server_session_t *)calloc(1, sizeof(*ss));
-  if (ss == NULL) {
-    errno = ENOMEM;
-    return NULL;
-  }
+init_session(odin_server_session_storage_t *storage,
+             odin_server_session_release_cb on_release,
+             odin_event_loop_t *loop, int conn_fd,
+             odin_dns_resolver_t *resolver, int owns_resolver,
+             odin_server_session_close_cb on_close, void *user_data) {
+  odin_server_session_t *ss = (odin_server_session_t *)(void *)&storage->state;
+  memset(ss, 0, sizeof(*ss));
+  ss->on_release = on_release;
   ss->loop = loop;
   ss->conn_fd = conn_fd;
   ss->dial_fd = -1;
+  ss->source_idx = -1;
   ss->state = ODIN_SERVER_SESSION_S_HANDSHAKE;
   ss->resolver = resolver;
   ss->owns_resolver = owns_resolver;
@@ -149,6 +200,32 @@ alloc_session(odin_event_loop_t *loop, int conn_fd,
   return ss;
 }
 
+static odin_server_session_t *
+alloc_session(odin_event_loop_t *loop, int conn_fd,
+              odin_dns_resolver_t *resolver, int owns_resolver,
+              odin_server_session_close_cb on_close, void *user_data) {
+  odin_server_session_storage_t *storage =
+      (odin_server_session_storage_t *)malloc(sizeof(*storage));
+  if (storage == NULL) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  return init_session(storage, NULL, loop, conn_fd, resolver, owns_resolver,
+                      on_close, user_data);
+}
+
+/* Drops the session's memory: free(3) for the allocating variants, on_release
+ * for create_in. Nothing touches ss afterwards. */
+static void release_session(odin_server_session_t *ss) {
+  if (ss->on_release == NULL) {
+    free(session_storage(ss));
+    return;
+  }
+  const odin_server_session_release_cb cb = ss->on_release;
+  void *const ud = ss->user_data;
+  cb(session_storage(ss), ud);
+}
+
 static void rollback_unpublished_session(odin_server_session_t *ss) {
   if (ss == NULL) {
     return;
@@ -165,12 +242,15 @@ static void rollback_unpublished_session(odin_server_session_t *ss) {
     odin_dns_resolver_destroy(ss->resolver);
     ss->resolver = NULL;
   }
-  free(ss);
+  if (ss->on_release == NULL) {
+    free(session_storage(ss));
+  }
 }
 
 static int finish_session_setup(odin_server_session_t *ss) {
-  if (odin_connect_session_create_server(session_on_req_decoded,
-                                         session_on_done, ss, &ss->s) != 0) {
+  if (odin_connect_session_create_server_in(
+          &session_storage(ss)->connect_session, session_on_req_decoded,
+          session_on_done, ss, &ss->s) != 0) {
     return -1;
   }
   if (odin_transport_set_interest(ss->downstream_t, ODIN_TRANSPORT_READ) != 0) {
@@ -179,6 +259,7 @@ static int finish_session_setup(odin_server_session_t *ss) {
 #if defined(ODIN_SERVER_SESSION_TESTING)
   g_server_session_live_count += 1;
 #endif
+  ODIN_TRACE1(server__session__create, ss);
   return 0;
 }
 
@@ -198,8 +279,24 @@ static int create_with_resolver_common(odin_event_loop_t *loop, int conn_fd,
     errno = saved;
     return -1;
   }
-  if (odin_fd_transport_create(loop, conn_fd, server_session_ready, ss,
-                               &ss->downstream_t) != 0) {
+  odin_fd_transport_create_in(&session_storage(ss)->downstream, loop, conn_fd,
+                              server_session_ready, ss, &ss->downstream_t);
+  if (finish_session_setup(ss) != 0) {
+    const int saved = errno;
+    rollback_unpublished_session(ss);
+    errno = saved;
+    return -1;
+  }
+  *out = ss;
+  return 0;
+}
+
+static int start_with_transport(
+    odin_server_session_t *ss,
+    odin_server_session_transport_factory_cb create_downstream,
+    void *factory_user_data, odin_server_session_t **out) {
+  if (create_downstream(server_session_ready, ss, factory_user_data,
+                        &ss->downstream_t) != 0) {
     const int saved = errno;
     rollback_unpublished_session(ss);
     errno = saved;
@@ -231,21 +328,7 @@ static int create_with_transport_and_resolver_common(
     errno = saved;
     return -1;
   }
-  if (create_downstream(server_session_ready, ss, factory_user_data,
-                        &ss->downstream_t) != 0) {
-    const int saved = errno;
-    rollback_unpublished_session(ss);
-    errno = saved;
-    return -1;
-  }
-  if (finish_session_setup(ss) != 0) {
-    const int saved = errno;
-    rollback_unpublished_session(ss);
-    errno = saved;
-    return -1;
-  }
-  *out = ss;
-  return 0;
+  return start_with_transport(ss, create_downstream, factory_user_data, out);
 }
 
 int odin_server_session_create(odin_event_loop_t *loop, int conn_fd,
@@ -318,6 +401,24 @@ int odin_server_session_create_with_transport_and_resolver(
                                                    0, on_close, user_data, out);
 }
 
+int odin_server_session_create_in(
+    odin_server_session_storage_t *storage,
+    odin_server_session_release_cb on_release, odin_event_loop_t *loop,
+    odin_server_session_transport_factory_cb create_downstream,
+    void *factory_user_data, odin_dns_resolver_t *resolver,
+    odin_server_session_close_cb on_close, void *user_data,
+    odin_server_session_t **out) {
+  if (storage == NULL || on_release == NULL || loop == NULL ||
+      create_downstream == NULL || resolver == NULL || on_close == NULL ||
+      out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_server_session_t *ss = init_session(storage, on_release, loop, -1,
+                                           resolver, 0, on_close, user_data);
+  return start_with_transport(ss, create_downstream, factory_user_data, out);
+}
+
 void odin_server_session_set_dial_filter(odin_server_session_t *ss,
                                          odin_server_session_dial_filter_cb cb,
                                          void *user_data) {
@@ -328,6 +429,46 @@ void odin_server_session_set_dial_filter(odin_server_session_t *ss,
   ss->dial_filter_ud = user_data;
 }
 
+void odin_server_session_set_downstream_destroying(
+    odin_server_session_t *ss, odin_server_session_downstream_destroying_cb cb,
+    void *user_data) {
+  if (ss == NULL) {
+    return;
+  }
+  ss->downstream_destroying = cb;
+  ss->downstream_destroying_ud = user_data;
+}
+
+void odin_server_session_set_tfo_cache(odin_server_session_t *ss,
+                                       odin_dial_tfo_cache_t *cache) {
+  if (ss == NULL) {
+    return;
+  }
+  ss->tfo_cache = cache;
+}
+
+void odin_server_session_set_source_pool(odin_server_session_t *ss,
+                                         odin_dial_source_pool_t *pool) {
+  if (ss == NULL) {
+    return;
+  }
+  ss->sources = pool;
+}
+
+void odin_server_session_set_access_log(odin_server_session_t *ss,
+                                        odin_access_log_ring_t *ring,
+                                        const struct sockaddr *client,
+                                        socklen_t client_len) {
+  if (ss == NULL) {
+    return;
+  }
+  ss->access_log = ring;
+  if (ring != NULL) {
+    odin_access_log_record_begin(&ss->log_rec, ODIN_ACCESS_LOG_SERVER);
+    odin_access_log_addr_set(&ss->log_rec.client, client, client_len);
+  }
+}
+
 void odin_server_session_destroy(odin_server_session_t *ss) {
   if (ss == NULL) {
     return;
@@ -339,15 +480,44 @@ void odin_server_session_destroy(odin_server_session_t *ss) {
   finish_destroy(ss);
 }
 
+/* Lets the owner drain the downstream transport, then destroys it. */
+static void destroy_downstream(odin_server_session_t *ss) {
+  if (ss->downstream_t == NULL) {
+    return;
+  }
+  if (ss->downstream_destroying != NULL) {
+    ss->downstream_destroying(ss->downstream_t, ss->downstream_destroying_ud);
+  }
+  odin_transport_destroy(ss->downstream_t);
+  ss->downstream_t = NULL;
+}
+
+/* Closes the upstream socket and returns its pool source's live count. */
+static void close_dial_fd(odin_server_session_t *ss) {
+  if (ss->dial_fd >= 0) {
+    (void)close(ss->dial_fd);
+    ss->dial_fd = -1;
+  }
+  odin_dial_source_pool_release(ss->sources, ss->source_idx);
+  ss->source_idx = -1;
+}
+
 static void finish_destroy(odin_server_session_t *ss) {
-  if (ss->dns_query != NULL) {
-    odin_dns_query_destroy(ss->dns_query);
-    ss->dns_query = NULL;
+  if (ss->access_log != NULL && !ss->on_close_fired) {
+    append_access_log(ss, ECANCELED); /* destroyed before it closed */
+  }
+  if (ss->lookup != NULL) {
+    odin_dns_stream_destroy(ss->lookup);
+    ss->lookup = NULL;
   }
   if (ss->relay != NULL) {
     odin_relay_destroy(ss->relay);
     ss->relay = NULL;
   }
+  if (ss->dns_tunnel != NULL) {
+    odin_dns_tunnel_server_destroy(ss->dns_tunnel);
+    ss->dns_tunnel = NULL;
+  }
   if (ss->dial != NULL) {
     odin_dial_destroy(ss->dial);
     ss->dial = NULL;
@@ -360,14 +530,8 @@ static void finish_destroy(odin_server_session_t *ss) {
     odin_transport_destroy(ss->upstream_t);
     ss->upstream_t = NULL;
   }
-  if (ss->downstream_t != NULL) {
-    odin_transport_destroy(ss->downstream_t);
-    ss->downstream_t = NULL;
-  }
-  if (ss->dial_fd >= 0) {
-    (void)close(ss->dial_fd);
-    ss->dial_fd = -1;
-  }
+  destroy_downstream(ss);
+  close_dial_fd(ss);
   if (ss->conn_fd >= 0) {
     (void)close(ss->conn_fd);
     ss->conn_fd = -1;
@@ -379,7 +543,7 @@ static void finish_destroy(odin_server_session_t *ss) {
 #if defined(ODIN_SERVER_SESSION_TESTING)
   g_server_session_live_count -= 1;
 #endif
-  free(ss);
+  release_session(ss);
 }
 
 static void server_session_ready(odin_transport_t *t, unsigned int events,
@@ -416,6 +580,11 @@ static void server_session_ready(odin_transport_t *t, unsigned int events,
     ss_leave(ss);
     return;
   }
+  if (ss->dns_tunnel != NULL) {
+    odin_dns_tunnel_server_ready(t, events, ss->dns_tunnel);
+    ss_leave(ss);
+    return;
+  }
   ss_leave(ss);
 }
 
@@ -448,9 +617,37 @@ static void session_on_req_decoded(odin_connect_session_t *s, void *user_data) {
   size_t host_len = 0;
   odin_connect_session_server_host(s, &host_ptr, &host_len);
   const uint16_t port = odin_connect_session_server_port(s);
+  if (ss->access_log != NULL) {
+    odin_access_log_record_set_host(&ss->log_rec, host_ptr, host_len, port);
+  }
+
+  /* RFC-045: the reserved DNS target names no upstream; answer OK at once
+   * and serve the stream from this server's resolver. */
+  if (port == ODIN_PROTO_DNS_PORT &&
+      host_len == sizeof(ODIN_PROTO_DNS_HOST) - 1 &&
+      memcmp(host_ptr, ODIN_PROTO_DNS_HOST, host_len) == 0) {
+    ss->dns_stream = 1;
+    handle_dial_result(ss, 0);
+    return;
+  }
 
-  if (odin_dns_resolve_start(ss->resolver, host_ptr, host_len, port, AF_UNSPEC,
-                             dns_on_done, ss, &ss->dns_query) != 0) {
+  /* RFC-044: a cached answer dials at once, with no query or loop pass. A
+   * family that is not cached, or cached addresses that cannot be dialed, fall
+   * through to the stream. */
+  static const int kFamilies[] = {AF_INET, AF_INET6};
+  for (size_t i = 0; i < sizeof(kFamilies) / sizeof(kFamilies[0]); ++i) {
+    odin_dns_addr_t cached[ODIN_SERVER_SESSION_CACHED_ADDRS];
+    const size_t n = odin_dns_resolver_cache_get(
+        ss->resolver, host_ptr, host_len, port, kFamilies[i], cached,
+        ODIN_SERVER_SESSION_CACHED_ADDRS);
+    if (n != 0 && select_and_dial(ss, cached, n) == 0) {
+      return;
+    }
+  }
+
+  if (odin_dns_resolve_stream_start(ss->resolver, host_ptr, host_len, port,
+                                    dns_on_partial, dns_on_done, ss,
+                                    &ss->lookup) != 0) {
     const int saved = errno;
     handle_dial_result(ss, saved);
     return;
@@ -475,38 +672,65 @@ static void maybe_post_injected_session_error(odin_server_session_t *ss) {
 }
 #endif
 
-static void dns_on_done(odin_dns_query_t *query, odin_dns_status_t status,
-                        int err, const odin_dns_addr_t *addrs,
-                        size_t addr_count, void *user_data) {
+/* RFC-043: each family's answer is tried as it lands, so a fast AAAA is not
+ * held behind a slow A. The first dial that starts ends the lookup. */
+static void dns_on_partial(odin_dns_stream_t *stream, int family,
+                           odin_dns_status_t status, int err,
+                           const odin_dns_addr_t *addrs, size_t addr_count,
+                           void *user_data) {
+  (void)family;
+  (void)err;
   odin_server_session_t *ss = (odin_server_session_t *)user_data;
   ss_enter(ss);
-  if (ss->on_close_fired || ss->destroy_pending) {
+  if (ss->on_close_fired || ss->destroy_pending || status != ODIN_DNS_OK ||
+      addr_count == 0) {
     ss_leave(ss);
     return;
   }
-  ss->dns_query = NULL;
-  odin_dns_query_destroy(query);
-  if (status != ODIN_DNS_OK) {
-    handle_dial_result(ss, err);
+  if (select_and_dial(ss, addrs, addr_count) == 0) {
+    ss->lookup = NULL;
+    odin_dns_stream_destroy(stream);
+  }
+  ss_leave(ss);
+}
+
+static void dns_on_done(odin_dns_stream_t *stream, odin_dns_status_t status,
+                        int err, void *user_data) {
+  (void)status;
+  odin_server_session_t *ss = (odin_server_session_t *)user_data;
+  ss_enter(ss);
+  if (ss->on_close_fired || ss->destroy_pending) {
     ss_leave(ss);
     return;
   }
-  select_and_dial(ss, addrs, addr_count);
+  ss->lookup = NULL;
+  odin_dns_stream_destroy(stream);
+  if (ss->lookup_start_err != 0) {
+    handle_dial_result(ss, ss->lookup_start_err);
+  } else if (ss->lookup_filter_err != 0) {
+    handle_dial_result(ss, ss->lookup_filter_err);
+  } else {
+    handle_dial_result(ss, err != 0 ? err : EHOSTUNREACH);
+  }
   ss_leave(ss);
 }
 
-static void select_and_dial(odin_server_session_t *ss,
-                            const odin_dns_addr_t *addrs, size_t addr_count) {
-  if (addr_count == 0) {
-    handle_dial_result(ss, EHOSTUNREACH);
-    return;
+/* Dials the first address the filter admits. Returns 0 once a dial has
+ * started or the session is closing; otherwise -1, with the failures noted
+ * for dns_on_done. */
+static int select_and_dial(odin_server_session_t *ss,
+                           const odin_dns_addr_t *addrs, size_t addr_count) {
+  const uint8_t *tail_ptr = NULL;
+  size_t tail_len = 0;
+  if (ss->tfo_cache != NULL) {
+    odin_connect_session_server_tail(ss->s, &tail_ptr, &tail_len);
   }
+  const odin_dial_opts_t opts = {ss->tfo_cache, tail_ptr, tail_len,
+                                 ss->sources};
 
-  int first_filter_err = 0;
-  int first_start_err = 0;
   for (size_t i = 0; i < addr_count; ++i) {
     if (ss->destroy_pending || ss->on_close_fired) {
-      return;
+      return 0;
     }
     const odin_dns_addr_t *addr = &addrs[i];
     if (ss->dial_filter != NULL) {
@@ -514,11 +738,11 @@ static void select_and_dial(odin_server_session_t *ss,
           ss->dial_filter((const struct sockaddr *)&addr->addr, addr->addrlen,
                           ss->dial_filter_ud);
       if (ss->destroy_pending || ss->on_close_fired) {
-        return;
+        return 0;
       }
       if (filter_err != 0) {
-        if (first_filter_err == 0) {
-          first_filter_err = filter_err;
+        if (ss->lookup_filter_err == 0) {
+          ss->lookup_filter_err = filter_err;
         }
         continue;
       }
@@ -528,33 +752,32 @@ static void select_and_dial(odin_server_session_t *ss,
       const int errnum = ss->fail_next_dial_errno;
       ss->fail_next_dial_armed = 0;
       ss->fail_next_dial_errno = 0;
-      if (first_start_err == 0) {
-        first_start_err = errnum;
+      if (ss->lookup_start_err == 0) {
+        ss->lookup_start_err = errnum;
       }
       continue;
     }
 #endif
-    if (odin_dial_start(ss->loop, (const struct sockaddr *)&addr->addr,
-                        addr->addrlen, dial_on_done, ss, &ss->dial) == 0) {
+    if (odin_dial_start_opts_in(&session_storage(ss)->dial, ss->loop,
+                                (const struct sockaddr *)&addr->addr,
+                                addr->addrlen, &opts, dial_on_done, ss,
+                                &ss->dial) == 0) {
       ss->state = ODIN_SERVER_SESSION_S_DIALING;
+      if (ss->access_log != NULL) {
+        ss->dial_start_us = odin_access_log_mono_us();
+        odin_access_log_addr_set(&ss->log_rec.upstream,
+                                 (const struct sockaddr *)&addr->addr,
+                                 addr->addrlen);
+      }
       maybe_post_injected_session_error(ss);
-      return;
+      return 0;
     }
-    if (first_start_err == 0) {
-      first_start_err = errno;
+    if (ss->lookup_start_err == 0) {
+      ss->lookup_start_err = errno;
     }
   }
 
-  if (ss->destroy_pending || ss->on_close_fired) {
-    return;
-  }
-  if (first_start_err != 0) {
-    handle_dial_result(ss, first_start_err);
-  } else if (first_filter_err != 0) {
-    handle_dial_result(ss, first_filter_err);
-  } else {
-    handle_dial_result(ss, EHOSTUNREACH);
-  }
+  return ss->destroy_pending || ss->on_close_fired ? 0 : -1;
 }
 
 static void dial_on_done(odin_dial_t *dial, odin_dial_status_t status, int fd,
@@ -566,6 +789,13 @@ static void dial_on_done(odin_dial_t *dial, odin_dial_status_t status, int fd,
     ss_leave(ss);
     return;
   }
+  if (ss->access_log != NULL) {
+    ss->log_rec.dial_us = odin_access_log_mono_us() - ss->dial_start_us;
+  }
+  if (status == ODIN_DIAL_OK) {
+    ss->tail_sent = odin_dial_early_sent(ss->dial);
+    ss->source_idx = odin_dial_source(ss->dial);
+  }
   odin_dial_destroy(ss->dial);
   ss->dial = NULL;
   if (status == ODIN_DIAL_OK) {
@@ -575,22 +805,15 @@ static void dial_on_done(odin_dial_t *dial, odin_dial_status_t status, int fd,
       const int errnum = ss->fail_next_upstream_xport_errno;
       ss->fail_next_upstream_xport_armed = 0;
       ss->fail_next_upstream_xport_errno = 0;
-      (void)close(ss->dial_fd);
-      ss->dial_fd = -1;
+      close_dial_fd(ss);
       handle_dial_result(ss, errnum);
       ss_leave(ss);
       return;
     }
 #endif
-    if (odin_fd_transport_create(ss->loop, ss->dial_fd, server_session_ready,
-                                 ss, &ss->upstream_t) != 0) {
-      const int saved = errno;
-      (void)close(ss->dial_fd);
-      ss->dial_fd = -1;
-      handle_dial_result(ss, saved);
-      ss_leave(ss);
-      return;
-    }
+    odin_fd_transport_create_in(&session_storage(ss)->upstream, ss->loop,
+                                ss->dial_fd, server_session_ready, ss,
+                                &ss->upstream_t);
     handle_dial_result(ss, 0);
     ss_leave(ss);
     return;
@@ -618,6 +841,26 @@ static void handle_dial_result(odin_server_session_t *ss, int err) {
   (void)odin_transport_set_interest(ss->downstream_t, mask);
 }
 
+/* Hands the downstream transport, and any queries the client pipelined
+ * behind its CONNECT_REQ, to an RFC-045 DNS responder. */
+static void start_dns_tunnel(odin_server_session_t *ss) {
+  const uint8_t *tail_ptr = NULL;
+  size_t tail_len = 0;
+  odin_connect_session_server_tail(ss->s, &tail_ptr, &tail_len);
+  const int rc = odin_dns_tunnel_server_create(
+      ss->resolver, ss->downstream_t, tail_ptr, tail_len, ss->dial_filter,
+      ss->dial_filter_ud, dns_tunnel_on_done, ss, &ss->dns_tunnel);
+  if (rc != 0) {
+    const int saved = errno;
+    fire_terminal(ss, saved);
+    return;
+  }
+  /* The responder copied the tail, so the connect session can go now. */
+  odin_connect_session_destroy(ss->s);
+  ss->s = NULL;
+  ss->state = ODIN_SERVER_SESSION_S_RELAY;
+}
+
 static void session_on_done(odin_connect_session_t *s,
                             odin_connect_session_status_t status, int err,
                             void *user_data) {
@@ -629,10 +872,16 @@ static void session_on_done(odin_connect_session_t *s,
   }
   assert(ss->state == ODIN_SERVER_SESSION_S_WRITING_OK_RESP ||
          ss->state == ODIN_SERVER_SESSION_S_WRITING_ERR_RESP);
+  if (ss->state == ODIN_SERVER_SESSION_S_WRITING_OK_RESP && ss->dns_stream) {
+    start_dns_tunnel(ss);
+    return;
+  }
   if (ss->state == ODIN_SERVER_SESSION_S_WRITING_OK_RESP) {
     const uint8_t *tail_ptr = NULL;
     size_t tail_len = 0;
     odin_connect_session_server_tail(ss->s, &tail_ptr, &tail_len);
+    tail_ptr += ss->tail_sent; /* the SYN already carried these */
+    tail_len -= ss->tail_sent;
     if (tail_len > 0) {
 #if defined(ODIN_SERVER_SESSION_TESTING)
       if (ss->fail_next_tail_write_armed) {
@@ -677,11 +926,8 @@ static void session_on_done(odin_connect_session_t *s,
       return;
     }
 #endif
-    if (odin_relay_create(relay_on_done, ss, &ss->relay) != 0) {
-      const int saved = errno;
-      fire_terminal(ss, saved);
-      return;
-    }
+    odin_relay_create_in(&session_storage(ss)->relay, relay_on_done, ss,
+                         &ss->relay);
 #if defined(ODIN_SERVER_SESSION_TESTING)
     if (ss->fail_next_relay_start_armed) {
       const int errnum = ss->fail_next_relay_start_errno;
@@ -711,20 +957,46 @@ static void relay_on_done(odin_relay_t *relay, odin_relay_status_t status,
   fire_terminal(ss, e);
 }
 
+static void dns_tunnel_on_done(odin_dns_tunnel_server_t *srv, int err,
+                               void *user_data) {
+  (void)srv;
+  odin_server_session_t *ss = (odin_server_session_t *)user_data;
+  fire_terminal(ss, err);
+}
+
+/* Completes the RFC-049 record; the relay must still be alive. A full ring
+ * drops the record and counts it. */
+static void append_access_log(odin_server_session_t *ss, int err) {
+  odin_access_log_record_t *rec = &ss->log_rec;
+  if (ss->relay != NULL) {
+    odin_relay_bytes(ss->relay, &rec->bytes_up, &rec->bytes_down);
+  }
+  rec->err = err;
+  odin_access_log_record_finish(rec);
+  (void)odin_access_log_append(ss->access_log, rec);
+}
+
 static void fire_terminal(odin_server_session_t *ss, int err) {
   if (ss->on_close_fired) {
     return;
   }
   ss->on_close_fired = 1;
   ss->state = ODIN_SERVER_SESSION_S_TERMINAL;
-  if (ss->dns_query != NULL) {
-    odin_dns_query_destroy(ss->dns_query);
-    ss->dns_query = NULL;
+  if (ss->access_log != NULL) {
+    append_access_log(ss, err);
+  }
+  if (ss->lookup != NULL) {
+    odin_dns_stream_destroy(ss->lookup);
+    ss->lookup = NULL;
   }
   if (ss->relay != NULL) {
     odin_relay_destroy(ss->relay);
     ss->relay = NULL;
   }
+  if (ss->dns_tunnel != NULL) {
+    odin_dns_tunnel_server_destroy(ss->dns_tunnel);
+    ss->dns_tunnel = NULL;
+  }
   if (ss->dial != NULL) {
     odin_dial_destroy(ss->dial);
     ss->dial = NULL;
@@ -737,14 +1009,8 @@ static void fire_terminal(odin_server_session_t *ss, int err) {
     odin_transport_destroy(ss->upstream_t);
     ss->upstream_t = NULL;
   }
-  if (ss->downstream_t != NULL) {
-    odin_transport_destroy(ss->downstream_t);
-    ss->downstream_t = NULL;
-  }
-  if (ss->dial_fd >= 0) {
-    (void)close(ss->dial_fd);
-    ss->dial_fd = -1;
-  }
+  destroy_downstream(ss);
+  close_dial_fd(ss);
   if (ss->conn_fd >= 0) {
     (void)close(ss->conn_fd);
     ss->conn_fd = -1;
@@ -753,6 +1019,7 @@ static void fire_terminal(odin_server_session_t *ss, int err) {
     odin_dns_resolver_destroy(ss->resolver);
     ss->resolver = NULL;
   }
+  ODIN_TRACE2(server__session__close, ss, err);
   const odin_server_session_close_cb cb = ss->on_close;
   void *const ud = ss->user_data;
   cb(ss, err, ud);
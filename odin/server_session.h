@@ -40,16 +40,66 @@
  * policy appropriate for the deployment. The setter is owner-thread and
  * replace-only; calling with cb == NULL clears any previously installed
  * filter. set_dial_filter is a no-op when ss == NULL.
+ *
+ * TCP Fast Open (RFC-036): odin_server_session_set_tfo_cache lends the session
+ * a shared odin_dial_tfo_cache_t. The upstream dial then offers the CONNECT
+ * tail -- bytes the client pipelined behind its request, such as a TLS
+ * ClientHello -- as SYN data, and only the part the SYN did not carry is
+ * written once the CONNECT_RESP has gone out. NULL (the default) dials
+ * without TFO. The cache must outlive the session; owner-thread, no-op when
+ * ss == NULL.
+ *
+ * Source addresses (RFC-037): odin_server_session_set_source_pool lends the
+ * session a shared odin_dial_source_pool_t. The upstream dial binds to one of
+ * its addresses, and the session returns that source's live count when it
+ * closes the upstream socket. NULL (the default) leaves the source to the
+ * kernel. Same lifetime and threading rules as the TFO cache.
+ *
+ * Downstream teardown (RFC-035): odin_server_session_set_downstream_destroying
+ * installs a hook the session calls with the downstream transport just before
+ * it destroys it, on close and on destroy alike, so the owner of a
+ * factory-built transport can hand on bytes the transport still holds -- such
+ * as an error response waiting in its coalescing buffer -- while the transport
+ * is alive. NULL (the default) calls nothing. Owner-thread; no-op when
+ * ss == NULL.
+ *
+ * Access log (RFC-049): odin_server_session_set_access_log lends the session
+ * the owner loop's odin_access_log_ring_t and names the client it serves
+ * (client may be NULL when unknown). Call it right after create: the record's
+ * start time is taken there. The session then records the CONNECT target,
+ * the address it dials and how long the dial took, and, on close, the relay's
+ * byte counts and the close errno, and appends one record just before
+ * on_close; a session destroyed before it closes appends its record with
+ * ECANCELED. NULL (the default) logs nothing. Same lifetime and threading
+ * rules as the TFO cache.
+ *
+ * Layout (RFC-033): a session and every per-connection sub-object it owns --
+ * the connect session, the dial, the fd transports, and the relay with its two
+ * 64 KiB buffers -- live in one odin_server_session_storage_t, so a CONNECT
+ * costs a single allocation. The create variants allocate that storage;
+ * odin_server_session_create_in runs the session in caller storage (e.g. a
+ * per-loop odin_slab_t block) and, instead of freeing it, hands it back through
+ * on_release at the point the allocating variants would free(3) -- after
+ * destroy, once the outermost session callback has unwound. on_release fires
+ * exactly once per successful create_in, including after an outside-callback
+ * destroy, where it fires before destroy returns. On create_in failure the
+ * storage is untouched by teardown and on_release never fires.
  */
 
 #ifndef ODIN_SERVER_SESSION_H_
 #define ODIN_SERVER_SESSION_H_
 
+#include <stdint.h>
 #include <sys/socket.h>
 
+#include "odin/access_log.h"
+#include "odin/connect_session.h"
+#include "odin/dial.h"
 #include "odin/dns_resolver.h"
 #include "odin/event_loop.h"
+#include "odin/relay.h"
 #include "odin/transport.h"
+#include "odin/transport_fd.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +113,28 @@ typedef struct odin_server_session_t odin_server_session_t;
 #define ODIN_SERVER_SESSION_RESP_CODE_ETIMEDOUT 0x0003u
 #define ODIN_SERVER_SESSION_RESP_CODE_OTHER 0x0004u
 
+/* Opaque session state, sized and aligned for the session object (checked at
+ * compile time in server_session.c). */
+#define ODIN_SERVER_SESSION_STATE_SIZE 656u
+
+/* One CONNECT's worth of memory: hot session state first, the relay's two
+ * buffers last. */
+typedef struct odin_server_session_storage_t {
+  union {
+    unsigned char bytes[ODIN_SERVER_SESSION_STATE_SIZE];
+    void *align_ptr;
+    uint64_t align_u64;
+  } state;
+  odin_connect_session_storage_t connect_session;
+  odin_dial_storage_t dial;
+  odin_fd_transport_storage_t downstream;
+  odin_fd_transport_storage_t upstream;
+  odin_relay_storage_t relay;
+} odin_server_session_storage_t;
+
+typedef void (*odin_server_session_release_cb)(
+    odin_server_session_storage_t *storage, void *user_data);
+
 typedef void (*odin_server_session_close_cb)(odin_server_session_t *ss, int err,
                                              void *user_data);
 
@@ -74,6 +146,9 @@ typedef int (*odin_server_session_transport_factory_cb)(
     odin_transport_ready_cb on_ready, void *ready_user_data,
     void *factory_user_data, odin_transport_t **out);
 
+typedef void (*odin_server_session_downstream_destroying_cb)(
+    odin_transport_t *transport, void *user_data);
+
 int odin_server_session_create(odin_event_loop_t *loop, int conn_fd,
                                odin_server_session_close_cb on_close,
                                void *user_data, odin_server_session_t **out);
@@ -96,10 +171,33 @@ int odin_server_session_create_with_transport_and_resolver(
     odin_server_session_close_cb on_close, void *user_data,
     odin_server_session_t **out);
 
+int odin_server_session_create_in(
+    odin_server_session_storage_t *storage,
+    odin_server_session_release_cb on_release, odin_event_loop_t *loop,
+    odin_server_session_transport_factory_cb create_downstream,
+    void *factory_user_data, odin_dns_resolver_t *resolver,
+    odin_server_session_close_cb on_close, void *user_data,
+    odin_server_session_t **out);
+
 void odin_server_session_set_dial_filter(odin_server_session_t *ss,
                                          odin_server_session_dial_filter_cb cb,
                                          void *user_data);
 
+void odin_server_session_set_downstream_destroying(
+    odin_server_session_t *ss, odin_server_session_downstream_destroying_cb cb,
+    void *user_data);
+
+void odin_server_session_set_tfo_cache(odin_server_session_t *ss,
+                                       odin_dial_tfo_cache_t *cache);
+
+void odin_server_session_set_source_pool(odin_server_session_t *ss,
+                                         odin_dial_source_pool_t *pool);
+
+void odin_server_session_set_access_log(odin_server_session_t *ss,
+                                        odin_access_log_ring_t *ring,
+                                        const struct sockaddr *client,
+                                        socklen_t client_len);
+
 void odin_server_session_destroy(odin_server_session_t *ss);
 
 #ifdef __cplusplus
@@ -4,20 +4,34 @@
 
 #include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "odin/dns_resolver.h"
+#include "odin/qlog.h"
+#include "odin/slab.h"
+#include "odin/trace.h"
 #include "odin/transport.h"
 #include "odin/transport_xqc.h"
+#include "odin/xqc_flush_timer.h"
 
 #if defined(ODIN_XQC_SERVER_RUNTIME_TESTING)
 #include "odin/testing/server_xqc_runtime_internal_test.h"
 #endif
 
+/* Released stream blocks kept per runtime (one runtime per loop) for reuse by
+ * the next stream; each block holds a stream context, its transport, and its
+ * whole server session (RFC-033). */
+#define ODIN_XQC_SERVER_STREAM_CACHE_MAX 64u
+
 typedef struct odin_xqc_server_conn_ctx_t odin_xqc_server_conn_ctx_t;
 typedef struct odin_xqc_server_stream_ctx_t odin_xqc_server_stream_ctx_t;
 
+/* One slab block per stream. refs counts the runtime's hold on the context
+ * plus the session's hold on its storage; the block returns to the slab when
+ * both are dropped, so a session whose free is deferred past the runtime's
+ * unlink never outlives its memory. */
 struct odin_xqc_server_stream_ctx_t {
   odin_xqc_server_conn_ctx_t *conn_ctx;
   odin_xqc_server_stream_ctx_t *conn_prev;
@@ -28,6 +42,10 @@ struct odin_xqc_server_stream_ctx_t {
   xqc_stream_t *stream;
   odin_transport_t *transport;
   odin_server_session_t *ss;
+  odin_slab_t *slab;
+  unsigned int refs;
+  odin_xqc_stream_transport_storage_t transport_storage;
+  odin_server_session_storage_t ss_storage;
 };
 
 struct odin_xqc_server_conn_ctx_t {
@@ -43,6 +61,10 @@ struct odin_xqc_server_conn_ctx_t {
   int destroy_snapshot_valid;
   int pre_destroy_closing;
   int destroy_close_requested;
+  int qlog_traced; /* RFC-050: qlog_cid is being traced */
+  xqc_cid_t qlog_cid;
+  int stats_retired; /* RFC-051: folded into rt->closed */
+  odin_xqc_send_backlog_t send_backlog; /* RFC-035 send probe */
 };
 
 struct odin_xqc_server_runtime_t {
@@ -55,6 +77,10 @@ struct odin_xqc_server_runtime_t {
   odin_xqc_server_stream_ctx_t *streams_by_transport;
   odin_server_session_dial_filter_cb dial_filter;
   void *dial_filter_ud;
+  odin_dial_tfo_cache_t *tfo_cache;
+  odin_dial_source_pool_t *sources;
+  odin_access_log_ring_t *access_log; /* RFC-049, lent; NULL: not logged */
+  odin_qlog_ring_t *qlog;             /* RFC-050, owned; NULL: off */
   unsigned int active_entries;
   int destroy_pending;
   int drain_active;
@@ -63,6 +89,9 @@ struct odin_xqc_server_runtime_t {
   int finish_destroy_in_progress;
   odin_xqc_server_conn_ctx_t *force_conns;
   odin_xqc_server_stream_ctx_t *force_streams;
+  odin_slab_t *stream_slab;
+  uint64_t conns_opened;             /* RFC-051 */
+  odin_xqc_runtime_totals_t closed; /* RFC-051: closed connections only */
 };
 
 static int runtime_server_accept(xqc_engine_t *engine, xqc_connection_t *conn,
@@ -80,6 +109,9 @@ static int runtime_conn_create_notify(xqc_connection_t *conn,
 static int runtime_conn_close_notify(xqc_connection_t *conn,
                                      const xqc_cid_t *cid, void *conn_user_data,
                                      void *conn_proto_data);
+static void runtime_conn_handshake_finished(xqc_connection_t *conn,
+                                            void *conn_user_data,
+                                            void *conn_proto_data);
 static xqc_int_t runtime_stream_create_notify(xqc_stream_t *stream,
                                               void *strm_user_data);
 static xqc_int_t runtime_stream_read_notify(xqc_stream_t *stream,
@@ -91,6 +123,8 @@ static xqc_int_t runtime_stream_close_notify(xqc_stream_t *stream,
 static void runtime_stream_closing_notify(xqc_stream_t *stream,
                                           xqc_int_t err_code,
                                           void *strm_user_data);
+static void runtime_stream_downstream_destroying(odin_transport_t *transport,
+                                                 void *user_data);
 static void runtime_stream_session_on_close(odin_server_session_t *ss, int err,
                                             void *user_data);
 
@@ -459,6 +493,82 @@ runtime_get_conn_alp_user_data_by_stream_call(xqc_stream_t *stream) {
 #endif
 }
 
+static xqc_int_t runtime_conn_get_peer_addr_call(xqc_connection_t *conn,
+                                                 struct sockaddr *addr,
+                                                 socklen_t addr_cap,
+                                                 socklen_t *addr_len) {
+#if defined(ODIN_XQC_SERVER_RUNTIME_TESTING)
+  if (g_server_xqc_test_ops.conn_get_peer_addr != NULL) {
+    return g_server_xqc_test_ops.conn_get_peer_addr(conn, addr, addr_cap,
+                                                    addr_len);
+  }
+#endif
+  return xqc_conn_get_peer_addr(conn, addr, addr_cap, addr_len);
+}
+
+static xqc_conn_stats_t runtime_conn_get_stats_call(xqc_engine_t *engine,
+                                                    const xqc_cid_t *cid) {
+#if defined(ODIN_XQC_SERVER_RUNTIME_TESTING)
+  if (g_server_xqc_test_ops.conn_get_stats != NULL) {
+    return g_server_xqc_test_ops.conn_get_stats(engine, cid);
+  }
+#endif
+  return xqc_conn_get_stats(engine, cid);
+}
+
+/* RFC-051: the live snapshot of one connection, less its peer. */
+static void runtime_conn_snapshot(const odin_xqc_server_conn_ctx_t *ctx,
+                                  odin_xqc_conn_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  const xqc_conn_stats_t st = runtime_conn_get_stats_call(
+      odin_xqc_udp_engine(ctx->rt->xu), &ctx->current_cid);
+  odin_xqc_conn_stats_fill(&st, out);
+  out->cid_len = ctx->current_cid.cid_len;
+  memcpy(out->cid, ctx->current_cid.cid_buf, ctx->current_cid.cid_len);
+  for (const odin_xqc_server_stream_ctx_t *stream_ctx = ctx->streams;
+       stream_ctx != NULL; stream_ctx = stream_ctx->conn_next) {
+    out->active_streams += 1;
+  }
+}
+
+/* RFC-051: folds a closing connection's counts into rt->closed while xquic
+ * still knows its CID. */
+static void runtime_conn_retire_stats(odin_xqc_server_conn_ctx_t *ctx) {
+  if (ctx->stats_retired) {
+    return;
+  }
+  ctx->stats_retired = 1;
+  odin_xqc_conn_stats_t snap;
+  runtime_conn_snapshot(ctx, &snap);
+  odin_xqc_runtime_totals_add(&ctx->rt->closed, &snap);
+}
+
+/* RFC-050: decides once, at accept, whether the connection is traced. */
+static void runtime_qlog_begin(odin_xqc_server_conn_ctx_t *ctx,
+                               const xqc_cid_t *cid) {
+  if (ctx->rt->qlog == NULL) {
+    return;
+  }
+  struct sockaddr_storage peer;
+  socklen_t peer_len = 0;
+  if (runtime_conn_get_peer_addr_call(ctx->conn, (struct sockaddr *)&peer,
+                                      sizeof(peer), &peer_len) != XQC_OK) {
+    peer_len = 0;
+  }
+  ctx->qlog_cid = *cid;
+  ctx->qlog_traced = odin_qlog_conn_begin(
+      ctx->rt->qlog, cid->cid_buf, cid->cid_len,
+      peer_len > 0 ? (const struct sockaddr *)&peer : NULL, peer_len);
+}
+
+static void runtime_qlog_end(odin_xqc_server_conn_ctx_t *ctx) {
+  if (ctx->qlog_traced) {
+    odin_qlog_conn_end(ctx->rt->qlog, ctx->qlog_cid.cid_buf,
+                       ctx->qlog_cid.cid_len);
+    ctx->qlog_traced = 0;
+  }
+}
+
 static xqc_int_t runtime_stream_close_call(xqc_stream_t *stream) {
 #if defined(ODIN_XQC_SERVER_RUNTIME_TESTING)
   odin_xqc_server_runtime_test_call_t *call =
@@ -485,11 +595,25 @@ static void runtime_callback_enter(odin_xqc_server_runtime_t *rt) {
   rt->active_entries += 1;
 }
 
+static void runtime_stream_ctx_put(odin_xqc_server_stream_ctx_t *stream_ctx) {
+  stream_ctx->refs -= 1;
+  if (stream_ctx->refs == 0) {
+    odin_slab_free(stream_ctx->slab, stream_ctx);
+  }
+}
+
+static void
+runtime_stream_session_on_release(odin_server_session_storage_t *storage,
+                                  void *user_data) {
+  (void)storage;
+  runtime_stream_ctx_put((odin_xqc_server_stream_ctx_t *)user_data);
+}
+
 static void runtime_free_force_pending(odin_xqc_server_runtime_t *rt) {
   while (rt->force_streams != NULL) {
     odin_xqc_server_stream_ctx_t *stream_ctx = rt->force_streams;
     rt->force_streams = stream_ctx->force_next;
-    free(stream_ctx);
+    runtime_stream_ctx_put(stream_ctx);
   }
   while (rt->force_conns != NULL) {
     odin_xqc_server_conn_ctx_t *ctx = rt->force_conns;
@@ -513,7 +637,11 @@ static void runtime_finish_destroy(odin_xqc_server_runtime_t *rt) {
     runtime_udp_destroy_call(rt->xu);
     rt->xu = NULL;
   }
+  odin_qlog_ring_destroy(rt->qlog);
+  rt->qlog = NULL;
   runtime_free_force_pending(rt);
+  odin_slab_destroy(rt->stream_slab);
+  rt->stream_slab = NULL;
   if (rt->resolver != NULL) {
     odin_dns_resolver_destroy(rt->resolver);
     rt->resolver = NULL;
@@ -547,15 +675,31 @@ runtime_stream_ctx_unlink(odin_xqc_server_stream_ctx_t *stream_ctx) {
   stream_ctx->rt_next = NULL;
 }
 
+/* RFC-035: forgets the stream's transport ahead of its destroy, counting the
+ * bytes it still holds as lost when nothing more may be sent. */
+static void
+runtime_stream_drop_transport(odin_xqc_server_stream_ctx_t *stream_ctx) {
+  if (stream_ctx->transport == NULL) {
+    return;
+  }
+  stream_ctx->conn_ctx->rt->closed.bytes_unsent +=
+      odin_xqc_stream_transport_unsent(stream_ctx->transport);
+  stream_ctx->transport = NULL;
+}
+
+/* Runs from xquic's close callbacks, where nothing may be sent: the transport
+ * is dropped before the session destroys it, so the session's
+ * downstream-destroying hook does not flush. */
 static void
 runtime_destroy_stream_session(odin_xqc_server_stream_ctx_t *stream_ctx) {
   odin_server_session_t *ss = stream_ctx->ss;
   stream_ctx->ss = NULL;
   runtime_stream_ctx_unlink(stream_ctx);
+  runtime_stream_drop_transport(stream_ctx);
   if (ss != NULL) {
     odin_server_session_destroy(ss);
   }
-  free(stream_ctx);
+  runtime_stream_ctx_put(stream_ctx);
 }
 
 static void runtime_destroy_all_streams(odin_xqc_server_conn_ctx_t *ctx) {
@@ -699,16 +843,43 @@ runtime_conn_ctx_from_stream(xqc_stream_t *stream) {
       runtime_get_conn_alp_user_data_by_stream_call(stream);
 }
 
+/* RFC-035 send probe: the bytes xquic holds for the connection, queued or
+ * unacknowledged, which the stream transport's send watermarks compare
+ * against. */
+static uint64_t runtime_send_unacked(void *user_data) {
+  odin_xqc_server_conn_ctx_t *ctx = (odin_xqc_server_conn_ctx_t *)user_data;
+  const xqc_conn_stats_t st = runtime_conn_get_stats_call(
+      odin_xqc_udp_engine(ctx->rt->xu), &ctx->current_cid);
+  return odin_xqc_send_backlog_update(&ctx->send_backlog, &st);
+}
+
+static void runtime_send_accepted(void *user_data, size_t n) {
+  odin_xqc_server_conn_ctx_t *ctx = (odin_xqc_server_conn_ctx_t *)user_data;
+  odin_xqc_send_backlog_accepted(&ctx->send_backlog, n);
+}
+
+static void runtime_enable_coalescing(odin_xqc_server_conn_ctx_t *ctx,
+                                      odin_transport_t *t) {
+  odin_xqc_flush_timer_install(t, ctx->rt->loop);
+  odin_xqc_send_probe_t probe;
+  probe.unacked = runtime_send_unacked;
+  probe.accepted = runtime_send_accepted;
+  probe.ctx = ctx;
+  odin_xqc_stream_transport_set_send_probe(t, &probe);
+}
+
 static int xqc_stream_transport_factory(odin_transport_ready_cb on_ready,
                                         void *ready_user_data,
                                         void *factory_user_data,
                                         odin_transport_t **out) {
   odin_xqc_server_stream_ctx_t *stream_ctx =
       (odin_xqc_server_stream_ctx_t *)factory_user_data;
-  if (odin_xqc_stream_transport_create(stream_ctx->stream, on_ready,
-                                       ready_user_data, out) != 0) {
+  if (odin_xqc_stream_transport_create_in(&stream_ctx->transport_storage,
+                                          stream_ctx->stream, on_ready,
+                                          ready_user_data, out) != 0) {
     return -1;
   }
+  runtime_enable_coalescing(stream_ctx->conn_ctx, *out);
   stream_ctx->transport = *out;
   return 0;
 }
@@ -733,6 +904,8 @@ int odin_xqc_server_runtime_create(
   rt->transport_callbacks.conn_update_cid_notify = runtime_conn_update_cid;
   rt->app_callbacks.conn_cbs.conn_create_notify = runtime_conn_create_notify;
   rt->app_callbacks.conn_cbs.conn_close_notify = runtime_conn_close_notify;
+  rt->app_callbacks.conn_cbs.conn_handshake_finished =
+      runtime_conn_handshake_finished;
   rt->app_callbacks.stream_cbs.stream_read_notify = runtime_stream_read_notify;
   rt->app_callbacks.stream_cbs.stream_write_notify =
       runtime_stream_write_notify;
@@ -743,8 +916,37 @@ int odin_xqc_server_runtime_create(
   rt->app_callbacks.stream_cbs.stream_closing_notify =
       runtime_stream_closing_notify;
 
+  if (odin_slab_create(sizeof(odin_xqc_server_stream_ctx_t),
+                       ODIN_XQC_SERVER_STREAM_CACHE_MAX,
+                       &rt->stream_slab) != 0) {
+    const int saved = errno;
+    free(rt);
+    errno = saved;
+    return -1;
+  }
   if (odin_dns_resolver_create(config->loop, NULL, &rt->resolver) != 0) {
     const int saved = errno;
+    odin_slab_destroy(rt->stream_slab);
+    free(rt);
+    errno = saved;
+    return -1;
+  }
+  /* Every stream resolves its CONNECT target through this resolver; cache
+   * answers and keep hot names fresh (RFC-044). */
+  if (odin_dns_resolver_set_cache(rt->resolver, NULL) != 0) {
+    const int saved = errno;
+    odin_dns_resolver_destroy(rt->resolver);
+    odin_slab_destroy(rt->stream_slab);
+    free(rt);
+    errno = saved;
+    return -1;
+  }
+
+  if (config->qlog != NULL &&
+      odin_qlog_ring_create(config->qlog, 0, &rt->qlog) != 0) {
+    const int saved = errno;
+    odin_dns_resolver_destroy(rt->resolver);
+    odin_slab_destroy(rt->stream_slab);
     free(rt);
     errno = saved;
     return -1;
@@ -761,9 +963,12 @@ int odin_xqc_server_runtime_create(
   udp_config.engine_callbacks = config->engine_callbacks;
   udp_config.transport_callbacks = &rt->transport_callbacks;
   udp_config.app_user_data = rt;
+  udp_config.qlog = rt->qlog;
   if (runtime_udp_create_call(&udp_config, &rt->xu) != 0) {
     const int saved = errno;
+    odin_qlog_ring_destroy(rt->qlog);
     odin_dns_resolver_destroy(rt->resolver);
+    odin_slab_destroy(rt->stream_slab);
     free(rt);
     errno = saved;
     return -1;
@@ -773,7 +978,9 @@ int odin_xqc_server_runtime_create(
                                         sizeof(ODIN_XQC_SERVER_ALPN) - 1u,
                                         &rt->app_callbacks, rt) != XQC_OK) {
     runtime_udp_destroy_call(rt->xu);
+    odin_qlog_ring_destroy(rt->qlog);
     odin_dns_resolver_destroy(rt->resolver);
+    odin_slab_destroy(rt->stream_slab);
     free(rt);
     errno = EIO;
     return -1;
@@ -827,6 +1034,84 @@ void odin_xqc_server_runtime_set_dial_filter(
   rt->dial_filter_ud = cb == NULL ? NULL : user_data;
 }
 
+void odin_xqc_server_runtime_set_tfo_cache(odin_xqc_server_runtime_t *rt,
+                                           odin_dial_tfo_cache_t *cache) {
+  if (rt == NULL) {
+    return;
+  }
+  rt->tfo_cache = cache;
+}
+
+void odin_xqc_server_runtime_set_source_pool(odin_xqc_server_runtime_t *rt,
+                                             odin_dial_source_pool_t *pool) {
+  if (rt == NULL) {
+    return;
+  }
+  rt->sources = pool;
+}
+
+void odin_xqc_server_runtime_set_access_log(odin_xqc_server_runtime_t *rt,
+                                            odin_access_log_ring_t *ring) {
+  if (rt == NULL) {
+    return;
+  }
+  rt->access_log = ring;
+}
+
+void odin_xqc_server_runtime_dns_stats(const odin_xqc_server_runtime_t *rt,
+                                       odin_dns_cache_stats_t *out) {
+  odin_dns_resolver_cache_stats(rt != NULL ? rt->resolver : NULL, out);
+}
+
+int odin_xqc_server_runtime_stats(const odin_xqc_server_runtime_t *rt,
+                                  odin_xqc_conn_stats_t *out, size_t cap,
+                                  size_t *count) {
+  if (rt == NULL || (out == NULL && cap > 0) || count == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t n = 0;
+  for (const odin_xqc_server_conn_ctx_t *ctx = rt->connections; ctx != NULL;
+       ctx = ctx->next) {
+    if (n < cap) {
+      odin_xqc_conn_stats_t *snap = &out[n];
+      runtime_conn_snapshot(ctx, snap);
+      socklen_t peer_len = 0;
+      if (runtime_conn_get_peer_addr_call(ctx->conn,
+                                          (struct sockaddr *)&snap->peer,
+                                          sizeof(snap->peer),
+                                          &peer_len) == XQC_OK) {
+        snap->peer_len = peer_len;
+      }
+    }
+    n += 1;
+  }
+  *count = n;
+  return 0;
+}
+
+int odin_xqc_server_runtime_totals(const odin_xqc_server_runtime_t *rt,
+                                   odin_xqc_runtime_totals_t *out) {
+  if (rt == NULL || out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  *out = rt->closed;
+  out->conns_opened = rt->conns_opened;
+  for (const odin_xqc_server_conn_ctx_t *ctx = rt->connections; ctx != NULL;
+       ctx = ctx->next) {
+    odin_xqc_conn_stats_t snap;
+    runtime_conn_snapshot(ctx, &snap);
+    odin_xqc_runtime_totals_add(out, &snap);
+    out->conns_active += 1;
+    out->streams_active += snap.active_streams;
+    if (snap.srtt_us > out->srtt_us_max) {
+      out->srtt_us_max = snap.srtt_us;
+    }
+  }
+  return 0;
+}
+
 void odin_xqc_server_runtime_destroy(odin_xqc_server_runtime_t *rt) {
   if (rt == NULL) {
     return;
@@ -856,10 +1141,10 @@ void odin_xqc_server_runtime_force_destroy(odin_xqc_server_runtime_t *rt) {
       odin_xqc_server_stream_ctx_t *stream_ctx = ctx->streams;
       odin_server_session_t *ss = stream_ctx->ss;
       stream_ctx->ss = NULL;
+      runtime_stream_drop_transport(stream_ctx);
       if (ss != NULL) {
         odin_server_session_destroy(ss);
       }
-      stream_ctx->transport = NULL;
       runtime_stream_ctx_unlink(stream_ctx);
       stream_ctx->force_next = rt->force_streams;
       rt->force_streams = stream_ctx;
@@ -936,9 +1221,11 @@ static int runtime_server_accept(xqc_engine_t *engine, xqc_connection_t *conn,
     rt->connections->prev = ctx;
   }
   rt->connections = ctx;
+  rt->conns_opened += 1;
   runtime_conn_set_transport_user_data_call(conn,
                                             odin_xqc_udp_xqc_user_data(xu));
   runtime_conn_set_alp_user_data_call(conn, ctx);
+  runtime_qlog_begin(ctx, cid);
   if (rt->destroy_pending) {
     ctx->pre_destroy_closing = ctx->closing;
     ctx->destroy_snapshot_valid = 1;
@@ -964,6 +1251,7 @@ static void runtime_server_refuse(xqc_engine_t *engine, xqc_connection_t *conn,
   runtime_callback_enter(rt);
   odin_xqc_server_conn_ctx_t *ctx = runtime_find_conn_by_conn(rt, conn);
   if (ctx != NULL) {
+    runtime_qlog_end(ctx);
     if (rt->force_destroy_active) {
       if (ctx->cid_registered) {
         runtime_udp_unregister_conn_call(ctx->rt->xu, &ctx->current_cid);
@@ -973,6 +1261,7 @@ static void runtime_server_refuse(xqc_engine_t *engine, xqc_connection_t *conn,
       (void)runtime_callback_leave(rt);
       return;
     }
+    runtime_conn_retire_stats(ctx);
     runtime_destroy_all_streams(ctx);
     if (ctx->cid_registered) {
       runtime_udp_unregister_conn_call(ctx->rt->xu, &ctx->current_cid);
@@ -1045,6 +1334,9 @@ static int runtime_conn_create_notify(xqc_connection_t *conn,
   odin_xqc_server_conn_ctx_t *ctx =
       runtime_find_conn_by_proto_data(rt, conn, conn_proto_data);
   const int ok = ctx != NULL;
+  if (ok) {
+    ODIN_TRACE2(quic__conn__create, conn, 1);
+  }
   (void)runtime_callback_leave(rt);
   return ok ? 0 : -1;
 }
@@ -1069,6 +1361,8 @@ static int runtime_conn_close_notify(xqc_connection_t *conn,
     ctx = runtime_find_conn_by_conn(rt, conn);
   }
   if (ctx != NULL) {
+    ODIN_TRACE2(quic__conn__close, conn, 1);
+    runtime_qlog_end(ctx);
     if (rt->force_destroy_active) {
       if (ctx->cid_registered) {
         runtime_udp_unregister_conn_call(ctx->rt->xu, &ctx->current_cid);
@@ -1078,6 +1372,7 @@ static int runtime_conn_close_notify(xqc_connection_t *conn,
       (void)runtime_callback_leave(rt);
       return 0;
     }
+    runtime_conn_retire_stats(ctx);
     runtime_destroy_all_streams(ctx);
     if (ctx->cid_registered) {
       runtime_udp_unregister_conn_call(ctx->rt->xu, &ctx->current_cid);
@@ -1090,6 +1385,16 @@ static int runtime_conn_close_notify(xqc_connection_t *conn,
   return 0;
 }
 
+/* The server needs nothing at handshake completion; the callback exists for
+ * the RFC-048 probe. */
+static void runtime_conn_handshake_finished(xqc_connection_t *conn,
+                                            void *conn_user_data,
+                                            void *conn_proto_data) {
+  (void)conn_user_data;
+  (void)conn_proto_data;
+  ODIN_TRACE2(quic__handshake__done, conn, 1);
+}
+
 static xqc_int_t runtime_stream_create_notify(xqc_stream_t *stream,
                                               void *strm_user_data) {
   (void)strm_user_data;
@@ -1120,25 +1425,48 @@ static xqc_int_t runtime_stream_create_notify(xqc_stream_t *stream,
   }
 #endif
   odin_xqc_server_stream_ctx_t *stream_ctx =
-      (odin_xqc_server_stream_ctx_t *)calloc(1, sizeof(*stream_ctx));
+      (odin_xqc_server_stream_ctx_t *)odin_slab_alloc(rt->stream_slab);
   if (stream_ctx == NULL) {
     (void)runtime_stream_close_call(stream);
     (void)runtime_callback_leave(rt);
     return XQC_OK;
   }
+  /* Only the context header needs zeroing; the transport and session
+   * initialize their own slots. */
+  memset(stream_ctx, 0,
+         offsetof(odin_xqc_server_stream_ctx_t, transport_storage));
   stream_ctx->conn_ctx = ctx;
   stream_ctx->stream = stream;
-  if (odin_server_session_create_with_transport_and_resolver(
-          rt->loop, xqc_stream_transport_factory, stream_ctx, rt->resolver,
+  stream_ctx->slab = rt->stream_slab;
+  stream_ctx->refs = 1;
+  if (odin_server_session_create_in(
+          &stream_ctx->ss_storage, runtime_stream_session_on_release, rt->loop,
+          xqc_stream_transport_factory, stream_ctx, rt->resolver,
           runtime_stream_session_on_close, stream_ctx, &stream_ctx->ss) != 0) {
     stream_ctx->transport = NULL;
     (void)runtime_stream_close_call(stream);
-    free(stream_ctx);
+    runtime_stream_ctx_put(stream_ctx);
     (void)runtime_callback_leave(rt);
     return XQC_OK;
   }
+  stream_ctx->refs += 1;
+  odin_server_session_set_downstream_destroying(
+      stream_ctx->ss, runtime_stream_downstream_destroying, stream_ctx);
   odin_server_session_set_dial_filter(stream_ctx->ss, rt->dial_filter,
                                       rt->dial_filter_ud);
+  odin_server_session_set_tfo_cache(stream_ctx->ss, rt->tfo_cache);
+  odin_server_session_set_source_pool(stream_ctx->ss, rt->sources);
+  if (rt->access_log != NULL) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = 0;
+    if (runtime_conn_get_peer_addr_call(ctx->conn, (struct sockaddr *)&peer,
+                                        sizeof(peer), &peer_len) != XQC_OK) {
+      peer_len = 0;
+    }
+    odin_server_session_set_access_log(
+        stream_ctx->ss, rt->access_log,
+        peer_len > 0 ? (const struct sockaddr *)&peer : NULL, peer_len);
+  }
   stream_ctx->conn_next = ctx->streams;
   if (ctx->streams != NULL) {
     ctx->streams->conn_prev = stream_ctx;
@@ -1226,6 +1554,21 @@ static void runtime_stream_closing_notify(xqc_stream_t *stream,
   (void)runtime_callback_leave(rt);
 }
 
+/* RFC-035: the session is about to destroy the stream's transport. Outside
+ * xquic's close callbacks the stream may still send, so the coalesced bytes
+ * -- an error RESP, the relay's last write -- and a pending fin go to xquic
+ * first; whatever xquic will not take is counted as lost. */
+static void runtime_stream_downstream_destroying(odin_transport_t *transport,
+                                                 void *user_data) {
+  odin_xqc_server_stream_ctx_t *stream_ctx =
+      (odin_xqc_server_stream_ctx_t *)user_data;
+  if (stream_ctx->transport != transport) {
+    return;
+  }
+  (void)odin_xqc_stream_transport_flush(transport);
+  runtime_stream_drop_transport(stream_ctx);
+}
+
 static void runtime_stream_session_on_close(odin_server_session_t *ss, int err,
                                             void *user_data) {
   odin_xqc_server_stream_ctx_t *stream_ctx =
@@ -1236,6 +1579,6 @@ static void runtime_stream_session_on_close(odin_server_session_t *ss, int err,
     (void)runtime_stream_close_call(stream_ctx->stream);
   }
   odin_server_session_destroy(ss);
-  free(stream_ctx);
+  runtime_stream_ctx_put(stream_ctx);
   (void)runtime_maybe_finish_destroy(rt);
 }
@@ -5,8 +5,12 @@
 
 #include <sys/socket.h>
 
+#include "odin/access_log.h"
+#include "odin/dns_resolver.h"
 #include "odin/event_loop.h"
+#include "odin/qlog.h"
 #include "odin/server_session.h"
+#include "odin/xqc_conn_stats.h"
 #include "odin/xqc_udp.h"
 #include <xquic/xquic.h>
 
@@ -25,6 +29,9 @@ typedef struct odin_xqc_server_runtime_config_t {
   const xqc_config_t *engine_config;
   const xqc_engine_ssl_config_t *ssl_config;
   const xqc_engine_callback_t *engine_callbacks;
+  /* RFC-050: optional, lent; must outlive the runtime. The runtime traces a
+   * sample of its connections into it through a ring of its own. */
+  odin_qlog_t *qlog;
 } odin_xqc_server_runtime_config_t;
 
 int odin_xqc_server_runtime_create(
@@ -38,6 +45,33 @@ int odin_xqc_server_runtime_local_addr(odin_xqc_server_runtime_t *rt,
 void odin_xqc_server_runtime_set_dial_filter(
     odin_xqc_server_runtime_t *rt, odin_server_session_dial_filter_cb cb,
     void *user_data);
+/* Lends every later stream's server session the TFO cache (RFC-036); NULL
+ * turns TFO off. The cache must outlive the runtime and its sessions. */
+void odin_xqc_server_runtime_set_tfo_cache(odin_xqc_server_runtime_t *rt,
+                                           odin_dial_tfo_cache_t *cache);
+/* Lends every later stream's server session the egress source pool (RFC-037);
+ * NULL lets the kernel pick. The pool must outlive the runtime and its
+ * sessions. */
+void odin_xqc_server_runtime_set_source_pool(odin_xqc_server_runtime_t *rt,
+                                             odin_dial_source_pool_t *pool);
+/* Lends every later stream's server session the loop's RFC-049 access-log
+ * ring, with the connection's peer as the client; NULL logs nothing. The
+ * ring must outlive the runtime and its sessions. */
+void odin_xqc_server_runtime_set_access_log(odin_xqc_server_runtime_t *rt,
+                                            odin_access_log_ring_t *ring);
+/* Snapshot of the runtime's CONNECT resolver cache (RFC-044); zeroes when rt
+ * is NULL. */
+void odin_xqc_server_runtime_dns_stats(const odin_xqc_server_runtime_t *rt,
+                                       odin_dns_cache_stats_t *out);
+/* RFC-051: fills out[0..cap) with one snapshot per live connection, without
+ * allocating, and sets *count to the number of live connections, which may
+ * exceed cap. Call on the loop thread. */
+int odin_xqc_server_runtime_stats(const odin_xqc_server_runtime_t *rt,
+                                  odin_xqc_conn_stats_t *out, size_t cap,
+                                  size_t *count);
+/* RFC-051: runtime-wide aggregates over live and closed connections. */
+int odin_xqc_server_runtime_totals(const odin_xqc_server_runtime_t *rt,
+                                   odin_xqc_runtime_totals_t *out);
 void odin_xqc_server_runtime_destroy(odin_xqc_server_runtime_t *rt);
 void odin_xqc_server_runtime_force_destroy(odin_xqc_server_runtime_t *rt);
 
@@ -0,0 +1,60 @@
+/* odin/slab.h
+ *
+ * Per-loop fixed-size block cache (RFC-033).
+ *
+ * An odin_slab_t hands out blocks of one fixed size and keeps released blocks
+ * on an intrusive free list for reuse, so a per-connection object graph carved
+ * from one block costs one allocation the first time a block is needed and
+ * none once the cache is warm. Up to cache_max released blocks are retained;
+ * any beyond that go straight back to free(3). Blocks are aligned as malloc(3)
+ * aligns, and their contents are unspecified on return from odin_slab_alloc.
+ *
+ * Ownership: each block belongs to the caller from odin_slab_alloc until
+ * odin_slab_free. odin_slab_destroy frees every cached block; if blocks are
+ * still outstanding the slab lingers, and the odin_slab_free that returns the
+ * last one frees it. No block may be freed to a slab other than the one that
+ * allocated it. odin_slab_destroy(NULL) is a no-op.
+ *
+ * Threading: a slab belongs to one owner thread (one event loop); it adds no
+ * locks.
+ */
+
+#ifndef ODIN_SLAB_H_
+#define ODIN_SLAB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct odin_slab_t odin_slab_t;
+
+typedef struct odin_slab_stats_t {
+  size_t live;         /* blocks currently held by callers         */
+  size_t cached;       /* released blocks waiting on the free list */
+  uint64_t allocs;     /* odin_slab_alloc successes                */
+  uint64_t cache_hits; /* allocs served from the free list         */
+} odin_slab_stats_t;
+
+/* block_size must be non-zero; it is rounded up to pointer alignment. Returns
+ * 0, or -1 with errno EINVAL / ENOMEM. */
+int odin_slab_create(size_t block_size, size_t cache_max, odin_slab_t **out);
+
+/* Returns a block, or NULL with errno == ENOMEM. */
+void *odin_slab_alloc(odin_slab_t *slab);
+
+/* Returns block to the cache (or to free(3) past cache_max).
+ * odin_slab_free(slab, NULL) is a no-op. */
+void odin_slab_free(odin_slab_t *slab, void *block);
+
+void odin_slab_stats(const odin_slab_t *slab, odin_slab_stats_t *out);
+
+void odin_slab_destroy(odin_slab_t *slab);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_SLAB_H_ */
@@ -0,0 +1,142 @@
+/* odin/socks5.c -- SOCKS5 CONNECT handshake parser (RFC-041). */
+
+#include "odin/socks5.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const uint8_t kMethodOk[ODIN_SOCKS5_METHOD_REPLY_LEN] = {0x05, 0x00};
+static const uint8_t kMethodNone[ODIN_SOCKS5_METHOD_REPLY_LEN] = {0x05, 0xFF};
+
+odin_socks5_status_t odin_socks5_parse_greeting(const uint8_t *buf, size_t n,
+                                                size_t *out_consumed) {
+  assert(buf != NULL || n == 0);
+  assert(out_consumed != NULL);
+
+  if (n < 1) {
+    return ODIN_SOCKS5_NEED_MORE;
+  }
+  if (buf[0] != ODIN_SOCKS5_VERSION) {
+    return ODIN_SOCKS5_ERR_BAD_VERSION;
+  }
+  if (n < 2) {
+    return ODIN_SOCKS5_NEED_MORE;
+  }
+  const size_t nmethods = buf[1];
+  if (nmethods == 0) {
+    return ODIN_SOCKS5_ERR_NO_METHOD;
+  }
+  if (n < 2 + nmethods) {
+    return ODIN_SOCKS5_NEED_MORE;
+  }
+  if (memchr(buf + 2, 0x00, nmethods) == NULL) {
+    return ODIN_SOCKS5_ERR_NO_METHOD;
+  }
+  *out_consumed = 2 + nmethods;
+  return ODIN_SOCKS5_OK;
+}
+
+odin_socks5_status_t odin_socks5_parse_request(const uint8_t *buf, size_t n,
+                                               size_t *out_consumed,
+                                               odin_socks5_request_t *out) {
+  assert(buf != NULL || n == 0);
+  assert(out_consumed != NULL);
+  assert(out != NULL);
+
+  /* Fixed header VER CMD RSV ATYP, checked byte by byte so a bad request
+   * fails as soon as its first wrong byte arrives. */
+  if (n >= 1 && buf[0] != ODIN_SOCKS5_VERSION) {
+    return ODIN_SOCKS5_ERR_BAD_VERSION;
+  }
+  if (n >= 2 && buf[1] != 0x01) {
+    return ODIN_SOCKS5_ERR_BAD_COMMAND;
+  }
+  if (n >= 3 && buf[2] != 0x00) {
+    return ODIN_SOCKS5_ERR_BAD_VERSION;
+  }
+  if (n < 4) {
+    return ODIN_SOCKS5_NEED_MORE;
+  }
+
+  size_t addr_off = 4;
+  size_t addr_len = 0;
+  switch (buf[3]) {
+  case ODIN_SOCKS5_ATYP_IPV4:
+    addr_len = 4;
+    break;
+  case ODIN_SOCKS5_ATYP_IPV6:
+    addr_len = 16;
+    break;
+  case ODIN_SOCKS5_ATYP_DOMAIN:
+    if (n < 5) {
+      return ODIN_SOCKS5_NEED_MORE;
+    }
+    addr_off = 5;
+    addr_len = buf[4];
+    if (addr_len == 0) {
+      return ODIN_SOCKS5_ERR_HOST_LEN_INVALID;
+    }
+    break;
+  default:
+    return ODIN_SOCKS5_ERR_BAD_ADDR_TYPE;
+  }
+
+  const size_t end = addr_off + addr_len + 2;
+  if (n < end) {
+    return ODIN_SOCKS5_NEED_MORE;
+  }
+  const uint16_t port =
+      (uint16_t)(((uint16_t)buf[end - 2] << 8) | (uint16_t)buf[end - 1]);
+  if (port == 0) {
+    return ODIN_SOCKS5_ERR_PORT_INVALID;
+  }
+
+  *out_consumed = end;
+  out->atyp = buf[3];
+  out->addr_off = addr_off;
+  out->addr_len = addr_len;
+  out->port = port;
+  return ODIN_SOCKS5_OK;
+}
+
+const uint8_t *odin_socks5_method_reply(int acceptable) {
+  return acceptable ? kMethodOk : kMethodNone;
+}
+
+void odin_socks5_write_reply(uint8_t rep, uint8_t *out) {
+  assert(out != NULL);
+  memset(out, 0, ODIN_SOCKS5_REPLY_LEN);
+  out[0] = ODIN_SOCKS5_VERSION;
+  out[1] = rep;
+  out[3] = ODIN_SOCKS5_ATYP_IPV4;
+}
+
+uint8_t odin_socks5_rep_for_errno(int err) {
+  switch (err) {
+  case 0:
+    return ODIN_SOCKS5_REP_SUCCEEDED;
+  case EACCES:
+  case EPERM:
+    return ODIN_SOCKS5_REP_NOT_ALLOWED;
+  case ENETUNREACH:
+  case ENETDOWN:
+    return ODIN_SOCKS5_REP_NETWORK_UNREACHABLE;
+  case EHOSTUNREACH:
+  case EHOSTDOWN:
+  case ENOENT: /* name did not resolve */
+    return ODIN_SOCKS5_REP_HOST_UNREACHABLE;
+  case ECONNREFUSED:
+    return ODIN_SOCKS5_REP_CONNECTION_REFUSED;
+  case ETIMEDOUT:
+    return ODIN_SOCKS5_REP_TTL_EXPIRED;
+  case EOPNOTSUPP:
+    return ODIN_SOCKS5_REP_COMMAND_NOT_SUPPORTED;
+  case EAFNOSUPPORT:
+    return ODIN_SOCKS5_REP_ADDRESS_TYPE_NOT_SUPPORTED;
+  default:
+    return ODIN_SOCKS5_REP_GENERAL_FAILURE;
+  }
+}
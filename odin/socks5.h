@@ -0,0 +1,94 @@
+/* odin/socks5.h
+ *
+ * Pure byte-buffer parser for the SOCKS5 CONNECT handshake (RFC-041,
+ * RFC 1928).
+ *
+ * Accepted grammar:
+ *
+ *   greeting = VER NMETHODS 1*255METHODS   ; VER = %x05, NMETHODS >= 1
+ *   request  = VER CMD RSV ATYP DST.ADDR DST.PORT
+ *   CMD      = %x01                        ; CONNECT only
+ *   RSV      = %x00
+ *   ATYP     = %x01 4OCTET                 ; IPv4
+ *            / %x03 LEN 1*255OCTET         ; domain name, LEN >= 1
+ *            / %x04 16OCTET                ; IPv6
+ *   DST.PORT = 2OCTET                      ; network order, nonzero
+ *
+ * Only METHOD %x00 (no authentication) is offered. Both parsers read from
+ * the start of buf each call and never allocate: call again with more bytes
+ * after ODIN_SOCKS5_NEED_MORE, exactly like odin_http_parse_connect. A client
+ * may pipeline the request and its first payload bytes behind the greeting
+ * without waiting for the method reply; *out_consumed marks where the payload
+ * starts.
+ */
+
+#ifndef ODIN_SOCKS5_H_
+#define ODIN_SOCKS5_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_SOCKS5_VERSION 0x05u
+#define ODIN_SOCKS5_METHOD_REPLY_LEN 2u
+#define ODIN_SOCKS5_REPLY_LEN 10u
+
+#define ODIN_SOCKS5_ATYP_IPV4 0x01u
+#define ODIN_SOCKS5_ATYP_DOMAIN 0x03u
+#define ODIN_SOCKS5_ATYP_IPV6 0x04u
+
+/* REP values (RFC 1928 §6). */
+#define ODIN_SOCKS5_REP_SUCCEEDED 0x00u
+#define ODIN_SOCKS5_REP_GENERAL_FAILURE 0x01u
+#define ODIN_SOCKS5_REP_NOT_ALLOWED 0x02u
+#define ODIN_SOCKS5_REP_NETWORK_UNREACHABLE 0x03u
+#define ODIN_SOCKS5_REP_HOST_UNREACHABLE 0x04u
+#define ODIN_SOCKS5_REP_CONNECTION_REFUSED 0x05u
+#define ODIN_SOCKS5_REP_TTL_EXPIRED 0x06u
+#define ODIN_SOCKS5_REP_COMMAND_NOT_SUPPORTED 0x07u
+#define ODIN_SOCKS5_REP_ADDRESS_TYPE_NOT_SUPPORTED 0x08u
+
+typedef enum {
+  ODIN_SOCKS5_OK = 0,
+  ODIN_SOCKS5_NEED_MORE,
+  ODIN_SOCKS5_ERR_BAD_VERSION,      /* VER is not 5, or RSV is not 0 */
+  ODIN_SOCKS5_ERR_NO_METHOD,        /* greeting does not offer %x00 */
+  ODIN_SOCKS5_ERR_BAD_COMMAND,      /* CMD other than CONNECT */
+  ODIN_SOCKS5_ERR_BAD_ADDR_TYPE,    /* unknown ATYP */
+  ODIN_SOCKS5_ERR_HOST_LEN_INVALID, /* domain LEN 0 */
+  ODIN_SOCKS5_ERR_PORT_INVALID,     /* DST.PORT 0 */
+} odin_socks5_status_t;
+
+typedef struct odin_socks5_request_t {
+  uint8_t atyp;
+  size_t addr_off; /* into buf: 4 or 16 address bytes, or the domain name */
+  size_t addr_len;
+  uint16_t port;
+} odin_socks5_request_t;
+
+odin_socks5_status_t odin_socks5_parse_greeting(const uint8_t *buf, size_t n,
+                                                size_t *out_consumed);
+
+odin_socks5_status_t odin_socks5_parse_request(const uint8_t *buf, size_t n,
+                                               size_t *out_consumed,
+                                               odin_socks5_request_t *out);
+
+/* The method-selection reply: %x05 %x00, or %x05 %xFF after
+ * ODIN_SOCKS5_ERR_NO_METHOD. */
+const uint8_t *odin_socks5_method_reply(int acceptable);
+
+/* Writes the ODIN_SOCKS5_REPLY_LEN-byte reply with rep and an all-zero IPv4
+ * BND.ADDR / BND.PORT to out. */
+void odin_socks5_write_reply(uint8_t rep, uint8_t *out);
+
+/* Maps a CONNECT failure errno to its REP value; 0 maps to SUCCEEDED. */
+uint8_t odin_socks5_rep_for_errno(int err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_SOCKS5_H_ */
@@ -0,0 +1 @@
+#include "odin/access_log.c" // NOLINT(bugprone-suspicious-include)
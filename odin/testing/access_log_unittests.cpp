@@ -0,0 +1,277 @@
+// odin/testing/access_log_unittests.cpp
+//
+// Unit tests T1-T5 from §5 of odin/docs/rfc_049_access_log.md.
+//
+// T1-T2 pin the line formats with odin_access_log_format alone. T3-T5 run the
+// writer thread against a pipe or an unwritable fd; nothing here needs an
+// event loop.
+
+#include "odin/access_log.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+// 2023-11-14T22:13:20.123456Z.
+constexpr uint64_t kWallUs = 1700000000123456u;
+
+odin_access_log_record_t SampleRecord(odin_access_log_side_t side,
+                                      const char *host) {
+  odin_access_log_record_t rec;
+  odin_access_log_record_begin(&rec, side);
+  rec.start_wall_us = kWallUs;
+  odin_access_log_record_set_host(&rec, host, std::strlen(host), 443);
+  return rec;
+}
+
+// Reads until want newlines have arrived, EOF, or timeout_ms passes.
+std::string ReadLines(int fd, size_t want, int timeout_ms) {
+  std::string out;
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+  size_t lines = 0;
+  while (lines < want) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) {
+      break;
+    }
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, static_cast<int>(left.count())) <= 0) {
+      break;
+    }
+    char buf[4096];
+    const ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      break;
+    }
+    for (ssize_t i = 0; i < n; ++i) {
+      lines += buf[i] == '\n' ? 1u : 0u;
+    }
+    out.append(buf, static_cast<size_t>(n));
+  }
+  return out;
+}
+
+// Polls the stats until pred holds or timeout_ms passes.
+template <typename Pred>
+odin_access_log_stats_t WaitStats(odin_access_log_t *log, Pred pred,
+                                  int timeout_ms) {
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+  odin_access_log_stats_t st{};
+  for (;;) {
+    odin_access_log_stats(log, &st);
+    if (pred(st) || std::chrono::steady_clock::now() >= deadline) {
+      return st;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+}
+
+// T1: the text format, with an IPv6 upstream in brackets and every host byte
+// that could split a field escaped as \xHH.
+TEST(OdinAccessLogTest, T1TextFormat) {
+  odin_access_log_record_t rec = SampleRecord(ODIN_ACCESS_LOG_SERVER, "a b\\c");
+  struct sockaddr_in client{};
+  client.sin_family = AF_INET;
+  client.sin_port = htons(5000);
+  ASSERT_EQ(inet_pton(AF_INET, "192.0.2.1", &client.sin_addr), 1);
+  odin_access_log_addr_set(&rec.client,
+                           reinterpret_cast<struct sockaddr *>(&client),
+                           sizeof(client));
+  struct sockaddr_in6 upstream{};
+  upstream.sin6_family = AF_INET6;
+  upstream.sin6_port = htons(443);
+  ASSERT_EQ(inet_pton(AF_INET6, "2001:db8::1", &upstream.sin6_addr), 1);
+  odin_access_log_addr_set(&rec.upstream,
+                           reinterpret_cast<struct sockaddr *>(&upstream),
+                           sizeof(upstream));
+  rec.dial_us = 12;
+  rec.bytes_up = 34;
+  rec.bytes_down = 56;
+  rec.duration_us = 78;
+
+  char buf[ODIN_ACCESS_LOG_LINE_MAX];
+  const size_t n =
+      odin_access_log_format(&rec, ODIN_ACCESS_LOG_TEXT, buf, sizeof(buf));
+  EXPECT_EQ(std::string(buf, n),
+            "2023-11-14T22:13:20.123Z server client=192.0.2.1:5000 "
+            "target=a\\x20b\\x5cc:443 upstream=[2001:db8::1]:443 dial_us=12 "
+            "bytes_up=34 bytes_down=56 duration_us=78 errno=0\n");
+
+  // A sockaddr too short for its family leaves the address unknown.
+  odin_access_log_addr_set(&rec.client,
+                           reinterpret_cast<struct sockaddr *>(&client), 4);
+  EXPECT_EQ(rec.client.family, 0u);
+}
+
+// T2: JSON Lines, with unknown addresses as null, quotes and backslashes
+// escaped, control bytes as \u00HH, and a buffer too small yielding 0.
+TEST(OdinAccessLogTest, T2JsonFormat) {
+  odin_access_log_record_t rec =
+      SampleRecord(ODIN_ACCESS_LOG_CLIENT, "x\"y\\z\n");
+  rec.port = 80;
+  rec.bytes_up = 1;
+  rec.bytes_down = 2;
+  rec.duration_us = 3;
+  rec.err = ECONNRESET;
+
+  char buf[ODIN_ACCESS_LOG_LINE_MAX];
+  const size_t n =
+      odin_access_log_format(&rec, ODIN_ACCESS_LOG_JSONL, buf, sizeof(buf));
+  EXPECT_EQ(std::string(buf, n),
+            "{\"ts\":\"2023-11-14T22:13:20.123Z\",\"side\":\"client\","
+            "\"client\":null,\"target\":\"x\\\"y\\\\z\\u000a:80\","
+            "\"upstream\":null,\"dial_us\":0,\"bytes_up\":1,\"bytes_down\":2,"
+            "\"duration_us\":3,\"errno\":" +
+                std::to_string(ECONNRESET) + "}\n");
+  EXPECT_EQ(odin_access_log_format(&rec, ODIN_ACCESS_LOG_JSONL, buf, 16), 0u);
+}
+
+// T3: records appended on one thread come out of the writer in order, and a
+// destroyed ring is still drained.
+TEST(OdinAccessLogTest, T3WriterDrainsInOrder) {
+  int p[2];
+  ASSERT_EQ(pipe(p), 0);
+  odin_access_log_config_t cfg{};
+  cfg.fd = p[1];
+  cfg.format = ODIN_ACCESS_LOG_TEXT;
+  cfg.flush_ms = 5;
+  odin_access_log_t *log = nullptr;
+  ASSERT_EQ(odin_access_log_create(&cfg, &log), 0);
+  odin_access_log_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_access_log_ring_create(log, 8, &ring), 0);
+
+  for (const char *host : {"one", "two", "three"}) {
+    const odin_access_log_record_t rec =
+        SampleRecord(ODIN_ACCESS_LOG_SERVER, host);
+    EXPECT_EQ(odin_access_log_append(ring, &rec), 0);
+  }
+  odin_access_log_ring_destroy(ring);
+
+  const std::string got = ReadLines(p[0], 3, 1500);
+  const size_t one = got.find("target=one:443");
+  const size_t two = got.find("target=two:443");
+  const size_t three = got.find("target=three:443");
+  ASSERT_NE(one, std::string::npos);
+  ASSERT_NE(two, std::string::npos);
+  ASSERT_NE(three, std::string::npos);
+  EXPECT_LT(one, two);
+  EXPECT_LT(two, three);
+  const odin_access_log_stats_t st = WaitStats(
+      log, [](const odin_access_log_stats_t &s) { return s.written == 3; },
+      1500);
+  EXPECT_EQ(st.written, 3u);
+  EXPECT_EQ(st.dropped, 0u);
+  EXPECT_EQ(st.write_errors, 0u);
+
+  odin_access_log_destroy(log);
+  EXPECT_EQ(close(p[0]), 0);
+  EXPECT_EQ(close(p[1]), 0);
+}
+
+// T4: a full ring refuses the record with ENOBUFS and counts it; the drop
+// count survives the ring, and destroy writes everything that was accepted.
+TEST(OdinAccessLogTest, T4FullRingDropsAndCounts) {
+  int p[2];
+  ASSERT_EQ(pipe(p), 0);
+  odin_access_log_config_t cfg{};
+  cfg.fd = p[1];
+  cfg.format = ODIN_ACCESS_LOG_JSONL;
+  cfg.flush_ms = 60000; // nothing drains until destroy
+  odin_access_log_t *log = nullptr;
+  ASSERT_EQ(odin_access_log_create(&cfg, &log), 0);
+  odin_access_log_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_access_log_ring_create(log, 3, &ring), 0); // 4 slots
+
+  const odin_access_log_record_t rec =
+      SampleRecord(ODIN_ACCESS_LOG_CLIENT, "full");
+  int refused = 0;
+  for (int i = 0; i < 6; ++i) {
+    errno = 0;
+    if (odin_access_log_append(ring, &rec) != 0) {
+      EXPECT_EQ(errno, ENOBUFS);
+      refused += 1;
+    }
+  }
+  EXPECT_EQ(refused, 2);
+  odin_access_log_stats_t st{};
+  odin_access_log_stats(log, &st);
+  EXPECT_EQ(st.dropped, 2u);
+  EXPECT_EQ(st.written, 0u);
+  odin_access_log_ring_destroy(ring);
+  odin_access_log_stats(log, &st);
+  EXPECT_EQ(st.dropped, 2u);
+
+  odin_access_log_destroy(log);
+  EXPECT_EQ(close(p[1]), 0);
+  const std::string got = ReadLines(p[0], 5, 500);
+  size_t lines = 0;
+  for (char c : got) {
+    lines += c == '\n' ? 1u : 0u;
+  }
+  EXPECT_EQ(lines, 4u);
+  EXPECT_EQ(close(p[0]), 0);
+}
+
+// T5: a failed write counts the batch's records as write errors, and bad
+// arguments are refused.
+TEST(OdinAccessLogTest, T5WriteErrorsAndBadArguments) {
+  const int fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  odin_access_log_config_t cfg{};
+  cfg.fd = fd;
+  cfg.flush_ms = 5;
+  odin_access_log_t *log = nullptr;
+  ASSERT_EQ(odin_access_log_create(&cfg, &log), 0);
+  odin_access_log_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_access_log_ring_create(log, 0, &ring), 0);
+  const odin_access_log_record_t rec =
+      SampleRecord(ODIN_ACCESS_LOG_SERVER, "lost");
+  EXPECT_EQ(odin_access_log_append(ring, &rec), 0);
+  const odin_access_log_stats_t st = WaitStats(
+      log, [](const odin_access_log_stats_t &s) { return s.write_errors == 1; },
+      1500);
+  EXPECT_EQ(st.write_errors, 1u);
+  EXPECT_EQ(st.written, 0u);
+  odin_access_log_ring_destroy(ring);
+  odin_access_log_destroy(log);
+  EXPECT_EQ(close(fd), 0);
+
+  odin_access_log_t *bad = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_access_log_create(nullptr, &bad), -1);
+  EXPECT_EQ(errno, EINVAL);
+  cfg.fd = -1;
+  errno = 0;
+  EXPECT_EQ(odin_access_log_create(&cfg, &bad), -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(bad, nullptr);
+  errno = 0;
+  EXPECT_EQ(odin_access_log_append(nullptr, &rec), -1);
+  EXPECT_EQ(errno, EINVAL);
+  odin_access_log_ring_destroy(nullptr);
+  odin_access_log_destroy(nullptr);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1 @@
+#include "odin/cert_cache.c" // NOLINT(bugprone-suspicious-include)
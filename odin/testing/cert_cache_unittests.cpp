@@ -0,0 +1,164 @@
+// odin/testing/cert_cache_unittests.cpp
+//
+// Unit tests T1-T5 and T9 from §5 of odin/docs/rfc_042_cert_verify_cache.md.
+//
+// Drives the cache directly with synthetic digests and caller-supplied
+// times; no certificates, no runtime.
+
+#include "odin/cert_cache.h"
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+using Digest = std::array<uint8_t, ODIN_CERT_CACHE_DIGEST_LEN>;
+
+constexpr uint64_t kNow = 1700000000000u;
+
+Digest Key(uint8_t tag) {
+  Digest d{};
+  d.fill(tag);
+  return d;
+}
+
+odin_cert_cache_stats_t Stats(const odin_cert_cache_t *cache) {
+  odin_cert_cache_stats_t stats{};
+  odin_cert_cache_stats(cache, &stats);
+  return stats;
+}
+
+// T1: a miss, an insert, then hits for that key only.
+TEST(OdinCertCacheTest, T1HitsAfterInsert) {
+  odin_cert_cache_t *cache = nullptr;
+  ASSERT_EQ(odin_cert_cache_create(4, 60000, &cache), 0);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow), 0);
+  odin_cert_cache_insert(cache, Key(1).data(), kNow + 3600000, kNow);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow + 1), 1);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow + 2), 1);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(2).data(), kNow + 3), 0);
+
+  const odin_cert_cache_stats_t stats = Stats(cache);
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.inserts, 1u);
+  odin_cert_cache_destroy(cache);
+}
+
+// T2: an entry expires at the earlier of its notAfter and the TTL; a chain
+// already past its notAfter is never stored.
+TEST(OdinCertCacheTest, T2ExpiresAtNotAfterOrTtl) {
+  odin_cert_cache_t *cache = nullptr;
+  ASSERT_EQ(odin_cert_cache_create(4, 1000, &cache), 0);
+  odin_cert_cache_insert(cache, Key(1).data(), kNow + 500, kNow);
+  odin_cert_cache_insert(cache, Key(2).data(), kNow + 3600000, kNow);
+  odin_cert_cache_insert(cache, Key(3).data(), kNow, kNow);
+
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow + 499), 1);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow + 500), 0);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(2).data(), kNow + 999), 1);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(2).data(), kNow + 1000), 0);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(3).data(), kNow), 0);
+
+  const odin_cert_cache_stats_t stats = Stats(cache);
+  EXPECT_EQ(stats.inserts, 2u);
+  EXPECT_EQ(stats.expirations, 2u);
+  odin_cert_cache_destroy(cache);
+}
+
+// T3: a full cache evicts its least recently used entry.
+TEST(OdinCertCacheTest, T3EvictsLeastRecentlyUsed) {
+  odin_cert_cache_t *cache = nullptr;
+  ASSERT_EQ(odin_cert_cache_create(2, 60000, &cache), 0);
+  odin_cert_cache_insert(cache, Key(1).data(), kNow + 60000, kNow);
+  odin_cert_cache_insert(cache, Key(2).data(), kNow + 60000, kNow);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow), 1);
+  odin_cert_cache_insert(cache, Key(3).data(), kNow + 60000, kNow);
+
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow), 1);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(2).data(), kNow), 0);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(3).data(), kNow), 1);
+  EXPECT_EQ(Stats(cache).evictions, 1u);
+  odin_cert_cache_destroy(cache);
+}
+
+// T4: a changed trust anchor drops every entry; the same anchor keeps them.
+TEST(OdinCertCacheTest, T4AnchorChangeInvalidates) {
+  odin_cert_cache_t *cache = nullptr;
+  ASSERT_EQ(odin_cert_cache_create(4, 60000, &cache), 0);
+  odin_cert_cache_set_anchor(cache, Key(0xA0).data());
+  odin_cert_cache_insert(cache, Key(1).data(), kNow + 60000, kNow);
+  odin_cert_cache_insert(cache, Key(2).data(), kNow + 60000, kNow);
+
+  odin_cert_cache_set_anchor(cache, Key(0xA0).data());
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow), 1);
+  EXPECT_EQ(Stats(cache).invalidations, 0u);
+
+  odin_cert_cache_set_anchor(cache, Key(0xA1).data());
+  EXPECT_EQ(Stats(cache).invalidations, 2u);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow), 0);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(2).data(), kNow), 0);
+  odin_cert_cache_destroy(cache);
+}
+
+// T5: argument checks, verify-time accounting, and NULL receivers.
+TEST(OdinCertCacheTest, T5ArgumentsAndVerifyCounters) {
+  odin_cert_cache_t *cache = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_cert_cache_create(0, 1000, &cache), -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(odin_cert_cache_create(ODIN_CERT_CACHE_MAX_ENTRIES + 1, 1000,
+                                   &cache),
+            -1);
+  EXPECT_EQ(odin_cert_cache_create(4, 0, &cache), -1);
+  EXPECT_EQ(odin_cert_cache_create(4, 1000, nullptr), -1);
+  EXPECT_EQ(cache, nullptr);
+
+  ASSERT_EQ(odin_cert_cache_create(ODIN_CERT_CACHE_MAX_ENTRIES,
+                                   UINT64_MAX, &cache),
+            0);
+  odin_cert_cache_insert(cache, Key(1).data(), kNow + 10, kNow);
+  EXPECT_EQ(odin_cert_cache_lookup(cache, Key(1).data(), kNow + 9), 1);
+  odin_cert_cache_record_verify(cache, 1500);
+  odin_cert_cache_record_verify(cache, 2500);
+  const odin_cert_cache_stats_t stats = Stats(cache);
+  EXPECT_EQ(stats.verifies, 2u);
+  EXPECT_EQ(stats.verify_ns, 4000u);
+  odin_cert_cache_destroy(cache);
+
+  EXPECT_EQ(odin_cert_cache_lookup(nullptr, Key(1).data(), kNow), 0);
+  odin_cert_cache_insert(nullptr, Key(1).data(), kNow + 1, kNow);
+  odin_cert_cache_record_verify(nullptr, 1);
+  EXPECT_EQ(Stats(nullptr).hits, 0u);
+  odin_cert_cache_destroy(nullptr);
+}
+
+// T9: the RFC-051 log fields, and snprintf-style truncation.
+TEST(OdinCertCacheTest, T9StatsFormat) {
+  odin_cert_cache_stats_t stats{};
+  stats.hits = 12;
+  stats.misses = 3;
+  stats.inserts = 3;
+  stats.verifies = 3;
+  stats.verify_ns = 4500999;
+  char buf[64];
+  const std::string want = "cert=12/3 verifies=3 verify_us=4500";
+  EXPECT_EQ(odin_cert_cache_stats_format(&stats, buf, sizeof(buf)),
+            want.size());
+  EXPECT_EQ(std::string(buf), want);
+  char small[8];
+  EXPECT_EQ(odin_cert_cache_stats_format(&stats, small, sizeof(small)),
+            want.size());
+  EXPECT_EQ(std::string(small), "cert=12");
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -5,10 +5,12 @@
 
 #if defined(ODIN_CLI_CLIENT_TESTING)
 
+#include "odin/client_session.h"
 #include "odin/protocol.h"
 
 #include <netinet/in.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/socket.h>
 
 #ifdef __cplusplus
@@ -36,6 +38,7 @@ typedef enum odin_cli_client_test_failpoint_t {
   ODIN_CLI_CLIENT_TEST_TRIGGER_ACCEPT_LOOP_FCNTL_SETFL_ERROR = 17,
   ODIN_CLI_CLIENT_TEST_FAIL_DNS_EVENT_LOOP_RUN = 18,
   ODIN_CLI_CLIENT_TEST_TRIGGER_DNS_EVENT_LOOP_STOP = 19,
+  ODIN_CLI_CLIENT_TEST_FAIL_STATS_TIMER_START = 20,
   ODIN_CLI_CLIENT_TEST_FAILPOINT_INVALID = 99,
   ODIN_CLI_CLIENT_TEST_FAIL_XQC_CLIENT_RUNTIME_CREATE = 100,
   ODIN_CLI_CLIENT_TEST_FAIL_XQC_CLIENT_RUNTIME_START = 101,
@@ -70,6 +73,8 @@ typedef struct odin_cli_client_test_runtime_config_record_t {
   const char *quic_ca_file;
   size_t quic_ca_file_len;
   char quic_ca_file_value[4096];
+  /* Last frontend lent to a runtime by the session options (RFC-041). */
+  odin_client_session_frontend_t frontend;
 } odin_cli_client_test_runtime_config_record_t;
 
 typedef struct odin_cli_client_test_dns_timing_t {
@@ -104,6 +109,8 @@ int odin_cli_client_test_last_xqc_add(
     odin_cli_client_test_xqc_add_record_t *out);
 int odin_cli_client_test_last_runtime_config(
     odin_cli_client_test_runtime_config_record_t *out);
+/* TTL the RFC-042 certificate cache was created with. */
+int odin_cli_client_test_last_cert_cache_ttl(uint64_t *out);
 int odin_cli_client_test_pending_failpoint(
     odin_cli_client_test_failpoint_t *out);
 int odin_cli_client_test_set_progress_fd(int fd, size_t min_inflight_sessions);
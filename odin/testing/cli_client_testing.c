@@ -21,6 +21,7 @@ static int valid_fail_next_fp(odin_cli_client_test_failpoint_t fp) {
   case ODIN_CLI_CLIENT_TEST_FAIL_SIGACTION_SIGINT:
   case ODIN_CLI_CLIENT_TEST_FAIL_SIGACTION_SIGTERM:
   case ODIN_CLI_CLIENT_TEST_FAIL_SIGNAL_TIMER_START:
+  case ODIN_CLI_CLIENT_TEST_FAIL_STATS_TIMER_START:
   case ODIN_CLI_CLIENT_TEST_FAIL_EVENT_LOOP_RUN:
   case ODIN_CLI_CLIENT_TEST_FAIL_DNS_EVENT_LOOP_RUN:
   case ODIN_CLI_CLIENT_TEST_TRIGGER_ACCEPT_LOOP_ERROR:
@@ -87,6 +88,8 @@ void odin_cli_client_test_reset_liveness(void) {
   memset(&g_last_xqc_add, 0, sizeof(g_last_xqc_add));
   g_last_runtime_config_recorded = 0;
   memset(&g_last_runtime_config, 0, sizeof(g_last_runtime_config));
+  g_last_cert_cache_ttl_recorded = 0;
+  g_last_cert_cache_ttl_ms = 0;
   g_progress_fd = -1;
   g_progress_min_inflight_sessions = 0;
   g_progress_reported = 0;
@@ -137,6 +140,19 @@ int odin_cli_client_test_last_bound_addr(struct sockaddr_in *out) {
   return 0;
 }
 
+int odin_cli_client_test_last_cert_cache_ttl(uint64_t *out) {
+  if (out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (!g_last_cert_cache_ttl_recorded) {
+    errno = ENOENT;
+    return -1;
+  }
+  *out = g_last_cert_cache_ttl_ms;
+  return 0;
+}
+
 int odin_cli_client_test_last_xqc_add(
     odin_cli_client_test_xqc_add_record_t *out) {
   if (out == NULL) {
@@ -2,6 +2,7 @@
 //
 // RFC-024 §5 process-level and unit-level tests for the CLI client runner.
 
+#include "odin/cert_cache.h"
 #include "odin/cli.h"
 #include "odin/cli_client.h"
 #include "odin/testing/cli_client_internal_test.h"
@@ -510,6 +511,8 @@ struct Rfc028QuicChildSnapshot {
   int add_record_ok;
   odin_cli_client_test_runtime_config_record_t runtime_config;
   int runtime_config_ok;
+  uint64_t cert_cache_ttl_ms;
+  int cert_cache_ttl_ok;
   odin_cli_client_test_dns_timing_t dns_timing;
   struct sockaddr_in bind_addr;
   int bind_addr_ok;
@@ -701,6 +704,10 @@ void FillRfc028QuicSnapshot(int rc, Rfc028QuicChildSnapshot *snap) {
   snap->runtime_config_ok =
       odin_cli_client_test_last_runtime_config(&snap->runtime_config) == 0 ? 1
                                                                            : 0;
+  snap->cert_cache_ttl_ok =
+      odin_cli_client_test_last_cert_cache_ttl(&snap->cert_cache_ttl_ms) == 0
+          ? 1
+          : 0;
   (void)odin_cli_client_test_dns_timing(&snap->dns_timing);
   snap->bind_addr_ok =
       odin_cli_client_test_last_bind_addr(&snap->bind_addr) == 0 ? 1 : 0;
@@ -970,9 +977,9 @@ TEST(OdinCliClientCaFileTest, T3RunnerForwardsRequiredCaFileAndRejectsOmit) {
   EXPECT_EQ(omitted.rc, 2);
   EXPECT_EQ(omitted.err,
             "odin: missing required flag\n"
-            "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE' "
-            "or 'odin-server --listen ADDR --quic-cert FILE --quic-key "
-            "FILE'\n");
+            "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE "
+            "[OPTION]...' or 'odin-server --listen ADDR --quic-cert FILE "
+            "--quic-key FILE [OPTION]...'\n");
   EXPECT_EQ(omitted.snapshot.runtime_record.default_create_calls, 0u);
   ExpectRfc028QuicClean(omitted.snapshot);
 }
@@ -1229,6 +1236,221 @@ TEST(OdinRFC028ClientTransportTest, T11QuicPostListenerStartupFailureMatrix) {
   }
 }
 
+// RFC-038 T10 — --route reaches the runner: a malformed rule fails the
+// compile step after the runtime started, and teardown leaves nothing live.
+TEST(OdinRFC038ClientRouteTest, T10RouteFlagReachesRunner) {
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.insert(tokens.end(),
+                {"--route", "direct *", "--route", "bypass example.com"});
+  Rfc028QuicDirectRun run = RunRfc028QuicDirect(tokens);
+  EXPECT_EQ(run.rc, 1);
+  EXPECT_EQ(run.err, "odin: client startup failed at route_compile\n");
+  EXPECT_EQ(run.snapshot.runtime_record.runtime_free_calls, 1u);
+  ExpectRfc028QuicClean(run.snapshot);
+}
+
+// RFC-042 T8 — --cert-cache-ttl-ms reaches the runner: the shared cache is
+// created with the flag's TTL, or the default hour without it.
+TEST(OdinRFC042ClientCertCacheTest, T8CertCacheTtlFlagReachesRunner) {
+  const struct {
+    const char *ttl;
+    uint64_t expected;
+  } cases[] = {
+      {nullptr, ODIN_CERT_CACHE_DEFAULT_TTL_MS},
+      {"1500", 1500u},
+  };
+  for (const auto &c : cases) {
+    SCOPED_TRACE(c.ttl != nullptr ? c.ttl : "(default)");
+    std::vector<std::string> tokens = QuicClientArgs();
+    if (c.ttl != nullptr) {
+      tokens.insert(tokens.end(), {"--cert-cache-ttl-ms", c.ttl});
+    }
+    Rfc028QuicDirectRun run = RunRfc028QuicDirect(
+        tokens, ODIN_CLI_CLIENT_TEST_FAIL_SIGNAL_TIMER_START, EIO);
+    EXPECT_EQ(run.rc, 1);
+    EXPECT_EQ(run.err, "odin: client startup failed at signal_timer_start\n");
+    ASSERT_TRUE(run.snapshot.cert_cache_ttl_ok);
+    EXPECT_EQ(run.snapshot.cert_cache_ttl_ms, c.expected);
+    ExpectRfc028QuicClean(run.snapshot);
+  }
+}
+
+// RFC-045 T13 — --dns-stub-port reaches the runner: with the port's UDP side
+// already taken, startup fails at the stub bind after the runtime started.
+TEST(OdinRFC045ClientDnsStubTest, T13DnsStubPortFlagReachesRunner) {
+  const int taken = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(taken, 0) << std::strerror(errno);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(taken, reinterpret_cast<const struct sockaddr *>(&addr),
+                 sizeof(addr)),
+            0)
+      << std::strerror(errno);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(taken, reinterpret_cast<struct sockaddr *>(&addr),
+                        &addr_len),
+            0);
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.insert(tokens.end(),
+                {"--dns-stub-port", std::to_string(ntohs(addr.sin_port))});
+  Rfc028QuicDirectRun run = RunRfc028QuicDirect(tokens);
+  close(taken);
+  EXPECT_EQ(run.rc, 1);
+  EXPECT_EQ(run.err, "odin: client startup failed at dns_stub_bind\n");
+  EXPECT_EQ(run.snapshot.runtime_record.runtime_free_calls, 1u);
+  ExpectRfc028QuicClean(run.snapshot);
+}
+
+// RFC-049 T9 — odin-client --access-log reaches the runner: an unopenable
+// path fails startup at access_log_open before any runtime exists.
+TEST(OdinRFC049ClientAccessLogTest, T9AccessLogFlagReachesRunner) {
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.insert(tokens.end(),
+                {"--access-log", "/nonexistent-odin-dir/access.log",
+                 "--access-log-format", "text"});
+  Rfc028QuicDirectRun run = RunRfc028QuicDirect(tokens);
+  EXPECT_EQ(run.rc, 1);
+  EXPECT_EQ(run.err, "odin: client startup failed at access_log_open\n");
+  EXPECT_EQ(run.snapshot.runtime_record.default_create_calls, 0u);
+  ExpectRfc028QuicClean(run.snapshot);
+}
+
+// RFC-039 T7 — --extra-server reaches the runner: a second runtime is created
+// for the extra server's resolved address, and both are torn down when a
+// later startup step fails.
+TEST(OdinRFC039ClientUpstreamTest, T7ExtraServerFlagReachesRunner) {
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.insert(tokens.end(), {"--extra-server", "127.0.0.1:4434",
+                               "--addrs-per-server", "2"});
+  Rfc028QuicDirectRun run = RunRfc028QuicDirect(
+      tokens, ODIN_CLI_CLIENT_TEST_FAIL_SIGNAL_TIMER_START, EIO);
+  EXPECT_EQ(run.rc, 1);
+  EXPECT_EQ(run.err, "odin: client startup failed at signal_timer_start\n");
+  EXPECT_EQ(run.snapshot.runtime_record.default_create_calls, 2u);
+  EXPECT_EQ(run.snapshot.runtime_record.runtime_free_calls, 2u);
+  ASSERT_TRUE(run.snapshot.runtime_config_ok);
+  const auto *peer = reinterpret_cast<const struct sockaddr_in *>(
+      &run.snapshot.runtime_config.peer_addr_value);
+  EXPECT_EQ(peer->sin_family, AF_INET);
+  EXPECT_EQ(peer->sin_addr.s_addr, htonl(INADDR_LOOPBACK));
+  EXPECT_EQ(ntohs(peer->sin_port), 4434);
+  ExpectRfc028QuicClean(run.snapshot);
+}
+
+// RFC-040 T8 — --transparent reaches the runner: a connection made straight
+// to the listener has no other original destination, so it is refused with
+// no bytes and never handed to the runtime.
+TEST(OdinRFC040ClientTransparentTest, T8TransparentFlagReachesRunner) {
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.push_back("--transparent");
+  Rfc028QuicChild child = SpawnRfc028QuicChild(tokens);
+  ChildGuard guard(child.pid);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 2000);
+  uint16_t proxy_port = 0;
+  std::string server;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &proxy_port, &server)) << line;
+  const int fd = TcpConnectLoopback(proxy_port, kShortDeadlineMs);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+  EXPECT_TRUE(DrainUntilEofOrResetExpectingNoBytes(fd, kShortDeadlineMs));
+  close(fd);
+  Rfc028QuicChildSnapshot snap = FinishRfc028QuicChild(&child, SIGTERM);
+  guard.disarm();
+  close(child.stderr_fd);
+  EXPECT_EQ(snap.rc, 0);
+  EXPECT_EQ(snap.cli.quic_runtime_add_connection_calls, 0u);
+  ExpectRfc028QuicClean(snap);
+}
+
+// RFC-041 T9 — --frontend reaches the runner: every session option is lent to
+// the runtime before the signal timer, so a failure there still observes it.
+TEST(OdinRFC041ClientFrontendTest, T9FrontendFlagReachesRunner) {
+  const struct {
+    const char *name;
+    odin_client_session_frontend_t frontend;
+  } cases[] = {
+      {nullptr, ODIN_CLIENT_SESSION_FRONTEND_HTTP},
+      {"socks5", ODIN_CLIENT_SESSION_FRONTEND_SOCKS5},
+      {"auto", ODIN_CLIENT_SESSION_FRONTEND_AUTO},
+  };
+  for (const auto &c : cases) {
+    SCOPED_TRACE(c.name != nullptr ? c.name : "(default)");
+    std::vector<std::string> tokens = QuicClientArgs();
+    if (c.name != nullptr) {
+      tokens.insert(tokens.end(), {"--frontend", c.name});
+    }
+    Rfc028QuicDirectRun run = RunRfc028QuicDirect(
+        tokens, ODIN_CLI_CLIENT_TEST_FAIL_SIGNAL_TIMER_START, EIO);
+    EXPECT_EQ(run.rc, 1);
+    EXPECT_EQ(run.err, "odin: client startup failed at signal_timer_start\n");
+    ASSERT_TRUE(run.snapshot.runtime_config_ok);
+    EXPECT_EQ(run.snapshot.runtime_config.frontend, c.frontend);
+    ExpectRfc028QuicClean(run.snapshot);
+  }
+}
+
+// RFC-050 T9 — the qlog flags reach odin-client: a path in a missing
+// directory fails at qlog_create and a non-numeric address at qlog_config,
+// both before any runtime exists.
+TEST(OdinRFC050ClientQlogTest, T9QlogFlagsReachRunner) {
+  const struct {
+    std::vector<std::string> extra;
+    const char *step;
+  } cases[] = {
+      {{"--qlog", "/nonexistent-odin-dir/client.qlog", "--qlog-sample", "1",
+        "--qlog-max-bytes", "4096"},
+       "qlog_create"},
+      {{"--qlog", "/tmp/odin-client-unused.qlog", "--qlog-force-ip",
+        "localhost"},
+       "qlog_config"},
+  };
+  for (const auto &c : cases) {
+    SCOPED_TRACE(c.step);
+    std::vector<std::string> tokens = QuicClientArgs();
+    tokens.insert(tokens.end(), c.extra.begin(), c.extra.end());
+    Rfc028QuicDirectRun run = RunRfc028QuicDirect(tokens);
+    EXPECT_EQ(run.rc, 1);
+    EXPECT_EQ(run.err,
+              std::string("odin: client startup failed at ") + c.step + "\n");
+    EXPECT_EQ(run.snapshot.runtime_record.default_create_calls, 0u);
+    ExpectRfc028QuicClean(run.snapshot);
+  }
+}
+
+// RFC-051 T11 — --stats-interval-s makes odin-client log one totals line
+// per interval after the startup line; a failed stats timer fails startup
+// with both runtimes released.
+TEST(OdinRFC051ClientStatsTest, T11StatsIntervalLogsTotals) {
+  std::vector<std::string> tokens = QuicClientArgs();
+  tokens.insert(tokens.end(), {"--stats-interval-s", "1"});
+  Rfc028QuicChild child = SpawnRfc028QuicChild(tokens);
+  ChildGuard guard(child.pid);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 2000);
+  uint16_t proxy_port = 0;
+  std::string server;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &proxy_port, &server)) << line;
+  const std::string stats = ReadLineWithDeadline(child.stderr_fd, 4000);
+  EXPECT_EQ(stats.rfind("odin: stats conns=", 0), 0u) << stats;
+  EXPECT_NE(stats.find(" pkts="), std::string::npos) << stats;
+  EXPECT_NE(stats.find(" cert="), std::string::npos) << stats;
+  EXPECT_NE(stats.find(" loop_us="), std::string::npos) << stats;
+  Rfc028QuicChildSnapshot snap = FinishRfc028QuicChild(&child, SIGTERM);
+  guard.disarm();
+  close(child.stderr_fd);
+  EXPECT_EQ(snap.rc, 0);
+  ExpectRfc028QuicClean(snap);
+
+  tokens.insert(tokens.end(), {"--extra-server", "127.0.0.1:4434"});
+  Rfc028QuicDirectRun run = RunRfc028QuicDirect(
+      tokens, ODIN_CLI_CLIENT_TEST_FAIL_STATS_TIMER_START, EIO);
+  EXPECT_EQ(run.rc, 1);
+  EXPECT_EQ(run.err, "odin: client startup failed at stats_timer_start\n");
+  EXPECT_EQ(run.snapshot.runtime_record.default_create_calls, 2u);
+  EXPECT_EQ(run.snapshot.runtime_record.runtime_free_calls, 2u);
+  ExpectRfc028QuicClean(run.snapshot);
+}
+
 TEST(OdinRFC028ClientTransportTest, T12ClientRunnerConfigPreconditions) {
   odin_cli_client_test_reset_liveness();
   odin_event_loop_test_reset_liveness();
@@ -1871,8 +2093,8 @@ TEST_F(OdinRFC032ClientDnsTest, T1HostnameResolvesToIpv4BeforeQuicStartup) {
   close(child.stderr_fd);
   EXPECT_EQ(snap.rc, 0);
   ExpectNoRfc032FakeFailures(snap);
-  EXPECT_EQ(snap.dns_obs.getaddrinfo_calls, 1u);
-  EXPECT_EQ(snap.dns_obs.last_ai_family, AF_UNSPEC);
+  EXPECT_EQ(snap.dns_obs.getaddrinfo_calls, 2u); // A, then AAAA
+  EXPECT_EQ(snap.dns_obs.last_ai_family, AF_INET6);
   ExpectRfc032RuntimeEndpoint(snap, AF_INET, "127.0.0.1", 8443, AF_INET,
                               "0.0.0.0", 0, "odin.test");
   EXPECT_EQ(snap.cli.quic_runtime_create_calls, 1u);
@@ -2217,8 +2439,8 @@ TEST_F(OdinRFC032ClientDnsTest, T11MultipleDnsResultsSelectFirstUsableAddress) {
   close(child.stderr_fd);
   EXPECT_EQ(snap.rc, 0);
   ExpectNoRfc032FakeFailures(snap);
-  EXPECT_EQ(snap.dns_obs.getaddrinfo_calls, 1u);
-  EXPECT_EQ(snap.dns_obs.last_ai_family, AF_UNSPEC);
+  EXPECT_EQ(snap.dns_obs.getaddrinfo_calls, 2u); // A, then AAAA
+  EXPECT_EQ(snap.dns_obs.last_ai_family, AF_INET6);
   ExpectRfc032RuntimeEndpoint(snap, AF_INET6, "2001:db8::32", 9443, AF_INET6,
                               "::", 0, "ordered.test");
   ExpectRfc032DnsTimingCallbackDestroyed(snap);
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <sys/socket.h>
 
+#include "odin/dial.h"
 #include "odin/server_session.h"
 #include "odin/server_xqc_runtime.h"
 
@@ -27,6 +28,7 @@ typedef enum odin_cli_server_test_failpoint_t {
   ODIN_CLI_SERVER_TEST_FAIL_SIGACTION_SIGINT = 10,
   ODIN_CLI_SERVER_TEST_FAIL_SIGACTION_SIGTERM = 11,
   ODIN_CLI_SERVER_TEST_FAIL_SIGNAL_TIMER_START = 12,
+  ODIN_CLI_SERVER_TEST_FAIL_STATS_TIMER_START = 13,
   ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_CREATE = 100,
   ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_START = 101,
   ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_LOCAL_ADDR = 102,
@@ -43,6 +45,13 @@ typedef struct odin_cli_server_test_filter_record_t {
   void *quic_user_data;
 } odin_cli_server_test_filter_record_t;
 
+/* What the runner lent the runtime from --source-addr / --source-policy. */
+typedef struct odin_cli_server_test_source_pool_record_t {
+  unsigned int set_count;
+  size_t source_count;
+  odin_dial_source_policy_t policy;
+} odin_cli_server_test_source_pool_record_t;
+
 typedef struct odin_cli_server_test_dial_start_t {
   int family;
   uint32_t ipv4_addr_nbo;
@@ -63,6 +72,8 @@ int odin_cli_server_test_maybe_probe_dial_start(const struct sockaddr *addr,
                                                 socklen_t addrlen);
 int odin_cli_server_test_filter_record(
     odin_cli_server_test_filter_record_t *out);
+int odin_cli_server_test_source_pool_record(
+    odin_cli_server_test_source_pool_record_t *out);
 int odin_cli_server_test_set_quic_start_probe(
     void (*cb)(odin_xqc_server_runtime_t *rt, void *user_data),
     void *user_data);
@@ -54,10 +54,16 @@ volatile sig_atomic_t g_counted_sigterm;
 int g_t5_engine_create_port_fd = -1;
 
 constexpr const char kServerUsage[] =
-    "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE";
+    "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+    "[--source-addr IP]... [--source-policy round-robin|least-used] "
+    "[--access-log FILE] [--access-log-format text|jsonl] "
+    "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+    "[--qlog-max-bytes N] [--stats-interval-s N]";
 constexpr const char kBothUsage[] =
-    "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE' or "
-    "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE'";
+    "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE "
+    "[OPTION]...' or "
+    "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+    "[OPTION]...'";
 
 class MutableArgv {
 public:
@@ -642,6 +648,12 @@ void FakeUdpUnregisterConn(odin_xqc_udp_t *, const xqc_cid_t *cid) {
   }
 }
 
+xqc_conn_stats_t FakeConnGetStats(xqc_engine_t *, const xqc_cid_t *) {
+  xqc_conn_stats_t stats;
+  std::memset(&stats, 0, sizeof(stats));
+  return stats;
+}
+
 ssize_t FakeRecv(xqc_stream_t *stream, unsigned char *recv_buf,
                  size_t recv_buf_size, uint8_t *fin) {
   FakeStream *fake = FromStream(stream);
@@ -769,8 +781,10 @@ void InstallHarnessOps(QuicHarness *h) {
       FakeStreamGetDirection,
       FakeGetConnAlpUserDataByStream,
       FakeStreamClose,
+      nullptr,
       FakeUdpRegisterConn,
       FakeUdpUnregisterConn,
+      FakeConnGetStats,
   };
   odin_xqc_server_runtime_test_reset();
   odin_xqc_server_runtime_test_set_ops(&kRuntimeOps);
@@ -2008,6 +2022,173 @@ TEST(OdinCliServerQuicSecurityTest, T9QuicConnectReqPolicyStreamPaths) {
   DestroyHarness(&h);
 }
 
+// RFC-049 T8 — odin-server --access-log opens the file before it reports
+// ready and stops cleanly on SIGTERM; an unopenable path fails startup at
+// access_log_open with nothing left live.
+TEST(OdinCliServerAccessLogTest, T8AccessLogFlagsReachRunner) {
+  char dir[] = "/tmp/odin_access_log.XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr) << std::strerror(errno);
+  const std::string path = std::string(dir) + "/access.log";
+  ChildHandle child = SpawnOdinServer(
+      {"--listen", "0", "--quic-cert", CertPath(), "--quic-key", KeyPath(),
+       "--access-log", path, "--access-log-format", "jsonl"});
+  ASSERT_NE(child.pid, -1);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 4000);
+  uint16_t port = 0;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &port)) << line;
+  EXPECT_EQ(access(path.c_str(), F_OK), 0);
+  EXPECT_EQ(kill(child.pid, SIGTERM), 0);
+  int wstatus = 0;
+  ASSERT_EQ(WaitChildBounded(child.pid, 3000, &wstatus), 0);
+  EXPECT_TRUE(WIFEXITED(wstatus));
+  EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  close(child.stdout_fd);
+  close(child.stderr_fd);
+
+  odin_cli_server_test_reset_liveness();
+  odin_event_loop_test_reset_liveness();
+  odin_xqc_server_runtime_test_reset();
+  const MainResult r =
+      RunMain({"odin-server", "--listen", "0", "--quic-cert", CertPath(),
+               "--quic-key", KeyPath(), "--access-log",
+               std::string(dir) + "/missing/access.log"});
+  EXPECT_EQ(r.rc, 1);
+  EXPECT_EQ(r.err, "odin: quic server startup failed at access_log_open\n");
+  ExpectZeroLiveness(SnapshotLiveness());
+  (void)unlink(path.c_str());
+  (void)rmdir(dir);
+}
+
+// RFC-050 T8 — the qlog flags reach odin-server: the file exists once the
+// server is ready, and an address that is not numeric stops startup at
+// qlog_config with nothing live.
+TEST(OdinCliServerQlogTest, T8QlogFlagsReachRunner) {
+  char dir[] = "/tmp/odin_qlog.XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr) << std::strerror(errno);
+  const std::string path = std::string(dir) + "/server.qlog";
+  ChildHandle child = SpawnOdinServer(
+      {"--listen", "0", "--quic-cert", CertPath(), "--quic-key", KeyPath(),
+       "--qlog", path, "--qlog-sample", "1", "--qlog-force-ip", "127.0.0.1",
+       "--qlog-max-bytes", "1048576"});
+  ASSERT_NE(child.pid, -1);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 4000);
+  uint16_t port = 0;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &port)) << line;
+  EXPECT_EQ(access(path.c_str(), F_OK), 0);
+  EXPECT_EQ(kill(child.pid, SIGTERM), 0);
+  int wstatus = 0;
+  ASSERT_EQ(WaitChildBounded(child.pid, 3000, &wstatus), 0);
+  EXPECT_TRUE(WIFEXITED(wstatus));
+  EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  close(child.stdout_fd);
+  close(child.stderr_fd);
+
+  odin_cli_server_test_reset_liveness();
+  odin_event_loop_test_reset_liveness();
+  odin_xqc_server_runtime_test_reset();
+  const MainResult r =
+      RunMain({"odin-server", "--listen", "0", "--quic-cert", CertPath(),
+               "--quic-key", KeyPath(), "--qlog", path, "--qlog-force-ip",
+               "localhost"});
+  EXPECT_EQ(r.rc, 1);
+  EXPECT_EQ(r.err, "odin: quic server startup failed at qlog_config\n");
+  ExpectZeroLiveness(SnapshotLiveness());
+  (void)unlink(path.c_str());
+  (void)rmdir(dir);
+}
+
+// RFC-037 T7 — the source flags reach odin-server: the runner lends the
+// runtime one pool with the parsed addresses and policy, serves with it, and
+// stops cleanly; without the flags it lends none.
+TEST(OdinCliServerSourcePoolTest, T7SourceFlagsReachRunner) {
+  ChildHandle child = SpawnOdinServer(
+      {"--listen", "0", "--quic-cert", CertPath(), "--quic-key", KeyPath(),
+       "--source-addr", "127.0.0.1", "--source-policy", "least-used"});
+  ASSERT_NE(child.pid, -1);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 4000);
+  uint16_t port = 0;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &port)) << line;
+  EXPECT_EQ(kill(child.pid, SIGTERM), 0);
+  int wstatus = 0;
+  ASSERT_EQ(WaitChildBounded(child.pid, 3000, &wstatus), 0);
+  EXPECT_TRUE(WIFEXITED(wstatus));
+  EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  close(child.stdout_fd);
+  close(child.stderr_fd);
+
+  odin_cli_server_test_reset_liveness();
+  odin_event_loop_test_reset_liveness();
+  odin_xqc_server_runtime_test_reset();
+  ASSERT_EQ(odin_cli_server_test_fail_next(
+                ODIN_CLI_SERVER_TEST_FAIL_SIGNAL_TIMER_START, EIO),
+            0);
+  MainResult r = RunMain({"odin-server", "--listen", "0", "--quic-cert",
+                          CertPath(), "--quic-key", KeyPath(), "--source-addr",
+                          "127.0.0.1", "--source-addr", "::1",
+                          "--source-policy", "least-used"});
+  EXPECT_EQ(r.rc, 1);
+  EXPECT_EQ(r.err, "odin: quic server startup failed at signal_timer_start\n");
+  odin_cli_server_test_source_pool_record_t record{};
+  ASSERT_EQ(odin_cli_server_test_source_pool_record(&record), 0);
+  EXPECT_EQ(record.set_count, 1u);
+  EXPECT_EQ(record.source_count, 2u);
+  EXPECT_EQ(record.policy, ODIN_DIAL_SOURCE_LEAST_USED);
+  ExpectZeroLiveness(SnapshotLiveness());
+
+  odin_cli_server_test_reset_liveness();
+  odin_event_loop_test_reset_liveness();
+  odin_xqc_server_runtime_test_reset();
+  ASSERT_EQ(odin_cli_server_test_fail_next(
+                ODIN_CLI_SERVER_TEST_FAIL_SIGNAL_TIMER_START, EIO),
+            0);
+  r = RunMain({"odin-server", "--listen", "0", "--quic-cert", CertPath(),
+               "--quic-key", KeyPath()});
+  EXPECT_EQ(r.rc, 1);
+  ASSERT_EQ(odin_cli_server_test_source_pool_record(&record), 0);
+  EXPECT_EQ(record.set_count, 0u);
+  ExpectZeroLiveness(SnapshotLiveness());
+}
+
+// RFC-051 T10 — --stats-interval-s makes odin-server log one totals line per
+// interval after the startup line; a failed stats timer fails startup and
+// releases everything.
+TEST(OdinCliServerStatsTest, T10StatsIntervalLogsTotals) {
+  ChildHandle child =
+      SpawnOdinServer({"--listen", "0", "--quic-cert", CertPath(),
+                       "--quic-key", KeyPath(), "--stats-interval-s", "1"});
+  ASSERT_NE(child.pid, -1);
+  const std::string line = ReadLineWithDeadline(child.stderr_fd, 4000);
+  uint16_t port = 0;
+  ASSERT_TRUE(ParseQuicStartupLine(line, &port)) << line;
+  const std::string stats = ReadLineWithDeadline(child.stderr_fd, 4000);
+  EXPECT_EQ(stats.rfind("odin: stats conns=0/0 streams=0 srtt_max_us=0 ", 0),
+            0u)
+      << stats;
+  EXPECT_NE(stats.find(" dns=0/0 hot=0/0 refresh=0/0/0 loop_us="),
+            std::string::npos)
+      << stats;
+  EXPECT_EQ(kill(child.pid, SIGTERM), 0);
+  int wstatus = 0;
+  ASSERT_EQ(WaitChildBounded(child.pid, 3000, &wstatus), 0);
+  EXPECT_TRUE(WIFEXITED(wstatus));
+  EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  close(child.stdout_fd);
+  close(child.stderr_fd);
+
+  odin_cli_server_test_reset_liveness();
+  odin_event_loop_test_reset_liveness();
+  odin_xqc_server_runtime_test_reset();
+  ASSERT_EQ(odin_cli_server_test_fail_next(
+                ODIN_CLI_SERVER_TEST_FAIL_STATS_TIMER_START, EIO),
+            0);
+  const MainResult r =
+      RunMain({"odin-server", "--listen", "0", "--quic-cert", CertPath(),
+               "--quic-key", KeyPath(), "--stats-interval-s", "1"});
+  EXPECT_EQ(r.rc, 1);
+  EXPECT_EQ(r.err, "odin: quic server startup failed at stats_timer_start\n");
+  ExpectZeroLiveness(SnapshotLiveness());
+}
+
 TEST(OdinXqcUdpLocalAddrTest, T10UdpAccessorValidation) {
   QuicHarness h;
   InitHarness(&h);
@@ -31,6 +31,7 @@ int odin_cli_server_test_fail_next(odin_cli_server_test_failpoint_t fp,
   case ODIN_CLI_SERVER_TEST_FAIL_SIGACTION_SIGINT:
   case ODIN_CLI_SERVER_TEST_FAIL_SIGACTION_SIGTERM:
   case ODIN_CLI_SERVER_TEST_FAIL_SIGNAL_TIMER_START:
+  case ODIN_CLI_SERVER_TEST_FAIL_STATS_TIMER_START:
   case ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_CREATE:
   case ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_START:
   case ODIN_CLI_SERVER_TEST_FAIL_XQC_SERVER_RUNTIME_LOCAL_ADDR:
@@ -47,6 +48,7 @@ int odin_cli_server_test_fail_next(odin_cli_server_test_failpoint_t fp,
 void odin_cli_server_test_reset_liveness(void) {
   g_live_xqc_runtimes = 0;
   memset(&g_filter_record, 0, sizeof(g_filter_record));
+  memset(&g_source_pool_record, 0, sizeof(g_source_pool_record));
   g_last_bind_addr_recorded = 0;
   memset(&g_last_bind_addr, 0, sizeof(g_last_bind_addr));
   g_progress_fd = -1;
@@ -128,6 +130,16 @@ int odin_cli_server_test_filter_record(
   return 0;
 }
 
+int odin_cli_server_test_source_pool_record(
+    odin_cli_server_test_source_pool_record_t *out) {
+  if (out == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  *out = g_source_pool_record;
+  return 0;
+}
+
 int odin_cli_server_test_set_quic_start_probe(
     void (*cb)(odin_xqc_server_runtime_t *rt, void *user_data),
     void *user_data) {
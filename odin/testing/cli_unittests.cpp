@@ -1,11 +1,15 @@
 // odin/testing/cli_unittests.cpp
 //
 // Tests T1-T10 from §7 of odin/docs/rfc_002_cli_skeleton.md,
-// T1-T8 from §7 of odin/docs/rfc_006_cli_listen_port_parser.md, and
-// T6-T8 from §7 of odin/docs/rfc_007_cli_server_host_addr_parser.md.
+// T1-T8 from §7 of odin/docs/rfc_006_cli_listen_port_parser.md,
+// T6-T8 from §7 of odin/docs/rfc_007_cli_server_host_addr_parser.md, and
+// the parser rows of the optional-flag RFCs: RFC-037 T6, RFC-038 T9,
+// RFC-039 T6, RFC-040 T7, RFC-041 T8, RFC-042 T7, RFC-045 T12, RFC-049 T7,
+// RFC-050 T7, and RFC-051 T9.
 
 #include "odin/cli.h"
 
+#include <arpa/inet.h>
 #include <cerrno>
 #include <cstdint>
 #include <cstdio>
@@ -13,7 +17,9 @@
 #include <cstring>
 #include <getopt.h>
 #include <initializer_list>
+#include <netinet/in.h>
 #include <string>
+#include <sys/socket.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <vector>
@@ -97,12 +103,24 @@ std::string Basename(const std::string &path) {
 }
 
 constexpr const char kUC[] =
-    "usage: odin-client --listen ADDR --server ADDR --ca-file FILE";
+    "usage: odin-client --listen ADDR --server ADDR --ca-file FILE "
+    "[--extra-server ADDR]... [--addrs-per-server N] "
+    "[--transparent] [--frontend http|socks5|auto] [--route RULE]... "
+    "[--cert-cache-ttl-ms MS] [--dns-stub-port PORT] "
+    "[--access-log FILE] [--access-log-format text|jsonl] "
+    "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+    "[--qlog-max-bytes N] [--stats-interval-s N]";
 constexpr const char kUS[] =
-    "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE";
+    "usage: odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+    "[--source-addr IP]... [--source-policy round-robin|least-used] "
+    "[--access-log FILE] [--access-log-format text|jsonl] "
+    "[--qlog FILE] [--qlog-sample N] [--qlog-force-ip IP] "
+    "[--qlog-max-bytes N] [--stats-interval-s N]";
 constexpr const char kUBoth[] =
-    "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE' or "
-    "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE'";
+    "usage: 'odin-client --listen ADDR --server ADDR --ca-file FILE "
+    "[OPTION]...' or "
+    "'odin-server --listen ADDR --quic-cert FILE --quic-key FILE "
+    "[OPTION]...'";
 
 } // namespace
 
@@ -876,6 +894,669 @@ TEST(OdinCliCaFileTest, T2BadCaFileFormsAndPrecedence) {
   }
 }
 
+// RFC-038 T9 — `--route` repeats, aliases argv in order, and rejects empty
+// values and one rule past the table limit as ERR_BAD_OPTION.
+TEST(OdinCliRouteTest, T9RouteFlagParse) {
+  const std::vector<std::string> base = {"odin-client", "--listen", "8080",
+                                         "--server",    "S",        "--ca-file",
+                                         "CA"};
+  {
+    MutableArgv argv(base);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.route_rule_count, static_cast<size_t>(0));
+  }
+  {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(),
+                  {"--route", "direct 10.0.0.0/8", "--route=tunnel *"});
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    ASSERT_EQ(out.route_rule_count, static_cast<size_t>(2));
+    EXPECT_EQ(out.route_rules[0], argv.argv()[8]);
+    EXPECT_EQ(out.route_rules[1], argv.argv()[9] + std::strlen("--route="));
+    EXPECT_STREQ(out.route_rules[1], "tunnel *");
+  }
+  const size_t route_max = ODIN_CLI_ROUTE_RULES_MAX;
+  for (const size_t count : {route_max, route_max + 1}) {
+    std::vector<std::string> tokens = base;
+    for (size_t i = 0; i < count; ++i) {
+      tokens.insert(tokens.end(), {"--route", "direct *"});
+    }
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              count == ODIN_CLI_ROUTE_RULES_MAX ? ODIN_CLI_OK_CLIENT
+                                                : ODIN_CLI_ERR_BAD_OPTION);
+    EXPECT_EQ(out.route_rule_count,
+              count == ODIN_CLI_ROUTE_RULES_MAX ? count : 0);
+  }
+
+  struct Case {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Case> cases = {
+      {{"--route", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--route="}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--route"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--rou", "direct *"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--route", "direct *", "--help"}, ODIN_CLI_HELP_CLIENT},
+  };
+  for (const Case &c : cases) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.route_rule_count, static_cast<size_t>(0));
+  }
+  {
+    // Missing required flags outrank a bad --route value.
+    MutableArgv argv({"odin-client", "--route", "", "--ca-file", "CA"});
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_ERR_MISSING_REQUIRED);
+  }
+  {
+    MutableArgv argv({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--route", "direct *"});
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_ERR_UNKNOWN_FLAG);
+  }
+
+  char out_buf[512] = {};
+  char err_buf[512] = {};
+  FILE *out = fmemopen(out_buf, sizeof(out_buf), "w");
+  FILE *err = fmemopen(err_buf, sizeof(err_buf), "w");
+  ASSERT_NE(out, nullptr);
+  ASSERT_NE(err, nullptr);
+  std::vector<std::string> tokens = base;
+  tokens.insert(tokens.end(), {"--route", ""});
+  MutableArgv argv(tokens);
+  EXPECT_EQ(odin_cli_main(argv.argc(), argv.argv(), out, err), 2);
+  static_cast<void>(std::fclose(out));
+  static_cast<void>(std::fclose(err));
+  EXPECT_STREQ(out_buf, "");
+  EXPECT_EQ(std::string(err_buf),
+            std::string("odin: invalid option value\n") + kUBoth + "\n");
+}
+
+// RFC-049 T7 — `--access-log` / `--access-log-format` in both modes: the
+// path aliases argv, the format defaults to text, and empty paths or
+// unknown formats return ERR_BAD_OPTION.
+TEST(OdinCliAccessLogTest, T7AccessLogFlagsParse) {
+  {
+    MutableArgv argv({"odin-client", "--server", "S", "--ca-file", "CA",
+                      "--access-log", "/var/log/odin.log",
+                      "--access-log-format", "jsonl"});
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.access_log_path, argv.argv()[6]);
+    EXPECT_EQ(out.access_log_format, ODIN_ACCESS_LOG_JSONL);
+  }
+  {
+    MutableArgv argv({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--access-log=L"});
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_SERVER);
+    EXPECT_STREQ(out.access_log_path, "L");
+    EXPECT_EQ(out.access_log_format, ODIN_ACCESS_LOG_TEXT);
+  }
+  {
+    MutableArgv argv({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--access-log-format", "text"});
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_SERVER);
+    EXPECT_EQ(out.access_log_path, nullptr);
+  }
+
+  struct Case {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Case> cases = {
+      {{"--access-log", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--access-log="}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--access-log", "L", "--access-log-format", "json"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"--access-log", "L", "--access-log-format", "JSONL"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"--access-log"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--access", "L"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--access-log-fmt", "text"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const char *mode : {"odin-client", "odin-server"}) {
+    const std::vector<std::string> base =
+        std::string(mode) == "odin-client"
+            ? std::vector<std::string>{mode, "--server", "S", "--ca-file", "CA"}
+            : std::vector<std::string>{mode, "--quic-cert", "C", "--quic-key",
+                                       "K"};
+    for (const Case &c : cases) {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+      SCOPED_TRACE(tokens.back());
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+      EXPECT_EQ(out.access_log_path, nullptr);
+    }
+  }
+
+  char out_buf[512] = {};
+  char err_buf[512] = {};
+  FILE *out = fmemopen(out_buf, sizeof(out_buf), "w");
+  FILE *err = fmemopen(err_buf, sizeof(err_buf), "w");
+  ASSERT_NE(out, nullptr);
+  ASSERT_NE(err, nullptr);
+  MutableArgv argv({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                    "--access-log-format", "xml"});
+  EXPECT_EQ(odin_cli_main(argv.argc(), argv.argv(), out, err), 2);
+  static_cast<void>(std::fclose(out));
+  static_cast<void>(std::fclose(err));
+  EXPECT_STREQ(out_buf, "");
+  EXPECT_EQ(std::string(err_buf),
+            std::string("odin: invalid option value\n") + kUBoth + "\n");
+}
+
+// RFC-039 T6 — --extra-server takes the --server shapes, up to one per spare
+// upstream slot; --addrs-per-server takes a decimal count in [1, 8].
+TEST(OdinCliUpstreamTest, T6ExtraServerFlagsParse) {
+  const std::vector<std::string> base = {"odin-client", "--server", "S",
+                                         "--ca-file", "CA"};
+  {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(),
+                  {"--extra-server", "b.example.com", "--extra-server=[::1]:9",
+                   "--addrs-per-server", "8"});
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    ASSERT_EQ(out.extra_server_count, 2u);
+    EXPECT_EQ(out.extra_servers[0].host, argv.argv()[6]);
+    EXPECT_EQ(out.extra_servers[0].host_len, std::strlen("b.example.com"));
+    EXPECT_EQ(out.extra_servers[0].port, ODIN_CLI_DEFAULT_LISTEN_PORT_SERVER);
+    EXPECT_EQ(std::string(out.extra_servers[1].host,
+                          out.extra_servers[1].host_len),
+              "::1");
+    EXPECT_EQ(out.extra_servers[1].port, 9);
+    EXPECT_EQ(out.addrs_per_server, 8u);
+  }
+  {
+    std::vector<std::string> tokens = base;
+    for (size_t i = 0; i < ODIN_CLI_EXTRA_SERVERS_MAX; ++i) {
+      tokens.insert(tokens.end(),
+                    {"--extra-server", "h:" + std::to_string(i + 1)});
+    }
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    ASSERT_EQ(out.extra_server_count, ODIN_CLI_EXTRA_SERVERS_MAX);
+    EXPECT_EQ(out.extra_servers[ODIN_CLI_EXTRA_SERVERS_MAX - 1].port,
+              ODIN_CLI_EXTRA_SERVERS_MAX);
+    EXPECT_EQ(out.addrs_per_server, 0u);
+
+    tokens.insert(tokens.end(), {"--extra-server", "h"});
+    MutableArgv more(tokens);
+    odin_cli_args_t more_out{};
+    EXPECT_EQ(odin_cli_parse(more.argc(), more.argv(), &more_out),
+              ODIN_CLI_ERR_BAD_OPTION);
+    EXPECT_EQ(more_out.extra_server_count, 0u);
+  }
+
+  struct Case {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Case> cases = {
+      {{"--extra-server", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--extra-server", "h:65536"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--extra-server", "[::1"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--addrs-per-server", "0"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--addrs-per-server", "9"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--addrs-per-server", "+2"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--addrs-per-server", "18446744073709551617"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"--addrs-per-server", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--extra-server"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--extra", "h"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--addrs-per-server"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const Case &c : cases) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.extra_server_count, 0u);
+    EXPECT_EQ(out.addrs_per_server, 0u);
+  }
+
+  MutableArgv server({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--extra-server", "h"});
+  odin_cli_args_t out{};
+  EXPECT_EQ(odin_cli_parse(server.argc(), server.argv(), &out),
+            ODIN_CLI_ERR_UNKNOWN_FLAG);
+}
+
+// RFC-040 T7 — --transparent is a Client-only switch that takes no value.
+TEST(OdinCliTransparentTest, T7TransparentFlagParse) {
+  const std::vector<std::string> base = {"odin-client", "--server", "S",
+                                         "--ca-file", "CA"};
+  for (const auto &extra : std::vector<std::vector<std::string>>{
+           {}, {"--transparent"}, {"--transparent", "--transparent"}}) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), extra.begin(), extra.end());
+    SCOPED_TRACE(extra.size());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.transparent, extra.empty() ? 0 : 1);
+  }
+
+  const std::vector<std::vector<std::string>> bads = {
+      {"odin-client", "--server", "S", "--ca-file", "CA", "--transparent=1"},
+      {"odin-client", "--server", "S", "--ca-file", "CA", "--trans"},
+      {"odin-client", "--server", "S", "--ca-file", "CA", "--transparent",
+       "yes"},
+      {"odin-server", "--quic-cert", "C", "--quic-key", "K", "--transparent"},
+  };
+  for (const auto &tokens : bads) {
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_ERR_UNKNOWN_FLAG);
+    EXPECT_EQ(out.transparent, 0);
+  }
+}
+
+// RFC-041 T8 — --frontend selects the listener protocol in Client mode only.
+TEST(OdinCliFrontendTest, T8FrontendFlagParse) {
+  const std::vector<std::string> base = {"odin-client", "--server", "S",
+                                         "--ca-file", "CA"};
+  struct Ok {
+    std::vector<std::string> tokens;
+    odin_client_session_frontend_t expected;
+  };
+  const std::vector<Ok> oks = {
+      {{}, ODIN_CLIENT_SESSION_FRONTEND_HTTP},
+      {{"--frontend", "http"}, ODIN_CLIENT_SESSION_FRONTEND_HTTP},
+      {{"--frontend", "socks5"}, ODIN_CLIENT_SESSION_FRONTEND_SOCKS5},
+      {{"--frontend=auto"}, ODIN_CLIENT_SESSION_FRONTEND_AUTO},
+      {{"--frontend", "auto", "--frontend", "socks5"},
+       ODIN_CLIENT_SESSION_FRONTEND_SOCKS5},
+  };
+  for (const Ok &c : oks) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.frontend, c.expected);
+  }
+
+  struct Bad {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Bad> bads = {
+      {{"odin-client", "--server", "S", "--ca-file", "CA", "--frontend", ""},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"odin-client", "--server", "S", "--ca-file", "CA", "--frontend",
+        "socks4"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"odin-client", "--server", "S", "--ca-file", "CA", "--frontend",
+        "SOCKS5"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"odin-client", "--server", "S", "--ca-file", "CA", "--frontend"},
+       ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"odin-client", "--server", "S", "--ca-file", "CA", "--front", "auto"},
+       ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"odin-client", "--frontend", "bogus"}, ODIN_CLI_ERR_MISSING_REQUIRED},
+      {{"odin-server", "--quic-cert", "C", "--quic-key", "K", "--frontend",
+        "auto"},
+       ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const Bad &c : bads) {
+    SCOPED_TRACE(c.tokens.back());
+    MutableArgv argv(c.tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.frontend, ODIN_CLIENT_SESSION_FRONTEND_HTTP);
+  }
+}
+
+// RFC-042 T7 — --cert-cache-ttl-ms takes a positive decimal count of ms.
+TEST(OdinCliCertCacheTest, T7CertCacheTtlFlagParse) {
+  const std::vector<std::string> base = {"odin-client", "--server", "S",
+                                         "--ca-file", "CA"};
+  struct Ok {
+    std::vector<std::string> tokens;
+    uint64_t expected;
+  };
+  const std::vector<Ok> oks = {
+      {{}, 0u},
+      {{"--cert-cache-ttl-ms", "1"}, 1u},
+      {{"--cert-cache-ttl-ms=600000"}, 600000u},
+      {{"--cert-cache-ttl-ms", "18446744073709551615"}, UINT64_MAX},
+  };
+  for (const Ok &c : oks) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.cert_cache_ttl_ms, c.expected);
+  }
+
+  struct Bad {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Bad> bads = {
+      {{"--cert-cache-ttl-ms", "0"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--cert-cache-ttl-ms", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--cert-cache-ttl-ms", "-1"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--cert-cache-ttl-ms", "1s"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--cert-cache-ttl-ms", "18446744073709551616"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"--cert-cache-ttl-ms"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--cert-cache-ttl", "1"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const Bad &c : bads) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.cert_cache_ttl_ms, 0u);
+  }
+
+  MutableArgv server({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--cert-cache-ttl-ms", "1"});
+  odin_cli_args_t out{};
+  EXPECT_EQ(odin_cli_parse(server.argc(), server.argv(), &out),
+            ODIN_CLI_ERR_UNKNOWN_FLAG);
+}
+
+// RFC-045 T12 — --dns-stub-port takes a nonzero decimal port.
+TEST(OdinCliDnsStubTest, T12DnsStubPortFlagParse) {
+  const std::vector<std::string> base = {"odin-client", "--server", "S",
+                                         "--ca-file", "CA"};
+  struct Ok {
+    std::vector<std::string> tokens;
+    uint16_t expected;
+  };
+  const std::vector<Ok> oks = {
+      {{}, 0},
+      {{"--dns-stub-port", "5353"}, 5353},
+      {{"--dns-stub-port=1"}, 1},
+      {{"--dns-stub-port", "65535"}, 65535},
+  };
+  for (const Ok &c : oks) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_CLIENT);
+    EXPECT_EQ(out.dns_stub_port, c.expected);
+  }
+
+  struct Bad {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Bad> bads = {
+      {{"--dns-stub-port", "0"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--dns-stub-port", "65536"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--dns-stub-port", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--dns-stub-port", "0x35"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--dns-stub-port", " 53"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--dns-stub-port"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--dns-stub", "53"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const Bad &c : bads) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.dns_stub_port, 0);
+  }
+
+  MutableArgv server({"odin-server", "--quic-cert", "C", "--quic-key", "K",
+                      "--dns-stub-port", "53"});
+  odin_cli_args_t out{};
+  EXPECT_EQ(odin_cli_parse(server.argc(), server.argv(), &out),
+            ODIN_CLI_ERR_UNKNOWN_FLAG);
+}
+
+// RFC-050 T7 — the qlog flags parse the same way in both modes.
+TEST(OdinCliQlogTest, T7QlogFlagsParse) {
+  for (const char *mode : {"odin-client", "odin-server"}) {
+    SCOPED_TRACE(mode);
+    const std::vector<std::string> base =
+        std::string(mode) == "odin-client"
+            ? std::vector<std::string>{mode, "--server", "S", "--ca-file", "CA"}
+            : std::vector<std::string>{mode, "--quic-cert", "C", "--quic-key",
+                                       "K"};
+    {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(),
+                    {"--qlog", "/var/log/odin.qlog", "--qlog-sample", "0",
+                     "--qlog-force-ip=2001:db8::7", "--qlog-max-bytes",
+                     "18446744073709551615"});
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+                std::string(mode) == "odin-client" ? ODIN_CLI_OK_CLIENT
+                                                   : ODIN_CLI_OK_SERVER);
+      EXPECT_EQ(out.qlog_path, argv.argv()[6]);
+      EXPECT_EQ(out.qlog_sample_every, 0u);
+      EXPECT_STREQ(out.qlog_force_ip, "2001:db8::7");
+      EXPECT_EQ(out.qlog_max_bytes, UINT64_MAX);
+    }
+    {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(), {"--qlog-sample", "4294967295",
+                                   "--qlog-max-bytes=1"});
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+                std::string(mode) == "odin-client" ? ODIN_CLI_OK_CLIENT
+                                                   : ODIN_CLI_OK_SERVER);
+      EXPECT_EQ(out.qlog_path, nullptr);
+      EXPECT_EQ(out.qlog_sample_every, UINT32_MAX);
+      EXPECT_EQ(out.qlog_force_ip, nullptr);
+      EXPECT_EQ(out.qlog_max_bytes, 1u);
+    }
+
+    struct Case {
+      std::vector<std::string> tokens;
+      odin_cli_status_t expected;
+    };
+    const std::vector<Case> cases = {
+        {{"--qlog", ""}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog-force-ip="}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog-sample", "4294967296"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog-sample", "-1"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog-max-bytes", "0"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog-max-bytes", "64M"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--qlog"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+        {{"--qlog-sample"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+        {{"--qlog-force", "127.0.0.1"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+        {{"--qlog-max", "1"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+    };
+    for (const Case &c : cases) {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+      SCOPED_TRACE(tokens.back());
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+      EXPECT_EQ(out.qlog_path, nullptr);
+      EXPECT_EQ(out.qlog_sample_every, 0u);
+      EXPECT_EQ(out.qlog_max_bytes, 0u);
+    }
+  }
+}
+
+// RFC-051 T9 — --stats-interval-s parses the same way in both modes; absent
+// or 0 leaves the stats line off.
+TEST(OdinCliStatsTest, T9StatsIntervalParses) {
+  for (const char *mode : {"odin-client", "odin-server"}) {
+    SCOPED_TRACE(mode);
+    const std::vector<std::string> base =
+        std::string(mode) == "odin-client"
+            ? std::vector<std::string>{mode, "--server", "S", "--ca-file", "CA"}
+            : std::vector<std::string>{mode, "--quic-cert", "C", "--quic-key",
+                                       "K"};
+    const odin_cli_status_t ok = std::string(mode) == "odin-client"
+                                     ? ODIN_CLI_OK_CLIENT
+                                     : ODIN_CLI_OK_SERVER;
+    const struct {
+      std::vector<std::string> tokens;
+      uint32_t expected;
+    } good[] = {
+        {{}, 0u},
+        {{"--stats-interval-s", "0"}, 0u},
+        {{"--stats-interval-s", "10"}, 10u},
+        {{"--stats-interval-s=86400"}, ODIN_CLI_STATS_INTERVAL_MAX_S},
+    };
+    for (const auto &g : good) {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(), g.tokens.begin(), g.tokens.end());
+      SCOPED_TRACE(tokens.back());
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), ok);
+      EXPECT_EQ(out.stats_interval_s, g.expected);
+    }
+
+    struct Case {
+      std::vector<std::string> tokens;
+      odin_cli_status_t expected;
+    };
+    const std::vector<Case> cases = {
+        {{"--stats-interval-s", "86401"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--stats-interval-s", "-1"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--stats-interval-s", "10s"}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--stats-interval-s", ""}, ODIN_CLI_ERR_BAD_OPTION},
+        {{"--stats-interval-s"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+        {{"--stats-interval", "10"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+    };
+    for (const Case &c : cases) {
+      std::vector<std::string> tokens = base;
+      tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+      SCOPED_TRACE(tokens.back());
+      MutableArgv argv(tokens);
+      odin_cli_args_t out{};
+      EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+      EXPECT_EQ(out.stats_interval_s, 0u);
+    }
+  }
+}
+
+// RFC-037 T6 — --source-addr repeats with numeric IPv4 / IPv6 addresses up to
+// a full pool, and --source-policy picks the pool policy in Server mode only.
+TEST(OdinCliSourcePoolTest, T6SourceFlagsParse) {
+  const std::vector<std::string> base = {"odin-server", "--quic-cert", "C",
+                                         "--quic-key", "K"};
+  {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), {"--source-addr", "192.0.2.1",
+                                 "--source-addr=2001:db8::2",
+                                 "--source-policy", "least-used"});
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_SERVER);
+    ASSERT_EQ(out.source_addr_count, 2u);
+    const auto *sin =
+        reinterpret_cast<const struct sockaddr_in *>(&out.source_addrs[0]);
+    EXPECT_EQ(sin->sin_family, AF_INET);
+    EXPECT_EQ(ntohl(sin->sin_addr.s_addr), 0xC0000201u);
+    EXPECT_EQ(sin->sin_port, 0);
+    const auto *sin6 =
+        reinterpret_cast<const struct sockaddr_in6 *>(&out.source_addrs[1]);
+    EXPECT_EQ(sin6->sin6_family, AF_INET6);
+    EXPECT_EQ(sin6->sin6_addr.s6_addr[15], 2);
+    EXPECT_EQ(out.source_policy, ODIN_DIAL_SOURCE_LEAST_USED);
+  }
+  {
+    std::vector<std::string> tokens = base;
+    for (size_t i = 0; i < ODIN_CLI_SOURCE_ADDRS_MAX; ++i) {
+      tokens.insert(tokens.end(),
+                    {"--source-addr", "127.0.0." + std::to_string(i + 1)});
+    }
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    ASSERT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out),
+              ODIN_CLI_OK_SERVER);
+    EXPECT_EQ(out.source_addr_count, ODIN_CLI_SOURCE_ADDRS_MAX);
+    EXPECT_EQ(out.source_policy, ODIN_DIAL_SOURCE_ROUND_ROBIN);
+
+    tokens.insert(tokens.end(), {"--source-addr", "127.0.0.99"});
+    MutableArgv more(tokens);
+    odin_cli_args_t more_out{};
+    EXPECT_EQ(odin_cli_parse(more.argc(), more.argv(), &more_out),
+              ODIN_CLI_ERR_BAD_OPTION);
+    EXPECT_EQ(more_out.source_addr_count, 0u);
+  }
+
+  struct Case {
+    std::vector<std::string> tokens;
+    odin_cli_status_t expected;
+  };
+  const std::vector<Case> cases = {
+      {{"--source-addr", ""}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-addr", "localhost"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-addr", "127.0.0.1:80"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-addr", "[::1]"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-addr", "127.0.0.1", "--source-policy", "random"},
+       ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-policy", "round-robin"}, ODIN_CLI_ERR_BAD_OPTION},
+      {{"--source-addr"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--source", "127.0.0.1"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+      {{"--source-policy"}, ODIN_CLI_ERR_UNKNOWN_FLAG},
+  };
+  for (const Case &c : cases) {
+    std::vector<std::string> tokens = base;
+    tokens.insert(tokens.end(), c.tokens.begin(), c.tokens.end());
+    SCOPED_TRACE(tokens.back());
+    MutableArgv argv(tokens);
+    odin_cli_args_t out{};
+    EXPECT_EQ(odin_cli_parse(argv.argc(), argv.argv(), &out), c.expected);
+    EXPECT_EQ(out.source_addr_count, 0u);
+  }
+
+  MutableArgv client({"odin-client", "--server", "S", "--ca-file", "CA",
+                      "--source-addr", "127.0.0.1"});
+  odin_cli_args_t out{};
+  EXPECT_EQ(odin_cli_parse(client.argc(), client.argv(), &out),
+            ODIN_CLI_ERR_UNKNOWN_FLAG);
+}
+
 int main(int argc, char **argv) {
   if (argc > 0 && argv[0] != nullptr) {
     g_test_argv0 = argv[0];
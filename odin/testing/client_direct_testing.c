@@ -0,0 +1 @@
+#include "odin/client_direct.c" // NOLINT(bugprone-suspicious-include)
@@ -31,6 +31,7 @@ int odin_client_session_test_fail_next_downstream_transport_create(int errnum);
 #define ODIN_CLIENT_SESSION_TEST_STATE_WRITING_ERR_HTTP 4
 #define ODIN_CLIENT_SESSION_TEST_STATE_RELAY 5
 #define ODIN_CLIENT_SESSION_TEST_STATE_TERMINAL 6
+#define ODIN_CLIENT_SESSION_TEST_STATE_DIRECT 7
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,512 @@
+// odin/testing/client_session_unittests.cpp
+//
+// Integration tests T5-T8 from §5 of
+// odin/docs/rfc_038_client_split_routing.md, T4-T6 from §5 of
+// odin/docs/rfc_040_transparent_proxy.md, and T5-T7 from §5 of
+// odin/docs/rfc_041_socks5_frontend.md.
+//
+// Drives a real client session over a socketpair, with a fake upstream
+// transport factory standing in for the QUIC runtime and either the real
+// odin_client_direct connector or a fake one.
+
+#include "odin/client_session.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "odin/client_direct.h"
+#include "odin/dns_resolver.h"
+#include "odin/event_loop.h"
+#include "odin/route.h"
+#include "odin/socks5.h"
+#include "odin/testing/client_session_internal_test.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+void SetNonblock(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  ASSERT_NE(flags, -1) << std::strerror(errno);
+  ASSERT_EQ(fcntl(fd, F_SETFL, flags | O_NONBLOCK), 0) << std::strerror(errno);
+}
+
+void MakePair(int *owned, int *peer) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0)
+      << std::strerror(errno);
+  SetNonblock(fds[0]);
+  SetNonblock(fds[1]);
+  *owned = fds[0];
+  *peer = fds[1];
+}
+
+struct sockaddr_in LoopbackAddr(uint16_t port) {
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  return addr;
+}
+
+int OpenLoopbackListener(uint16_t *port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(fd, reinterpret_cast<const struct sockaddr *>(&addr),
+           sizeof(addr)) != 0 ||
+      listen(fd, 4) != 0 ||
+      getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) != 0) {
+    close(fd);
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+std::string DrainFdNow(int fd) {
+  std::string out;
+  char buf[512];
+  for (;;) {
+    const ssize_t n = read(fd, buf, sizeof(buf));
+    if (n > 0) {
+      out.append(buf, static_cast<size_t>(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    return out;
+  }
+}
+
+std::string HttpConnectReq(const char *host, uint16_t port) {
+  return std::string("CONNECT ") + host + ":" + std::to_string(port) +
+         " HTTP/1.1\r\n\r\n";
+}
+
+const std::string kSocksGreeting("\x05\x01\x00", 3);
+
+std::string SocksConnectV4(uint16_t port) {
+  return std::string("\x05\x01\x00\x01\x7f\x00\x00\x01", 8) +
+         static_cast<char>(port >> 8) + static_cast<char>(port & 0xFF);
+}
+
+std::string SocksReply(uint8_t rep) {
+  return std::string("\x05", 1) + static_cast<char>(rep) +
+         std::string("\x00\x01\x00\x00\x00\x00\x00\x00", 8);
+}
+
+void StopTimerCb(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                 void *user_data) {
+  (void)user_data;
+  odin_event_timer_stop(timer);
+  odin_event_loop_stop(loop);
+}
+
+void RunLoopFor(odin_event_loop_t *loop, uint64_t usec = 20000) {
+  odin_event_timer_t *timer = nullptr;
+  ASSERT_EQ(odin_event_timer_start(loop, usec, 0, StopTimerCb, nullptr, &timer),
+            0)
+      << std::strerror(errno);
+  ASSERT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+}
+
+struct SessionRecord {
+  int factory_calls = 0;
+  int close_calls = 0;
+  int close_err = 0;
+};
+
+int FailingFactory(odin_transport_ready_cb on_ready, void *ready_user_data,
+                   void *factory_user_data, odin_transport_t **out) {
+  (void)on_ready;
+  (void)ready_user_data;
+  (void)out;
+  static_cast<SessionRecord *>(factory_user_data)->factory_calls += 1;
+  errno = ECONNREFUSED;
+  return -1;
+}
+
+void RecordClose(odin_client_session_t *cs, int err, void *user_data) {
+  (void)cs;
+  auto *rec = static_cast<SessionRecord *>(user_data);
+  rec->close_calls += 1;
+  rec->close_err = err;
+}
+
+struct FakeDirect {
+  int starts = 0;
+  int cancels = 0;
+  std::string host;
+  uint16_t port = 0;
+  int token = 0;
+};
+
+int FakeDirectStart(const char *host, size_t host_len, uint16_t port,
+                    odin_client_session_direct_done_cb on_done,
+                    void *done_user_data, void *direct_user_data,
+                    void **out_attempt) {
+  (void)on_done;
+  (void)done_user_data;
+  auto *fake = static_cast<FakeDirect *>(direct_user_data);
+  fake->starts += 1;
+  fake->host.assign(host, host_len);
+  fake->port = port;
+  *out_attempt = &fake->token;
+  return 0;
+}
+
+void FakeDirectCancel(void *attempt, void *direct_user_data) {
+  auto *fake = static_cast<FakeDirect *>(direct_user_data);
+  EXPECT_EQ(attempt, &fake->token);
+  fake->cancels += 1;
+}
+
+class OdinClientSplitRouteTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_EQ(odin_event_loop_create(&loop_), 0) << std::strerror(errno);
+    ASSERT_EQ(odin_dns_resolver_create(loop_, nullptr, &resolver_), 0);
+    ASSERT_EQ(odin_client_direct_create(loop_, resolver_, &direct_), 0);
+  }
+
+  void TearDown() override {
+    odin_client_session_destroy(cs_);
+    if (peer_ >= 0) {
+      close(peer_);
+    }
+    odin_client_direct_destroy(direct_);
+    odin_dns_resolver_destroy(resolver_);
+    odin_route_table_destroy(table_);
+    odin_event_loop_destroy(loop_);
+  }
+
+  void Compile(const char *const *rules, size_t count) {
+    ASSERT_EQ(odin_route_table_create(rules, count, nullptr, &table_), 0);
+  }
+
+  void StartSession(odin_client_session_direct_start_cb start,
+                    odin_client_session_direct_cancel_cb cancel, void *ud) {
+    int conn = -1;
+    MakePair(&conn, &peer_);
+    ASSERT_EQ(odin_client_session_create_with_upstream_transport(
+                  loop_, conn, FailingFactory, &rec_, nullptr, RecordClose,
+                  &rec_, &cs_),
+              0)
+        << std::strerror(errno);
+    const odin_client_session_route_t route = {table_, start, cancel, ud};
+    odin_client_session_set_route(cs_, &route);
+  }
+
+  void StartDirectSession() {
+    StartSession(odin_client_direct_start, odin_client_direct_cancel, direct_);
+  }
+
+  // A direct-capable session told that its connection was redirected from
+  // 127.0.0.1:port.
+  void StartTransparentSession(uint16_t port) {
+    StartDirectSession();
+    const struct sockaddr_in dst = LoopbackAddr(port);
+    ASSERT_EQ(odin_client_session_start_transparent(
+                  cs_, reinterpret_cast<const struct sockaddr *>(&dst),
+                  sizeof(dst)),
+              0)
+        << std::strerror(errno);
+  }
+
+  void Send(const std::string &bytes) {
+    ASSERT_EQ(write(peer_, bytes.data(), bytes.size()),
+              static_cast<ssize_t>(bytes.size()));
+  }
+
+  // Runs the loop until the client peer has read something or the session
+  // closed, for up to ~2 s.
+  std::string AwaitClientBytes() {
+    std::string got;
+    for (int i = 0; i < 100 && got.empty() && rec_.close_calls == 0; ++i) {
+      RunLoopFor(loop_);
+      got += DrainFdNow(peer_);
+    }
+    got += DrainFdNow(peer_);
+    return got;
+  }
+
+  odin_event_loop_t *loop_ = nullptr;
+  odin_dns_resolver_t *resolver_ = nullptr;
+  odin_client_direct_t *direct_ = nullptr;
+  odin_route_table_t *table_ = nullptr;
+  odin_client_session_t *cs_ = nullptr;
+  int peer_ = -1;
+  SessionRecord rec_;
+};
+
+// RFC-038 T5 — a direct-routed CONNECT dials the destination itself: the
+// client gets 200, pipelined bytes reach the destination, and the relay runs
+// both ways with no upstream factory call.
+TEST_F(OdinClientSplitRouteTest, T5DirectRouteRelaysToDestination) {
+  uint16_t port = 0;
+  const int lfd = OpenLoopbackListener(&port);
+  ASSERT_GE(lfd, 0) << std::strerror(errno);
+  const char *rules[] = {"direct 127.0.0.0/8"};
+  Compile(rules, 1);
+  StartDirectSession();
+  Send(HttpConnectReq("127.0.0.1", port) + "hello");
+
+  const std::string resp = AwaitClientBytes();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200", 0), 0u) << resp;
+  EXPECT_EQ(odin_client_session_test_state(cs_),
+            ODIN_CLIENT_SESSION_TEST_STATE_RELAY);
+  EXPECT_EQ(rec_.factory_calls, 0);
+
+  const int up = accept(lfd, nullptr, nullptr);
+  ASSERT_GE(up, 0) << std::strerror(errno);
+  SetNonblock(up);
+  std::string upstream;
+  for (int i = 0; i < 50 && upstream.size() < 5; ++i) {
+    RunLoopFor(loop_);
+    upstream += DrainFdNow(up);
+  }
+  EXPECT_EQ(upstream, "hello");
+
+  ASSERT_EQ(write(up, "world", 5), 5);
+  EXPECT_EQ(AwaitClientBytes(), "world");
+
+  odin_route_stats_t st{};
+  odin_route_stats(table_, &st);
+  EXPECT_EQ(st.direct, 1u);
+  close(up);
+  close(lfd);
+}
+
+// RFC-038 T6 — a CONNECT no direct rule matches still takes the upstream
+// factory, and the connector is never started.
+TEST_F(OdinClientSplitRouteTest, T6TunnelRouteUsesFactory) {
+  const char *rules[] = {"direct corp.lan", "tunnel *"};
+  Compile(rules, 2);
+  FakeDirect fake;
+  StartSession(FakeDirectStart, FakeDirectCancel, &fake);
+  Send(HttpConnectReq("example.com", 443));
+
+  const std::string resp = AwaitClientBytes();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200", 0), std::string::npos) << resp;
+  EXPECT_EQ(rec_.factory_calls, 1);
+  EXPECT_EQ(fake.starts, 0);
+  EXPECT_EQ(odin_route_rule_hits(table_, 1), 1u);
+}
+
+// RFC-038 T7 — a direct dial that fails answers the client with an HTTP error
+// and closes the session with the dial's errno.
+TEST_F(OdinClientSplitRouteTest, T7DirectFailureAnswersError) {
+  uint16_t port = 0;
+  const int lfd = OpenLoopbackListener(&port);
+  ASSERT_GE(lfd, 0) << std::strerror(errno);
+  close(lfd); // nothing listens on port any more
+  const char *rules[] = {"direct *"};
+  Compile(rules, 1);
+  StartDirectSession();
+  Send(HttpConnectReq("127.0.0.1", port));
+
+  const std::string resp = AwaitClientBytes();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 ", 0), 0u) << resp;
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200", 0), std::string::npos) << resp;
+  for (int i = 0; i < 50 && rec_.close_calls == 0; ++i) {
+    RunLoopFor(loop_);
+  }
+  EXPECT_EQ(rec_.close_calls, 1);
+  EXPECT_EQ(rec_.close_err, ECONNREFUSED);
+  EXPECT_EQ(rec_.factory_calls, 0);
+}
+
+// RFC-038 T8 — destroying a session whose direct attempt has not reported
+// cancels the attempt exactly once; the connector sees the bracket-free host.
+TEST_F(OdinClientSplitRouteTest, T8DestroyCancelsPendingAttempt) {
+  const char *rules[] = {"direct ::1"};
+  Compile(rules, 1);
+  FakeDirect fake;
+  StartSession(FakeDirectStart, FakeDirectCancel, &fake);
+  Send(HttpConnectReq("[::1]", 8443));
+  for (int i = 0; i < 50 && fake.starts == 0; ++i) {
+    RunLoopFor(loop_);
+  }
+  ASSERT_EQ(fake.starts, 1);
+  EXPECT_EQ(fake.host, "::1");
+  EXPECT_EQ(fake.port, 8443);
+  EXPECT_EQ(odin_client_session_test_state(cs_),
+            ODIN_CLIENT_SESSION_TEST_STATE_DIRECT);
+
+  odin_client_session_destroy(cs_);
+  cs_ = nullptr;
+  EXPECT_EQ(fake.cancels, 1);
+  EXPECT_EQ(rec_.factory_calls, 0);
+}
+
+// RFC-041 T5 — greeting, request, and first payload in one write: the method
+// reply and the success reply come back together and the payload reaches the
+// destination.
+TEST_F(OdinClientSplitRouteTest, T5Socks5PipelinedDirectRelay) {
+  uint16_t port = 0;
+  const int lfd = OpenLoopbackListener(&port);
+  ASSERT_GE(lfd, 0) << std::strerror(errno);
+  const char *rules[] = {"direct 127.0.0.0/8"};
+  Compile(rules, 1);
+  StartDirectSession();
+  odin_client_session_set_frontend(cs_, ODIN_CLIENT_SESSION_FRONTEND_SOCKS5);
+  Send(kSocksGreeting + SocksConnectV4(port) + "hello");
+
+  EXPECT_EQ(AwaitClientBytes(),
+            std::string("\x05\x00", 2) + SocksReply(0x00));
+  const int up = accept(lfd, nullptr, nullptr);
+  ASSERT_GE(up, 0) << std::strerror(errno);
+  SetNonblock(up);
+  std::string upstream;
+  for (int i = 0; i < 50 && upstream.size() < 5; ++i) {
+    RunLoopFor(loop_);
+    upstream += DrainFdNow(up);
+  }
+  EXPECT_EQ(upstream, "hello");
+  EXPECT_EQ(odin_client_session_test_state(cs_),
+            ODIN_CLIENT_SESSION_TEST_STATE_RELAY);
+  close(up);
+  close(lfd);
+}
+
+// RFC-041 T6 — AUTO sniffs SOCKS5 from the first byte; the method reply goes
+// out before the request arrives, and a failed tunnel answers with the REP
+// code for its errno.
+TEST_F(OdinClientSplitRouteTest, T6AutoSniffsSocks5AndMapsFailure) {
+  StartSession(nullptr, nullptr, nullptr);
+  odin_client_session_set_frontend(cs_, ODIN_CLIENT_SESSION_FRONTEND_AUTO);
+  Send(kSocksGreeting);
+  EXPECT_EQ(AwaitClientBytes(), std::string("\x05\x00", 2));
+  Send(SocksConnectV4(443));
+  EXPECT_EQ(AwaitClientBytes(), SocksReply(ODIN_SOCKS5_REP_CONNECTION_REFUSED));
+  for (int i = 0; i < 50 && rec_.close_calls == 0; ++i) {
+    RunLoopFor(loop_);
+  }
+  EXPECT_EQ(rec_.factory_calls, 1);
+  EXPECT_EQ(rec_.close_err, ECONNREFUSED);
+}
+
+// RFC-041 T7 — AUTO still serves HTTP CONNECT, and a SOCKS5 greeting without
+// the no-auth method is refused with %xFF.
+TEST_F(OdinClientSplitRouteTest, T7AutoServesHttpAndRefusesAuthOnly) {
+  StartSession(nullptr, nullptr, nullptr);
+  odin_client_session_set_frontend(cs_, ODIN_CLIENT_SESSION_FRONTEND_AUTO);
+  Send(HttpConnectReq("example.com", 443));
+  EXPECT_EQ(AwaitClientBytes().rfind("HTTP/1.1 ", 0), 0u);
+  EXPECT_EQ(rec_.factory_calls, 1);
+  odin_client_session_destroy(cs_);
+  cs_ = nullptr;
+  close(peer_);
+  peer_ = -1;
+
+  rec_ = SessionRecord();
+  StartSession(nullptr, nullptr, nullptr);
+  odin_client_session_set_frontend(cs_, ODIN_CLIENT_SESSION_FRONTEND_AUTO);
+  Send(std::string("\x05\x01\x02", 3)); // username/password only
+  EXPECT_EQ(AwaitClientBytes(), std::string("\x05\xff", 2));
+  for (int i = 0; i < 50 && rec_.close_calls == 0; ++i) {
+    RunLoopFor(loop_);
+  }
+  EXPECT_EQ(rec_.close_err, EACCES);
+  EXPECT_EQ(rec_.factory_calls, 0);
+}
+
+// RFC-040 T4 — a transparent session relays the client's first bytes to the
+// destination with no CONNECT parse and no 200 in front of the reply.
+TEST_F(OdinClientSplitRouteTest, T4TransparentRelaysWithoutHttp) {
+  uint16_t port = 0;
+  const int lfd = OpenLoopbackListener(&port);
+  ASSERT_GE(lfd, 0) << std::strerror(errno);
+  const char *rules[] = {"direct 127.0.0.0/8"};
+  Compile(rules, 1);
+  StartTransparentSession(port);
+  Send("hello");
+
+  int up = -1;
+  for (int i = 0; i < 100 && up < 0; ++i) {
+    RunLoopFor(loop_);
+    up = accept(lfd, nullptr, nullptr);
+  }
+  ASSERT_GE(up, 0) << std::strerror(errno);
+  SetNonblock(up);
+  std::string upstream;
+  for (int i = 0; i < 50 && upstream.size() < 5; ++i) {
+    RunLoopFor(loop_);
+    upstream += DrainFdNow(up);
+  }
+  EXPECT_EQ(upstream, "hello");
+  EXPECT_EQ(odin_client_session_test_state(cs_),
+            ODIN_CLIENT_SESSION_TEST_STATE_RELAY);
+
+  ASSERT_EQ(write(up, "world", 5), 5);
+  EXPECT_EQ(AwaitClientBytes(), "world");
+  EXPECT_EQ(rec_.factory_calls, 0);
+  close(up);
+  close(lfd);
+}
+
+// RFC-040 T5 — a transparent session whose tunnel fails closes the client
+// with no HTTP error text and reports the factory's errno.
+TEST_F(OdinClientSplitRouteTest, T5TransparentFailureWritesNoHttp) {
+  StartTransparentSession(443); // no rules: tunnel through the factory
+  const std::string got = AwaitClientBytes();
+  EXPECT_EQ(got, "");
+  for (int i = 0; i < 50 && rec_.close_calls == 0; ++i) {
+    RunLoopFor(loop_);
+  }
+  EXPECT_EQ(rec_.factory_calls, 1);
+  EXPECT_EQ(rec_.close_calls, 1);
+  EXPECT_EQ(rec_.close_err, ECONNREFUSED);
+}
+
+// RFC-040 T6 — only an IPv4 / IPv6 destination with a port starts a
+// transparent session, and only before the session has read anything.
+TEST_F(OdinClientSplitRouteTest, T6TransparentRejectsBadDestination) {
+  StartDirectSession();
+  struct sockaddr_in zero_port = LoopbackAddr(0);
+  errno = 0;
+  EXPECT_EQ(odin_client_session_start_transparent(
+                cs_, reinterpret_cast<const struct sockaddr *>(&zero_port),
+                sizeof(zero_port)),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  struct sockaddr unix_addr{};
+  unix_addr.sa_family = AF_UNIX;
+  EXPECT_EQ(odin_client_session_start_transparent(cs_, &unix_addr,
+                                                  sizeof(unix_addr)),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+
+  Send("CONN");
+  RunLoopFor(loop_);
+  const struct sockaddr_in dst = LoopbackAddr(443);
+  EXPECT_EQ(odin_client_session_start_transparent(
+                cs_, reinterpret_cast<const struct sockaddr *>(&dst),
+                sizeof(dst)),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(odin_client_session_test_state(cs_),
+            ODIN_CLIENT_SESSION_TEST_STATE_PARSING);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
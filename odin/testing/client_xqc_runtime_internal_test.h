@@ -171,6 +171,8 @@ typedef struct odin_xqc_client_runtime_test_ops_t {
   xqc_int_t (*stream_close)(xqc_stream_t *stream);
   int (*udp_register_conn)(odin_xqc_udp_t *xu, const xqc_cid_t *cid);
   void (*udp_unregister_conn)(odin_xqc_udp_t *xu, const xqc_cid_t *cid);
+  xqc_conn_stats_t (*conn_get_stats)(xqc_engine_t *engine,
+                                     const xqc_cid_t *cid);
 } odin_xqc_client_runtime_test_ops_t;
 
 void odin_xqc_client_runtime_test_reset(void);
@@ -1293,7 +1293,8 @@ protected:
   }
 
   void CreateDefaultRuntimeOwned(const char *server_host, const char *ca_file,
-                                 odin_xqc_client_runtime_t **rt) {
+                                 odin_xqc_client_runtime_t **rt,
+                                 odin_cert_cache_t *cert_cache = nullptr) {
     h.expected_server_host = server_host;
     h.expected_no_crypto_flag = 0;
     h.expected_cert_verify_flag =
@@ -1307,6 +1308,7 @@ protected:
     config.peer_addrlen = sizeof(h.peer_addr);
     config.server_host = server_host;
     config.ca_file = ca_file;
+    config.cert_cache = cert_cache;
     ASSERT_EQ(odin_xqc_client_runtime_create_default(&config, rt), 0)
         << std::strerror(errno);
     ASSERT_NE(*rt, nullptr);
@@ -1315,8 +1317,9 @@ protected:
   void CreateCaDefaultRuntimeOwned(const char *server_host,
                                    const std::string &ca,
                                    odin_xqc_client_runtime_t **rt,
-                                   xqc_cert_verify_pt *cb, void **user_data) {
-    CreateDefaultRuntimeOwned(server_host, ca.c_str(), rt);
+                                   xqc_cert_verify_pt *cb, void **user_data,
+                                   odin_cert_cache_t *cert_cache = nullptr) {
+    CreateDefaultRuntimeOwned(server_host, ca.c_str(), rt, cert_cache);
     const odin_xqc_client_runtime_test_record_t *record =
         odin_xqc_client_runtime_test_record();
     ASSERT_NE(
@@ -5028,6 +5031,60 @@ TEST_F(OdinXqcClientRuntimeTest, CaFileT14VerifierAcceptsIntermediateChain) {
   EXPECT_GT(odin_xqc_client_runtime_test_record()->cert_verify_successes, 0u);
 }
 
+// RFC-042 T6: a chain verified by one runtime is accepted from the shared
+// cache by the next without parsing or a store context; failures are never
+// cached, and a different CA file invalidates the cache.
+TEST_F(OdinXqcClientRuntimeTest, CertCacheT6SkipsRepeatVerification) {
+  const std::string ca = CertFixturePath("root-ca.pem");
+  const std::vector<unsigned char> leaf =
+      ReadPemX509DerFile(CertFixturePath("intermediate-server-chain.pem"), 0);
+  const std::vector<unsigned char> intermediate =
+      ReadPemX509DerFile(CertFixturePath("intermediate-server-chain.pem"), 1);
+  ASSERT_FALSE(leaf.empty());
+  ASSERT_FALSE(intermediate.empty());
+  odin_cert_cache_t *cache = nullptr;
+  ASSERT_EQ(odin_cert_cache_create(4, ODIN_CERT_CACHE_DEFAULT_TTL_MS, &cache),
+            0);
+  xqc_cert_verify_pt cb = nullptr;
+  void *user_data = nullptr;
+  {
+    ScopedClientRuntime rt;
+    CreateCaDefaultRuntimeOwned("localhost", ca, rt.out(), &cb, &user_data,
+                                cache);
+    ExpectVerifierDelta(cb, user_data, {leaf, intermediate}, true, 1, 1, 1, 1);
+    ExpectVerifierDelta(cb, user_data, {leaf}, false, 1, 0, 0, 1);
+    ExpectVerifierDelta(cb, user_data, {leaf}, false, 1, 0, 0, 1);
+  }
+  {
+    ScopedClientRuntime rt;
+    CreateCaDefaultRuntimeOwned("localhost", ca, rt.out(), &cb, &user_data,
+                                cache);
+    ExpectVerifierDelta(cb, user_data, {leaf, intermediate}, true, 0, 0, 0, 0);
+  }
+  odin_cert_cache_stats_t stats{};
+  odin_cert_cache_stats(cache, &stats);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 3u);
+  EXPECT_EQ(stats.inserts, 1u);
+  EXPECT_EQ(stats.verifies, 3u);
+  EXPECT_EQ(stats.invalidations, 0u);
+
+  const std::string temp_ca = std::string("/tmp/odin-rfc042-root-copy-") +
+                              std::to_string(getpid()) + ".pem";
+  ASSERT_TRUE(CopyFileBytes(ca, temp_ca));
+  {
+    ScopedClientRuntime rt;
+    CreateCaDefaultRuntimeOwned("localhost", temp_ca, rt.out(), &cb,
+                                &user_data, cache);
+    ASSERT_EQ(unlink(temp_ca.c_str()), 0) << std::strerror(errno);
+    ExpectVerifierDelta(cb, user_data, {leaf, intermediate}, true, 1, 1, 1, 1);
+  }
+  odin_cert_cache_stats(cache, &stats);
+  EXPECT_EQ(stats.invalidations, 1u);
+  EXPECT_EQ(stats.hits, 1u);
+  odin_cert_cache_destroy(cache);
+}
+
 } // namespace
 
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -1,6 +1,7 @@
 // odin/testing/connect_session_unittests.cpp
 //
-// Unit tests T1-T27 from §5 of odin/docs/rfc_018_connect_session.md.
+// Unit tests T1-T27 from §5 of odin/docs/rfc_018_connect_session.md, plus T8
+// from §5 of odin/docs/rfc_033_single_allocation_server_session.md.
 //
 // T1-T26 drive the session against a test-local fake transport (no fd, no
 // event loop): the fake embeds odin_transport_t as its first member, serves
@@ -1111,4 +1112,49 @@ TEST(OdinConnectSessionTest, T27) {
   EXPECT_EQ(done.calls, 0);
 }
 
+// RFC-033 T8 — the _in constructors build both modes inside one caller
+// storage in turn: a client session destroyed from on_done, then a server
+// session decoding a REQ from the same bytes.
+TEST(OdinConnectSessionStorageTest, T8CreateInBothModesShareStorage) {
+  odin_connect_session_storage_t storage;
+
+  FakeTransport t = MakeFake();
+  DoneRecord done;
+  done.destroy_in_cb = true;
+  odin_connect_session_t *s = nullptr;
+  ASSERT_EQ(odin_connect_session_create_client_in(
+                &storage, "example.com", 11, 443, OnDone, &done, &s),
+            0);
+  EXPECT_EQ(static_cast<void *>(s), static_cast<void *>(&storage));
+  t.writes.push_back(WriteAcceptAll());
+  EXPECT_EQ(odin_connect_session_drive(s, &t.base, ODIN_TRANSPORT_WRITE),
+            ODIN_CONNECT_SESSION_DRIVE_CONTINUE);
+  t.reads.push_back(ReadData(std::string("\x01\x02\x00\x00", 4)));
+  EXPECT_EQ(odin_connect_session_drive(s, &t.base, ODIN_TRANSPORT_READ),
+            ODIN_CONNECT_SESSION_DRIVE_DONE);
+  EXPECT_EQ(done.calls, 1);
+  EXPECT_EQ(done.status, ODIN_CONNECT_SESSION_OK);
+
+  FakeTransport u = MakeFake();
+  ReqDecodedRecord rd;
+  DoneRecord dn;
+  Combo combo{&rd, &dn};
+  odin_connect_session_t *srv = nullptr;
+  ASSERT_EQ(odin_connect_session_create_server_in(
+                &storage, OnComboReqDecoded, OnComboDone, &combo, &srv),
+            0);
+  u.reads.push_back(ReadData(EncodedReq("example.org", 8443)));
+  u.reads.push_back(ReadAgain());
+  EXPECT_EQ(odin_connect_session_drive(srv, &u.base, ODIN_TRANSPORT_READ),
+            ODIN_CONNECT_SESSION_DRIVE_CONTINUE);
+  EXPECT_EQ(rd.calls, 1);
+  const char *host = nullptr;
+  size_t host_len = 0;
+  odin_connect_session_server_host(srv, &host, &host_len);
+  EXPECT_EQ(std::string(host, host_len), std::string("example.org"));
+  EXPECT_EQ(odin_connect_session_server_port(srv), 8443);
+  EXPECT_EQ(dn.calls, 0);
+  odin_connect_session_destroy(srv);
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -5,6 +5,8 @@
 
 #if defined(ODIN_DIAL_TESTING)
 
+#include <stdint.h>
+
 #include "odin/dial.h"
 
 #ifdef __cplusplus
@@ -18,6 +20,14 @@ extern "C" {
  */
 int odin_dial_test_fd(odin_dial_t *dial);
 
+/* Pins the TFO cache clock to ms (monotonic milliseconds); 0 restores the real
+ * clock. Process-wide. */
+void odin_dial_test_set_now_ms(uint64_t ms);
+
+/* Makes the next TFO attempt complete with err as its SO_ERROR, as if a
+ * middlebox had dropped or reset the SYN. Process-wide, one-shot. */
+void odin_dial_test_fail_next_tfo(int err);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,9 @@
 // odin/testing/dial_unittests.cpp
 //
-// Unit tests T1-T7 from §6 of odin/docs/rfc_012_nonblocking_socket_dial.md.
+// Unit tests T1-T7 from §6 of odin/docs/rfc_012_nonblocking_socket_dial.md,
+// plus T7 from §5 of odin/docs/rfc_033_single_allocation_server_session.md,
+// T1-T4 from §5 of odin/docs/rfc_036_tcp_fast_open_dial.md, and T1-T4 from §5
+// of odin/docs/rfc_037_egress_source_pool.md.
 //
 // Each row runs the event loop, so every row executes under the same fork +
 // waitpid 2 s deadline fixture RFC-010 §6 established (replicated below as
@@ -19,6 +22,8 @@
 #include <cstring>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -77,6 +82,8 @@ struct DialState {
   odin_dial_status_t status = ODIN_DIAL_OK;
   int err = 0;
   int fd = -2;
+  size_t early_sent = 0;
+  int source = -1;
   bool timed_out = false;
   bool destroy_in_cb = false;
   odin_event_loop_t *loop = nullptr;
@@ -91,6 +98,10 @@ void OnDial(odin_dial_t *dial, odin_dial_status_t status, int fd, int err,
   s->err = err;
   s->fd = fd;
   s->calls += 1;
+  if (status == ODIN_DIAL_OK) {
+    s->early_sent = odin_dial_early_sent(dial);
+    s->source = odin_dial_source(dial);
+  }
   if (s->destroy_in_cb) {
     odin_dial_destroy(dial);
   }
@@ -173,6 +184,83 @@ void T6DestroyCb(odin_event_loop_t *loop, odin_event_timer_t *timer,
   odin_event_timer_stop(timer);
 }
 
+// Whether this kernel lets a client socket opt into TCP_FASTOPEN_CONNECT.
+bool KernelAllowsTfoConnect() {
+#if defined(TCP_FASTOPEN_CONNECT)
+  const int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0) {
+    return false;
+  }
+  const int one = 1;
+  const bool ok = setsockopt(s, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one,
+                             sizeof(one)) == 0;
+  close(s);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+// Runs one odin_dial_start_opts_in to completion and returns its state.
+DialState RunOptsDial(odin_event_loop_t *loop, odin_dial_storage_t *storage,
+                      const struct sockaddr *addr, socklen_t addrlen,
+                      const odin_dial_opts_t *opts) {
+  DialState state;
+  state.loop = loop;
+  state.destroy_in_cb = true;
+  odin_event_timer_t *watchdog = nullptr;
+  EXPECT_EQ(
+      odin_event_timer_start(loop, 100000, 0, WatchdogCb, &state, &watchdog),
+      0);
+  odin_dial_t *d = nullptr;
+  EXPECT_EQ(odin_dial_start_opts_in(storage, loop, addr, addrlen, opts, OnDial,
+                                    &state, &d),
+            0)
+      << std::strerror(errno);
+  EXPECT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+  if (!state.timed_out) {
+    odin_event_timer_stop(watchdog);
+  }
+  return state;
+}
+
+DialState RunTfoDial(odin_event_loop_t *loop, odin_dial_storage_t *storage,
+                     const struct sockaddr *addr, socklen_t addrlen,
+                     odin_dial_tfo_cache_t *cache, const char *data,
+                     size_t len) {
+  const odin_dial_opts_t opts = {cache, data, len, nullptr};
+  return RunOptsDial(loop, storage, addr, addrlen, &opts);
+}
+
+// An IPv4 source pool entry for a dotted-quad address.
+struct sockaddr_storage Source4(const char *ip) {
+  struct sockaddr_storage ss;
+  std::memset(&ss, 0, sizeof(ss));
+  auto *sin = reinterpret_cast<struct sockaddr_in *>(&ss);
+  sin->sin_family = AF_INET;
+  EXPECT_EQ(inet_pton(AF_INET, ip, &sin->sin_addr), 1);
+  return ss;
+}
+
+// The dotted-quad local address a connected IPv4 socket is bound to.
+std::string LocalIp(int fd) {
+  struct sockaddr_in addr;
+  socklen_t alen = sizeof(addr);
+  if (getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &alen) != 0) {
+    return "";
+  }
+  char buf[INET_ADDRSTRLEN];
+  return inet_ntop(AF_INET, &addr.sin_addr, buf, sizeof(buf));
+}
+
+odin_dial_source_stats_t SourceStats(const odin_dial_source_pool_t *pool,
+                                     size_t index) {
+  odin_dial_source_stats_t st;
+  std::memset(&st, 0, sizeof(st));
+  EXPECT_EQ(odin_dial_source_pool_stats(pool, index, &st), 0);
+  return st;
+}
+
 } // namespace
 
 // T1 — Loopback TCP dial succeeds; connected fd handed to caller, ownership
@@ -498,4 +586,444 @@ TEST(OdinDialTest, T7) {
   });
 }
 
+// RFC-033 T7 — odin_dial_start_in connects from caller storage; destroying
+// from on_done leaves the storage free for the next dial.
+TEST(OdinDialStorageTest, T7StartInStorageIsReusable) {
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_dial_storage_t storage;
+
+    for (int round = 0; round < 2; ++round) {
+      DialState state;
+      state.loop = loop;
+      state.destroy_in_cb = true;
+      odin_event_timer_t *watchdog = nullptr;
+      ASSERT_EQ(odin_event_timer_start(loop, 100000, 0, WatchdogCb, &state,
+                                       &watchdog),
+                0);
+
+      odin_dial_t *d = nullptr;
+      ASSERT_EQ(odin_dial_start_in(&storage, loop,
+                                   reinterpret_cast<struct sockaddr *>(&addr),
+                                   sizeof(addr), OnDial, &state, &d),
+                0)
+          << std::strerror(errno);
+      EXPECT_EQ(static_cast<void *>(d), static_cast<void *>(&storage));
+      EXPECT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+      odin_event_timer_stop(watchdog);
+
+      ASSERT_EQ(state.calls, 1);
+      EXPECT_EQ(state.status, ODIN_DIAL_OK);
+      EXPECT_FALSE(state.timed_out);
+      const int srv = accept(lfd, nullptr, nullptr);
+      ASSERT_GE(srv, 0) << std::strerror(errno);
+      EXPECT_EQ(close(state.fd), 0);
+      EXPECT_EQ(close(srv), 0);
+    }
+
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+#if defined(ODIN_DIAL_TESTING)
+// RFC-036 T1 — a TFO dial delivers the early data exactly once: whatever the
+// SYN carried plus what the caller writes after OK.
+TEST(OdinDialTfoTest, T1EarlyDataArrivesOnce) {
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    const int qlen = 8;
+    (void)setsockopt(lfd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen));
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_dial_tfo_cache_t *cache = nullptr;
+    ASSERT_EQ(odin_dial_tfo_cache_create(&cache), 0);
+    odin_dial_storage_t storage;
+
+    static const char kHello[] = "client-hello";
+    const size_t len = sizeof(kHello) - 1;
+    DialState state =
+        RunTfoDial(loop, &storage, reinterpret_cast<struct sockaddr *>(&addr),
+                   sizeof(addr), cache, kHello, len);
+    ASSERT_EQ(state.calls, 1);
+    ASSERT_EQ(state.status, ODIN_DIAL_OK);
+    ASSERT_LE(state.early_sent, len);
+    const size_t rest = len - state.early_sent;
+    ASSERT_EQ(write(state.fd, kHello + state.early_sent, rest),
+              static_cast<ssize_t>(rest));
+
+    const int srv = accept(lfd, nullptr, nullptr);
+    ASSERT_GE(srv, 0) << std::strerror(errno);
+    char buf[32];
+    size_t got = 0;
+    while (got < len) {
+      const ssize_t n = read(srv, buf + got, sizeof(buf) - got);
+      ASSERT_GT(n, 0) << std::strerror(errno);
+      got += static_cast<size_t>(n);
+    }
+    EXPECT_EQ(std::string(buf, got), kHello);
+
+    EXPECT_EQ(close(state.fd), 0);
+    EXPECT_EQ(close(srv), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_dial_tfo_cache_destroy(cache);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-036 T2 — a TFO attempt that times out is recorded and redialed without
+// TFO; on_done sees only the plain dial's OK.
+TEST(OdinDialTfoTest, T2DroppedTfoFallsBackToPlainDial) {
+  if (!KernelAllowsTfoConnect()) {
+    GTEST_SKIP() << "TCP_FASTOPEN_CONNECT unavailable";
+  }
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    ASSERT_EQ(listen(lfd, 4), 0);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_dial_tfo_cache_t *cache = nullptr;
+    ASSERT_EQ(odin_dial_tfo_cache_create(&cache), 0);
+    odin_dial_storage_t storage;
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+
+    odin_dial_test_fail_next_tfo(ETIMEDOUT);
+    DialState state =
+        RunTfoDial(loop, &storage, sa, sizeof(addr), cache, "x", 1);
+    odin_dial_test_fail_next_tfo(0);
+    ASSERT_EQ(state.calls, 1);
+    EXPECT_EQ(state.status, ODIN_DIAL_OK);
+    EXPECT_EQ(state.err, 0);
+    EXPECT_EQ(state.early_sent, 0u);
+    EXPECT_FALSE(state.timed_out);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 0);
+
+    EXPECT_EQ(close(state.fd), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_dial_tfo_cache_destroy(cache);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-036 T3 — backoff starts at ODIN_DIAL_TFO_BACKOFF_MS and doubles per
+// consecutive failure; a destination in backoff is dialed without TFO.
+TEST(OdinDialTfoTest, T3BackoffDoublesPerFailure) {
+  if (!KernelAllowsTfoConnect()) {
+    GTEST_SKIP() << "TCP_FASTOPEN_CONNECT unavailable";
+  }
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    ASSERT_EQ(listen(lfd, 8), 0);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_dial_tfo_cache_t *cache = nullptr;
+    ASSERT_EQ(odin_dial_tfo_cache_create(&cache), 0);
+    odin_dial_storage_t storage;
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+    const uint64_t t0 = 1000000;
+    const uint64_t base = ODIN_DIAL_TFO_BACKOFF_MS;
+
+    odin_dial_test_set_now_ms(t0);
+    odin_dial_test_fail_next_tfo(ECONNRESET);
+    DialState state =
+        RunTfoDial(loop, &storage, sa, sizeof(addr), cache, "x", 1);
+    EXPECT_EQ(state.status, ODIN_DIAL_OK);
+    EXPECT_EQ(close(state.fd), 0);
+
+    // In backoff: the dial skips TFO, so the armed failure is not consumed
+    // until the backoff has expired.
+    odin_dial_test_fail_next_tfo(ECONNRESET);
+    odin_dial_test_set_now_ms(t0 + base - 1);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 0);
+    state = RunTfoDial(loop, &storage, sa, sizeof(addr), cache, "x", 1);
+    EXPECT_EQ(state.status, ODIN_DIAL_OK);
+    EXPECT_EQ(close(state.fd), 0);
+
+    odin_dial_test_set_now_ms(t0 + base);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 1);
+    state = RunTfoDial(loop, &storage, sa, sizeof(addr), cache, "x", 1);
+    EXPECT_EQ(state.status, ODIN_DIAL_OK);
+    EXPECT_EQ(close(state.fd), 0);
+
+    odin_dial_test_set_now_ms(t0 + base + 2 * base - 1);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 0);
+    odin_dial_test_set_now_ms(t0 + base + 2 * base);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 1);
+
+    odin_dial_test_fail_next_tfo(0);
+    odin_dial_test_set_now_ms(0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_dial_tfo_cache_destroy(cache);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-036 T4 — non-IP destinations never use TFO: an AF_UNIX dial with a
+// cache and early data is a plain dial that leaves the data to the caller.
+TEST(OdinDialTfoTest, T4UnixDestinationSkipsTfo) {
+  DialRunDeadline::Run([] {
+    char path[108];
+    MakeUnixPath(path, sizeof(path), "tfo");
+    (void)unlink(path);
+    const int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(lfd, 0) << std::strerror(errno);
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path, std::strlen(path) + 1);
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+    ASSERT_EQ(bind(lfd, sa, sizeof(addr)), 0) << std::strerror(errno);
+    ASSERT_EQ(listen(lfd, 1), 0) << std::strerror(errno);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_dial_tfo_cache_t *cache = nullptr;
+    ASSERT_EQ(odin_dial_tfo_cache_create(&cache), 0);
+    odin_dial_storage_t storage;
+
+    odin_dial_test_fail_next_tfo(ETIMEDOUT); // must stay unconsumed
+    DialState state =
+        RunTfoDial(loop, &storage, sa, sizeof(addr), cache, "hi", 2);
+    odin_dial_test_fail_next_tfo(0);
+    ASSERT_EQ(state.calls, 1);
+    EXPECT_EQ(state.status, ODIN_DIAL_OK);
+    EXPECT_EQ(state.early_sent, 0u);
+    EXPECT_EQ(odin_dial_tfo_cache_allows(cache, sa, sizeof(addr)), 0);
+
+    EXPECT_EQ(close(state.fd), 0);
+    EXPECT_EQ(close(lfd), 0);
+    (void)unlink(path);
+    odin_dial_tfo_cache_destroy(cache);
+    odin_event_loop_destroy(loop);
+  });
+}
+#endif
+
+// RFC-037 T1 — round-robin binds successive dials to successive sources and
+// counts each socket as live until the caller releases it.
+TEST(OdinDialSourceTest, T1RoundRobinAlternatesSources) {
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    const struct sockaddr_storage srcs[2] = {Source4("127.0.0.1"),
+                                             Source4("127.0.0.2")};
+    odin_dial_source_pool_t *pool = nullptr;
+    ASSERT_EQ(odin_dial_source_pool_create(srcs, 2,
+                                           ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+              0);
+    const odin_dial_opts_t opts = {nullptr, nullptr, 0, pool};
+    odin_dial_storage_t storage;
+
+    static const char *const kWant[4] = {"127.0.0.1", "127.0.0.2", "127.0.0.1",
+                                         "127.0.0.2"};
+    int fds[4];
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+    for (int i = 0; i < 4; ++i) {
+      DialState state = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+      ASSERT_EQ(state.status, ODIN_DIAL_OK) << std::strerror(state.err);
+      EXPECT_EQ(state.source, i % 2);
+      EXPECT_EQ(LocalIp(state.fd), kWant[i]);
+      fds[i] = state.fd;
+      const int srv = accept(lfd, nullptr, nullptr); // keep the backlog clear
+      ASSERT_GE(srv, 0) << std::strerror(errno);
+      EXPECT_EQ(close(srv), 0);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      const odin_dial_source_stats_t st = SourceStats(pool, i);
+      EXPECT_EQ(st.dials, 2u);
+      EXPECT_EQ(st.live, 2u);
+      EXPECT_EQ(st.exhausted, 0u);
+    }
+    char line[64];
+    EXPECT_EQ(odin_dial_source_pool_stats_format(pool, line, sizeof(line)),
+              15u);
+    EXPECT_EQ(std::string(line), "src=2/0/2,2/0/2");
+    char small[12];
+    EXPECT_EQ(odin_dial_source_pool_stats_format(pool, small, sizeof(small)),
+              15u);
+    EXPECT_EQ(std::string(small), "src=2/0/2,2");
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(close(fds[i]), 0);
+      odin_dial_source_pool_release(pool, i % 2);
+    }
+    EXPECT_EQ(SourceStats(pool, 0).live, 0u);
+    EXPECT_EQ(SourceStats(pool, 1).live, 0u);
+
+    odin_dial_source_pool_destroy(pool);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-037 T2 — least-used picks the source with the fewest live sockets.
+TEST(OdinDialSourceTest, T2LeastUsedPrefersIdleSource) {
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    const struct sockaddr_storage srcs[2] = {Source4("127.0.0.1"),
+                                             Source4("127.0.0.2")};
+    odin_dial_source_pool_t *pool = nullptr;
+    ASSERT_EQ(odin_dial_source_pool_create(srcs, 2, ODIN_DIAL_SOURCE_LEAST_USED,
+                                           &pool),
+              0);
+    const odin_dial_opts_t opts = {nullptr, nullptr, 0, pool};
+    odin_dial_storage_t storage;
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+
+    DialState a = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+    ASSERT_EQ(a.status, ODIN_DIAL_OK);
+    DialState b = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+    ASSERT_EQ(b.status, ODIN_DIAL_OK);
+    for (int i = 0; i < 2; ++i) { // keep the backlog clear
+      const int srv = accept(lfd, nullptr, nullptr);
+      ASSERT_GE(srv, 0) << std::strerror(errno);
+      EXPECT_EQ(close(srv), 0);
+    }
+    EXPECT_NE(a.source, b.source);
+    EXPECT_EQ(close(a.fd), 0);
+    odin_dial_source_pool_release(pool, a.source);
+    DialState c = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+    ASSERT_EQ(c.status, ODIN_DIAL_OK);
+    EXPECT_EQ(c.source, a.source);
+    EXPECT_EQ(SourceStats(pool, static_cast<size_t>(a.source)).live, 1u);
+    EXPECT_EQ(SourceStats(pool, static_cast<size_t>(b.source)).live, 1u);
+
+    EXPECT_EQ(close(b.fd), 0);
+    EXPECT_EQ(close(c.fd), 0);
+    odin_dial_source_pool_destroy(pool);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-037 T3 — a source that cannot be bound is counted as exhausted and the
+// next one used; with none left the dial fails with EADDRNOTAVAIL.
+TEST(OdinDialSourceTest, T3UnusableSourceFailsOver) {
+  DialRunDeadline::Run([] {
+    int lfd = -1;
+    struct sockaddr_in addr;
+    MakeTcpListener(&lfd, &addr);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    // 192.0.2.1 (TEST-NET-1) is not a local address, so bind(2) refuses it.
+    const struct sockaddr_storage srcs[2] = {Source4("192.0.2.1"),
+                                             Source4("127.0.0.1")};
+    odin_dial_source_pool_t *pool = nullptr;
+    ASSERT_EQ(odin_dial_source_pool_create(srcs, 2,
+                                           ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+              0);
+    const odin_dial_opts_t opts = {nullptr, nullptr, 0, pool};
+    odin_dial_storage_t storage;
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+
+    DialState ok = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+    ASSERT_EQ(ok.status, ODIN_DIAL_OK) << std::strerror(ok.err);
+    EXPECT_EQ(ok.source, 1);
+    const odin_dial_source_stats_t bad = SourceStats(pool, 0);
+    EXPECT_EQ(bad.exhausted, 1u);
+    EXPECT_EQ(bad.live, 0u);
+    EXPECT_EQ(SourceStats(pool, 1).live, 1u);
+    EXPECT_EQ(close(ok.fd), 0);
+    odin_dial_source_pool_release(pool, ok.source);
+    odin_dial_source_pool_destroy(pool);
+
+    ASSERT_EQ(odin_dial_source_pool_create(srcs, 1,
+                                           ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+              0);
+    const odin_dial_opts_t only_bad = {nullptr, nullptr, 0, pool};
+    DialState fail = RunOptsDial(loop, &storage, sa, sizeof(addr), &only_bad);
+    EXPECT_EQ(fail.calls, 1);
+    EXPECT_EQ(fail.status, ODIN_DIAL_ERROR);
+    EXPECT_EQ(fail.err, EADDRNOTAVAIL);
+    EXPECT_EQ(fail.fd, -1);
+    EXPECT_EQ(SourceStats(pool, 0).live, 0u);
+
+    odin_dial_source_pool_destroy(pool);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-037 T4 — create validates its arguments, and a destination family the
+// pool has no source for dials from the kernel-chosen address.
+TEST(OdinDialSourceTest, T4ValidationAndFamilyMismatch) {
+  const struct sockaddr_storage v4 = Source4("127.0.0.1");
+  struct sockaddr_storage srcs[ODIN_DIAL_SOURCE_POOL_MAX + 1];
+  for (size_t i = 0; i <= ODIN_DIAL_SOURCE_POOL_MAX; ++i) {
+    srcs[i] = v4;
+  }
+  odin_dial_source_pool_t *pool = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_dial_source_pool_create(srcs, 0, ODIN_DIAL_SOURCE_ROUND_ROBIN,
+                                         &pool),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  errno = 0;
+  EXPECT_EQ(odin_dial_source_pool_create(srcs, ODIN_DIAL_SOURCE_POOL_MAX + 1,
+                                         ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  struct sockaddr_storage unix_src;
+  std::memset(&unix_src, 0, sizeof(unix_src));
+  unix_src.ss_family = AF_UNIX;
+  errno = 0;
+  EXPECT_EQ(odin_dial_source_pool_create(&unix_src, 1,
+                                         ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(pool, nullptr);
+
+  DialRunDeadline::Run([] {
+    char path[108];
+    MakeUnixPath(path, sizeof(path), "src");
+    (void)unlink(path);
+    const int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(lfd, 0) << std::strerror(errno);
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path, std::strlen(path) + 1);
+    const auto *sa = reinterpret_cast<struct sockaddr *>(&addr);
+    ASSERT_EQ(bind(lfd, sa, sizeof(addr)), 0) << std::strerror(errno);
+    ASSERT_EQ(listen(lfd, 1), 0) << std::strerror(errno);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    const struct sockaddr_storage src = Source4("127.0.0.1");
+    odin_dial_source_pool_t *v4_pool = nullptr;
+    ASSERT_EQ(odin_dial_source_pool_create(&src, 1, ODIN_DIAL_SOURCE_LEAST_USED,
+                                           &v4_pool),
+              0);
+    const odin_dial_opts_t opts = {nullptr, nullptr, 0, v4_pool};
+    odin_dial_storage_t storage;
+
+    DialState state = RunOptsDial(loop, &storage, sa, sizeof(addr), &opts);
+    ASSERT_EQ(state.status, ODIN_DIAL_OK) << std::strerror(state.err);
+    EXPECT_EQ(state.source, -1);
+    EXPECT_EQ(SourceStats(v4_pool, 0).dials, 0u);
+    odin_dial_source_pool_release(v4_pool, state.source); // no-op for -1
+    EXPECT_EQ(SourceStats(v4_pool, 0).live, 0u);
+
+    EXPECT_EQ(close(state.fd), 0);
+    EXPECT_EQ(close(lfd), 0);
+    (void)unlink(path);
+    odin_dial_source_pool_destroy(v4_pool);
+    odin_event_loop_destroy(loop);
+  });
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
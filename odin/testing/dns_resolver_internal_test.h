@@ -72,6 +72,10 @@ int odin_dns_resolver_test_push_cares_step(
 int odin_dns_resolver_test_push_addr_result(const odin_dns_addr_t *addrs,
                                             size_t addr_count);
 int odin_dns_resolver_test_fail_next_result_alloc(void);
+/* RFC-044: pins the cache clock (0 restores CLOCK_MONOTONIC) and runs one
+ * refresh sweep without waiting for the sweep timer. */
+void odin_dns_resolver_test_set_now_ms(uint64_t ms);
+int odin_dns_resolver_test_refresh_sweep(odin_dns_resolver_t *resolver);
 int odin_dns_resolver_test_first_watch(odin_dns_query_t *query,
                                        odin_event_io_t **out_io, int *out_fd);
 
@@ -1,6 +1,8 @@
 // odin/testing/dns_resolver_unittests.cpp
 //
-// Unit tests T1-T20 from §5 of odin/docs/rfc_030_async_dns_resolver.md.
+// Unit tests T1-T20 from §5 of odin/docs/rfc_030_async_dns_resolver.md, the
+// streaming tests T1-T6 from §5 of odin/docs/rfc_043_streaming_dns.md, and the
+// cache tests T1-T6 and T8 from §5 of odin/docs/rfc_044_dns_refresh_ahead.md.
 
 #include "odin/dns_resolver.h"
 
@@ -948,8 +950,10 @@ TEST(OdinDnsResolverTest, T3) {
 
       odin_dns_resolver_test_cares_observation_t obs;
       ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
-      EXPECT_EQ(obs.getaddrinfo_calls, static_cast<size_t>(1));
-      EXPECT_EQ(obs.last_ai_family, family);
+      // AF_UNSPEC runs as one lookup per family, AAAA started last.
+      EXPECT_EQ(obs.getaddrinfo_calls,
+                static_cast<size_t>(family == AF_UNSPEC ? 2 : 1));
+      EXPECT_EQ(obs.last_ai_family, family == AF_UNSPEC ? AF_INET6 : family);
       EXPECT_TRUE((obs.last_ai_flags & ARES_AI_NUMERICSERV) != 0);
       EXPECT_TRUE((obs.last_ai_flags & ARES_AI_NOSORT) != 0);
 
@@ -1881,6 +1885,765 @@ TEST(OdinDnsResolverTest, T20) {
   AssertParentCaresInitUnchanged();
 }
 
+namespace {
+
+// RFC-043 streaming helpers.
+
+struct StreamPartial {
+  int family = AF_UNSPEC;
+  odin_dns_status_t status = ODIN_DNS_OK;
+  int err = 0;
+  std::vector<odin_dns_addr_t> addrs;
+};
+
+struct StreamState {
+  odin_dns_stream_t *stream = nullptr;
+  odin_event_loop_t *loop = nullptr;
+  std::vector<StreamPartial> partials;
+  int done_calls = 0;
+  odin_dns_status_t done_status = ODIN_DNS_OK;
+  int done_err = 0;
+  bool done_after_partials = false;
+  bool destroy_in_partial = false;
+  size_t stop_after = 0;
+};
+
+void StopStreamIfDone(StreamState *state) {
+  const size_t events =
+      state->partials.size() + static_cast<size_t>(state->done_calls);
+  if (state->loop != nullptr && events >= state->stop_after) {
+    odin_event_loop_stop(state->loop);
+  }
+}
+
+void OnStreamPartial(odin_dns_stream_t *stream, int family,
+                     odin_dns_status_t status, int err,
+                     const odin_dns_addr_t *addrs, size_t addr_count,
+                     void *user_data) {
+  StreamState *state = static_cast<StreamState *>(user_data);
+  EXPECT_EQ(stream, state->stream);
+  StreamPartial partial;
+  partial.family = family;
+  partial.status = status;
+  partial.err = err;
+  if (addrs != nullptr) {
+    partial.addrs.assign(addrs, addrs + addr_count);
+  }
+  state->partials.push_back(partial);
+  if (state->destroy_in_partial) {
+    odin_dns_stream_destroy(stream);
+    state->stream = nullptr;
+  }
+  StopStreamIfDone(state);
+}
+
+void OnStreamDone(odin_dns_stream_t *stream, odin_dns_status_t status, int err,
+                  void *user_data) {
+  StreamState *state = static_cast<StreamState *>(user_data);
+  EXPECT_EQ(stream, state->stream);
+  state->done_calls += 1;
+  state->done_status = status;
+  state->done_err = err;
+  state->done_after_partials = state->partials.size() == 2;
+  StopStreamIfDone(state);
+}
+
+// Runs until stop_after callbacks have fired, or for a short window when
+// expect_idle is set, in which case nothing more may arrive.
+void RunStream(odin_event_loop_t *loop, StreamState *state, size_t stop_after,
+               bool expect_idle = false) {
+  bool timed_out = false;
+  odin_event_timer_t *watchdog = nullptr;
+  ASSERT_EQ(odin_event_timer_start(loop, expect_idle ? 20000 : 1500000, 0,
+                                   WatchdogCb, &timed_out, &watchdog),
+            0)
+      << std::strerror(errno);
+  state->loop = loop;
+  state->stop_after = stop_after;
+  ASSERT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+  if (!timed_out) {
+    odin_event_timer_stop(watchdog);
+  }
+  EXPECT_EQ(timed_out, expect_idle);
+}
+
+odin_dns_addr_t StreamAddr(int family, const char *literal, uint16_t port) {
+  odin_dns_addr_t addr = {};
+  if (family == AF_INET) {
+    sockaddr_in *sin = reinterpret_cast<sockaddr_in *>(&addr.addr);
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(port);
+    EXPECT_EQ(inet_pton(AF_INET, literal, &sin->sin_addr), 1);
+    addr.addrlen = sizeof(sockaddr_in);
+  } else {
+    sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6 *>(&addr.addr);
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons(port);
+    EXPECT_EQ(inet_pton(AF_INET6, literal, &sin6->sin6_addr), 1);
+    addr.addrlen = sizeof(sockaddr_in6);
+  }
+  addr.ttl = 30;
+  return addr;
+}
+
+void PushStreamAddr(int family, const char *literal, uint16_t port) {
+  const odin_dns_addr_t addr = StreamAddr(family, literal, port);
+  ASSERT_EQ(odin_dns_resolver_test_push_addr_result(&addr, 1), 0)
+      << std::strerror(errno);
+}
+
+void StartStream(odin_dns_resolver_t *resolver, StreamState *state) {
+  ASSERT_EQ(odin_dns_resolve_stream_start(resolver, "stream.test", 11, 443,
+                                          OnStreamPartial, OnStreamDone, state,
+                                          &state->stream),
+            0)
+      << std::strerror(errno);
+  EXPECT_TRUE(state->partials.empty());
+  EXPECT_EQ(state->done_calls, 0);
+}
+
+} // namespace
+
+// RFC-043 T1: the A answer is delivered while AAAA is still outstanding, and
+// destroying the stream then releases the pending family.
+TEST(OdinDnsStreamTest, T1PartialBeforeSlowFamily) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    PushStreamAddr(AF_INET, "192.0.2.10", 443);
+    PushStep(ODIN_DNS_TEST_CARES_RESULT_PENDING);
+
+    StreamState state;
+    StartStream(resolver, &state);
+    odin_dns_resolver_test_cares_observation_t obs;
+    ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
+    EXPECT_EQ(obs.getaddrinfo_calls, static_cast<size_t>(2));
+    EXPECT_EQ(obs.last_ai_family, AF_INET6);
+
+    RunStream(loop, &state, 1);
+    ASSERT_EQ(state.partials.size(), static_cast<size_t>(1));
+    EXPECT_EQ(state.partials[0].family, AF_INET);
+    EXPECT_EQ(state.partials[0].status, ODIN_DNS_OK);
+    ASSERT_EQ(state.partials[0].addrs.size(), static_cast<size_t>(1));
+    EXPECT_EQ(state.partials[0].addrs[0].addr.ss_family, AF_INET);
+
+    RunStream(loop, &state, 2, true);
+    EXPECT_EQ(state.partials.size(), static_cast<size_t>(1));
+    EXPECT_EQ(state.done_calls, 0);
+
+    odin_dns_stream_destroy(state.stream);
+    ExpectNoLiveQueryResources();
+    odin_dns_stream_destroy(nullptr);
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-043 T2: both families answer, then the stream completes once with OK.
+TEST(OdinDnsStreamTest, T2BothFamiliesThenDone) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    PushStreamAddr(AF_INET, "192.0.2.10", 443);
+    PushStreamAddr(AF_INET6, "2001:db8::10", 443);
+
+    StreamState state;
+    StartStream(resolver, &state);
+    RunStream(loop, &state, 3);
+    ASSERT_EQ(state.partials.size(), static_cast<size_t>(2));
+    EXPECT_NE(state.partials[0].family, state.partials[1].family);
+    for (const StreamPartial &partial : state.partials) {
+      EXPECT_EQ(partial.status, ODIN_DNS_OK);
+      ASSERT_EQ(partial.addrs.size(), static_cast<size_t>(1));
+      EXPECT_EQ(partial.addrs[0].addr.ss_family, partial.family);
+    }
+    EXPECT_EQ(state.done_calls, 1);
+    EXPECT_TRUE(state.done_after_partials);
+    EXPECT_EQ(state.done_status, ODIN_DNS_OK);
+    EXPECT_EQ(state.done_err, 0);
+    ExpectNoLiveQueryResources();
+
+    odin_dns_stream_destroy(state.stream);
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-043 T3: a stream with no usable family fails with the first family's
+// errno, and empty answers on both sides fail with EHOSTUNREACH.
+TEST(OdinDnsStreamTest, T3NoUsableFamily) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    PushResultStatus(ARES_ETIMEOUT);
+    PushResultStatus(ARES_ENOTFOUND);
+
+    StreamState failed;
+    StartStream(resolver, &failed);
+    RunStream(loop, &failed, 3);
+    ASSERT_EQ(failed.partials.size(), static_cast<size_t>(2));
+    EXPECT_EQ(failed.partials[0].status, ODIN_DNS_ERROR);
+    EXPECT_EQ(failed.partials[1].status, ODIN_DNS_ERROR);
+    EXPECT_EQ(failed.done_calls, 1);
+    EXPECT_EQ(failed.done_status, ODIN_DNS_ERROR);
+    EXPECT_EQ(failed.done_err, failed.partials[0].err);
+    odin_dns_stream_destroy(failed.stream);
+
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(nullptr, 0), 0);
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(nullptr, 0), 0);
+    StreamState empty;
+    StartStream(resolver, &empty);
+    RunStream(loop, &empty, 3);
+    ASSERT_EQ(empty.partials.size(), static_cast<size_t>(2));
+    EXPECT_EQ(empty.partials[0].status, ODIN_DNS_OK);
+    EXPECT_TRUE(empty.partials[0].addrs.empty());
+    EXPECT_EQ(empty.done_status, ODIN_DNS_ERROR);
+    EXPECT_EQ(empty.done_err, EHOSTUNREACH);
+    odin_dns_stream_destroy(empty.stream);
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-043 T4: argument checks, and destroying the stream from its first
+// partial suppresses the rest.
+TEST(OdinDnsStreamTest, T4ArgumentsAndDestroyFromPartial) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+
+    StreamState state;
+    odin_dns_stream_t *sentinel = reinterpret_cast<odin_dns_stream_t *>(0x1);
+    EXPECT_EQ(odin_dns_resolve_stream_start(resolver, "a.test", 6, 80, nullptr,
+                                            OnStreamDone, &state, &sentinel),
+              -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(odin_dns_resolve_stream_start(resolver, "a.test", 6, 80,
+                                            OnStreamPartial, nullptr, &state,
+                                            &sentinel),
+              -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(odin_dns_resolve_stream_start(resolver, "a.test", 0, 80,
+                                            OnStreamPartial, OnStreamDone,
+                                            &state, &sentinel),
+              -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(odin_dns_resolve_stream_start(nullptr, "a.test", 6, 80,
+                                            OnStreamPartial, OnStreamDone,
+                                            &state, &sentinel),
+              -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(sentinel, reinterpret_cast<odin_dns_stream_t *>(0x1));
+    ExpectNoLiveQueryResources();
+
+    PushStreamAddr(AF_INET, "192.0.2.10", 443);
+    PushStreamAddr(AF_INET6, "2001:db8::10", 443);
+    state.destroy_in_partial = true;
+    StartStream(resolver, &state);
+    RunStream(loop, &state, 1);
+    RunStream(loop, &state, 2, true);
+    EXPECT_EQ(state.partials.size(), static_cast<size_t>(1));
+    EXPECT_EQ(state.done_calls, 0);
+    EXPECT_EQ(state.stream, nullptr);
+    ExpectNoLiveQueryResources();
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-043 T5: a numeric host asks only its own family, so a literal costs
+// one lookup and the stream ends after a single partial.
+TEST(OdinDnsStreamTest, T5NumericHostAsksOneFamily) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    struct Case {
+      const char *name;
+      int family;
+      const char *literal;
+    };
+    for (const Case &c : {Case{"192.0.2.10", AF_INET, "192.0.2.10"},
+                          Case{"2001:db8::10", AF_INET6, "2001:db8::10"}}) {
+      odin_dns_resolver_test_cares_observation_t obs0;
+      ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs0), 0);
+      PushStreamAddr(c.family, c.literal, 443);
+      StreamState state;
+      ASSERT_EQ(odin_dns_resolve_stream_start(
+                    resolver, c.name, std::strlen(c.name), 443,
+                    OnStreamPartial, OnStreamDone, &state, &state.stream),
+                0)
+          << std::strerror(errno);
+      odin_dns_resolver_test_cares_observation_t obs;
+      ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
+      EXPECT_EQ(obs.getaddrinfo_calls, obs0.getaddrinfo_calls + 1);
+      EXPECT_EQ(obs.last_ai_family, c.family);
+
+      RunStream(loop, &state, 2);
+      ASSERT_EQ(state.partials.size(), static_cast<size_t>(1));
+      EXPECT_EQ(state.partials[0].family, c.family);
+      EXPECT_EQ(state.done_calls, 1);
+      EXPECT_EQ(state.done_status, ODIN_DNS_OK);
+      odin_dns_stream_destroy(state.stream);
+      ExpectNoLiveQueryResources();
+    }
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-043 T6: an AF_UNSPEC one-shot runs on the stream. One callback carries
+// both families; a pending family holds it back; destroying the query, or
+// the resolver under it, frees both lookups.
+TEST(OdinDnsStreamTest, T6UnspecOneShotRidesTheStream) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    const odin_dns_addr_t both[2] = {
+        StreamAddr(AF_INET, "192.0.2.10", 443),
+        StreamAddr(AF_INET6, "2001:db8::10", 443)};
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(both, 2), 0);
+    CallbackState cb;
+    odin_dns_query_t *query =
+        StartFixtureQuery(resolver, "stream.test", 443, AF_UNSPEC, &cb);
+    ASSERT_NE(query, nullptr);
+    odin_dns_resolver_test_cares_observation_t obs;
+    ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
+    EXPECT_EQ(obs.getaddrinfo_calls, static_cast<size_t>(2));
+    EXPECT_EQ(obs.last_ai_family, AF_INET6);
+    RunLoopUntil(loop, &cb, 1);
+    ASSERT_EQ(cb.records.size(), static_cast<size_t>(1));
+    EXPECT_TRUE(cb.records[0].start_returned);
+    EXPECT_EQ(cb.records[0].query, query);
+    EXPECT_EQ(cb.records[0].status, ODIN_DNS_OK);
+    ExpectAddressCount(cb.records[0], 2);
+    EXPECT_TRUE(HasFamily(cb.records[0], AF_INET));
+    EXPECT_TRUE(HasFamily(cb.records[0], AF_INET6));
+    odin_dns_query_destroy(query);
+    ExpectNoLiveQueryResources();
+
+    PushStep(ODIN_DNS_TEST_CARES_RESULT_PENDING);
+    CallbackState pending;
+    query = StartFixtureQuery(resolver, "stream.test", 443, AF_UNSPEC,
+                              &pending);
+    RunShortLoopExpectNoCallback(loop, &pending);
+    odin_dns_query_destroy(query);
+    ExpectNoLiveQueryResources();
+
+    PushStep(ODIN_DNS_TEST_CARES_RESULT_PENDING);
+    CallbackState orphan;
+    (void)StartFixtureQuery(resolver, "stream.test", 443, AF_UNSPEC, &orphan);
+    odin_dns_resolver_destroy(resolver);
+    EXPECT_EQ(orphan.calls, 0);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+namespace {
+
+// RFC-044 cache helpers.
+
+constexpr uint64_t kCacheNow = 1000000u;
+
+CapturedCallback ResolveOnce(odin_event_loop_t *loop,
+                             odin_dns_resolver_t *resolver, const char *name,
+                             uint16_t port, int family = AF_INET) {
+  CallbackState cb;
+  odin_dns_query_t *query =
+      StartFixtureQuery(resolver, name, port, family, &cb);
+  RunLoopUntil(loop, &cb, 1);
+  odin_dns_query_destroy(query);
+  return cb.records.empty() ? CapturedCallback() : cb.records[0];
+}
+
+size_t GetaddrinfoCalls() {
+  odin_dns_resolver_test_cares_observation_t obs;
+  EXPECT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
+  return obs.getaddrinfo_calls;
+}
+
+odin_dns_cache_stats_t CacheStats(const odin_dns_resolver_t *resolver) {
+  odin_dns_cache_stats_t stats;
+  odin_dns_resolver_cache_stats(resolver, &stats);
+  return stats;
+}
+
+// Synchronous probe into a buffer of cap addresses, shaped as a callback
+// record so the result checks apply.
+CapturedCallback CacheGet(odin_dns_resolver_t *resolver, const char *name,
+                          uint16_t port, int family, size_t cap) {
+  std::vector<odin_dns_addr_t> buf(cap);
+  const size_t n = odin_dns_resolver_cache_get(
+      resolver, name, std::strlen(name), port, family, buf.data(), cap);
+  CapturedCallback record;
+  record.addrs_was_null = n == 0;
+  record.addr_count = n;
+  record.addrs.assign(buf.begin(), buf.begin() + static_cast<ptrdiff_t>(n));
+  return record;
+}
+
+// Lets background refreshes finish; no user callback may fire.
+void SettleRefreshes(odin_event_loop_t *loop) {
+  CallbackState idle;
+  RunShortLoopExpectNoCallback(loop, &idle);
+}
+
+} // namespace
+
+// RFC-044 T1: a repeat lookup is answered from the cache with the requested
+// port, and an expired answer goes back to the network.
+TEST(OdinDnsCacheTest, T1HitReusesAnswer) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, nullptr), 0);
+
+    PushStreamAddr(AF_INET, "192.0.2.1", 443);
+    const CapturedCallback miss =
+        ResolveOnce(loop, resolver, "cache.test", 443);
+    EXPECT_EQ(miss.status, ODIN_DNS_OK);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(1));
+
+    const CapturedCallback hit =
+        ResolveOnce(loop, resolver, "CACHE.test", 8443);
+    EXPECT_EQ(hit.status, ODIN_DNS_OK);
+    EXPECT_TRUE(hit.start_returned);
+    ExpectAddressCount(hit, 1);
+    ExpectIpv4Result(hit, "192.0.2.1", 8443, 30);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(1));
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 30000);
+    PushStreamAddr(AF_INET, "192.0.2.2", 443);
+    const CapturedCallback expired =
+        ResolveOnce(loop, resolver, "cache.test", 443);
+    ExpectIpv4Result(expired, "192.0.2.2", 443, 30);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(2));
+
+    const odin_dns_cache_stats_t stats = CacheStats(resolver);
+    EXPECT_EQ(stats.lookups, 3u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-044 T2: a hot name is re-resolved once it passes the refresh fraction,
+// so a lookup after the original expiry still never waits; a cold name is
+// left alone.
+TEST(OdinDnsCacheTest, T2RefreshAheadKeepsHotNameWarm) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    const odin_dns_cache_config_t config = {0, 80, 0};
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, &config), 0);
+
+    PushStreamAddr(AF_INET, "192.0.2.9", 443);
+    (void)ResolveOnce(loop, resolver, "cold.test", 443);
+    PushStreamAddr(AF_INET, "192.0.2.1", 443);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(ResolveOnce(loop, resolver, "hot.test", 443).status,
+                ODIN_DNS_OK);
+    }
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(2));
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 23999);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(2));
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 24000);
+    PushStreamAddr(AF_INET, "192.0.2.2", 0);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(3));
+    SettleRefreshes(loop);
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 31000);
+    const CapturedCallback warm = ResolveOnce(loop, resolver, "hot.test", 443);
+    // Refreshed at +24 s with a 30 s TTL: 23 s are left at +31 s.
+    ExpectIpv4Result(warm, "192.0.2.2", 443, 23);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(3));
+
+    const odin_dns_cache_stats_t stats = CacheStats(resolver);
+    EXPECT_EQ(stats.refreshes, 1u);
+    EXPECT_EQ(stats.refresh_failures, 0u);
+    EXPECT_EQ(stats.hot_lookups, 1u);
+    EXPECT_EQ(stats.hot_hits, 1u);
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-044 T3: refreshes beyond the per-second budget wait for a later sweep.
+TEST(OdinDnsCacheTest, T3RefreshRateLimit) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    const odin_dns_cache_config_t config = {0, 80, 1};
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, &config), 0);
+
+    for (const char *name : {"a.test", "b.test"}) {
+      PushStreamAddr(AF_INET, "192.0.2.1", 443);
+      for (int i = 0; i < 3; ++i) {
+        (void)ResolveOnce(loop, resolver, name, 443);
+      }
+    }
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(2));
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 24000);
+    PushStreamAddr(AF_INET, "192.0.2.2", 0);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    SettleRefreshes(loop);
+    EXPECT_EQ(CacheStats(resolver).refreshes, 1u);
+    EXPECT_EQ(CacheStats(resolver).refresh_deferred, 1u);
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 24999);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    EXPECT_EQ(CacheStats(resolver).refreshes, 1u);
+    EXPECT_EQ(CacheStats(resolver).refresh_deferred, 2u);
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 25000);
+    PushStreamAddr(AF_INET, "192.0.2.3", 0);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    SettleRefreshes(loop);
+    EXPECT_EQ(CacheStats(resolver).refreshes, 2u);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(4));
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-044 T4: argument checks, eviction, uncached empty answers, and teardown
+// with a refresh still in flight.
+TEST(OdinDnsCacheTest, T4ArgumentsEvictionAndTeardown) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+
+    EXPECT_EQ(odin_dns_resolver_set_cache(nullptr, nullptr), -1);
+    EXPECT_EQ(errno, EINVAL);
+    const odin_dns_cache_config_t too_big = {ODIN_DNS_CACHE_MAX_ENTRIES + 1, 0,
+                                             0};
+    const odin_dns_cache_config_t bad_percent = {0, 100, 0};
+    const odin_dns_cache_config_t bad_rate = {0, 0, -1};
+    for (const odin_dns_cache_config_t *bad :
+         {&too_big, &bad_percent, &bad_rate}) {
+      errno = 0;
+      EXPECT_EQ(odin_dns_resolver_set_cache(resolver, bad), -1);
+      EXPECT_EQ(errno, EINVAL);
+    }
+    EXPECT_EQ(CacheStats(resolver).lookups, 0u);
+    EXPECT_EQ(CacheStats(nullptr).lookups, 0u);
+    EXPECT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), -1);
+
+    const odin_dns_cache_config_t one = {1, 0, 0};
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, &one), 0);
+    EXPECT_EQ(odin_dns_resolver_set_cache(resolver, &one), -1);
+    EXPECT_EQ(errno, EALREADY);
+
+    PushStreamAddr(AF_INET, "192.0.2.1", 443);
+    (void)ResolveOnce(loop, resolver, "a.test", 443);
+    PushStreamAddr(AF_INET, "192.0.2.2", 443);
+    (void)ResolveOnce(loop, resolver, "b.test", 443);
+    EXPECT_EQ(CacheStats(resolver).evictions, 1u);
+    PushStreamAddr(AF_INET, "192.0.2.1", 443);
+    (void)ResolveOnce(loop, resolver, "a.test", 443);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(3));
+
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_EQ(odin_dns_resolver_test_push_addr_result(nullptr, 0), 0);
+      EXPECT_EQ(ResolveOnce(loop, resolver, "empty.test", 443).addr_count,
+                static_cast<size_t>(0));
+    }
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(5));
+
+    (void)ResolveOnce(loop, resolver, "a.test", 443);
+    (void)ResolveOnce(loop, resolver, "a.test", 443);
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 24000);
+    PushStep(ODIN_DNS_TEST_CARES_RESULT_PENDING);
+    ASSERT_EQ(odin_dns_resolver_test_refresh_sweep(resolver), 0);
+    EXPECT_EQ(CacheStats(resolver).refreshes, 1u);
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-044 T5: the synchronous probe answers a live entry in any case with the
+// requested port, truncates to the caller's buffer, and leaves misses to the
+// query that follows.
+TEST(OdinDnsCacheTest, T5SynchronousGet) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    odin_dns_addr_t one;
+    EXPECT_EQ(odin_dns_resolver_cache_get(resolver, "get.test", 8, 443,
+                                          AF_INET, &one, 1),
+              static_cast<size_t>(0));
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, nullptr), 0);
+    EXPECT_EQ(odin_dns_resolver_cache_get(nullptr, "get.test", 8, 443,
+                                          AF_INET, &one, 1),
+              static_cast<size_t>(0));
+    EXPECT_EQ(odin_dns_resolver_cache_get(resolver, "get.test", 8, 443,
+                                          AF_INET, nullptr, 1),
+              static_cast<size_t>(0));
+    EXPECT_EQ(CacheGet(resolver, "get.test", 443, AF_INET, 4).addr_count,
+              static_cast<size_t>(0));
+    EXPECT_EQ(CacheStats(resolver).lookups, 0u);
+
+    const odin_dns_addr_t answer[2] = {
+        StreamAddr(AF_INET, "192.0.2.1", 443),
+        StreamAddr(AF_INET, "192.0.2.2", 443),
+    };
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(answer, 2), 0);
+    (void)ResolveOnce(loop, resolver, "get.test", 443);
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 10500);
+    const CapturedCallback both =
+        CacheGet(resolver, "GET.Test", 8443, AF_INET, 4);
+    ExpectAddressCount(both, 2);
+    CapturedCallback second = both;
+    second.addrs.erase(second.addrs.begin());
+    ExpectIpv4Result(second, "192.0.2.2", 8443, 20);
+    const CapturedCallback first =
+        CacheGet(resolver, "get.test", 80, AF_INET, 1);
+    ExpectAddressCount(first, 1);
+    ExpectIpv4Result(first, "192.0.2.1", 80, 20);
+    EXPECT_EQ(CacheGet(resolver, "get.test", 443, AF_INET6, 4).addr_count,
+              static_cast<size_t>(0));
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(1));
+
+    odin_dns_resolver_test_set_now_ms(kCacheNow + 30000);
+    EXPECT_EQ(CacheGet(resolver, "get.test", 443, AF_INET, 4).addr_count,
+              static_cast<size_t>(0));
+
+    const odin_dns_cache_stats_t stats = CacheStats(resolver);
+    EXPECT_EQ(stats.lookups, 3u);
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 1u);
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+// RFC-044 T6: the hashed index keeps (name, family) pairs apart and stays
+// consistent as a full cache evicts and reuses slots.
+TEST(OdinDnsCacheTest, T6IndexSurvivesEviction) {
+  AssertParentCaresInitUnchanged();
+  DnsRunDeadline::Run([] {
+    odin_dns_resolver_test_set_now_ms(kCacheNow);
+    odin_event_loop_t *loop = nullptr;
+    odin_dns_resolver_t *resolver = nullptr;
+    BasicLoopResolver(&loop, &resolver);
+    const odin_dns_cache_config_t three = {3, 0, 0};
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, &three), 0);
+
+    PushStreamAddr(AF_INET, "192.0.2.1", 443);
+    (void)ResolveOnce(loop, resolver, "a.test", 443);
+    PushStreamAddr(AF_INET6, "2001:db8::1", 443);
+    (void)ResolveOnce(loop, resolver, "a.test", 443, AF_INET6);
+    PushStreamAddr(AF_INET, "192.0.2.2", 443);
+    (void)ResolveOnce(loop, resolver, "b.test", 443);
+    ExpectIpv6Result(CacheGet(resolver, "A.TEST", 443, AF_INET6, 1),
+                     "2001:db8::1", 443, 30);
+
+    for (int round = 0; round < 8; ++round) {
+      const std::string name = "n" + std::to_string(round) + ".test";
+      PushStreamAddr(AF_INET, "192.0.2.3", 443);
+      (void)ResolveOnce(loop, resolver, name.c_str(), 443);
+      ExpectIpv4Result(CacheGet(resolver, name.c_str(), 443, AF_INET, 1),
+                       "192.0.2.3", 443, 30);
+    }
+    EXPECT_EQ(CacheStats(resolver).evictions, 8u);
+    EXPECT_EQ(CacheGet(resolver, "a.test", 443, AF_INET, 1).addr_count,
+              static_cast<size_t>(0));
+    EXPECT_EQ(CacheGet(resolver, "b.test", 443, AF_INET, 1).addr_count,
+              static_cast<size_t>(0));
+    ExpectIpv4Result(CacheGet(resolver, "n7.test", 443, AF_INET, 1),
+                     "192.0.2.3", 443, 30);
+    EXPECT_EQ(GetaddrinfoCalls(), static_cast<size_t>(11));
+
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(loop);
+    ExpectZeroLiveness();
+  });
+  AssertParentCaresInitUnchanged();
+}
+
+TEST(OdinDnsCacheTest, T8StatsFormat) {
+  odin_dns_cache_stats_t stats{};
+  stats.lookups = 40;
+  stats.hits = 30;
+  stats.misses = 10;
+  stats.hot_lookups = 12;
+  stats.hot_hits = 11;
+  stats.refreshes = 5;
+  stats.refresh_failures = 1;
+  stats.refresh_deferred = 2;
+  char buf[96];
+  const std::string want = "dns=30/10 hot=11/12 refresh=5/1/2";
+  EXPECT_EQ(odin_dns_cache_stats_format(&stats, buf, sizeof(buf)),
+            want.size());
+  EXPECT_EQ(std::string(buf), want);
+  char small[10];
+  EXPECT_EQ(odin_dns_cache_stats_format(&stats, small, sizeof(small)),
+            want.size());
+  EXPECT_EQ(std::string(small), "dns=30/10");
+}
+
 TEST(OdinDnsResolverExecChild, T16LibraryInit) {
   ODIN_DNS_REQUIRE_CHILD_MODE("T16LibraryInit", "T16_LIBRARY_INIT");
   ASSERT_EQ(odin_dns_resolver_test_reset_liveness(), 0) << std::strerror(errno);
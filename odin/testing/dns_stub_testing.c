@@ -0,0 +1 @@
+#include "odin/dns_stub.c" // NOLINT(bugprone-suspicious-include)
@@ -0,0 +1,373 @@
+// odin/testing/dns_stub_unittests.cpp
+//
+// Unit tests T9-T10 from §5 of odin/docs/rfc_045_dns_over_odin.md.
+//
+// T9 drives the RFC 1035 parse/build helpers on hand-built messages. T10 puts
+// the stub in front of a tunnel client whose stream a real responder serves
+// from the test resolver, and queries it over loopback UDP and TCP.
+
+#include "odin/dns_stub.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "odin/dns_resolver.h"
+#include "odin/dns_tunnel.h"
+#include "odin/event_loop.h"
+#include "odin/testing/dns_resolver_internal_test.h"
+#include "odin/transport.h"
+#include "odin/transport_fd.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+class StubRunDeadline {
+public:
+  template <typename Fn> static void Run(Fn fn) {
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1) << std::strerror(errno);
+    if (pid == 0) {
+      (void)odin_dns_resolver_test_reset_liveness();
+      fn();
+      _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+    int wstatus = 0;
+    bool exited = false;
+    for (int i = 0; i < 300; ++i) {
+      const pid_t got = waitpid(pid, &wstatus, WNOHANG);
+      if (got == pid) {
+        exited = true;
+        break;
+      }
+      if (got == -1 && errno != EINTR) {
+        break;
+      }
+      usleep(10000);
+    }
+    if (!exited) {
+      kill(pid, SIGKILL);
+      waitpid(pid, &wstatus, 0);
+      FAIL() << "StubRunDeadline exceeded 3 seconds";
+    }
+    ASSERT_TRUE(WIFEXITED(wstatus));
+    EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  }
+};
+
+using Bytes = std::vector<uint8_t>;
+
+uint16_t Rd16(const Bytes &b, size_t off) {
+  return static_cast<uint16_t>((b[off] << 8) | b[off + 1]);
+}
+
+// A one-question query; name is dotted, qdcount and flags as given.
+Bytes DnsQuery(uint16_t id, const std::string &name, uint16_t qtype,
+               uint16_t qclass = ODIN_DNS_CLASS_IN, uint16_t flags = 0x0100,
+               uint16_t qdcount = 1) {
+  Bytes b = {static_cast<uint8_t>(id >> 8),
+             static_cast<uint8_t>(id),
+             static_cast<uint8_t>(flags >> 8),
+             static_cast<uint8_t>(flags),
+             static_cast<uint8_t>(qdcount >> 8),
+             static_cast<uint8_t>(qdcount),
+             0,
+             0,
+             0,
+             0,
+             0,
+             0};
+  size_t start = 0;
+  while (start <= name.size() && !name.empty()) {
+    size_t dot = name.find('.', start);
+    if (dot == std::string::npos) {
+      dot = name.size();
+    }
+    b.push_back(static_cast<uint8_t>(dot - start));
+    b.insert(b.end(), name.begin() + static_cast<std::ptrdiff_t>(start),
+             name.begin() + static_cast<std::ptrdiff_t>(dot));
+    start = dot + 1;
+  }
+  b.push_back(0);
+  b.push_back(static_cast<uint8_t>(qtype >> 8));
+  b.push_back(static_cast<uint8_t>(qtype));
+  b.push_back(static_cast<uint8_t>(qclass >> 8));
+  b.push_back(static_cast<uint8_t>(qclass));
+  return b;
+}
+
+odin_dns_stub_question_t Parse(const Bytes &msg) {
+  odin_dns_stub_question_t q;
+  EXPECT_EQ(odin_dns_stub_parse_query(msg.data(), msg.size(), &q), 0);
+  return q;
+}
+
+// T9: questions parse to the name and type the tunnel needs; unusable ones
+// carry their rcode, and responses pack answers behind a name pointer,
+// setting TC when they do not fit.
+TEST(OdinDnsStubTest, T9ParseAndBuild) {
+  const Bytes query = DnsQuery(0x1234, "Example.com", ODIN_DNS_TYPE_A);
+  const odin_dns_stub_question_t q = Parse(query);
+  EXPECT_EQ(q.id, 0x1234);
+  EXPECT_EQ(q.rcode, ODIN_DNS_RCODE_NOERROR);
+  EXPECT_EQ(q.qtype, ODIN_DNS_TYPE_A);
+  EXPECT_EQ(std::string(q.name, q.name_len), "Example.com");
+  EXPECT_EQ(q.question_end, query.size());
+
+  const uint8_t addrs[8] = {192, 0, 2, 1, 192, 0, 2, 2};
+  uint8_t out[512];
+  size_t len = odin_dns_stub_build_response(query.data(), &q,
+                                            ODIN_DNS_RCODE_NOERROR, 60, addrs,
+                                            2, out, sizeof(out));
+  Bytes resp(out, out + len);
+  ASSERT_EQ(resp.size(), query.size() + 2 * 16);
+  EXPECT_EQ(Rd16(resp, 0), 0x1234);
+  EXPECT_EQ(Rd16(resp, 2), 0x8180); // QR, RD, RA, NOERROR
+  EXPECT_EQ(Rd16(resp, 4), 1);
+  EXPECT_EQ(Rd16(resp, 6), 2);
+  const size_t a1 = query.size() + 16;
+  EXPECT_EQ(Rd16(resp, a1), 0xC00C);
+  EXPECT_EQ(Rd16(resp, a1 + 2), ODIN_DNS_TYPE_A);
+  EXPECT_EQ(Rd16(resp, a1 + 8), 60); // low half of the TTL
+  EXPECT_EQ(Rd16(resp, a1 + 10), 4);
+  EXPECT_EQ(resp[a1 + 15], 2);
+
+  len = odin_dns_stub_build_response(query.data(), &q, ODIN_DNS_RCODE_NOERROR,
+                                     60, addrs, 2, out, query.size() + 16);
+  resp.assign(out, out + len);
+  EXPECT_EQ(Rd16(resp, 2) & 0x0200, 0x0200);
+  EXPECT_EQ(Rd16(resp, 6), 1);
+
+  EXPECT_EQ(Parse(DnsQuery(1, "a.test", ODIN_DNS_TYPE_A, 3)).rcode,
+            ODIN_DNS_RCODE_REFUSED);
+  EXPECT_EQ(Parse(DnsQuery(1, "", ODIN_DNS_TYPE_A)).rcode,
+            ODIN_DNS_RCODE_REFUSED);
+  EXPECT_EQ(Parse(DnsQuery(1, "a.test", ODIN_DNS_TYPE_A, ODIN_DNS_CLASS_IN,
+                           0x0100, 2))
+                .rcode,
+            ODIN_DNS_RCODE_FORMERR);
+  EXPECT_EQ(Parse(DnsQuery(1, "a.test", ODIN_DNS_TYPE_A, ODIN_DNS_CLASS_IN,
+                           0x1000))
+                .rcode,
+            ODIN_DNS_RCODE_NOTIMP);
+  Bytes cut = DnsQuery(1, "a.test", ODIN_DNS_TYPE_A);
+  cut.resize(cut.size() - 3);
+  const odin_dns_stub_question_t bad = Parse(cut);
+  EXPECT_EQ(bad.rcode, ODIN_DNS_RCODE_FORMERR);
+  len = odin_dns_stub_build_response(cut.data(), &bad, bad.rcode, 0, nullptr,
+                                     0, out, sizeof(out));
+  EXPECT_EQ(len, 12u);
+  EXPECT_EQ(out[3] & 0x0F, ODIN_DNS_RCODE_FORMERR);
+
+  odin_dns_stub_question_t ignored;
+  const Bytes response = DnsQuery(1, "a.test", ODIN_DNS_TYPE_A,
+                                  ODIN_DNS_CLASS_IN, 0x8000);
+  EXPECT_EQ(odin_dns_stub_parse_query(response.data(), response.size(),
+                                      &ignored),
+            -1);
+  EXPECT_EQ(odin_dns_stub_parse_query(response.data(), 11, &ignored), -1);
+}
+
+struct Server {
+  odin_event_loop_t *loop = nullptr;
+  odin_dns_resolver_t *resolver = nullptr;
+  odin_transport_t *t = nullptr;
+  odin_dns_tunnel_server_t *srv = nullptr;
+  int fd = -1;
+};
+
+void ServerReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  Server *s = static_cast<Server *>(user_data);
+  if (s->srv != nullptr) {
+    odin_dns_tunnel_server_ready(t, events, s->srv);
+  }
+}
+
+void ServerDone(odin_dns_tunnel_server_t *srv, int err, void *user_data) {
+  (void)err;
+  Server *s = static_cast<Server *>(user_data);
+  odin_dns_tunnel_server_destroy(srv);
+  s->srv = nullptr;
+}
+
+int ServerOpen(int fd, void *user_data) {
+  Server *s = static_cast<Server *>(user_data);
+  s->fd = fd;
+  if (odin_fd_transport_create(s->loop, fd, ServerReady, s, &s->t) != 0) {
+    return -1;
+  }
+  return odin_dns_tunnel_server_create(s->resolver, s->t, nullptr, 0, nullptr,
+                                       nullptr, ServerDone, s, &s->srv);
+}
+
+// Collects what the stub sends back to one UDP or TCP client socket.
+struct Reader {
+  odin_event_loop_t *loop = nullptr;
+  Bytes got;
+  size_t want = 0; // bytes (TCP) or datagrams (UDP) before stopping
+  bool datagram = false;
+  size_t datagrams = 0;
+};
+
+void OnReadable(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                unsigned int events, void *user_data) {
+  (void)io;
+  (void)events;
+  Reader *r = static_cast<Reader *>(user_data);
+  uint8_t buf[4096];
+  for (;;) {
+    const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      break;
+    }
+    r->got.insert(r->got.end(), buf, buf + n);
+    r->datagrams += 1;
+  }
+  if ((r->datagram ? r->datagrams : r->got.size()) >= r->want) {
+    odin_event_loop_stop(loop);
+  }
+}
+
+void RunUntilRead(Reader *r, int fd) {
+  odin_event_io_t *io = nullptr;
+  ASSERT_EQ(odin_event_io_start(r->loop, fd, ODIN_EVENT_READ, OnReadable, r,
+                                &io),
+            0);
+  ASSERT_EQ(odin_event_loop_run(r->loop), 0);
+  odin_event_io_stop(io);
+}
+
+odin_dns_addr_t V4(const char *literal) {
+  odin_dns_addr_t addr = {};
+  sockaddr_in *sin = reinterpret_cast<sockaddr_in *>(&addr.addr);
+  sin->sin_family = AF_INET;
+  EXPECT_EQ(inet_pton(AF_INET, literal, &sin->sin_addr), 1);
+  addr.addrlen = sizeof(sockaddr_in);
+  addr.ttl = 120;
+  return addr;
+}
+
+void StopWatchdog(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                  void *user_data) {
+  (void)timer;
+  *static_cast<bool *>(user_data) = true;
+  odin_event_loop_stop(loop);
+}
+
+// T10: a UDP and a pipelined TCP client get answers through the tunnel; a
+// type other than A/AAAA gets an empty NOERROR without a tunnel query.
+TEST(OdinDnsStubTest, T10UdpAndTcpThroughTunnel) {
+  StubRunDeadline::Run([] {
+    Server s;
+    ASSERT_EQ(odin_event_loop_create(&s.loop), 0);
+    ASSERT_EQ(odin_dns_resolver_create(s.loop, nullptr, &s.resolver), 0);
+    odin_dns_tunnel_client_config_t config = {};
+    config.loop = s.loop;
+    config.open_stream = ServerOpen;
+    config.open_user_data = &s;
+    odin_dns_tunnel_client_t *tunnel = nullptr;
+    ASSERT_EQ(odin_dns_tunnel_client_create(&config, &tunnel), 0);
+
+    int udp_fd = -1;
+    int tcp_fd = -1;
+    ASSERT_EQ(odin_dns_stub_open(0, &udp_fd, &tcp_fd), 0);
+    odin_dns_stub_t *stub = nullptr;
+    ASSERT_EQ(odin_dns_stub_create(s.loop, tunnel, udp_fd, tcp_fd, &stub), 0);
+    sockaddr_in addr = {};
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(getsockname(udp_fd, reinterpret_cast<sockaddr *>(&addr),
+                          &addr_len),
+              0);
+    bool timed_out = false;
+    odin_event_timer_t *watchdog = nullptr;
+    ASSERT_EQ(odin_event_timer_start(s.loop, 2000000, 0, StopWatchdog,
+                                     &timed_out, &watchdog),
+              0);
+
+    const odin_dns_addr_t udp_answer = V4("192.0.2.7");
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(&udp_answer, 1), 0);
+    const int uc = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    ASSERT_GE(uc, 0);
+    const Bytes uq = DnsQuery(0x0101, "udp.test", ODIN_DNS_TYPE_A);
+    ASSERT_EQ(sendto(uc, uq.data(), uq.size(), 0,
+                     reinterpret_cast<const sockaddr *>(&addr), addr_len),
+              static_cast<ssize_t>(uq.size()));
+    Reader ur;
+    ur.loop = s.loop;
+    ur.datagram = true;
+    ur.want = 1;
+    RunUntilRead(&ur, uc);
+    ASSERT_FALSE(timed_out);
+    ASSERT_EQ(ur.got.size(), uq.size() + 16);
+    EXPECT_EQ(Rd16(ur.got, 0), 0x0101);
+    EXPECT_EQ(Rd16(ur.got, 6), 1);
+    EXPECT_EQ(ur.got[ur.got.size() - 1], 7);
+
+    const odin_dns_addr_t tcp_answer = V4("192.0.2.8");
+    ASSERT_EQ(odin_dns_resolver_test_push_addr_result(&tcp_answer, 1), 0);
+    const int tc = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(tc, 0);
+    ASSERT_EQ(connect(tc, reinterpret_cast<const sockaddr *>(&addr), addr_len),
+              0);
+    ASSERT_EQ(fcntl(tc, F_SETFL, fcntl(tc, F_GETFL, 0) | O_NONBLOCK), 0);
+    const Bytes tq1 = DnsQuery(0x0202, "tcp.test", ODIN_DNS_TYPE_A);
+    const Bytes tq2 = DnsQuery(0x0303, "tcp.test", 16 /* TXT */);
+    Bytes stream;
+    for (const Bytes *m : {&tq1, &tq2}) {
+      stream.push_back(static_cast<uint8_t>(m->size() >> 8));
+      stream.push_back(static_cast<uint8_t>(m->size()));
+      stream.insert(stream.end(), m->begin(), m->end());
+    }
+    ASSERT_EQ(send(tc, stream.data(), stream.size(), 0),
+              static_cast<ssize_t>(stream.size()));
+    Reader tr;
+    tr.loop = s.loop;
+    tr.want = (2 + tq1.size() + 16) + (2 + tq2.size());
+    RunUntilRead(&tr, tc);
+    ASSERT_FALSE(timed_out);
+    ASSERT_EQ(tr.got.size(), tr.want);
+    // The TXT answer needs no tunnel round trip, so it comes back first.
+    EXPECT_EQ(Rd16(tr.got, 0), tq2.size());
+    EXPECT_EQ(Rd16(tr.got, 2), 0x0303);
+    EXPECT_EQ(Rd16(tr.got, 2 + 6), 0);
+    const size_t second = 2 + tq2.size();
+    EXPECT_EQ(Rd16(tr.got, second + 2), 0x0202);
+    EXPECT_EQ(Rd16(tr.got, second + 2 + 6), 1);
+    EXPECT_EQ(tr.got.back(), 8);
+
+    odin_dns_tunnel_client_stats_t stats = {};
+    odin_dns_tunnel_client_stats(tunnel, &stats);
+    EXPECT_EQ(stats.queries, 2u);
+    EXPECT_EQ(stats.streams, 1u);
+
+    odin_event_timer_stop(watchdog);
+    (void)close(uc);
+    (void)close(tc);
+    odin_dns_stub_destroy(stub);
+    odin_dns_tunnel_client_destroy(tunnel);
+    (void)close(udp_fd);
+    (void)close(tcp_fd);
+    odin_dns_tunnel_server_destroy(s.srv);
+    odin_transport_destroy(s.t);
+    (void)close(s.fd);
+    odin_dns_resolver_destroy(s.resolver);
+    odin_event_loop_destroy(s.loop);
+  });
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1,21 @@
+/* odin/testing/dns_tunnel_internal_test.h */
+
+#ifndef ODIN_DNS_TUNNEL_INTERNAL_TEST_H_
+#define ODIN_DNS_TUNNEL_INTERNAL_TEST_H_
+
+#include <stdint.h>
+
+#if defined(ODIN_DNS_TUNNEL_TESTING)
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pins the client cache clock; 0 restores CLOCK_MONOTONIC. */
+void odin_dns_tunnel_test_set_now_ms(uint64_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* defined(ODIN_DNS_TUNNEL_TESTING) */
+
+#endif /* ODIN_DNS_TUNNEL_INTERNAL_TEST_H_ */
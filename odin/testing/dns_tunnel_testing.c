@@ -0,0 +1 @@
+#include "odin/dns_tunnel.c" // NOLINT(bugprone-suspicious-include)
@@ -0,0 +1,647 @@
+// odin/testing/dns_tunnel_unittests.cpp
+//
+// Unit tests T3-T8 from §5 of odin/docs/rfc_045_dns_over_odin.md.
+//
+// The responder runs over an fd transport on one end of a socketpair with
+// the test resolver's scripted results; the client's DNS stream is either
+// answered by hand (FakeServer) or handed to a real responder.
+
+#include "odin/dns_tunnel.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "odin/dns_resolver.h"
+#include "odin/event_loop.h"
+#include "odin/protocol.h"
+#include "odin/testing/dns_resolver_internal_test.h"
+#include "odin/testing/dns_tunnel_internal_test.h"
+#include "odin/transport.h"
+#include "odin/transport_fd.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+constexpr uint64_t kNow = 1700000000000u;
+
+class TunnelRunDeadline {
+public:
+  template <typename Fn> static void Run(Fn fn) {
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1) << std::strerror(errno);
+    if (pid == 0) {
+      (void)odin_dns_resolver_test_reset_liveness();
+      fn();
+      _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+    int wstatus = 0;
+    bool exited = false;
+    for (int i = 0; i < 300; ++i) {
+      const pid_t got = waitpid(pid, &wstatus, WNOHANG);
+      if (got == pid) {
+        exited = true;
+        break;
+      }
+      if (got == -1 && errno != EINTR) {
+        break;
+      }
+      usleep(10000);
+    }
+    if (!exited) {
+      kill(pid, SIGKILL);
+      waitpid(pid, &wstatus, 0);
+      FAIL() << "TunnelRunDeadline exceeded 3 seconds";
+    }
+    ASSERT_TRUE(WIFEXITED(wstatus));
+    EXPECT_EQ(WEXITSTATUS(wstatus), 0);
+  }
+};
+
+void MakePair(int *a, int *b) {
+  int fds[2] = {-1, -1};
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  for (int fd : fds) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    ASSERT_EQ(fcntl(fd, F_SETFL, flags | O_NONBLOCK), 0);
+  }
+  *a = fds[0];
+  *b = fds[1];
+}
+
+void StopLoop(odin_event_loop_t *loop, odin_event_timer_t *timer,
+              void *user_data) {
+  (void)timer;
+  *static_cast<bool *>(user_data) = true;
+  odin_event_loop_stop(loop);
+}
+
+// Runs loop until something stops it; fails if the 1.5 s watchdog did.
+void RunLoop(odin_event_loop_t *loop) {
+  bool timed_out = false;
+  odin_event_timer_t *watchdog = nullptr;
+  ASSERT_EQ(odin_event_timer_start(loop, 1500000, 0, StopLoop, &timed_out,
+                                   &watchdog),
+            0);
+  ASSERT_EQ(odin_event_loop_run(loop), 0);
+  if (!timed_out) {
+    odin_event_timer_stop(watchdog);
+  }
+  ASSERT_FALSE(timed_out);
+}
+
+odin_dns_addr_t Addr(int family, const char *literal, int ttl) {
+  odin_dns_addr_t addr = {};
+  if (family == AF_INET) {
+    sockaddr_in *sin = reinterpret_cast<sockaddr_in *>(&addr.addr);
+    sin->sin_family = AF_INET;
+    EXPECT_EQ(inet_pton(AF_INET, literal, &sin->sin_addr), 1);
+    addr.addrlen = sizeof(sockaddr_in);
+  } else {
+    sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6 *>(&addr.addr);
+    sin6->sin6_family = AF_INET6;
+    EXPECT_EQ(inet_pton(AF_INET6, literal, &sin6->sin6_addr), 1);
+    addr.addrlen = sizeof(sockaddr_in6);
+  }
+  addr.ttl = ttl;
+  return addr;
+}
+
+void PushResult(const std::vector<odin_dns_addr_t> &addrs) {
+  ASSERT_EQ(odin_dns_resolver_test_push_addr_result(
+                addrs.empty() ? nullptr : addrs.data(), addrs.size()),
+            0)
+      << std::strerror(errno);
+}
+
+std::string Query(uint16_t id, uint8_t family, const char *name) {
+  uint8_t buf[ODIN_PROTO_DNS_QUERY_MAX];
+  size_t len = 0;
+  EXPECT_EQ(odin_proto_encode_dns_query(id, family, name, std::strlen(name),
+                                        buf, sizeof(buf), &len),
+            ODIN_PROTO_OK);
+  return std::string(reinterpret_cast<const char *>(buf), len);
+}
+
+std::string Ipv4(const uint8_t *p) {
+  char text[INET_ADDRSTRLEN] = {0};
+  EXPECT_NE(inet_ntop(AF_INET, p, text, sizeof(text)), nullptr);
+  return text;
+}
+
+struct Answer {
+  uint16_t id = 0;
+  uint8_t family = 0;
+  uint8_t rcode = 0;
+  uint32_t ttl = 0;
+  std::vector<std::string> addrs;
+};
+
+// Decodes every complete DNS_ANSWER in bytes.
+std::vector<Answer> DecodeAnswers(const std::string &bytes) {
+  std::vector<Answer> out;
+  size_t off = 0;
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(bytes.data());
+  while (off < bytes.size()) {
+    odin_proto_dns_answer_view_t view;
+    size_t consumed = 0;
+    if (odin_proto_decode_dns_answer(p + off, bytes.size() - off, &consumed,
+                                     &view) != ODIN_PROTO_OK) {
+      break;
+    }
+    Answer a;
+    a.id = view.id;
+    a.family = view.family;
+    a.rcode = view.rcode;
+    a.ttl = view.ttl;
+    for (size_t i = 0; i < view.count && view.family == 4; ++i) {
+      a.addrs.push_back(Ipv4(p + off + view.addrs_off + i * 4));
+    }
+    out.push_back(a);
+    off += consumed;
+  }
+  return out;
+}
+
+std::string DrainFd(int fd) {
+  std::string out;
+  char buf[4096];
+  for (;;) {
+    const ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      break;
+    }
+    out.append(buf, static_cast<size_t>(n));
+  }
+  return out;
+}
+
+// A responder on an fd transport; the transport's readiness is forwarded
+// once the responder exists.
+struct Responder {
+  odin_event_loop_t *loop = nullptr;
+  odin_transport_t *t = nullptr;
+  odin_dns_tunnel_server_t *srv = nullptr;
+  int fd = -1;
+  int done_calls = 0;
+  int done_err = -1;
+  bool stop_on_done = true;
+};
+
+void ResponderReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  Responder *r = static_cast<Responder *>(user_data);
+  if (r->srv != nullptr) {
+    odin_dns_tunnel_server_ready(t, events, r->srv);
+  }
+}
+
+void ResponderDone(odin_dns_tunnel_server_t *srv, int err, void *user_data) {
+  Responder *r = static_cast<Responder *>(user_data);
+  r->done_calls += 1;
+  r->done_err = err;
+  odin_dns_tunnel_server_destroy(srv);
+  r->srv = nullptr;
+  if (r->stop_on_done) {
+    odin_event_loop_stop(r->loop);
+  }
+}
+
+int RefuseLoopback(const sockaddr *addr, socklen_t addrlen, void *user_data) {
+  (void)addrlen;
+  (void)user_data;
+  if (addr->sa_family != AF_INET) {
+    return 0;
+  }
+  const sockaddr_in *sin = reinterpret_cast<const sockaddr_in *>(addr);
+  return (ntohl(sin->sin_addr.s_addr) >> 24) == 127 ? 1 : 0;
+}
+
+int StartResponder(Responder *r, odin_dns_resolver_t *resolver, int fd,
+                   const std::string &prefix) {
+  r->fd = fd;
+  if (odin_fd_transport_create(r->loop, fd, ResponderReady, r, &r->t) != 0) {
+    return -1;
+  }
+  return odin_dns_tunnel_server_create(
+      resolver, r->t, reinterpret_cast<const uint8_t *>(prefix.data()),
+      prefix.size(), RefuseLoopback, nullptr, ResponderDone, r, &r->srv);
+}
+
+void StopResponder(Responder *r) {
+  odin_dns_tunnel_server_destroy(r->srv);
+  r->srv = nullptr;
+  if (r->t != nullptr) {
+    odin_transport_destroy(r->t);
+    r->t = nullptr;
+  }
+  if (r->fd >= 0) {
+    (void)close(r->fd);
+    r->fd = -1;
+  }
+}
+
+// Client-side bookkeeping for odin_dns_tunnel_resolve callbacks.
+struct Lookups {
+  odin_event_loop_t *loop = nullptr;
+  int calls = 0;
+  int stop_after = 0;
+  std::vector<Answer> results;
+};
+
+void OnLookup(odin_dns_tunnel_request_t *req, uint8_t rcode, uint32_t ttl,
+              const uint8_t *addrs, size_t count, void *user_data) {
+  (void)req;
+  Lookups *l = static_cast<Lookups *>(user_data);
+  Answer a;
+  a.rcode = rcode;
+  a.ttl = ttl;
+  for (size_t i = 0; i < count; ++i) {
+    a.addrs.push_back(Ipv4(addrs + i * 4));
+  }
+  l->results.push_back(a);
+  l->calls += 1;
+  if (l->calls == l->stop_after) {
+    odin_event_loop_stop(l->loop);
+  }
+}
+
+// Plays the server by hand: records each query and, when answering, replies
+// with 10.0.0.<id + 1> and ttl 10.
+struct FakeServer {
+  odin_event_loop_t *loop = nullptr;
+  int fd = -1;
+  odin_event_io_t *io = nullptr;
+  bool answer = true;
+  int streams = 0;
+  std::vector<std::string> names;
+};
+
+void FakeServerIo(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
+                  unsigned int events, void *user_data) {
+  (void)loop;
+  (void)io;
+  (void)events;
+  FakeServer *s = static_cast<FakeServer *>(user_data);
+  const std::string bytes = DrainFd(fd);
+  size_t off = 0;
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(bytes.data());
+  while (off < bytes.size()) {
+    odin_proto_dns_query_view_t view;
+    size_t consumed = 0;
+    ASSERT_EQ(odin_proto_decode_dns_query(p + off, bytes.size() - off,
+                                          &consumed, &view),
+              ODIN_PROTO_OK);
+    s->names.emplace_back(reinterpret_cast<const char *>(p + off) +
+                              view.name_off,
+                          view.name_len);
+    if (s->answer) {
+      const uint8_t addr[4] = {10, 0, 0, static_cast<uint8_t>(view.id + 1)};
+      uint8_t out[ODIN_PROTO_DNS_ANSWER_MAX];
+      size_t len = 0;
+      ASSERT_EQ(odin_proto_encode_dns_answer(view.id, view.family,
+                                             ODIN_PROTO_DNS_RCODE_OK, 10, addr,
+                                             1, out, sizeof(out), &len),
+                ODIN_PROTO_OK);
+      ASSERT_EQ(write(fd, out, len), static_cast<ssize_t>(len));
+    }
+    off += consumed;
+  }
+}
+
+int FakeServerOpen(int fd, void *user_data) {
+  FakeServer *s = static_cast<FakeServer *>(user_data);
+  if (s->io != nullptr) {
+    odin_event_io_stop(s->io);
+    (void)close(s->fd);
+  }
+  s->fd = fd;
+  s->streams += 1;
+  return odin_event_io_start(s->loop, fd, ODIN_EVENT_READ, FakeServerIo, s,
+                             &s->io);
+}
+
+void FakeServerClose(FakeServer *s) {
+  if (s->io != nullptr) {
+    odin_event_io_stop(s->io);
+    s->io = nullptr;
+  }
+  if (s->fd >= 0) {
+    (void)close(s->fd);
+    s->fd = -1;
+  }
+}
+
+odin_dns_tunnel_client_t *FakeClient(FakeServer *s, uint32_t timeout_ms) {
+  odin_dns_tunnel_client_config_t config = {};
+  config.loop = s->loop;
+  config.open_stream = FakeServerOpen;
+  config.open_user_data = s;
+  config.cache_entries = 4;
+  config.timeout_ms = timeout_ms;
+  odin_dns_tunnel_client_t *client = nullptr;
+  EXPECT_EQ(odin_dns_tunnel_client_create(&config, &client), 0);
+  return client;
+}
+
+odin_dns_tunnel_client_stats_t Stats(const odin_dns_tunnel_client_t *client) {
+  odin_dns_tunnel_client_stats_t stats = {};
+  odin_dns_tunnel_client_stats(client, &stats);
+  return stats;
+}
+
+void Resolve(odin_dns_tunnel_client_t *client, const char *name, int family,
+             Lookups *l, odin_dns_tunnel_request_t **out = nullptr) {
+  odin_dns_tunnel_request_t *req = nullptr;
+  ASSERT_EQ(odin_dns_tunnel_resolve(client, name, std::strlen(name), family,
+                                    OnLookup, l, &req),
+            0)
+      << std::strerror(errno);
+  if (out != nullptr) {
+    *out = req;
+  }
+}
+
+// T3: queries pipelined behind the CONNECT and on the stream are answered
+// with their own ids; other-family and filtered addresses are dropped, the
+// TTL is the smallest kept one, and a half-close ends the responder with 0.
+TEST(OdinDnsTunnelTest, T3ResponderAnswersPipelinedQueries) {
+  TunnelRunDeadline::Run([] {
+    int a = -1;
+    int b = -1;
+    MakePair(&a, &b);
+    Responder r;
+    ASSERT_EQ(odin_event_loop_create(&r.loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    ASSERT_EQ(odin_dns_resolver_create(r.loop, nullptr, &resolver), 0);
+
+    PushResult({Addr(AF_INET, "192.0.2.1", 30),
+                Addr(AF_INET6, "2001:db8::1", 5),
+                Addr(AF_INET, "192.0.2.2", 20)});
+    PushResult(
+        {Addr(AF_INET, "127.0.0.1", 30), Addr(AF_INET, "192.0.2.9", 40)});
+    PushResult({});
+    ASSERT_EQ(StartResponder(&r, resolver, b,
+                             Query(7, ODIN_PROTO_DNS_FAMILY_V4, "a.test")),
+              0);
+    const std::string more = Query(8, ODIN_PROTO_DNS_FAMILY_V4, "b.test") +
+                             Query(9, ODIN_PROTO_DNS_FAMILY_V4, "none.test");
+    ASSERT_EQ(write(a, more.data(), more.size()),
+              static_cast<ssize_t>(more.size()));
+    ASSERT_EQ(shutdown(a, SHUT_WR), 0);
+    RunLoop(r.loop);
+
+    EXPECT_EQ(r.done_calls, 1);
+    EXPECT_EQ(r.done_err, 0);
+    std::vector<Answer> answers = DecodeAnswers(DrainFd(a));
+    ASSERT_EQ(answers.size(), 3u);
+    for (const Answer &ans : answers) {
+      EXPECT_EQ(ans.rcode, ODIN_PROTO_DNS_RCODE_OK);
+      EXPECT_EQ(ans.family, ODIN_PROTO_DNS_FAMILY_V4);
+      if (ans.id == 7) {
+        EXPECT_EQ(ans.addrs,
+                  (std::vector<std::string>{"192.0.2.1", "192.0.2.2"}));
+        EXPECT_EQ(ans.ttl, 20u);
+      } else if (ans.id == 8) {
+        EXPECT_EQ(ans.addrs, std::vector<std::string>{"192.0.2.9"});
+        EXPECT_EQ(ans.ttl, 40u);
+      } else {
+        EXPECT_EQ(ans.id, 9u);
+        EXPECT_TRUE(ans.addrs.empty());
+        EXPECT_EQ(ans.ttl, 0u);
+      }
+    }
+
+    StopResponder(&r);
+    (void)close(a);
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(r.loop);
+  });
+}
+
+// T4: a prefix or a stream frame that is not a DNS_QUERY is EPROTO.
+TEST(OdinDnsTunnelTest, T4ResponderRejectsForeignFrames) {
+  TunnelRunDeadline::Run([] {
+    int a = -1;
+    int b = -1;
+    MakePair(&a, &b);
+    Responder r;
+    ASSERT_EQ(odin_event_loop_create(&r.loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    ASSERT_EQ(odin_dns_resolver_create(r.loop, nullptr, &resolver), 0);
+
+    uint8_t frame[ODIN_PROTO_DNS_ANSWER_MAX];
+    size_t frame_len = 0;
+    ASSERT_EQ(odin_proto_encode_dns_answer(1, ODIN_PROTO_DNS_FAMILY_V4,
+                                           ODIN_PROTO_DNS_RCODE_OK, 0, nullptr,
+                                           0, frame, sizeof(frame), &frame_len),
+              ODIN_PROTO_OK);
+    const std::string answer(reinterpret_cast<const char *>(frame), frame_len);
+    errno = 0;
+    EXPECT_EQ(StartResponder(&r, resolver, b, answer), -1);
+    EXPECT_EQ(errno, EPROTO);
+    EXPECT_EQ(r.srv, nullptr);
+
+    ASSERT_EQ(odin_dns_tunnel_server_create(resolver, r.t, nullptr, 0,
+                                            nullptr, nullptr, ResponderDone,
+                                            &r, &r.srv),
+              0);
+    ASSERT_EQ(write(a, answer.data(), answer.size()),
+              static_cast<ssize_t>(answer.size()));
+    RunLoop(r.loop);
+    EXPECT_EQ(r.done_calls, 1);
+    EXPECT_EQ(r.done_err, EPROTO);
+
+    StopResponder(&r);
+    (void)close(a);
+    odin_dns_resolver_destroy(resolver);
+    odin_event_loop_destroy(r.loop);
+  });
+}
+
+// T5: a lookup for a name in flight joins it; the answer is cached for its
+// TTL, a hit is never delivered inside resolve, and expiry asks again.
+TEST(OdinDnsTunnelTest, T5ClientCoalescesAndCaches) {
+  TunnelRunDeadline::Run([] {
+    odin_dns_tunnel_test_set_now_ms(kNow);
+    FakeServer s;
+    ASSERT_EQ(odin_event_loop_create(&s.loop), 0);
+    odin_dns_tunnel_client_t *client = FakeClient(&s, 0);
+    ASSERT_NE(client, nullptr);
+
+    Lookups l;
+    l.loop = s.loop;
+    l.stop_after = 2;
+    Resolve(client, "x.test", AF_INET, &l);
+    Resolve(client, "X.TEST", AF_INET, &l);
+    EXPECT_EQ(l.calls, 0);
+    RunLoop(s.loop);
+    ASSERT_EQ(l.calls, 2);
+    EXPECT_EQ(l.results[0].addrs, std::vector<std::string>{"10.0.0.1"});
+    EXPECT_EQ(l.results[1].addrs, std::vector<std::string>{"10.0.0.1"});
+    EXPECT_EQ(s.names, std::vector<std::string>{"x.test"});
+
+    l.stop_after = 3;
+    Resolve(client, "x.test", AF_INET, &l);
+    EXPECT_EQ(l.calls, 2);
+    RunLoop(s.loop);
+    EXPECT_EQ(l.results[2].ttl, 10u);
+
+    odin_dns_tunnel_test_set_now_ms(kNow + 10000);
+    l.stop_after = 4;
+    Resolve(client, "x.test", AF_INET, &l);
+    RunLoop(s.loop);
+    EXPECT_EQ(s.names.size(), 2u);
+
+    const odin_dns_tunnel_client_stats_t stats = Stats(client);
+    EXPECT_EQ(stats.lookups, 4u);
+    EXPECT_EQ(stats.coalesced, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.queries, 2u);
+    EXPECT_EQ(stats.streams, 1u);
+    EXPECT_EQ(stats.failures, 0u);
+
+    odin_dns_tunnel_client_destroy(client);
+    FakeServerClose(&s);
+    odin_event_loop_destroy(s.loop);
+    odin_dns_tunnel_test_set_now_ms(0);
+  });
+}
+
+// T6: with every slot waiting on the stream, a new name is ENOBUFS; a
+// stream that answers nothing for timeout_ms fails its lookups, and the next
+// lookup opens a new stream. A cancelled lookup never calls back.
+TEST(OdinDnsTunnelTest, T6ClientFailsStalledStream) {
+  TunnelRunDeadline::Run([] {
+    FakeServer s;
+    s.answer = false;
+    ASSERT_EQ(odin_event_loop_create(&s.loop), 0);
+    odin_dns_tunnel_client_t *client = FakeClient(&s, 50);
+    ASSERT_NE(client, nullptr);
+
+    Lookups l;
+    l.loop = s.loop;
+    l.stop_after = 3;
+    odin_dns_tunnel_request_t *cancelled = nullptr;
+    Resolve(client, "a.test", AF_INET, &l);
+    Resolve(client, "b.test", AF_INET, &l);
+    Resolve(client, "c.test", AF_INET, &l);
+    Resolve(client, "d.test", AF_INET, &l, &cancelled);
+    odin_dns_tunnel_request_t *req = nullptr;
+    errno = 0;
+    EXPECT_EQ(odin_dns_tunnel_resolve(client, "e.test", 6, AF_INET, OnLookup,
+                                      &l, &req),
+              -1);
+    EXPECT_EQ(errno, ENOBUFS);
+    odin_dns_tunnel_request_cancel(cancelled);
+    RunLoop(s.loop);
+    ASSERT_EQ(l.calls, 3);
+    for (const Answer &a : l.results) {
+      EXPECT_EQ(a.rcode, ODIN_PROTO_DNS_RCODE_FAIL);
+      EXPECT_TRUE(a.addrs.empty());
+    }
+    EXPECT_EQ(s.names.size(), 4u);
+
+    s.answer = true;
+    l.stop_after = 4;
+    Resolve(client, "a.test", AF_INET, &l);
+    RunLoop(s.loop);
+    EXPECT_EQ(l.results[3].rcode, ODIN_PROTO_DNS_RCODE_OK);
+
+    const odin_dns_tunnel_client_stats_t stats = Stats(client);
+    EXPECT_EQ(stats.streams, 2u);
+    EXPECT_EQ(stats.failures, 3u);
+
+    odin_dns_tunnel_client_destroy(client);
+    FakeServerClose(&s);
+    odin_event_loop_destroy(s.loop);
+  });
+}
+
+// T7: the server closing the stream fails pending lookups at once.
+TEST(OdinDnsTunnelTest, T7ClientFailsClosedStream) {
+  TunnelRunDeadline::Run([] {
+    FakeServer s;
+    s.answer = false;
+    ASSERT_EQ(odin_event_loop_create(&s.loop), 0);
+    odin_dns_tunnel_client_t *client = FakeClient(&s, 60000);
+    ASSERT_NE(client, nullptr);
+
+    Lookups l;
+    l.loop = s.loop;
+    l.stop_after = 1;
+    Resolve(client, "gone.test", AF_INET6, &l);
+    ASSERT_EQ(shutdown(s.fd, SHUT_RDWR), 0);
+    RunLoop(s.loop);
+    ASSERT_EQ(l.calls, 1);
+    EXPECT_EQ(l.results[0].rcode, ODIN_PROTO_DNS_RCODE_FAIL);
+
+    odin_dns_tunnel_client_destroy(client);
+    FakeServerClose(&s);
+    odin_event_loop_destroy(s.loop);
+  });
+}
+
+struct Interop {
+  Responder r;
+  odin_dns_resolver_t *resolver = nullptr;
+};
+
+int InteropOpen(int fd, void *user_data) {
+  Interop *i = static_cast<Interop *>(user_data);
+  i->r.stop_on_done = false;
+  return StartResponder(&i->r, i->resolver, fd, std::string());
+}
+
+// T8: a client stream served by a real responder resolves both families of
+// one name with one query each.
+TEST(OdinDnsTunnelTest, T8ClientAgainstResponder) {
+  TunnelRunDeadline::Run([] {
+    Interop i;
+    ASSERT_EQ(odin_event_loop_create(&i.r.loop), 0);
+    ASSERT_EQ(odin_dns_resolver_create(i.r.loop, nullptr, &i.resolver), 0);
+    odin_dns_tunnel_client_config_t config = {};
+    config.loop = i.r.loop;
+    config.open_stream = InteropOpen;
+    config.open_user_data = &i;
+    odin_dns_tunnel_client_t *client = nullptr;
+    ASSERT_EQ(odin_dns_tunnel_client_create(&config, &client), 0);
+
+    PushResult({Addr(AF_INET, "192.0.2.5", 60)});
+    PushResult({Addr(AF_INET6, "2001:db8::5", 60)});
+    Lookups l;
+    l.loop = i.r.loop;
+    l.stop_after = 2;
+    Resolve(client, "both.test", AF_INET, &l);
+    Resolve(client, "both.test", AF_INET6, &l);
+    RunLoop(i.r.loop);
+    ASSERT_EQ(l.calls, 2);
+    EXPECT_EQ(l.results[0].rcode, ODIN_PROTO_DNS_RCODE_OK);
+    EXPECT_EQ(l.results[1].rcode, ODIN_PROTO_DNS_RCODE_OK);
+    EXPECT_EQ(l.results[0].addrs.size(), 1u);
+    EXPECT_EQ(l.results[1].addrs.size(), 1u);
+    EXPECT_EQ(l.results[0].ttl, 60u);
+    EXPECT_EQ(Stats(client).queries, 2u);
+
+    odin_dns_tunnel_client_destroy(client);
+    StopResponder(&i.r);
+    odin_dns_resolver_destroy(i.resolver);
+    odin_event_loop_destroy(i.r.loop);
+  });
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -1080,4 +1081,446 @@ TEST(OdinEventLoopTest, T27) {
   EXPECT_EQ(after_destroy.task_nodes, 0u);
 }
 
+// RFC-046 instrumentation rows. Callbacks advance the fake clock by the time
+// they pretend to run, so every histogram value is exact.
+namespace {
+
+struct StatsState {
+  odin_event_loop_t *loop = nullptr;
+  int fds[2] = {-1, -1};
+  std::vector<odin_event_loop_slow_report_t> reports;
+  std::vector<std::string> symbols;
+  uint64_t now_us = 0;
+};
+
+void Advance(StatsState *st, uint64_t us) {
+  st->now_us += us;
+  odin_event_loop_test_set_now_us(st->loop, st->now_us);
+}
+
+void SlowTask(odin_event_loop_t *, void *user_data) {
+  Advance(static_cast<StatsState *>(user_data), 2000);
+}
+
+void QuickTimer(odin_event_loop_t *, odin_event_timer_t *, void *user_data) {
+  Advance(static_cast<StatsState *>(user_data), 50);
+}
+
+void StoppingIo(odin_event_loop_t *loop, odin_event_io_t *, int fd,
+                unsigned int, void *user_data) {
+  ReadOne(fd, 'x');
+  Advance(static_cast<StatsState *>(user_data), 10);
+  odin_event_loop_stop(loop);
+}
+
+void SixHundredTask(odin_event_loop_t *, void *user_data) {
+  Advance(static_cast<StatsState *>(user_data), 600);
+}
+
+void CollectSlow(odin_event_loop_t *, const odin_event_loop_slow_report_t *r,
+                 void *user_data) {
+  StatsState *st = static_cast<StatsState *>(user_data);
+  st->reports.push_back(*r);
+  st->symbols.emplace_back(r->symbol);
+}
+
+} // namespace
+
+// RFC-046 T1 — instrumentation is off until enabled, enables once, and a
+// NULL config takes the defaults.
+TEST(OdinEventLoopStatsTest, T1OffUntilEnabled) {
+  EventLoopRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    AssertOk(odin_event_loop_create(&loop));
+    int calls = 0;
+    ExpectOk(odin_event_post(loop, StopTask, &calls));
+    EXPECT_EQ(odin_event_loop_run(loop), 0);
+    odin_event_loop_stats_t stats;
+    std::memset(&stats, 0xFF, sizeof(stats));
+    odin_event_loop_stats(loop, &stats);
+    EXPECT_EQ(stats.callback.count, 0u);
+    EXPECT_EQ(stats.callbacks, 0u);
+    EXPECT_EQ(odin_event_loop_callback_stats(loop, nullptr, 0), 0u);
+
+    ExpectOk(odin_event_loop_enable_stats(loop, nullptr));
+    errno = 0;
+    EXPECT_EQ(odin_event_loop_enable_stats(loop, nullptr), -1);
+    EXPECT_EQ(errno, EALREADY);
+    ExpectOk(odin_event_post(loop, StopTask, &calls));
+    EXPECT_EQ(odin_event_loop_run(loop), 0);
+    odin_event_loop_stats(loop, &stats);
+    EXPECT_EQ(stats.callback.count, 1u);
+    EXPECT_EQ(stats.slow_callbacks, 0u);
+    odin_event_loop_cb_stats_t cb;
+    ASSERT_EQ(odin_event_loop_callback_stats(loop, &cb, 1), 1u);
+    EXPECT_EQ(cb.fn, reinterpret_cast<uintptr_t>(&StopTask));
+    EXPECT_EQ(cb.kind, ODIN_EVENT_CB_TASK);
+    EXPECT_EQ(calls, 2);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-046 T2 — a task, a late timer, and an I/O callback land in the
+// iteration, lateness, and run-time histograms and in per-callback slots
+// ordered by total run time; the slow task is reported with its symbol.
+TEST(OdinEventLoopStatsTest, T2HistogramsAndPerCallback) {
+  EventLoopRunDeadline::Run([] {
+    StatsState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    st.now_us = 1000000;
+    odin_event_loop_test_set_now_us(st.loop, st.now_us);
+    odin_event_loop_stats_config_t config = {};
+    config.slow_us = 1000;
+    config.on_slow = CollectSlow;
+    config.user_data = &st;
+    ExpectOk(odin_event_loop_enable_stats(st.loop, &config));
+
+    odin_event_timer_t *timer = nullptr;
+    AssertOk(odin_event_timer_start(st.loop, 100, 0, QuickTimer, &st, &timer));
+    Advance(&st, 500);
+    ExpectOk(odin_event_post(st.loop, SlowTask, &st));
+    CreateNonblockingSocketpair(st.fds);
+    WriteOne(st.fds[1], 'x');
+    odin_event_io_t *io = nullptr;
+    AssertOk(odin_event_io_start(st.loop, st.fds[0], ODIN_EVENT_READ,
+                                 StoppingIo, &st, &io));
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+
+    odin_event_loop_stats_t stats;
+    odin_event_loop_stats(st.loop, &stats);
+    EXPECT_EQ(stats.callback.count, 3u);
+    EXPECT_EQ(stats.callback.sum_us, 2060u);
+    EXPECT_EQ(stats.callback.max_us, 2000u);
+    EXPECT_EQ(stats.callback.buckets[11], 1u); // 2000 in [1024, 2048)
+    EXPECT_EQ(stats.timer_lateness.count, 1u);
+    EXPECT_EQ(stats.timer_lateness.sum_us, 2400u);
+    EXPECT_EQ(stats.timer_lateness.buckets[12], 1u);
+    EXPECT_EQ(stats.iteration.count, 1u);
+    EXPECT_EQ(stats.iteration.sum_us, 2050u);
+    EXPECT_EQ(stats.slow_callbacks, 1u);
+    EXPECT_EQ(stats.slow_reports, 1u);
+    EXPECT_EQ(stats.untracked, 0u);
+    EXPECT_EQ(stats.callbacks, 3u);
+
+    ASSERT_EQ(st.reports.size(), 1u);
+    EXPECT_EQ(st.reports[0].fn, reinterpret_cast<uintptr_t>(&SlowTask));
+    EXPECT_EQ(st.reports[0].kind, ODIN_EVENT_CB_TASK);
+    EXPECT_EQ(st.reports[0].elapsed_us, 2000u);
+    EXPECT_EQ(st.reports[0].suppressed, 0u);
+    EXPECT_FALSE(st.symbols[0].empty());
+
+    odin_event_loop_cb_stats_t cbs[8];
+    ASSERT_EQ(odin_event_loop_callback_stats(st.loop, cbs, 8), 3u);
+    EXPECT_EQ(cbs[0].fn, reinterpret_cast<uintptr_t>(&SlowTask));
+    EXPECT_EQ(cbs[0].run.sum_us, 2000u);
+    EXPECT_EQ(cbs[1].fn, reinterpret_cast<uintptr_t>(&QuickTimer));
+    EXPECT_EQ(cbs[1].kind, ODIN_EVENT_CB_TIMER);
+    EXPECT_EQ(cbs[1].run.sum_us, 50u);
+    EXPECT_EQ(cbs[2].fn, reinterpret_cast<uintptr_t>(&StoppingIo));
+    EXPECT_EQ(cbs[2].kind, ODIN_EVENT_CB_IO);
+    EXPECT_EQ(cbs[2].run.sum_us, 10u);
+    odin_event_loop_cb_stats_t top;
+    ASSERT_EQ(odin_event_loop_callback_stats(st.loop, &top, 1), 3u);
+    EXPECT_EQ(top.fn, reinterpret_cast<uintptr_t>(&SlowTask));
+
+    odin_event_io_stop(io);
+    odin_event_loop_destroy(st.loop);
+    ClosePair(st.fds);
+  });
+}
+
+// RFC-046 T3 — slow callbacks are reported at most once per interval, each
+// report carrying how many were skipped; symbols resolve or fall back to
+// module+offset.
+TEST(OdinEventLoopStatsTest, T3SlowReportsAreSampled) {
+  EventLoopRunDeadline::Run([] {
+    StatsState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    odin_event_loop_test_set_now_us(st.loop, 0);
+    odin_event_loop_stats_config_t config = {};
+    config.slow_us = 500;
+    config.report_interval_us = 1000;
+    config.on_slow = CollectSlow;
+    config.user_data = &st;
+    ExpectOk(odin_event_loop_enable_stats(st.loop, &config));
+    for (int i = 0; i < 5; ++i) {
+      ExpectOk(odin_event_post(st.loop, SixHundredTask, &st));
+    }
+    int calls = 0;
+    ExpectOk(odin_event_post(st.loop, StopTask, &calls));
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+
+    odin_event_loop_stats_t stats;
+    odin_event_loop_stats(st.loop, &stats);
+    EXPECT_EQ(stats.slow_callbacks, 5u);
+    EXPECT_EQ(stats.slow_reports, 3u);
+    ASSERT_EQ(st.reports.size(), 3u);
+    EXPECT_EQ(st.reports[0].suppressed, 0u);
+    EXPECT_EQ(st.reports[1].suppressed, 1u);
+    EXPECT_EQ(st.reports[2].suppressed, 1u);
+    EXPECT_EQ(stats.callbacks, 2u);
+    odin_event_loop_destroy(st.loop);
+
+    char buf[ODIN_EVENT_LOOP_SYMBOL_MAX];
+    const size_t len = odin_event_loop_symbol(
+        reinterpret_cast<uintptr_t>(&SixHundredTask), buf, sizeof(buf));
+    EXPECT_EQ(len, std::strlen(buf));
+    // Internal linkage: never a dynamic symbol, so module+offset.
+    EXPECT_NE(std::string(buf).find("+0x"), std::string::npos) << buf;
+    char tiny[4];
+    EXPECT_EQ(odin_event_loop_symbol(
+                  reinterpret_cast<uintptr_t>(&SixHundredTask), tiny,
+                  sizeof(tiny)),
+              len);
+    EXPECT_EQ(std::strlen(tiny), 3u);
+  });
+}
+
+// RFC-046 T4 — the RFC-051 log fields: histogram means and maxima, the slow
+// count, and one slow report; both truncate snprintf-style.
+TEST(OdinEventLoopStatsTest, T4StatsAndSlowReportFormat) {
+  odin_event_loop_stats_t stats = {};
+  stats.iteration.count = 4;
+  stats.iteration.sum_us = 410;
+  stats.iteration.max_us = 250;
+  stats.timer_lateness.count = 2;
+  stats.timer_lateness.sum_us = 3000;
+  stats.timer_lateness.max_us = 2400;
+  stats.slow_callbacks = 1;
+  char buf[128];
+  const std::string want =
+      "loop_us=102/250 late_us=1500/2400 cb_us=0/0 slow=1";
+  EXPECT_EQ(odin_event_loop_stats_format(&stats, buf, sizeof(buf)),
+            want.size());
+  EXPECT_EQ(std::string(buf), want);
+  char small[16];
+  EXPECT_EQ(odin_event_loop_stats_format(&stats, small, sizeof(small)),
+            want.size());
+  EXPECT_EQ(std::string(small), "loop_us=102/250");
+
+  odin_event_loop_slow_report_t report = {};
+  report.kind = ODIN_EVENT_CB_TIMER;
+  report.elapsed_us = 12000;
+  report.suppressed = 3;
+  report.symbol = "odin+0x1f00";
+  const std::string want_report =
+      "cb=odin+0x1f00 kind=timer us=12000 suppressed=3";
+  EXPECT_EQ(odin_event_loop_slow_report_format(&report, buf, sizeof(buf)),
+            want_report.size());
+  EXPECT_EQ(std::string(buf), want_report);
+  report.kind = ODIN_EVENT_CB_IO;
+  report.symbol = nullptr;
+  (void)odin_event_loop_slow_report_format(&report, buf, sizeof(buf));
+  EXPECT_EQ(std::string(buf), "cb=? kind=io us=12000 suppressed=3");
+}
+
+// RFC-047 budget rows. Each row records the order callbacks ran in.
+namespace {
+
+struct BudgetState {
+  odin_event_loop_t *loop = nullptr;
+  std::string order;
+  uint64_t now_us = 0;
+  uint64_t step_us = 0;
+  int pairs[3][2] = {{-1, -1}, {-1, -1}, {-1, -1}};
+  odin_event_io_t *ios[3] = {nullptr, nullptr, nullptr};
+  int stop_after = 0;
+};
+
+struct BudgetCall {
+  BudgetState *st;
+  char tag;
+};
+
+void BudgetStep(BudgetState *st, char tag) {
+  st->order.push_back(tag);
+  if (st->step_us != 0) {
+    st->now_us += st->step_us;
+    odin_event_loop_test_set_now_us(st->loop, st->now_us);
+  }
+  if (static_cast<int>(st->order.size()) == st->stop_after) {
+    odin_event_loop_stop(st->loop);
+  }
+}
+
+void BudgetTask(odin_event_loop_t *, void *user_data) {
+  BudgetCall *c = static_cast<BudgetCall *>(user_data);
+  BudgetStep(c->st, c->tag);
+}
+
+void BudgetTimer(odin_event_loop_t *, odin_event_timer_t *, void *user_data) {
+  BudgetCall *c = static_cast<BudgetCall *>(user_data);
+  BudgetStep(c->st, c->tag);
+}
+
+// Runs as timer X and posts task t behind it.
+BudgetCall g_posted_task;
+
+void PostingTimer(odin_event_loop_t *loop, odin_event_timer_t *,
+                  void *user_data) {
+  BudgetCall *c = static_cast<BudgetCall *>(user_data);
+  BudgetStep(c->st, c->tag);
+  g_posted_task.st = c->st;
+  g_posted_task.tag = 't';
+  ExpectOk(odin_event_post(loop, BudgetTask, &g_posted_task));
+}
+
+// Reads its byte, then posts the lower-case task for its tag.
+BudgetCall g_io_tasks[3];
+
+void BudgetIo(odin_event_loop_t *loop, odin_event_io_t *, int fd,
+              unsigned int, void *user_data) {
+  BudgetCall *c = static_cast<BudgetCall *>(user_data);
+  ReadOne(fd, 'x');
+  BudgetStep(c->st, c->tag);
+  const int i = c->tag - 'A';
+  g_io_tasks[i].st = c->st;
+  g_io_tasks[i].tag = static_cast<char>('a' + i);
+  ExpectOk(odin_event_post(loop, BudgetTask, &g_io_tasks[i]));
+}
+
+void StopsNextIo(odin_event_loop_t *loop, odin_event_io_t *, int fd,
+                 unsigned int, void *user_data) {
+  BudgetState *st = static_cast<BudgetState *>(user_data);
+  ReadOne(fd, 'x');
+  st->order.push_back(fd == st->pairs[0][0] ? 'A' : 'B');
+  for (int i = 0; i < 2; ++i) {
+    if (st->pairs[i][0] != fd && st->ios[i] != nullptr) {
+      odin_event_io_stop(st->ios[i]);
+      st->ios[i] = nullptr;
+    }
+  }
+  odin_event_loop_stop(loop);
+}
+
+} // namespace
+
+// RFC-047 T1 — with one I/O callback per pass, tasks run between readiness
+// that a single backend wait reported, and the carry needs no second wait.
+TEST(OdinEventLoopBudgetTest, T1IoBudgetCarriesReadiness) {
+  EventLoopRunDeadline::Run([] {
+    BudgetState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    ExpectOk(odin_event_loop_enable_stats(st.loop, nullptr));
+    odin_event_loop_budget_t budget = {};
+    budget.io_per_pass = 1;
+    odin_event_loop_set_budget(st.loop, &budget);
+    st.stop_after = 6;
+    BudgetCall calls[3];
+    for (int i = 0; i < 3; ++i) {
+      CreateNonblockingSocketpair(st.pairs[i]);
+      WriteOne(st.pairs[i][1], 'x');
+      calls[i].st = &st;
+      calls[i].tag = static_cast<char>('A' + i);
+      AssertOk(odin_event_io_start(st.loop, st.pairs[i][0], ODIN_EVENT_READ,
+                                   BudgetIo, &calls[i], &st.ios[i]));
+    }
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+    EXPECT_EQ(st.order, "AaBbCc");
+    odin_event_loop_stats_t stats;
+    odin_event_loop_stats(st.loop, &stats);
+    EXPECT_EQ(stats.iteration.count, 1u);
+
+    odin_event_loop_set_budget(st.loop, nullptr);
+    st.order.clear();
+    st.stop_after = 6;
+    for (int i = 0; i < 3; ++i) {
+      WriteOne(st.pairs[i][1], 'x');
+    }
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+    EXPECT_EQ(st.order, "ABCabc");
+    for (int i = 0; i < 3; ++i) {
+      odin_event_io_stop(st.ios[i]);
+      ClosePair(st.pairs[i]);
+    }
+    odin_event_loop_destroy(st.loop);
+  });
+}
+
+// RFC-047 T2 — a task phase past phase_us yields to due timers; the rest of
+// the snapshot keeps its place ahead of later tasks.
+TEST(OdinEventLoopBudgetTest, T2TaskPhaseYieldsToTimers) {
+  EventLoopRunDeadline::Run([] {
+    BudgetState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    st.now_us = 1000000;
+    st.step_us = 1000;
+    odin_event_loop_test_set_now_us(st.loop, st.now_us);
+    odin_event_loop_budget_t budget = {};
+    budget.phase_us = 1500;
+    odin_event_loop_set_budget(st.loop, &budget);
+    st.stop_after = 4;
+    BudgetCall tasks[3] = {{&st, '1'}, {&st, '2'}, {&st, '3'}};
+    for (BudgetCall &c : tasks) {
+      ExpectOk(odin_event_post(st.loop, BudgetTask, &c));
+    }
+    BudgetCall timer_call = {&st, 'T'};
+    odin_event_timer_t *timer = nullptr;
+    AssertOk(odin_event_timer_start(st.loop, 0, 0, BudgetTimer, &timer_call,
+                                    &timer));
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+    EXPECT_EQ(st.order, "12T3");
+    odin_event_loop_destroy(st.loop);
+  });
+}
+
+// RFC-047 T3 — a timer phase past phase_us lets posted tasks run; timers
+// left over stay due and fire next pass in deadline order.
+TEST(OdinEventLoopBudgetTest, T3TimerPhaseYieldsToTasks) {
+  EventLoopRunDeadline::Run([] {
+    BudgetState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    st.now_us = 1000000;
+    st.step_us = 1000;
+    odin_event_loop_test_set_now_us(st.loop, st.now_us);
+    odin_event_loop_budget_t budget = {};
+    budget.phase_us = 1500;
+    odin_event_loop_set_budget(st.loop, &budget);
+    st.stop_after = 4;
+    BudgetCall timer_calls[3] = {{&st, 'X'}, {&st, 'Y'}, {&st, 'Z'}};
+    odin_event_timer_t *timers[3] = {};
+    for (int i = 0; i < 3; ++i) {
+      AssertOk(odin_event_timer_start(st.loop, static_cast<uint64_t>(i), 0,
+                                      i == 0 ? PostingTimer : BudgetTimer,
+                                      &timer_calls[i], &timers[i]));
+    }
+    st.now_us += 10;
+    odin_event_loop_test_set_now_us(st.loop, st.now_us);
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+    EXPECT_EQ(st.order, "XYtZ");
+    EXPECT_EQ(odin_event_loop_test_live_timer_count(st.loop), 0u);
+    odin_event_loop_destroy(st.loop);
+  });
+}
+
+// RFC-047 T4 — a watch stopped while its readiness is carried never fires,
+// and its handle is freed without the carry touching it again.
+TEST(OdinEventLoopBudgetTest, T4StoppedWatchLeavesCarry) {
+  odin_event_loop_test_reset_liveness();
+  EventLoopRunDeadline::Run([] {
+    BudgetState st;
+    AssertOk(odin_event_loop_create(&st.loop));
+    odin_event_loop_budget_t budget = {};
+    budget.io_per_pass = 1;
+    odin_event_loop_set_budget(st.loop, &budget);
+    for (int i = 0; i < 2; ++i) {
+      CreateNonblockingSocketpair(st.pairs[i]);
+      WriteOne(st.pairs[i][1], 'x');
+      AssertOk(odin_event_io_start(st.loop, st.pairs[i][0], ODIN_EVENT_READ,
+                                   StopsNextIo, &st, &st.ios[i]));
+    }
+    EXPECT_EQ(odin_event_loop_run(st.loop), 0);
+    ASSERT_EQ(st.order.size(), 1u);
+    odin_event_loop_test_liveness_t live = {};
+    ExpectOk(odin_event_loop_test_liveness(&live));
+    EXPECT_EQ(live.io_handles, 1u);
+    odin_event_loop_destroy(st.loop);
+    ExpectOk(odin_event_loop_test_liveness(&live));
+    EXPECT_EQ(live.io_handles, 0u);
+    EXPECT_EQ(live.loops, 0u);
+    ClosePair(st.pairs[0]);
+    ClosePair(st.pairs[1]);
+  });
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1,1030 @@
+// odin/testing/loadgen.cpp
+//
+// End-to-end load generator for odin/docs/rfc_052_loadgen.md.
+//
+// One process runs four event loops, each on its own thread:
+//
+//   generator --TCP--> client runtime --QUIC--> server runtime --TCP--> origin
+//
+// The origin echoes, sinks, or sends a fixed-size response. The server is an
+// odin_xqc_server_runtime_t without the CLI's SSRF filter, because every
+// upstream here is on loopback. The client is an odin_xqc_client_runtime_t
+// behind a loopback listener, as odin-client runs it. The generator (the main
+// thread) opens HTTP CONNECT tunnels through the client at an open-loop
+// arrival rate, moves each tunnel's payload, and prints one JSON object on
+// stdout: setup latency percentiles measured from each tunnel's scheduled
+// arrival, goodput, CPU per tunnel for each thread, and RSS per open tunnel.
+//
+// Usage: odin-loadgen [--mode echo|sink|fixed] [--tunnels N]
+//                     [--concurrency N] [--rate PER_SEC] [--bytes N]
+//                     [--timeout-ms N] [--cert PEM] [--key PEM] [--ca PEM]
+// Defaults: echo, 1000 tunnels, 100 open at most, 200/s, 64 KiB each, 10 s;
+// the certificates default to <bindir>/gen/thor/odin_test_certs. --rate 0
+// keeps --concurrency tunnels open back to back instead.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "odin/accept_loop.h"
+#include "odin/client_xqc_runtime.h"
+#include "odin/event_loop.h"
+#include "odin/server_xqc_runtime.h"
+
+namespace {
+
+constexpr size_t kChunk = 64 * 1024;
+constexpr size_t kEchoPendingMax = 1024 * 1024;
+constexpr uint64_t kTickUs = 1000;
+
+enum class Mode { kEcho, kSink, kFixed };
+
+struct Options {
+  Mode mode = Mode::kEcho;
+  size_t tunnels = 1000;
+  size_t concurrency = 100;
+  double rate = 200.0;
+  size_t bytes = 64 * 1024;
+  uint64_t timeout_ms = 10000;
+  std::string cert;
+  std::string key;
+  std::string ca;
+};
+
+const char *ModeName(Mode mode) {
+  switch (mode) {
+  case Mode::kEcho:
+    return "echo";
+  case Mode::kSink:
+    return "sink";
+  case Mode::kFixed:
+    return "fixed";
+  }
+  return "?";
+}
+
+uint64_t NowUs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+bool SetNonblock(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+struct sockaddr_in Loopback4(uint16_t port) {
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  return addr;
+}
+
+// Binds a nonblocking loopback TCP listener on an ephemeral port.
+int OpenListener(uint16_t *port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  const int one = 1;
+  (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = Loopback4(0);
+  socklen_t len = sizeof(addr);
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) !=
+          0 ||
+      listen(fd, SOMAXCONN) != 0 || !SetNonblock(fd) ||
+      getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) != 0) {
+    const int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+uint64_t RssBytes() {
+#if defined(__linux__)
+  FILE *f = std::fopen("/proc/self/statm", "r");
+  if (f == nullptr) {
+    return 0;
+  }
+  unsigned long size = 0;
+  unsigned long resident = 0;
+  const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+  std::fclose(f);
+  if (n != 2) {
+    return 0;
+  }
+  return static_cast<uint64_t>(resident) *
+         static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+uint64_t ProcessCpuUs() {
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0) {
+    return 0;
+  }
+  const auto us = [](const struct timeval &tv) {
+    return static_cast<uint64_t>(tv.tv_sec) * 1000000u +
+           static_cast<uint64_t>(tv.tv_usec);
+  };
+  return us(ru.ru_utime) + us(ru.ru_stime);
+}
+
+// A loop on its own thread, stopped by a byte on a pipe because
+// odin_event_post is owner-thread only.
+struct Component {
+  const char *name = "";
+  std::thread thread;
+  int ctl[2] = {-1, -1};
+  odin_event_loop_t *loop = nullptr;
+  odin_event_io_t *ctl_io = nullptr;
+  std::promise<int> ready;
+  uint16_t port = 0;
+#if defined(__linux__)
+  clockid_t cpu_clock = 0;
+  bool cpu_clock_ok = false;
+#endif
+  uint64_t cpu_base_us = 0;
+  uint64_t cpu_us = 0;
+};
+
+void OnControl(odin_event_loop_t *loop, odin_event_io_t *, int fd,
+               unsigned int, void *) {
+  char c = 0;
+  (void)read(fd, &c, 1);
+  odin_event_loop_stop(loop);
+}
+
+// Creates c's loop and control watch on the calling (component) thread.
+int ComponentOpen(Component *c) {
+  if (pipe(c->ctl) != 0) {
+    return errno;
+  }
+  if (!SetNonblock(c->ctl[0]) || odin_event_loop_create(&c->loop) != 0 ||
+      odin_event_io_start(c->loop, c->ctl[0], ODIN_EVENT_READ, OnControl,
+                          nullptr, &c->ctl_io) != 0) {
+    return errno != 0 ? errno : EIO;
+  }
+  const odin_event_loop_budget_t budget = {
+      ODIN_EVENT_LOOP_DEFAULT_IO_PER_PASS,
+      ODIN_EVENT_LOOP_DEFAULT_PHASE_US,
+  };
+  odin_event_loop_set_budget(c->loop, &budget);
+  return 0;
+}
+
+void ComponentClose(Component *c) {
+  if (c->ctl_io != nullptr) {
+    odin_event_io_stop(c->ctl_io);
+    c->ctl_io = nullptr;
+  }
+  if (c->loop != nullptr) {
+    odin_event_loop_destroy(c->loop);
+    c->loop = nullptr;
+  }
+}
+
+uint64_t ComponentCpuUs(Component *c) {
+#if defined(__linux__)
+  struct timespec ts;
+  if (c->cpu_clock_ok && clock_gettime(c->cpu_clock, &ts) == 0) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000u +
+           static_cast<uint64_t>(ts.tv_nsec) / 1000u;
+  }
+#else
+  (void)c;
+#endif
+  return 0;
+}
+
+// Waits for c's thread to report its setup, and pins its CPU clock.
+int ComponentWait(Component *c) {
+  const int rc = c->ready.get_future().get();
+#if defined(__linux__)
+  if (rc == 0) {
+    c->cpu_clock_ok =
+        pthread_getcpuclockid(c->thread.native_handle(), &c->cpu_clock) == 0;
+  }
+#endif
+  return rc;
+}
+
+// The pipe is closed here, after the join, so the write never races it.
+void ComponentStop(Component *c) {
+  if (c->thread.joinable()) {
+    if (c->ctl[1] >= 0) {
+      const char q = 'q';
+      (void)write(c->ctl[1], &q, 1);
+    }
+    c->thread.join();
+  }
+  for (int &fd : c->ctl) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+// ---- origin ----------------------------------------------------------------
+
+struct Origin;
+
+struct OriginConn {
+  Origin *origin = nullptr;
+  int fd = -1;
+  odin_event_io_t *io = nullptr;
+  std::string pending; // echo: received, not yet written back
+  size_t fixed_left = 0;
+  bool read_eof = false;
+  bool shut = false;
+};
+
+struct Origin {
+  Component c;
+  Mode mode = Mode::kEcho;
+  size_t bytes = 0;
+  int listen_fd = -1;
+  odin_accept_loop_t *accept = nullptr;
+  std::vector<OriginConn *> conns;
+};
+
+char g_zeros[kChunk];
+
+void OriginConnClose(OriginConn *oc) {
+  odin_event_io_stop(oc->io);
+  close(oc->fd);
+  std::vector<OriginConn *> &all = oc->origin->conns;
+  all.erase(std::remove(all.begin(), all.end(), oc), all.end());
+  delete oc;
+}
+
+void OnOriginConn(odin_event_loop_t *, odin_event_io_t *, int fd,
+                  unsigned int events, void *user_data) {
+  OriginConn *oc = static_cast<OriginConn *>(user_data);
+  const Mode mode = oc->origin->mode;
+  if ((events & (ODIN_EVENT_READ | ODIN_EVENT_ERROR)) != 0 && !oc->read_eof) {
+    char buf[kChunk];
+    while (oc->pending.size() < kEchoPendingMax) {
+      const ssize_t n = read(fd, buf, sizeof(buf));
+      if (n > 0) {
+        if (mode == Mode::kEcho) {
+          oc->pending.append(buf, static_cast<size_t>(n));
+        }
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      oc->read_eof = true; // EOF or a reset
+      break;
+    }
+  }
+  for (;;) {
+    const char *data = nullptr;
+    size_t len = 0;
+    if (!oc->pending.empty()) {
+      data = oc->pending.data();
+      len = oc->pending.size();
+    } else if (oc->fixed_left > 0) {
+      data = g_zeros;
+      len = std::min(oc->fixed_left, sizeof(g_zeros));
+    } else {
+      break;
+    }
+    const ssize_t w = send(fd, data, len, MSG_NOSIGNAL);
+    if (w < 0 && errno == EINTR) {
+      continue;
+    }
+    if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (w <= 0) {
+      OriginConnClose(oc);
+      return;
+    }
+    if (!oc->pending.empty()) {
+      oc->pending.erase(0, static_cast<size_t>(w));
+    } else {
+      oc->fixed_left -= static_cast<size_t>(w);
+    }
+  }
+  const bool out_done = oc->pending.empty() && oc->fixed_left == 0;
+  if (out_done && !oc->shut && (mode == Mode::kFixed || oc->read_eof)) {
+    (void)shutdown(fd, SHUT_WR);
+    oc->shut = true;
+  }
+  if (out_done && oc->read_eof) {
+    OriginConnClose(oc);
+    return;
+  }
+  // Not done, so at least one of these is set.
+  unsigned int want = 0;
+  if (!oc->read_eof && oc->pending.size() < kEchoPendingMax) {
+    want |= ODIN_EVENT_READ;
+  }
+  if (!out_done) {
+    want |= ODIN_EVENT_WRITE;
+  }
+  (void)odin_event_io_update(oc->io, want);
+}
+
+void OnOriginAccept(odin_accept_loop_t *, int conn_fd, void *user_data) {
+  Origin *o = static_cast<Origin *>(user_data);
+  OriginConn *oc = new OriginConn;
+  oc->origin = o;
+  oc->fd = conn_fd;
+  oc->fixed_left = o->mode == Mode::kFixed ? o->bytes : 0;
+  unsigned int want = ODIN_EVENT_READ;
+  if (oc->fixed_left > 0) {
+    want |= ODIN_EVENT_WRITE;
+  }
+  if (odin_event_io_start(o->c.loop, conn_fd, want, OnOriginConn, oc,
+                          &oc->io) != 0) {
+    close(conn_fd);
+    delete oc;
+    return;
+  }
+  o->conns.push_back(oc);
+}
+
+void OnAcceptError(odin_accept_loop_t *, int err, void *user_data) {
+  const Component *c = static_cast<const Component *>(user_data);
+  std::fprintf(stderr, "odin-loadgen: %s accept failed: %s\n", c->name,
+               std::strerror(err));
+}
+
+void OriginThread(Origin *o) {
+  int rc = ComponentOpen(&o->c);
+  if (rc == 0) {
+    o->listen_fd = OpenListener(&o->c.port);
+    if (o->listen_fd < 0 ||
+        odin_accept_loop_create(o->c.loop, o->listen_fd, OnOriginAccept,
+                                OnAcceptError, o, &o->accept) != 0) {
+      rc = errno;
+    }
+  }
+  o->c.ready.set_value(rc);
+  if (rc == 0) {
+    (void)odin_event_loop_run(o->c.loop);
+  }
+  while (!o->conns.empty()) {
+    OriginConnClose(o->conns.back());
+  }
+  odin_accept_loop_destroy(o->accept);
+  if (o->listen_fd >= 0) {
+    close(o->listen_fd);
+  }
+  ComponentClose(&o->c);
+}
+
+// ---- odin server and client -------------------------------------------------
+
+struct Server {
+  Component c;
+  const Options *opt = nullptr;
+  odin_xqc_server_runtime_t *rt = nullptr;
+};
+
+void ServerThread(Server *s) {
+  int rc = ComponentOpen(&s->c);
+  if (rc == 0) {
+    const struct sockaddr_in local = Loopback4(0);
+    xqc_engine_ssl_config_t ssl;
+    std::memset(&ssl, 0, sizeof(ssl));
+    ssl.private_key_file = const_cast<char *>(s->opt->key.c_str());
+    ssl.cert_file = const_cast<char *>(s->opt->cert.c_str());
+    xqc_engine_callback_t callbacks;
+    std::memset(&callbacks, 0, sizeof(callbacks));
+    odin_xqc_server_runtime_config_t config;
+    std::memset(&config, 0, sizeof(config));
+    config.loop = s->c.loop;
+    config.local_addr = reinterpret_cast<const struct sockaddr *>(&local);
+    config.local_addrlen = sizeof(local);
+    config.ssl_config = &ssl;
+    config.engine_callbacks = &callbacks;
+    struct sockaddr_in bound;
+    socklen_t bound_len = sizeof(bound);
+    if (odin_xqc_server_runtime_create(&config, &s->rt) != 0 ||
+        odin_xqc_server_runtime_start(s->rt) != 0 ||
+        odin_xqc_server_runtime_local_addr(
+            s->rt, reinterpret_cast<struct sockaddr *>(&bound), &bound_len) !=
+            0) {
+      rc = errno != 0 ? errno : EIO;
+    } else {
+      s->c.port = ntohs(bound.sin_port);
+    }
+  }
+  s->c.ready.set_value(rc);
+  if (rc == 0) {
+    (void)odin_event_loop_run(s->c.loop);
+  }
+  if (s->rt != nullptr) {
+    odin_xqc_server_runtime_force_destroy(s->rt);
+    s->rt = nullptr;
+  }
+  ComponentClose(&s->c);
+}
+
+struct Client {
+  Component c;
+  const Options *opt = nullptr;
+  uint16_t server_port = 0;
+  odin_xqc_client_runtime_t *rt = nullptr;
+  int listen_fd = -1;
+  odin_accept_loop_t *accept = nullptr;
+  odin_event_timer_t *handshake_timer = nullptr;
+};
+
+// Reports the client ready once its QUIC handshake is done, so the first
+// tunnels' setup latency does not include it.
+void OnClientHandshakePoll(odin_event_loop_t *, odin_event_timer_t *timer,
+                           void *user_data) {
+  Client *cl = static_cast<Client *>(user_data);
+  odin_xqc_client_runtime_health_t st;
+  if (odin_xqc_client_runtime_health(cl->rt, &st) != 0 ||
+      st.state == ODIN_XQC_CLIENT_RUNTIME_CONNECTING) {
+    return;
+  }
+  odin_event_timer_stop(timer);
+  cl->handshake_timer = nullptr;
+  cl->c.ready.set_value(st.state == ODIN_XQC_CLIENT_RUNTIME_READY
+                            ? 0
+                            : ECONNREFUSED);
+}
+
+void OnClientAccept(odin_accept_loop_t *, int conn_fd, void *user_data) {
+  Client *cl = static_cast<Client *>(user_data);
+  if (odin_xqc_client_runtime_add_connection(cl->rt, conn_fd) != 0) {
+    close(conn_fd);
+  }
+}
+
+void ClientThread(Client *cl) {
+  int rc = ComponentOpen(&cl->c);
+  if (rc == 0) {
+    const struct sockaddr_in local = Loopback4(0);
+    const struct sockaddr_in peer = Loopback4(cl->server_port);
+    odin_xqc_client_runtime_default_config_t config;
+    std::memset(&config, 0, sizeof(config));
+    config.loop = cl->c.loop;
+    config.local_addr = reinterpret_cast<const struct sockaddr *>(&local);
+    config.local_addrlen = sizeof(local);
+    config.peer_addr = reinterpret_cast<const struct sockaddr *>(&peer);
+    config.peer_addrlen = sizeof(peer);
+    config.server_host = "localhost";
+    config.ca_file = cl->opt->ca.c_str();
+    if (odin_xqc_client_runtime_create_default(&config, &cl->rt) != 0 ||
+        odin_xqc_client_runtime_start(cl->rt) != 0) {
+      rc = errno != 0 ? errno : EIO;
+    } else {
+      cl->listen_fd = OpenListener(&cl->c.port);
+      if (cl->listen_fd < 0 ||
+          odin_accept_loop_create(cl->c.loop, cl->listen_fd, OnClientAccept,
+                                  OnAcceptError, cl, &cl->accept) != 0 ||
+          odin_event_timer_start(cl->c.loop, 0, kTickUs,
+                                 OnClientHandshakePoll, cl,
+                                 &cl->handshake_timer) != 0) {
+        rc = errno;
+      }
+    }
+  }
+  if (rc != 0) {
+    cl->c.ready.set_value(rc);
+  } else {
+    (void)odin_event_loop_run(cl->c.loop);
+  }
+  if (cl->handshake_timer != nullptr) {
+    odin_event_timer_stop(cl->handshake_timer);
+    cl->c.ready.set_value(ECANCELED);
+  }
+  odin_accept_loop_destroy(cl->accept);
+  if (cl->listen_fd >= 0) {
+    close(cl->listen_fd);
+  }
+  if (cl->rt != nullptr) {
+    odin_xqc_client_runtime_force_destroy(cl->rt);
+    cl->rt = nullptr;
+  }
+  ComponentClose(&cl->c);
+}
+
+// ---- generator --------------------------------------------------------------
+
+enum class Phase { kConnecting, kRequest, kResponse, kData };
+
+struct Gen;
+
+struct Tunnel {
+  Gen *gen = nullptr;
+  int fd = -1;
+  odin_event_io_t *io = nullptr;
+  Phase phase = Phase::kConnecting;
+  uint64_t sched_us = 0; // intended arrival, for latency
+  std::string request;
+  size_t request_off = 0;
+  std::string response;
+  size_t sent = 0;
+  size_t received = 0;
+  bool shut = false;
+};
+
+struct Gen {
+  const Options *opt = nullptr;
+  odin_event_loop_t *loop = nullptr;
+  odin_event_timer_t *tick = nullptr;
+  uint16_t client_port = 0;
+  uint16_t origin_port = 0;
+  uint64_t start_us = 0;
+  size_t arrivals = 0; // launched + shed
+  size_t shed = 0;
+  size_t completed = 0;
+  size_t failed = 0;
+  size_t peak_open = 0;
+  uint64_t payload_bytes = 0;
+  uint64_t rss_peak = 0;
+  std::vector<Tunnel *> open;
+  std::vector<uint64_t> setup_us;
+};
+
+void TunnelFinish(Tunnel *t, bool ok) {
+  Gen *g = t->gen;
+  if (ok) {
+    g->completed += 1;
+    g->payload_bytes += g->opt->mode == Mode::kFixed ? t->received : t->sent;
+  } else {
+    g->failed += 1;
+  }
+  if (t->io != nullptr) {
+    odin_event_io_stop(t->io);
+  }
+  close(t->fd);
+  g->open.erase(std::remove(g->open.begin(), g->open.end(), t), g->open.end());
+  delete t;
+}
+
+// Moves payload; returns false once the tunnel is finished.
+bool TunnelData(Tunnel *t, unsigned int events) {
+  const Options &opt = *t->gen->opt;
+  const bool sends = opt.mode != Mode::kFixed;
+  while (sends && t->sent < opt.bytes) {
+    const size_t len = std::min(opt.bytes - t->sent, sizeof(g_zeros));
+    const ssize_t w = send(t->fd, g_zeros, len, MSG_NOSIGNAL);
+    if (w < 0 && errno == EINTR) {
+      continue;
+    }
+    if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (w <= 0) {
+      TunnelFinish(t, false);
+      return false;
+    }
+    t->sent += static_cast<size_t>(w);
+  }
+  if (opt.mode == Mode::kSink && t->sent == opt.bytes && !t->shut) {
+    (void)shutdown(t->fd, SHUT_WR);
+    t->shut = true;
+  }
+  if ((events & (ODIN_EVENT_READ | ODIN_EVENT_ERROR)) != 0) {
+    char buf[kChunk];
+    for (;;) {
+      const ssize_t n = read(t->fd, buf, sizeof(buf));
+      if (n > 0) {
+        t->received += static_cast<size_t>(n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      // EOF: a sink tunnel is done once everything went out.
+      TunnelFinish(t, opt.mode == Mode::kSink ? t->sent == opt.bytes
+                                              : t->received == opt.bytes);
+      return false;
+    }
+  }
+  if (opt.mode != Mode::kSink && t->received >= opt.bytes &&
+      (!sends || t->sent == opt.bytes)) {
+    TunnelFinish(t, t->received == opt.bytes);
+    return false;
+  }
+  unsigned int want = ODIN_EVENT_READ;
+  if (sends && t->sent < opt.bytes) {
+    want |= ODIN_EVENT_WRITE;
+  }
+  (void)odin_event_io_update(t->io, want);
+  return true;
+}
+
+void OnTunnel(odin_event_loop_t *, odin_event_io_t *, int fd,
+              unsigned int events, void *user_data) {
+  Tunnel *t = static_cast<Tunnel *>(user_data);
+  if (t->phase == Phase::kConnecting) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+      TunnelFinish(t, false);
+      return;
+    }
+    t->phase = Phase::kRequest;
+  }
+  if (t->phase == Phase::kRequest) {
+    while (t->request_off < t->request.size()) {
+      const ssize_t w =
+          send(fd, t->request.data() + t->request_off,
+               t->request.size() - t->request_off, MSG_NOSIGNAL);
+      if (w < 0 && errno == EINTR) {
+        continue;
+      }
+      if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        (void)odin_event_io_update(t->io, ODIN_EVENT_WRITE);
+        return;
+      }
+      if (w <= 0) {
+        TunnelFinish(t, false);
+        return;
+      }
+      t->request_off += static_cast<size_t>(w);
+    }
+    t->phase = Phase::kResponse;
+    (void)odin_event_io_update(t->io, ODIN_EVENT_READ);
+    return;
+  }
+  if (t->phase == Phase::kResponse) {
+    char buf[1024];
+    const ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    if (n <= 0) {
+      TunnelFinish(t, false);
+      return;
+    }
+    t->response.append(buf, static_cast<size_t>(n));
+    const size_t end = t->response.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      if (t->response.size() > 4096) {
+        TunnelFinish(t, false);
+      }
+      return;
+    }
+    if (t->response.compare(0, 12, "HTTP/1.1 200") != 0) {
+      TunnelFinish(t, false);
+      return;
+    }
+    t->gen->setup_us.push_back(NowUs() - t->sched_us);
+    t->received = t->response.size() - (end + 4); // early origin bytes
+    t->response.clear();
+    t->phase = Phase::kData;
+    events = ODIN_EVENT_WRITE;
+  }
+  (void)TunnelData(t, events);
+}
+
+void Launch(Gen *g, uint64_t sched_us) {
+  Tunnel *t = new Tunnel;
+  t->gen = g;
+  t->sched_us = sched_us;
+  char req[128];
+  std::snprintf(req, sizeof(req),
+                "CONNECT 127.0.0.1:%u HTTP/1.1\r\nHost: 127.0.0.1:%u\r\n\r\n",
+                static_cast<unsigned>(g->origin_port),
+                static_cast<unsigned>(g->origin_port));
+  t->request = req;
+  t->fd = socket(AF_INET, SOCK_STREAM, 0);
+  g->open.push_back(t);
+  g->peak_open = std::max(g->peak_open, g->open.size());
+  if (t->fd < 0) {
+    g->failed += 1;
+    g->open.pop_back();
+    delete t;
+    return;
+  }
+  if (!SetNonblock(t->fd)) {
+    TunnelFinish(t, false);
+    return;
+  }
+  const struct sockaddr_in addr = Loopback4(g->client_port);
+  if (connect(t->fd, reinterpret_cast<const struct sockaddr *>(&addr),
+              sizeof(addr)) != 0 &&
+      errno != EINPROGRESS) {
+    TunnelFinish(t, false);
+    return;
+  }
+  if (odin_event_io_start(g->loop, t->fd, ODIN_EVENT_WRITE, OnTunnel, t,
+                          &t->io) != 0) {
+    t->io = nullptr;
+    TunnelFinish(t, false);
+  }
+}
+
+void OnTick(odin_event_loop_t *loop, odin_event_timer_t *, void *user_data) {
+  Gen *g = static_cast<Gen *>(user_data);
+  const Options &opt = *g->opt;
+  const uint64_t now = NowUs();
+  g->rss_peak = std::max(g->rss_peak, RssBytes());
+  // Open loop: every arrival due by now, on schedule, whatever is open.
+  // Closed loop (--rate 0): refill to the concurrency limit.
+  while (g->arrivals < opt.tunnels) {
+    uint64_t sched = now;
+    if (opt.rate > 0) {
+      sched = g->start_us + static_cast<uint64_t>(
+                                static_cast<double>(g->arrivals) * 1e6 /
+                                opt.rate);
+      if (sched > now) {
+        break;
+      }
+    } else if (g->open.size() >= opt.concurrency) {
+      break;
+    }
+    g->arrivals += 1;
+    if (g->open.size() >= opt.concurrency) {
+      g->shed += 1;
+      continue;
+    }
+    Launch(g, sched);
+  }
+  const uint64_t timeout_us = opt.timeout_ms * 1000u;
+  for (size_t i = g->open.size(); i > 0; --i) {
+    Tunnel *t = g->open[i - 1];
+    if (now - t->sched_us > timeout_us) {
+      TunnelFinish(t, false);
+    }
+  }
+  if (g->arrivals == opt.tunnels && g->open.empty()) {
+    odin_event_loop_stop(loop);
+  }
+}
+
+// ---- report -----------------------------------------------------------------
+
+uint64_t Percentile(const std::vector<uint64_t> &sorted, double q) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t i = static_cast<size_t>(q * static_cast<double>(sorted.size()));
+  if (i >= sorted.size()) {
+    i = sorted.size() - 1;
+  }
+  return sorted[i];
+}
+
+double PerTunnel(uint64_t v, size_t tunnels) {
+  return tunnels == 0 ? 0.0
+                      : static_cast<double>(v) / static_cast<double>(tunnels);
+}
+
+std::string Dirname(const char *path) {
+  const std::string s(path);
+  const size_t slash = s.rfind('/');
+  return slash == std::string::npos ? "." : s.substr(0, slash);
+}
+
+bool ParseSize(const char *s, size_t *out) {
+  char *end = nullptr;
+  errno = 0;
+  const unsigned long long v = std::strtoull(s, &end, 10);
+  if (errno != 0 || end == s || *end != '\0') {
+    return false;
+  }
+  *out = static_cast<size_t>(v);
+  return true;
+}
+
+int Usage() {
+  std::fprintf(stderr,
+               "usage: odin-loadgen [--mode echo|sink|fixed] [--tunnels N] "
+               "[--concurrency N] [--rate PER_SEC] [--bytes N] "
+               "[--timeout-ms N] [--cert PEM] [--key PEM] [--ca PEM]\n");
+  return 2;
+}
+
+int ParseArgs(int argc, char **argv, Options *opt) {
+  const std::string certs = Dirname(argv[0]) + "/gen/thor/odin_test_certs";
+  opt->cert = certs + "/odin-server.pem";
+  opt->key = certs + "/odin-test-leaf-key.pem";
+  opt->ca = certs + "/root-ca.pem";
+  for (int i = 1; i < argc; i += 2) {
+    const std::string flag = argv[i];
+    if (i + 1 >= argc) {
+      return -1;
+    }
+    const char *v = argv[i + 1];
+    size_t n = 0;
+    if (flag == "--mode") {
+      const std::string m = v;
+      if (m == "echo") {
+        opt->mode = Mode::kEcho;
+      } else if (m == "sink") {
+        opt->mode = Mode::kSink;
+      } else if (m == "fixed") {
+        opt->mode = Mode::kFixed;
+      } else {
+        return -1;
+      }
+    } else if (flag == "--tunnels" && ParseSize(v, &n)) {
+      opt->tunnels = n;
+    } else if (flag == "--concurrency" && ParseSize(v, &n) && n > 0) {
+      opt->concurrency = n;
+    } else if (flag == "--rate") {
+      char *end = nullptr;
+      opt->rate = std::strtod(v, &end);
+      if (end == v || *end != '\0' || opt->rate < 0) {
+        return -1;
+      }
+    } else if (flag == "--bytes" && ParseSize(v, &n)) {
+      opt->bytes = n;
+    } else if (flag == "--timeout-ms" && ParseSize(v, &n) && n > 0) {
+      opt->timeout_ms = n;
+    } else if (flag == "--cert") {
+      opt->cert = v;
+    } else if (flag == "--key") {
+      opt->key = v;
+    } else if (flag == "--ca") {
+      opt->ca = v;
+    } else {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Each tunnel holds about four descriptors across the pipeline.
+void RaiseFdLimit() {
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur = rl.rlim_max;
+    (void)setrlimit(RLIMIT_NOFILE, &rl);
+  }
+}
+
+void PrintReport(const Options &opt, Gen *g, double secs,
+                 const std::vector<Component *> &parts, uint64_t gen_cpu_us,
+                 uint64_t process_cpu_us, uint64_t rss_base) {
+  std::sort(g->setup_us.begin(), g->setup_us.end());
+  const size_t launched = opt.tunnels - g->shed;
+  const uint64_t rss_grow = g->rss_peak > rss_base ? g->rss_peak - rss_base : 0;
+  std::printf("{\n");
+  std::printf("  \"mode\": \"%s\",\n", ModeName(opt.mode));
+  std::printf("  \"tunnels\": %zu,\n  \"concurrency\": %zu,\n", opt.tunnels,
+              opt.concurrency);
+  std::printf("  \"rate_per_sec\": %.1f,\n  \"bytes_per_tunnel\": %zu,\n",
+              opt.rate, opt.bytes);
+  std::printf("  \"completed\": %zu,\n  \"failed\": %zu,\n  \"shed\": %zu,\n",
+              g->completed, g->failed, g->shed);
+  std::printf("  \"peak_open_tunnels\": %zu,\n", g->peak_open);
+  std::printf("  \"duration_s\": %.3f,\n", secs);
+  std::printf("  \"setup_latency_us\": {\"p50\": %" PRIu64 ", \"p90\": %" PRIu64
+              ", \"p99\": %" PRIu64 ", \"p999\": %" PRIu64 ", \"max\": %" PRIu64
+              "},\n",
+              Percentile(g->setup_us, 0.50), Percentile(g->setup_us, 0.90),
+              Percentile(g->setup_us, 0.99), Percentile(g->setup_us, 0.999),
+              g->setup_us.empty() ? 0 : g->setup_us.back());
+  std::printf("  \"payload_bytes\": %" PRIu64 ",\n", g->payload_bytes);
+  std::printf("  \"goodput_mbps\": %.2f,\n",
+              secs > 0 ? static_cast<double>(g->payload_bytes) * 8.0 /
+                             (secs * 1e6)
+                       : 0.0);
+  std::printf("  \"cpu_us_per_tunnel\": {");
+  uint64_t odin_cpu_us = 0;
+  for (const Component *c : parts) {
+    std::printf("\"%s\": %.1f, ", c->name, PerTunnel(c->cpu_us, launched));
+    if (std::strcmp(c->name, "origin") != 0) {
+      odin_cpu_us += c->cpu_us;
+    }
+  }
+  std::printf("\"generator\": %.1f, \"odin\": %.1f, \"process\": %.1f},\n",
+              PerTunnel(gen_cpu_us, launched),
+              PerTunnel(odin_cpu_us, launched),
+              PerTunnel(process_cpu_us, launched));
+  std::printf("  \"rss_bytes\": {\"baseline\": %" PRIu64 ", \"peak\": %" PRIu64
+              "},\n",
+              rss_base, g->rss_peak);
+  std::printf("  \"rss_bytes_per_open_tunnel\": %.1f\n",
+              PerTunnel(rss_grow, g->peak_open));
+  std::printf("}\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (ParseArgs(argc, argv, &opt) != 0) {
+    return Usage();
+  }
+  (void)signal(SIGPIPE, SIG_IGN);
+  RaiseFdLimit();
+
+  Origin origin;
+  origin.c.name = "origin";
+  origin.mode = opt.mode;
+  origin.bytes = opt.bytes;
+  Server server;
+  server.c.name = "server";
+  server.opt = &opt;
+  Client client;
+  client.c.name = "client";
+  client.opt = &opt;
+
+  origin.c.thread = std::thread(OriginThread, &origin);
+  server.c.thread = std::thread(ServerThread, &server);
+  int rc = ComponentWait(&origin.c);
+  const int server_rc = ComponentWait(&server.c);
+  rc = rc != 0 ? rc : server_rc;
+  if (rc == 0) {
+    client.server_port = server.c.port;
+    client.c.thread = std::thread(ClientThread, &client);
+    rc = ComponentWait(&client.c);
+  }
+  Gen gen;
+  gen.opt = &opt;
+  if (rc == 0 && odin_event_loop_create(&gen.loop) != 0) {
+    rc = errno;
+  }
+  if (rc != 0) {
+    std::fprintf(stderr, "odin-loadgen: startup failed: %s\n",
+                 std::strerror(rc));
+    ComponentStop(&client.c);
+    ComponentStop(&server.c);
+    ComponentStop(&origin.c);
+    return 1;
+  }
+  gen.client_port = client.c.port;
+  gen.origin_port = origin.c.port;
+
+  std::vector<Component *> parts = {&client.c, &server.c, &origin.c};
+  for (Component *c : parts) {
+    c->cpu_base_us = ComponentCpuUs(c);
+  }
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  const uint64_t gen_cpu_base = static_cast<uint64_t>(ts.tv_sec) * 1000000u +
+                                static_cast<uint64_t>(ts.tv_nsec) / 1000u;
+  const uint64_t process_cpu_base = ProcessCpuUs();
+  const uint64_t rss_base = RssBytes();
+  gen.rss_peak = rss_base;
+  gen.start_us = NowUs();
+  if (odin_event_timer_start(gen.loop, 0, kTickUs, OnTick, &gen, &gen.tick) !=
+          0 ||
+      odin_event_loop_run(gen.loop) != 0) {
+    std::perror("odin-loadgen: generator");
+    rc = 1;
+  }
+  const double secs = static_cast<double>(NowUs() - gen.start_us) / 1e6;
+  for (Component *c : parts) {
+    c->cpu_us = ComponentCpuUs(c) - c->cpu_base_us;
+  }
+  (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  const uint64_t gen_cpu_us = static_cast<uint64_t>(ts.tv_sec) * 1000000u +
+                              static_cast<uint64_t>(ts.tv_nsec) / 1000u -
+                              gen_cpu_base;
+  const uint64_t process_cpu_us = ProcessCpuUs() - process_cpu_base;
+
+  while (!gen.open.empty()) {
+    TunnelFinish(gen.open.back(), false);
+  }
+  if (gen.tick != nullptr) {
+    odin_event_timer_stop(gen.tick);
+  }
+  odin_event_loop_destroy(gen.loop);
+  ComponentStop(&client.c);
+  ComponentStop(&server.c);
+  ComponentStop(&origin.c);
+
+  PrintReport(opt, &gen, secs, parts, gen_cpu_us, process_cpu_us, rss_base);
+  return rc == 0 && gen.failed == 0 ? 0 : 1;
+}
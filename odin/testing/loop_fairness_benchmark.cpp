@@ -0,0 +1,227 @@
+// odin/testing/loop_fairness_benchmark.cpp
+//
+// Timer lateness under bulk load for odin/docs/rfc_047_fair_dispatch.md §5.
+//
+// Runs several fd-fd relays over AF_UNIX socket pairs on one loop, each fed
+// by a writer thread and drained by a reader thread as fast as they can, plus
+// a 1 ms repeating timer. The loop's RFC-046 instrumentation records how late
+// that timer fires. Each pass prints aggregate MiB/s and timer lateness
+// (p50, p99, max), first without budgets and then with the defaults the CLI
+// runners use.
+//
+// Usage: odin_loop_fairness_benchmark [MiB per flow] [flows] (default 256 8).
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "odin/event_loop.h"
+#include "odin/relay.h"
+#include "odin/transport.h"
+#include "odin/transport_fd.h"
+
+namespace {
+
+struct Bench;
+
+struct Flow {
+  Bench *bench = nullptr;
+  odin_relay_t *relay = nullptr;
+  odin_transport_t *ends[2] = {nullptr, nullptr};
+  int sa[2] = {-1, -1};
+  int sb[2] = {-1, -1};
+  size_t got = 0;
+  bool ok = false;
+};
+
+struct Bench {
+  odin_event_loop_t *loop = nullptr;
+  size_t remaining = 0;
+};
+
+void OnReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  Flow *flow = static_cast<Flow *>(user_data);
+  odin_relay_ready(t, events, flow->relay);
+}
+
+void OnDone(odin_relay_t *, odin_relay_status_t status, int, void *user_data) {
+  Flow *flow = static_cast<Flow *>(user_data);
+  flow->ok = status == ODIN_RELAY_OK;
+  flow->bench->remaining -= 1;
+  if (flow->bench->remaining == 0) {
+    odin_event_loop_stop(flow->bench->loop);
+  }
+}
+
+void OnTick(odin_event_loop_t *, odin_event_timer_t *, void *) {}
+
+bool SetNonblock(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void Writer(int fd, size_t total) {
+  static char chunk[65536];
+  size_t off = 0;
+  while (off < total) {
+    size_t n = total - off;
+    if (n > sizeof(chunk)) {
+      n = sizeof(chunk);
+    }
+    const ssize_t w = write(fd, chunk, n);
+    if (w < 0 && errno == EINTR) {
+      continue;
+    }
+    if (w <= 0) {
+      break;
+    }
+    off += static_cast<size_t>(w);
+  }
+  (void)shutdown(fd, SHUT_WR);
+}
+
+void Reader(int fd, size_t *got) {
+  char chunk[65536];
+  for (;;) {
+    const ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n > 0) {
+      *got += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    break;
+  }
+}
+
+// Upper bound of the bucket holding the q-th quantile.
+uint64_t Quantile(const odin_event_loop_hist_t &h, double q) {
+  const uint64_t want = static_cast<uint64_t>(q * static_cast<double>(h.count));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < ODIN_EVENT_LOOP_HIST_BUCKETS; ++i) {
+    seen += h.buckets[i];
+    if (seen > want) {
+      return i == 0 ? 0 : (uint64_t{1} << i);
+    }
+  }
+  return h.max_us;
+}
+
+int Run(const char *name, const odin_event_loop_budget_t *budget,
+        size_t total, size_t flows) {
+  Bench bench;
+  if (odin_event_loop_create(&bench.loop) != 0 ||
+      odin_event_loop_enable_stats(bench.loop, nullptr) != 0) {
+    std::perror("loop");
+    return -1;
+  }
+  odin_event_loop_set_budget(bench.loop, budget);
+  std::vector<Flow> all(flows);
+  for (Flow &f : all) {
+    f.bench = &bench;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, f.sa) != 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM, 0, f.sb) != 0 ||
+        !SetNonblock(f.sa[1]) || !SetNonblock(f.sb[1])) {
+      std::perror("socketpair");
+      return -1;
+    }
+    (void)shutdown(f.sb[0], SHUT_WR); // b -> a carries nothing
+    if (odin_relay_create(OnDone, &f, &f.relay) != 0 ||
+        odin_fd_transport_create(bench.loop, f.sa[1], OnReady, &f,
+                                 &f.ends[0]) != 0 ||
+        odin_fd_transport_create(bench.loop, f.sb[1], OnReady, &f,
+                                 &f.ends[1]) != 0 ||
+        odin_relay_start(f.relay, f.ends[0], f.ends[1]) != 0) {
+      std::perror("relay");
+      return -1;
+    }
+  }
+  bench.remaining = flows;
+  odin_event_timer_t *tick = nullptr;
+  if (odin_event_timer_start(bench.loop, 1000, 1000, OnTick, nullptr, &tick) !=
+      0) {
+    std::perror("timer");
+    return -1;
+  }
+
+  std::vector<std::thread> threads;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (Flow &f : all) {
+    threads.emplace_back(Writer, f.sa[0], total);
+    threads.emplace_back(Reader, f.sb[0], &f.got);
+  }
+  if (odin_event_loop_run(bench.loop) != 0) {
+    std::perror("run");
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+
+  odin_event_loop_stats_t stats;
+  odin_event_loop_stats(bench.loop, &stats);
+  size_t got = 0;
+  bool ok = true;
+  for (Flow &f : all) {
+    got += f.got;
+    ok = ok && f.ok && f.got == total;
+  }
+  const double secs = std::chrono::duration<double>(t1 - t0).count();
+  const double mib = static_cast<double>(got) / (1024.0 * 1024.0);
+  const odin_event_loop_hist_t &late = stats.timer_lateness;
+  std::printf("%-8s %8.1f MiB/s  lateness p50 <%6llu us  p99 <%6llu us  "
+              "max %6llu us  ticks %llu  %s\n",
+              name, mib / secs,
+              static_cast<unsigned long long>(Quantile(late, 0.50)),
+              static_cast<unsigned long long>(Quantile(late, 0.99)),
+              static_cast<unsigned long long>(late.max_us),
+              static_cast<unsigned long long>(late.count),
+              ok ? "ok" : "FAILED");
+
+  odin_event_timer_stop(tick);
+  for (Flow &f : all) {
+    odin_relay_destroy(f.relay);
+    odin_transport_destroy(f.ends[0]);
+    odin_transport_destroy(f.ends[1]);
+    for (int fd : {f.sa[0], f.sa[1], f.sb[0], f.sb[1]}) {
+      close(fd);
+    }
+  }
+  odin_event_loop_destroy(bench.loop);
+  return ok ? 0 : -1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t mib = 256;
+  size_t flows = 8;
+  if (argc > 1) {
+    mib = static_cast<size_t>(std::strtoul(argv[1], nullptr, 10));
+  }
+  if (argc > 2) {
+    flows = static_cast<size_t>(std::strtoul(argv[2], nullptr, 10));
+  }
+  const size_t total = mib * 1024 * 1024;
+  odin_event_loop_budget_t budget = {};
+  budget.io_per_pass = ODIN_EVENT_LOOP_DEFAULT_IO_PER_PASS;
+  budget.phase_us = ODIN_EVENT_LOOP_DEFAULT_PHASE_US;
+  int rc = 0;
+  if (Run("none", nullptr, total, flows) != 0) {
+    rc = 1;
+  }
+  if (Run("budget", &budget, total, flows) != 0) {
+    rc = 1;
+  }
+  return rc;
+}
@@ -0,0 +1,28 @@
+/* odin/testing/original_dst_internal_test.h */
+
+#ifndef ODIN_ORIGINAL_DST_INTERNAL_TEST_H_
+#define ODIN_ORIGINAL_DST_INTERNAL_TEST_H_
+
+#if defined(ODIN_ORIGINAL_DST_TESTING)
+
+#include <sys/socket.h>
+
+#include "odin/original_dst.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Loopback redirect stub: the next conntrack lookup reports dst, as if an
+ * iptables REDIRECT rule had rewritten a connection to dst. Linux only;
+ * process-wide, one-shot. Returns 0, or -1 with errno EINVAL. */
+int odin_original_dst_test_redirect_next(const struct sockaddr *dst,
+                                         socklen_t dst_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(ODIN_ORIGINAL_DST_TESTING) */
+
+#endif /* ODIN_ORIGINAL_DST_INTERNAL_TEST_H_ */
@@ -0,0 +1 @@
+#include "odin/original_dst.c" // NOLINT(bugprone-suspicious-include)
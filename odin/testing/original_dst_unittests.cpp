@@ -0,0 +1,143 @@
+// odin/testing/original_dst_unittests.cpp
+//
+// Unit tests T1-T3 from §5 of odin/docs/rfc_040_transparent_proxy.md.
+//
+// Uses real loopback connections. No iptables rule is installed: T2 stands
+// in for REDIRECT with the conntrack stub, and T1 treats a connection
+// accepted on one listener as if TPROXY had delivered it to another.
+
+#include "odin/original_dst.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "odin/testing/original_dst_internal_test.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+struct sockaddr_in Loopback(uint16_t port) {
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  return addr;
+}
+
+// A loopback listener, one client connected to it, and the accepted socket.
+class OdinOriginalDstTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listen_fd_, 0) << std::strerror(errno);
+    listen_addr_ = Loopback(0);
+    socklen_t len = sizeof(listen_addr_);
+    ASSERT_EQ(bind(listen_fd_, reinterpret_cast<sockaddr *>(&listen_addr_),
+                   sizeof(listen_addr_)),
+              0);
+    ASSERT_EQ(listen(listen_fd_, 1), 0);
+    ASSERT_EQ(getsockname(listen_fd_,
+                          reinterpret_cast<sockaddr *>(&listen_addr_), &len),
+              0);
+    client_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(client_fd_, 0);
+    ASSERT_EQ(connect(client_fd_, reinterpret_cast<sockaddr *>(&listen_addr_),
+                      sizeof(listen_addr_)),
+              0)
+        << std::strerror(errno);
+    conn_fd_ = accept(listen_fd_, nullptr, nullptr);
+    ASSERT_GE(conn_fd_, 0) << std::strerror(errno);
+  }
+
+  void TearDown() override {
+    for (int fd : {conn_fd_, client_fd_, listen_fd_}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  int Get(const struct sockaddr_in &listener, struct sockaddr_in *out) {
+    struct sockaddr_storage dst;
+    socklen_t dst_len = 0;
+    const int rc = odin_original_dst_get(
+        conn_fd_, reinterpret_cast<const sockaddr *>(&listener),
+        sizeof(listener), &dst, &dst_len);
+    if (rc == 0) {
+      EXPECT_EQ(dst_len, sizeof(*out));
+      std::memcpy(out, &dst, sizeof(*out));
+    }
+    return rc;
+  }
+
+  int listen_fd_ = -1;
+  int client_fd_ = -1;
+  int conn_fd_ = -1;
+  struct sockaddr_in listen_addr_{};
+};
+
+// T1: with no conntrack entry, the accepted socket's local address is the
+// destination (TPROXY); here the "proxy" listens elsewhere.
+TEST_F(OdinOriginalDstTest, T1LocalAddressIsDestination) {
+  struct sockaddr_in got{};
+  ASSERT_EQ(Get(Loopback(1), &got), 0) << std::strerror(errno);
+  EXPECT_EQ(got.sin_family, AF_INET);
+  EXPECT_EQ(got.sin_addr.s_addr, htonl(INADDR_LOOPBACK));
+  EXPECT_EQ(got.sin_port, listen_addr_.sin_port);
+}
+
+// T2: a conntrack answer (REDIRECT) wins over the local address.
+TEST_F(OdinOriginalDstTest, T2RedirectStubReportsOriginal) {
+#if defined(__linux__)
+  struct sockaddr_in original = Loopback(8443);
+  original.sin_addr.s_addr = htonl(0xC0000201); // 192.0.2.1
+  ASSERT_EQ(odin_original_dst_test_redirect_next(
+                reinterpret_cast<const sockaddr *>(&original),
+                sizeof(original)),
+            0);
+  struct sockaddr_in got{};
+  ASSERT_EQ(Get(listen_addr_, &got), 0) << std::strerror(errno);
+  EXPECT_EQ(got.sin_addr.s_addr, original.sin_addr.s_addr);
+  EXPECT_EQ(ntohs(got.sin_port), 8443);
+#else
+  GTEST_SKIP() << "SO_ORIGINAL_DST is Linux-only";
+#endif
+}
+
+// T3: a connection made straight to the listener is refused with ELOOP, for
+// an exact and a wildcard listener address; bad arguments are EINVAL.
+TEST_F(OdinOriginalDstTest, T3DirectConnectionIsLoop) {
+  struct sockaddr_in got{};
+  errno = 0;
+  EXPECT_EQ(Get(listen_addr_, &got), -1);
+  EXPECT_EQ(errno, ELOOP);
+
+  struct sockaddr_in wildcard = listen_addr_;
+  wildcard.sin_addr.s_addr = htonl(INADDR_ANY);
+  errno = 0;
+  EXPECT_EQ(Get(wildcard, &got), -1);
+  EXPECT_EQ(errno, ELOOP);
+
+  struct sockaddr_storage dst;
+  socklen_t dst_len = 0;
+  errno = 0;
+  EXPECT_EQ(odin_original_dst_get(
+                conn_fd_, reinterpret_cast<const sockaddr *>(&listen_addr_),
+                sizeof(listen_addr_) - 1u, &dst, &dst_len),
+            -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(odin_original_dst_get(conn_fd_, nullptr, 0, &dst, &dst_len), -1);
+  EXPECT_EQ(errno, EINVAL);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
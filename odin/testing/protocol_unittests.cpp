@@ -1,8 +1,9 @@
 // odin/testing/protocol_unittests.cpp
 //
-// Unit tests from RFC-001, RFC-004, and RFC-005 for the Odin control-frame
-// codec. The zero-copy request codec and fixed-frame response encoder own
-// request encode/decode and response encode coverage.
+// Unit tests from RFC-001, RFC-004, RFC-005, and RFC-045 for the Odin
+// control-frame codec. The zero-copy request codec and fixed-frame response
+// encoder own request encode/decode and response encode coverage; the DNS
+// frames encode into flat buffers.
 
 #include "odin/protocol.h"
 
@@ -451,3 +452,109 @@ TEST(OdinProtoRespTest, T3DecoderInteropAndTrailing) {
       std::memcmp(&buffer[ODIN_PROTO_CONNECT_RESP_SIZE], saved_trailing, 100),
       0);
 }
+
+// RFC-045 T1 — DNS_QUERY and DNS_ANSWER round-trip byte-exact and leave
+// trailing bytes for the next frame.
+TEST(OdinProtoDnsTest, T1QueryAndAnswerRoundTrip) {
+  uint8_t buf[ODIN_PROTO_DNS_QUERY_MAX + 8];
+  size_t len = 0;
+  ASSERT_EQ(odin_proto_encode_dns_query(0xBEEF, ODIN_PROTO_DNS_FAMILY_V6,
+                                        "example.com", 11, buf, sizeof(buf),
+                                        &len),
+            ODIN_PROTO_OK);
+  const uint8_t want_query[] = {0x01, 0x03, 0xBE, 0xEF, 0x06, 0x0B};
+  ASSERT_EQ(len, sizeof(want_query) + 11);
+  EXPECT_EQ(std::memcmp(buf, want_query, sizeof(want_query)), 0);
+  buf[len] = 0x01;
+
+  size_t consumed = kSentinelSize;
+  odin_proto_dns_query_view_t q = {};
+  ASSERT_EQ(odin_proto_decode_dns_query(buf, len + 1, &consumed, &q),
+            ODIN_PROTO_OK);
+  EXPECT_EQ(consumed, len);
+  EXPECT_EQ(q.id, 0xBEEF);
+  EXPECT_EQ(q.family, ODIN_PROTO_DNS_FAMILY_V6);
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(buf) + q.name_off,
+                        q.name_len),
+            "example.com");
+
+  const uint8_t addrs[] = {192, 0, 2, 1, 192, 0, 2, 2};
+  uint8_t ans[ODIN_PROTO_DNS_ANSWER_MAX];
+  ASSERT_EQ(odin_proto_encode_dns_answer(7, ODIN_PROTO_DNS_FAMILY_V4,
+                                         ODIN_PROTO_DNS_RCODE_OK, 0x01020304,
+                                         addrs, 2, ans, sizeof(ans), &len),
+            ODIN_PROTO_OK);
+  const uint8_t want_answer[] = {0x01, 0x04, 0x00, 0x07, 0x04, 0x00,
+                                 0x01, 0x02, 0x03, 0x04, 0x02};
+  ASSERT_EQ(len, sizeof(want_answer) + sizeof(addrs));
+  EXPECT_EQ(std::memcmp(ans, want_answer, sizeof(want_answer)), 0);
+
+  odin_proto_dns_answer_view_t a = {};
+  ASSERT_EQ(odin_proto_decode_dns_answer(ans, len, &consumed, &a),
+            ODIN_PROTO_OK);
+  EXPECT_EQ(consumed, len);
+  EXPECT_EQ(a.id, 7);
+  EXPECT_EQ(a.rcode, ODIN_PROTO_DNS_RCODE_OK);
+  EXPECT_EQ(a.ttl, 0x01020304u);
+  EXPECT_EQ(a.count, 2u);
+  EXPECT_EQ(std::memcmp(ans + a.addrs_off, addrs, sizeof(addrs)), 0);
+}
+
+// RFC-045 T2 — DNS frames reject bad fields, short buffers, and each other's
+// frame types, and report NEED_MORE on every proper prefix.
+TEST(OdinProtoDnsTest, T2RejectsBadFramesAndPrefixes) {
+  uint8_t buf[ODIN_PROTO_DNS_ANSWER_MAX];
+  size_t len = kSentinelSize;
+  EXPECT_EQ(odin_proto_encode_dns_query(1, 5, "a", 1, buf, sizeof(buf), &len),
+            ODIN_PROTO_ERR_BAD_FAMILY);
+  EXPECT_EQ(odin_proto_encode_dns_query(1, ODIN_PROTO_DNS_FAMILY_V4, "a", 0,
+                                        buf, sizeof(buf), &len),
+            ODIN_PROTO_ERR_HOST_LEN_INVALID);
+  EXPECT_EQ(odin_proto_encode_dns_query(1, ODIN_PROTO_DNS_FAMILY_V4, "ab", 2,
+                                        buf, 7, &len),
+            ODIN_PROTO_ERR_BUF_TOO_SMALL);
+  EXPECT_EQ(odin_proto_encode_dns_answer(1, ODIN_PROTO_DNS_FAMILY_V4, 0, 0,
+                                         buf, ODIN_PROTO_DNS_ADDR_MAX + 1, buf,
+                                         sizeof(buf), &len),
+            ODIN_PROTO_ERR_BAD_COUNT);
+  EXPECT_EQ(len, kSentinelSize);
+
+  ASSERT_EQ(odin_proto_encode_dns_query(9, ODIN_PROTO_DNS_FAMILY_V4, "host", 4,
+                                        buf, sizeof(buf), &len),
+            ODIN_PROTO_OK);
+  size_t consumed = kSentinelSize;
+  odin_proto_dns_query_view_t q = {};
+  for (size_t n = 0; n < len; ++n) {
+    EXPECT_EQ(odin_proto_decode_dns_query(buf, n, &consumed, &q),
+              ODIN_PROTO_NEED_MORE)
+        << n;
+  }
+  odin_proto_dns_answer_view_t a = {};
+  EXPECT_EQ(odin_proto_decode_dns_answer(buf, len, &consumed, &a),
+            ODIN_PROTO_ERR_BAD_FRAME_TYPE);
+  odin_proto_connect_req_view_t req = {};
+  EXPECT_EQ(odin_proto_decode_connect_req(buf, len, &consumed, &req),
+            ODIN_PROTO_ERR_BAD_FRAME_TYPE);
+  buf[4] = 0;
+  EXPECT_EQ(odin_proto_decode_dns_query(buf, len, &consumed, &q),
+            ODIN_PROTO_ERR_BAD_FAMILY);
+  buf[4] = ODIN_PROTO_DNS_FAMILY_V4;
+  buf[5] = 0;
+  EXPECT_EQ(odin_proto_decode_dns_query(buf, len, &consumed, &q),
+            ODIN_PROTO_ERR_HOST_LEN_INVALID);
+
+  ASSERT_EQ(odin_proto_encode_dns_answer(9, ODIN_PROTO_DNS_FAMILY_V6,
+                                         ODIN_PROTO_DNS_RCODE_FAIL, 0, nullptr,
+                                         0, buf, sizeof(buf), &len),
+            ODIN_PROTO_OK);
+  EXPECT_EQ(len, static_cast<size_t>(ODIN_PROTO_DNS_ANSWER_HEADER_SIZE));
+  for (size_t n = 0; n < len; ++n) {
+    EXPECT_EQ(odin_proto_decode_dns_answer(buf, n, &consumed, &a),
+              ODIN_PROTO_NEED_MORE)
+        << n;
+  }
+  buf[10] = ODIN_PROTO_DNS_ADDR_MAX + 1;
+  EXPECT_EQ(odin_proto_decode_dns_answer(buf, len, &consumed, &a),
+            ODIN_PROTO_ERR_BAD_COUNT);
+  EXPECT_EQ(consumed, kSentinelSize);
+}
@@ -0,0 +1 @@
+#include "odin/qlog.c" // NOLINT(bugprone-suspicious-include)
@@ -0,0 +1,353 @@
+// odin/testing/qlog_unittests.cpp
+//
+// Unit tests T1-T5 from §5 of odin/docs/rfc_050_qlog.md.
+//
+// Every test feeds odin_qlog_conn_begin and odin_qlog_event directly, as the
+// runtimes and odin_xqc_udp_t would, and reads back the files the writer
+// thread produces in a fresh directory under /tmp; nothing here needs xquic
+// or an event loop.
+
+#include "odin/qlog.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+constexpr char kServerHeader[] =
+    "\x1e{\"qlog_version\":\"0.3\",\"qlog_format\":\"JSON-SEQ\","
+    "\"title\":\"odin\",\"trace\":{\"vantage_point\":{\"type\":\"server\"},"
+    "\"common_fields\":{\"time_format\":\"absolute\"}}}\n";
+
+// A fresh directory holding one qlog path and its rotated files.
+class QlogDir {
+public:
+  QlogDir() {
+    char templ[] = "/tmp/odin_qlog.XXXXXX";
+    if (mkdtemp(templ) != nullptr) {
+      dir_ = templ;
+    }
+    path_ = dir_ + "/trace.sqlog";
+  }
+  ~QlogDir() {
+    (void)std::remove(path_.c_str());
+    for (int i = 1; i <= 8; ++i) {
+      (void)std::remove(Rotated(i).c_str());
+    }
+    (void)rmdir(dir_.c_str());
+  }
+  QlogDir(const QlogDir &) = delete;
+  QlogDir &operator=(const QlogDir &) = delete;
+
+  bool ok() const { return !dir_.empty(); }
+  const char *path() const { return path_.c_str(); }
+  std::string Rotated(int i) const { return path_ + "." + std::to_string(i); }
+
+private:
+  std::string dir_;
+  std::string path_;
+};
+
+std::string ReadFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream out;
+  out << in.rdbuf();
+  return out.str();
+}
+
+bool FileExists(const std::string &path) {
+  return access(path.c_str(), F_OK) == 0;
+}
+
+size_t CountRecords(const std::string &text) {
+  size_t n = 0;
+  for (char c : text) {
+    n += c == '\x1e' ? 1u : 0u;
+  }
+  return n;
+}
+
+struct sockaddr_in Addr4(const char *ip, uint16_t port) {
+  struct sockaddr_in sin{};
+  sin.sin_family = AF_INET;
+  sin.sin_port = htons(port);
+  EXPECT_EQ(inet_pton(AF_INET, ip, &sin.sin_addr), 1);
+  return sin;
+}
+
+int Begin(odin_qlog_ring_t *ring, uint8_t tag, const struct sockaddr_in &peer) {
+  const uint8_t cid[4] = {0xab, 0xcd, 0x00, tag};
+  return odin_qlog_conn_begin(ring, cid, sizeof(cid),
+                              reinterpret_cast<const struct sockaddr *>(&peer),
+                              sizeof(peer));
+}
+
+void End(odin_qlog_ring_t *ring, uint8_t tag) {
+  const uint8_t cid[4] = {0xab, 0xcd, 0x00, tag};
+  odin_qlog_conn_end(ring, cid, sizeof(cid));
+}
+
+void Event(odin_qlog_ring_t *ring, const std::string &line) {
+  odin_qlog_event(ring, 2, line.data(), line.size());
+}
+
+// Polls the stats until pred holds or timeout_ms passes.
+template <typename Pred>
+odin_qlog_stats_t WaitStats(odin_qlog_t *log, Pred pred, int timeout_ms) {
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+  odin_qlog_stats_t st{};
+  for (;;) {
+    odin_qlog_stats(log, &st);
+    if (pred(st) || std::chrono::steady_clock::now() >= deadline) {
+      return st;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+}
+
+// T1: one connection in sample_every is traced, a peer matching force_addr
+// always is without advancing the sample, and the traced table is bounded.
+TEST(OdinQlogTest, T1SamplingAndForcedPeer) {
+  QlogDir dir;
+  ASSERT_TRUE(dir.ok()) << std::strerror(errno);
+  const struct sockaddr_in force = Addr4("192.0.2.7", 0);
+  odin_qlog_config_t cfg{};
+  cfg.path = dir.path();
+  cfg.sample_every = 3;
+  cfg.force_addr = reinterpret_cast<const struct sockaddr *>(&force);
+  cfg.force_addr_len = sizeof(force);
+  odin_qlog_t *log = nullptr;
+  ASSERT_EQ(odin_qlog_create(&cfg, &log), 0) << std::strerror(errno);
+  odin_qlog_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_qlog_ring_create(log, 0, &ring), 0);
+
+  const struct sockaddr_in other = Addr4("198.51.100.1", 443);
+  const struct sockaddr_in forced = Addr4("192.0.2.7", 5555);
+  EXPECT_EQ(Begin(ring, 0, other), 1);
+  EXPECT_EQ(Begin(ring, 1, forced), 1);
+  EXPECT_EQ(Begin(ring, 2, other), 0);
+  EXPECT_EQ(Begin(ring, 3, other), 0);
+  EXPECT_EQ(Begin(ring, 4, other), 1);
+  for (uint8_t tag : {0, 1, 4}) {
+    End(ring, tag);
+  }
+
+  // Only ODIN_QLOG_CONN_MAX connections are traced at once.
+  for (uint8_t tag = 0; tag < ODIN_QLOG_CONN_MAX; ++tag) {
+    EXPECT_EQ(Begin(ring, tag, forced), 1);
+  }
+  EXPECT_EQ(Begin(ring, 200, forced), 0);
+  End(ring, 0);
+  EXPECT_EQ(Begin(ring, 200, forced), 1);
+  odin_qlog_ring_destroy(ring);
+  odin_qlog_destroy(log);
+
+  // sample_every 0 traces forced peers only.
+  cfg.sample_every = 0;
+  ASSERT_EQ(odin_qlog_create(&cfg, &log), 0);
+  ASSERT_EQ(odin_qlog_ring_create(log, 0, &ring), 0);
+  EXPECT_EQ(Begin(ring, 0, other), 0);
+  EXPECT_EQ(Begin(ring, 1, forced), 1);
+  odin_qlog_ring_destroy(ring);
+  odin_qlog_destroy(log);
+}
+
+// T2: a traced connection's records are framed as JSON-SEQ under the qlog
+// header, with its event line escaped; lines of untraced connections and
+// engine-level lines are discarded.
+TEST(OdinQlogTest, T2JsonSeqFraming) {
+  QlogDir dir;
+  ASSERT_TRUE(dir.ok()) << std::strerror(errno);
+  odin_qlog_config_t cfg{};
+  cfg.path = dir.path();
+  cfg.sample_every = 2;
+  cfg.flush_ms = 5;
+  odin_qlog_t *log = nullptr;
+  ASSERT_EQ(odin_qlog_create(&cfg, &log), 0) << std::strerror(errno);
+  odin_qlog_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_qlog_ring_create(log, 0, &ring), 0);
+
+  ASSERT_EQ(Begin(ring, 1, Addr4("192.0.2.1", 4433)), 1);
+  ASSERT_EQ(Begin(ring, 2, Addr4("192.0.2.2", 4433)), 0);
+  Event(ring, "[packet_sent] |scid:ABCD0001|frame:\"PING\"\t|\r\n");
+  Event(ring, "[packet_sent] |scid:abcd0002|untraced|\n");
+  Event(ring, "[engine] |no connection here|\n");
+  End(ring, 1);
+  Event(ring, "[packet_sent] |scid:abcd0001|after close|\n");
+  const odin_qlog_stats_t st = WaitStats(
+      log, [](const odin_qlog_stats_t &s) { return s.written == 3; }, 1500);
+  EXPECT_EQ(st.written, 3u);
+  odin_qlog_ring_destroy(ring);
+  odin_qlog_destroy(log);
+
+  const std::string got = ReadFile(dir.path());
+  ASSERT_EQ(got.rfind(kServerHeader, 0), 0u) << got;
+  EXPECT_EQ(CountRecords(got), 4u);
+  EXPECT_NE(got.find("\"name\":\"connectivity:connection_started\","
+                     "\"group_id\":\"abcd0001\",\"data\":{\"src_ip\":"
+                     "\"192.0.2.1\",\"src_port\":4433,\"trigger\":"
+                     "\"sampled\"}}\n"),
+            std::string::npos)
+      << got;
+  EXPECT_NE(got.find("\"name\":\"xquic:event\",\"group_id\":\"abcd0001\","
+                     "\"data\":{\"importance\":2,\"line\":\"[packet_sent] "
+                     "|scid:ABCD0001|frame:\\\"PING\\\"\\u0009|\"}}\n"),
+            std::string::npos)
+      << got;
+  EXPECT_NE(got.find("\"name\":\"connectivity:connection_closed\","
+                     "\"group_id\":\"abcd0001\",\"data\":{}}\n"),
+            std::string::npos)
+      << got;
+  EXPECT_EQ(got.find("untraced"), std::string::npos);
+  EXPECT_EQ(got.find("no connection"), std::string::npos);
+  EXPECT_EQ(got.find("after close"), std::string::npos);
+  EXPECT_EQ(got.find("abcd0002"), std::string::npos);
+}
+
+// T3: once the file reaches max_bytes the writer rotates it, keeping keep
+// files, and every file starts with its own header.
+TEST(OdinQlogTest, T3RotatesBySize) {
+  QlogDir dir;
+  ASSERT_TRUE(dir.ok()) << std::strerror(errno);
+  odin_qlog_config_t cfg{};
+  cfg.path = dir.path();
+  cfg.sample_every = 1;
+  cfg.max_bytes = 64;
+  cfg.keep = 2;
+  cfg.flush_ms = 5;
+  odin_qlog_t *log = nullptr;
+  ASSERT_EQ(odin_qlog_create(&cfg, &log), 0) << std::strerror(errno);
+  odin_qlog_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_qlog_ring_create(log, 0, &ring), 0);
+  ASSERT_EQ(Begin(ring, 1, Addr4("192.0.2.1", 4433)), 1);
+  // One batch per round, so each flush crosses max_bytes once.
+  uint64_t want = 1;
+  odin_qlog_stats_t st = WaitStats(
+      log, [](const odin_qlog_stats_t &s) { return s.rotations == 1; }, 1500);
+  EXPECT_EQ(st.rotations, 1u);
+  for (int round = 0; round < 3; ++round) {
+    Event(ring, "|scid:abcd0001|round " + std::to_string(round) + "|");
+    want += 1;
+    st = WaitStats(
+        log,
+        [want](const odin_qlog_stats_t &s) {
+          return s.written == want && s.rotations == want;
+        },
+        1500);
+  }
+  EXPECT_EQ(st.written, 4u);
+  EXPECT_EQ(st.rotations, 4u);
+  odin_qlog_ring_destroy(ring);
+  odin_qlog_destroy(log);
+
+  // The last rotation left path empty; path.1 and path.2 hold rounds 2 and
+  // 1, and round 0 aged out with path.3.
+  EXPECT_EQ(ReadFile(dir.path()), "");
+  const std::string newest = ReadFile(dir.Rotated(1));
+  const std::string older = ReadFile(dir.Rotated(2));
+  EXPECT_EQ(newest.rfind(kServerHeader, 0), 0u) << newest;
+  EXPECT_EQ(older.rfind(kServerHeader, 0), 0u) << older;
+  EXPECT_NE(newest.find("round 2"), std::string::npos) << newest;
+  EXPECT_NE(older.find("round 1"), std::string::npos) << older;
+  EXPECT_FALSE(FileExists(dir.Rotated(3)));
+}
+
+// T4: a full ring refuses records and counts them; lines past
+// ODIN_QLOG_EVENT_MAX are truncated, and destroy writes what was accepted.
+TEST(OdinQlogTest, T4FullRingDropsAndTruncates) {
+  QlogDir dir;
+  ASSERT_TRUE(dir.ok()) << std::strerror(errno);
+  odin_qlog_config_t cfg{};
+  cfg.path = dir.path();
+  cfg.sample_every = 1;
+  cfg.flush_ms = 60000; // nothing drains until destroy
+  odin_qlog_t *log = nullptr;
+  ASSERT_EQ(odin_qlog_create(&cfg, &log), 0) << std::strerror(errno);
+  odin_qlog_ring_t *ring = nullptr;
+  ASSERT_EQ(odin_qlog_ring_create(log, 1, &ring), 0); // 64 KiB
+  ASSERT_EQ(Begin(ring, 1, Addr4("192.0.2.1", 4433)), 1);
+
+  const std::string line =
+      "|scid:abcd0001|" + std::string(ODIN_QLOG_EVENT_MAX, 'x') + "TAIL";
+  for (int i = 0; i < 40; ++i) {
+    Event(ring, line);
+  }
+  odin_qlog_stats_t st{};
+  odin_qlog_stats(log, &st);
+  EXPECT_GT(st.dropped, 0u);
+  EXPECT_LT(st.dropped, 40u);
+  EXPECT_EQ(st.written, 0u);
+  const uint64_t dropped = st.dropped;
+  odin_qlog_ring_destroy(ring);
+  odin_qlog_stats(log, &st);
+  EXPECT_EQ(st.dropped, dropped);
+  odin_qlog_destroy(log);
+
+  const std::string got = ReadFile(dir.path());
+  EXPECT_EQ(CountRecords(got), 1u + 1u + (40u - dropped));
+  EXPECT_EQ(got.find("TAIL"), std::string::npos);
+}
+
+// T5: bad arguments are refused, the loop-side calls tolerate NULL, and
+// odin_qlog_parse_ip takes numeric addresses only.
+TEST(OdinQlogTest, T5BadArgumentsAndParseIp) {
+  odin_qlog_t *log = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_qlog_create(nullptr, &log), -1);
+  EXPECT_EQ(errno, EINVAL);
+  odin_qlog_config_t cfg{};
+  cfg.path = "";
+  errno = 0;
+  EXPECT_EQ(odin_qlog_create(&cfg, &log), -1);
+  EXPECT_EQ(errno, EINVAL);
+  cfg.path = "/nonexistent-odin-dir/trace.sqlog";
+  errno = 0;
+  EXPECT_EQ(odin_qlog_create(&cfg, &log), -1);
+  EXPECT_EQ(errno, ENOENT);
+  EXPECT_EQ(log, nullptr);
+  odin_qlog_ring_t *ring = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_qlog_ring_create(nullptr, 0, &ring), -1);
+  EXPECT_EQ(errno, EINVAL);
+
+  const uint8_t cid[1] = {1};
+  EXPECT_EQ(odin_qlog_conn_begin(nullptr, cid, sizeof(cid), nullptr, 0), 0);
+  odin_qlog_conn_end(nullptr, cid, sizeof(cid));
+  odin_qlog_event(nullptr, 0, "|scid:01|", 9);
+  odin_qlog_ring_destroy(nullptr);
+  odin_qlog_destroy(nullptr);
+
+  struct sockaddr_storage ss;
+  socklen_t len = 0;
+  ASSERT_EQ(odin_qlog_parse_ip("192.0.2.1", &ss, &len), 0);
+  EXPECT_EQ(ss.ss_family, AF_INET);
+  EXPECT_EQ(len, sizeof(struct sockaddr_in));
+  EXPECT_EQ(reinterpret_cast<struct sockaddr_in *>(&ss)->sin_port, 0);
+  ASSERT_EQ(odin_qlog_parse_ip("2001:db8::1", &ss, &len), 0);
+  EXPECT_EQ(ss.ss_family, AF_INET6);
+  EXPECT_EQ(len, sizeof(struct sockaddr_in6));
+  errno = 0;
+  EXPECT_EQ(odin_qlog_parse_ip("example.com", &ss, &len), -1);
+  EXPECT_EQ(errno, EINVAL);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
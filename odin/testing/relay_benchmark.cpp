@@ -0,0 +1,250 @@
+// odin/testing/relay_benchmark.cpp
+//
+// Relay throughput benchmark for odin/docs/rfc_034_relay_fast_paths.md §3.2.6.
+//
+// Pushes a fixed payload a -> b through one relay over two AF_UNIX socket
+// pairs, with a writer thread feeding a's peer and a reader thread draining
+// b's peer, and reports MiB/s plus relay readiness callbacks per MiB for
+// three endpoint pairings:
+//
+//   generic  both endpoints behind a forwarding vtable (RFC-014 path)
+//   mixed    one fd endpoint, one forwarding endpoint (RFC-034 pump, direct
+//            calls on the fd side only)
+//   fd-fd    both endpoints are fd transports (RFC-034 pump, direct calls)
+//
+// The fd <-> xqc pairing a server session runs needs a live xquic engine and
+// is covered by RFC-034 T4 instead.
+//
+// Usage: odin_relay_benchmark [MiB] (default 256).
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "odin/event_loop.h"
+#include "odin/relay.h"
+#include "odin/transport.h"
+#include "odin/transport_fd.h"
+
+namespace {
+
+enum class Pairing { kGeneric, kMixed, kFdFd };
+
+// Forwarding transport: hides an fd transport's vtable from the relay.
+struct ForwardTransport {
+  odin_transport_t base;
+  odin_transport_t *inner;
+};
+
+odin_transport_t *Inner(odin_transport_t *t) {
+  return reinterpret_cast<ForwardTransport *>(t)->inner;
+}
+
+odin_transport_io_t ForwardRead(odin_transport_t *t, void *buf, size_t len,
+                                size_t *out_n) {
+  return odin_transport_read(Inner(t), buf, len, out_n);
+}
+
+odin_transport_io_t ForwardWrite(odin_transport_t *t, const void *buf,
+                                 size_t len, size_t *out_n) {
+  return odin_transport_write(Inner(t), buf, len, out_n);
+}
+
+int ForwardShutdown(odin_transport_t *t) {
+  return odin_transport_shutdown_write(Inner(t));
+}
+
+int ForwardSetInterest(odin_transport_t *t, unsigned int events) {
+  return odin_transport_set_interest(Inner(t), events);
+}
+
+int ForwardError(odin_transport_t *t) { return odin_transport_error(Inner(t)); }
+
+void ForwardDestroy(odin_transport_t *t) { (void)t; }
+
+const odin_transport_vtable_t kForwardVtable = {
+    ForwardRead,        ForwardWrite, ForwardShutdown,
+    ForwardSetInterest, ForwardError, ForwardDestroy,
+};
+
+// One relay endpoint as the relay sees it, plus the fd transport beneath.
+struct Endpoint {
+  ForwardTransport fwd{};
+  odin_transport_t *fd_t = nullptr;
+  odin_transport_t *relay_t = nullptr;
+};
+
+struct Run {
+  odin_event_loop_t *loop = nullptr;
+  odin_relay_t *relay = nullptr;
+  Endpoint ends[2];
+  uint64_t callbacks = 0;
+  int done = 0;
+  odin_relay_status_t status = ODIN_RELAY_OK;
+  int err = 0;
+};
+
+// fd transport on_ready: translate to the endpoint the relay was started with.
+void OnReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  Run *run = static_cast<Run *>(user_data);
+  run->callbacks += 1;
+  odin_transport_t *relay_t =
+      (t == run->ends[0].fd_t) ? run->ends[0].relay_t : run->ends[1].relay_t;
+  odin_relay_ready(relay_t, events, run->relay);
+}
+
+void OnDone(odin_relay_t *relay, odin_relay_status_t status, int err,
+            void *user_data) {
+  (void)relay;
+  Run *run = static_cast<Run *>(user_data);
+  run->done = 1;
+  run->status = status;
+  run->err = err;
+  odin_event_loop_stop(run->loop);
+}
+
+bool SetNonblock(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void Writer(int fd, size_t total) {
+  static char chunk[65536];
+  std::memset(chunk, 0x5a, sizeof(chunk));
+  size_t off = 0;
+  while (off < total) {
+    size_t n = total - off;
+    if (n > sizeof(chunk)) {
+      n = sizeof(chunk);
+    }
+    const ssize_t w = write(fd, chunk, n);
+    if (w < 0 && errno == EINTR) {
+      continue;
+    }
+    if (w <= 0) {
+      break;
+    }
+    off += static_cast<size_t>(w);
+  }
+  (void)shutdown(fd, SHUT_WR);
+}
+
+void Reader(int fd, size_t *got) {
+  static char chunk[65536];
+  for (;;) {
+    const ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n > 0) {
+      *got += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    break;
+  }
+}
+
+const char *Name(Pairing p) {
+  switch (p) {
+  case Pairing::kGeneric:
+    return "generic";
+  case Pairing::kMixed:
+    return "mixed";
+  case Pairing::kFdFd:
+    return "fd-fd";
+  }
+  return "?";
+}
+
+int Bench(Pairing pairing, size_t total) {
+  int sa[2];
+  int sb[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sa) != 0 ||
+      socketpair(AF_UNIX, SOCK_STREAM, 0, sb) != 0) {
+    std::perror("socketpair");
+    return -1;
+  }
+  // sa[1] / sb[1] are the relay's fds; sa[0] / sb[0] are the peers.
+  if (!SetNonblock(sa[1]) || !SetNonblock(sb[1])) {
+    std::perror("fcntl");
+    return -1;
+  }
+  (void)shutdown(sb[0], SHUT_WR); // b -> a carries nothing
+
+  Run run;
+  if (odin_event_loop_create(&run.loop) != 0 ||
+      odin_relay_create(OnDone, &run, &run.relay) != 0) {
+    std::perror("create");
+    return -1;
+  }
+  const int fds[2] = {sa[1], sb[1]};
+  for (int i = 0; i < 2; ++i) {
+    Endpoint &e = run.ends[i];
+    if (odin_fd_transport_create(run.loop, fds[i], OnReady, &run, &e.fd_t) !=
+        0) {
+      std::perror("odin_fd_transport_create");
+      return -1;
+    }
+    const bool wrap = pairing == Pairing::kGeneric ||
+                      (pairing == Pairing::kMixed && i == 0);
+    e.fwd.base.vt = &kForwardVtable;
+    e.fwd.inner = e.fd_t;
+    e.relay_t = wrap ? &e.fwd.base : e.fd_t;
+  }
+
+  size_t got = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  std::thread writer(Writer, sa[0], total);
+  std::thread reader(Reader, sb[0], &got);
+  if (odin_relay_start(run.relay, run.ends[0].relay_t, run.ends[1].relay_t) !=
+          0 ||
+      odin_event_loop_run(run.loop) != 0) {
+    std::perror("relay");
+  }
+  writer.join();
+  reader.join();
+  const auto t1 = std::chrono::steady_clock::now();
+
+  const double secs = std::chrono::duration<double>(t1 - t0).count();
+  const double mib = static_cast<double>(got) / (1024.0 * 1024.0);
+  std::printf("%-8s %8.1f MiB/s  %8.1f callbacks/MiB  %s\n", Name(pairing),
+              mib / secs, static_cast<double>(run.callbacks) / mib,
+              (run.done && run.status == ODIN_RELAY_OK && got == total)
+                  ? "ok"
+                  : "FAILED");
+
+  odin_relay_destroy(run.relay);
+  odin_transport_destroy(run.ends[0].fd_t);
+  odin_transport_destroy(run.ends[1].fd_t);
+  odin_event_loop_destroy(run.loop);
+  for (int fd : {sa[0], sa[1], sb[0], sb[1]}) {
+    close(fd);
+  }
+  return got == total ? 0 : -1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t mib = 256;
+  if (argc > 1) {
+    mib = static_cast<size_t>(std::strtoul(argv[1], nullptr, 10));
+  }
+  const size_t total = mib * 1024 * 1024;
+  int rc = 0;
+  for (Pairing p : {Pairing::kGeneric, Pairing::kMixed, Pairing::kFdFd}) {
+    if (Bench(p, total) != 0) {
+      rc = 1;
+    }
+  }
+  return rc;
+}
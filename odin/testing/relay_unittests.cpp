@@ -1,6 +1,8 @@
 // odin/testing/relay_unittests.cpp
 //
-// Unit tests T1-T16 from §6 of odin/docs/rfc_014_relay_v2_transport.md.
+// Unit tests T1-T16 from §6 of odin/docs/rfc_014_relay_v2_transport.md, plus
+// T5 from §5 of odin/docs/rfc_033_single_allocation_server_session.md, plus
+// T1-T3 and T5 from §5 of odin/docs/rfc_034_relay_fast_paths.md.
 //
 // T1-T7 and T16 drive the relay against a test-local fake transport (no fd, no
 // loop), injecting readiness by calling the exported odin_relay_ready
@@ -21,9 +23,11 @@
 #include <cstring>
 #include <deque>
 #include <fcntl.h>
+#include <memory>
 #include <netinet/in.h>
 #include <poll.h>
 #include <string>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -1202,4 +1206,349 @@ TEST(OdinRelayTest, T16) {
   odin_relay_destroy(r);
 }
 
+// RFC-033 T5 — create_in stages bytes in the caller's buffers, and the storage
+// is reusable for a second relay once the first is destroyed from on_done.
+TEST(OdinRelayStorageTest, T5CreateInUsesCallerStorage) {
+  std::unique_ptr<odin_relay_storage_t> storage(new odin_relay_storage_t);
+
+  FakeTransport a{};
+  a.base.vt = &kFakeVtable;
+  FakeTransport b{};
+  b.base.vt = &kFakeVtable;
+  a.reads.push_back(ReadData("hello"));
+  b.write_mode = kWriteAgain; // park "hello" in dir A's buffer
+
+  DoneState state;
+  state.destroy_in_cb = true;
+  odin_relay_t *r = nullptr;
+  odin_relay_create_in(storage.get(), OnDone, &state, &r);
+  ASSERT_NE(r, nullptr);
+  ASSERT_EQ(odin_relay_start(r, &a.base, &b.base), 0) << std::strerror(errno);
+
+  odin_relay_ready(&a.base, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(std::memcmp(storage->buf[0], "hello", 5), 0);
+
+  b.write_mode = kWriteAccept;
+  odin_relay_ready(&b.base, ODIN_TRANSPORT_WRITE, r);
+  EXPECT_EQ(b.written, std::string("hello"));
+
+  // Dual EOF completes; OnDone destroys the relay inside the callback.
+  a.reads.push_back(ReadEof());
+  b.reads.push_back(ReadEof());
+  odin_relay_ready(&a.base, ODIN_TRANSPORT_READ, r);
+  odin_relay_ready(&b.base, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(state.calls, 1);
+  EXPECT_EQ(state.status, ODIN_RELAY_OK);
+  EXPECT_EQ(a.destroy_calls, 0);
+  EXPECT_EQ(b.destroy_calls, 0);
+
+  // Same storage, second relay.
+  FakeTransport c{};
+  c.base.vt = &kFakeVtable;
+  FakeTransport d{};
+  d.base.vt = &kFakeVtable;
+  c.reads.push_back(ReadData("again"));
+  DoneState state2;
+  odin_relay_t *r2 = nullptr;
+  odin_relay_create_in(storage.get(), OnDone, &state2, &r2);
+  ASSERT_EQ(odin_relay_start(r2, &c.base, &d.base), 0) << std::strerror(errno);
+  odin_relay_ready(&c.base, ODIN_TRANSPORT_READ, r2);
+  EXPECT_EQ(std::memcmp(storage->buf[0], "again", 5), 0);
+  odin_relay_ready(&d.base, ODIN_TRANSPORT_WRITE, r2);
+  EXPECT_EQ(d.written, std::string("again"));
+  EXPECT_EQ(state2.calls, 0);
+  odin_relay_destroy(r2);
+}
+
+namespace {
+
+// Forwards every slot to an inner transport. A relay sees the wrapper's vtable,
+// not the fd transport's, so it must take the RFC-014 generic path.
+struct ForwardTransport {
+  odin_transport_t base;
+  odin_transport_t *inner;
+};
+
+odin_transport_t *Inner(odin_transport_t *t) {
+  return reinterpret_cast<ForwardTransport *>(t)->inner;
+}
+
+odin_transport_io_t ForwardReadFn(odin_transport_t *t, void *buf, size_t len,
+                                  size_t *out_n) {
+  return odin_transport_read(Inner(t), buf, len, out_n);
+}
+
+odin_transport_io_t ForwardWriteFn(odin_transport_t *t, const void *buf,
+                                   size_t len, size_t *out_n) {
+  return odin_transport_write(Inner(t), buf, len, out_n);
+}
+
+int ForwardShutdownFn(odin_transport_t *t) {
+  return odin_transport_shutdown_write(Inner(t));
+}
+
+int ForwardSetInterestFn(odin_transport_t *t, unsigned int events) {
+  return odin_transport_set_interest(Inner(t), events);
+}
+
+int ForwardErrorFn(odin_transport_t *t) {
+  return odin_transport_error(Inner(t));
+}
+
+void ForwardDestroyFn(odin_transport_t *t) { (void)t; }
+
+const odin_transport_vtable_t kForwardVtable = {
+    ForwardReadFn,        ForwardWriteFn, ForwardShutdownFn,
+    ForwardSetInterestFn, ForwardErrorFn, ForwardDestroyFn,
+};
+
+// Nonblocking drain of whatever is immediately readable on fd.
+size_t DrainAvailable(int fd) {
+  size_t total = 0;
+  char buf[16384];
+  for (;;) {
+    const ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) {
+      total += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    return total;
+  }
+}
+
+// Two unix pairs with room for kPayload in each direction's socket buffers;
+// kPayload spans two relay reads.
+constexpr size_t kPayload = kCap + kCap / 2;
+
+struct FdPairs {
+  int fd_a = -1;
+  int pa = -1;
+  int fd_b = -1;
+  int pb = -1;
+  odin_event_loop_t *loop = nullptr;
+
+  void Open() {
+    MakeUnixPair(&fd_a, &pa, false);
+    MakeUnixPair(&fd_b, &pb, true);
+    PinSocketBuf(pa, 1 << 20);
+    PinSocketBuf(fd_a, 1 << 20);
+    PinSocketBuf(fd_b, 1 << 20);
+    PinSocketBuf(pb, 1 << 20);
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+  }
+
+  ~FdPairs() {
+    odin_event_loop_destroy(loop);
+    for (int fd : {fd_a, pa, fd_b, pb}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+};
+
+} // namespace
+
+// RFC-034 T1 — fd <-> fd: one READ readiness pumps the whole payload through to
+// the peer, across more than one ring's worth of reads and without waiting for
+// WRITE readiness.
+TEST(OdinRelayFastPathTest, T1FdPairPumpsWithinOneReadiness) {
+  FdPairs p;
+  ASSERT_NO_FATAL_FAILURE(p.Open());
+  const std::string payload(kPayload, 'x');
+  ASSERT_TRUE(WriteAll(p.pa, payload.data(), payload.size()));
+
+  DoneState state;
+  odin_relay_t *r = nullptr;
+  ASSERT_EQ(odin_relay_create(OnDone, &state, &r), 0) << std::strerror(errno);
+  odin_transport_t *a = nullptr;
+  odin_transport_t *b = nullptr;
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_a, odin_relay_ready, r, &a),
+            0);
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_b, odin_relay_ready, r, &b),
+            0);
+  EXPECT_TRUE(odin_fd_transport_is(a));
+  ASSERT_EQ(odin_relay_start(r, a, b), 0) << std::strerror(errno);
+
+  odin_relay_ready(a, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(DrainAvailable(p.pb), kPayload);
+  EXPECT_EQ(state.calls, 0);
+
+  odin_relay_destroy(r);
+  odin_transport_destroy(a);
+  odin_transport_destroy(b);
+}
+
+// RFC-034 T2 — the per-readiness budget: an always-readable source stops after
+// 4 * CAP bytes even though the fd sink would take more.
+TEST(OdinRelayFastPathTest, T2PumpStopsAtBudget) {
+#if defined(F_SETPIPE_SZ)
+  int pfd[2];
+  ASSERT_EQ(pipe(pfd), 0) << std::strerror(errno);
+  if (fcntl(pfd[1], F_SETPIPE_SZ, 8 * static_cast<int>(kCap)) < 0) {
+    close(pfd[0]);
+    close(pfd[1]);
+    GTEST_SKIP() << "F_SETPIPE_SZ: " << std::strerror(errno);
+  }
+  SetNonblock(pfd[0]);
+  SetNonblock(pfd[1]);
+  odin_event_loop_t *loop = nullptr;
+  ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+
+  DoneState state;
+  odin_relay_t *r = nullptr;
+  ASSERT_EQ(odin_relay_create(OnDone, &state, &r), 0) << std::strerror(errno);
+  odin_transport_t *a = nullptr;
+  ASSERT_EQ(odin_fd_transport_create(loop, pfd[1], odin_relay_ready, r, &a), 0);
+  FakeTransport b{};
+  b.base.vt = &kFakeVtable;
+  b.read_infinite = true;
+  ASSERT_EQ(odin_relay_start(r, a, &b.base), 0) << std::strerror(errno);
+
+  odin_relay_ready(&b.base, ODIN_TRANSPORT_READ, r);
+  int queued = 0;
+  ASSERT_EQ(ioctl(pfd[0], FIONREAD, &queued), 0) << std::strerror(errno);
+  EXPECT_EQ(static_cast<size_t>(queued), 4 * kCap);
+  EXPECT_EQ(LastInterest(b), ODIN_TRANSPORT_READ);
+  EXPECT_EQ(state.calls, 0);
+
+  odin_relay_destroy(r);
+  odin_transport_destroy(a);
+  odin_event_loop_destroy(loop);
+  close(pfd[0]);
+  close(pfd[1]);
+#else
+  GTEST_SKIP() << "F_SETPIPE_SZ unavailable";
+#endif
+}
+
+// RFC-034 T3 — the same fd pair behind a forwarding vtable is not recognized,
+// so the relay keeps the RFC-014 path: one read per READ readiness, and bytes
+// move only on the sink's WRITE readiness.
+TEST(OdinRelayFastPathTest, T3WrappedPairTakesGenericPath) {
+  FdPairs p;
+  ASSERT_NO_FATAL_FAILURE(p.Open());
+  const std::string payload(kPayload, 'y');
+  ASSERT_TRUE(WriteAll(p.pa, payload.data(), payload.size()));
+
+  DoneState state;
+  odin_relay_t *r = nullptr;
+  ASSERT_EQ(odin_relay_create(OnDone, &state, &r), 0) << std::strerror(errno);
+  ForwardTransport wa{};
+  ForwardTransport wb{};
+  wa.base.vt = &kForwardVtable;
+  wb.base.vt = &kForwardVtable;
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_a, odin_relay_ready, r,
+                                     &wa.inner),
+            0);
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_b, odin_relay_ready, r,
+                                     &wb.inner),
+            0);
+  EXPECT_FALSE(odin_fd_transport_is(&wa.base));
+  EXPECT_FALSE(odin_fd_transport_is(nullptr));
+  ASSERT_EQ(odin_relay_start(r, &wa.base, &wb.base), 0) << std::strerror(errno);
+
+  odin_relay_ready(&wa.base, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(DrainAvailable(p.pb), 0u);
+  odin_relay_ready(&wb.base, ODIN_TRANSPORT_WRITE, r);
+  EXPECT_EQ(DrainAvailable(p.pb), kCap);
+  EXPECT_EQ(state.calls, 0);
+
+  odin_relay_destroy(r);
+  odin_transport_destroy(wa.inner);
+  odin_transport_destroy(wb.inner);
+}
+
+// RFC-034 T5 — a readiness for a transport the relay never bound, or one that
+// arrives before start, touches neither endpoint instead of being routed to
+// end b.
+TEST(OdinRelayFastPathTest, T5ForeignReadinessIsIgnored) {
+  FakeTransport a{};
+  a.base.vt = &kFakeVtable;
+  FakeTransport b{};
+  b.base.vt = &kFakeVtable;
+  FakeTransport stray{};
+  stray.base.vt = &kFakeVtable;
+  a.reads.push_back(ReadData("from-a"));
+  b.reads.push_back(ReadData("from-b"));
+
+  DoneState state;
+  odin_relay_t *r = nullptr;
+  ASSERT_EQ(odin_relay_create(OnDone, &state, &r), 0) << std::strerror(errno);
+  odin_relay_ready(&b.base, ODIN_TRANSPORT_READ, r);
+  odin_relay_ready(nullptr, ODIN_TRANSPORT_READ, r);
+  ASSERT_EQ(odin_relay_start(r, &a.base, &b.base), 0) << std::strerror(errno);
+  odin_relay_ready(&stray.base, ODIN_TRANSPORT_READ | ODIN_TRANSPORT_ERROR, r);
+
+  EXPECT_EQ(a.reads.size(), 1u);
+  EXPECT_EQ(b.reads.size(), 1u);
+  EXPECT_TRUE(stray.interests.empty());
+  EXPECT_EQ(LastInterest(a), ODIN_TRANSPORT_READ);
+  EXPECT_EQ(LastInterest(b), ODIN_TRANSPORT_READ);
+  EXPECT_EQ(state.calls, 0);
+
+  odin_relay_ready(&b.base, ODIN_TRANSPORT_READ, r);
+  odin_relay_ready(&a.base, ODIN_TRANSPORT_WRITE, r);
+  EXPECT_EQ(a.written, std::string("from-b"));
+  EXPECT_TRUE(b.written.empty());
+
+  odin_relay_destroy(r);
+}
+
+// RFC-048 T1 — the relay counts the bytes each sink accepted, per direction,
+// and the counts stay readable after on_done until destroy.
+TEST(OdinRelayTraceTest, T1CountsBytesPerDirection) {
+  FdPairs p;
+  ASSERT_NO_FATAL_FAILURE(p.Open());
+  const std::string up(kPayload, 'u');
+  const std::string down(kCap / 2, 'd');
+  ASSERT_TRUE(WriteAll(p.pa, up.data(), up.size()));
+  ASSERT_TRUE(WriteAll(p.pb, down.data(), down.size()));
+
+  DoneState state;
+  odin_relay_t *r = nullptr;
+  ASSERT_EQ(odin_relay_create(OnDone, &state, &r), 0) << std::strerror(errno);
+  uint64_t a_to_b = 1;
+  uint64_t b_to_a = 1;
+  odin_relay_bytes(r, &a_to_b, &b_to_a);
+  EXPECT_EQ(a_to_b, 0u);
+  EXPECT_EQ(b_to_a, 0u);
+  odin_transport_t *a = nullptr;
+  odin_transport_t *b = nullptr;
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_a, odin_relay_ready, r, &a),
+            0);
+  ASSERT_EQ(odin_fd_transport_create(p.loop, p.fd_b, odin_relay_ready, r, &b),
+            0);
+  ASSERT_EQ(odin_relay_start(r, a, b), 0) << std::strerror(errno);
+
+  odin_relay_ready(a, ODIN_TRANSPORT_READ, r);
+  odin_relay_ready(b, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(DrainAvailable(p.pb), kPayload);
+  EXPECT_EQ(DrainAvailable(p.pa), down.size());
+  odin_relay_bytes(r, &a_to_b, nullptr);
+  odin_relay_bytes(r, nullptr, &b_to_a);
+  EXPECT_EQ(a_to_b, kPayload);
+  EXPECT_EQ(b_to_a, down.size());
+  EXPECT_EQ(state.calls, 0);
+
+  ASSERT_EQ(shutdown(p.pa, SHUT_WR), 0) << std::strerror(errno);
+  ASSERT_EQ(shutdown(p.pb, SHUT_WR), 0) << std::strerror(errno);
+  odin_relay_ready(a, ODIN_TRANSPORT_READ, r);
+  odin_relay_ready(b, ODIN_TRANSPORT_READ, r);
+  EXPECT_EQ(state.calls, 1);
+  EXPECT_EQ(state.status, ODIN_RELAY_OK);
+  a_to_b = 0;
+  b_to_a = 0;
+  odin_relay_bytes(r, &a_to_b, &b_to_a);
+  EXPECT_EQ(a_to_b, kPayload);
+  EXPECT_EQ(b_to_a, down.size());
+
+  odin_relay_destroy(r);
+  odin_transport_destroy(a);
+  odin_transport_destroy(b);
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1 @@
+#include "odin/route.c" // NOLINT(bugprone-suspicious-include)
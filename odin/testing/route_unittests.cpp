@@ -0,0 +1,147 @@
+// odin/testing/route_unittests.cpp
+//
+// Unit tests T1-T4 and T11 from §5 of odin/docs/rfc_038_client_split_routing.md.
+//
+// Exercises the rule table directly; no loop, no fds.
+
+#include "odin/route.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+odin_route_action_t Decide(odin_route_table_t *t, const char *host,
+                           uint16_t port) {
+  return odin_route_decide(t, host, std::strlen(host), port);
+}
+
+// T1: well-formed rules compile; a malformed rule is rejected with EINVAL and
+// its index, and an empty rule list tunnels everything.
+TEST(OdinRouteTest, T1CompileValidatesRules) {
+  const char *good[] = {"direct *",         "tunnel 10.0.0.0/8",
+                        "direct ::1",       "direct fd00::/8 443",
+                        "direct .corp.lan", "tunnel Example.COM. 8443"};
+  odin_route_table_t *t = nullptr;
+  ASSERT_EQ(odin_route_table_create(good, 6, nullptr, &t), 0);
+  odin_route_table_destroy(t);
+
+  const char *bad[][2] = {
+      {"direct example.com", "bounce example.com"},
+      {"direct example.com", "direct"},
+      {"direct example.com", "direct 10.0.0.0/33"},
+      {"direct example.com", "direct example.com 0"},
+      {"direct example.com", "direct example.com 65536"},
+      {"direct example.com", "direct exa..mple.com"},
+      {"direct example.com", "direct exa mple.com 80 x"},
+      {"direct example.com", "direct ."},
+  };
+  for (const auto &rules : bad) {
+    size_t bad_index = 99;
+    t = nullptr;
+    errno = 0;
+    EXPECT_EQ(odin_route_table_create(rules, 2, &bad_index, &t), -1)
+        << rules[1];
+    EXPECT_EQ(errno, EINVAL) << rules[1];
+    EXPECT_EQ(bad_index, 1u) << rules[1];
+    EXPECT_EQ(t, nullptr) << rules[1];
+  }
+
+  ASSERT_EQ(odin_route_table_create(nullptr, 0, nullptr, &t), 0);
+  EXPECT_EQ(Decide(t, "example.com", 443), ODIN_ROUTE_TUNNEL);
+  odin_route_table_destroy(t);
+  odin_route_table_destroy(nullptr);
+}
+
+// T2: name rules match the name and its subdomains case-insensitively and
+// never a literal; prefix rules match only literals; ports narrow a rule.
+TEST(OdinRouteTest, T2NamePrefixAndPortMatching) {
+  const char *rules[] = {"direct corp.lan", "direct 10.0.0.0/8",
+                         "direct fd00::/8", "direct 192.168.1.7",
+                         "direct example.org 8080"};
+  odin_route_table_t *t = nullptr;
+  ASSERT_EQ(odin_route_table_create(rules, 5, nullptr, &t), 0);
+
+  EXPECT_EQ(Decide(t, "corp.lan", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "Git.CORP.lan.", 22), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "notcorp.lan", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "corp.lan.evil.com", 443), ODIN_ROUTE_TUNNEL);
+
+  EXPECT_EQ(Decide(t, "10.20.30.40", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "11.0.0.1", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "fd12::1", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "fe80::1", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "192.168.1.7", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "192.168.1.8", 443), ODIN_ROUTE_TUNNEL);
+
+  EXPECT_EQ(Decide(t, "example.org", 8080), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "www.example.org", 8080), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "example.org", 443), ODIN_ROUTE_TUNNEL);
+  odin_route_table_destroy(t);
+}
+
+// T3: the first matching rule wins, so a narrow tunnel rule can carve an
+// exception out of a broader direct rule, and "*" catches the rest.
+TEST(OdinRouteTest, T3FirstMatchWins) {
+  const char *rules[] = {"tunnel secret.corp.lan", "direct corp.lan",
+                         "tunnel 10.1.0.0/16", "direct 10.0.0.0/8",
+                         "direct *"};
+  odin_route_table_t *t = nullptr;
+  ASSERT_EQ(odin_route_table_create(rules, 5, nullptr, &t), 0);
+
+  EXPECT_EQ(Decide(t, "a.secret.corp.lan", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "wiki.corp.lan", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "10.1.2.3", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "10.2.3.4", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "example.com", 443), ODIN_ROUTE_DIRECT);
+  odin_route_table_destroy(t);
+}
+
+// T4: every decision is counted against its action and its rule; unmatched
+// decisions count as defaulted tunnels.
+TEST(OdinRouteTest, T4CountersTrackDecisions) {
+  const char *rules[] = {"direct corp.lan", "tunnel 10.0.0.0/8"};
+  odin_route_table_t *t = nullptr;
+  ASSERT_EQ(odin_route_table_create(rules, 2, nullptr, &t), 0);
+
+  EXPECT_EQ(Decide(t, "a.corp.lan", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "b.corp.lan", 443), ODIN_ROUTE_DIRECT);
+  EXPECT_EQ(Decide(t, "10.0.0.1", 443), ODIN_ROUTE_TUNNEL);
+  EXPECT_EQ(Decide(t, "example.com", 443), ODIN_ROUTE_TUNNEL);
+
+  odin_route_stats_t st{};
+  odin_route_stats(t, &st);
+  EXPECT_EQ(st.direct, 2u);
+  EXPECT_EQ(st.tunnel, 2u);
+  EXPECT_EQ(st.defaulted, 1u);
+  EXPECT_EQ(odin_route_rule_hits(t, 0), 2u);
+  EXPECT_EQ(odin_route_rule_hits(t, 1), 1u);
+  EXPECT_EQ(odin_route_rule_hits(t, 2), 0u);
+  odin_route_table_destroy(t);
+}
+
+// T11: the RFC-051 log fields, and snprintf-style truncation.
+TEST(OdinRouteTest, T11StatsFormat) {
+  odin_route_stats_t st{};
+  st.tunnel = 7;
+  st.direct = 12;
+  st.defaulted = 3;
+  char buf[32];
+  const std::string want = "route=7/12/3";
+  EXPECT_EQ(odin_route_stats_format(&st, buf, sizeof(buf)), want.size());
+  EXPECT_EQ(std::string(buf), want);
+  char small[8];
+  EXPECT_EQ(odin_route_stats_format(&st, small, sizeof(small)), want.size());
+  EXPECT_EQ(std::string(small), "route=7");
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
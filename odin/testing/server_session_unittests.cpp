@@ -1,6 +1,13 @@
 // odin/testing/server_session_unittests.cpp
 //
-// Unit tests T1-T22 from §5 of odin/docs/rfc_020_server_session.md.
+// Unit tests T1-T22 from §5 of odin/docs/rfc_020_server_session.md, plus
+// T10-T11 from §5 of odin/docs/rfc_033_single_allocation_server_session.md,
+// T5 from §5 of odin/docs/rfc_036_tcp_fast_open_dial.md, T5 from §5 of
+// odin/docs/rfc_037_egress_source_pool.md, T7 from §5 of
+// odin/docs/rfc_043_streaming_dns.md, T7 from §5 of
+// odin/docs/rfc_044_dns_refresh_ahead.md, T11 from §5 of
+// odin/docs/rfc_045_dns_over_odin.md, and T6 from §5 of
+// odin/docs/rfc_049_access_log.md.
 //
 // Each row runs under the same fork + waitpid 2 s deadline fixture RFC-012 §6
 // and RFC-019 §6 established (replicated below as ServerSessionRunDeadline);
@@ -27,7 +34,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <memory>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 #include <pthread.h>
 #include <string>
@@ -39,6 +48,7 @@
 #include <unistd.h>
 #include <vector>
 
+#include "odin/dial.h"
 #include "odin/event_loop.h"
 #include "odin/protocol.h"
 #include "odin/testing/connect_session_internal_test.h"
@@ -1111,7 +1121,8 @@ TEST(OdinServerSessionTest, T13) {
 #if defined(ODIN_DNS_RESOLVER_TESTING)
     odin_dns_resolver_test_cares_step_t step = {};
     step.op = ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS;
-    ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0);
+    ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0); // A
+    ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0); // AAAA
 #endif
 
     const std::string req = EncodedReq("not-an-ip", 80);
@@ -1845,9 +1856,9 @@ private:
     pthread_mutex_unlock(&mu_);
   }
 
-  static bool ShouldDrop(const std::string &name) {
+  static bool ShouldDrop(const std::string &name, uint16_t qtype) {
     return name == "aliaspeer" || name == "noresponse.test" ||
-           name == "slow.test";
+           name == "slow.test" || (name == "v6-first.test" && qtype == 1);
   }
 
   static bool IsNxDomain(const std::string &name) { return name == "nx.test"; }
@@ -1870,7 +1881,7 @@ private:
         return {A(127, 0, 0, 1)};
       }
     }
-    if (qtype == 28 && name == "v6.test") {
+    if (qtype == 28 && (name == "v6.test" || name == "v6-first.test")) {
       return {AAAALoopback()};
     }
     return {};
@@ -1940,7 +1951,7 @@ private:
         continue;
       }
       NoteQuestion(name);
-      if (ShouldDrop(name)) {
+      if (ShouldDrop(name, qtype)) {
         continue;
       }
       Reply(buf, question_end, name, qtype, peer, peer_len);
@@ -2157,6 +2168,22 @@ int FdFactory(odin_transport_ready_cb on_ready, void *ready_user_data,
                                   ready_user_data, out);
 }
 
+// RFC-033 caller-storage rows: OnClose sees the embedded ServerSessionState
+// (first member), OnRelease the whole record.
+struct StorageSessionState {
+  ServerSessionState session;
+  int release_calls = 0;
+  odin_server_session_storage_t *released = nullptr;
+  int on_close_calls_at_release = -1;
+};
+
+void OnRelease(odin_server_session_storage_t *storage, void *user_data) {
+  StorageSessionState *s = static_cast<StorageSessionState *>(user_data);
+  s->release_calls += 1;
+  s->released = storage;
+  s->on_close_calls_at_release = s->session.on_close_calls;
+}
+
 } // namespace
 
 TEST(OdinServerDnsTest, T1DnsNameResolvesAndRelays) {
@@ -2268,7 +2295,7 @@ TEST(OdinServerDnsTest, T2NumericLiteralUsesResolverPath) {
     odin_dns_resolver_test_cares_observation_t obs1;
     ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs1), 0);
     EXPECT_EQ(obs1.getaddrinfo_calls, obs0.getaddrinfo_calls + 1);
-    EXPECT_EQ(obs1.last_ai_family, AF_UNSPEC);
+    EXPECT_EQ(obs1.last_ai_family, AF_INET);
     EXPECT_TRUE(fixture.Questions().empty());
     EXPECT_EQ(state.on_close_calls, 1);
     EXPECT_EQ(state.on_close_err, 0);
@@ -2305,7 +2332,8 @@ TEST(OdinServerDnsTest, T3DnsAndDialErrorsMapToResponses) {
       if (c.push_empty_success) {
         odin_dns_resolver_test_cares_step_t step = {};
         step.op = ODIN_DNS_TEST_CARES_RESULT_EMPTY_SUCCESS;
-        ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0);
+        ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0); // A
+        ASSERT_EQ(odin_dns_resolver_test_push_cares_step(&step), 0); // AAAA
       }
       int pa = -1;
       int pb = -1;
@@ -2785,8 +2813,78 @@ TEST(OdinServerDnsTest, T12Ipv6ResultReachesFilterAndDial) {
     EXPECT_NE(seen[0].find("::1:" + std::to_string(port)), std::string::npos);
     odin_dns_resolver_test_cares_observation_t obs;
     ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs), 0);
-    EXPECT_EQ(obs.last_ai_family, AF_UNSPEC);
+    EXPECT_EQ(obs.last_ai_family, AF_INET6);
+    EXPECT_EQ(state.on_close_err, 0);
+    odin_dns_resolver_destroy(resolver);
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-043 T7 — the AAAA answer is dialled while the A lookup is still
+// outstanding. Waiting for A would outlast the 300 ms watchdog.
+TEST(OdinServerDnsStreamTest, T7DialsFirstFamilyToAnswer) {
+  ServerSessionRunDeadline::Run([] {
+    ASSERT_EQ(odin_dns_resolver_test_reset_liveness(), 0);
+    const int lfd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (lfd < 0) {
+      GTEST_SKIP() << "IPv6 loopback socket unsupported";
+    }
+    int flags = fcntl(lfd, F_GETFL, 0);
+    ASSERT_NE(flags, -1);
+    ASSERT_EQ(fcntl(lfd, F_SETFL, flags | O_NONBLOCK), 0);
+    sockaddr_in6 addr6;
+    std::memset(&addr6, 0, sizeof(addr6));
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr = in6addr_loopback;
+    ASSERT_EQ(bind(lfd, reinterpret_cast<sockaddr *>(&addr6), sizeof(addr6)), 0)
+        << std::strerror(errno);
+    ASSERT_EQ(listen(lfd, 16), 0);
+    socklen_t alen = sizeof(addr6);
+    ASSERT_EQ(getsockname(lfd, reinterpret_cast<sockaddr *>(&addr6), &alen), 0);
+    const uint16_t port = ntohs(addr6.sin6_port);
+    std::thread srv([lfd] {
+      struct pollfd pfd{lfd, POLLIN, 0};
+      (void)poll(&pfd, 1, 1500);
+      const int fd = accept(lfd, nullptr, nullptr);
+      if (fd >= 0) {
+        (void)shutdown(fd, SHUT_WR);
+        close(fd);
+      }
+    });
+    ServerDnsFixture fixture;
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    CreateFixtureResolver(loop, &fixture, &resolver, 1500);
+    ServerSessionState state;
+    state.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create_with_resolver(loop, pb, resolver,
+                                                       OnClose, &state, &ss),
+              0);
+    std::vector<std::string> seen;
+    odin_server_session_set_dial_filter(ss, RecordAndAllowFilter, &seen);
+    const std::string req = EncodedReq("v6-first.test", port);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+    std::thread client([pa] {
+      ExpectRespCode(pa, ODIN_SERVER_SESSION_RESP_CODE_OK);
+      (void)shutdown(pa, SHUT_WR);
+    });
+    RunServerLoop(loop, &state);
+    client.join();
+    srv.join();
+    ASSERT_EQ(seen.size(), 1u);
+    EXPECT_NE(seen[0].find("::1:" + std::to_string(port)), std::string::npos);
+    EXPECT_EQ(state.on_close_calls, 1);
     EXPECT_EQ(state.on_close_err, 0);
+    odin_dns_resolver_test_liveness_t live;
+    ASSERT_EQ(odin_dns_resolver_test_liveness(&live), 0);
+    ExpectDnsLiveCounts(live, 1, 0, 0, 0, 0, 0);
     odin_dns_resolver_destroy(resolver);
     EXPECT_EQ(close(pa), 0);
     EXPECT_EQ(close(lfd), 0);
@@ -3108,7 +3206,7 @@ TEST(OdinServerDnsTest, T18ExistingPrivateConstructorsResolveNumericConnect) {
       EXPECT_EQ(live1.resolver_create_calls, live0.resolver_create_calls + 1);
       EXPECT_EQ(live1.resolver_destroy_calls, live0.resolver_destroy_calls + 1);
       EXPECT_EQ(obs1.getaddrinfo_calls, obs0.getaddrinfo_calls + 1);
-      EXPECT_EQ(obs1.last_ai_family, AF_UNSPEC);
+      EXPECT_EQ(obs1.last_ai_family, AF_INET);
       EXPECT_EQ(state.on_close_calls, 1);
       EXPECT_EQ(state.on_close_err, 0);
       EXPECT_EQ(close(pa), 0);
@@ -3118,4 +3216,556 @@ TEST(OdinServerDnsTest, T18ExistingPrivateConstructorsResolveNumericConnect) {
   }
 }
 
+// RFC-033 T10 — a create_in session relays end-to-end out of caller storage
+// and, destroyed from on_close, hands that storage back exactly once, after
+// on_close has returned.
+TEST(OdinServerSessionStorageTest, T10CreateInRelaysAndReleasesOnce) {
+  ServerSessionRunDeadline::Run([] {
+    ServerDnsFixture fixture;
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    uint16_t port = 0;
+    const int lfd = OpenLoopbackListener(&port);
+    ASSERT_GE(lfd, 0) << std::strerror(errno);
+    std::thread srv([lfd] {
+      struct pollfd pfd{lfd, POLLIN, 0};
+      (void)poll(&pfd, 1, 1500);
+      const int fd = accept(lfd, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      (void)write(fd, "from-storage", 12);
+      (void)shutdown(fd, SHUT_WR);
+      std::string scratch;
+      DrainUntilEof(fd, &scratch, 500);
+      close(fd);
+    });
+
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    CreateFixtureResolver(loop, &fixture, &resolver);
+    std::unique_ptr<odin_server_session_storage_t> storage(
+        new odin_server_session_storage_t);
+    StorageSessionState state;
+    state.session.loop = loop;
+    state.session.destroy_in_cb = true;
+    FdFactoryState factory;
+    factory.fd = pb;
+    factory.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create_in(storage.get(), OnRelease, loop,
+                                            FdFactory, &factory, resolver,
+                                            OnClose, &state, &ss),
+              0)
+        << std::strerror(errno);
+    EXPECT_EQ(static_cast<void *>(ss), static_cast<void *>(storage.get()));
+
+    const std::string req = EncodedReq("127.0.0.1", port);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+    std::string downstream_got;
+    std::thread client([pa, &downstream_got] {
+      ExpectRespCode(pa, ODIN_SERVER_SESSION_RESP_CODE_OK);
+      (void)shutdown(pa, SHUT_WR);
+      DrainUntilEof(pa, &downstream_got, 1500);
+    });
+    RunServerLoop(loop, &state.session);
+    client.join();
+    srv.join();
+
+    EXPECT_EQ(downstream_got, "from-storage");
+    EXPECT_EQ(state.session.on_close_calls, 1);
+    EXPECT_EQ(state.session.on_close_err, 0);
+    EXPECT_EQ(state.release_calls, 1);
+    EXPECT_EQ(state.released, storage.get());
+    EXPECT_EQ(state.on_close_calls_at_release, 1);
+    odin_dns_resolver_destroy(resolver);
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(pb), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-033 T11 — create_in validation and factory failure never release the
+// storage; an outside-callback destroy releases it before destroy returns.
+TEST(OdinServerSessionStorageTest, T11CreateInFailureAndOutsideDestroy) {
+  ServerSessionRunDeadline::Run([] {
+    ServerDnsFixture fixture;
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    CreateFixtureResolver(loop, &fixture, &resolver);
+    std::unique_ptr<odin_server_session_storage_t> storage(
+        new odin_server_session_storage_t);
+    StorageSessionState state;
+    state.session.loop = loop;
+    FdFactoryState factory;
+    factory.fd = pb;
+    factory.loop = loop;
+    odin_server_session_t *ss = nullptr;
+
+    errno = 0;
+    EXPECT_EQ(odin_server_session_create_in(storage.get(), nullptr, loop,
+                                            FdFactory, &factory, resolver,
+                                            OnClose, &state, &ss),
+              -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(factory.calls, 0);
+
+    factory.fail_errno = EMFILE;
+    errno = 0;
+    EXPECT_EQ(odin_server_session_create_in(storage.get(), OnRelease, loop,
+                                            FdFactory, &factory, resolver,
+                                            OnClose, &state, &ss),
+              -1);
+    EXPECT_EQ(errno, EMFILE);
+    EXPECT_EQ(factory.calls, 1);
+    EXPECT_EQ(state.release_calls, 0);
+    EXPECT_EQ(ss, nullptr);
+
+    factory.fail_errno = 0;
+    ASSERT_EQ(odin_server_session_create_in(storage.get(), OnRelease, loop,
+                                            FdFactory, &factory, resolver,
+                                            OnClose, &state, &ss),
+              0)
+        << std::strerror(errno);
+    odin_server_session_destroy(ss);
+    EXPECT_EQ(state.release_calls, 1);
+    EXPECT_EQ(state.released, storage.get());
+    EXPECT_EQ(state.session.on_close_calls, 0);
+
+    odin_dns_resolver_destroy(resolver);
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(pb), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-036 T5 — with a TFO cache the pipelined tail reaches upstream exactly
+// once, ahead of relayed bytes, whether or not the SYN carried it. Two
+// sessions run back to back so the second can use the cookie the first
+// fetched when the host enables server-side TFO.
+TEST(OdinServerTfoTest, T5TailReachesUpstreamOnce) {
+  ServerSessionRunDeadline::Run([] {
+    uint16_t port = 0;
+    const int lfd = OpenLoopbackListener(&port);
+    ASSERT_GE(lfd, 0);
+    const int qlen = 8;
+    (void)setsockopt(lfd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen));
+    odin_dial_tfo_cache_t *cache = nullptr;
+    ASSERT_EQ(odin_dial_tfo_cache_create(&cache), 0);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+
+    for (int round = 0; round < 2; ++round) {
+      int pa = -1;
+      int pb = -1;
+      MakeUnixPair(&pa, &pb);
+      std::string upstream_got;
+      std::thread srv_thread([lfd, &upstream_got] {
+        struct pollfd pfd;
+        pfd.fd = lfd;
+        pfd.events = POLLIN;
+        (void)poll(&pfd, 1, 1500);
+        const int srv = accept(lfd, nullptr, nullptr);
+        if (srv < 0) {
+          return;
+        }
+        DrainUntilEof(srv, &upstream_got, 1500);
+        (void)shutdown(srv, SHUT_WR);
+        close(srv);
+      });
+
+      ServerSessionState state;
+      state.loop = loop;
+      odin_server_session_t *ss = nullptr;
+      ASSERT_EQ(odin_server_session_create(loop, pb, OnClose, &state, &ss), 0);
+      odin_server_session_set_tfo_cache(ss, cache);
+      const std::string combined =
+          EncodedReq("127.0.0.1", port) + std::string("PIPELINED-TAIL-17");
+      ASSERT_TRUE(WriteAll(pa, combined.data(), combined.size()));
+
+      odin_event_timer_t *watchdog = nullptr;
+      ASSERT_EQ(odin_event_timer_start(loop, 300000, 0, WatchdogCb, &state,
+                                       &watchdog),
+                0);
+      std::thread test_thread([pa] {
+        uint8_t resp[4] = {0};
+        EXPECT_EQ(ReadExactly(pa, resp, 4, 1500), 4u);
+        EXPECT_EQ(resp[2], 0x00);
+        EXPECT_EQ(resp[3], 0x00);
+        (void)write(pa, "after", 5);
+        (void)shutdown(pa, SHUT_WR);
+        std::string scratch;
+        DrainUntilEof(pa, &scratch, 1500);
+      });
+
+      EXPECT_EQ(odin_event_loop_run(loop), 0);
+      test_thread.join();
+      srv_thread.join();
+      if (!state.timed_out) {
+        odin_event_timer_stop(watchdog);
+      }
+
+      EXPECT_EQ(state.on_close_calls, 1);
+      EXPECT_EQ(state.on_close_err, 0);
+      EXPECT_FALSE(state.timed_out);
+      EXPECT_EQ(upstream_got, std::string("PIPELINED-TAIL-17after"));
+      odin_server_session_destroy(ss);
+      EXPECT_EQ(close(pa), 0);
+    }
+
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+    odin_dial_tfo_cache_destroy(cache);
+  });
+}
+
+// RFC-037 T5 — a session with a source pool dials upstream from the pool's
+// address and hands the source back once the upstream socket closes.
+TEST(OdinServerSourceTest, T5UpstreamBindsPoolSource) {
+  ServerSessionRunDeadline::Run([] {
+    uint16_t port = 0;
+    const int lfd = OpenLoopbackListener(&port);
+    ASSERT_GE(lfd, 0);
+    struct sockaddr_storage src;
+    std::memset(&src, 0, sizeof(src));
+    auto *sin = reinterpret_cast<struct sockaddr_in *>(&src);
+    sin->sin_family = AF_INET;
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.2", &sin->sin_addr), 1);
+    odin_dial_source_pool_t *pool = nullptr;
+    ASSERT_EQ(odin_dial_source_pool_create(&src, 1,
+                                           ODIN_DIAL_SOURCE_ROUND_ROBIN, &pool),
+              0);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    std::string upstream_got;
+    char peer_ip[INET_ADDRSTRLEN] = {0};
+    std::thread srv_thread([lfd, &upstream_got, &peer_ip] {
+      struct pollfd pfd;
+      pfd.fd = lfd;
+      pfd.events = POLLIN;
+      (void)poll(&pfd, 1, 1500);
+      struct sockaddr_in peer;
+      socklen_t plen = sizeof(peer);
+      const int srv =
+          accept(lfd, reinterpret_cast<struct sockaddr *>(&peer), &plen);
+      if (srv < 0) {
+        return;
+      }
+      (void)inet_ntop(AF_INET, &peer.sin_addr, peer_ip, sizeof(peer_ip));
+      DrainUntilEof(srv, &upstream_got, 1500);
+      (void)shutdown(srv, SHUT_WR);
+      close(srv);
+    });
+
+    ServerSessionState state;
+    state.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create(loop, pb, OnClose, &state, &ss), 0);
+    odin_server_session_set_source_pool(ss, pool);
+    const std::string req = EncodedReq("127.0.0.1", port);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+
+    odin_event_timer_t *watchdog = nullptr;
+    ASSERT_EQ(
+        odin_event_timer_start(loop, 300000, 0, WatchdogCb, &state, &watchdog),
+        0);
+    std::thread test_thread([pa] {
+      uint8_t resp[4] = {0};
+      EXPECT_EQ(ReadExactly(pa, resp, 4, 1500), 4u);
+      EXPECT_EQ(resp[2], 0x00);
+      EXPECT_EQ(resp[3], 0x00);
+      (void)write(pa, "ping", 4);
+      (void)shutdown(pa, SHUT_WR);
+      std::string scratch;
+      DrainUntilEof(pa, &scratch, 1500);
+    });
+
+    EXPECT_EQ(odin_event_loop_run(loop), 0);
+    test_thread.join();
+    srv_thread.join();
+    if (!state.timed_out) {
+      odin_event_timer_stop(watchdog);
+    }
+
+    EXPECT_EQ(state.on_close_calls, 1);
+    EXPECT_EQ(state.on_close_err, 0);
+    EXPECT_EQ(upstream_got, std::string("ping"));
+    EXPECT_STREQ(peer_ip, "127.0.0.2");
+    odin_server_session_destroy(ss);
+    odin_dial_source_stats_t st;
+    ASSERT_EQ(odin_dial_source_pool_stats(pool, 0, &st), 0);
+    EXPECT_EQ(st.dials, 1u);
+    EXPECT_EQ(st.live, 0u);
+
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+    odin_dial_source_pool_destroy(pool);
+  });
+}
+
+// RFC-045 T11 — a CONNECT to the reserved DNS target is answered OK without a
+// dial, and a DNS_QUERY pipelined behind it gets its DNS_ANSWER on the same
+// stream; the client's half-close ends the session cleanly.
+TEST(OdinServerDnsTunnelTest, T11ReservedTargetServesQueries) {
+  ServerSessionRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+
+    ServerSessionState state;
+    state.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create(loop, pb, OnClose, &state, &ss), 0);
+    uint8_t query[ODIN_PROTO_DNS_QUERY_MAX];
+    size_t query_len = 0;
+    ASSERT_EQ(odin_proto_encode_dns_query(0x0102, ODIN_PROTO_DNS_FAMILY_V4,
+                                          "127.0.0.1", 9, query, sizeof(query),
+                                          &query_len),
+              ODIN_PROTO_OK);
+    const std::string req =
+        EncodedReq(ODIN_PROTO_DNS_HOST, ODIN_PROTO_DNS_PORT) +
+        std::string(reinterpret_cast<const char *>(query), query_len);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+
+    odin_event_timer_t *watchdog = nullptr;
+    ASSERT_EQ(
+        odin_event_timer_start(loop, 300000, 0, WatchdogCb, &state, &watchdog),
+        0);
+    uint8_t answer[ODIN_PROTO_DNS_ANSWER_HEADER_SIZE + 4] = {0};
+    size_t answer_len = 0;
+    std::string trailing;
+    std::thread test_thread([pa, &answer, &answer_len, &trailing] {
+      ExpectRespCode(pa, ODIN_SERVER_SESSION_RESP_CODE_OK);
+      answer_len = ReadExactly(pa, answer, sizeof(answer), 1500);
+      (void)shutdown(pa, SHUT_WR);
+      DrainUntilEof(pa, &trailing, 1500);
+    });
+
+    EXPECT_EQ(odin_event_loop_run(loop), 0);
+    test_thread.join();
+    if (!state.timed_out) {
+      odin_event_timer_stop(watchdog);
+    }
+
+    EXPECT_EQ(state.on_close_calls, 1);
+    EXPECT_EQ(state.on_close_err, 0);
+    ASSERT_EQ(answer_len, sizeof(answer));
+    size_t used = 0;
+    odin_proto_dns_answer_view_t view;
+    ASSERT_EQ(odin_proto_decode_dns_answer(answer, answer_len, &used, &view),
+              ODIN_PROTO_OK);
+    EXPECT_EQ(view.id, 0x0102);
+    EXPECT_EQ(view.rcode, ODIN_PROTO_DNS_RCODE_OK);
+    ASSERT_EQ(view.count, 1u);
+    const uint8_t loopback[4] = {127, 0, 0, 1};
+    EXPECT_EQ(std::memcmp(answer + view.addrs_off, loopback, 4), 0);
+    EXPECT_TRUE(trailing.empty());
+    odin_server_session_destroy(ss);
+    EXPECT_EQ(close(pa), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+// RFC-049 T6 — a relayed tunnel appends one record to the session's ring: the
+// client address it was given, the decoded target, the address dialed, the
+// byte counts each way, and a clean close.
+TEST(OdinServerAccessLogTest, T6TunnelAppendsRecord) {
+  ServerSessionRunDeadline::Run([] {
+    uint16_t port = 0;
+    const int lfd = OpenLoopbackListener(&port);
+    ASSERT_GE(lfd, 0);
+    int lp[2];
+    ASSERT_EQ(pipe(lp), 0);
+    odin_access_log_config_t cfg{};
+    cfg.fd = lp[1];
+    cfg.format = ODIN_ACCESS_LOG_JSONL;
+    odin_access_log_t *log = nullptr;
+    ASSERT_EQ(odin_access_log_create(&cfg, &log), 0);
+    odin_access_log_ring_t *ring = nullptr;
+    ASSERT_EQ(odin_access_log_ring_create(log, 4, &ring), 0);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    std::thread srv_thread([lfd] {
+      struct pollfd pfd;
+      pfd.fd = lfd;
+      pfd.events = POLLIN;
+      (void)poll(&pfd, 1, 1500);
+      const int srv = accept(lfd, nullptr, nullptr);
+      if (srv < 0) {
+        return;
+      }
+      std::string got;
+      DrainUntilEof(srv, &got, 1500);
+      (void)write(srv, "pong!", 5);
+      (void)shutdown(srv, SHUT_WR);
+      close(srv);
+    });
+
+    ServerSessionState state;
+    state.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create(loop, pb, OnClose, &state, &ss), 0);
+    struct sockaddr_in client;
+    std::memset(&client, 0, sizeof(client));
+    client.sin_family = AF_INET;
+    client.sin_port = htons(40000);
+    ASSERT_EQ(inet_pton(AF_INET, "198.51.100.7", &client.sin_addr), 1);
+    odin_server_session_set_access_log(
+        ss, ring, reinterpret_cast<struct sockaddr *>(&client),
+        sizeof(client));
+    const std::string req = EncodedReq("127.0.0.1", port);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+
+    odin_event_timer_t *watchdog = nullptr;
+    ASSERT_EQ(
+        odin_event_timer_start(loop, 300000, 0, WatchdogCb, &state, &watchdog),
+        0);
+    std::thread test_thread([pa] {
+      uint8_t resp[4] = {0};
+      EXPECT_EQ(ReadExactly(pa, resp, 4, 1500), 4u);
+      (void)write(pa, "ping", 4);
+      (void)shutdown(pa, SHUT_WR);
+      std::string scratch;
+      DrainUntilEof(pa, &scratch, 1500);
+      EXPECT_EQ(scratch, std::string("pong!"));
+    });
+
+    EXPECT_EQ(odin_event_loop_run(loop), 0);
+    test_thread.join();
+    srv_thread.join();
+    if (!state.timed_out) {
+      odin_event_timer_stop(watchdog);
+    }
+    EXPECT_EQ(state.on_close_calls, 1);
+    EXPECT_EQ(state.on_close_err, 0);
+    odin_server_session_destroy(ss);
+    odin_access_log_ring_destroy(ring);
+    odin_access_log_destroy(log);
+    EXPECT_EQ(close(lp[1]), 0);
+
+    std::string line;
+    DrainUntilEof(lp[0], &line, 1500);
+    const std::string target =
+        "\"target\":\"127.0.0.1:" + std::to_string(port) + "\"";
+    const std::string upstream =
+        "\"upstream\":\"127.0.0.1:" + std::to_string(port) + "\"";
+    EXPECT_EQ(std::count(line.begin(), line.end(), '\n'), 1);
+    EXPECT_NE(line.find("\"side\":\"server\""), std::string::npos);
+    EXPECT_NE(line.find("\"client\":\"198.51.100.7:40000\""),
+              std::string::npos);
+    EXPECT_NE(line.find(target), std::string::npos);
+    EXPECT_NE(line.find(upstream), std::string::npos);
+    EXPECT_NE(line.find("\"bytes_up\":4,\"bytes_down\":5,"),
+              std::string::npos);
+    EXPECT_NE(line.find("\"errno\":0}"), std::string::npos);
+
+    EXPECT_EQ(close(lp[0]), 0);
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
+
+namespace {
+
+void StopOnPrimed(odin_dns_query_t *query, odin_dns_status_t status, int err,
+                  const odin_dns_addr_t *addrs, size_t addr_count,
+                  void *user_data) {
+  (void)query;
+  (void)err;
+  (void)addrs;
+  EXPECT_EQ(status, ODIN_DNS_OK);
+  EXPECT_GT(addr_count, static_cast<size_t>(0));
+  odin_event_loop_stop(static_cast<odin_event_loop_t *>(user_data));
+}
+
+} // namespace
+
+// RFC-044 T7 — a CONNECT to a cached target dials straight from the cache:
+// no DNS query, and the cache records one hit.
+TEST(OdinServerDnsCacheTest, T7CachedTargetDialsWithoutQuery) {
+  ServerSessionRunDeadline::Run([] {
+    ServerDnsFixture fixture;
+    int pa = -1;
+    int pb = -1;
+    MakeUnixPair(&pa, &pb);
+    uint16_t port = 0;
+    const int lfd = OpenLoopbackListener(&port);
+    ASSERT_GE(lfd, 0) << std::strerror(errno);
+    std::thread srv([lfd] {
+      struct pollfd pfd{lfd, POLLIN, 0};
+      (void)poll(&pfd, 1, 1500);
+      const int fd = accept(lfd, nullptr, nullptr);
+      if (fd >= 0) {
+        (void)shutdown(fd, SHUT_WR);
+        close(fd);
+      }
+    });
+
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0);
+    odin_dns_resolver_t *resolver = nullptr;
+    CreateFixtureResolver(loop, &fixture, &resolver);
+    ASSERT_EQ(odin_dns_resolver_set_cache(resolver, nullptr), 0);
+    odin_dns_query_t *prime = nullptr;
+    ASSERT_EQ(odin_dns_resolve_start(resolver, "target.test", 11, 0, AF_INET,
+                                     StopOnPrimed, loop, &prime),
+              0)
+        << std::strerror(errno);
+    ASSERT_EQ(odin_event_loop_run(loop), 0);
+    odin_dns_query_destroy(prime);
+    const size_t questions = fixture.Questions().size();
+    odin_dns_resolver_test_cares_observation_t obs0;
+    ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs0), 0);
+
+    ServerSessionState state;
+    state.loop = loop;
+    odin_server_session_t *ss = nullptr;
+    ASSERT_EQ(odin_server_session_create_with_resolver(loop, pb, resolver,
+                                                       OnClose, &state, &ss),
+              0)
+        << std::strerror(errno);
+    const std::string req = EncodedReq("target.test", port);
+    ASSERT_TRUE(WriteAll(pa, req.data(), req.size()));
+    std::thread client([pa] {
+      ExpectRespCode(pa, ODIN_SERVER_SESSION_RESP_CODE_OK);
+      (void)shutdown(pa, SHUT_WR);
+    });
+    RunServerLoop(loop, &state);
+    client.join();
+    srv.join();
+
+    odin_dns_resolver_test_cares_observation_t obs1;
+    ASSERT_EQ(odin_dns_resolver_test_cares_observation(&obs1), 0);
+    EXPECT_EQ(obs1.getaddrinfo_calls, obs0.getaddrinfo_calls);
+    EXPECT_EQ(fixture.Questions().size(), questions);
+    odin_dns_cache_stats_t stats;
+    odin_dns_resolver_cache_stats(resolver, &stats);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(state.on_close_calls, 1);
+    EXPECT_EQ(state.on_close_err, 0);
+    odin_dns_resolver_destroy(resolver);
+    EXPECT_EQ(close(pa), 0);
+    EXPECT_EQ(close(lfd), 0);
+    odin_event_loop_destroy(loop);
+  });
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -86,8 +86,12 @@ typedef struct odin_xqc_server_runtime_test_ops_t {
   xqc_stream_direction_t (*stream_get_direction)(xqc_stream_t *stream);
   void *(*get_conn_alp_user_data_by_stream)(xqc_stream_t *stream);
   xqc_int_t (*stream_close)(xqc_stream_t *stream);
+  xqc_int_t (*conn_get_peer_addr)(xqc_connection_t *conn, struct sockaddr *addr,
+                                  socklen_t addr_cap, socklen_t *addr_len);
   int (*udp_register_conn)(odin_xqc_udp_t *xu, const xqc_cid_t *cid);
   void (*udp_unregister_conn)(odin_xqc_udp_t *xu, const xqc_cid_t *cid);
+  xqc_conn_stats_t (*conn_get_stats)(xqc_engine_t *engine,
+                                     const xqc_cid_t *cid);
 } odin_xqc_server_runtime_test_ops_t;
 
 void odin_xqc_server_runtime_test_reset(void);
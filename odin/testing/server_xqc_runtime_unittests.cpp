@@ -28,6 +28,7 @@
 #include "odin/protocol.h"
 #include "odin/testing/dns_resolver_internal_test.h"
 #include "odin/transport.h"
+#include "odin/transport_xqc.h"
 #if defined(ODIN_CONNECT_SESSION_TESTING)
 #include "odin/testing/connect_session_internal_test.h"
 #endif
@@ -191,6 +192,7 @@ struct FakeStream {
   std::string send_must_be_inside_bytes;
   int send_must_be_inside_checks = 0;
   int close_calls = 0;
+  size_t sends_at_close = 0;
 };
 
 xqc_connection_t *AsConn(FakeConn *conn) {
@@ -622,6 +624,8 @@ struct RuntimeHarness {
   std::vector<xqc_cid_t> fake_registered;
   std::vector<xqc_cid_t> fake_unregistered;
   std::vector<xqc_cid_t> conn_close_cids;
+  xqc_conn_stats_t conn_stats = {};
+  int conn_get_stats_calls = 0;
   int alpn_unregister_calls = 0;
   int start_calls_before = 0;
   int stop_calls_before = 0;
@@ -709,10 +713,29 @@ void *FakeGetConnAlpUserDataByStream(xqc_stream_t *stream) {
 }
 
 xqc_int_t FakeStreamClose(xqc_stream_t *stream) {
-  FromStream(stream)->close_calls += 1;
+  FakeStream *fake = FromStream(stream);
+  fake->close_calls += 1;
+  fake->sends_at_close = fake->sends.size();
+  return XQC_OK;
+}
+
+xqc_int_t FakeConnGetPeerAddr(xqc_connection_t *, struct sockaddr *addr,
+                              socklen_t addr_cap, socklen_t *addr_len) {
+  const struct sockaddr_in peer = Loopback4(4433);
+  if (addr_cap < sizeof(peer)) {
+    return -XQC_EPARAM;
+  }
+  std::memcpy(addr, &peer, sizeof(peer));
+  *addr_len = sizeof(peer);
   return XQC_OK;
 }
 
+xqc_conn_stats_t FakeConnGetStats(xqc_engine_t *engine, const xqc_cid_t *) {
+  EXPECT_EQ(engine, g_harness->engine);
+  g_harness->conn_get_stats_calls += 1;
+  return g_harness->conn_stats;
+}
+
 int FakeUdpRegisterConn(odin_xqc_udp_t *, const xqc_cid_t *cid) {
   if (g_harness != nullptr && cid != nullptr && cid->cid_len == 1 &&
       cid->cid_buf[0] == g_harness->fail_register_cid) {
@@ -761,8 +784,10 @@ void InstallRuntimeOps(RuntimeHarness *h) {
       FakeStreamGetDirection,
       FakeGetConnAlpUserDataByStream,
       FakeStreamClose,
+      FakeConnGetPeerAddr,
       FakeUdpRegisterConn,
       FakeUdpUnregisterConn,
+      FakeConnGetStats,
   };
   odin_xqc_server_runtime_test_reset();
   odin_xqc_server_runtime_test_set_ops(&kRuntimeOps);
@@ -795,6 +820,7 @@ void InitHarness(RuntimeHarness *h) {
 
 odin_xqc_server_runtime_config_t MakeRuntimeConfig(RuntimeHarness *h) {
   odin_xqc_server_runtime_config_t config;
+  std::memset(&config, 0, sizeof(config));
   config.loop = h->loop;
   config.local_addr = reinterpret_cast<const struct sockaddr *>(&h->local_addr);
   config.local_addrlen = sizeof(h->local_addr);
@@ -2213,5 +2239,176 @@ TEST(OdinXqcServerRuntimeTest, T18) {
   DestroyHarness(&h);
 }
 
+// RFC-051 T6 — the server runtime snapshots every live connection into a
+// caller array without allocating, and its totals keep a closed connection's
+// counts.
+TEST(OdinXqcServerRuntimeStatsTest, T6SnapshotsAndTotals) {
+  RuntimeHarness h;
+  InitHarness(&h);
+  CreateRuntime(&h);
+  h.conn_stats.srtt = 12000;
+  h.conn_stats.min_rtt = 9000;
+  h.conn_stats.send_count = 40;
+  h.conn_stats.recv_count = 30;
+  h.conn_stats.lost_count = 2;
+  h.conn_stats.paths_info[0].path_send_bytes = 5000;
+  h.conn_stats.paths_info[0].path_recv_bytes = 3000;
+  h.conn_stats.paths_info[1].path_send_bytes = 100;
+  FakeConn conn_a;
+  FakeConn conn_b;
+  AcceptConn(&h, &conn_a, Cid(0xD1));
+  AcceptConn(&h, &conn_b, Cid(0xD2));
+  FakeStream stream;
+  CreateBidiStream(&h, &conn_b, &stream);
+
+  odin_xqc_conn_stats_t snaps[2];
+  size_t count = 0;
+  ASSERT_EQ(odin_xqc_server_runtime_stats(h.rt, snaps, 1, &count), 0);
+  EXPECT_EQ(count, 2u);
+  ASSERT_EQ(odin_xqc_server_runtime_stats(h.rt, nullptr, 0, &count), 0);
+  EXPECT_EQ(count, 2u);
+  ASSERT_EQ(odin_xqc_server_runtime_stats(h.rt, snaps, 2, &count), 0);
+  ASSERT_EQ(count, 2u);
+  const odin_xqc_conn_stats_t &b =
+      snaps[0].cid[0] == 0xD2 ? snaps[0] : snaps[1];
+  ASSERT_EQ(b.cid_len, 1u);
+  EXPECT_EQ(b.cid[0], 0xD2);
+  EXPECT_EQ(b.srtt_us, 12000u);
+  EXPECT_EQ(b.min_rtt_us, 9000u);
+  EXPECT_EQ(b.packets_sent, 40u);
+  EXPECT_EQ(b.packets_received, 30u);
+  EXPECT_EQ(b.packets_lost, 2u);
+  EXPECT_EQ(b.bytes_sent, 5100u);
+  EXPECT_EQ(b.bytes_received, 3000u);
+  EXPECT_EQ(b.active_streams, 1u);
+  ASSERT_EQ(b.peer_len, sizeof(struct sockaddr_in));
+  EXPECT_EQ(reinterpret_cast<const struct sockaddr_in *>(&b.peer)->sin_port,
+            htons(4433));
+  errno = 0;
+  EXPECT_EQ(odin_xqc_server_runtime_stats(h.rt, nullptr, 1, &count), -1);
+  EXPECT_EQ(errno, EINVAL);
+
+  CloseConn(&h, &conn_a, Cid(0xD1));
+  odin_xqc_runtime_totals_t totals;
+  ASSERT_EQ(odin_xqc_server_runtime_totals(h.rt, &totals), 0);
+  EXPECT_EQ(totals.conns_opened, 2u);
+  EXPECT_EQ(totals.conns_active, 1u);
+  EXPECT_EQ(totals.streams_active, 1u);
+  EXPECT_EQ(totals.srtt_us_max, 12000u);
+  EXPECT_EQ(totals.packets_sent, 80u);
+  EXPECT_EQ(totals.packets_lost, 4u);
+  EXPECT_EQ(totals.bytes_sent, 10200u);
+  EXPECT_EQ(totals.bytes_received, 6000u);
+
+  CloseConn(&h, &conn_b, Cid(0xD2));
+  ASSERT_EQ(odin_xqc_server_runtime_totals(h.rt, &totals), 0);
+  EXPECT_EQ(totals.conns_active, 0u);
+  EXPECT_EQ(totals.streams_active, 0u);
+  EXPECT_EQ(totals.srtt_us_max, 0u);
+  EXPECT_EQ(totals.packets_sent, 80u);
+  EXPECT_EQ(totals.bytes_received, 6000u);
+  DestroyHarness(&h);
+}
+
+// RFC-035 T13 — an error RESP that joined the coalescing buffer reaches xquic
+// before the session destroys the transport, ahead of the stream close; bytes
+// still buffered when xquic itself closes the stream are counted as unsent.
+TEST(OdinXqcServerRuntimeCoalesceTest, T13BufferedErrorRespSentBeforeClose) {
+  (void)signal(SIGPIPE, SIG_IGN);
+  RuntimeHarness h;
+  InitHarness(&h);
+  CreateRuntime(&h);
+  uint16_t deny_port = 0;
+  int deny_lfd = OpenLoopbackListener(&deny_port);
+  ASSERT_GE(deny_lfd, 0) << std::strerror(errno);
+  FilterState deny;
+  deny.err = EACCES;
+  odin_xqc_server_runtime_set_dial_filter(h.rt, TestDialFilter, &deny);
+  FakeConn conn;
+  AcceptConn(&h, &conn, Cid(0x61));
+  FakeStream stream;
+  CreateBidiStream(&h, &conn, &stream);
+
+  // A small write that xquic takes whole opens the coalescing window, so the
+  // error RESP written behind it is buffered instead of sent.
+  size_t n = 0;
+  ASSERT_EQ(odin_transport_write(
+                static_cast<odin_transport_t *>(stream.user_data), "x", 1, &n),
+            ODIN_TRANSPORT_OK);
+  QueueCompleteReq(&stream, deny_port, "", 0);
+  ASSERT_EQ(h.app_callbacks->stream_cbs.stream_read_notify(AsStream(&stream),
+                                                           stream.user_data),
+            XQC_OK);
+  RunUntil(h.loop, [&] { return stream.close_calls != 0; });
+  EXPECT_EQ(deny.calls, 1);
+  EXPECT_EQ(stream.user_data, nullptr);
+  EXPECT_EQ(DataSends(stream),
+            "x" + EncodedResp(ODIN_SERVER_SESSION_RESP_CODE_OTHER));
+  EXPECT_EQ(stream.close_calls, 1);
+  EXPECT_EQ(stream.sends_at_close, stream.sends.size());
+  ExpectNoAccept(deny_lfd);
+  EXPECT_EQ(close(deny_lfd), 0);
+
+  FakeStream lost;
+  CreateBidiStream(&h, &conn, &lost);
+  odin_transport_t *t = static_cast<odin_transport_t *>(lost.user_data);
+  ASSERT_EQ(odin_transport_write(t, "x", 1, &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(odin_transport_write(t, "yz", 2, &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(h.app_callbacks->stream_cbs.stream_close_notify(AsStream(&lost),
+                                                            lost.user_data),
+            XQC_OK);
+  EXPECT_EQ(lost.user_data, nullptr);
+  EXPECT_EQ(DataSends(lost), "x");
+  odin_xqc_runtime_totals_t totals;
+  ASSERT_EQ(odin_xqc_server_runtime_totals(h.rt, &totals), 0);
+  EXPECT_EQ(totals.bytes_unsent, 2u);
+  CloseConn(&h, &conn, Cid(0x61));
+  DestroyHarness(&h);
+}
+
+// RFC-035 T14 — bytes xquic accepted count against the high mark until the
+// connection's sent-less-in-flight bytes show them gone, so a writer is held
+// even while nothing is in flight, and released below the low mark.
+TEST(OdinXqcServerRuntimeCoalesceTest, T14ProbeThrottlesWriter) {
+  RuntimeHarness h;
+  InitHarness(&h);
+  CreateRuntime(&h);
+  FakeConn conn;
+  AcceptConn(&h, &conn, Cid(0x62));
+  FakeStream stream;
+  CreateBidiStream(&h, &conn, &stream);
+  odin_transport_t *t = static_cast<odin_transport_t *>(stream.user_data);
+
+  const std::string chunk(65536, 'c');
+  size_t total = 0;
+  size_t n = 0;
+  while (odin_transport_write(t, chunk.data(), chunk.size(), &n) ==
+         ODIN_TRANSPORT_OK) {
+    total += n;
+  }
+  EXPECT_EQ(total, size_t{ODIN_XQC_SEND_HIGH_WATER});
+  EXPECT_EQ(h.conn_get_stats_calls, 1);
+  const size_t sends = stream.sends.size();
+
+  // Half the bytes sent and acknowledged leaves the low mark still held.
+  h.conn_stats.paths_info[0].path_send_bytes = ODIN_XQC_SEND_LOW_WATER;
+  ASSERT_EQ(h.app_callbacks->stream_cbs.stream_write_notify(AsStream(&stream),
+                                                            stream.user_data),
+            XQC_OK);
+  EXPECT_EQ(odin_transport_write(t, chunk.data(), chunk.size(), &n),
+            ODIN_TRANSPORT_AGAIN);
+  EXPECT_EQ(stream.sends.size(), sends);
+
+  h.conn_stats.paths_info[0].path_send_bytes = ODIN_XQC_SEND_LOW_WATER + 1;
+  ASSERT_EQ(h.app_callbacks->stream_cbs.stream_write_notify(AsStream(&stream),
+                                                            stream.user_data),
+            XQC_OK);
+  EXPECT_EQ(odin_transport_write(t, chunk.data(), chunk.size(), &n),
+            ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, chunk.size());
+  CloseConn(&h, &conn, Cid(0x62));
+  DestroyHarness(&h);
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage,
 // performance-no-int-to-ptr)
@@ -0,0 +1 @@
+#include "odin/slab.c" // NOLINT(bugprone-suspicious-include)
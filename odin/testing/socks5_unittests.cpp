@@ -0,0 +1,137 @@
+// odin/testing/socks5_unittests.cpp
+//
+// Unit tests T1-T4 from §5 of odin/docs/rfc_041_socks5_frontend.md.
+
+#include "odin/socks5.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes Concat(Bytes a, const Bytes &b) {
+  a.insert(a.end(), b.begin(), b.end());
+  return a;
+}
+
+odin_socks5_status_t ParseRequest(const Bytes &b, size_t *consumed,
+                                  odin_socks5_request_t *req) {
+  return odin_socks5_parse_request(b.data(), b.size(), consumed, req);
+}
+
+// T1: CONNECT with each address type parses, reporting the address span,
+// port, and the offset of pipelined payload.
+TEST(OdinSocks5Test, T1RequestAddressTypes) {
+  const Bytes v4 = {5, 1, 0, 1, 127, 0, 0, 1, 0x01, 0xBB};
+  const Bytes v6 = {5, 1, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0,
+                    0, 0, 0, 0, 0, 0, 0, 1, 0x20, 0xFB};
+  const Bytes name = {5, 1, 0, 3, 11, 'e', 'x', 'a', 'm', 'p',
+                      'l', 'e', '.', 'c', 'o', 'm', 0x00, 0x50};
+
+  size_t consumed = 0;
+  odin_socks5_request_t req{};
+  ASSERT_EQ(ParseRequest(v4, &consumed, &req), ODIN_SOCKS5_OK);
+  EXPECT_EQ(consumed, v4.size());
+  EXPECT_EQ(req.atyp, ODIN_SOCKS5_ATYP_IPV4);
+  EXPECT_EQ(req.addr_off, 4u);
+  EXPECT_EQ(req.addr_len, 4u);
+  EXPECT_EQ(req.port, 443);
+
+  ASSERT_EQ(ParseRequest(v6, &consumed, &req), ODIN_SOCKS5_OK);
+  EXPECT_EQ(req.atyp, ODIN_SOCKS5_ATYP_IPV6);
+  EXPECT_EQ(req.addr_len, 16u);
+  EXPECT_EQ(req.port, 8443);
+
+  const Bytes piped = Concat(name, {'G', 'E', 'T'});
+  ASSERT_EQ(ParseRequest(piped, &consumed, &req), ODIN_SOCKS5_OK);
+  EXPECT_EQ(consumed, name.size());
+  EXPECT_EQ(req.atyp, ODIN_SOCKS5_ATYP_DOMAIN);
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(piped.data()) +
+                            req.addr_off,
+                        req.addr_len),
+            "example.com");
+  EXPECT_EQ(req.port, 80);
+}
+
+// T2: every strict prefix of a greeting or request asks for more bytes, so
+// the parsers resume cleanly across arbitrary read boundaries.
+TEST(OdinSocks5Test, T2PrefixesNeedMore) {
+  const Bytes greeting = {5, 2, 2, 0};
+  const Bytes request = {5, 1, 0, 3, 1, 'a', 0, 1};
+  size_t consumed = 0;
+  odin_socks5_request_t req{};
+  for (size_t n = 0; n < greeting.size(); ++n) {
+    EXPECT_EQ(odin_socks5_parse_greeting(greeting.data(), n, &consumed),
+              ODIN_SOCKS5_NEED_MORE)
+        << n;
+  }
+  EXPECT_EQ(odin_socks5_parse_greeting(greeting.data(), greeting.size(),
+                                       &consumed),
+            ODIN_SOCKS5_OK);
+  EXPECT_EQ(consumed, greeting.size());
+  for (size_t n = 0; n < request.size(); ++n) {
+    EXPECT_EQ(odin_socks5_parse_request(request.data(), n, &consumed, &req),
+              ODIN_SOCKS5_NEED_MORE)
+        << n;
+  }
+}
+
+// T3: malformed greetings and requests fail as soon as the bad byte arrives.
+TEST(OdinSocks5Test, T3RejectsMalformed) {
+  size_t consumed = 0;
+  odin_socks5_request_t req{};
+  const Bytes v4_greeting = {4, 1, 0};
+  const Bytes no_method = {5, 1, 2};
+  const Bytes zero_methods = {5, 0};
+  EXPECT_EQ(odin_socks5_parse_greeting(v4_greeting.data(), 1, &consumed),
+            ODIN_SOCKS5_ERR_BAD_VERSION);
+  EXPECT_EQ(odin_socks5_parse_greeting(no_method.data(), no_method.size(),
+                                       &consumed),
+            ODIN_SOCKS5_ERR_NO_METHOD);
+  EXPECT_EQ(odin_socks5_parse_greeting(zero_methods.data(),
+                                       zero_methods.size(), &consumed),
+            ODIN_SOCKS5_ERR_NO_METHOD);
+
+  EXPECT_EQ(ParseRequest({5, 2}, &consumed, &req),
+            ODIN_SOCKS5_ERR_BAD_COMMAND); // BIND
+  EXPECT_EQ(ParseRequest({5, 1, 1}, &consumed, &req),
+            ODIN_SOCKS5_ERR_BAD_VERSION); // RSV
+  EXPECT_EQ(ParseRequest({5, 1, 0, 2}, &consumed, &req),
+            ODIN_SOCKS5_ERR_BAD_ADDR_TYPE);
+  EXPECT_EQ(ParseRequest({5, 1, 0, 3, 0}, &consumed, &req),
+            ODIN_SOCKS5_ERR_HOST_LEN_INVALID);
+  EXPECT_EQ(ParseRequest({5, 1, 0, 1, 1, 2, 3, 4, 0, 0}, &consumed, &req),
+            ODIN_SOCKS5_ERR_PORT_INVALID);
+}
+
+// T4: replies carry the mapped REP code and a zero IPv4 bind address.
+TEST(OdinSocks5Test, T4Replies) {
+  uint8_t out[ODIN_SOCKS5_REPLY_LEN];
+  odin_socks5_write_reply(ODIN_SOCKS5_REP_CONNECTION_REFUSED, out);
+  EXPECT_EQ(Bytes(out, out + sizeof(out)),
+            Bytes({5, 5, 0, 1, 0, 0, 0, 0, 0, 0}));
+  EXPECT_EQ(odin_socks5_method_reply(1)[1], 0x00);
+  EXPECT_EQ(odin_socks5_method_reply(0)[1], 0xFF);
+
+  EXPECT_EQ(odin_socks5_rep_for_errno(0), ODIN_SOCKS5_REP_SUCCEEDED);
+  EXPECT_EQ(odin_socks5_rep_for_errno(ECONNREFUSED),
+            ODIN_SOCKS5_REP_CONNECTION_REFUSED);
+  EXPECT_EQ(odin_socks5_rep_for_errno(EHOSTUNREACH),
+            ODIN_SOCKS5_REP_HOST_UNREACHABLE);
+  EXPECT_EQ(odin_socks5_rep_for_errno(EOPNOTSUPP),
+            ODIN_SOCKS5_REP_COMMAND_NOT_SUPPORTED);
+  EXPECT_EQ(odin_socks5_rep_for_errno(EIO), ODIN_SOCKS5_REP_GENERAL_FAILURE);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -1,7 +1,8 @@
 // odin/testing/transport_fd_unittests.cpp
 //
-// Unit tests T2-T14 from §6 of
-// odin/docs/rfc_013_transport_interface_fd_impl.md.
+// Unit tests T2-T14 from §5 of
+// odin/docs/rfc_013_transport_interface_fd_impl.md, plus T6 from §5 of
+// odin/docs/rfc_033_single_allocation_server_session.md.
 //
 // Each row exercises the public odin_transport_* API against an
 // odin_fd_transport_create instance. Every row runs under the same fork +
@@ -662,4 +663,48 @@ TEST(OdinFdTransportTest, T14) {
   });
 }
 
+// RFC-033 T6 — create_in runs in caller storage; destroy leaves the storage
+// (and the fd) to the caller, and the same storage hosts a second transport.
+TEST(OdinFdTransportStorageTest, T6CreateInStorageIsReusable) {
+  TransportRunDeadline::Run([] {
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_fd_transport_storage_t storage;
+
+    for (int round = 0; round < 2; ++round) {
+      int fd = -1;
+      int peer = -1;
+      MakeUnixPair(&fd, &peer, false);
+      ASSERT_TRUE(WriteAll(peer, "hello", 5));
+
+      ReadyState state;
+      state.loop = loop;
+      odin_transport_t *t = nullptr;
+      odin_fd_transport_create_in(&storage, loop, fd, OnReady, &state, &t);
+      ASSERT_EQ(static_cast<void *>(t), static_cast<void *>(&storage));
+
+      odin_event_timer_t *watchdog = nullptr;
+      ASSERT_EQ(odin_event_timer_start(loop, 100000, 0, WatchdogCb, &state,
+                                       &watchdog),
+                0);
+      ASSERT_EQ(odin_transport_set_interest(t, ODIN_TRANSPORT_READ), 0)
+          << std::strerror(errno);
+      EXPECT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+      EXPECT_FALSE(state.timed_out);
+      odin_event_timer_stop(watchdog);
+
+      char buf[64];
+      size_t n = 0;
+      EXPECT_EQ(odin_transport_read(t, buf, sizeof(buf), &n),
+                ODIN_TRANSPORT_OK);
+      EXPECT_EQ(std::string(buf, n), std::string("hello"));
+
+      odin_transport_destroy(t);
+      EXPECT_EQ(close(fd), 0);
+      EXPECT_EQ(close(peer), 0);
+    }
+    odin_event_loop_destroy(loop);
+  });
+}
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -1,7 +1,10 @@
 // odin/testing/transport_xqc_unittests.cpp
 //
 // Unit and integration tests T1-T18 from §5 of
-// odin/docs/rfc_016_xqc_stream_transport.md.
+// odin/docs/rfc_016_xqc_stream_transport.md, plus T9 from §5 of
+// odin/docs/rfc_033_single_allocation_server_session.md, T1-T8 and T12 from
+// §5 of odin/docs/rfc_035_xqc_write_coalescing.md, and T4 from §5 of
+// odin/docs/rfc_034_relay_fast_paths.md.
 
 #include "odin/transport_xqc.h"
 
@@ -237,6 +240,30 @@ void RelayDone(odin_relay_t *relay, odin_relay_status_t status, int err,
   }
 }
 
+// Destroys the transport from inside READ and immediately builds a fresh one
+// in the same storage, the way a slab-recycled session would.
+struct RebuildState {
+  odin_xqc_stream_transport_storage_t *storage = nullptr;
+  FakeStream *stream = nullptr;
+  ReadyState inner;
+  odin_transport_t *rebuilt = nullptr;
+  int calls = 0;
+};
+
+void RebuildReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  RebuildState *s = static_cast<RebuildState *>(user_data);
+  s->calls += 1;
+  if ((events & ODIN_TRANSPORT_READ) == 0 || s->rebuilt != nullptr) {
+    return;
+  }
+  odin_transport_destroy(t);
+  EXPECT_EQ(odin_xqc_stream_transport_create_in(s->storage, AsStream(s->stream),
+                                                RecordingReady, &s->inner,
+                                                &s->rebuilt),
+            0)
+      << std::strerror(errno);
+}
+
 } // namespace
 
 // T1 — Factory installs and destroy clears xquic stream user data.
@@ -703,4 +730,470 @@ TEST(OdinXqcStreamTransportTest, T18) {
   odin_transport_destroy(b);
 }
 
+// RFC-034 T4 — xqc <-> xqc: the relay recognizes both stream transports, so
+// one READ notify drains every queued chunk into the peer stream instead of
+// reading once and waiting for another readiness.
+TEST(OdinXqcRelayFastPathTest, T4XqcPairPumpsWithinOneReadiness) {
+  InstallFakeOps();
+  FakeStream a_stream;
+  FakeStream b_stream;
+  const std::string chunk(2 * ODIN_XQC_COALESCE_SIZE, 'p');
+  for (int i = 0; i < 3; i++) {
+    QueueRecv(&a_stream, chunk, static_cast<ssize_t>(chunk.size()), 0);
+  }
+  QueueRecv(&a_stream, "", -XQC_EAGAIN, 0);
+
+  RelayDoneState done;
+  odin_relay_t *relay = nullptr;
+  ASSERT_EQ(odin_relay_create(RelayDone, &done, &relay), 0)
+      << std::strerror(errno);
+  odin_transport_t *a = nullptr;
+  odin_transport_t *b = nullptr;
+  ASSERT_EQ(odin_xqc_stream_transport_create(AsStream(&a_stream),
+                                             odin_relay_ready, relay, &a),
+            0)
+      << std::strerror(errno);
+  ASSERT_EQ(odin_xqc_stream_transport_create(AsStream(&b_stream),
+                                             odin_relay_ready, relay, &b),
+            0)
+      << std::strerror(errno);
+  EXPECT_TRUE(odin_xqc_stream_transport_is(a));
+  EXPECT_FALSE(odin_xqc_stream_transport_is(nullptr));
+  ASSERT_EQ(odin_relay_start(relay, a, b), 0) << std::strerror(errno);
+
+  EXPECT_EQ(odin_xqc_stream_transport_read_notify(AsStream(&a_stream), a),
+            XQC_OK);
+  EXPECT_EQ(a_stream.recv_calls, 4);
+  EXPECT_EQ(DataSends(b_stream), chunk + chunk + chunk);
+  EXPECT_EQ(done.calls, 0);
+
+  odin_relay_destroy(relay);
+  odin_transport_destroy(a);
+  odin_transport_destroy(b);
+}
+
+// RFC-033 T9 — destroy inside on_ready is immediate: the notify epilogue
+// neither touches the storage nor delivers the latched EOF to whatever the
+// callback rebuilt there.
+TEST(OdinXqcStreamTransportStorageTest, T9DestroyInReadyFreesStorageAtOnce) {
+  InstallFakeOps();
+  FakeStream stream;
+  QueueRecv(&stream, "bye", 3, 1);
+  odin_xqc_stream_transport_storage_t storage;
+
+  RebuildState state;
+  state.storage = &storage;
+  state.stream = &stream;
+  odin_transport_t *t = nullptr;
+  ASSERT_EQ(odin_xqc_stream_transport_create_in(&storage, AsStream(&stream),
+                                                RebuildReady, &state, &t),
+            0)
+      << std::strerror(errno);
+  EXPECT_EQ(static_cast<void *>(t), static_cast<void *>(&storage));
+
+  ASSERT_EQ(odin_transport_set_interest(t, ODIN_TRANSPORT_READ), 0);
+  EXPECT_EQ(odin_xqc_stream_transport_read_notify(AsStream(&stream), t),
+            XQC_OK);
+
+  EXPECT_EQ(state.calls, 1);
+  ASSERT_EQ(state.rebuilt, t);
+  EXPECT_EQ(state.inner.calls, 0);
+  EXPECT_EQ(stream.user_data, state.rebuilt);
+  EXPECT_EQ(odin_xqc_stream_transport_test_interest(state.rebuilt), 0u);
+
+  odin_transport_destroy(state.rebuilt);
+  EXPECT_EQ(stream.user_data, nullptr);
+}
+
+namespace {
+
+// Flush-timer ops that record arm / cancel and hand out one dummy handle; the
+// test fires the timer by calling odin_xqc_stream_transport_flush_timer_fired.
+struct FakeTimer {
+  int arms = 0;
+  int rearms = 0; // arms that handed back the expiring handle
+  int cancels = 0;
+  uint64_t delay_us = 0;
+  bool armed = false;
+  bool fail_arm = false;
+  int handle = 0;
+};
+
+void *FakeTimerArm(void *ctx, void *spent, uint64_t delay_us,
+                   odin_transport_t *t) {
+  (void)t;
+  FakeTimer *timer = static_cast<FakeTimer *>(ctx);
+  timer->arms += 1;
+  if (spent != nullptr) {
+    EXPECT_EQ(spent, &timer->handle);
+    timer->rearms += 1;
+  }
+  timer->delay_us = delay_us;
+  if (timer->fail_arm) {
+    return nullptr;
+  }
+  timer->armed = true;
+  return &timer->handle;
+}
+
+void FakeTimerCancel(void *ctx, void *handle) {
+  FakeTimer *timer = static_cast<FakeTimer *>(ctx);
+  EXPECT_EQ(handle, &timer->handle);
+  timer->cancels += 1;
+  timer->armed = false;
+}
+
+void CreateCoalescing(FakeStream *stream, ReadyState *state, FakeTimer *timer,
+                      odin_transport_t **out) {
+  CreateTransport(stream, state, out);
+  const odin_xqc_flush_timer_ops_t ops = {FakeTimerArm, FakeTimerCancel,
+                                          timer};
+  odin_xqc_stream_transport_set_flush_timer(*out, &ops,
+                                            ODIN_XQC_COALESCE_DELAY_US);
+}
+
+// Send probe whose answer the test sets; counts how often it is asked.
+struct FakeProbe {
+  uint64_t unacked = 0;
+  int calls = 0;
+};
+
+uint64_t FakeProbeUnacked(void *ctx) {
+  FakeProbe *probe = static_cast<FakeProbe *>(ctx);
+  probe->calls += 1;
+  return probe->unacked;
+}
+
+void InstallProbe(FakeProbe *probe, odin_transport_t *t) {
+  const odin_xqc_send_probe_t ops = {FakeProbeUnacked, nullptr, probe};
+  odin_xqc_stream_transport_set_send_probe(t, &ops);
+}
+
+void Fire(FakeTimer *timer, odin_transport_t *t) {
+  ASSERT_TRUE(timer->armed);
+  timer->armed = false;
+  odin_xqc_stream_transport_flush_timer_fired(t);
+}
+
+odin_transport_io_t Write(odin_transport_t *t, const std::string &data,
+                          size_t *n) {
+  *n = 0;
+  return odin_transport_write(t, data.data(), data.size(), n);
+}
+
+} // namespace
+
+#if defined(ODIN_TRANSPORT_XQC_TESTING)
+// RFC-035 T1 — an isolated small write goes straight out and opens the window;
+// small writes inside it are merged into one send when the timer fires.
+TEST(OdinXqcCoalesceTest, T1SmallWritesInWindowShareOneSend) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  EXPECT_EQ(Write(t, "a", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, 1u);
+  ASSERT_EQ(stream.send_calls, 1);
+  EXPECT_EQ(timer.arms, 1);
+  EXPECT_EQ(timer.delay_us, ODIN_XQC_COALESCE_DELAY_US);
+
+  EXPECT_EQ(Write(t, "bc", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, 2u);
+  EXPECT_EQ(Write(t, "d", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(stream.send_calls, 1);
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 3u);
+
+  Fire(&timer, t);
+  ASSERT_EQ(stream.send_calls, 2);
+  EXPECT_EQ(stream.sends[1].data, "bcd");
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 0u);
+
+  // The window closed with the timer: the next small write is direct again.
+  EXPECT_EQ(Write(t, "e", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(stream.send_calls, 3);
+  EXPECT_EQ(timer.arms, 2);
+  EXPECT_EQ(DataSends(stream), "abcde");
+  EXPECT_EQ(state.calls, 0);
+
+  odin_transport_destroy(t);
+  EXPECT_EQ(timer.cancels, 1);
+}
+
+// RFC-035 T2 — the buffer goes out as soon as it holds a full frame, and a
+// write that does not fit sends the buffer first.
+TEST(OdinXqcCoalesceTest, T2FullBufferAndLargeWriteKeepOrder) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  ASSERT_EQ(Write(t, "x", &n), ODIN_TRANSPORT_OK); // opens the window
+  const std::string half(ODIN_XQC_COALESCE_SIZE / 2, 'h');
+  EXPECT_EQ(Write(t, half, &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(Write(t, half, &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(stream.send_calls, 2);
+  EXPECT_EQ(stream.sends[1].size, size_t{ODIN_XQC_COALESCE_SIZE});
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 0u);
+
+  EXPECT_EQ(Write(t, "yz", &n), ODIN_TRANSPORT_OK);
+  const std::string big(4096, 'B');
+  EXPECT_EQ(Write(t, big, &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, big.size());
+  ASSERT_EQ(stream.send_calls, 4);
+  EXPECT_EQ(stream.sends[2].data, "yz");
+  EXPECT_EQ(stream.sends[3].data, big);
+  EXPECT_EQ(DataSends(stream), "x" + half + half + "yz" + big);
+
+  odin_transport_destroy(t);
+}
+
+// RFC-035 T3 — while xquic refuses bytes nothing is buffered, so AGAIN reaches
+// the caller; write_notify ends the blocked state.
+TEST(OdinXqcCoalesceTest, T3BackpressureBypassesBuffer) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  QueueSend(&stream, 2);
+  size_t n = 0;
+  EXPECT_EQ(Write(t, "abcd", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, 2u);
+  EXPECT_EQ(timer.arms, 0);
+
+  QueueSend(&stream, -XQC_EAGAIN);
+  EXPECT_EQ(Write(t, "cd", &n), ODIN_TRANSPORT_AGAIN);
+  EXPECT_EQ(stream.send_calls, 2);
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 0u);
+
+  ASSERT_EQ(odin_transport_set_interest(t, ODIN_TRANSPORT_WRITE), 0);
+  state.events.clear(); // drop the set_interest write kick
+  EXPECT_EQ(odin_xqc_stream_transport_write_notify(AsStream(&stream), t),
+            XQC_OK);
+  ASSERT_EQ(state.events.size(), 1u);
+  EXPECT_EQ(state.events[0], ODIN_TRANSPORT_WRITE);
+  EXPECT_EQ(Write(t, "cd", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(stream.sends.size(), 3u);
+  EXPECT_EQ(stream.sends[2].data, "cd");
+
+  odin_transport_destroy(t);
+}
+
+// RFC-035 T4 — writes stop once xquic holds the high mark unacknowledged,
+// confirmed by a probe, and WRITE readiness returns only below the low mark.
+TEST(OdinXqcCoalesceTest, T4WatermarksBoundUnackedBytes) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  FakeProbe probe;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+  InstallProbe(&probe, t);
+
+  const std::string chunk(kRelayCap, 'c');
+  size_t total = 0;
+  size_t n = 0;
+  probe.unacked = ODIN_XQC_SEND_HIGH_WATER;
+  while (Write(t, chunk, &n) == ODIN_TRANSPORT_OK) {
+    total += n;
+  }
+  EXPECT_EQ(total, size_t{ODIN_XQC_SEND_HIGH_WATER});
+  EXPECT_EQ(probe.calls, 1);
+  EXPECT_EQ(timer.arms, 1);
+  EXPECT_EQ(timer.delay_us, ODIN_XQC_SEND_POLL_US);
+  const int sends = stream.send_calls;
+  EXPECT_EQ(Write(t, "z", &n), ODIN_TRANSPORT_AGAIN);
+  EXPECT_EQ(stream.send_calls, sends);
+  EXPECT_EQ(probe.calls, 1);
+
+  // Acks bring xquic under the high mark but not the low one: still held, and
+  // neither write_notify nor the poll reports WRITE.
+  ASSERT_EQ(odin_transport_set_interest(t, ODIN_TRANSPORT_WRITE), 0);
+  state.events.clear();
+  probe.unacked = ODIN_XQC_SEND_LOW_WATER;
+  EXPECT_EQ(odin_xqc_stream_transport_write_notify(AsStream(&stream), t),
+            XQC_OK);
+  Fire(&timer, t);
+  EXPECT_TRUE(state.events.empty());
+  EXPECT_EQ(Write(t, "z", &n), ODIN_TRANSPORT_AGAIN);
+
+  probe.unacked = ODIN_XQC_SEND_LOW_WATER - 1;
+  Fire(&timer, t);
+  ASSERT_EQ(state.events.size(), 1u);
+  EXPECT_EQ(state.events[0], ODIN_TRANSPORT_WRITE);
+  EXPECT_EQ(Write(t, chunk, &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(n, chunk.size());
+
+  odin_transport_destroy(t);
+}
+
+// RFC-035 T5 — shutdown_write sends the buffered tail before the fin; when
+// xquic refuses the tail the fin waits for write_notify.
+TEST(OdinXqcCoalesceTest, T5FinFollowsBufferedTail) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  ASSERT_EQ(Write(t, "head", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, "tail", &n), ODIN_TRANSPORT_OK);
+  QueueSend(&stream, -XQC_EAGAIN);
+  EXPECT_EQ(odin_transport_shutdown_write(t), 0);
+  EXPECT_EQ(FinSends(stream), 0);
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 4u);
+
+  EXPECT_EQ(odin_xqc_stream_transport_write_notify(AsStream(&stream), t),
+            XQC_OK);
+  ASSERT_EQ(stream.sends.size(), 4u);
+  EXPECT_EQ(stream.sends[2].data, "tail");
+  EXPECT_EQ(stream.sends[3].fin, 1);
+
+  odin_transport_destroy(t);
+}
+
+// RFC-035 T6 — destroy cancels the armed timer and never calls
+// xqc_stream_send, since it may run inside stream_close_notify; the owner's
+// explicit flush is what hands the buffer over ahead of a close.
+TEST(OdinXqcCoalesceTest, T6DestroyCancelsWithoutSending) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  ASSERT_EQ(Write(t, "-ERR", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, " bye", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(odin_xqc_stream_transport_flush(t), 0);
+  EXPECT_EQ(DataSends(stream), "-ERR bye");
+  ASSERT_EQ(Write(t, " lost", &n), ODIN_TRANSPORT_OK);
+  const int sends = stream.send_calls;
+  odin_transport_destroy(t);
+  EXPECT_EQ(timer.cancels, 1);
+  EXPECT_FALSE(timer.armed);
+  EXPECT_EQ(stream.send_calls, sends);
+  EXPECT_EQ(stream.user_data, nullptr);
+}
+
+// RFC-035 T7 — the explicit flush reports EAGAIN while xquic is blocked, and a
+// failed arm degrades to an immediate send.
+TEST(OdinXqcCoalesceTest, T7ExplicitFlushAndArmFailure) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  ASSERT_EQ(Write(t, "a", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, "b", &n), ODIN_TRANSPORT_OK);
+  QueueSend(&stream, -XQC_EAGAIN);
+  errno = 0;
+  EXPECT_EQ(odin_xqc_stream_transport_flush(t), -1);
+  EXPECT_EQ(errno, EAGAIN);
+  EXPECT_EQ(odin_xqc_stream_transport_flush(t), 0);
+  ASSERT_EQ(stream.sends.size(), 3u);
+  EXPECT_EQ(stream.sends[2].data, "b");
+  Fire(&timer, t);
+  EXPECT_EQ(odin_xqc_stream_transport_write_notify(AsStream(&stream), t),
+            XQC_OK);
+
+  timer.fail_arm = true;
+  ASSERT_EQ(Write(t, "c", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, "d", &n), ODIN_TRANSPORT_OK);
+  EXPECT_EQ(odin_xqc_stream_transport_test_coalesced(t), 0u);
+  EXPECT_EQ(stream.send_calls, 5);
+  EXPECT_EQ(timer.arms, 3);
+
+  odin_transport_destroy(t);
+  EXPECT_EQ(timer.cancels, 0);
+}
+
+// RFC-035 T8 — a throttled stream polls on its one timer: each expiry that
+// still finds xquic at the low mark hands the expiring handle back to arm, and
+// a failed arm lifts the throttle rather than stranding the writer.
+TEST(OdinXqcCoalesceTest, T8ThrottledStreamRearmsItsTimer) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  FakeProbe probe;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+  InstallProbe(&probe, t);
+
+  const std::string chunk(kRelayCap, 'c');
+  size_t n = 0;
+  probe.unacked = ODIN_XQC_SEND_HIGH_WATER;
+  while (Write(t, chunk, &n) == ODIN_TRANSPORT_OK) {
+  }
+  ASSERT_EQ(timer.arms, 1);
+  ASSERT_EQ(odin_transport_set_interest(t, ODIN_TRANSPORT_WRITE), 0);
+  state.events.clear();
+
+  Fire(&timer, t);
+  Fire(&timer, t);
+  EXPECT_EQ(timer.arms, 3);
+  EXPECT_EQ(timer.rearms, 2);
+  EXPECT_EQ(probe.calls, 3);
+  EXPECT_TRUE(state.events.empty());
+
+  timer.fail_arm = true;
+  Fire(&timer, t);
+  ASSERT_EQ(state.events.size(), 1u);
+  EXPECT_EQ(state.events[0], ODIN_TRANSPORT_WRITE);
+
+  odin_transport_destroy(t);
+  EXPECT_EQ(timer.cancels, 0);
+}
+
+// RFC-035 T12 — the owner's flush drains a fin xquic refused along with the
+// tail ahead of it, sends nothing once the stream has failed, and what destroy
+// would drop stays readable for the owner to count.
+TEST(OdinXqcCoalesceTest, T12FlushDrainsFinAndReportsUnsent) {
+  FakeStream stream;
+  ReadyState state;
+  FakeTimer timer;
+  odin_transport_t *t = nullptr;
+  CreateCoalescing(&stream, &state, &timer, &t);
+
+  size_t n = 0;
+  ASSERT_EQ(Write(t, "-ERR", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, " bye", &n), ODIN_TRANSPORT_OK);
+  QueueSend(&stream, -XQC_EAGAIN);
+  EXPECT_EQ(odin_transport_shutdown_write(t), 0);
+  EXPECT_EQ(odin_xqc_stream_transport_unsent(t), 4u);
+  EXPECT_EQ(odin_xqc_stream_transport_flush(t), 0);
+  EXPECT_EQ(odin_xqc_stream_transport_unsent(t), 0u);
+  // The refused tail is offered again, then the fin follows it.
+  EXPECT_EQ(DataSends(stream), "-ERR bye bye");
+  EXPECT_EQ(FinSends(stream), 1);
+  EXPECT_EQ(stream.sends.back().fin, 1);
+  odin_transport_destroy(t);
+
+  FakeStream failed;
+  ReadyState failed_state;
+  FakeTimer failed_timer;
+  CreateCoalescing(&failed, &failed_state, &failed_timer, &t);
+  ASSERT_EQ(Write(t, "a", &n), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(t, "bc", &n), ODIN_TRANSPORT_OK);
+  odin_xqc_stream_transport_closing_notify(AsStream(&failed),
+                                           XQC_ESTREAM_RESET, t);
+  const int sends = failed.send_calls;
+  errno = 0;
+  EXPECT_EQ(odin_xqc_stream_transport_flush(t), -1);
+  EXPECT_EQ(errno, EPIPE);
+  EXPECT_EQ(failed.send_calls, sends);
+  EXPECT_EQ(odin_xqc_stream_transport_unsent(t), 2u);
+  odin_transport_destroy(t);
+}
+#endif
+
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1 @@
+#include "odin/upstream_set.c" // NOLINT(bugprone-suspicious-include)
@@ -0,0 +1,134 @@
+// odin/testing/upstream_set_unittests.cpp
+//
+// Unit tests T1-T5 from §5 of odin/docs/rfc_039_upstream_selection.md.
+//
+// Exercises the selection state machine directly with caller-supplied
+// statistics and times; no loop, no runtimes.
+
+#include "odin/upstream_set.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+odin_upstream_info_t Info(const odin_upstream_set_t *set, size_t index) {
+  odin_upstream_info_t info{};
+  EXPECT_EQ(odin_upstream_set_info(set, index, &info), 0);
+  return info;
+}
+
+// T1: before any server is up the lowest-index connecting server is picked;
+// once servers report, the lowest RTT wins.
+TEST(OdinUpstreamSetTest, T1PicksLowestRttOnceUp) {
+  odin_upstream_set_t *set = nullptr;
+  ASSERT_EQ(odin_upstream_set_create(3, &set), 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), 0);
+
+  odin_upstream_set_observe(set, 1, 40000, 100, 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), 1);
+  odin_upstream_set_observe(set, 2, 20000, 100, 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), 2);
+  EXPECT_EQ(Info(set, 2).state, ODIN_UPSTREAM_UP);
+  EXPECT_EQ(Info(set, 2).picks, 1u);
+  EXPECT_EQ(Info(set, 0).state, ODIN_UPSTREAM_CONNECTING);
+  odin_upstream_set_destroy(set);
+}
+
+// T2: a preferred server is kept until another beats it by more than
+// ODIN_UPSTREAM_SWITCH_PERCENT.
+TEST(OdinUpstreamSetTest, T2HysteresisAvoidsFlapping) {
+  odin_upstream_set_t *set = nullptr;
+  ASSERT_EQ(odin_upstream_set_create(2, &set), 0);
+  odin_upstream_set_observe(set, 0, 20000, 100, 0);
+  odin_upstream_set_observe(set, 1, 30000, 100, 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), 0);
+
+  odin_upstream_set_observe(set, 1, 19000, 200, 0); // 5% better: stay
+  EXPECT_EQ(odin_upstream_set_pick(set), 0);
+  odin_upstream_set_observe(set, 1, 15000, 300, 0); // 25% better: switch
+  EXPECT_EQ(odin_upstream_set_pick(set), 1);
+  odin_upstream_set_destroy(set);
+}
+
+// T3: loss inflates a server's score, so a lossy low-RTT server loses to a
+// clean one.
+TEST(OdinUpstreamSetTest, T3LossPenalizesScore) {
+  odin_upstream_set_t *set = nullptr;
+  ASSERT_EQ(odin_upstream_set_create(2, &set), 0);
+  odin_upstream_set_observe(set, 0, 20000, 0, 0);
+  odin_upstream_set_observe(set, 1, 30000, 0, 0);
+  for (uint64_t i = 1; i <= 8; ++i) {
+    odin_upstream_set_observe(set, 0, 20000, i * 100, i * 30); // 30% loss
+    odin_upstream_set_observe(set, 1, 30000, i * 100, 0);
+  }
+  EXPECT_GT(Info(set, 0).loss_permille, 150u);
+  EXPECT_EQ(Info(set, 1).loss_permille, 0u);
+  EXPECT_EQ(odin_upstream_set_pick(set), 1);
+  odin_upstream_set_destroy(set);
+}
+
+// T4: a server marked down is skipped at once and stays out until its
+// backoff expires and it reconnects; the backoff doubles up to the cap.
+TEST(OdinUpstreamSetTest, T4FailoverAndBackoff) {
+  odin_upstream_set_t *set = nullptr;
+  ASSERT_EQ(odin_upstream_set_create(2, &set), 0);
+  odin_upstream_set_observe(set, 0, 10000, 100, 0);
+  odin_upstream_set_observe(set, 1, 50000, 100, 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), 0);
+
+  odin_upstream_set_mark_down(set, 0, 1000);
+  EXPECT_EQ(odin_upstream_set_pick(set), 1);
+  EXPECT_EQ(Info(set, 0).retry_at_ms, 1000u + ODIN_UPSTREAM_RETRY_MIN_MS);
+  EXPECT_EQ(odin_upstream_set_retry_due(set, 0, 1999), 0);
+  EXPECT_EQ(odin_upstream_set_retry_due(set, 0, 2000), 1);
+  odin_upstream_set_observe(set, 0, 1, 1, 0); // ignored while down
+  EXPECT_EQ(Info(set, 0).state, ODIN_UPSTREAM_DOWN);
+
+  odin_upstream_set_mark_connecting(set, 0);
+  odin_upstream_set_mark_down(set, 0, 2000);
+  EXPECT_EQ(Info(set, 0).retry_at_ms, 2000u + 2u * ODIN_UPSTREAM_RETRY_MIN_MS);
+  for (int i = 0; i < 10; ++i) {
+    odin_upstream_set_mark_down(set, 0, 5000);
+  }
+  EXPECT_EQ(Info(set, 0).retry_at_ms, 5000u + ODIN_UPSTREAM_RETRY_MAX_MS);
+
+  odin_upstream_set_mark_connecting(set, 0);
+  odin_upstream_set_observe(set, 0, 10000, 10, 0);
+  EXPECT_EQ(Info(set, 0).state, ODIN_UPSTREAM_UP);
+  EXPECT_EQ(Info(set, 0).failures, 0u);
+  EXPECT_EQ(odin_upstream_set_pick(set), 0);
+  odin_upstream_set_destroy(set);
+}
+
+// T5: with every server down, pick reports -1; bad arguments are rejected.
+TEST(OdinUpstreamSetTest, T5AllDownAndBadArguments) {
+  odin_upstream_set_t *set = nullptr;
+  ASSERT_EQ(odin_upstream_set_create(2, &set), 0);
+  odin_upstream_set_mark_down(set, 0, 0);
+  odin_upstream_set_mark_down(set, 1, 0);
+  EXPECT_EQ(odin_upstream_set_pick(set), -1);
+
+  odin_upstream_info_t info{};
+  errno = 0;
+  EXPECT_EQ(odin_upstream_set_info(set, 2, &info), -1);
+  EXPECT_EQ(errno, EINVAL);
+  odin_upstream_set_destroy(set);
+  odin_upstream_set_destroy(nullptr);
+
+  odin_upstream_set_t *bad = nullptr;
+  errno = 0;
+  EXPECT_EQ(odin_upstream_set_create(0, &bad), -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(odin_upstream_set_create(ODIN_UPSTREAM_SET_MAX + 1u, &bad), -1);
+  EXPECT_EQ(bad, nullptr);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1 @@
+#include "odin/xqc_conn_stats.c" // NOLINT(bugprone-suspicious-include)
@@ -0,0 +1,189 @@
+// odin/testing/xqc_conn_stats_unittests.cpp
+//
+// Unit tests T1-T5, T7, and T8 from §5 of odin/docs/rfc_051_quic_conn_stats.md.
+//
+// The helpers are pure functions over xquic's stats struct, so every test
+// builds an xqc_conn_stats_t by hand; no engine or connection is involved.
+
+#include "odin/xqc_conn_stats.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+namespace {
+
+xqc_conn_stats_t ZeroStats() {
+  xqc_conn_stats_t st;
+  std::memset(&st, 0, sizeof(st));
+  return st;
+}
+
+// T1: the scalar transport fields are copied across under their odin names.
+TEST(OdinXqcConnStatsTest, T1FillCopiesTransportFields) {
+  xqc_conn_stats_t st = ZeroStats();
+  st.srtt = 25000;
+  st.min_rtt = 18000;
+  st.inflight_bytes = 7300;
+  st.send_count = 120;
+  st.recv_count = 95;
+  st.lost_count = 3;
+  odin_xqc_conn_stats_t out;
+  std::memset(&out, 0, sizeof(out));
+  odin_xqc_conn_stats_fill(&st, &out);
+  EXPECT_EQ(out.srtt_us, 25000u);
+  EXPECT_EQ(out.min_rtt_us, 18000u);
+  EXPECT_EQ(out.inflight_bytes, 7300u);
+  EXPECT_EQ(out.packets_sent, 120u);
+  EXPECT_EQ(out.packets_received, 95u);
+  EXPECT_EQ(out.packets_lost, 3u);
+  EXPECT_EQ(out.bytes_sent, 0u);
+  EXPECT_EQ(out.bytes_received, 0u);
+}
+
+// T2: payload bytes are the sum over every path slot, the last included.
+TEST(OdinXqcConnStatsTest, T2FillSumsBytesOverPaths) {
+  xqc_conn_stats_t st = ZeroStats();
+  st.paths_info[0].path_send_bytes = 1000;
+  st.paths_info[0].path_recv_bytes = 400;
+  st.paths_info[1].path_send_bytes = 20;
+  st.paths_info[XQC_MAX_PATHS_COUNT - 1].path_send_bytes = 3;
+  st.paths_info[XQC_MAX_PATHS_COUNT - 1].path_recv_bytes = 5;
+  odin_xqc_conn_stats_t out;
+  std::memset(&out, 0, sizeof(out));
+  odin_xqc_conn_stats_fill(&st, &out);
+  EXPECT_EQ(out.bytes_sent, 1023u);
+  EXPECT_EQ(out.bytes_received, 405u);
+}
+
+// T3: fill overwrites stale byte counts but leaves the fields the runtime
+// owns (CID, peer, streams) alone.
+TEST(OdinXqcConnStatsTest, T3FillLeavesRuntimeFields) {
+  odin_xqc_conn_stats_t out;
+  std::memset(&out, 0, sizeof(out));
+  out.cid_len = 2;
+  out.cid[0] = 0xAB;
+  out.cid[1] = 0xCD;
+  out.peer_len = 16;
+  out.active_streams = 4;
+  out.bytes_sent = 999;
+  out.bytes_received = 999;
+  const xqc_conn_stats_t st = ZeroStats();
+  odin_xqc_conn_stats_fill(&st, &out);
+  EXPECT_EQ(out.cid_len, 2u);
+  EXPECT_EQ(out.cid[0], 0xAB);
+  EXPECT_EQ(out.cid[1], 0xCD);
+  EXPECT_EQ(out.peer_len, 16u);
+  EXPECT_EQ(out.active_streams, 4u);
+  EXPECT_EQ(out.bytes_sent, 0u);
+  EXPECT_EQ(out.bytes_received, 0u);
+}
+
+// T4: totals_add accumulates packets and bytes across snapshots.
+TEST(OdinXqcConnStatsTest, T4TotalsAddAccumulates) {
+  odin_xqc_conn_stats_t c;
+  std::memset(&c, 0, sizeof(c));
+  c.packets_sent = 10;
+  c.packets_received = 8;
+  c.packets_lost = 1;
+  c.bytes_sent = 1500;
+  c.bytes_received = 700;
+  odin_xqc_runtime_totals_t t;
+  std::memset(&t, 0, sizeof(t));
+  odin_xqc_runtime_totals_add(&t, &c);
+  odin_xqc_runtime_totals_add(&t, &c);
+  EXPECT_EQ(t.packets_sent, 20u);
+  EXPECT_EQ(t.packets_received, 16u);
+  EXPECT_EQ(t.packets_lost, 2u);
+  EXPECT_EQ(t.bytes_sent, 3000u);
+  EXPECT_EQ(t.bytes_received, 1400u);
+}
+
+// T5: totals_add leaves the connection, stream, and RTT aggregates to the
+// runtime.
+TEST(OdinXqcConnStatsTest, T5TotalsAddLeavesRuntimeAggregates) {
+  odin_xqc_conn_stats_t c;
+  std::memset(&c, 0, sizeof(c));
+  c.srtt_us = 40000;
+  c.active_streams = 3;
+  odin_xqc_runtime_totals_t t;
+  std::memset(&t, 0, sizeof(t));
+  t.conns_opened = 7;
+  odin_xqc_runtime_totals_add(&t, &c);
+  EXPECT_EQ(t.conns_opened, 7u);
+  EXPECT_EQ(t.conns_active, 0u);
+  EXPECT_EQ(t.streams_active, 0u);
+  EXPECT_EQ(t.srtt_us_max, 0u);
+}
+
+// T7: the log line carries every aggregate in a fixed order, and a short
+// buffer is truncated but still told the full length.
+TEST(OdinXqcConnStatsTest, T7TotalsFormatLine) {
+  odin_xqc_runtime_totals_t t;
+  std::memset(&t, 0, sizeof(t));
+  t.conns_active = 2;
+  t.conns_opened = 9;
+  t.streams_active = 5;
+  t.srtt_us_max = 31000;
+  t.packets_sent = 400;
+  t.packets_received = 380;
+  t.packets_lost = 4;
+  t.bytes_sent = 52000;
+  t.bytes_received = 1048576;
+  t.bytes_unsent = 6;
+  const char *want = "conns=2/9 streams=5 srtt_max_us=31000 pkts=400/380/4 "
+                     "bytes=52000/1048576 unsent=6";
+  char buf[128];
+  EXPECT_EQ(odin_xqc_runtime_totals_format(&t, buf, sizeof(buf)),
+            std::strlen(want));
+  EXPECT_STREQ(buf, want);
+  char small[10];
+  EXPECT_EQ(odin_xqc_runtime_totals_format(&t, small, sizeof(small)),
+            std::strlen(want));
+  EXPECT_STREQ(small, "conns=2/9");
+}
+
+// T8: merge sums every count and keeps the worse RTT from either side.
+TEST(OdinXqcConnStatsTest, T8TotalsMergeSumsRuntimes) {
+  odin_xqc_runtime_totals_t a;
+  std::memset(&a, 0, sizeof(a));
+  a.conns_active = 1;
+  a.conns_opened = 3;
+  a.streams_active = 2;
+  a.srtt_us_max = 9000;
+  a.packets_sent = 10;
+  a.bytes_received = 100;
+  odin_xqc_runtime_totals_t b;
+  std::memset(&b, 0, sizeof(b));
+  b.conns_active = 1;
+  b.conns_opened = 1;
+  b.streams_active = 5;
+  b.srtt_us_max = 45000;
+  b.packets_sent = 7;
+  b.packets_received = 6;
+  b.packets_lost = 1;
+  b.bytes_sent = 50;
+  b.bytes_received = 20;
+  b.bytes_unsent = 3;
+  odin_xqc_runtime_totals_merge(&a, &b);
+  EXPECT_EQ(a.conns_active, 2u);
+  EXPECT_EQ(a.conns_opened, 4u);
+  EXPECT_EQ(a.streams_active, 7u);
+  EXPECT_EQ(a.srtt_us_max, 45000u);
+  EXPECT_EQ(a.packets_sent, 17u);
+  EXPECT_EQ(a.packets_received, 6u);
+  EXPECT_EQ(a.packets_lost, 1u);
+  EXPECT_EQ(a.bytes_sent, 50u);
+  EXPECT_EQ(a.bytes_received, 120u);
+  EXPECT_EQ(a.bytes_unsent, 3u);
+  b.srtt_us_max = 1000;
+  odin_xqc_runtime_totals_merge(&a, &b);
+  EXPECT_EQ(a.srtt_us_max, 45000u);
+}
+
+} // namespace
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
@@ -0,0 +1 @@
+#include "odin/xqc_flush_timer.c" // NOLINT(bugprone-suspicious-include)
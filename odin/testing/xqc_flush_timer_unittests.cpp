@@ -0,0 +1,230 @@
+// odin/testing/xqc_flush_timer_unittests.cpp
+//
+// Unit tests T9-T11 from §5 of odin/docs/rfc_035_xqc_write_coalescing.md.
+//
+// T9 and T10 drive a real xqc stream transport over a fake xqc_stream_t (the
+// RFC-016 test ops) on a real odin_event_loop with a fake clock, so the
+// loop-backed ops are exercised exactly as the runtimes install them.
+
+#include "odin/xqc_flush_timer.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "odin/event_loop.h"
+#include "odin/testing/event_loop_internal_test.h"
+#include "odin/transport.h"
+#include "odin/transport_xqc.h"
+#if defined(ODIN_TRANSPORT_XQC_TESTING)
+#include "odin/testing/transport_xqc_internal_test.h"
+#endif
+
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(misc-const-correctness, misc-use-internal-linkage)
+
+#if defined(ODIN_TRANSPORT_XQC_TESTING)
+namespace {
+
+constexpr uint64_t kNow = 1000000;
+
+std::vector<std::string> g_sends;
+
+ssize_t FakeSend(xqc_stream_t *stream, unsigned char *send_data,
+                 size_t send_data_size, uint8_t fin) {
+  (void)stream;
+  (void)fin;
+  g_sends.emplace_back(reinterpret_cast<const char *>(send_data),
+                       send_data_size);
+  return static_cast<ssize_t>(send_data_size);
+}
+
+ssize_t FakeRecv(xqc_stream_t *stream, unsigned char *recv_buf,
+                 size_t recv_buf_size, uint8_t *fin) {
+  (void)stream;
+  (void)recv_buf;
+  (void)recv_buf_size;
+  *fin = 0;
+  return -XQC_EAGAIN;
+}
+
+void FakeSetUserData(xqc_stream_t *stream, void *user_data) {
+  (void)stream;
+  (void)user_data;
+}
+
+struct Ready {
+  std::vector<unsigned int> events;
+};
+
+void OnReady(odin_transport_t *t, unsigned int events, void *user_data) {
+  (void)t;
+  static_cast<Ready *>(user_data)->events.push_back(events);
+}
+
+// Probe that answers `unacked` and stops the loop on every call, so one run
+// covers exactly one expiry.
+struct Probe {
+  odin_event_loop_t *loop = nullptr;
+  uint64_t unacked = 0;
+  int calls = 0;
+};
+
+uint64_t ProbeUnacked(void *ctx) {
+  Probe *probe = static_cast<Probe *>(ctx);
+  probe->calls += 1;
+  odin_event_loop_stop(probe->loop);
+  return probe->unacked;
+}
+
+void StopCb(odin_event_loop_t *loop, odin_event_timer_t *timer,
+            void *user_data) {
+  (void)timer;
+  (void)user_data;
+  odin_event_loop_stop(loop);
+}
+
+struct Fixture {
+  odin_event_loop_t *loop = nullptr;
+  int stream_storage = 0;
+  Ready ready;
+  odin_transport_t *t = nullptr;
+
+  void Open() {
+    static const odin_xqc_stream_transport_test_ops_t kOps = {
+        FakeRecv,
+        FakeSend,
+        FakeSetUserData,
+    };
+    odin_xqc_stream_transport_test_set_ops(&kOps);
+    g_sends.clear();
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    odin_event_loop_test_set_now_us(loop, kNow);
+    ASSERT_EQ(odin_xqc_stream_transport_create(
+                  reinterpret_cast<xqc_stream_t *>(&stream_storage), OnReady,
+                  &ready, &t),
+              0)
+        << std::strerror(errno);
+    odin_xqc_flush_timer_install(t, loop);
+  }
+
+  // Runs the loop with the clock at at_us; a one-shot stop timer queued behind
+  // every timer already due ends the run.
+  void RunAt(uint64_t at_us) {
+    odin_event_timer_t *stop = nullptr;
+    ASSERT_EQ(odin_event_timer_start(loop, at_us - kNow, 0, StopCb, nullptr,
+                                     &stop),
+              0);
+    odin_event_loop_test_set_now_us(loop, at_us);
+    EXPECT_EQ(odin_event_loop_run(loop), 0) << std::strerror(errno);
+  }
+
+  ~Fixture() {
+    if (t != nullptr) {
+      odin_transport_destroy(t);
+    }
+    if (loop != nullptr) {
+      odin_event_loop_destroy(loop);
+    }
+    odin_xqc_stream_transport_test_set_ops(nullptr);
+  }
+};
+
+odin_transport_io_t Write(odin_transport_t *t, const std::string &data) {
+  size_t n = 0;
+  return odin_transport_write(t, data.data(), data.size(), &n);
+}
+
+} // namespace
+
+// T9 — the coalescing window is a loop timer: its expiry sends the buffered
+// bytes, and the spent timer is released.
+TEST(OdinXqcFlushTimerTest, T9WindowExpiresOnTheLoop) {
+  Fixture f;
+  ASSERT_NO_FATAL_FAILURE(f.Open());
+
+  ASSERT_EQ(Write(f.t, "a"), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(Write(f.t, "bc"), ODIN_TRANSPORT_OK);
+  ASSERT_EQ(g_sends.size(), 1u);
+  EXPECT_EQ(odin_event_loop_test_live_timer_count(f.loop), 1u);
+
+  ASSERT_NO_FATAL_FAILURE(f.RunAt(kNow + ODIN_XQC_COALESCE_DELAY_US));
+  ASSERT_EQ(g_sends.size(), 2u);
+  EXPECT_EQ(g_sends[1], "bc");
+  EXPECT_EQ(odin_event_loop_test_live_timer_count(f.loop), 0u);
+}
+
+// T10 — a throttled stream re-arms from its expiry by restarting the same
+// timer: with every fresh timer start failing, the poll still continues, and
+// WRITE arrives once the probe drops below the low mark.
+TEST(OdinXqcFlushTimerTest, T10PollRestartsTheSameTimer) {
+  Fixture f;
+  ASSERT_NO_FATAL_FAILURE(f.Open());
+  Probe probe;
+  probe.loop = f.loop;
+  probe.unacked = ODIN_XQC_SEND_HIGH_WATER;
+  const odin_xqc_send_probe_t ops = {ProbeUnacked, nullptr, &probe};
+  odin_xqc_stream_transport_set_send_probe(f.t, &ops);
+
+  const std::string chunk(65536, 'c');
+  while (Write(f.t, chunk) == ODIN_TRANSPORT_OK) {
+  }
+  ASSERT_EQ(probe.calls, 1);
+  EXPECT_EQ(odin_event_loop_test_live_timer_count(f.loop), 1u);
+  ASSERT_EQ(odin_transport_set_interest(f.t, ODIN_TRANSPORT_WRITE), 0);
+  f.ready.events.clear();
+
+  ASSERT_EQ(odin_event_loop_test_fail_next_timer_start(f.loop, ENOMEM), 0);
+  odin_event_loop_test_set_now_us(f.loop, kNow + ODIN_XQC_SEND_POLL_US);
+  EXPECT_EQ(odin_event_loop_run(f.loop), 0) << std::strerror(errno);
+  EXPECT_EQ(probe.calls, 2);
+  EXPECT_TRUE(f.ready.events.empty());
+  EXPECT_EQ(odin_event_loop_test_live_timer_count(f.loop), 1u);
+  EXPECT_EQ(Write(f.t, "z"), ODIN_TRANSPORT_AGAIN);
+
+  probe.unacked = 0;
+  odin_event_loop_test_set_now_us(f.loop, kNow + 2 * ODIN_XQC_SEND_POLL_US);
+  EXPECT_EQ(odin_event_loop_run(f.loop), 0) << std::strerror(errno);
+  EXPECT_EQ(probe.calls, 3);
+  ASSERT_EQ(f.ready.events.size(), 1u);
+  EXPECT_EQ(f.ready.events[0], ODIN_TRANSPORT_WRITE);
+  EXPECT_EQ(odin_event_loop_test_live_timer_count(f.loop), 0u);
+}
+#endif
+
+// T11 — the send backlog counts what xquic accepted until the connection's
+// sent-less-in-flight bytes show it gone, so bytes still queued behind the
+// congestion window count even while nothing is in flight.
+TEST(OdinXqcFlushTimerTest, T11BacklogCountsQueuedBytes) {
+  odin_xqc_send_backlog_t b;
+  std::memset(&b, 0, sizeof(b));
+  xqc_conn_stats_t st;
+  std::memset(&st, 0, sizeof(st));
+  odin_xqc_send_backlog_accepted(&b, ODIN_XQC_SEND_HIGH_WATER);
+  EXPECT_EQ(odin_xqc_send_backlog_update(&b, &st),
+            uint64_t{ODIN_XQC_SEND_HIGH_WATER});
+
+  // 1 MiB sent over two paths, a quarter of it still in flight.
+  st.paths_info[0].path_send_bytes = 786432;
+  st.paths_info[1].path_send_bytes = 262144;
+  st.inflight_bytes = 262144;
+  EXPECT_EQ(odin_xqc_send_backlog_update(&b, &st),
+            uint64_t{ODIN_XQC_SEND_HIGH_WATER} - 786432);
+  EXPECT_EQ(odin_xqc_send_backlog_update(&b, &st),
+            uint64_t{ODIN_XQC_SEND_HIGH_WATER} - 786432);
+
+  // Headers and retransmissions make progress outrun the accepted bytes: the
+  // estimate stops at zero and never reports less than in flight.
+  st.paths_info[0].path_send_bytes = 2 * uint64_t{ODIN_XQC_SEND_HIGH_WATER};
+  st.inflight_bytes = 4096;
+  EXPECT_EQ(odin_xqc_send_backlog_update(&b, &st), 4096u);
+  EXPECT_EQ(b.held, 0u);
+  odin_xqc_send_backlog_accepted(&b, 100);
+  EXPECT_EQ(odin_xqc_send_backlog_update(&b, &st), 4096u);
+  EXPECT_EQ(b.held, 100u);
+}
+
+// NOLINTEND(misc-const-correctness, misc-use-internal-linkage)
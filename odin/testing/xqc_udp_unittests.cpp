@@ -1,7 +1,8 @@
 // odin/testing/xqc_udp_unittests.cpp
 //
 // Unit and integration tests T1-T20 from §5 of
-// odin/docs/rfc_017_xqc_udp_event_driver.md.
+// odin/docs/rfc_017_xqc_udp_event_driver.md, plus T6 from §5 of
+// odin/docs/rfc_050_qlog.md.
 //
 // Each test is gated by the ODIN_XQC_UDP_RED environment variable during P1
 // red verification: with the variable unset, the test SKIPs (so the default
@@ -19,8 +20,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <fstream>
 #include <functional>
 #include <netinet/in.h>
+#include <sstream>
 #include <string>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -29,6 +32,7 @@
 #include <vector>
 
 #include "odin/event_loop.h"
+#include "odin/qlog.h"
 #include "odin/testing/event_loop_internal_test.h"
 #include "odin/testing/udp_internal_test.h"
 #include "odin/udp.h"
@@ -136,6 +140,11 @@ struct FakeXqc {
   bool create_returns_null = false;
   xqc_engine_t *engine_handle = nullptr;
   void *engine_user_data = nullptr;
+  const xqc_config_t *engine_config = nullptr;
+  int cfg_log_event = -1;
+  qlog_event_importance_t cfg_qlog_importance = EVENT_IMPORTANCE_SELECTED;
+  void (*qlog_event_write)(qlog_event_importance_t, const void *, size_t,
+                           void *) = nullptr;
 
   int engine_create_calls = 0;
   int engine_destroy_calls = 0;
@@ -171,13 +180,19 @@ xqc_engine_t *FakeEngineCreate(xqc_engine_type_t engine_type,
                                const xqc_transport_callbacks_t *transport_cbs,
                                void *user_data) {
   (void)engine_type;
-  (void)engine_config;
   (void)ssl_config;
   if (g_fake == nullptr) {
     return nullptr;
   }
   g_fake->engine_create_calls += 1;
   g_fake->engine_user_data = user_data;
+  g_fake->engine_config = engine_config;
+  if (engine_config != nullptr) {
+    g_fake->cfg_log_event = static_cast<int>(engine_config->cfg_log_event);
+    g_fake->cfg_qlog_importance = engine_config->cfg_qlog_importance;
+  }
+  g_fake->qlog_event_write =
+      engine_callback->log_callbacks.xqc_qlog_event_write;
   g_fake->set_event_timer = engine_callback->set_event_timer;
   g_fake->monotonic_ts = engine_callback->monotonic_ts;
   g_fake->stateless_reset = transport_cbs->stateless_reset;
@@ -1685,6 +1700,70 @@ TEST(OdinXqcUdpTest, T20) {
   });
 }
 
+// RFC-050 T6 — with a qlog ring, create turns on xquic's event log at EXTRA
+// importance and routes its lines into the ring; without one the engine
+// config passes through untouched.
+TEST(OdinXqcUdpQlogTest, T6EngineEventLogFeedsRing) {
+  XqcUdpRunDeadline::Run([] {
+    char path[] = "/tmp/odin_xqc_udp_qlog.XXXXXX";
+    const int path_fd = mkstemp(path);
+    ASSERT_NE(path_fd, -1) << std::strerror(errno);
+    close(path_fd);
+    odin_qlog_config_t qcfg;
+    std::memset(&qcfg, 0, sizeof(qcfg));
+    qcfg.path = path;
+    qcfg.sample_every = 1;
+    odin_qlog_t *log = nullptr;
+    ASSERT_EQ(odin_qlog_create(&qcfg, &log), 0) << std::strerror(errno);
+    odin_qlog_ring_t *ring = nullptr;
+    ASSERT_EQ(odin_qlog_ring_create(log, 0, &ring), 0);
+
+    FakeXqc fake;
+    fake.engine_handle = reinterpret_cast<xqc_engine_t *>(0x1000);
+    InstallFakeXqc(&fake);
+    odin_event_loop_t *loop = nullptr;
+    ASSERT_EQ(odin_event_loop_create(&loop), 0) << std::strerror(errno);
+    xqc_engine_callback_t eng_cbs = MakeEngineCallbacks();
+    xqc_transport_callbacks_t trans_cbs = MakeTransportCallbacks();
+    struct sockaddr_in local = Loopback4(0);
+    odin_xqc_udp_config_t cfg =
+        MakeConfig(loop, reinterpret_cast<struct sockaddr *>(&local),
+                   sizeof(local), &eng_cbs, &trans_cbs, nullptr);
+    odin_xqc_udp_t *xu = nullptr;
+    ASSERT_EQ(odin_xqc_udp_create(&cfg, &xu), 0) << std::strerror(errno);
+    EXPECT_EQ(fake.engine_config, nullptr);
+    EXPECT_EQ(fake.qlog_event_write, nullptr);
+    odin_xqc_udp_destroy(xu);
+
+    cfg.qlog = ring;
+    ASSERT_EQ(odin_xqc_udp_create(&cfg, &xu), 0) << std::strerror(errno);
+    EXPECT_NE(fake.engine_config, nullptr);
+    EXPECT_EQ(fake.cfg_log_event, 1);
+    EXPECT_EQ(fake.cfg_qlog_importance, EVENT_IMPORTANCE_CORE);
+    ASSERT_NE(fake.qlog_event_write, nullptr);
+    const uint8_t cid[2] = {0x0a, 0x0b};
+    ASSERT_EQ(odin_qlog_conn_begin(ring, cid, sizeof(cid), nullptr, 0), 1);
+    const char line[] = "[packet_received] |scid:0a0b|pn:7|\n";
+    fake.qlog_event_write(EVENT_IMPORTANCE_BASE, line, sizeof(line) - 1u,
+                          fake.engine_user_data);
+    odin_xqc_udp_destroy(xu);
+    odin_event_loop_destroy(loop);
+    ClearFakeXqc();
+
+    odin_qlog_ring_destroy(ring);
+    odin_qlog_destroy(log);
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream got;
+    got << in.rdbuf();
+    EXPECT_NE(got.str().find("\"group_id\":\"0a0b\",\"data\":{"
+                             "\"importance\":2,\"line\":"
+                             "\"[packet_received] |scid:0a0b|pn:7|\"}}"),
+              std::string::npos)
+        << got.str();
+    (void)std::remove(path);
+  });
+}
+
 #endif // ODIN_XQC_UDP_TESTING
 
 // NOLINTEND(misc-const-correctness, misc-use-internal-linkage,
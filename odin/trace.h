@@ -0,0 +1,50 @@
+/* odin/trace.h
+ *
+ * USDT static tracepoints (RFC-048).
+ *
+ * ODIN_TRACEn(name, args...) marks a probe point named name under the "odin"
+ * provider. With the GN arg odin_usdt = true (which defines ODIN_USDT) on
+ * Linux, each expands to a <sys/sdt.h> probe: a single NOP in the text plus
+ * an ELF note that bpftrace, perf, and SystemTap attach to at run time. The
+ * arguments are only placed in registers or memory; nothing is called and no
+ * branch is taken while no tracer is attached. In every other build the
+ * macros expand to nothing and never evaluate their arguments.
+ *
+ * Probe names use a double underscore where the tracer shows a dash (dtrace
+ * convention); bpftrace takes them as written, e.g. usdt:*:odin:dns__start.
+ * Every probe and its arguments are listed in
+ * odin/docs/rfc_048_usdt_tracepoints.md. Arguments must be integers or
+ * pointers.
+ */
+
+#ifndef ODIN_TRACE_H_
+#define ODIN_TRACE_H_
+
+#if defined(ODIN_USDT)
+#if !defined(__linux__)
+#error "ODIN_USDT probes are only supported on Linux"
+#endif
+#if defined(__has_include)
+#if !__has_include(<sys/sdt.h>)
+#error "ODIN_USDT needs <sys/sdt.h> (systemtap-sdt-dev)"
+#endif
+#endif
+#include <sys/sdt.h>
+
+#define ODIN_TRACE_ENABLED 1
+#define ODIN_TRACE1(name, a) DTRACE_PROBE1(odin, name, a)
+#define ODIN_TRACE2(name, a, b) DTRACE_PROBE2(odin, name, a, b)
+#define ODIN_TRACE3(name, a, b, c) DTRACE_PROBE3(odin, name, a, b, c)
+#define ODIN_TRACE4(name, a, b, c, d) DTRACE_PROBE4(odin, name, a, b, c, d)
+#else
+#define ODIN_TRACE_ENABLED 0
+/* sizeof keeps the arguments "used" without evaluating them. */
+#define ODIN_TRACE1(name, a) ((void)sizeof(a))
+#define ODIN_TRACE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define ODIN_TRACE3(name, a, b, c)                                             \
+  ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+#define ODIN_TRACE4(name, a, b, c, d)                                          \
+  ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c), (void)sizeof(d))
+#endif
+
+#endif /* ODIN_TRACE_H_ */
@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -21,17 +22,26 @@
 
 /* Internal state (§3.2.2). base is first so the cast in every slot is valid; fd
  * is not owned; io is the active watch (or NULL); cur is the current
- * ODIN_EVENT_* mask. */
+ * ODIN_EVENT_* mask; embedded marks caller storage (create_in) that destroy
+ * must not free. */
 typedef struct odin_fd_transport_t {
   odin_transport_t base;
   odin_event_loop_t *loop;
   int fd;
+  int embedded;
   odin_event_io_t *io;
   unsigned int cur;
   odin_transport_ready_cb on_ready;
   void *user_data;
 } odin_fd_transport_t;
 
+_Static_assert(sizeof(odin_fd_transport_t) <=
+                   sizeof(odin_fd_transport_storage_t),
+               "ODIN_FD_TRANSPORT_STORAGE_SIZE too small");
+_Static_assert(_Alignof(odin_fd_transport_t) <=
+                   _Alignof(odin_fd_transport_storage_t),
+               "odin_fd_transport_storage_t under-aligned");
+
 static void fd_on_io(odin_event_loop_t *loop, odin_event_io_t *io, int fd,
                      unsigned int events, void *user_data);
 
@@ -123,15 +133,18 @@ static int fd_error(odin_transport_t *t) {
   return err;
 }
 
-/* Stops any active watch and frees the implementation struct only; never closes
- * fd. Callable from within the readiness callback. */
+/* Stops any active watch and frees the implementation struct only (nothing
+ * for caller storage); never closes fd. Callable from within the readiness
+ * callback. */
 static void fd_destroy(odin_transport_t *t) {
   odin_fd_transport_t *s = (odin_fd_transport_t *)t;
   if (s->io != NULL) {
     odin_event_io_stop(s->io);
     s->io = NULL;
   }
-  free(s);
+  if (!s->embedded) {
+    free(s);
+  }
 }
 
 /* Translates the loop's ODIN_EVENT_* readiness to the equal-valued
@@ -159,6 +172,17 @@ static const odin_transport_vtable_t fd_vtable = {
     fd_read, fd_write, fd_shutdown_write, fd_set_interest, fd_error, fd_destroy,
 };
 
+static void fd_init(odin_fd_transport_t *s, odin_event_loop_t *loop, int fd,
+                    odin_transport_ready_cb on_ready, void *user_data) {
+  s->base.vt = &fd_vtable;
+  s->loop = loop;
+  s->fd = fd;
+  s->io = NULL;
+  s->cur = 0;
+  s->on_ready = on_ready;
+  s->user_data = user_data;
+}
+
 int odin_fd_transport_create(odin_event_loop_t *loop, int fd,
                              odin_transport_ready_cb on_ready, void *user_data,
                              odin_transport_t **out) {
@@ -167,17 +191,37 @@ int odin_fd_transport_create(odin_event_loop_t *loop, int fd,
     errno = ENOMEM;
     return -1;
   }
-  s->base.vt = &fd_vtable;
-  s->loop = loop;
-  s->fd = fd;
-  s->io = NULL;
-  s->cur = 0;
-  s->on_ready = on_ready;
-  s->user_data = user_data;
+  fd_init(s, loop, fd, on_ready, user_data);
   *out = &s->base;
   return 0;
 }
 
+void odin_fd_transport_create_in(odin_fd_transport_storage_t *storage,
+                                 odin_event_loop_t *loop, int fd,
+                                 odin_transport_ready_cb on_ready,
+                                 void *user_data, odin_transport_t **out) {
+  odin_fd_transport_t *s = (odin_fd_transport_t *)(void *)storage;
+  memset(s, 0, sizeof(*s));
+  fd_init(s, loop, fd, on_ready, user_data);
+  s->embedded = 1;
+  *out = &s->base;
+}
+
+int odin_fd_transport_is(const odin_transport_t *t) {
+  return t != NULL && t->vt == &fd_vtable;
+}
+
+odin_transport_io_t odin_fd_transport_read(odin_transport_t *t, void *buf,
+                                           size_t len, size_t *out_n) {
+  return fd_read(t, buf, len, out_n);
+}
+
+odin_transport_io_t odin_fd_transport_write(odin_transport_t *t,
+                                            const void *buf, size_t len,
+                                            size_t *out_n) {
+  return fd_write(t, buf, len, out_n);
+}
+
 #if defined(ODIN_TRANSPORT_FD_TESTING)
 int odin_fd_transport_test_io(odin_transport_t *t, odin_event_io_t **out) {
   odin_fd_transport_t *s = (odin_fd_transport_t *)t;
@@ -16,11 +16,25 @@
  * ENOMEM (returns -1, errno == ENOMEM, *out untouched). Preconditions: fd is a
  * caller-owned, nonblocking, connected stream socket; loop is a live loop owned
  * by the calling thread; on_ready is non-null. Owner-thread API.
+ *
+ * Caller storage: odin_fd_transport_create_in is create without the
+ * allocation -- it builds the transport inside caller-provided
+ * odin_fd_transport_storage_t, never fails, and the vtable destroy then stops
+ * the watch but releases nothing. The storage must stay valid and unmoved
+ * until destroy returns; it may be reused immediately afterwards.
+ *
+ * Identity (RFC-034): odin_fd_transport_is reports whether t was built by this
+ * module (vtable identity), and odin_fd_transport_read / _write are its read
+ * and write slots as direct calls, for a consumer such as the relay that
+ * specializes its pump on fd endpoints. Both require odin_fd_transport_is(t).
  */
 
 #ifndef ODIN_TRANSPORT_FD_H_
 #define ODIN_TRANSPORT_FD_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "odin/event_loop.h"
 #include "odin/transport.h"
 
@@ -28,10 +42,33 @@
 extern "C" {
 #endif
 
+/* Opaque storage sized and aligned for the implementation struct (checked at
+ * compile time in transport_fd.c). */
+#define ODIN_FD_TRANSPORT_STORAGE_SIZE 64u
+
+typedef union odin_fd_transport_storage_t {
+  unsigned char bytes[ODIN_FD_TRANSPORT_STORAGE_SIZE];
+  void *align_ptr;
+  uint64_t align_u64;
+} odin_fd_transport_storage_t;
+
 int odin_fd_transport_create(odin_event_loop_t *loop, int fd,
                              odin_transport_ready_cb on_ready, void *user_data,
                              odin_transport_t **out);
 
+void odin_fd_transport_create_in(odin_fd_transport_storage_t *storage,
+                                 odin_event_loop_t *loop, int fd,
+                                 odin_transport_ready_cb on_ready,
+                                 void *user_data, odin_transport_t **out);
+
+int odin_fd_transport_is(const odin_transport_t *t);
+
+odin_transport_io_t odin_fd_transport_read(odin_transport_t *t, void *buf,
+                                           size_t len, size_t *out_n);
+odin_transport_io_t odin_fd_transport_write(odin_transport_t *t,
+                                            const void *buf, size_t len,
+                                            size_t *out_n);
+
 #ifdef __cplusplus
 }
 #endif
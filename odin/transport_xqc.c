@@ -1,4 +1,7 @@
-/* odin/transport_xqc.c -- RFC-016 xqc_stream_t transport implementation. */
+/* odin/transport_xqc.c -- RFC-016 xqc_stream_t transport implementation.
+ *
+ * RFC-035 adds write coalescing, driven by the owner's flush-timer ops, and
+ * send watermarks, driven by the owner's send probe. */
 
 #include "odin/transport_xqc.h"
 
@@ -6,28 +9,53 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #if defined(ODIN_TRANSPORT_XQC_TESTING)
 #include "odin/testing/transport_xqc_internal_test.h"
 #endif
 
+/* One in-flight on_ready delivery. Frames live on the delivering call's stack
+ * and are chained from the transport; destroy flags every live frame so each
+ * delivery unwinds without touching the (already released) transport. */
+typedef struct odin_xqc_frame_t {
+  struct odin_xqc_frame_t *prev;
+  int destroyed;
+} odin_xqc_frame_t;
+
 typedef struct odin_xqc_stream_transport_t {
   odin_transport_t base;
   xqc_stream_t *stream;
   odin_transport_ready_cb on_ready;
   void *user_data;
+  odin_xqc_frame_t *frames;
   unsigned int interest;
   int err;
   int recv_eof_latched;
   int recv_eof_ready_pending;
   int read_ready_depth;
-  int callback_depth;
-  int destroy_pending;
   int fin_pending;
   int fin_sent;
+  int embedded;
+  odin_xqc_flush_timer_ops_t timer_ops; /* arm == NULL: coalescing off */
+  odin_xqc_send_probe_t probe;          /* unacked == NULL: no watermarks */
+  uint64_t coalesce_delay_us;
+  void *flush_timer; /* armed handle, NULL when idle */
+  uint64_t unacked;  /* last probe plus bytes xquic accepted since */
+  int throttled;     /* held at the high mark until below the low mark */
+  int send_blocked;  /* xquic refused bytes since the last write_notify */
+  size_t coalesce_len;
+  unsigned char coalesce_buf[ODIN_XQC_COALESCE_SIZE];
 } odin_xqc_stream_transport_t;
 
+_Static_assert(sizeof(odin_xqc_stream_transport_t) <=
+                   sizeof(odin_xqc_stream_transport_storage_t),
+               "ODIN_XQC_STREAM_TRANSPORT_STORAGE_SIZE too small");
+_Static_assert(_Alignof(odin_xqc_stream_transport_t) <=
+                   _Alignof(odin_xqc_stream_transport_storage_t),
+               "odin_xqc_stream_transport_storage_t under-aligned");
+
 #if defined(ODIN_TRANSPORT_XQC_TESTING)
 static odin_xqc_stream_transport_test_ops_t odin_xqc_test_ops;
 static int odin_xqc_test_fail_next_create_armed;
@@ -49,6 +77,11 @@ unsigned int odin_xqc_stream_transport_test_interest(odin_transport_t *t) {
   return s->interest;
 }
 
+size_t odin_xqc_stream_transport_test_coalesced(odin_transport_t *t) {
+  odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  return s->coalesce_len;
+}
+
 int odin_xqc_stream_transport_test_fail_next_create(int errnum) {
   odin_xqc_test_fail_next_create_armed = 1;
   odin_xqc_test_fail_next_create_errno = errnum;
@@ -100,29 +133,36 @@ static int odin_xqc_map_error(ssize_t ret) {
   return EIO;
 }
 
-static int odin_xqc_end_callback(odin_xqc_stream_transport_t *s) {
-  s->callback_depth -= 1;
-  if (s->callback_depth == 0 && s->destroy_pending) {
-    free(s);
+static void odin_xqc_begin_callback(odin_xqc_stream_transport_t *s,
+                                    odin_xqc_frame_t *frame) {
+  frame->prev = s->frames;
+  frame->destroyed = 0;
+  s->frames = frame;
+}
+
+/* Returns 1 when the transport was destroyed during the frame; s is then dead
+ * and the caller must return without touching it. */
+static int odin_xqc_end_callback(odin_xqc_stream_transport_t *s,
+                                 const odin_xqc_frame_t *frame) {
+  if (frame->destroyed) {
     return 1;
   }
+  s->frames = frame->prev;
   return 0;
 }
 
 static int odin_xqc_deliver_ready(odin_xqc_stream_transport_t *s,
                                   unsigned int events) {
-  if (s->destroy_pending) {
-    return 0;
-  }
-  s->callback_depth += 1;
+  odin_xqc_frame_t frame;
+  odin_xqc_begin_callback(s, &frame);
   s->on_ready(&s->base, events, s->user_data);
-  return odin_xqc_end_callback(s);
+  return odin_xqc_end_callback(s, &frame);
 }
 
 static int
 odin_xqc_deliver_pending_eof_ready_if_armed(odin_xqc_stream_transport_t *s) {
-  if (s->destroy_pending || !s->recv_eof_ready_pending ||
-      !(s->interest & ODIN_TRANSPORT_READ) || s->read_ready_depth != 0) {
+  if (!s->recv_eof_ready_pending || !(s->interest & ODIN_TRANSPORT_READ) ||
+      s->read_ready_depth != 0) {
     return 0;
   }
   s->recv_eof_ready_pending = 0;
@@ -131,17 +171,128 @@ odin_xqc_deliver_pending_eof_ready_if_armed(odin_xqc_stream_transport_t *s) {
 
 static int odin_xqc_deliver_write_kick_if_armed(odin_xqc_stream_transport_t *s,
                                                 unsigned int old_interest) {
-  if (s->destroy_pending || (old_interest & ODIN_TRANSPORT_WRITE) ||
+  if ((old_interest & ODIN_TRANSPORT_WRITE) ||
       !(s->interest & ODIN_TRANSPORT_WRITE)) {
     return 0;
   }
   return odin_xqc_deliver_ready(s, ODIN_TRANSPORT_WRITE);
 }
 
+static int odin_xqc_coalescing(const odin_xqc_stream_transport_t *s) {
+  return s->timer_ops.arm != NULL;
+}
+
+static int odin_xqc_watermarked(const odin_xqc_stream_transport_t *s) {
+  return s->timer_ops.arm != NULL && s->probe.unacked != NULL;
+}
+
+static void odin_xqc_cancel_flush_timer(odin_xqc_stream_transport_t *s) {
+  if (s->flush_timer != NULL) {
+    void *const timer = s->flush_timer;
+    s->flush_timer = NULL;
+    s->timer_ops.cancel(s->timer_ops.ctx, timer);
+  }
+}
+
+/* Counts n bytes xquic just accepted into the estimate and the probe. */
+static void odin_xqc_note_accepted(odin_xqc_stream_transport_t *s, size_t n) {
+  s->unacked += n;
+  if (s->probe.accepted != NULL) {
+    s->probe.accepted(s->probe.ctx, n);
+  }
+}
+
+/* Hands the coalesced bytes to xquic. OK once the buffer is empty; AGAIN with
+ * the unsent tail kept at the front of the buffer; IO_ERROR with errno set. */
+static odin_transport_io_t
+odin_xqc_flush_coalesced(odin_xqc_stream_transport_t *s) {
+  if (s->coalesce_len == 0) {
+    return ODIN_TRANSPORT_OK;
+  }
+  const ssize_t ret = odin_xqc_stream_send_call(s->stream, s->coalesce_buf,
+                                                s->coalesce_len, 0);
+  if (ret > 0 && (size_t)ret <= s->coalesce_len) {
+    const size_t n = (size_t)ret;
+    odin_xqc_note_accepted(s, n);
+    s->coalesce_len -= n;
+    if (s->coalesce_len != 0) {
+      memmove(s->coalesce_buf, s->coalesce_buf + n, s->coalesce_len);
+      s->send_blocked = 1;
+      return ODIN_TRANSPORT_AGAIN;
+    }
+    return ODIN_TRANSPORT_OK;
+  }
+  if (ret == -XQC_EAGAIN || ret == 0) {
+    s->send_blocked = 1;
+    return ODIN_TRANSPORT_AGAIN;
+  }
+  errno = (ret > 0) ? EIO : odin_xqc_map_error(ret);
+  return ODIN_TRANSPORT_IO_ERROR;
+}
+
+/* Arms the stream's one timer unless it is pending; spent is the handle that
+ * just expired when called from the expiry, else NULL. When arm fails the
+ * coalesced bytes go out now and the throttle lifts, so nothing waits on a
+ * timer that will never fire. */
+static void odin_xqc_arm_flush_timer(odin_xqc_stream_transport_t *s,
+                                     void *spent, uint64_t delay_us) {
+  if (s->flush_timer != NULL) {
+    return;
+  }
+  s->flush_timer =
+      s->timer_ops.arm(s->timer_ops.ctx, spent, delay_us, &s->base);
+  if (s->flush_timer != NULL) {
+    return;
+  }
+  s->throttled = 0;
+  if (odin_xqc_flush_coalesced(s) == ODIN_TRANSPORT_IO_ERROR) {
+    s->err = errno;
+  }
+}
+
+/* Write-side watermark gate: 1 while the stream is throttled. The estimate only
+ * grows between probes, so reaching the high mark re-probes before refusing. */
+static int odin_xqc_at_high_water(odin_xqc_stream_transport_t *s) {
+  if (!odin_xqc_watermarked(s) || s->throttled) {
+    return s->throttled;
+  }
+  if (s->unacked < ODIN_XQC_SEND_HIGH_WATER) {
+    return 0;
+  }
+  s->unacked = s->probe.unacked(s->probe.ctx);
+  if (s->unacked < ODIN_XQC_SEND_HIGH_WATER) {
+    return 0;
+  }
+  s->throttled = 1;
+  odin_xqc_arm_flush_timer(s, NULL, ODIN_XQC_SEND_POLL_US);
+  return s->throttled;
+}
+
+/* Readiness-side watermark gate: re-probes a throttled stream and lifts the
+ * throttle once xquic holds less than the low mark. */
+static void odin_xqc_release_below_low_water(odin_xqc_stream_transport_t *s) {
+  if (!s->throttled) {
+    return;
+  }
+  s->unacked = s->probe.unacked(s->probe.ctx);
+  if (s->unacked < ODIN_XQC_SEND_LOW_WATER) {
+    s->throttled = 0;
+  }
+}
+
 static void odin_xqc_retry_pending_fin(odin_xqc_stream_transport_t *s) {
   if (!s->fin_pending) {
     return;
   }
+  const odin_transport_io_t io = odin_xqc_flush_coalesced(s);
+  if (io == ODIN_TRANSPORT_AGAIN) {
+    return;
+  }
+  if (io == ODIN_TRANSPORT_IO_ERROR) {
+    s->fin_pending = 0;
+    s->err = errno;
+    return;
+  }
   const ssize_t ret = odin_xqc_stream_send_call(s->stream, NULL, 0, 1);
   if (ret >= 0) {
     s->fin_pending = 0;
@@ -192,6 +343,13 @@ static odin_transport_io_t odin_xqc_read(odin_transport_t *t, void *buf,
   return ODIN_TRANSPORT_IO_ERROR;
 }
 
+/* With coalescing on, small writes follow Nagle's rule with the flush timer as
+ * the window: a small write with no window open goes straight to xquic and, if
+ * fully accepted, opens one; small writes inside the window join the buffer,
+ * which the timer's expiry sends as one frame. Nothing is buffered while xquic
+ * is refusing bytes, so its backpressure reaches the caller unchanged. A write
+ * that does not fit flushes the buffer first, so bytes reach xquic in order.
+ * Direct sends are clipped to the room left below the high mark. */
 static odin_transport_io_t odin_xqc_write(odin_transport_t *t, const void *buf,
                                           size_t len, size_t *out_n) {
   odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
@@ -199,6 +357,39 @@ static odin_transport_io_t odin_xqc_write(odin_transport_t *t, const void *buf,
     *out_n = 0;
     return ODIN_TRANSPORT_OK;
   }
+  const int coalescing = odin_xqc_coalescing(s);
+  const int small = len < ODIN_XQC_COALESCE_SIZE;
+  if (coalescing) {
+    if (s->err != 0) {
+      errno = s->err;
+      return ODIN_TRANSPORT_IO_ERROR;
+    }
+    if (odin_xqc_at_high_water(s)) {
+      return ODIN_TRANSPORT_AGAIN;
+    }
+    if (!s->send_blocked && (s->coalesce_len != 0 || s->flush_timer != NULL) &&
+        len <= ODIN_XQC_COALESCE_SIZE - s->coalesce_len) {
+      memcpy(s->coalesce_buf + s->coalesce_len, buf, len);
+      s->coalesce_len += len;
+      *out_n = len;
+      if (s->coalesce_len == ODIN_XQC_COALESCE_SIZE &&
+          odin_xqc_flush_coalesced(s) == ODIN_TRANSPORT_IO_ERROR) {
+        s->err = errno;
+      }
+      return ODIN_TRANSPORT_OK;
+    }
+    const odin_transport_io_t io = odin_xqc_flush_coalesced(s);
+    if (io != ODIN_TRANSPORT_OK) {
+      return io;
+    }
+    if (odin_xqc_at_high_water(s)) { /* the flush may reach the mark */
+      return ODIN_TRANSPORT_AGAIN;
+    }
+    if (odin_xqc_watermarked(s) &&
+        len > ODIN_XQC_SEND_HIGH_WATER - s->unacked) {
+      len = (size_t)(ODIN_XQC_SEND_HIGH_WATER - s->unacked);
+    }
+  }
 
   const ssize_t ret =
       odin_xqc_stream_send_call(s->stream, (unsigned char *)buf, len, 0);
@@ -207,10 +398,19 @@ static odin_transport_io_t odin_xqc_write(odin_transport_t *t, const void *buf,
       errno = EIO;
       return ODIN_TRANSPORT_IO_ERROR;
     }
+    if (coalescing) {
+      odin_xqc_note_accepted(s, (size_t)ret);
+      if ((size_t)ret < len) {
+        s->send_blocked = 1;
+      } else if (small) {
+        odin_xqc_arm_flush_timer(s, NULL, s->coalesce_delay_us); /* window */
+      }
+    }
     *out_n = (size_t)ret;
     return ODIN_TRANSPORT_OK;
   }
   if (ret == -XQC_EAGAIN || ret == 0) {
+    s->send_blocked = 1;
     return ODIN_TRANSPORT_AGAIN;
   }
   errno = odin_xqc_map_error(ret);
@@ -222,6 +422,14 @@ static int odin_xqc_shutdown_write(odin_transport_t *t) {
   if (s->fin_sent || s->fin_pending) {
     return 0;
   }
+  const odin_transport_io_t io = odin_xqc_flush_coalesced(s);
+  if (io == ODIN_TRANSPORT_AGAIN) {
+    s->fin_pending = 1; /* write_notify sends the tail, then the fin */
+    return 0;
+  }
+  if (io == ODIN_TRANSPORT_IO_ERROR) {
+    return -1;
+  }
   const ssize_t ret = odin_xqc_stream_send_call(s->stream, NULL, 0, 1);
   if (ret >= 0) {
     s->fin_sent = 1;
@@ -262,14 +470,20 @@ static int odin_xqc_error(odin_transport_t *t) {
   return s->err;
 }
 
+/* Sends nothing: destroy may run inside xquic's stream_close_notify, where
+ * xqc_stream_send must not be called. Owners that may still send flush first;
+ * the rest read odin_xqc_stream_transport_unsent to count the loss. */
 static void odin_xqc_destroy(odin_transport_t *t) {
   odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  odin_xqc_cancel_flush_timer(s);
   odin_xqc_stream_set_user_data_call(s->stream, NULL);
-  if (s->callback_depth != 0) {
-    s->destroy_pending = 1;
-    return;
+  for (odin_xqc_frame_t *frame = s->frames; frame != NULL;
+       frame = frame->prev) {
+    frame->destroyed = 1;
+  }
+  if (!s->embedded) {
+    free(s);
   }
-  free(s);
 }
 
 static const odin_transport_vtable_t odin_xqc_stream_transport_vtable = {
@@ -277,10 +491,8 @@ static const odin_transport_vtable_t odin_xqc_stream_transport_vtable = {
     odin_xqc_set_interest, odin_xqc_error, odin_xqc_destroy,
 };
 
-int odin_xqc_stream_transport_create(xqc_stream_t *stream,
-                                     odin_transport_ready_cb on_ready,
-                                     void *user_data, odin_transport_t **out) {
 #if defined(ODIN_TRANSPORT_XQC_TESTING)
+static int odin_xqc_take_fail_next_create(void) {
   if (odin_xqc_test_fail_next_create_armed) {
     const int errnum = odin_xqc_test_fail_next_create_errno;
     odin_xqc_test_fail_next_create_armed = 0;
@@ -288,6 +500,42 @@ int odin_xqc_stream_transport_create(xqc_stream_t *stream,
     errno = errnum;
     return -1;
   }
+  return 0;
+}
+#endif
+
+static void odin_xqc_init(odin_xqc_stream_transport_t *s, xqc_stream_t *stream,
+                          odin_transport_ready_cb on_ready, void *user_data) {
+  s->base.vt = &odin_xqc_stream_transport_vtable;
+  s->stream = stream;
+  s->on_ready = on_ready;
+  s->user_data = user_data;
+  odin_xqc_stream_set_user_data_call(stream, &s->base);
+}
+
+int odin_xqc_stream_transport_is(const odin_transport_t *t) {
+  return t != NULL && t->vt == &odin_xqc_stream_transport_vtable;
+}
+
+odin_transport_io_t odin_xqc_stream_transport_read(odin_transport_t *t,
+                                                   void *buf, size_t len,
+                                                   size_t *out_n) {
+  return odin_xqc_read(t, buf, len, out_n);
+}
+
+odin_transport_io_t odin_xqc_stream_transport_write(odin_transport_t *t,
+                                                    const void *buf,
+                                                    size_t len, size_t *out_n) {
+  return odin_xqc_write(t, buf, len, out_n);
+}
+
+int odin_xqc_stream_transport_create(xqc_stream_t *stream,
+                                     odin_transport_ready_cb on_ready,
+                                     void *user_data, odin_transport_t **out) {
+#if defined(ODIN_TRANSPORT_XQC_TESTING)
+  if (odin_xqc_take_fail_next_create() != 0) {
+    return -1;
+  }
 #endif
   odin_xqc_stream_transport_t *s =
       (odin_xqc_stream_transport_t *)calloc(1, sizeof(*s));
@@ -295,15 +543,109 @@ int odin_xqc_stream_transport_create(xqc_stream_t *stream,
     errno = ENOMEM;
     return -1;
   }
-  s->base.vt = &odin_xqc_stream_transport_vtable;
-  s->stream = stream;
-  s->on_ready = on_ready;
-  s->user_data = user_data;
-  odin_xqc_stream_set_user_data_call(stream, &s->base);
+  odin_xqc_init(s, stream, on_ready, user_data);
   *out = &s->base;
   return 0;
 }
 
+int odin_xqc_stream_transport_create_in(
+    odin_xqc_stream_transport_storage_t *storage, xqc_stream_t *stream,
+    odin_transport_ready_cb on_ready, void *user_data, odin_transport_t **out) {
+#if defined(ODIN_TRANSPORT_XQC_TESTING)
+  if (odin_xqc_take_fail_next_create() != 0) {
+    return -1;
+  }
+#endif
+  odin_xqc_stream_transport_t *s =
+      (odin_xqc_stream_transport_t *)(void *)storage;
+  memset(s, 0, sizeof(*s));
+  s->embedded = 1;
+  odin_xqc_init(s, stream, on_ready, user_data);
+  *out = &s->base;
+  return 0;
+}
+
+void odin_xqc_stream_transport_set_flush_timer(
+    odin_transport_t *t, const odin_xqc_flush_timer_ops_t *ops,
+    uint64_t delay_us) {
+  odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  s->timer_ops = *ops;
+  s->coalesce_delay_us = delay_us;
+}
+
+void odin_xqc_stream_transport_set_send_probe(
+    odin_transport_t *t, const odin_xqc_send_probe_t *probe) {
+  odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  s->probe = *probe;
+}
+
+int odin_xqc_stream_transport_flush(odin_transport_t *t) {
+  odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  if (s->err != 0) {
+    errno = s->err;
+    return -1;
+  }
+  if (s->fin_pending) {
+    odin_xqc_retry_pending_fin(s);
+    if (s->err != 0) {
+      errno = s->err;
+      return -1;
+    }
+    if (s->fin_pending) {
+      errno = EAGAIN;
+      return -1;
+    }
+    return 0;
+  }
+  switch (odin_xqc_flush_coalesced(s)) {
+  case ODIN_TRANSPORT_OK:
+    return 0;
+  case ODIN_TRANSPORT_AGAIN:
+    errno = EAGAIN;
+    return -1;
+  case ODIN_TRANSPORT_EOF:
+  case ODIN_TRANSPORT_IO_ERROR:
+    break;
+  }
+  s->err = errno;
+  return -1;
+}
+
+size_t odin_xqc_stream_transport_unsent(const odin_transport_t *t) {
+  const odin_xqc_stream_transport_t *s =
+      (const odin_xqc_stream_transport_t *)t;
+  return s->coalesce_len;
+}
+
+/* Expiry flushes the window and re-probes a throttled stream: once xquic holds
+ * less than the low mark the owner is told it may write again, otherwise the
+ * same timer is re-armed to probe later. */
+void odin_xqc_stream_transport_flush_timer_fired(odin_transport_t *t) {
+  odin_xqc_stream_transport_t *s = (odin_xqc_stream_transport_t *)t;
+  void *const spent = s->flush_timer;
+  s->flush_timer = NULL;
+  const int throttled = s->throttled;
+  odin_xqc_release_below_low_water(s);
+  if (s->throttled) {
+    odin_xqc_arm_flush_timer(s, spent, ODIN_XQC_SEND_POLL_US);
+  }
+  if (s->fin_pending) {
+    odin_xqc_retry_pending_fin(s);
+  } else if (odin_xqc_flush_coalesced(s) == ODIN_TRANSPORT_IO_ERROR) {
+    s->err = errno;
+  }
+  if (s->err != 0) {
+    if (s->interest != 0) {
+      (void)odin_xqc_deliver_ready(s, ODIN_TRANSPORT_ERROR);
+    }
+    return;
+  }
+  if (throttled && !s->throttled && s->coalesce_len == 0 &&
+      (s->interest & ODIN_TRANSPORT_WRITE)) {
+    (void)odin_xqc_deliver_ready(s, ODIN_TRANSPORT_WRITE);
+  }
+}
+
 xqc_int_t odin_xqc_stream_transport_read_notify(xqc_stream_t *stream,
                                                 void *strm_user_data) {
   (void)stream;
@@ -313,13 +655,14 @@ xqc_int_t odin_xqc_stream_transport_read_notify(xqc_stream_t *stream,
   odin_xqc_stream_transport_t *s =
       (odin_xqc_stream_transport_t *)strm_user_data;
   if (s->interest & ODIN_TRANSPORT_READ) {
-    s->callback_depth += 1;
+    odin_xqc_frame_t frame;
+    odin_xqc_begin_callback(s, &frame);
     s->read_ready_depth += 1;
     s->on_ready(&s->base, ODIN_TRANSPORT_READ, s->user_data);
-    s->read_ready_depth -= 1;
-    if (odin_xqc_end_callback(s)) {
+    if (odin_xqc_end_callback(s, &frame)) {
       return XQC_OK;
     }
+    s->read_ready_depth -= 1;
     (void)odin_xqc_deliver_pending_eof_ready_if_armed(s);
   }
   return XQC_OK;
@@ -333,14 +676,21 @@ xqc_int_t odin_xqc_stream_transport_write_notify(xqc_stream_t *stream,
   }
   odin_xqc_stream_transport_t *s =
       (odin_xqc_stream_transport_t *)strm_user_data;
+  s->send_blocked = 0;
+  odin_xqc_release_below_low_water(s);
   if (s->fin_pending) {
     odin_xqc_retry_pending_fin(s);
     if (s->err != 0) {
       (void)odin_xqc_deliver_ready(s, ODIN_TRANSPORT_ERROR);
       return XQC_OK;
     }
+  } else if (odin_xqc_flush_coalesced(s) == ODIN_TRANSPORT_IO_ERROR) {
+    s->err = errno;
+    (void)odin_xqc_deliver_ready(s, ODIN_TRANSPORT_ERROR);
+    return XQC_OK;
   }
-  if ((s->interest & ODIN_TRANSPORT_WRITE) && !s->destroy_pending) {
+  if ((s->interest & ODIN_TRANSPORT_WRITE) && s->coalesce_len == 0 &&
+      !s->throttled) {
     (void)odin_xqc_deliver_ready(s, ODIN_TRANSPORT_WRITE);
   }
   return XQC_OK;
@@ -7,11 +7,58 @@
  * read/write/readiness callbacks to odin_transport_t and must be destroyed
  * while the xqc_stream_t is still valid so destroy can clear the stream
  * user-data slot it installed.
+ *
+ * Destroy is immediate, including from inside on_ready: every in-flight
+ * readiness delivery is flagged and unwinds without touching the transport
+ * again. odin_xqc_stream_transport_create_in builds the transport inside
+ * caller-provided odin_xqc_stream_transport_storage_t; destroy then releases
+ * nothing, and the storage may be reused as soon as destroy returns.
+ *
+ * Write coalescing (RFC-035): once the owner installs flush-timer ops with
+ * odin_xqc_stream_transport_set_flush_timer, writes that fit in the
+ * ODIN_XQC_COALESCE_SIZE buffer are accepted into it instead of being sent, and
+ * the buffer is handed to xquic as one send when it fills, when a write does
+ * not fit, on shutdown_write, on write_notify, when the timer expires, and
+ * on odin_xqc_stream_transport_flush. WRITE readiness is delivered only
+ * while the coalescing buffer is empty. Without ops the transport sends every
+ * write straight through, as before.
+ *
+ * Send watermarks (RFC-035): once the owner also installs a send probe with
+ * odin_xqc_stream_transport_set_send_probe, write returns AGAIN while the bytes
+ * xquic holds for the stream's connection -- queued behind the congestion
+ * window or sent and not yet acknowledged -- are at or above
+ * ODIN_XQC_SEND_HIGH_WATER, and WRITE readiness returns only once they fall
+ * below ODIN_XQC_SEND_LOW_WATER. The transport keeps a running estimate (the
+ * last probe plus every byte xquic has accepted since) and probes only when the
+ * estimate reaches the high mark, on write_notify, and on timer expiry while
+ * throttled; a throttled stream re-probes every ODIN_XQC_SEND_POLL_US. Every
+ * byte xquic accepts is also reported to the probe's accepted hook, so the
+ * owner can count what it queued across the connection's streams.
+ *
+ * The ops keep the transport free of any event-loop dependency: arm starts a
+ * one-shot timer of delay_us and returns its handle (NULL on failure, in which
+ * case the transport flushes at once and drops any throttle); on expiry the
+ * owner calls odin_xqc_stream_transport_flush_timer_fired(t) exactly once,
+ * after which the handle is dead unless the transport re-arms from inside that
+ * call, when arm receives it back and may restart it in place. A stream
+ * therefore holds at most one timer. cancel is called only on a live handle,
+ * including from destroy.
+ *
+ * Destroy never calls xqc_stream_send, since it may run inside xquic's
+ * stream_close_notify, and so drops whatever the transport still holds: the
+ * coalesced bytes and a fin that xquic refused. An owner that may still send
+ * drains them first with odin_xqc_stream_transport_flush, so bytes already
+ * accepted by write (such as a final error response) reach xquic ahead of the
+ * close; an owner destroying from inside xquic's close callbacks reads
+ * odin_xqc_stream_transport_unsent to count what is lost.
  */
 
 #ifndef ODIN_TRANSPORT_XQC_H_
 #define ODIN_TRANSPORT_XQC_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "odin/transport.h"
 #include <xquic/xquic.h>
 
@@ -19,10 +66,88 @@
 extern "C" {
 #endif
 
+/* Opaque storage sized and aligned for the implementation struct (checked at
+ * compile time in transport_xqc.c). */
+#define ODIN_XQC_STREAM_TRANSPORT_STORAGE_SIZE 1376u
+
+/* Coalescing buffer: one full STREAM frame in a 1252-byte datagram. */
+#define ODIN_XQC_COALESCE_SIZE 1200u
+
+/* Default flush-timer delay for coalesced bytes. */
+#define ODIN_XQC_COALESCE_DELAY_US 200u
+
+/* Watermarks on the bytes xquic holds queued or unacknowledged for the
+ * connection: writes stop at the high mark and resume below the low mark. */
+#define ODIN_XQC_SEND_HIGH_WATER 8388608u
+#define ODIN_XQC_SEND_LOW_WATER 4194304u
+
+/* Re-probe interval for a stream held at the high mark. */
+#define ODIN_XQC_SEND_POLL_US 1000u
+
+typedef union odin_xqc_stream_transport_storage_t {
+  unsigned char bytes[ODIN_XQC_STREAM_TRANSPORT_STORAGE_SIZE];
+  void *align_ptr;
+  uint64_t align_u64;
+} odin_xqc_stream_transport_storage_t;
+
+typedef struct odin_xqc_flush_timer_ops_t {
+  void *(*arm)(void *ctx, void *timer, uint64_t delay_us, odin_transport_t *t);
+  void (*cancel)(void *ctx, void *timer);
+  void *ctx;
+} odin_xqc_flush_timer_ops_t;
+
+/* unacked reports the bytes xquic holds for the stream's connection that the
+ * peer has not yet acknowledged, counting those still queued to be sent.
+ * accepted, when non-NULL, is told of every n bytes xquic accepts from the
+ * stream. */
+typedef struct odin_xqc_send_probe_t {
+  uint64_t (*unacked)(void *ctx);
+  void (*accepted)(void *ctx, size_t n);
+  void *ctx;
+} odin_xqc_send_probe_t;
+
 int odin_xqc_stream_transport_create(xqc_stream_t *stream,
                                      odin_transport_ready_cb on_ready,
                                      void *user_data, odin_transport_t **out);
 
+int odin_xqc_stream_transport_create_in(
+    odin_xqc_stream_transport_storage_t *storage, xqc_stream_t *stream,
+    odin_transport_ready_cb on_ready, void *user_data, odin_transport_t **out);
+
+/* Enables coalescing on t (ops copied). */
+void odin_xqc_stream_transport_set_flush_timer(
+    odin_transport_t *t, const odin_xqc_flush_timer_ops_t *ops,
+    uint64_t delay_us);
+
+/* Enables the send watermarks on t (probe copied); they apply only while flush
+ * timer ops are installed too. */
+void odin_xqc_stream_transport_set_send_probe(
+    odin_transport_t *t, const odin_xqc_send_probe_t *probe);
+
+/* Flush-timer expiry: sends the coalesced bytes, re-probes a throttled stream,
+ * and may deliver WRITE or ERROR readiness. */
+void odin_xqc_stream_transport_flush_timer_fired(odin_transport_t *t);
+
+/* Hands any coalesced bytes, then a pending fin, to xquic now without
+ * delivering readiness. Returns 0 when nothing remains, or -1 with errno
+ * EAGAIN (the rest kept for write_notify) or the latched or mapped send error;
+ * a stream that has already failed sends nothing. */
+int odin_xqc_stream_transport_flush(odin_transport_t *t);
+
+/* Coalesced bytes write accepted that xquic has not; destroy drops them. */
+size_t odin_xqc_stream_transport_unsent(const odin_transport_t *t);
+
+/* Identity (RFC-034): reports whether t was built by this module (vtable
+ * identity). _read / _write are its read and write slots as direct calls, for
+ * the relay's pump; both require odin_xqc_stream_transport_is(t). */
+int odin_xqc_stream_transport_is(const odin_transport_t *t);
+odin_transport_io_t odin_xqc_stream_transport_read(odin_transport_t *t,
+                                                   void *buf, size_t len,
+                                                   size_t *out_n);
+odin_transport_io_t odin_xqc_stream_transport_write(odin_transport_t *t,
+                                                    const void *buf,
+                                                    size_t len, size_t *out_n);
+
 xqc_int_t odin_xqc_stream_transport_read_notify(xqc_stream_t *stream,
                                                 void *strm_user_data);
 xqc_int_t odin_xqc_stream_transport_write_notify(xqc_stream_t *stream,
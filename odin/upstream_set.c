@@ -0,0 +1,170 @@
+/* odin/upstream_set.c -- RFC-039 upstream server selection. */
+
+#include "odin/upstream_set.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct upstream_member_t {
+  odin_upstream_info_t info;
+  uint64_t last_sent;
+  uint64_t last_lost;
+} upstream_member_t;
+
+struct odin_upstream_set_t {
+  size_t count;
+  int preferred; /* last pick among UP servers, or -1 */
+  upstream_member_t members[ODIN_UPSTREAM_SET_MAX];
+};
+
+int odin_upstream_set_create(size_t count, odin_upstream_set_t **out) {
+  if (out == NULL || count == 0 || count > ODIN_UPSTREAM_SET_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  odin_upstream_set_t *set = (odin_upstream_set_t *)calloc(1, sizeof(*set));
+  if (set == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  set->count = count;
+  set->preferred = -1;
+  *out = set;
+  return 0;
+}
+
+void odin_upstream_set_observe(odin_upstream_set_t *set, size_t index,
+                               uint64_t srtt_us, uint64_t sent, uint64_t lost) {
+  if (set == NULL || index >= set->count) {
+    return;
+  }
+  upstream_member_t *m = &set->members[index];
+  if (m->info.state == ODIN_UPSTREAM_DOWN) {
+    return;
+  }
+  if (m->info.state == ODIN_UPSTREAM_CONNECTING) {
+    m->info.state = ODIN_UPSTREAM_UP;
+    m->info.failures = 0;
+  }
+  if (srtt_us != 0) {
+    m->info.srtt_us = srtt_us;
+  }
+  if (sent > m->last_sent && lost >= m->last_lost) {
+    const uint64_t d_sent = sent - m->last_sent;
+    uint64_t d_lost = lost - m->last_lost;
+    if (d_lost > d_sent) {
+      d_lost = d_sent;
+    }
+    const uint32_t sample = (uint32_t)(d_lost * 1000u / d_sent);
+    m->info.loss_permille = (m->info.loss_permille * 7u + sample) / 8u;
+  }
+  m->last_sent = sent;
+  m->last_lost = lost;
+}
+
+void odin_upstream_set_mark_down(odin_upstream_set_t *set, size_t index,
+                                 uint64_t now_ms) {
+  if (set == NULL || index >= set->count) {
+    return;
+  }
+  upstream_member_t *m = &set->members[index];
+  m->info.failures += 1;
+  uint64_t backoff = ODIN_UPSTREAM_RETRY_MIN_MS;
+  for (uint64_t i = 1;
+       i < m->info.failures && backoff < ODIN_UPSTREAM_RETRY_MAX_MS; ++i) {
+    backoff *= 2u;
+  }
+  if (backoff > ODIN_UPSTREAM_RETRY_MAX_MS) {
+    backoff = ODIN_UPSTREAM_RETRY_MAX_MS;
+  }
+  m->info.state = ODIN_UPSTREAM_DOWN;
+  m->info.retry_at_ms = now_ms + backoff;
+  if (set->preferred == (int)index) {
+    set->preferred = -1;
+  }
+}
+
+int odin_upstream_set_retry_due(const odin_upstream_set_t *set, size_t index,
+                                uint64_t now_ms) {
+  if (set == NULL || index >= set->count) {
+    return 0;
+  }
+  const upstream_member_t *m = &set->members[index];
+  return m->info.state == ODIN_UPSTREAM_DOWN && now_ms >= m->info.retry_at_ms;
+}
+
+void odin_upstream_set_mark_connecting(odin_upstream_set_t *set,
+                                       size_t index) {
+  if (set == NULL || index >= set->count) {
+    return;
+  }
+  upstream_member_t *m = &set->members[index];
+  m->info.state = ODIN_UPSTREAM_CONNECTING;
+  m->info.retry_at_ms = 0;
+  m->last_sent = 0;
+  m->last_lost = 0;
+}
+
+/* srtt scaled by (1 + 4 * loss); a server with no RTT sample yet sorts last
+ * among those that are up. */
+static uint64_t score(const upstream_member_t *m) {
+  if (m->info.srtt_us == 0) {
+    return UINT64_MAX / 1000u;
+  }
+  return m->info.srtt_us * (1000u + 4u * (uint64_t)m->info.loss_permille) /
+         1000u;
+}
+
+int odin_upstream_set_pick(odin_upstream_set_t *set) {
+  if (set == NULL) {
+    return -1;
+  }
+  int best = -1;
+  uint64_t best_score = 0;
+  for (size_t i = 0; i < set->count; ++i) {
+    const upstream_member_t *m = &set->members[i];
+    if (m->info.state != ODIN_UPSTREAM_UP) {
+      continue;
+    }
+    const uint64_t s = score(m);
+    if (best < 0 || s < best_score) {
+      best = (int)i;
+      best_score = s;
+    }
+  }
+  if (best >= 0) {
+    const int cur = set->preferred;
+    if (cur >= 0 && cur != best &&
+        set->members[cur].info.state == ODIN_UPSTREAM_UP &&
+        best_score * 100u >
+            score(&set->members[cur]) * (100u - ODIN_UPSTREAM_SWITCH_PERCENT)) {
+      best = cur;
+    }
+    set->preferred = best;
+  } else {
+    for (size_t i = 0; i < set->count; ++i) {
+      if (set->members[i].info.state == ODIN_UPSTREAM_CONNECTING) {
+        best = (int)i;
+        break;
+      }
+    }
+  }
+  if (best >= 0) {
+    set->members[best].info.picks += 1;
+  }
+  return best;
+}
+
+int odin_upstream_set_info(const odin_upstream_set_t *set, size_t index,
+                           odin_upstream_info_t *out) {
+  if (set == NULL || out == NULL || index >= set->count) {
+    errno = EINVAL;
+    return -1;
+  }
+  *out = set->members[index].info;
+  return 0;
+}
+
+void odin_upstream_set_destroy(odin_upstream_set_t *set) { free(set); }
@@ -0,0 +1,98 @@
+/* odin/upstream_set.h
+ *
+ * Upstream server selection for the local client (RFC-039).
+ *
+ * An odin_upstream_set_t tracks a fixed number of upstream servers by index.
+ * The owner feeds it what each server's warm QUIC connection reports --
+ * smoothed RTT and cumulative packets sent / lost -- and tells it when a
+ * connection dies. odin_upstream_set_pick returns the server new tunnels
+ * should use:
+ *
+ *   - only servers that are up are scored; score = srtt * (1 + 4 * loss),
+ *     with loss an EWMA (1/8) of the per-observation loss ratio;
+ *   - the current preference is kept unless another server scores at least
+ *     ODIN_UPSTREAM_SWITCH_PERCENT percent lower, so near-equal servers do
+ *     not flap;
+ *   - with no server up, the lowest-index server still connecting is
+ *     returned (its runtime queues the tunnel until the handshake); with
+ *     none connecting either, -1.
+ *
+ * A server marked down is not picked again until odin_upstream_set_retry_due
+ * says its backoff has expired -- ODIN_UPSTREAM_RETRY_MIN_MS after the first
+ * failure, doubling per consecutive failure up to ODIN_UPSTREAM_RETRY_MAX_MS
+ * -- and the owner has reconnected it (odin_upstream_set_mark_connecting).
+ * An observation on a connecting server marks it up and resets its failure
+ * count. Times are caller-supplied monotonic milliseconds.
+ *
+ * Threading: owner-thread, no locks, no allocation after create.
+ * odin_upstream_set_destroy(NULL) is a no-op.
+ */
+
+#ifndef ODIN_UPSTREAM_SET_H_
+#define ODIN_UPSTREAM_SET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ODIN_UPSTREAM_SET_MAX 8u
+#define ODIN_UPSTREAM_SWITCH_PERCENT 10u
+#define ODIN_UPSTREAM_RETRY_MIN_MS 1000u
+#define ODIN_UPSTREAM_RETRY_MAX_MS 30000u
+
+typedef struct odin_upstream_set_t odin_upstream_set_t;
+
+typedef enum odin_upstream_state_t {
+  ODIN_UPSTREAM_CONNECTING = 0,
+  ODIN_UPSTREAM_UP,
+  ODIN_UPSTREAM_DOWN,
+} odin_upstream_state_t;
+
+typedef struct odin_upstream_info_t {
+  odin_upstream_state_t state;
+  uint64_t srtt_us;       /* last reported smoothed RTT, 0 before any  */
+  uint32_t loss_permille; /* EWMA of the loss ratio, per mille          */
+  uint64_t picks;         /* times odin_upstream_set_pick returned it   */
+  uint64_t failures;      /* odin_upstream_set_mark_down calls           */
+  uint64_t retry_at_ms;   /* DOWN: earliest reconnect time               */
+} odin_upstream_info_t;
+
+/* Creates a set of count servers, all CONNECTING. Returns 0, or -1 with errno
+ * EINVAL (count 0 or > ODIN_UPSTREAM_SET_MAX, or out NULL) or ENOMEM. */
+int odin_upstream_set_create(size_t count, odin_upstream_set_t **out);
+
+/* Reports index's connection statistics; sent and lost are cumulative over
+ * the current connection. Marks a CONNECTING server UP; ignored for DOWN. */
+void odin_upstream_set_observe(odin_upstream_set_t *set, size_t index,
+                               uint64_t srtt_us, uint64_t sent, uint64_t lost);
+
+/* index's connection failed or was refused at now_ms: DOWN with backoff. */
+void odin_upstream_set_mark_down(odin_upstream_set_t *set, size_t index,
+                                 uint64_t now_ms);
+
+/* Returns 1 when index is DOWN and its backoff has expired at now_ms. */
+int odin_upstream_set_retry_due(const odin_upstream_set_t *set, size_t index,
+                                uint64_t now_ms);
+
+/* index has a fresh connection in progress; its counters restart. */
+void odin_upstream_set_mark_connecting(odin_upstream_set_t *set,
+                                       size_t index);
+
+/* Returns the index new tunnels should use, or -1 when every server is down.
+ */
+int odin_upstream_set_pick(odin_upstream_set_t *set);
+
+/* Copies index's state to *out. Returns 0, or -1 with errno EINVAL. */
+int odin_upstream_set_info(const odin_upstream_set_t *set, size_t index,
+                           odin_upstream_info_t *out);
+
+void odin_upstream_set_destroy(odin_upstream_set_t *set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_UPSTREAM_SET_H_ */
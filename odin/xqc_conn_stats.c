@@ -0,0 +1,61 @@
+/* odin/xqc_conn_stats.c -- RFC-051 connection stats helpers. */
+
+#include "odin/xqc_conn_stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+void odin_xqc_conn_stats_fill(const xqc_conn_stats_t *st,
+                              odin_xqc_conn_stats_t *out) {
+  out->srtt_us = st->srtt;
+  out->min_rtt_us = st->min_rtt;
+  out->inflight_bytes = st->inflight_bytes;
+  out->packets_sent = st->send_count;
+  out->packets_received = st->recv_count;
+  out->packets_lost = st->lost_count;
+  out->bytes_sent = 0;
+  out->bytes_received = 0;
+  /* Unused path slots are zero. */
+  for (size_t i = 0; i < XQC_MAX_PATHS_COUNT; ++i) {
+    out->bytes_sent += st->paths_info[i].path_send_bytes;
+    out->bytes_received += st->paths_info[i].path_recv_bytes;
+  }
+}
+
+void odin_xqc_runtime_totals_add(odin_xqc_runtime_totals_t *t,
+                                 const odin_xqc_conn_stats_t *c) {
+  t->packets_sent += c->packets_sent;
+  t->packets_received += c->packets_received;
+  t->packets_lost += c->packets_lost;
+  t->bytes_sent += c->bytes_sent;
+  t->bytes_received += c->bytes_received;
+}
+
+void odin_xqc_runtime_totals_merge(odin_xqc_runtime_totals_t *into,
+                                   const odin_xqc_runtime_totals_t *from) {
+  into->conns_active += from->conns_active;
+  into->conns_opened += from->conns_opened;
+  into->streams_active += from->streams_active;
+  if (from->srtt_us_max > into->srtt_us_max) {
+    into->srtt_us_max = from->srtt_us_max;
+  }
+  into->packets_sent += from->packets_sent;
+  into->packets_received += from->packets_received;
+  into->packets_lost += from->packets_lost;
+  into->bytes_sent += from->bytes_sent;
+  into->bytes_received += from->bytes_received;
+  into->bytes_unsent += from->bytes_unsent;
+}
+
+size_t odin_xqc_runtime_totals_format(const odin_xqc_runtime_totals_t *t,
+                                      char *buf, size_t cap) {
+  const int n = snprintf(
+      buf, cap,
+      "conns=%" PRIu64 "/%" PRIu64 " streams=%" PRIu64 " srtt_max_us=%" PRIu64
+      " pkts=%" PRIu64 "/%" PRIu64 "/%" PRIu64 " bytes=%" PRIu64 "/%" PRIu64
+      " unsent=%" PRIu64,
+      t->conns_active, t->conns_opened, t->streams_active, t->srtt_us_max,
+      t->packets_sent, t->packets_received, t->packets_lost, t->bytes_sent,
+      t->bytes_received, t->bytes_unsent);
+  return n > 0 ? (size_t)n : 0;
+}
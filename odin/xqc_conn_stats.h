@@ -0,0 +1,83 @@
+/* odin/xqc_conn_stats.h
+ *
+ * Per-connection QUIC transport stats shared by both runtimes (RFC-051).
+ *
+ * odin_xqc_conn_stats_t is a flat, caller-owned snapshot of one connection:
+ * its source CID and peer, xquic's RTT estimates and bytes in flight, packet
+ * counts, payload bytes, and the runtime's count of active streams.
+ * odin_xqc_server_runtime_stats and odin_xqc_client_runtime_stats fill a
+ * caller-provided array of them without allocating. The matching totals calls
+ * fill odin_xqc_runtime_totals_t, which adds the live connections to
+ * everything the runtime has closed since it was created.
+ *
+ * odin_xqc_conn_stats_fill copies the transport fields out of one
+ * xqc_conn_get_stats result; odin_xqc_runtime_totals_add folds one snapshot
+ * into a totals struct. Neither touches the CID, peer, or stream fields.
+ * odin_xqc_runtime_totals_merge sums two runtimes' totals.
+ * odin_xqc_runtime_totals_format renders totals as the one-line summary the
+ * CLI logs every --stats-interval-s.
+ */
+
+#ifndef ODIN_XQC_CONN_STATS_H_
+#define ODIN_XQC_CONN_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <xquic/xquic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct odin_xqc_conn_stats_t {
+  uint8_t cid_len;
+  uint8_t cid[XQC_MAX_CID_LEN]; /* the source CID, as the runtime keys it */
+  socklen_t peer_len;           /* 0: unknown */
+  struct sockaddr_storage peer;
+  uint64_t srtt_us;
+  uint64_t min_rtt_us;
+  uint64_t inflight_bytes; /* sent and not yet acked or declared lost */
+  uint64_t packets_sent;
+  uint64_t packets_received;
+  uint64_t packets_lost;
+  uint64_t bytes_sent; /* summed over every path */
+  uint64_t bytes_received;
+  uint32_t active_streams;
+} odin_xqc_conn_stats_t;
+
+typedef struct odin_xqc_runtime_totals_t {
+  uint64_t conns_active;
+  uint64_t conns_opened; /* since the runtime was created */
+  uint64_t streams_active;
+  uint64_t srtt_us_max; /* over the live connections */
+  /* Live connections plus every connection already closed. */
+  uint64_t packets_sent;
+  uint64_t packets_received;
+  uint64_t packets_lost;
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  uint64_t bytes_unsent; /* accepted by a stream write, dropped at close */
+} odin_xqc_runtime_totals_t;
+
+void odin_xqc_conn_stats_fill(const xqc_conn_stats_t *st,
+                              odin_xqc_conn_stats_t *out);
+/* Adds c's packet and byte counts to t. */
+void odin_xqc_runtime_totals_add(odin_xqc_runtime_totals_t *t,
+                                 const odin_xqc_conn_stats_t *c);
+/* Adds from's counts to into and keeps the larger srtt_us_max; for a caller
+ * that reports several runtimes as one. */
+void odin_xqc_runtime_totals_merge(odin_xqc_runtime_totals_t *into,
+                                   const odin_xqc_runtime_totals_t *from);
+/* snprintf-style: writes "conns=A/O streams=S srtt_max_us=R pkts=T/R/L
+ * bytes=T/R unsent=U" (A active, O opened; sent/received/lost) into buf,
+ * truncating to cap, and returns the untruncated length. */
+size_t odin_xqc_runtime_totals_format(const odin_xqc_runtime_totals_t *t,
+                                      char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_XQC_CONN_STATS_H_ */
@@ -0,0 +1,68 @@
+/* odin/xqc_flush_timer.c -- RFC-035 flush-timer ops on the event loop and the
+ * connection send backlog behind the runtimes' send probes. */
+
+#include "odin/xqc_flush_timer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "odin/transport_xqc.h"
+
+static void flush_timer_cb(odin_event_loop_t *loop, odin_event_timer_t *timer,
+                           void *user_data) {
+  (void)loop;
+  (void)timer;
+  odin_xqc_stream_transport_flush_timer_fired((odin_transport_t *)user_data);
+}
+
+/* timer is the handle expiring right now when the transport re-arms from its
+ * expiry; resetting it keeps it alive past the callback. */
+static void *flush_timer_arm(void *ctx, void *timer, uint64_t delay_us,
+                             odin_transport_t *t) {
+  if (timer != NULL &&
+      odin_event_timer_reset((odin_event_timer_t *)timer, delay_us, 0) == 0) {
+    return timer;
+  }
+  odin_event_timer_t *fresh = NULL;
+  if (odin_event_timer_start((odin_event_loop_t *)ctx, delay_us, 0,
+                             flush_timer_cb, t, &fresh) != 0) {
+    return NULL;
+  }
+  return fresh;
+}
+
+static void flush_timer_cancel(void *ctx, void *timer) {
+  (void)ctx;
+  odin_event_timer_stop((odin_event_timer_t *)timer);
+}
+
+void odin_xqc_flush_timer_install(odin_transport_t *t,
+                                  odin_event_loop_t *loop) {
+  odin_xqc_flush_timer_ops_t ops;
+  ops.arm = flush_timer_arm;
+  ops.cancel = flush_timer_cancel;
+  ops.ctx = loop;
+  odin_xqc_stream_transport_set_flush_timer(t, &ops,
+                                            ODIN_XQC_COALESCE_DELAY_US);
+}
+
+void odin_xqc_send_backlog_accepted(odin_xqc_send_backlog_t *b, size_t n) {
+  b->held += n;
+}
+
+uint64_t odin_xqc_send_backlog_update(odin_xqc_send_backlog_t *b,
+                                      const xqc_conn_stats_t *st) {
+  uint64_t sent = 0;
+  /* Unused path slots are zero. */
+  for (size_t i = 0; i < XQC_MAX_PATHS_COUNT; ++i) {
+    sent += st->paths_info[i].path_send_bytes;
+  }
+  const uint64_t done =
+      sent > st->inflight_bytes ? sent - st->inflight_bytes : 0;
+  if (done > b->done) {
+    const uint64_t progress = done - b->done;
+    b->held = b->held > progress ? b->held - progress : 0;
+    b->done = done;
+  }
+  return b->held > st->inflight_bytes ? b->held : st->inflight_bytes;
+}
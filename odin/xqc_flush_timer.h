@@ -0,0 +1,57 @@
+/* odin/xqc_flush_timer.h
+ *
+ * Loop-backed flush-timer ops for the xqc stream transport (RFC-035), shared
+ * by the server and client runtimes.
+ *
+ * odin_xqc_flush_timer_install gives t one-shot odin_event_timer timers on
+ * loop whose expiry calls odin_xqc_stream_transport_flush_timer_fired, with
+ * the ODIN_XQC_COALESCE_DELAY_US window. When the transport re-arms from inside
+ * that expiry, the expired timer is restarted in place with
+ * odin_event_timer_reset, so a stream polling its send watermark keeps one
+ * timer for as long as it polls. Owner-thread API.
+ *
+ * odin_xqc_send_backlog_t is the per-connection estimate behind both runtimes'
+ * send probes: the bytes xqc_stream_send accepted on any of the connection's
+ * streams that xquic has not yet seen acknowledged, whether still queued
+ * behind the congestion window or in flight. xquic exposes neither a send
+ * queue size nor acked stream bytes, so _update takes what has left xquic's
+ * hands from xqc_conn_get_stats -- bytes sent on every path less bytes in
+ * flight -- and subtracts its growth since the last update. Packet headers
+ * and retransmissions count as progress, so the estimate errs low and reaches
+ * zero when xquic drains; it never reports less than inflight_bytes.
+ */
+
+#ifndef ODIN_XQC_FLUSH_TIMER_H_
+#define ODIN_XQC_FLUSH_TIMER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "odin/event_loop.h"
+#include "odin/transport.h"
+#include <xquic/xquic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void odin_xqc_flush_timer_install(odin_transport_t *t,
+                                  odin_event_loop_t *loop);
+
+typedef struct odin_xqc_send_backlog_t {
+  uint64_t held; /* accepted and not yet seen leave xquic */
+  uint64_t done; /* sent less in flight at the last update */
+} odin_xqc_send_backlog_t;
+
+/* Adds n bytes xqc_stream_send just accepted; a send probe's accepted hook. */
+void odin_xqc_send_backlog_accepted(odin_xqc_send_backlog_t *b, size_t n);
+/* Folds one xqc_conn_get_stats result into b and returns the bytes xquic
+ * holds for the connection: the estimate, or inflight_bytes when larger. */
+uint64_t odin_xqc_send_backlog_update(odin_xqc_send_backlog_t *b,
+                                      const xqc_conn_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ODIN_XQC_FLUSH_TIMER_H_ */
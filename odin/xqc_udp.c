@@ -21,6 +21,7 @@ struct odin_xqc_udp_t {
   xqc_engine_callback_t engine_callbacks;
   xqc_transport_callbacks_t transport_callbacks;
   void *app_user_data;
+  odin_qlog_ring_t *qlog;
   struct sockaddr_storage local_addr;
   socklen_t local_addrlen;
   xqc_cid_t *registered_cids;
@@ -137,6 +138,16 @@ static xqc_usec_t odin_xqc_udp_default_monotonic_us(void) {
          (xqc_usec_t)((unsigned long)ts.tv_nsec / 1000u);
 }
 
+static void odin_xqc_udp_qlog_write(qlog_event_importance_t imp,
+                                    const void *buf, size_t size,
+                                    void *engine_user_data) {
+  odin_xqc_udp_t *xu = (odin_xqc_udp_t *)engine_user_data;
+  if (xu == NULL) {
+    return;
+  }
+  odin_qlog_event(xu->qlog, (int)imp, (const char *)buf, size);
+}
+
 static xqc_usec_t odin_xqc_udp_monotonic_us(odin_xqc_udp_t *xu) {
   return xu->engine_callbacks.monotonic_ts();
 }
@@ -402,6 +413,26 @@ int odin_xqc_udp_create(const odin_xqc_udp_config_t *config,
   if (xu->engine_callbacks.monotonic_ts == NULL) {
     xu->engine_callbacks.monotonic_ts = odin_xqc_udp_default_monotonic_us;
   }
+  const xqc_config_t *engine_config = config->engine_config;
+  xqc_config_t qlog_config;
+  if (config->qlog != NULL) {
+    if (engine_config != NULL) {
+      qlog_config = *engine_config;
+    } else if (xqc_engine_get_default_config(&qlog_config,
+                                             config->engine_type) != XQC_OK) {
+      free(xu);
+      errno = EIO;
+      return -1;
+    }
+    /* xquic formats every event of every connection once the log is on;
+     * core events keep that cost to a few lines per packet. */
+    qlog_config.cfg_log_event = 1;
+    qlog_config.cfg_qlog_importance = EVENT_IMPORTANCE_CORE;
+    engine_config = &qlog_config;
+    xu->qlog = config->qlog;
+    xu->engine_callbacks.log_callbacks.xqc_qlog_event_write =
+        odin_xqc_udp_qlog_write;
+  }
   xu->transport_callbacks = *config->transport_callbacks;
   xu->transport_callbacks.stateless_reset = odin_xqc_udp_stateless_reset;
   xu->transport_callbacks.write_socket = odin_xqc_udp_write_socket;
@@ -429,7 +460,7 @@ int odin_xqc_udp_create(const odin_xqc_udp_config_t *config,
   }
 
   xqc_engine_t *engine = xqc_udp_engine_create_call(
-      config->engine_type, config->engine_config, config->ssl_config,
+      config->engine_type, engine_config, config->ssl_config,
       &xu->engine_callbacks, &xu->transport_callbacks, xu);
   if (engine == NULL) {
     const int saved = errno;
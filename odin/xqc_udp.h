@@ -29,6 +29,11 @@
  * driver-entered xquic callback (packet-process, finish-recv, timer
  * main-logic, continue-send) is deferred until the outermost such call
  * returns.
+ *
+ * qlog (RFC-050): with config->qlog set, the driver turns on xquic's event
+ * log for core-importance events, in a copy of engine_config or of xquic's
+ * defaults when that is NULL, and hands each event line to odin_qlog_event
+ * on that ring. The ring is lent and must outlive the driver.
  */
 
 #ifndef ODIN_XQC_UDP_H_
@@ -37,6 +42,7 @@
 #include <sys/socket.h>
 
 #include "odin/event_loop.h"
+#include "odin/qlog.h"
 #include "odin/udp.h"
 #include <xquic/xquic.h>
 
@@ -59,6 +65,7 @@ typedef struct odin_xqc_udp_config_t {
   const xqc_engine_callback_t *engine_callbacks;
   const xqc_transport_callbacks_t *transport_callbacks;
   void *app_user_data;
+  odin_qlog_ring_t *qlog; /* optional; see above */
 } odin_xqc_udp_config_t;
 
 int odin_xqc_udp_create(const odin_xqc_udp_config_t *config,